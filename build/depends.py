@@ -582,7 +582,8 @@ class SoundTouch(Dependence):
 
 class RubberBand(Dependence):
     def sources(self, build):
-        sources = ['src/engine/bufferscalers/enginebufferscalerubberband.cpp', ]
+        sources = ['src/engine/bufferscalers/enginebufferscalerubberband.cpp',
+                   'src/engine/bufferscalers/rubberbandworker.cpp', ]
         return sources
 
     def configure(self, build, conf, env=None):
@@ -705,6 +706,36 @@ class FpClassify(Dependence):
                 env['CCFLAGS'].remove('-ffast-math')
         return env.Object('src/util/fpclassify.cpp')
 
+class SampleKernels(Dependence):
+
+    # The scalar kernels are the bit-exact reference for the hand-vectorized
+    # kernels and must neither be reassociated nor contracted into FMA
+    # instructions. The SIMD kernels are only called after a runtime CPU check.
+    def sources(self, build):
+        env = build.env.Clone()
+        if build.toolchain_is_gnu:
+            if '-ffast-math' in env['CCFLAGS']:
+                env['CCFLAGS'].remove('-ffast-math')
+            env.Append(CCFLAGS=['-fno-fast-math', '-ffp-contract=off'])
+        elif build.toolchain_is_msvs:
+            if '/fp:fast' in env['CCFLAGS']:
+                env['CCFLAGS'].remove('/fp:fast')
+            env.Append(CCFLAGS='/fp:precise')
+        sources = [env.Object('src/util/samplekernels.cpp')]
+
+        avx2_env = env.Clone()
+        avx512_env = env.Clone()
+        if build.architecture_is_x86:
+            if build.toolchain_is_gnu:
+                avx2_env.Append(CCFLAGS='-mavx2')
+                avx512_env.Append(CCFLAGS='-mavx512f')
+            elif build.toolchain_is_msvs:
+                avx2_env.Append(CCFLAGS='/arch:AVX2')
+                avx512_env.Append(CCFLAGS='/arch:AVX512')
+        sources.append(avx2_env.Object('src/util/samplekernels_avx2.cpp'))
+        sources.append(avx512_env.Object('src/util/samplekernels_avx512.cpp'))
+        return sources
+
 class PortAudioRingBuffer(Dependence):
     def configure(self, build, conf):
         build.env.Append(CPPPATH='#lib/portaudio')
@@ -752,6 +783,7 @@ class MixxxCore(Feature):
                    "src/control/controlpotmeter.cpp",
                    "src/control/controlproxy.cpp",
                    "src/control/controlpushbutton.cpp",
+                   "src/control/controlregistry.cpp",
                    "src/control/controlttrotary.cpp",
                    "src/control/controlencoder.cpp",
 
@@ -825,6 +857,8 @@ class MixxxCore(Feature):
                    "src/effects/builtin/filtereffect.cpp",
                    "src/effects/builtin/moogladder4filtereffect.cpp",
                    "src/effects/builtin/reverbeffect.cpp",
+                   "src/effects/builtin/convolutionreverbeffect.cpp",
+                   "src/effects/builtin/impulseresponseloader.cpp",
                    "src/effects/builtin/echoeffect.cpp",
                    "src/effects/builtin/autopaneffect.cpp",
                    "src/effects/builtin/phasereffect.cpp",
@@ -844,11 +878,14 @@ class MixxxCore(Feature):
                    "src/engine/engineworker.cpp",
                    "src/engine/engineworkerscheduler.cpp",
                    "src/engine/enginebuffer.cpp",
+                   "src/engine/enginecallbacktelemetry.cpp",
                    "src/engine/bufferscalers/enginebufferscale.cpp",
                    "src/engine/bufferscalers/enginebufferscalelinear.cpp",
+                   "src/engine/bufferscalers/scaleinputhistory.cpp",
                    "src/engine/channels/engineaux.cpp",
                    "src/engine/channels/enginechannel.cpp",
                    "src/engine/channels/enginedeck.cpp",
+                   "src/engine/deckstate.cpp",
                    "src/engine/channels/enginemicrophone.cpp",
                    "src/engine/filters/enginefilterbiquad1.cpp",
                    "src/engine/filters/enginefiltermoogladder4.cpp",
@@ -860,9 +897,11 @@ class MixxxCore(Feature):
                    "src/engine/filters/enginefilterlinkwitzriley4.cpp",
                    "src/engine/filters/enginefilterlinkwitzriley8.cpp",
                    "src/engine/filters/enginefilter.cpp",
+                   "src/engine/filters/partitionedconvolution.cpp",
                    "src/engine/engineobject.cpp",
                    "src/engine/enginepregain.cpp",
                    "src/engine/enginemaster.cpp",
+                   "src/engine/engineofflinerenderer.cpp",
                    "src/engine/enginedelay.cpp",
                    "src/engine/enginevumeter.cpp",
                    "src/engine/enginesidechaincompressor.cpp",
@@ -870,6 +909,7 @@ class MixxxCore(Feature):
                    "src/engine/sidechain/networkoutputstreamworker.cpp",
                    "src/engine/sidechain/networkinputstreamworker.cpp",
                    "src/engine/enginexfader.cpp",
+                   "src/engine/channelmixer.cpp",
                    "src/engine/channelmixer_autogen.cpp",
                    "src/engine/positionscratchcontroller.cpp",
                    "src/engine/controls/bpmcontrol.cpp",
@@ -881,14 +921,20 @@ class MixxxCore(Feature):
                    "src/engine/controls/quantizecontrol.cpp",
                    "src/engine/controls/ratecontrol.cpp",
                    "src/engine/readaheadmanager.cpp",
+                   "src/engine/realtimeworkerpool.cpp",
                    "src/engine/enginetalkoverducking.cpp",
                    "src/engine/cachingreader/cachingreader.cpp",
                    "src/engine/cachingreader/cachingreaderchunk.cpp",
                    "src/engine/cachingreader/cachingreaderworker.cpp",
+                   "src/engine/cachingreader/preloadbudget.cpp",
+                   "src/engine/cachingreader/preloadedtrack.cpp",
 
+                   "src/analyzer/trackanalysisqueue.cpp",
                    "src/analyzer/trackanalysisscheduler.cpp",
                    "src/analyzer/analyzerthread.cpp",
+                   "src/analyzer/analyzerpipeline.cpp",
                    "src/analyzer/analyzerwaveform.cpp",
+                   "src/analyzer/waveformfilterbank.cpp",
                    "src/analyzer/analyzergain.cpp",
                    "src/analyzer/analyzerbeats.cpp",
                    "src/analyzer/analyzerkey.cpp",
@@ -945,6 +991,7 @@ class MixxxCore(Feature):
                    "src/sources/audiosource.cpp",
                    "src/sources/audiosourcestereoproxy.cpp",
                    "src/sources/metadatasourcetaglib.cpp",
+                   "src/sources/pcmcache.cpp",
                    "src/sources/soundsource.cpp",
                    "src/sources/soundsourceproviderregistry.cpp",
                    "src/sources/soundsourceproxy.cpp",
@@ -1033,6 +1080,7 @@ class MixxxCore(Feature):
                    "src/library/externaltrackcollection.cpp",
                    "src/library/basesqltablemodel.cpp",
                    "src/library/basetrackcache.cpp",
+                   "src/library/tracksearchindex.cpp",
                    "src/library/basetracktablemodel.cpp",
                    "src/library/columncache.cpp",
                    "src/library/librarytablemodel.cpp",
@@ -1151,6 +1199,7 @@ class MixxxCore(Feature):
                    "src/widget/wwaveformviewer.cpp",
 
                    "src/waveform/sharedglcontext.cpp",
+                   "src/waveform/provisionalwaveformbuilder.cpp",
                    "src/waveform/waveform.cpp",
                    "src/waveform/waveformfactory.cpp",
                    "src/waveform/waveformwidgetfactory.cpp",
@@ -1627,7 +1676,7 @@ class MixxxCore(Feature):
         return [SoundTouch, ReplayGain, Ebur128Mit, PortAudio, PortMIDI, Qt, TestHeaders,
                 FidLib, SndFile, FLAC, OggVorbis, OpenGL, TagLib, ProtoBuf,
                 Chromaprint, RubberBand, SecurityFramework, CoreServices, IOKit,
-                Reverb, FpClassify, PortAudioRingBuffer, LAME,
+                Reverb, FpClassify, SampleKernels, PortAudioRingBuffer, LAME,
                 QueenMaryDsp, Kaitai, MP3GuessEnc, RigtorpSPSCQueue]
 
     def post_dependency_check_configure(self, build, conf):
@@ -1172,7 +1172,9 @@ class Lilv(Feature):
     def sources(self, build):
         return ['src/effects/lv2/lv2backend.cpp',
                 'src/effects/lv2/lv2effectprocessor.cpp',
+                'src/effects/lv2/lv2hostfeatures.cpp',
                 'src/effects/lv2/lv2manifest.cpp',
+                'src/effects/lv2/lv2worker.cpp',
                 'src/preferences/dialog/dlgpreflv2.cpp']
 
 class Battery(Feature):
@@ -0,0 +1,185 @@
+#include "analyzer/analyzerpipeline.h"
+
+#include <QThread>
+
+#include "analyzer/constants.h"
+#include "rigtorp/SPSCQueue.h"
+#include "util/logger.h"
+#include "util/sample.h"
+
+namespace {
+
+mixxx::Logger kLogger("AnalyzerPipeline");
+
+// The number of blocks that decoding may run ahead of the slowest
+// analyzer. Only a few are needed to smooth out the varying processing
+// times of the analyzers per block.
+constexpr size_t kNumBlocks = 8;
+
+} // anonymous namespace
+
+// Processes the blocks for a single analyzer on its own thread
+class AnalyzerLane : public QThread {
+  public:
+    enum class MessageType {
+        Process,
+        Finish,
+        Cancel,
+        Quit,
+    };
+
+    struct Message {
+        MessageType type;
+        AnalyzerPipeline::Block* pBlock;
+    };
+
+    AnalyzerLane(AnalyzerPipeline* pPipeline, AnalyzerWithState analyzer)
+            : m_pPipeline(pPipeline),
+              m_analyzer(std::move(analyzer)),
+              // Each block is enqueued at most once and at most
+              // one control message follows the blocks
+              m_messages(kNumBlocks + 1) {
+    }
+
+    AnalyzerWithState& analyzer() {
+        return m_analyzer;
+    }
+
+    void send(MessageType type, AnalyzerPipeline::Block* pBlock = nullptr) {
+        const bool pushed = m_messages.try_push(Message{type, pBlock});
+        VERIFY_OR_DEBUG_ASSERT(pushed) {
+            m_messages.push(Message{type, pBlock});
+        }
+        m_messageAvailable.release();
+    }
+
+  protected:
+    void run() override {
+        while (true) {
+            m_messageAvailable.acquire();
+            Message* pMessage = m_messages.front();
+            DEBUG_ASSERT(pMessage);
+            const Message message = *pMessage;
+            m_messages.pop();
+            switch (message.type) {
+            case MessageType::Process:
+                if (!m_pPipeline->m_cancelled.load(std::memory_order_relaxed)) {
+                    m_analyzer.processSamples(
+                            message.pBlock->samples.data(),
+                            message.pBlock->length);
+                }
+                m_pPipeline->releaseBlock(message.pBlock);
+                break;
+            case MessageType::Finish:
+                m_analyzer.finish(m_pPipeline->m_pFinishedTrack);
+                m_pPipeline->laneDone();
+                break;
+            case MessageType::Cancel:
+                m_analyzer.cancel();
+                m_pPipeline->laneDone();
+                break;
+            case MessageType::Quit:
+                return;
+            }
+        }
+    }
+
+  private:
+    AnalyzerPipeline* const m_pPipeline;
+    AnalyzerWithState m_analyzer;
+    rigtorp::SPSCQueue<Message> m_messages;
+    QSemaphore m_messageAvailable;
+};
+
+AnalyzerPipeline::AnalyzerPipeline(
+        const QString& name,
+        std::vector<AnalyzerWithState> analyzers)
+        : m_nextBlock(0),
+          m_freeBlocks(kNumBlocks),
+          m_active(false),
+          m_cancelled(false) {
+    m_blocks.reserve(kNumBlocks);
+    for (size_t i = 0; i < kNumBlocks; ++i) {
+        m_blocks.push_back(std::make_unique<Block>(mixxx::kAnalysisSamplesPerChunk));
+    }
+    m_lanes.reserve(analyzers.size());
+    for (auto&& analyzer : analyzers) {
+        auto pLane = std::make_unique<AnalyzerLane>(this, std::move(analyzer));
+        pLane->setObjectName(QString("%1 Lane %2").arg(name).arg(m_lanes.size() + 1));
+        pLane->start(QThread::LowPriority);
+        m_lanes.push_back(std::move(pLane));
+    }
+    kLogger.debug()
+            << "Started" << m_lanes.size() << "analyzer threads for" << name;
+}
+
+AnalyzerPipeline::~AnalyzerPipeline() {
+    for (auto&& pLane : m_lanes) {
+        DEBUG_ASSERT(!pLane->analyzer().isActive());
+        pLane->send(AnalyzerLane::MessageType::Quit);
+    }
+    for (auto&& pLane : m_lanes) {
+        pLane->wait();
+    }
+}
+
+bool AnalyzerPipeline::initialize(
+        TrackPointer pTrack, int sampleRate, int totalSamples) {
+    // All analyzer threads are idle between tracks
+    m_cancelled.store(false);
+    m_active = false;
+    for (auto&& pLane : m_lanes) {
+        // Make sure not to short-circuit initialize(...)
+        if (pLane->analyzer().initialize(pTrack, sampleRate, totalSamples)) {
+            m_active = true;
+        }
+    }
+    return m_active;
+}
+
+void AnalyzerPipeline::processSamples(const CSAMPLE* pIn, int iLen) {
+    DEBUG_ASSERT(iLen <= mixxx::kAnalysisSamplesPerChunk);
+    if (!m_active) {
+        // Don't copy the samples if no analyzer needs them
+        return;
+    }
+    m_freeBlocks.acquire();
+    // Blocks are processed in order by all analyzers and become
+    // free again in the same order
+    Block* pBlock = m_blocks[m_nextBlock].get();
+    m_nextBlock = (m_nextBlock + 1) % m_blocks.size();
+    DEBUG_ASSERT(pBlock->pendingLanes.load() == 0);
+    SampleUtil::copy(pBlock->samples.data(), pIn, iLen);
+    pBlock->length = iLen;
+    pBlock->pendingLanes.store(numAnalyzers());
+    for (auto&& pLane : m_lanes) {
+        pLane->send(AnalyzerLane::MessageType::Process, pBlock);
+    }
+}
+
+void AnalyzerPipeline::finish(TrackPointer pTrack) {
+    m_pFinishedTrack = std::move(pTrack);
+    for (auto&& pLane : m_lanes) {
+        pLane->send(AnalyzerLane::MessageType::Finish);
+    }
+    m_doneLanes.acquire(numAnalyzers());
+    m_pFinishedTrack.reset();
+}
+
+void AnalyzerPipeline::cancel() {
+    m_cancelled.store(true);
+    for (auto&& pLane : m_lanes) {
+        pLane->send(AnalyzerLane::MessageType::Cancel);
+    }
+    m_doneLanes.acquire(numAnalyzers());
+}
+
+void AnalyzerPipeline::releaseBlock(Block* pBlock) {
+    if (pBlock->pendingLanes.fetch_sub(1) == 1) {
+        m_freeBlocks.release();
+    }
+}
+
+void AnalyzerPipeline::laneDone() {
+    m_doneLanes.release();
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <QSemaphore>
+#include <QString>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "analyzer/analyzer.h"
+#include "util/class.h"
+#include "util/samplebuffer.h"
+
+class AnalyzerLane;
+
+// Runs each analyzer on a separate thread while the host thread decodes
+// the track only once. Decoded blocks are copied into a small ring of
+// buffers that is shared by all analyzers and handed over to every
+// analyzer thread through a lock-free SPSC queue. A block is reused after
+// all analyzers have processed it, i.e. the slowest analyzer limits how
+// far decoding may run ahead, but never blocks the other analyzers.
+//
+// All functions must be called from the host thread. Analyzers are
+// initialized on the host thread, while processing and finishing them
+// happens on their own threads.
+class AnalyzerPipeline {
+  public:
+    AnalyzerPipeline(
+            const QString& name,
+            std::vector<AnalyzerWithState> analyzers);
+    ~AnalyzerPipeline();
+
+    int numAnalyzers() const {
+        return static_cast<int>(m_lanes.size());
+    }
+
+    // Returns true if at least one analyzer needs to process the track
+    bool initialize(TrackPointer pTrack, int sampleRate, int totalSamples);
+
+    // Hands over a copy of the samples to all analyzers. Blocks while
+    // all buffers are still in use.
+    void processSamples(const CSAMPLE* pIn, int iLen);
+
+    // Waits until all analyzers have processed all samples and stored
+    // their results.
+    void finish(TrackPointer pTrack);
+
+    // Discards all pending samples and waits until all analyzers have
+    // been cancelled.
+    void cancel();
+
+  private:
+    friend class AnalyzerLane;
+
+    struct Block {
+        explicit Block(SINT capacity)
+                : samples(capacity),
+                  length(0),
+                  pendingLanes(0) {
+        }
+        mixxx::SampleBuffer samples;
+        int length;
+        // The number of analyzers that have not processed the block yet
+        std::atomic<int> pendingLanes;
+    };
+
+    // Called by the analyzer threads
+    void releaseBlock(Block* pBlock);
+    void laneDone();
+
+    std::vector<std::unique_ptr<Block>> m_blocks;
+    size_t m_nextBlock;
+    QSemaphore m_freeBlocks;
+
+    std::vector<std::unique_ptr<AnalyzerLane>> m_lanes;
+    QSemaphore m_doneLanes;
+
+    // At least one analyzer processes the current track
+    bool m_active;
+
+    // Set before sending the finish message to the analyzer threads
+    TrackPointer m_pFinishedTrack;
+    std::atomic<bool> m_cancelled;
+
+    DISALLOW_COPY_AND_ASSIGN(AnalyzerPipeline);
+};
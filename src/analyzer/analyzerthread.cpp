@@ -64,12 +64,14 @@ AnalyzerThread::Pointer AnalyzerThread::createInstance(
         int id,
         mixxx::DbConnectionPoolPtr dbConnectionPool,
         UserSettingsPointer pConfig,
-        AnalyzerModeFlags modeFlags) {
+        AnalyzerModeFlags modeFlags,
+        bool parallelAnalyzers) {
     return Pointer(new AnalyzerThread(
                            id,
                            dbConnectionPool,
                            pConfig,
-                           modeFlags),
+                           modeFlags,
+                           parallelAnalyzers),
             deleteAnalyzerThread);
 }
 
@@ -77,12 +79,14 @@ AnalyzerThread::AnalyzerThread(
         int id,
         mixxx::DbConnectionPoolPtr dbConnectionPool,
         UserSettingsPointer pConfig,
-        AnalyzerModeFlags modeFlags)
+        AnalyzerModeFlags modeFlags,
+        bool parallelAnalyzers)
         : WorkerThread(QString("AnalyzerThread %1").arg(id)),
           m_id(id),
           m_dbConnectionPool(std::move(dbConnectionPool)),
           m_pConfig(pConfig),
           m_modeFlags(modeFlags),
+          m_parallelAnalyzers(parallelAnalyzers),
           m_nextTrack(2), // minimum capacity
           m_sampleBuffer(mixxx::kAnalysisSamplesPerChunk),
           m_emittedState(AnalyzerThreadState::Void) {
@@ -103,22 +107,39 @@ void AnalyzerThread::doRun() {
             return;
         }
         QSqlDatabase dbConnection = mixxx::DbConnectionPooled(m_dbConnectionPool);
+        // The waveform analyzer always runs on this thread, because it
+        // accesses the database through the connection of this thread.
         m_analyzers.push_back(AnalyzerWithState(std::make_unique<AnalyzerWaveform>(m_pConfig, dbConnection)));
     }
+    std::vector<AnalyzerWithState> analyzers;
     if (AnalyzerGain::isEnabled(ReplayGainSettings(m_pConfig))) {
-        m_analyzers.push_back(AnalyzerWithState(std::make_unique<AnalyzerGain>(m_pConfig)));
+        analyzers.push_back(AnalyzerWithState(std::make_unique<AnalyzerGain>(m_pConfig)));
     }
     if (AnalyzerEbur128::isEnabled(ReplayGainSettings(m_pConfig))) {
-        m_analyzers.push_back(AnalyzerWithState(std::make_unique<AnalyzerEbur128>(m_pConfig)));
+        analyzers.push_back(AnalyzerWithState(std::make_unique<AnalyzerEbur128>(m_pConfig)));
     }
     // BPM detection might be disabled in the config, but can be overridden
     // and enabled by explicitly setting the mode flag.
     const bool enforceBpmDetection = (m_modeFlags & AnalyzerModeFlags::WithBeats) != 0;
-    m_analyzers.push_back(AnalyzerWithState(std::make_unique<AnalyzerBeats>(m_pConfig, enforceBpmDetection)));
-    m_analyzers.push_back(AnalyzerWithState(std::make_unique<AnalyzerKey>(m_pConfig)));
-    m_analyzers.push_back(AnalyzerWithState(std::make_unique<AnalyzerSilence>(m_pConfig)));
-    DEBUG_ASSERT(!m_analyzers.empty());
-    kLogger.debug() << "Activated" << m_analyzers.size() << "analyzers";
+    analyzers.push_back(AnalyzerWithState(std::make_unique<AnalyzerBeats>(m_pConfig, enforceBpmDetection)));
+    analyzers.push_back(AnalyzerWithState(std::make_unique<AnalyzerKey>(m_pConfig)));
+    analyzers.push_back(AnalyzerWithState(std::make_unique<AnalyzerSilence>(m_pConfig)));
+    // Slow analyzers like the beat detection should not delay the
+    // others, so each one gets its own thread if requested.
+    if (m_parallelAnalyzers) {
+        m_pPipeline = std::make_unique<AnalyzerPipeline>(
+                QString("AnalyzerThread %1").arg(m_id),
+                std::move(analyzers));
+    } else {
+        for (auto&& analyzer : analyzers) {
+            m_analyzers.push_back(std::move(analyzer));
+        }
+    }
+    DEBUG_ASSERT(!m_analyzers.empty() || m_pPipeline);
+    kLogger.debug()
+            << "Activated" << m_analyzers.size() << "analyzers and"
+            << (m_pPipeline ? m_pPipeline->numAnalyzers() : 0)
+            << "analyzers on separate threads";
 
     m_lastBusyProgressEmittedTimer.start();
 
@@ -150,6 +171,13 @@ void AnalyzerThread::doRun() {
                 processTrack = true;
             }
         }
+        if (m_pPipeline &&
+                m_pPipeline->initialize(
+                        m_currentTrack,
+                        audioSource->getSignalInfo().getSampleRate(),
+                        audioSource->frameLength() * mixxx::kAnalysisChannels)) {
+            processTrack = true;
+        }
 
         if (processTrack) {
             const auto analysisResult = analyzeAudioSource(audioSource);
@@ -163,11 +191,17 @@ void AnalyzerThread::doRun() {
                 // suddenly.
                 emitBusyProgress(kAnalyzerProgressFinalizing);
                 // This takes around 3 sec on a Atom Netbook
+                if (m_pPipeline) {
+                    m_pPipeline->finish(m_currentTrack);
+                }
                 for (auto&& analyzer : m_analyzers) {
                     analyzer.finish(m_currentTrack);
                 }
                 emitDoneProgress(kAnalyzerProgressDone);
             } else {
+                if (m_pPipeline) {
+                    m_pPipeline->cancel();
+                }
                 for (auto&& analyzer : m_analyzers) {
                     analyzer.cancel();
                 }
@@ -181,6 +215,7 @@ void AnalyzerThread::doRun() {
     DEBUG_ASSERT(!m_currentTrack);
     DEBUG_ASSERT(isStopping());
 
+    m_pPipeline.reset();
     m_analyzers.clear();
 
     kLogger.debug() << "Exiting worker thread";
@@ -297,6 +332,13 @@ AnalyzerThread::AnalysisResult AnalyzerThread::analyzeAudioSource(
 
         // 2nd: step: Analyze chunk of decoded audio data
         if (!readableSampleFrames.frameIndexRange().empty()) {
+            // The analyzers on other threads start first and process
+            // their copy of the samples concurrently
+            if (m_pPipeline) {
+                m_pPipeline->processSamples(
+                        readableSampleFrames.readableData(),
+                        readableSampleFrames.readableLength());
+            }
             for (auto&& analyzer : m_analyzers) {
                 analyzer.processSamples(
                         readableSampleFrames.readableData(),
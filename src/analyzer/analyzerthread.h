@@ -5,6 +5,7 @@
 #include "rigtorp/SPSCQueue.h"
 
 #include "analyzer/analyzer.h"
+#include "analyzer/analyzerpipeline.h"
 #include "analyzer/analyzerprogress.h"
 #include "preferences/usersettings.h"
 #include "sources/audiosource.h"
@@ -56,13 +57,15 @@ class AnalyzerThread : public WorkerThread {
             int id,
             mixxx::DbConnectionPoolPtr dbConnectionPool,
             UserSettingsPointer pConfig,
-            AnalyzerModeFlags modeFlags);
+            AnalyzerModeFlags modeFlags,
+            bool parallelAnalyzers);
 
     /*private*/ AnalyzerThread(
             int id,
             mixxx::DbConnectionPoolPtr dbConnectionPool,
             UserSettingsPointer pConfig,
-            AnalyzerModeFlags modeFlags);
+            AnalyzerModeFlags modeFlags,
+            bool parallelAnalyzers);
     ~AnalyzerThread() override = default;
 
     int id() const {
@@ -97,6 +100,7 @@ class AnalyzerThread : public WorkerThread {
     const mixxx::DbConnectionPoolPtr m_dbConnectionPool;
     const UserSettingsPointer m_pConfig;
     const AnalyzerModeFlags m_modeFlags;
+    const bool m_parallelAnalyzers;
 
     /////////////////////////////////////////////////////////////////////////
     // Thread-safe atomic values
@@ -113,7 +117,10 @@ class AnalyzerThread : public WorkerThread {
     // Thread local: Only used in the constructor/destructor and within
     // run() by the worker thread.
 
+    // Analyzers that run on this thread
     std::vector<AnalyzerWithState> m_analyzers;
+    // Analyzers that run on their own threads, optional
+    std::unique_ptr<AnalyzerPipeline> m_pPipeline;
 
     mixxx::SampleBuffer m_sampleBuffer;
 
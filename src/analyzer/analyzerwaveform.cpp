@@ -1,17 +1,45 @@
 #include "analyzer/analyzerwaveform.h"
 
-#include "engine/engineobject.h"
-#include "engine/filters/enginefilterbessel4.h"
-#include "engine/filters/enginefilterbutterworth8.h"
+#include "analyzer/waveformfilterbank.h"
 #include "library/trackcollection.h"
 #include "track/track.h"
 #include "util/logger.h"
 #include "waveform/waveformfactory.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ANALYZERWAVEFORM_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace {
 
 mixxx::Logger kLogger("AnalyzerWaveform");
 
+#ifdef ANALYZERWAVEFORM_SSE2
+// Reduces the absolute values of the interleaved stereo frames into the
+// peaks of both channels in lanes 0 and 1. Like storeIfGreater() a NaN
+// never replaces a peak.
+inline __m128 reducePeaks(__m128 peaks, const CSAMPLE* pBuffer, int frames) {
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    // Two frames per vector
+    int i = 0;
+    for (; i + 2 <= frames; i += 2) {
+        const __m128 samples = _mm_and_ps(_mm_loadu_ps(pBuffer + 2 * i), absMask);
+        peaks = _mm_max_ps(samples, peaks);
+    }
+    // Fold the peaks of the odd and even frames
+    peaks = _mm_max_ps(peaks, _mm_movehl_ps(peaks, peaks));
+    if (i < frames) {
+        const __m128 samples = _mm_and_ps(
+                _mm_loadl_pi(_mm_setzero_ps(),
+                        reinterpret_cast<const __m64*>(pBuffer + 2 * i)),
+                absMask);
+        peaks = _mm_max_ps(samples, peaks);
+    }
+    return peaks;
+}
+#endif
+
 } // namespace
 
 AnalyzerWaveform::AnalyzerWaveform(
@@ -23,9 +51,6 @@ AnalyzerWaveform::AnalyzerWaveform(
           m_stride(0, 0),
           m_currentStride(0),
           m_currentSummaryStride(0) {
-    m_filter[0] = 0;
-    m_filter[1] = 0;
-    m_filter[2] = 0;
     m_analysisDao.initialize(dbConnection);
 }
 
@@ -52,14 +77,13 @@ bool AnalyzerWaveform::initialize(TrackPointer tio, int sampleRate, int totalSam
     createFilters(sampleRate);
 
     //TODO (vrince) Do we want to expose this as settings or whatever ?
-    const int mainWaveformSampleRate = 441;
     // two visual sample per pixel in full width overview in full hd
     const int summaryWaveformSamples = 2 * 1920;
 
     m_waveform = WaveformPointer(new Waveform(
-            sampleRate, totalSamples, mainWaveformSampleRate, -1));
+            sampleRate, totalSamples, kMainWaveformSampleRate, -1));
     m_waveformSummary = WaveformPointer(new Waveform(
-            sampleRate, totalSamples, mainWaveformSampleRate, summaryWaveformSamples));
+            sampleRate, totalSamples, kMainWaveformSampleRate, summaryWaveformSamples));
 
     // Now, that the Waveform memory is initialized, we can set set them to
     // the TIO. Be aware that other threads of Mixxx can touch them from
@@ -94,8 +118,13 @@ bool AnalyzerWaveform::shouldAnalyze(TrackPointer tio) const {
     ConstWaveformPointer pLoadedTrackWaveformSummary;
 
     TrackId trackId = tio->getId();
-    bool missingWaveform = pTrackWaveform.isNull();
+    // A provisional waveform is only displayed until it is replaced
+    // by the analyzed or the stored one
+    bool missingWaveform = pTrackWaveform.isNull() ||
+            pTrackWaveform->isProvisional();
     bool missingWavesummary = pTrackWaveformSummary.isNull();
+    // Waveforms stored in a previous format are stored again once
+    bool convertStored = false;
 
     if (trackId.isValid() && (missingWaveform || missingWavesummary)) {
         QList<AnalysisDao::AnalysisInfo> analyses =
@@ -108,9 +137,15 @@ bool AnalyzerWaveform::shouldAnalyze(TrackPointer tio) const {
 
             if (analysis.type == AnalysisDao::TYPE_WAVEFORM) {
                 vc = WaveformFactory::waveformVersionToVersionClass(analysis.version);
-                if (missingWaveform && vc == WaveformFactory::VC_USE) {
-                    pLoadedTrackWaveform = ConstWaveformPointer(
-                            WaveformFactory::loadWaveformFromAnalysis(analysis));
+                if (missingWaveform && (vc == WaveformFactory::VC_USE ||
+                        vc == WaveformFactory::VC_CONVERT)) {
+                    Waveform* pWaveform =
+                            WaveformFactory::loadWaveformFromAnalysis(analysis);
+                    if (vc == WaveformFactory::VC_CONVERT) {
+                        WaveformFactory::convertWaveformToCurrentVersion(pWaveform);
+                        convertStored = true;
+                    }
+                    pLoadedTrackWaveform = ConstWaveformPointer(pWaveform);
                     missingWaveform = false;
                 } else if (vc != WaveformFactory::VC_KEEP) {
                     // remove all other Analysis except that one we should keep
@@ -119,9 +154,16 @@ bool AnalyzerWaveform::shouldAnalyze(TrackPointer tio) const {
             }
             if (analysis.type == AnalysisDao::TYPE_WAVESUMMARY) {
                 vc = WaveformFactory::waveformSummaryVersionToVersionClass(analysis.version);
-                if (missingWavesummary && vc == WaveformFactory::VC_USE) {
-                    pLoadedTrackWaveformSummary = ConstWaveformPointer(
-                            WaveformFactory::loadWaveformFromAnalysis(analysis));
+                if (missingWavesummary && (vc == WaveformFactory::VC_USE ||
+                        vc == WaveformFactory::VC_CONVERT)) {
+                    Waveform* pWaveformSummary =
+                            WaveformFactory::loadWaveformFromAnalysis(analysis);
+                    if (vc == WaveformFactory::VC_CONVERT) {
+                        WaveformFactory::convertWaveformSummaryToCurrentVersion(
+                                pWaveformSummary);
+                        convertStored = true;
+                    }
+                    pLoadedTrackWaveformSummary = ConstWaveformPointer(pWaveformSummary);
                     missingWavesummary = false;
                 } else if (vc != WaveformFactory::VC_KEEP) {
                     // remove all other Analysis except that one we should keep
@@ -134,6 +176,19 @@ bool AnalyzerWaveform::shouldAnalyze(TrackPointer tio) const {
     // If we don't need to calculate the waveform/wavesummary, skip.
     if (!missingWaveform && !missingWavesummary) {
         kLogger.debug() << "loadStored - Stored waveform loaded";
+        if (convertStored &&
+                pLoadedTrackWaveform && pLoadedTrackWaveform->isValid() &&
+                pLoadedTrackWaveformSummary && pLoadedTrackWaveformSummary->isValid()) {
+            // Both are saved together, so a waveform of the current
+            // version is stored again with a converted summary and
+            // vice versa
+            pLoadedTrackWaveform->setSaveState(Waveform::SaveState::SavePending);
+            pLoadedTrackWaveformSummary->setSaveState(Waveform::SaveState::SavePending);
+            m_analysisDao.saveTrackAnalyses(
+                    trackId,
+                    pLoadedTrackWaveform,
+                    pLoadedTrackWaveformSummary);
+        }
         if (pLoadedTrackWaveform) {
             tio->setWaveform(pLoadedTrackWaveform);
         }
@@ -146,25 +201,14 @@ bool AnalyzerWaveform::shouldAnalyze(TrackPointer tio) const {
 }
 
 void AnalyzerWaveform::createFilters(int sampleRate) {
-    // m_filter[Low] = new EngineFilterButterworth8(FILTER_LOWPASS, sampleRate, 200);
-    // m_filter[Mid] = new EngineFilterButterworth8(FILTER_BANDPASS, sampleRate, 200, 2000);
-    // m_filter[High] = new EngineFilterButterworth8(FILTER_HIGHPASS, sampleRate, 2000);
-    m_filter[Low] = new EngineFilterBessel4Low(sampleRate, 600);
-    m_filter[Mid] = new EngineFilterBessel4Band(sampleRate, 600, 4000);
-    m_filter[High] = new EngineFilterBessel4High(sampleRate, 4000);
-    // settle filters for silence in preroll to avoids ramping (Bug #1406389)
-    for (int i = 0; i < FilterCount; ++i) {
-        m_filter[i]->assumeSettled();
-    }
+    // The filters are settled for silence in preroll to avoids ramping
+    // (Bug #1406389)
+    m_pFilterBank = std::make_unique<WaveformFilterBank>(
+            sampleRate, kLowMidCorner, kMidHighCorner);
 }
 
 void AnalyzerWaveform::destroyFilters() {
-    for (int i = 0; i < FilterCount; ++i) {
-        if (m_filter[i]) {
-            delete m_filter[i];
-            m_filter[i] = 0;
-        }
-    }
+    m_pFilterBank.reset();
 }
 
 bool AnalyzerWaveform::processSamples(const CSAMPLE* buffer, const int bufferLength) {
@@ -182,14 +226,31 @@ bool AnalyzerWaveform::processSamples(const CSAMPLE* buffer, const int bufferLen
         m_buffers[High].resize(bufferLength);
     }
 
-    m_filter[Low]->process(buffer, &m_buffers[Low][0], bufferLength);
-    m_filter[Mid]->process(buffer, &m_buffers[Mid][0], bufferLength);
-    m_filter[High]->process(buffer, &m_buffers[High][0], bufferLength);
+    m_pFilterBank->process(buffer,
+            &m_buffers[Low][0],
+            &m_buffers[Mid][0],
+            &m_buffers[High][0],
+            bufferLength);
 
     m_waveform->setSaveState(Waveform::SaveState::NotSaved);
     m_waveformSummary->setSaveState(Waveform::SaveState::NotSaved);
 
+    const int firstStride = m_currentStride;
+    const int firstSummaryStride = m_currentSummaryStride;
+
     for (int i = 0; i < bufferLength; i += 2) {
+        // Reduce all frames up to the next possible end of a stride at once
+        const int frames = math_min(
+                (bufferLength - i) / 2,
+                math_min(framesBeforeStrideEnd(m_stride.m_length),
+                        framesBeforeStrideEnd(m_stride.m_averageLength)));
+        if (frames > 0) {
+            storeStridePeaks(buffer, i, frames);
+            m_stride.m_position += frames;
+            i += 2 * (frames - 1);
+            continue;
+        }
+
         // Take max value, not average of data
         CSAMPLE cover[2] = {fabs(buffer[i]), fabs(buffer[i + 1])};
         CSAMPLE clow[2] = {fabs(m_buffers[Low][i]), fabs(m_buffers[Low][i + 1])};
@@ -251,6 +312,9 @@ bool AnalyzerWaveform::processSamples(const CSAMPLE* buffer, const int bufferLen
         }
     }
 
+    m_waveform->updateMipLevels(firstStride, m_currentStride);
+    m_waveformSummary->updateMipLevels(firstSummaryStride, m_currentSummaryStride);
+
     //kLogger.debug() << "process - m_waveform->getCompletion()" << m_waveform->getCompletion() << "off" << m_waveform->getDataSize();
     //kLogger.debug() << "process - m_waveformSummary->getCompletion()" << m_waveformSummary->getCompletion() << "off" << m_waveformSummary->getDataSize();
     return true;
@@ -304,3 +368,40 @@ void AnalyzerWaveform::storeIfGreater(float* pDest, float source) {
         *pDest = source;
     }
 }
+
+int AnalyzerWaveform::framesBeforeStrideEnd(double strideLength) const {
+    // A stride ends after the frame that moves the position less than one
+    // frame past a multiple of the stride length. Subtracting another frame
+    // leaves room for the rounding of the remaining length.
+    const double remainder = fmod(m_stride.m_position, strideLength);
+    return math_max(0, static_cast<int>(strideLength - remainder) - 1);
+}
+
+void AnalyzerWaveform::storeStridePeaks(
+        const CSAMPLE* pBuffer, int offset, int frames) {
+#ifdef ANALYZERWAVEFORM_SSE2
+    float peaks[4];
+    _mm_storeu_ps(peaks, reducePeaks(
+            _mm_setr_ps(m_stride.m_overallData[Left], m_stride.m_overallData[Right], 0, 0),
+            pBuffer + offset, frames));
+    m_stride.m_overallData[Left] = peaks[Left];
+    m_stride.m_overallData[Right] = peaks[Right];
+    for (int f = 0; f < FilterCount; ++f) {
+        _mm_storeu_ps(peaks, reducePeaks(
+                _mm_setr_ps(m_stride.m_filteredData[Left][f],
+                        m_stride.m_filteredData[Right][f], 0, 0),
+                &m_buffers[f][offset], frames));
+        m_stride.m_filteredData[Left][f] = peaks[Left];
+        m_stride.m_filteredData[Right][f] = peaks[Right];
+    }
+#else
+    for (int i = offset; i < offset + 2 * frames; i += 2) {
+        storeIfGreater(&m_stride.m_overallData[Left], fabs(pBuffer[i]));
+        storeIfGreater(&m_stride.m_overallData[Right], fabs(pBuffer[i + 1]));
+        for (int f = 0; f < FilterCount; ++f) {
+            storeIfGreater(&m_stride.m_filteredData[Left][f], fabs(m_buffers[f][i]));
+            storeIfGreater(&m_stride.m_filteredData[Right][f], fabs(m_buffers[f][i + 1]));
+        }
+    }
+#endif
+}
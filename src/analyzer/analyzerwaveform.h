@@ -5,6 +5,7 @@
 #include <QSqlDatabase>
 
 #include <limits>
+#include <memory>
 
 #include "analyzer/analyzer.h"
 #include "library/dao/analysisdao.h"
@@ -15,7 +16,7 @@
 //NOTS vrince some test to segment sound, to apply color in the waveform
 //#define TEST_HEAT_MAP
 
-class EngineFilterIIRBase;
+class WaveformFilterBank;
 
 inline CSAMPLE scaleSignal(CSAMPLE invalue, FilterIndex index = FilterCount) {
     if (invalue == 0.0) {
@@ -142,6 +143,12 @@ class AnalyzerWaveform : public Analyzer {
             QSqlDatabase dbConnection);
     ~AnalyzerWaveform() override;
 
+    // The visual sample rate of the main waveform
+    static constexpr int kMainWaveformSampleRate = 441;
+    // The corner frequencies of the low, mid and high bands
+    static constexpr double kLowMidCorner = 600;
+    static constexpr double kMidHighCorner = 4000;
+
     bool initialize(TrackPointer tio, int sampleRate, int totalSamples) override;
     bool processSamples(const CSAMPLE* buffer, const int bufferLength) override;
     void storeResults(TrackPointer tio) override;
@@ -156,6 +163,11 @@ class AnalyzerWaveform : public Analyzer {
     void createFilters(int sampleRate);
     void destroyFilters();
     void storeIfGreater(float* pDest, float source);
+    // The number of the following frames that cannot end a stride of the
+    // given length, i.e. that can be reduced into the current stride
+    // without checking for its end
+    int framesBeforeStrideEnd(double strideLength) const;
+    void storeStridePeaks(const CSAMPLE* pBuffer, int offset, int frames);
 
     mutable AnalysisDao m_analysisDao;
 
@@ -169,7 +181,7 @@ class AnalyzerWaveform : public Analyzer {
     int m_currentStride;
     int m_currentSummaryStride;
 
-    EngineFilterIIRBase* m_filter[FilterCount];
+    std::unique_ptr<WaveformFilterBank> m_pFilterBank;
     std::vector<float> m_buffers[FilterCount];
 
     PerformanceTimer m_timer;
@@ -0,0 +1,148 @@
+#include "analyzer/trackanalysisqueue.h"
+
+#include "util/assert.h"
+#include "util/stat.h"
+
+namespace {
+
+QString priorityName(TrackAnalysisPriority priority) {
+    switch (priority) {
+    case TrackAnalysisPriority::DeckLoaded:
+        return QStringLiteral("deck loaded");
+    case TrackAnalysisPriority::AutoDjUpcoming:
+        return QStringLiteral("AutoDJ upcoming");
+    case TrackAnalysisPriority::Batch:
+        return QStringLiteral("batch");
+    case TrackAnalysisPriority::Background:
+        return QStringLiteral("background");
+    }
+    DEBUG_ASSERT(!"unreachable");
+    return QString();
+}
+
+} // anonymous namespace
+
+TrackAnalysisQueue::TrackAnalysisQueue() {
+    m_counts.fill(0);
+}
+
+void TrackAnalysisQueue::enqueue(
+        TrackId trackId, TrackAnalysisPriority priority) {
+    DEBUG_ASSERT(trackId.isValid());
+    const int queueIndex = static_cast<int>(priority);
+    const auto queued = m_priorities.find(trackId);
+    if (queued != m_priorities.end()) {
+        const int queuedIndex = static_cast<int>(queued.value());
+        if (queuedIndex <= queueIndex) {
+            // Already queued with the same or a higher priority
+            return;
+        }
+        // The entry in the other queue will be skipped
+        setCount(queuedIndex, m_counts[queuedIndex] - 1);
+        queued.value() = priority;
+    } else {
+        m_priorities.insert(trackId, priority);
+    }
+    m_queues[queueIndex].push_back(trackId);
+    setCount(queueIndex, m_counts[queueIndex] + 1);
+}
+
+bool TrackAnalysisQueue::front(
+        TrackId* pTrackId, TrackAnalysisPriority* pPriority) {
+    const int queueIndex = frontQueueIndex();
+    if (queueIndex < 0) {
+        return false;
+    }
+    *pTrackId = m_queues[queueIndex].front();
+    *pPriority = static_cast<TrackAnalysisPriority>(queueIndex);
+    return true;
+}
+
+void TrackAnalysisQueue::popFront() {
+    const int queueIndex = frontQueueIndex();
+    VERIFY_OR_DEBUG_ASSERT(queueIndex >= 0) {
+        return;
+    }
+    auto& queue = m_queues[queueIndex];
+    m_priorities.remove(queue.front());
+    queue.pop_front();
+    setCount(queueIndex, m_counts[queueIndex] - 1);
+}
+
+void TrackAnalysisQueue::clear() {
+    for (auto& queue : m_queues) {
+        queue.clear();
+    }
+    m_priorities.clear();
+    for (int queueIndex = 0; queueIndex < kPriorityCount; ++queueIndex) {
+        setCount(queueIndex, 0);
+    }
+}
+
+QList<TrackId> TrackAnalysisQueue::trackIds() const {
+    QList<TrackId> trackIds;
+    trackIds.reserve(size());
+    for (int queueIndex = 0; queueIndex < kPriorityCount; ++queueIndex) {
+        for (const auto& trackId : m_queues[queueIndex]) {
+            const auto queued = m_priorities.constFind(trackId);
+            if (queued != m_priorities.constEnd() &&
+                    static_cast<int>(queued.value()) == queueIndex) {
+                trackIds.append(trackId);
+            }
+        }
+    }
+    return trackIds;
+}
+
+int TrackAnalysisQueue::frontQueueIndex() {
+    for (int queueIndex = 0; queueIndex < kPriorityCount; ++queueIndex) {
+        auto& queue = m_queues[queueIndex];
+        while (!queue.empty()) {
+            const auto queued = m_priorities.constFind(queue.front());
+            if (queued != m_priorities.constEnd() &&
+                    static_cast<int>(queued.value()) == queueIndex) {
+                return queueIndex;
+            }
+            // Moved to a queue with a higher priority or already dequeued
+            queue.pop_front();
+        }
+    }
+    return -1;
+}
+
+void TrackAnalysisQueue::setCount(int queueIndex, int count) {
+    DEBUG_ASSERT(count >= 0);
+    m_counts[queueIndex] = count;
+    Stat::track(
+            QStringLiteral("TrackAnalysisScheduler queued ") +
+                    priorityName(static_cast<TrackAnalysisPriority>(queueIndex)),
+            Stat::UNSPECIFIED,
+            Stat::COUNT | Stat::AVERAGE | Stat::MAX,
+            count);
+}
+
+TrackAnalysisPriority TrackAnalysisPreemption::priority(int worker) const {
+    DEBUG_ASSERT(m_busy[worker]);
+    return m_priorities[worker];
+}
+
+bool TrackAnalysisPreemption::isPreempted(int worker) const {
+    if (!m_busy[worker]) {
+        return false;
+    }
+    for (size_t other = 0; other < m_busy.size(); ++other) {
+        if (m_busy[other] && m_priorities[other] < m_priorities[worker]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool TrackAnalysisPreemption::wouldPreempt(TrackAnalysisPriority priority) const {
+    for (size_t worker = 0; worker < m_busy.size(); ++worker) {
+        if (m_busy[worker] && m_priorities[worker] > priority) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <QHash>
+#include <QList>
+
+#include <array>
+#include <deque>
+#include <vector>
+
+#include "track/trackid.h"
+
+// Ordered from the highest to the lowest priority
+enum class TrackAnalysisPriority {
+    // Loaded into a deck by the user
+    DeckLoaded,
+    // Loaded into a deck by AutoDJ in advance
+    AutoDjUpcoming,
+    // Selected by the user for analysis
+    Batch,
+    // Nobody is waiting for the results, e.g. samples
+    Background,
+};
+
+// The tracks that wait for a worker of the TrackAnalysisScheduler, in the
+// order of their priority and in the order they have been queued within
+// each priority.
+class TrackAnalysisQueue {
+  public:
+    static constexpr int kPriorityCount = 4;
+
+    TrackAnalysisQueue();
+
+    // Queuing a queued track again with a higher priority moves it forward.
+    // A lower priority is ignored.
+    void enqueue(TrackId trackId, TrackAnalysisPriority priority);
+
+    bool isEmpty() const {
+        return m_priorities.isEmpty();
+    }
+    int size() const {
+        return m_priorities.size();
+    }
+    // Also reported to the StatsManager
+    int size(TrackAnalysisPriority priority) const {
+        return m_counts[static_cast<int>(priority)];
+    }
+
+    // The next track and its priority. Returns false if the queue is empty.
+    bool front(TrackId* pTrackId, TrackAnalysisPriority* pPriority);
+    void popFront();
+
+    void clear();
+
+    // All queued tracks in the order they will be dequeued
+    QList<TrackId> trackIds() const;
+
+  private:
+    // The index of the queue with the highest priority that is not empty
+    // or -1 if all queues are empty
+    int frontQueueIndex();
+    void setCount(int queueIndex, int count);
+
+    // One queue per priority. The queues might still contain tracks that
+    // have been moved to a queue with a higher priority, only the priority
+    // stored in m_priorities is valid.
+    std::array<std::deque<TrackId>, kPriorityCount> m_queues;
+    QHash<TrackId, TrackAnalysisPriority> m_priorities;
+    std::array<int, kPriorityCount> m_counts;
+};
+
+// Decides which workers of the TrackAnalysisScheduler continue while tracks
+// with different priorities are analyzed. Workers that are busy with a
+// lower priority than the highest priority of all busy workers are
+// preempted until those tracks are done.
+class TrackAnalysisPreemption {
+  public:
+    explicit TrackAnalysisPreemption(int numWorkers)
+            : m_busy(numWorkers, false),
+              m_priorities(numWorkers, TrackAnalysisPriority::Background) {
+    }
+
+    void setBusy(int worker, TrackAnalysisPriority priority) {
+        m_busy[worker] = true;
+        m_priorities[worker] = priority;
+    }
+    void setIdle(int worker) {
+        m_busy[worker] = false;
+    }
+
+    bool isBusy(int worker) const {
+        return m_busy[worker];
+    }
+    // The priority of the track while busy
+    TrackAnalysisPriority priority(int worker) const;
+
+    bool isPreempted(int worker) const;
+
+    // A track with this priority would preempt at least one busy worker.
+    // Only these tracks are started on the reserved worker.
+    bool wouldPreempt(TrackAnalysisPriority priority) const;
+
+  private:
+    std::vector<bool> m_busy;
+    std::vector<TrackAnalysisPriority> m_priorities;
+};
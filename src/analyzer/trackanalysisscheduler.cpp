@@ -50,6 +50,9 @@ TrackAnalysisScheduler::TrackAnalysisScheduler(
         const UserSettingsPointer& pConfig,
         AnalyzerModeFlags modeFlags)
         : m_library(library),
+          // The worker threads are started in a suspended state
+          m_suspended(true),
+          m_preemption(numWorkerThreads + 1),
           m_currentTrackProgress(kAnalyzerProgressUnknown),
           m_currentTrackNumber(0),
           m_dequeuedTracksCount(0),
@@ -65,14 +68,24 @@ TrackAnalysisScheduler::TrackAnalysisScheduler(
                 << numWorkerThreads
                 << "worker threads";
     }
-    // 1st pass: Create worker threads
-    m_workers.reserve(numWorkerThreads);
-    for (int threadId = 0; threadId < numWorkerThreads; ++threadId) {
+    // Running each analyzer on its own thread only pays off while a
+    // single worker is analyzing. Several workers already keep the CPU
+    // cores busy and would otherwise spawn one thread per analyzer each.
+    const bool parallelAnalyzers = pConfig->getValue(
+            ConfigKey("[Library]", "ParallelAnalyzers"),
+            numWorkerThreads <= 1);
+    kLogger.debug()
+            << "Parallel analyzers"
+            << (parallelAnalyzers ? "enabled" : "disabled");
+    // 1st pass: Create worker threads, including the reserved worker
+    m_workers.reserve(numWorkerThreads + 1);
+    for (int threadId = 0; threadId <= numWorkerThreads; ++threadId) {
         m_workers.emplace_back(AnalyzerThread::createInstance(
                 threadId,
                 library->dbConnectionPool(),
                 pConfig,
-                modeFlags));
+                modeFlags,
+                parallelAnalyzers));
         connect(m_workers.back().thread(), &AnalyzerThread::progress,
             this, &TrackAnalysisScheduler::onWorkerThreadProgress);
     }
@@ -163,7 +176,7 @@ void TrackAnalysisScheduler::emitProgressOrFinished() {
         }
     }
     const int totalTracksCount =
-            m_dequeuedTracksCount + m_queuedTrackIds.size();
+            m_dequeuedTracksCount + queuedTracksCount();
     DEBUG_ASSERT(m_currentTrackNumber <= m_dequeuedTracksCount);
     DEBUG_ASSERT(m_dequeuedTracksCount <= totalTracksCount);
     emit progress(
@@ -216,12 +229,16 @@ void TrackAnalysisScheduler::onWorkerThreadProgress(
             worker.onAnalyzerProgress(analyzerProgress);
             emit trackProgress(trackId, analyzerProgress);
         }
+        m_preemption.setIdle(threadId);
+        updatePreemptedWorkers();
         break;
     case AnalyzerThreadState::Exit:
         DEBUG_ASSERT(!trackId.isValid());
         DEBUG_ASSERT(analyzerProgress == kAnalyzerProgressUnknown);
         worker.onThreadExit();
         DEBUG_ASSERT(!worker);
+        m_preemption.setIdle(threadId);
+        updatePreemptedWorkers();
         break;
     default:
         DEBUG_ASSERT(!"Unhandled signal from worker thread");
@@ -229,14 +246,16 @@ void TrackAnalysisScheduler::onWorkerThreadProgress(
     emitProgressOrFinished();
 }
 
-bool TrackAnalysisScheduler::scheduleTrackById(TrackId trackId) {
+bool TrackAnalysisScheduler::scheduleTrackById(
+        TrackId trackId,
+        Priority priority) {
     VERIFY_OR_DEBUG_ASSERT(trackId.isValid()) {
         qWarning()
                 << "Cannot schedule track with invalid id"
                 << trackId;
         return false;
     }
-    m_queuedTrackIds.push_back(trackId);
+    m_queue.enqueue(trackId, priority);
     // Don't wake up the suspended thread now to avoid race conditions
     // if multiple threads are added in a row by calling this function
     // multiple times. The caller is responsible to finish the scheduling
@@ -244,10 +263,12 @@ bool TrackAnalysisScheduler::scheduleTrackById(TrackId trackId) {
     return true;
 }
 
-int TrackAnalysisScheduler::scheduleTracksById(const QList<TrackId>& trackIds) {
+int TrackAnalysisScheduler::scheduleTracksById(
+        const QList<TrackId>& trackIds,
+        Priority priority) {
     int scheduledCount = 0;
     for (auto trackId: trackIds) {
-        if (scheduleTrackById(std::move(trackId))) {
+        if (scheduleTrackById(std::move(trackId), priority)) {
             ++scheduledCount;
         }
     }
@@ -256,6 +277,7 @@ int TrackAnalysisScheduler::scheduleTracksById(const QList<TrackId>& trackIds) {
 
 void TrackAnalysisScheduler::suspend() {
     kLogger.debug() << "Suspending";
+    m_suspended = true;
     for (auto& worker: m_workers) {
         worker.suspendThread();
     }
@@ -263,15 +285,41 @@ void TrackAnalysisScheduler::suspend() {
 
 void TrackAnalysisScheduler::resume() {
     kLogger.debug() << "Resuming";
+    m_suspended = false;
     for (auto& worker: m_workers) {
-        worker.resumeThread();
+        if (!worker.isPreempted()) {
+            worker.resumeThread();
+        }
+    }
+}
+
+void TrackAnalysisScheduler::updatePreemptedWorkers() {
+    for (auto& worker : m_workers) {
+        const bool preempted = m_preemption.isPreempted(workerIndex(worker));
+        if (preempted == worker.isPreempted()) {
+            continue;
+        }
+        worker.setPreempted(preempted);
+        if (preempted) {
+            kLogger.debug()
+                    << "Pausing analysis of track in worker"
+                    << workerIndex(worker);
+            worker.suspendThread();
+        } else if (!m_suspended) {
+            worker.resumeThread();
+        }
     }
 }
 
 bool TrackAnalysisScheduler::submitNextTrack(Worker* worker) {
     DEBUG_ASSERT(worker);
-    while (!m_queuedTrackIds.empty()) {
-        TrackId nextTrackId = m_queuedTrackIds.front();
+    TrackId nextTrackId;
+    Priority priority;
+    while (m_queue.front(&nextTrackId, &priority)) {
+        if (isReservedWorker(*worker) && !m_preemption.wouldPreempt(priority)) {
+            // Leave the track for the other workers
+            return false;
+        }
         DEBUG_ASSERT(nextTrackId.isValid());
         if (nextTrackId.isValid()) {
             TrackPointer nextTrack =
@@ -279,8 +327,10 @@ bool TrackAnalysisScheduler::submitNextTrack(Worker* worker) {
             if (nextTrack) {
                 if (m_pendingTrackIds.insert(nextTrackId).second) {
                     if (worker->submitNextTrack(std::move(nextTrack))) {
-                        m_queuedTrackIds.pop_front();
+                        m_queue.popFront();
                         ++m_dequeuedTracksCount;
+                        m_preemption.setBusy(workerIndex(*worker), priority);
+                        updatePreemptedWorkers();
                         return true;
                     } else {
                         // The worker may already have been assigned new tasks
@@ -310,7 +360,7 @@ bool TrackAnalysisScheduler::submitNextTrack(Worker* worker) {
                     << nextTrackId;
         }
         // Skip this track
-        m_queuedTrackIds.pop_front();
+        m_queue.popFront();
         ++m_dequeuedTracksCount;
     }
     return false;
@@ -323,17 +373,14 @@ void TrackAnalysisScheduler::stop() {
     }
     // The worker threads are still running at this point
     // and m_workers must not be modified!
-    m_queuedTrackIds.clear();
+    m_queue.clear();
     m_pendingTrackIds.clear();
     DEBUG_ASSERT((allTracksFinished()));
 }
 
 QList<TrackId> TrackAnalysisScheduler::stopAndCollectScheduledTrackIds() {
-    QList<TrackId> scheduledTrackIds;
-    scheduledTrackIds.reserve(m_queuedTrackIds.size() + m_pendingTrackIds.size());
-    for (auto queuedTrackId: m_queuedTrackIds) {
-        scheduledTrackIds.append(std::move(queuedTrackId));
-    }
+    // Ordered by priority
+    QList<TrackId> scheduledTrackIds = m_queue.trackIds();
     for (auto pendingTrackId: m_pendingTrackIds) {
         scheduledTrackIds.append(std::move(pendingTrackId));
     }
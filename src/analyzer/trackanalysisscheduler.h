@@ -2,11 +2,11 @@
 
 #include <QList>
 
-#include <deque>
 #include <set>
 #include <vector>
 
 #include "analyzer/analyzerthread.h"
+#include "analyzer/trackanalysisqueue.h"
 
 #include "util/memory.h"
 
@@ -14,10 +14,20 @@
 // forward declaration(s)
 class Library;
 
+// Tracks are analyzed in the order of their priority and in the order
+// they have been scheduled within each priority.
+//
+// While tracks are analyzed the analysis of all tracks with a lower priority
+// is paused and continues where it left off afterwards. The scheduler owns
+// one more worker thread than requested that is reserved for starting the
+// analysis of tracks with a higher priority while all other workers are busy
+// with tracks of a lower priority.
 class TrackAnalysisScheduler : public QObject {
     Q_OBJECT
 
   public:
+    typedef TrackAnalysisPriority Priority;
+
     typedef std::unique_ptr<TrackAnalysisScheduler, void(*)(TrackAnalysisScheduler*)> Pointer;
     // Subclass that provides a default constructor and nothing else
     class NullPointer: public Pointer {
@@ -39,9 +49,20 @@ class TrackAnalysisScheduler : public QObject {
     ~TrackAnalysisScheduler() override;
 
     // Schedule single or multiple tracks. After all tracks have been scheduled
-    // the caller must invoke resume() once.
-    bool scheduleTrackById(TrackId trackId);
-    int scheduleTracksById(const QList<TrackId>& trackIds);
+    // the caller must invoke resume() once. Scheduling a queued track again
+    // with a higher priority moves it forward.
+    bool scheduleTrackById(
+            TrackId trackId,
+            Priority priority = Priority::Batch);
+    int scheduleTracksById(
+            const QList<TrackId>& trackIds,
+            Priority priority = Priority::Batch);
+
+    // The number of tracks with the given priority that are waiting
+    // for a worker. Also reported to the StatsManager.
+    int queuedTrackCount(Priority priority) const {
+        return m_queue.size(priority);
+    }
 
     // Returns the scheduled tracks that have not yet been analyzed.
     // Includes both queued tracks as well as pending tracks that are
@@ -80,7 +101,8 @@ class TrackAnalysisScheduler : public QObject {
       public:
         explicit Worker(AnalyzerThread::Pointer thread = AnalyzerThread::NullPointer())
             : m_thread(std::move(thread)),
-              m_analyzerProgress(kAnalyzerProgressUnknown) {
+              m_analyzerProgress(kAnalyzerProgressUnknown),
+              m_preempted(false) {
         }
         Worker(const Worker&) = delete;
         Worker(Worker&&) = default;
@@ -104,6 +126,15 @@ class TrackAnalysisScheduler : public QObject {
             return m_thread->submitNextTrack(std::move(track));
         }
 
+        // Suspended until all tracks with a higher priority are done
+        bool isPreempted() const {
+            return m_preempted;
+        }
+
+        void setPreempted(bool preempted) {
+            m_preempted = preempted;
+        }
+
         void suspendThread() {
             if (m_thread) {
                 m_thread->suspend();
@@ -136,13 +167,28 @@ class TrackAnalysisScheduler : public QObject {
       private:
         AnalyzerThread::Pointer m_thread;
         AnalyzerProgress m_analyzerProgress;
+        bool m_preempted;
     };
 
     bool submitNextTrack(Worker* worker);
     void emitProgressOrFinished();
 
+    int workerIndex(const Worker& worker) const {
+        return static_cast<int>(&worker - &m_workers.front());
+    }
+    // The reserved worker only analyzes tracks that preempt others
+    bool isReservedWorker(const Worker& worker) const {
+        return &worker == &m_workers.back();
+    }
+    // Suspends the preempted workers and resumes all others
+    void updatePreemptedWorkers();
+
+    int queuedTracksCount() const {
+        return m_queue.size();
+    }
+
     bool allTracksFinished() const {
-        return m_queuedTrackIds.empty() &&
+        return m_queue.isEmpty() &&
                 m_pendingTrackIds.empty();
     }
 
@@ -150,7 +196,13 @@ class TrackAnalysisScheduler : public QObject {
 
     std::vector<Worker> m_workers;
 
-    std::deque<TrackId> m_queuedTrackIds;
+    // Suspended by the host
+    bool m_suspended;
+
+    TrackAnalysisQueue m_queue;
+
+    // The priorities of the tracks that the workers are busy with
+    TrackAnalysisPreemption m_preemption;
 
     // Tracks that have already been submitted to workers
     // and not yet reported back as finished.
@@ -0,0 +1,158 @@
+#include "analyzer/waveformfilterbank.h"
+
+#define MIXXX
+#include <cstdio>
+#include <cstring>
+#include <fidlib.h>
+
+#include "util/assert.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define WAVEFORMFILTERBANK_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// Length of the spec argument of fid_design_coef, like FIDSPEC_LENGTH
+constexpr size_t kSpecLength = 40;
+
+// The sections of fidlib's Bessel cascades only differ in the sign of the
+// feed forward coefficient of the newer delayed value. All of them are
+// normalized to 1 for the older delayed value.
+enum class SectionType {
+    LowPass,  // + 2 * z1
+    HighPass, // - 2 * z1
+};
+
+// Writes the coefficients into pCoef like EngineFilterIIR::setCoefs
+void designCoefs(double* pCoef, int size, const char* spec,
+        int sampleRate, double freq0, double freq1 = 0) {
+    char spec_d[kSpecLength];
+    DEBUG_ASSERT(strlen(spec) < sizeof(spec_d));
+    // Copy to dynamic-ish memory to prevent fidlib API breakage.
+    strcpy(spec_d, spec);
+    pCoef[0] = fid_design_coef(pCoef + 1, size, spec_d, sampleRate, freq0, freq1, 0);
+}
+
+// The operations are done in exactly the same order as in
+// EngineFilterIIR::processSample()
+#ifdef WAVEFORMFILTERBANK_SSE2
+
+inline __m128d processSection(
+        __m128d x,
+        double* pState,
+        const double* pCoef,
+        SectionType type) {
+    const __m128d z2 = _mm_load_pd(pState);
+    const __m128d z1 = _mm_load_pd(pState + 2);
+    __m128d iir = _mm_sub_pd(x, _mm_mul_pd(_mm_set1_pd(pCoef[0]), z2));
+    iir = _mm_sub_pd(iir, _mm_mul_pd(_mm_set1_pd(pCoef[1]), z1));
+    const __m128d twoZ1 = _mm_add_pd(z1, z1);
+    const __m128d fir = type == SectionType::LowPass
+            ? _mm_add_pd(z2, twoZ1)
+            : _mm_sub_pd(z2, twoZ1);
+    _mm_store_pd(pState, z1);
+    _mm_store_pd(pState + 2, iir);
+    return _mm_add_pd(fir, iir);
+}
+
+inline __m128d loadFrame(const CSAMPLE* pIn) {
+    return _mm_cvtps_pd(_mm_castpd_ps(
+            _mm_load_sd(reinterpret_cast<const double*>(pIn))));
+}
+
+inline void storeFrame(CSAMPLE* pOut, __m128d frame) {
+    _mm_storel_pi(reinterpret_cast<__m64*>(pOut), _mm_cvtpd_ps(frame));
+}
+
+#else
+
+inline double processSection(
+        double x,
+        double* pState,
+        const double* pCoef,
+        SectionType type) {
+    const double z2 = pState[0];
+    const double z1 = pState[2];
+    double iir = x - pCoef[0] * z2;
+    iir = iir - pCoef[1] * z1;
+    const double twoZ1 = z1 + z1;
+    const double fir = type == SectionType::LowPass ? z2 + twoZ1 : z2 - twoZ1;
+    pState[0] = z1;
+    pState[2] = iir;
+    return fir + iir;
+}
+
+#endif
+
+} // anonymous namespace
+
+WaveformFilterBank::WaveformFilterBank(
+        int sampleRate, double lowMidCorner, double midHighCorner) {
+    designCoefs(m_lowCoef, 2 * kLowSections, "LpBe4", sampleRate, lowMidCorner);
+    designCoefs(m_midCoef, 2 * kMidSections, "BpBe4", sampleRate,
+            lowMidCorner, midHighCorner);
+    designCoefs(m_highCoef, 2 * kHighSections, "HpBe4", sampleRate, midHighCorner);
+    // Settled for silence
+    memset(m_state, 0, sizeof(m_state));
+}
+
+void WaveformFilterBank::process(const CSAMPLE* pIn,
+        CSAMPLE* pLow,
+        CSAMPLE* pMid,
+        CSAMPLE* pHigh,
+        SINT numSamples) {
+    DEBUG_ASSERT(numSamples % 2 == 0);
+    double (*pLowState)[4] = m_state;
+    double (*pMidState)[4] = m_state + kLowSections;
+    double (*pHighState)[4] = m_state + kLowSections + kMidSections;
+#ifdef WAVEFORMFILTERBANK_SSE2
+    const __m128d lowGain = _mm_set1_pd(m_lowCoef[0]);
+    const __m128d midGain = _mm_set1_pd(m_midCoef[0]);
+    const __m128d highGain = _mm_set1_pd(m_highCoef[0]);
+    for (SINT i = 0; i < numSamples; i += 2) {
+        const __m128d in = loadFrame(pIn + i);
+
+        __m128d low = _mm_mul_pd(in, lowGain);
+        low = processSection(low, pLowState[0], m_lowCoef + 1, SectionType::LowPass);
+        low = processSection(low, pLowState[1], m_lowCoef + 3, SectionType::LowPass);
+        storeFrame(pLow + i, low);
+
+        __m128d mid = _mm_mul_pd(in, midGain);
+        mid = processSection(mid, pMidState[0], m_midCoef + 1, SectionType::HighPass);
+        mid = processSection(mid, pMidState[1], m_midCoef + 3, SectionType::HighPass);
+        mid = processSection(mid, pMidState[2], m_midCoef + 5, SectionType::LowPass);
+        mid = processSection(mid, pMidState[3], m_midCoef + 7, SectionType::LowPass);
+        storeFrame(pMid + i, mid);
+
+        __m128d high = _mm_mul_pd(in, highGain);
+        high = processSection(high, pHighState[0], m_highCoef + 1, SectionType::HighPass);
+        high = processSection(high, pHighState[1], m_highCoef + 3, SectionType::HighPass);
+        storeFrame(pHigh + i, high);
+    }
+#else
+    for (SINT i = 0; i < numSamples; i += 2) {
+        for (int c = 0; c < 2; ++c) {
+            const double in = pIn[i + c];
+
+            double low = in * m_lowCoef[0];
+            low = processSection(low, pLowState[0] + c, m_lowCoef + 1, SectionType::LowPass);
+            low = processSection(low, pLowState[1] + c, m_lowCoef + 3, SectionType::LowPass);
+            pLow[i + c] = static_cast<CSAMPLE>(low);
+
+            double mid = in * m_midCoef[0];
+            mid = processSection(mid, pMidState[0] + c, m_midCoef + 1, SectionType::HighPass);
+            mid = processSection(mid, pMidState[1] + c, m_midCoef + 3, SectionType::HighPass);
+            mid = processSection(mid, pMidState[2] + c, m_midCoef + 5, SectionType::LowPass);
+            mid = processSection(mid, pMidState[3] + c, m_midCoef + 7, SectionType::LowPass);
+            pMid[i + c] = static_cast<CSAMPLE>(mid);
+
+            double high = in * m_highCoef[0];
+            high = processSection(high, pHighState[0] + c, m_highCoef + 1, SectionType::HighPass);
+            high = processSection(high, pHighState[1] + c, m_highCoef + 3, SectionType::HighPass);
+            pHigh[i + c] = static_cast<CSAMPLE>(high);
+        }
+    }
+#endif
+}
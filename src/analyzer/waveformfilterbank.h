@@ -0,0 +1,45 @@
+#pragma once
+
+#include "util/class.h"
+#include "util/types.h"
+
+// The low, mid and high band filters of the waveform analysis, i.e. a
+// Bessel 4th order low pass, band pass and high pass like
+// EngineFilterBessel4Low, EngineFilterBessel4Band and
+// EngineFilterBessel4High.
+//
+// Instead of running each filter over the whole buffer one after another,
+// all three filters are calculated together for each stereo frame with both
+// channels in one SIMD vector. The results are the same as those of the
+// engine filters after assumeSettled(), apart from rounding differences
+// the compiler may introduce with -ffast-math.
+class WaveformFilterBank {
+  public:
+    WaveformFilterBank(int sampleRate, double lowMidCorner, double midHighCorner);
+
+    // Filters the interleaved stereo samples of pIn into the three bands
+    void process(const CSAMPLE* pIn,
+            CSAMPLE* pLow,
+            CSAMPLE* pMid,
+            CSAMPLE* pHigh,
+            SINT numSamples);
+
+  private:
+    // Number of 2nd order sections of the cascades
+    static constexpr int kLowSections = 2;
+    static constexpr int kMidSections = 4;
+    static constexpr int kHighSections = 2;
+    static constexpr int kSections = kLowSections + kMidSections + kHighSections;
+
+    // The gain of the cascade followed by the two feedback
+    // coefficients of each section, like m_coef of EngineFilterIIR
+    double m_lowCoef[1 + 2 * kLowSections];
+    double m_midCoef[1 + 2 * kMidSections];
+    double m_highCoef[1 + 2 * kHighSections];
+
+    // The older and the newer delayed value of each section for the left
+    // and the right channel: {z2 left, z2 right, z1 left, z1 right}
+    alignas(16) double m_state[kSections][4];
+
+    DISALLOW_COPY_AND_ASSIGN(WaveformFilterBank);
+};
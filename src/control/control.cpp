@@ -8,13 +8,18 @@
 // Static member variable definition
 UserSettingsPointer ControlDoublePrivate::s_pUserConfig;
 
-QHash<ConfigKey, QWeakPointer<ControlDoublePrivate> > ControlDoublePrivate::s_qCOHash
-GUARDED_BY(ControlDoublePrivate::s_qCOHashMutex);
-
 QHash<ConfigKey, ConfigKey> ControlDoublePrivate::s_qCOAliasHash
-GUARDED_BY(ControlDoublePrivate::s_qCOHashMutex);
+GUARDED_BY(ControlDoublePrivate::s_qCOAliasHashMutex);
+
+MMutex ControlDoublePrivate::s_qCOAliasHashMutex;
 
-MMutex ControlDoublePrivate::s_qCOHashMutex;
+// static
+ControlRegistry& ControlDoublePrivate::registry() {
+    // Intentionally leaked, because controls with static storage duration
+    // might be destroyed after it otherwise.
+    static ControlRegistry* s_pRegistry = new ControlRegistry();
+    return *s_pRegistry;
+}
 
 /*
 ControlDoublePrivate::ControlDoublePrivate()
@@ -29,10 +34,12 @@ ControlDoublePrivate::ControlDoublePrivate()
 */
 
 ControlDoublePrivate::ControlDoublePrivate(ConfigKey key,
+                                           ControlId id,
                                            ControlObject* pCreatorCO,
                                            bool bIgnoreNops, bool bTrack,
                                            bool bPersist, double defaultValue)
         : m_key(key),
+          m_id(id),
           m_bPersistInConfiguration(bPersist),
           m_bIgnoreNops(bIgnoreNops),
           m_bTrack(bTrack),
@@ -67,10 +74,8 @@ void ControlDoublePrivate::initialize(double defaultValue) {
 }
 
 ControlDoublePrivate::~ControlDoublePrivate() {
-    s_qCOHashMutex.lock();
-    //qDebug() << "ControlDoublePrivate::s_qCOHash.remove(" << m_key.group << "," << m_key.item << ")";
-    s_qCOHash.remove(m_key);
-    s_qCOHashMutex.unlock();
+    //qDebug() << "ControlDoublePrivate::registry().removeExpiredControl(" << m_key.group << "," << m_key.item << ")";
+    registry().removeExpiredControl(m_id);
 
     if (m_bPersistInConfiguration) {
         UserSettingsPointer pConfig = ControlDoublePrivate::s_pUserConfig;
@@ -82,22 +87,23 @@ ControlDoublePrivate::~ControlDoublePrivate() {
 
 // static
 void ControlDoublePrivate::insertAlias(const ConfigKey& alias, const ConfigKey& key) {
-    MMutexLocker locker(&s_qCOHashMutex);
-
-    auto it = s_qCOHash.constFind(key);
-    if (it == s_qCOHash.constEnd()) {
+    ControlId id = registry().lookupId(key);
+    if (id == kInvalidControlId) {
         qWarning() << "WARNING: ControlDoublePrivate::insertAlias called for null control" << key;
         return;
     }
 
-    QSharedPointer<ControlDoublePrivate> pControl = it.value();
+    QSharedPointer<ControlDoublePrivate> pControl = registry().control(id);
     if (pControl.isNull()) {
         qWarning() << "WARNING: ControlDoublePrivate::insertAlias called for expired control" << key;
         return;
     }
 
-    s_qCOAliasHash.insert(key, alias);
-    s_qCOHash.insert(alias, pControl);
+    {
+        MMutexLocker locker(&s_qCOAliasHashMutex);
+        s_qCOAliasHash.insert(key, alias);
+    }
+    registry().setControl(registry().internId(alias), pControl);
 }
 
 // static
@@ -114,17 +120,19 @@ QSharedPointer<ControlDoublePrivate> ControlDoublePrivate::getControl(
 
 
     QSharedPointer<ControlDoublePrivate> pControl;
-    // Scope for MMutexLocker.
-    {
-        MMutexLocker locker(&s_qCOHashMutex);
-        auto it = s_qCOHash.constFind(key);
-        if (it != s_qCOHash.constEnd()) {
+    // Only intern keys of controls that are created, lookups of keys that
+    // do not exist must not grow the registry.
+    const ControlId id = pCreatorCO ?
+            registry().internId(key) : registry().lookupId(key);
+    if (id != kInvalidControlId) {
+        QSharedPointer<ControlDoublePrivate> pExisting = registry().control(id);
+        if (pExisting) {
             if (pCreatorCO) {
                 if (warn) {
                     qDebug() << "ControlObject" << key.group << key.item << "already created";
                 }
             } else {
-                pControl = it.value();
+                pControl = pExisting;
             }
         }
     }
@@ -132,11 +140,10 @@ QSharedPointer<ControlDoublePrivate> ControlDoublePrivate::getControl(
     if (pControl == NULL) {
         if (pCreatorCO) {
             pControl = QSharedPointer<ControlDoublePrivate>(
-                    new ControlDoublePrivate(key, pCreatorCO, bIgnoreNops,
+                    new ControlDoublePrivate(key, id, pCreatorCO, bIgnoreNops,
                                              bTrack, bPersist, defaultValue));
-            MMutexLocker locker(&s_qCOHashMutex);
-            //qDebug() << "ControlDoublePrivate::s_qCOHash.insert(" << key.group << "," << key.item << ")";
-            s_qCOHash.insert(key, pControl);
+            //qDebug() << "ControlDoublePrivate::registry().setControl(" << key.group << "," << key.item << ")";
+            registry().setControl(id, pControl);
         } else if (warn) {
             qWarning() << "ControlDoublePrivate::getControl returning NULL for ("
                        << key.group << "," << key.item << ")";
@@ -145,23 +152,44 @@ QSharedPointer<ControlDoublePrivate> ControlDoublePrivate::getControl(
     return pControl;
 }
 
+// static
+ControlId ControlDoublePrivate::getControlId(const ConfigKey& key) {
+    if (key.isEmpty()) {
+        return kInvalidControlId;
+    }
+    return registry().lookupId(key);
+}
+
+// static
+QSharedPointer<ControlDoublePrivate> ControlDoublePrivate::getControl(
+        ControlId id, bool warn) {
+    if (id == kInvalidControlId) {
+        return QSharedPointer<ControlDoublePrivate>();
+    }
+    QSharedPointer<ControlDoublePrivate> pControl = registry().control(id);
+    if (pControl.isNull() && warn) {
+        qWarning() << "ControlDoublePrivate::getControl returning NULL for"
+                   << registry().key(id);
+    }
+    return pControl;
+}
+
 // static
 void ControlDoublePrivate::getControls(
         QList<QSharedPointer<ControlDoublePrivate> >* pControlList) {
-    s_qCOHashMutex.lock();
     pControlList->clear();
-    for (auto it = s_qCOHash.constBegin(); it != s_qCOHash.constEnd(); ++it) {
-        QSharedPointer<ControlDoublePrivate> pControl = it.value();
+    const int numIds = registry().size();
+    for (ControlId id = 0; id < numIds; ++id) {
+        QSharedPointer<ControlDoublePrivate> pControl = registry().control(id);
         if (!pControl.isNull()) {
             pControlList->push_back(pControl);
         }
     }
-    s_qCOHashMutex.unlock();
 }
 
 // static
 QHash<ConfigKey, ConfigKey> ControlDoublePrivate::getControlAliases() {
-    MMutexLocker locker(&s_qCOHashMutex);
+    MMutexLocker locker(&s_qCOAliasHashMutex);
     return s_qCOAliasHash;
 }
 
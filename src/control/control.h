@@ -7,6 +7,7 @@
 #include <QAtomicPointer>
 
 #include "control/controlbehavior.h"
+#include "control/controlregistry.h"
 #include "control/controlvalue.h"
 #include "preferences/usersettings.h"
 #include "util/mutex.h"
@@ -38,6 +39,19 @@ class ControlDoublePrivate : public QObject {
             ControlObject* pCreatorCO = NULL, bool bIgnoreNops = true, bool bTrack = false,
             bool bPersist = false, double defaultValue = 0.0);
 
+    // Returns the id of the ConfigKey or kInvalidControlId if no control has
+    // ever been created for it. Unknown keys are not interned, so lookups of
+    // arbitrary keys, e.g. from controller scripts, do not grow the registry.
+    // Looking up controls by id is cheaper than by ConfigKey, because the key
+    // does not need to be hashed and no lock is taken. Use this for keys that
+    // are resolved repeatedly.
+    static ControlId getControlId(const ConfigKey& key);
+
+    // Gets the ControlDoublePrivate for an id returned by getControlId() or
+    // null if the control does not exist (yet or anymore).
+    static QSharedPointer<ControlDoublePrivate> getControl(
+            ControlId id, bool warn = true);
+
     // Adds all ControlDoublePrivate that currently exist to pControlList
     static void getControls(QList<QSharedPointer<ControlDoublePrivate> >* pControlsList);
 
@@ -109,6 +123,10 @@ class ControlDoublePrivate : public QObject {
         return m_key;
     }
 
+    inline ControlId getId() const {
+        return m_id;
+    }
+
     // Connects a slot to the ValueChange request for CO validation. All change
     // requests issued by set are routed though the connected slot. This can
     // decide with its own thread safe solution if the requested value can be
@@ -131,13 +149,14 @@ class ControlDoublePrivate : public QObject {
     void valueChangeRequest(double value);
 
   private:
-    ControlDoublePrivate(ConfigKey key, ControlObject* pCreatorCO,
+    ControlDoublePrivate(ConfigKey key, ControlId id, ControlObject* pCreatorCO,
                          bool bIgnoreNops, bool bTrack, bool bPersist,
                          double defaultValue);
     void initialize(double defaultValue);
     void setInner(double value, QObject* pSender);
 
     ConfigKey m_key;
+    const ControlId m_id;
 
     // Whether the control should persist in the Mixxx user configuration. The
     // value is loaded from configuration when the control is created and
@@ -177,14 +196,15 @@ class ControlDoublePrivate : public QObject {
     // configuration object would be arduous.
     static UserSettingsPointer s_pUserConfig;
 
-    // Hash of ControlDoublePrivate instantiations.
-    static QHash<ConfigKey, QWeakPointer<ControlDoublePrivate> > s_qCOHash;
+    // Registry of ControlDoublePrivate instantiations, including aliases.
+    static ControlRegistry& registry();
+
     // Hash of aliases between ConfigKeys. Solely used for looking up the first
     // alias associated with a key.
     static QHash<ConfigKey, ConfigKey> s_qCOAliasHash;
 
-    // Mutex guarding access to s_qCOHash and s_qCOAliasHash.
-    static MMutex s_qCOHashMutex;
+    // Mutex guarding access to s_qCOAliasHash.
+    static MMutex s_qCOAliasHashMutex;
 };
 
 
@@ -71,6 +71,15 @@ ControlObject* ControlObject::getControl(const ConfigKey& key, bool warn) {
     return NULL;
 }
 
+// static
+ControlObject* ControlObject::getControl(ControlId id, bool warn) {
+    QSharedPointer<ControlDoublePrivate> pCDP = ControlDoublePrivate::getControl(id, warn);
+    if (pCDP) {
+        return pCDP->getCreatorCO();
+    }
+    return NULL;
+}
+
 void ControlObject::setValueFromMidi(MidiOpCode o, double v) {
     if (m_pControl) {
         m_pControl->setValueFromMidi(o, v);
@@ -87,6 +96,12 @@ double ControlObject::get(const ConfigKey& key) {
     return pCop ? pCop->get() : 0.0;
 }
 
+// static
+double ControlObject::get(ControlId id) {
+    QSharedPointer<ControlDoublePrivate> pCop = ControlDoublePrivate::getControl(id);
+    return pCop ? pCop->get() : 0.0;
+}
+
 double ControlObject::getParameter() const {
     return m_pControl ? m_pControl->getParameter() : 0.0;
 }
@@ -119,6 +134,14 @@ void ControlObject::set(const ConfigKey& key, const double& value) {
     }
 }
 
+// static
+void ControlObject::set(ControlId id, const double& value) {
+    QSharedPointer<ControlDoublePrivate> pCop = ControlDoublePrivate::getControl(id);
+    if (pCop) {
+        pCop->set(value, NULL);
+    }
+}
+
 void ControlObject::setReadOnly() {
     connectValueChangeRequest(this, &ControlObject::readOnlyHandler,
                               Qt::DirectConnection);
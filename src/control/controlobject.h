@@ -47,6 +47,9 @@ class ControlObject : public QObject {
         ConfigKey key(group, item);
         return getControl(key, warn);
     }
+    // Returns a pointer to the ControlObject matching the given id, see
+    // ControlDoublePrivate::getControlId()
+    static ControlObject* getControl(ControlId id, bool warn = true);
 
     QString name() const {
         return m_pControl ?  m_pControl->name() : QString();
@@ -85,6 +88,7 @@ class ControlObject : public QObject {
 
     // Instantly returns the value of the ControlObject
     static double get(const ConfigKey& key);
+    static double get(ControlId id);
 
     // Sets the ControlObject value. May require confirmation by owner.
     inline void set(double value) {
@@ -108,6 +112,7 @@ class ControlObject : public QObject {
 
     // Instantly sets the value of the ControlObject
     static void set(const ConfigKey& key, const double& value);
+    static void set(ControlId id, const double& value);
 
     // Sets the default value
     inline void reset() {
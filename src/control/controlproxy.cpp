@@ -5,6 +5,7 @@
 
 ControlProxy::ControlProxy(QObject* pParent)
         : QObject(pParent),
+          m_controlId(kInvalidControlId),
           m_pControl(NULL) {
 }
 
@@ -25,9 +26,14 @@ ControlProxy::ControlProxy(const ConfigKey& key, QObject* pParent)
 
 void ControlProxy::initialize(const ConfigKey& key, bool warn) {
     m_key = key;
+    m_controlId = kInvalidControlId;
     // Don't bother looking up the control if key is NULL. Prevents log spew.
     if (!key.isNull()) {
-        m_pControl = ControlDoublePrivate::getControl(key, warn);
+        m_controlId = ControlDoublePrivate::getControlId(key);
+        m_pControl = ControlDoublePrivate::getControl(m_controlId, false);
+        if (!m_pControl && warn) {
+            qWarning() << "ControlProxy: No control for" << key;
+        }
     }
 }
 
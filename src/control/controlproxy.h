@@ -31,6 +31,12 @@ class ControlProxy : public QObject {
         return m_key;
     }
 
+    // The id of the connected control or kInvalidControlId if the control
+    // does not exist, see ControlDoublePrivate::getControlId()
+    ControlId getControlId() const {
+        return m_controlId;
+    }
+
     template<typename Receiver, typename Slot>
     bool connectValueChanged(Receiver receiver,
             Slot func,
@@ -197,6 +203,7 @@ class ControlProxy : public QObject {
 
   protected:
     ConfigKey m_key;
+    ControlId m_controlId;
     // Pointer to connected control.
     QSharedPointer<ControlDoublePrivate> m_pControl;
 };
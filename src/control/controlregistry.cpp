@@ -0,0 +1,140 @@
+#include "control/controlregistry.h"
+
+#include <QtDebug>
+
+#include "util/assert.h"
+
+struct ControlRegistry::Entry {
+    // Written once before the id is published.
+    ConfigKey key;
+    // Guards pControl.
+    mutable std::atomic_flag lock = ATOMIC_FLAG_INIT;
+    QWeakPointer<ControlDoublePrivate> pControl;
+};
+
+struct ControlRegistry::Shard {
+    mutable MReadWriteLock lock;
+    QHash<ConfigKey, ControlId> ids;
+};
+
+namespace {
+
+// Holding the lock of an entry is only ever needed for copying or assigning
+// a weak pointer, so spinning is cheaper than a mutex.
+class EntryLocker {
+  public:
+    explicit EntryLocker(std::atomic_flag* pLock)
+            : m_pLock(pLock) {
+        while (m_pLock->test_and_set(std::memory_order_acquire)) {
+        }
+    }
+    ~EntryLocker() {
+        m_pLock->clear(std::memory_order_release);
+    }
+
+  private:
+    std::atomic_flag* const m_pLock;
+};
+
+} // anonymous namespace
+
+ControlRegistry::ControlRegistry()
+        : m_shards(new Shard[kShardCount]),
+          m_size(0) {
+    for (auto& chunk : m_chunks) {
+        chunk.store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+ControlRegistry::~ControlRegistry() {
+    for (auto& chunk : m_chunks) {
+        delete[] chunk.load(std::memory_order_relaxed);
+    }
+    delete[] m_shards;
+}
+
+ControlRegistry::Entry& ControlRegistry::entry(ControlId id) const {
+    Entry* pChunk = m_chunks[id >> kChunkSizeBits].load(std::memory_order_acquire);
+    return pChunk[id & (kChunkSize - 1)];
+}
+
+ControlId ControlRegistry::lookupId(const ConfigKey& key) const {
+    const Shard& shard = m_shards[qHash(key) % kShardCount];
+    MReadLocker locker(&shard.lock);
+    return shard.ids.value(key, kInvalidControlId);
+}
+
+ControlId ControlRegistry::internId(const ConfigKey& key) {
+    ControlId id = lookupId(key);
+    if (id != kInvalidControlId) {
+        return id;
+    }
+
+    Shard& shard = m_shards[qHash(key) % kShardCount];
+    MWriteLocker locker(&shard.lock);
+    // Another thread might have interned the key in the meantime
+    id = shard.ids.value(key, kInvalidControlId);
+    if (id != kInvalidControlId) {
+        return id;
+    }
+
+    MMutexLocker appendLocker(&m_appendMutex);
+    id = m_size.load(std::memory_order_relaxed);
+    const int chunkIndex = id >> kChunkSizeBits;
+    VERIFY_OR_DEBUG_ASSERT(chunkIndex < kMaxChunks) {
+        qWarning() << "ControlRegistry: Too many controls, ignoring" << key;
+        return kInvalidControlId;
+    }
+    if (!m_chunks[chunkIndex].load(std::memory_order_relaxed)) {
+        m_chunks[chunkIndex].store(new Entry[kChunkSize], std::memory_order_release);
+    }
+    entry(id).key = key;
+    // Publish the new entry for iterating over all ids
+    m_size.store(id + 1, std::memory_order_release);
+    shard.ids.insert(key, id);
+    return id;
+}
+
+const ConfigKey& ControlRegistry::key(ControlId id) const {
+    DEBUG_ASSERT(id >= 0 && id < size());
+    return entry(id).key;
+}
+
+QSharedPointer<ControlDoublePrivate> ControlRegistry::control(ControlId id) const {
+    VERIFY_OR_DEBUG_ASSERT(id >= 0 && id < size()) {
+        return QSharedPointer<ControlDoublePrivate>();
+    }
+    const Entry& e = entry(id);
+    EntryLocker locker(&e.lock);
+    return e.pControl.toStrongRef();
+}
+
+void ControlRegistry::setControl(ControlId id,
+        const QSharedPointer<ControlDoublePrivate>& pControl) {
+    VERIFY_OR_DEBUG_ASSERT(id >= 0 && id < size()) {
+        return;
+    }
+    Entry& e = entry(id);
+    // Destroy the previous weak pointer outside of the spin lock
+    QWeakPointer<ControlDoublePrivate> pPrevious = pControl;
+    {
+        EntryLocker locker(&e.lock);
+        e.pControl.swap(pPrevious);
+    }
+}
+
+void ControlRegistry::removeExpiredControl(ControlId id) {
+    VERIFY_OR_DEBUG_ASSERT(id >= 0 && id < size()) {
+        return;
+    }
+    Entry& e = entry(id);
+    QWeakPointer<ControlDoublePrivate> pPrevious;
+    {
+        EntryLocker locker(&e.lock);
+        // A new control for the key might already have replaced the
+        // expired one.
+        if (e.pControl.isNull()) {
+            e.pControl.swap(pPrevious);
+        }
+    }
+}
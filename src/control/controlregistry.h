@@ -0,0 +1,76 @@
+#pragma once
+
+#include <QHash>
+#include <QSharedPointer>
+#include <QWeakPointer>
+#include <atomic>
+
+#include "preferences/configobject.h"
+#include "util/class.h"
+#include "util/mutex.h"
+
+class ControlDoublePrivate;
+
+// A ConfigKey that has been interned by the ControlRegistry. Ids are dense,
+// start at 0 and stay valid for the lifetime of the process, even after the
+// control for the key has been deleted.
+typedef int ControlId;
+
+const ControlId kInvalidControlId = -1;
+
+// Maps ConfigKeys to ControlIds and ControlIds to the ControlDoublePrivate
+// that currently exists for the key.
+//
+// Looking up the id of a key only locks one of many shards for reading, so
+// threads that look up different keys do not contend with each other.
+// Looking up the control of an id does not lock at all apart from a per-id
+// spin lock that is only contended if the same control is looked up by
+// multiple threads at the same time. Ids are never removed, which allows
+// to store the entries in chunks that are never moved or freed.
+class ControlRegistry {
+  public:
+    ControlRegistry();
+    ~ControlRegistry();
+
+    // Returns the id of the key or kInvalidControlId if it has not been
+    // interned yet.
+    ControlId lookupId(const ConfigKey& key) const;
+    // Returns the id of the key and interns it if necessary.
+    ControlId internId(const ConfigKey& key);
+
+    // The number of interned keys. All ids are less than this.
+    int size() const {
+        return m_size.load(std::memory_order_acquire);
+    }
+
+    const ConfigKey& key(ControlId id) const;
+
+    // Returns the control for the id or null if it does not exist (anymore).
+    QSharedPointer<ControlDoublePrivate> control(ControlId id) const;
+    // Registers pControl for the id, replacing any previous control.
+    void setControl(ControlId id,
+            const QSharedPointer<ControlDoublePrivate>& pControl);
+    // Unregisters the control of the id unless it has already been replaced
+    // by a control that still exists.
+    void removeExpiredControl(ControlId id);
+
+  private:
+    struct Entry;
+    struct Shard;
+
+    Entry& entry(ControlId id) const;
+
+    static constexpr int kShardCount = 64;
+    static constexpr int kChunkSizeBits = 10;
+    static constexpr int kChunkSize = 1 << kChunkSizeBits;
+    // Allows up to 1M interned keys, which is far more than Mixxx uses.
+    static constexpr int kMaxChunks = 1024;
+
+    Shard* const m_shards;
+    std::atomic<Entry*> m_chunks[kMaxChunks];
+    std::atomic<int> m_size;
+    // Guards appending new ids.
+    MMutex m_appendMutex;
+
+    DISALLOW_COPY_AND_ASSIGN(ControlRegistry);
+};
@@ -7,6 +7,7 @@
 #include "controllers/engine/colormapperjsproxy.h"
 #include "controllers/engine/controllerenginejsproxy.h"
 #include "controllers/engine/scriptconnectionjsproxy.h"
+#include "engine/deckstate.h"
 #include "errordialoghandler.h"
 #include "mixer/playermanager.h"
 // to tell the msvs compiler about `isnan`
@@ -474,7 +475,45 @@ ControlObjectScript* ControllerEngine::getControlObjectScript(const QString& gro
     return coScript;
 }
 
+bool ControllerEngine::getDeckStateValue(
+        const QString& group, const QString& name, double* pValue) {
+    // Only the indicators that are solely written by the engine. Reading
+    // controls that scripts may set from the snapshot would return the
+    // previous value until the next engine callback.
+    if (name != "VuMeter" && name != "VuMeterL" && name != "VuMeterR" &&
+            name != "beat_distance") {
+        return false;
+    }
+    QSharedPointer<DeckStatePublisher> pPublisher = m_deckStatePublishers.value(group);
+    if (pPublisher.isNull()) {
+        pPublisher = DeckStatePublisher::getPublisher(group);
+        if (pPublisher.isNull()) {
+            return false;
+        }
+        m_deckStatePublishers.insert(group, pPublisher);
+    }
+    const DeckState& state = pPublisher->read(DeckStatePublisher::Reader::Controllers);
+    if (state.version == 0) {
+        // Not processed by the engine yet
+        return false;
+    }
+    if (name == "VuMeter") {
+        *pValue = state.vuMeter;
+    } else if (name == "VuMeterL") {
+        *pValue = state.vuMeterLeft;
+    } else if (name == "VuMeterR") {
+        *pValue = state.vuMeterRight;
+    } else {
+        *pValue = state.beatDistance;
+    }
+    return true;
+}
+
 double ControllerEngine::getValue(QString group, QString name) {
+    double deckStateValue;
+    if (getDeckStateValue(group, name, &deckStateValue)) {
+        return deckStateValue;
+    }
     ControlObjectScript* coScript = getControlObjectScript(group, name);
     if (coScript == nullptr) {
         qWarning() << "ControllerEngine: Unknown control" << group << name << ", returning 0.0";
@@ -493,7 +532,9 @@ void ControllerEngine::setValue(QString group, QString name, double newValue) {
     ControlObjectScript* coScript = getControlObjectScript(group, name);
 
     if (coScript != nullptr) {
-        ControlObject* pControl = ControlObject::getControl(coScript->getKey());
+        // The id has been resolved when the script control was cached, so
+        // this neither hashes the key nor takes a lock.
+        ControlObject* pControl = ControlObject::getControl(coScript->getControlId());
         if (pControl && !m_st.ignore(pControl, coScript->getParameterForValue(newValue))) {
             coScript->slotSet(newValue);
         }
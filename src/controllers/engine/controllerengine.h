@@ -17,6 +17,7 @@ class Controller;
 class ControlObjectScript;
 class ControllerEngine;
 class ControllerEngineJSProxy;
+class DeckStatePublisher;
 class EvaluationException;
 class ScriptConnection;
 
@@ -136,6 +137,9 @@ class ControllerEngine : public QObject {
     QJSEngine* m_pScriptEngine;
 
     ControlObjectScript* getControlObjectScript(const QString& group, const QString& name);
+    /// Reads the engine indicators of decks from the snapshot published by
+    /// the engine. Returns false if the control is not part of it.
+    bool getDeckStateValue(const QString& group, const QString& name, double* pValue);
 
     // Scratching functions & variables
 
@@ -148,6 +152,7 @@ class ControllerEngine : public QObject {
     Controller* m_pController;
     QList<QString> m_scriptFunctionPrefixes;
     QHash<ConfigKey, ControlObjectScript*> m_controlCache;
+    QHash<QString, QSharedPointer<DeckStatePublisher>> m_deckStatePublishers;
     struct TimerInfo {
         QJSValue callback;
         bool oneShot;
@@ -57,21 +57,7 @@ void Bessel4LVMixEQEffect::processChannel(const ChannelHandle& handle,
         double fLow;
         double fMid;
         double fHigh;
-        if (!m_pKillLow->toBool()) {
-            fLow = m_pPotLow->value();
-        } else {
-            fLow = 0;
-        }
-        if (!m_pKillMid->toBool()) {
-            fMid = m_pPotMid->value();
-        } else {
-            fMid = 0;
-        }
-        if (!m_pKillHigh->toBool()) {
-            fHigh = m_pPotHigh->value();
-        } else {
-            fHigh = 0;
-        }
+        getGains(&fLow, &fMid, &fHigh);
         pState->processChannel(pInput, pOutput,
                                bufferParameters.samplesPerBuffer(),
                                bufferParameters.sampleRate(),
@@ -79,3 +65,40 @@ void Bessel4LVMixEQEffect::processChannel(const ChannelHandle& handle,
                                m_pLoFreqCorner->get(), m_pHiFreqCorner->get());
     }
 }
+
+void Bessel4LVMixEQEffect::prepareChannelBatch(const ChannelHandle& handle,
+                                               Bessel4LVMixEQEffectGroupState* pState,
+                                               const CSAMPLE* pInput,
+                                               const mixxx::EngineParameters& bufferParameters,
+                                               EngineFilterIIRBatch* pBatch) {
+    Q_UNUSED(handle);
+
+    double fLow;
+    double fMid;
+    double fHigh;
+    getGains(&fLow, &fMid, &fHigh);
+    pState->prepareBatch(pInput,
+                         bufferParameters.samplesPerBuffer(),
+                         bufferParameters.sampleRate(),
+                         fLow, fMid, fHigh,
+                         m_pLoFreqCorner->get(), m_pHiFreqCorner->get(),
+                         pBatch);
+}
+
+void Bessel4LVMixEQEffect::getGains(double* pLow, double* pMid, double* pHigh) const {
+    if (!m_pKillLow->toBool()) {
+        *pLow = m_pPotLow->value();
+    } else {
+        *pLow = 0;
+    }
+    if (!m_pKillMid->toBool()) {
+        *pMid = m_pPotMid->value();
+    } else {
+        *pMid = 0;
+    }
+    if (!m_pKillHigh->toBool()) {
+        *pHigh = m_pPotHigh->value();
+    } else {
+        *pHigh = 0;
+    }
+}
@@ -39,11 +39,20 @@ class Bessel4LVMixEQEffect : public EffectProcessorImpl<Bessel4LVMixEQEffectGrou
                         const EffectEnableState enableState,
                         const GroupFeatureState& groupFeatureState);
 
+    // See effectprocessor.h
+    void prepareChannelBatch(const ChannelHandle& handle,
+                             Bessel4LVMixEQEffectGroupState* pState,
+                             const CSAMPLE* pInput,
+                             const mixxx::EngineParameters& bufferParameters,
+                             EngineFilterIIRBatch* pBatch);
+
   private:
     QString debugString() const {
         return getId();
     }
 
+    void getGains(double* pLow, double* pMid, double* pHigh) const;
+
     EngineEffectParameter* m_pPotLow;
     EngineEffectParameter* m_pPotMid;
     EngineEffectParameter* m_pPotHigh;
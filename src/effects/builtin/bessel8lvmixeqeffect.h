@@ -42,11 +42,20 @@ class Bessel8LVMixEQEffect : public EffectProcessorImpl<Bessel8LVMixEQEffectGrou
                         const EffectEnableState enableState,
                         const GroupFeatureState& groupFeatureState);
 
+    // See effectprocessor.h
+    void prepareChannelBatch(const ChannelHandle& handle,
+                             Bessel8LVMixEQEffectGroupState* pState,
+                             const CSAMPLE* pInput,
+                             const mixxx::EngineParameters& bufferParameters,
+                             EngineFilterIIRBatch* pBatch);
+
   private:
     QString debugString() const {
         return getId();
     }
 
+    void getGains(double* pLow, double* pMid, double* pHigh) const;
+
     EngineEffectParameter* m_pPotLow;
     EngineEffectParameter* m_pPotMid;
     EngineEffectParameter* m_pPotHigh;
@@ -17,6 +17,7 @@
 #ifndef __MACAPPSTORE__
 #include "effects/builtin/reverbeffect.h"
 #endif
+#include "effects/builtin/convolutionreverbeffect.h"
 #include "effects/builtin/echoeffect.h"
 #include "effects/builtin/autopaneffect.h"
 #include "effects/builtin/phasereffect.h"
@@ -49,6 +50,7 @@ BuiltInBackend::BuiltInBackend(QObject* pParent)
 #ifndef __MACAPPSTORE__
     registerEffect<ReverbEffect>();
 #endif
+    registerEffect<ConvolutionReverbEffect>();
     registerEffect<PhaserEffect>();
     registerEffect<MetronomeEffect>();
     registerEffect<TremoloEffect>();
@@ -0,0 +1,163 @@
+#include "effects/builtin/convolutionreverbeffect.h"
+
+#include <QtDebug>
+
+#include "util/math.h"
+#include "util/sample.h"
+
+namespace {
+
+// A state switches to a new kernel at its next long block boundary and
+// fades out the previous one during the following long block. Only after
+// that the kernel before can be retired.
+constexpr SINT kKernelRetireFrames =
+        2 * PartitionedConvolutionKernel::kLongBlockFrames;
+
+} // anonymous namespace
+
+// static
+QString ConvolutionReverbEffect::getId() {
+    return "org.mixxx.effects.convolutionreverb";
+}
+
+// static
+EffectManifestPointer ConvolutionReverbEffect::getManifest() {
+    EffectManifestPointer pManifest(new EffectManifest());
+    pManifest->setAddDryToWet(true);
+    pManifest->setEffectRampsFromDry(true);
+
+    pManifest->setId(getId());
+    pManifest->setName(QObject::tr("Convolution Reverb"));
+    pManifest->setShortName(QObject::tr("Conv Reverb"));
+    pManifest->setAuthor("The Mixxx Team");
+    pManifest->setVersion("1.0");
+    pManifest->setDescription(QObject::tr(
+        "Places the signal in a room by convolving it with an impulse response.\n"
+        "Audio files in the impulse_responses folder of the settings folder\n"
+        "can be selected in addition to the built-in impulse responses."));
+
+    EffectManifestParameterPointer impulse = pManifest->addParameter();
+    impulse->setId("impulse");
+    impulse->setName(QObject::tr("Impulse Response"));
+    impulse->setShortName(QObject::tr("IR"));
+    impulse->setDescription(QObject::tr(
+        "The impulse response of the room"));
+    impulse->setControlHint(EffectManifestParameter::ControlHint::TOGGLE_STEPPING);
+    impulse->setSemanticHint(EffectManifestParameter::SemanticHint::UNKNOWN);
+    impulse->setUnitsHint(EffectManifestParameter::UnitsHint::UNKNOWN);
+    const QStringList impulseResponseNames = ImpulseResponseLoader::impulseResponseNames();
+    for (int i = 0; i < impulseResponseNames.size(); ++i) {
+        impulse->appendStep(qMakePair(impulseResponseNames.at(i), static_cast<double>(i)));
+    }
+    impulse->setMinimum(0);
+    impulse->setDefault(0);
+    impulse->setMaximum(impulseResponseNames.size() - 1);
+
+    EffectManifestParameterPointer send = pManifest->addParameter();
+    send->setId("send_amount");
+    send->setName(QObject::tr("Send"));
+    send->setShortName(QObject::tr("Send"));
+    send->setDescription(QObject::tr(
+        "How much of the signal to send in to the effect"));
+    send->setControlHint(EffectManifestParameter::ControlHint::KNOB_LINEAR);
+    send->setSemanticHint(EffectManifestParameter::SemanticHint::UNKNOWN);
+    send->setUnitsHint(EffectManifestParameter::UnitsHint::UNKNOWN);
+    send->setDefaultLinkType(EffectManifestParameter::LinkType::LINKED);
+    send->setDefaultLinkInversion(EffectManifestParameter::LinkInversion::NOT_INVERTED);
+    send->setMinimum(0);
+    send->setDefault(0);
+    send->setMaximum(1);
+
+    return pManifest;
+}
+
+ConvolutionReverbEffect::ConvolutionReverbEffect(EngineEffect* pEffect)
+        : m_pImpulseParameter(pEffect->getParameterById("impulse")),
+          m_pSendParameter(pEffect->getParameterById("send_amount")),
+          m_pKernel(nullptr),
+          m_pPreviousKernel(nullptr),
+          m_kernelChanges(0) {
+    m_loader.start(QThread::LowPriority);
+}
+
+ConvolutionReverbEffect::~ConvolutionReverbEffect() {
+    //qDebug() << debugString() << "destroyed";
+    delete m_pKernel;
+    delete m_pPreviousKernel;
+}
+
+void ConvolutionReverbEffect::updateKernels(
+        ConvolutionReverbGroupState* pState, SINT sampleRate) {
+    m_loader.requestKernel(m_pImpulseParameter->toInt(), sampleRate);
+    if (pState->kernelChanges != m_kernelChanges) {
+        pState->kernelChanges = m_kernelChanges;
+        pState->framesSinceKernelChange = 0;
+    }
+    // All states that have been active since the last change have
+    // processed as many frames as this one, so they are done with the
+    // previous kernel as well. States that are enabled later start
+    // without a crossfade.
+    if (m_pPreviousKernel &&
+            pState->framesSinceKernelChange < kKernelRetireFrames) {
+        // A newly loaded kernel waits in the loader
+        return;
+    }
+    PartitionedConvolutionKernel* pKernel = m_loader.takeKernel();
+    if (!pKernel) {
+        return;
+    }
+    m_loader.retireKernel(m_pPreviousKernel);
+    m_pPreviousKernel = m_pKernel;
+    m_pKernel = pKernel;
+    ++m_kernelChanges;
+    pState->kernelChanges = m_kernelChanges;
+    pState->framesSinceKernelChange = 0;
+}
+
+void ConvolutionReverbEffect::processChannel(const ChannelHandle& handle,
+                                ConvolutionReverbGroupState* pState,
+                                const CSAMPLE* pInput, CSAMPLE* pOutput,
+                                const mixxx::EngineParameters& bufferParameters,
+                                const EffectEnableState enableState,
+                                const GroupFeatureState& groupFeatures) {
+    Q_UNUSED(handle);
+    Q_UNUSED(groupFeatures);
+
+    const SINT sampleRate = bufferParameters.sampleRate();
+    const auto sendCurrent = static_cast<CSAMPLE_GAIN>(m_pSendParameter->value());
+
+    updateKernels(pState, sampleRate);
+    // Stop using the retired kernels before the loader deletes them
+    pState->convolver.retainKernels(m_pKernel, m_pPreviousKernel);
+    if (m_pKernel && m_pKernel->sampleRate() == sampleRate) {
+        pState->convolver.setKernel(m_pKernel);
+    } else {
+        // Silent until the kernel for the new sample rate is loaded
+        pState->convolver.setKernel(nullptr);
+    }
+
+    // Clear the convolver when turning it on to prevent replaying the old
+    // input from the last time the effect was enabled.
+    if (enableState == EffectEnableState::Enabling) {
+        pState->convolver.clear();
+    }
+
+    SampleUtil::copyWithRampingGain(pState->pSendBuffer, pInput,
+            pState->sendPrevious, sendCurrent,
+            bufferParameters.samplesPerBuffer());
+    pState->convolver.process(pState->pSendBuffer, pOutput,
+            bufferParameters.framesPerBuffer());
+    pState->framesSinceKernelChange = math_min(
+            pState->framesSinceKernelChange + bufferParameters.framesPerBuffer(),
+            kKernelRetireFrames);
+
+    // The ramping of the send parameter handles ramping when enabling, so
+    // this effect must handle ramping to dry when disabling itself (instead
+    // of being handled by EngineEffect::process).
+    if (enableState == EffectEnableState::Disabling) {
+        SampleUtil::applyRampingGain(pOutput, 1.0, 0.0, bufferParameters.samplesPerBuffer());
+        pState->sendPrevious = 0;
+    } else {
+        pState->sendPrevious = sendCurrent;
+    }
+}
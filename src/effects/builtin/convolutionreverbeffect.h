@@ -0,0 +1,73 @@
+#pragma once
+
+#include "effects/builtin/impulseresponseloader.h"
+#include "effects/effectprocessor.h"
+#include "engine/effects/engineeffect.h"
+#include "engine/effects/engineeffectparameter.h"
+#include "engine/filters/partitionedconvolution.h"
+#include "util/class.h"
+#include "util/defs.h"
+#include "util/sample.h"
+#include "util/types.h"
+
+class ConvolutionReverbGroupState : public EffectState {
+  public:
+    ConvolutionReverbGroupState(const mixxx::EngineParameters& bufferParameters)
+            : EffectState(bufferParameters),
+              sendPrevious(0),
+              pSendBuffer(SampleUtil::alloc(MAX_BUFFER_LEN)),
+              kernelChanges(0),
+              framesSinceKernelChange(0) {
+    }
+    ~ConvolutionReverbGroupState() override {
+        SampleUtil::free(pSendBuffer);
+    }
+
+    CSAMPLE_GAIN sendPrevious;
+    CSAMPLE* pSendBuffer;
+    PartitionedConvolver convolver;
+    // The kernel changes of the effect that this state has seen and the
+    // frames it has processed since the last one
+    quint64 kernelChanges;
+    SINT framesSinceKernelChange;
+};
+
+// Convolves the signal with a recorded or synthesized impulse response.
+// The impulse responses are prepared by an ImpulseResponseLoader and a
+// newly selected one is crossfaded in.
+class ConvolutionReverbEffect : public EffectProcessorImpl<ConvolutionReverbGroupState> {
+  public:
+    ConvolutionReverbEffect(EngineEffect* pEffect);
+    virtual ~ConvolutionReverbEffect();
+
+    static QString getId();
+    static EffectManifestPointer getManifest();
+
+    // See effectprocessor.h
+    void processChannel(const ChannelHandle& handle,
+                        ConvolutionReverbGroupState* pState,
+                        const CSAMPLE* pInput, CSAMPLE* pOutput,
+                        const mixxx::EngineParameters& bufferParameters,
+                        const EffectEnableState enableState,
+                        const GroupFeatureState& groupFeatures);
+
+  private:
+    QString debugString() const {
+        return getId();
+    }
+
+    // Picks up a newly loaded kernel and retires the one before the
+    // current one, once no state can be fading it out anymore
+    void updateKernels(ConvolutionReverbGroupState* pState, SINT sampleRate);
+
+    EngineEffectParameter* m_pImpulseParameter;
+    EngineEffectParameter* m_pSendParameter;
+
+    ImpulseResponseLoader m_loader;
+    PartitionedConvolutionKernel* m_pKernel;
+    PartitionedConvolutionKernel* m_pPreviousKernel;
+    // Counts the kernels that have been picked up
+    quint64 m_kernelChanges;
+
+    DISALLOW_COPY_AND_ASSIGN(ConvolutionReverbEffect);
+};
@@ -8,18 +8,6 @@
 
 constexpr int EchoGroupState::kMaxDelaySeconds;
 
-namespace {
-
-void incrementRing(int* pIndex, int increment, int length) {
-    *pIndex = (*pIndex + increment) % length;
-}
-
-void decrementRing(int* pIndex, int decrement, int length) {
-    *pIndex = (*pIndex + length - decrement) % length;
-}
-
-} // anonymous namespace
-
 // static
 QString EchoEffect::getId() {
     return "org.mixxx.effects.echo";
@@ -170,15 +158,19 @@ void EchoEffect::processChannel(const ChannelHandle& handle, EchoGroupState* pGr
         delay_frames = 1;
     }
 
-    int delay_samples = delay_frames * bufferParameters.channelCount();
-    VERIFY_OR_DEBUG_ASSERT(delay_samples <= gs.delay_buf.size()) {
-        delay_samples = gs.delay_buf.size();
+    VERIFY_OR_DEBUG_ASSERT(delay_frames <= gs.delay_line.capacity()) {
+        delay_frames = gs.delay_line.capacity();
     }
+    int delay_samples = delay_frames * bufferParameters.channelCount();
 
-    int prev_read_position = gs.write_position;
-    decrementRing(&prev_read_position, gs.prev_delay_samples, gs.delay_buf.size());
-    int read_position = gs.write_position;
-    decrementRing(&read_position, delay_samples, gs.delay_buf.size());
+    // Fade from the previous delay to the current one across the buffer.
+    // The frame read before writing with a delay of d frames has age d - 1.
+    // After clear() there is no previous delay, so the echo fades in from
+    // the oldest frame of the cleared buffer, which is silent.
+    const SINT read_age = delay_frames - 1;
+    const SINT prev_read_age = gs.prev_delay_frames > 0
+            ? gs.prev_delay_frames - 1
+            : gs.delay_line.capacity() - 1;
 
     RampingValue<CSAMPLE_GAIN> send(send_current, gs.prev_send,
                                     bufferParameters.framesPerBuffer());
@@ -194,28 +186,27 @@ void EchoEffect::processChannel(const ChannelHandle& handle, EchoGroupState* pGr
         CSAMPLE_GAIN send_ramped = send.getNext();
         CSAMPLE_GAIN feedback_ramped = feedback.getNext();
 
-        CSAMPLE bufferedSampleLeft = gs.delay_buf[read_position];
-        CSAMPLE bufferedSampleRight = gs.delay_buf[read_position + 1];
-        if (read_position != prev_read_position) {
+        const CSAMPLE* pBufferedFrame = gs.delay_line.frame(read_age);
+        CSAMPLE bufferedSampleLeft = pBufferedFrame[0];
+        CSAMPLE bufferedSampleRight = pBufferedFrame[1];
+        if (read_age != prev_read_age) {
+            const CSAMPLE* pPrevBufferedFrame = gs.delay_line.frame(prev_read_age);
             double frac = static_cast<double>(i)
                 / bufferParameters.samplesPerBuffer();
             bufferedSampleLeft *= frac;
             bufferedSampleRight *= frac;
-            bufferedSampleLeft += gs.delay_buf[prev_read_position] * (1 - frac);
-            bufferedSampleRight += gs.delay_buf[prev_read_position + 1] * (1 - frac);
-            incrementRing(&prev_read_position, bufferParameters.channelCount(),
-                    gs.delay_buf.size());
+            bufferedSampleLeft += pPrevBufferedFrame[0] * (1 - frac);
+            bufferedSampleRight += pPrevBufferedFrame[1] * (1 - frac);
         }
-        incrementRing(&read_position, bufferParameters.channelCount(),
-                gs.delay_buf.size());
 
         // Actual delays distort and saturate, so clamp the buffer here.
-        gs.delay_buf[gs.write_position] = SampleUtil::clampSample(
-                pInput[i] * send_ramped +
-                bufferedSampleLeft * feedback_ramped);
-        gs.delay_buf[gs.write_position + 1] = SampleUtil::clampSample(
-                pInput[i + 1] * send_ramped +
-                bufferedSampleLeft * feedback_ramped);
+        const CSAMPLE writtenFrame[] = {
+                SampleUtil::clampSample(
+                        pInput[i] * send_ramped +
+                        bufferedSampleLeft * feedback_ramped),
+                SampleUtil::clampSample(
+                        pInput[i + 1] * send_ramped +
+                        bufferedSampleLeft * feedback_ramped)};
 
         // Pingpong the output.  If the pingpong value is zero, all of the
         // math below should result in a simple copy of delay buf to pOutput.
@@ -235,8 +226,7 @@ void EchoEffect::processChannel(const ChannelHandle& handle, EchoGroupState* pGr
                              (1 + pingpong_frac);
         }
 
-        incrementRing(&gs.write_position, bufferParameters.channelCount(),
-                gs.delay_buf.size());
+        gs.delay_line.writeFrame(writtenFrame);
 
         ++gs.ping_pong;
         if (gs.ping_pong >= delay_samples) {
@@ -249,12 +239,12 @@ void EchoEffect::processChannel(const ChannelHandle& handle, EchoGroupState* pGr
     // of being handled by EngineEffect::process).
     if (enableState == EffectEnableState::Disabling) {
         SampleUtil::applyRampingGain(pOutput, 1.0, 0.0, bufferParameters.samplesPerBuffer());
-        gs.delay_buf.clear();
+        gs.delay_line.clear();
         gs.prev_send = 0;
     } else {
         gs.prev_send = send_current;
     }
 
     gs.prev_feedback = feedback_current;
-    gs.prev_delay_samples = delay_samples;
+    gs.prev_delay_frames = delay_frames;
 }
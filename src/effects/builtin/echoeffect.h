@@ -9,8 +9,8 @@
 #include "engine/effects/engineeffectparameter.h"
 #include "util/class.h"
 #include "util/defs.h"
+#include "util/delayline.h"
 #include "util/sample.h"
-#include "util/samplebuffer.h"
 
 class EchoGroupState : public EffectState {
   public:
@@ -25,24 +25,21 @@ class EchoGroupState : public EffectState {
     }
 
     void audioParametersChanged(const mixxx::EngineParameters bufferParameters) {
-        delay_buf = mixxx::SampleBuffer(kMaxDelaySeconds
-                * bufferParameters.sampleRate() * bufferParameters.channelCount());
+        delay_line.resize(kMaxDelaySeconds * bufferParameters.sampleRate());
     };
 
     void clear() {
-        delay_buf.clear();
+        delay_line.clear();
         prev_send = 0.0f;
         prev_feedback= 0.0f;
-        prev_delay_samples = 0;
-        write_position = 0;
+        prev_delay_frames = 0;
         ping_pong = 0;
     };
 
-    mixxx::SampleBuffer delay_buf;
+    mixxx::DelayLine<CSAMPLE, mixxx::kEngineChannelCount> delay_line;
     CSAMPLE_GAIN prev_send;
     CSAMPLE_GAIN prev_feedback;
-    int prev_delay_samples;
-    int write_position;
+    int prev_delay_frames;
     int ping_pong;
 };
 
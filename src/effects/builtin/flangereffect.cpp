@@ -191,9 +191,6 @@ void FlangerEffect::processChannel(const ChannelHandle& handle,
             pState->prev_manual, manual, bufferParameters.framesPerBuffer());
     pState->prev_manual = manual;
 
-    CSAMPLE* delayLeft = pState->delayLeft;
-    CSAMPLE* delayRight = pState->delayRight;
-
    for (unsigned int i = 0;
           i < bufferParameters.samplesPerBuffer();
           i += bufferParameters.channelCount()) {
@@ -212,24 +209,16 @@ void FlangerEffect::processChannel(const ChannelHandle& handle,
         double delayMs = manual_ramped + width_ramped / 2 * sin(M_PI * 2.0f * periodFraction);
         double delayFrames = delayMs * bufferParameters.sampleRate() / 1000;
 
-        SINT framePrev = (pState->delayPos - static_cast<SINT>(floor(delayFrames))
-                + kBufferLenth) % kBufferLenth;
-        SINT frameNext = (pState->delayPos - static_cast<SINT>(ceil(delayFrames))
-                + kBufferLenth) % kBufferLenth;
-        CSAMPLE prevLeft = delayLeft[framePrev];
-        CSAMPLE nextLeft = delayLeft[frameNext];
-
-        CSAMPLE prevRight = delayRight[framePrev];
-        CSAMPLE nextRight = delayRight[frameNext];
-
-        CSAMPLE frac = delayFrames - floorf(delayFrames);
-        CSAMPLE delayedSampleLeft = prevLeft + frac * (nextLeft - prevLeft);
-        CSAMPLE delayedSampleRight = prevRight + frac * (nextRight - prevRight);
-
-        delayLeft[pState->delayPos] = tanh_approx(pInput[i] + regen_ramped * delayedSampleLeft);
-        delayRight[pState->delayPos] = tanh_approx(pInput[i + 1] + regen_ramped * delayedSampleRight);
+        // The frame read before writing with a delay of d frames has age d - 1
+        CSAMPLE delayedFrame[mixxx::kEngineChannelCount];
+        pState->delayLine.readInterpolated(delayedFrame, delayFrames - 1);
+        CSAMPLE delayedSampleLeft = delayedFrame[0];
+        CSAMPLE delayedSampleRight = delayedFrame[1];
 
-        pState->delayPos = (pState->delayPos + 1) % kBufferLenth;
+        const CSAMPLE writtenFrame[] = {
+                tanh_approx(pInput[i] + regen_ramped * delayedSampleLeft),
+                tanh_approx(pInput[i + 1] + regen_ramped * delayedSampleRight)};
+        pState->delayLine.writeFrame(writtenFrame);
 
         double gain = (1 - mix_ramped + kGainCorrection * mix_ramped);
         pOutput[i] = (pInput[i] + mix_ramped * delayedSampleLeft) / gain;
@@ -237,8 +226,7 @@ void FlangerEffect::processChannel(const ChannelHandle& handle,
     }
 
     if (enableState == EffectEnableState::Disabling) {
-        SampleUtil::clear(delayLeft, kBufferLenth);
-        SampleUtil::clear(delayRight, kBufferLenth);
+        pState->delayLine.clear();
         pState->previousPeriodFrames = -1;
         pState->prev_regen = 0;
         pState->prev_mix = 0;
@@ -4,10 +4,12 @@
 #include <QMap>
 
 #include "effects/effectprocessor.h"
+#include "engine/engine.h"
 #include "engine/effects/engineeffect.h"
 #include "engine/effects/engineeffectparameter.h"
 #include "util/class.h"
 #include "util/defs.h"
+#include "util/delayline.h"
 #include "util/sample.h"
 #include "util/types.h"
 #include "util/rampingvalue.h"
@@ -26,19 +28,15 @@ constexpr double kMaxLfoBeats = 32.0;
 struct FlangerGroupState : public EffectState {
     FlangerGroupState(const mixxx::EngineParameters& bufferParameters)
             : EffectState(bufferParameters),
-              delayPos(0),
+              delayLine(kBufferLenth),
               lfoFrames(0),
               previousPeriodFrames(-1),
               prev_regen(0),
               prev_mix(0),
               prev_width(0),
               prev_manual(kCenterDelayMs) {
-        SampleUtil::clear(delayLeft, kBufferLenth);
-        SampleUtil::clear(delayRight, kBufferLenth);
     }
-    CSAMPLE delayLeft[kBufferLenth];
-    CSAMPLE delayRight[kBufferLenth];
-    unsigned int delayPos;
+    mixxx::DelayLine<CSAMPLE, mixxx::kEngineChannelCount> delayLine;
     unsigned int lfoFrames;
     double previousPeriodFrames;
     CSAMPLE_GAIN prev_regen;
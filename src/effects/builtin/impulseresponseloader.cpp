@@ -0,0 +1,288 @@
+#include "effects/builtin/impulseresponseloader.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QtDebug>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "engine/filters/partitionedconvolution.h"
+#include "sources/audiosourcestereoproxy.h"
+#include "sources/soundsourceproxy.h"
+#include "util/assert.h"
+#include "util/cmdlineargs.h"
+#include "util/math.h"
+#include "util/samplebuffer.h"
+
+namespace {
+
+constexpr SINT kChannelCount = PartitionedConvolutionKernel::kChannelCount;
+
+// Only a few kernels are retired between two wake-ups of the loader
+constexpr int kRetiredKernelCapacity = 16;
+
+// Truncated impulse responses are faded out over this many frames
+constexpr SINT kTruncationFadeFrames = 8 * PartitionedConvolutionKernel::kLongBlockFrames;
+
+struct SynthesizedImpulseResponse {
+    const char* name;
+    // The time for decaying by 60 dB
+    double decaySeconds;
+    double cutoffHertz;
+};
+
+const SynthesizedImpulseResponse kSynthesizedImpulseResponses[] = {
+        {QT_TRANSLATE_NOOP("ImpulseResponseLoader", "Room"), 0.8, 7000},
+        {QT_TRANSLATE_NOOP("ImpulseResponseLoader", "Hall"), 2.0, 4000},
+};
+
+constexpr int kSynthesizedImpulseResponseCount =
+        sizeof(kSynthesizedImpulseResponses) / sizeof(kSynthesizedImpulseResponses[0]);
+
+constexpr double kPredelaySeconds = 0.01;
+
+const QStringList& impulseResponseFiles() {
+    static const QStringList s_files = [] {
+        QStringList files;
+        const QDir directory(QDir(CmdlineArgs::Instance().getSettingsPath())
+                                     .filePath("impulse_responses"));
+        const QFileInfoList fileInfos = directory.entryInfoList(
+                SoundSourceProxy::getSupportedFileNamePatterns(),
+                QDir::Files | QDir::Readable,
+                QDir::Name | QDir::IgnoreCase);
+        for (const auto& fileInfo : fileInfos) {
+            files.append(fileInfo.absoluteFilePath());
+        }
+        return files;
+    }();
+    return s_files;
+}
+
+// Exponentially decaying, low pass filtered noise that is decorrelated
+// between the channels
+std::vector<CSAMPLE> synthesizeImpulseResponse(
+        const SynthesizedImpulseResponse& response, SINT sampleRate) {
+    const SINT predelayFrames = static_cast<SINT>(kPredelaySeconds * sampleRate);
+    const SINT frames = predelayFrames +
+            static_cast<SINT>(response.decaySeconds * sampleRate);
+    std::vector<CSAMPLE> samples(kChannelCount * frames, 0);
+    const double decay = std::exp(-std::log(1000.0) / (response.decaySeconds * sampleRate));
+    const double smoothing = 1.0 - std::exp(-2 * M_PI * response.cutoffHertz / sampleRate);
+    for (SINT channel = 0; channel < kChannelCount; ++channel) {
+        std::mt19937 generator(static_cast<unsigned int>(channel + 1));
+        std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+        double envelope = 1.0;
+        double filtered = 0.0;
+        for (SINT frame = predelayFrames; frame < frames; ++frame) {
+            filtered += smoothing * (distribution(generator) - filtered);
+            samples[kChannelCount * frame + channel] =
+                    static_cast<CSAMPLE>(filtered * envelope);
+            envelope *= decay;
+        }
+    }
+    return samples;
+}
+
+// The impulse response is only read up to the frames that fit into a
+// kernel. Linear interpolation is sufficient for a reverb tail.
+std::vector<CSAMPLE> readImpulseResponse(
+        const QString& fileName, SINT sampleRate) {
+    mixxx::AudioSource::OpenParams config;
+    config.setChannelCount(mixxx::audio::ChannelCount(kChannelCount));
+    auto pAudioSource = SoundSourceProxy(
+            SoundSourceProxy::importTemporaryTrack(TrackFile(fileName)))
+                                .openAudioSource(config);
+    if (!pAudioSource) {
+        qWarning() << "Failed to open impulse response" << fileName;
+        return std::vector<CSAMPLE>();
+    }
+
+    const double ratio = static_cast<double>(
+                                 pAudioSource->getSignalInfo().getSampleRate()) /
+            sampleRate;
+    const auto readRange = intersect(
+            pAudioSource->frameIndexRange(),
+            mixxx::IndexRange::forward(
+                    pAudioSource->frameIndexMin(),
+                    static_cast<SINT>(std::ceil(
+                            PartitionedConvolutionKernel::kMaxFrames * ratio)) +
+                            1));
+    mixxx::AudioSourceStereoProxy audioSourceProxy(
+            pAudioSource,
+            readRange.length());
+    mixxx::SampleBuffer sampleBuffer(kChannelCount * readRange.length());
+    const auto readableSampleFrames =
+            audioSourceProxy.readSampleFrames(
+                    mixxx::WritableSampleFrames(
+                            readRange,
+                            mixxx::SampleBuffer::WritableSlice(sampleBuffer)));
+    const SINT readFrames = readableSampleFrames.frameLength();
+    if (readFrames <= 0) {
+        qWarning() << "Failed to read impulse response" << fileName;
+        return std::vector<CSAMPLE>();
+    }
+
+    const CSAMPLE* pSamples = readableSampleFrames.readableData();
+    const SINT frames = static_cast<SINT>((readFrames - 1) / ratio) + 1;
+    std::vector<CSAMPLE> samples(kChannelCount * frames);
+    for (SINT frame = 0; frame < frames; ++frame) {
+        const double position = frame * ratio;
+        const SINT index = math_min(static_cast<SINT>(position), readFrames - 1);
+        const SINT nextIndex = math_min(index + 1, readFrames - 1);
+        const CSAMPLE fraction = static_cast<CSAMPLE>(position - index);
+        for (SINT channel = 0; channel < kChannelCount; ++channel) {
+            const CSAMPLE sample = pSamples[kChannelCount * index + channel];
+            const CSAMPLE nextSample = pSamples[kChannelCount * nextIndex + channel];
+            samples[kChannelCount * frame + channel] =
+                    sample + (nextSample - sample) * fraction;
+        }
+    }
+    return samples;
+}
+
+// Truncates the impulse response to the maximum length of a kernel and
+// normalizes it to unity gain for white noise.
+bool conditionImpulseResponse(std::vector<CSAMPLE>* pSamples) {
+    const SINT frames = static_cast<SINT>(pSamples->size()) / kChannelCount;
+    if (frames > PartitionedConvolutionKernel::kMaxFrames) {
+        pSamples->resize(kChannelCount * PartitionedConvolutionKernel::kMaxFrames);
+        const SINT fadeStart = PartitionedConvolutionKernel::kMaxFrames - kTruncationFadeFrames;
+        for (SINT frame = fadeStart; frame < PartitionedConvolutionKernel::kMaxFrames; ++frame) {
+            const CSAMPLE gain = static_cast<CSAMPLE>(
+                    PartitionedConvolutionKernel::kMaxFrames - frame) /
+                    kTruncationFadeFrames;
+            for (SINT channel = 0; channel < kChannelCount; ++channel) {
+                (*pSamples)[kChannelCount * frame + channel] *= gain;
+            }
+        }
+    }
+
+    double energy = 0;
+    for (const CSAMPLE sample : *pSamples) {
+        energy += static_cast<double>(sample) * sample;
+    }
+    energy /= kChannelCount;
+    if (energy <= 0) {
+        return false;
+    }
+    const CSAMPLE gain = static_cast<CSAMPLE>(1.0 / std::sqrt(energy));
+    for (CSAMPLE& sample : *pSamples) {
+        sample *= gain;
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+// static
+QStringList ImpulseResponseLoader::impulseResponseNames() {
+    QStringList names;
+    for (const auto& response : kSynthesizedImpulseResponses) {
+        names.append(tr(response.name));
+    }
+    for (const auto& fileName : impulseResponseFiles()) {
+        names.append(QFileInfo(fileName).completeBaseName());
+    }
+    return names;
+}
+
+ImpulseResponseLoader::ImpulseResponseLoader()
+        : m_stop(false),
+          m_lastRequest(-1),
+          m_request(-1),
+          m_pLoadedKernel(nullptr),
+          m_retiredKernels(kRetiredKernelCapacity) {
+}
+
+ImpulseResponseLoader::~ImpulseResponseLoader() {
+    m_stop = true;
+    m_semaRun.release();
+    wait();
+    deleteRetiredKernels();
+    delete m_pLoadedKernel.exchange(nullptr);
+}
+
+void ImpulseResponseLoader::requestKernel(int index, SINT sampleRate) {
+    const qint64 request = packRequest(index, sampleRate);
+    if (request == m_lastRequest) {
+        return;
+    }
+    m_lastRequest = request;
+    m_request.store(request);
+    m_semaRun.release();
+}
+
+PartitionedConvolutionKernel* ImpulseResponseLoader::takeKernel() {
+    if (!m_pLoadedKernel.load(std::memory_order_relaxed)) {
+        return nullptr;
+    }
+    return m_pLoadedKernel.exchange(nullptr);
+}
+
+void ImpulseResponseLoader::retireKernel(PartitionedConvolutionKernel* pKernel) {
+    if (!pKernel) {
+        return;
+    }
+    // The loader deletes the retired kernels before loading another one,
+    // so the capacity is never exceeded.
+    const int written = m_retiredKernels.write(&pKernel, 1);
+    DEBUG_ASSERT(written == 1);
+    Q_UNUSED(written);
+    m_semaRun.release();
+}
+
+void ImpulseResponseLoader::run() {
+    QThread::currentThread()->setObjectName("ImpulseResponseLoader");
+
+    qint64 loadedRequest = -1;
+    while (!m_stop.load()) {
+        m_semaRun.acquire();
+        deleteRetiredKernels();
+        if (m_stop.load()) {
+            break;
+        }
+        const qint64 request = m_request.load();
+        if (request == loadedRequest) {
+            continue;
+        }
+        loadedRequest = request;
+        PartitionedConvolutionKernel* pKernel = loadKernel(
+                static_cast<int>(request >> 32),
+                static_cast<SINT>(request & 0xffffffff));
+        if (pKernel) {
+            // Replaces a kernel that has never been taken
+            delete m_pLoadedKernel.exchange(pKernel);
+        }
+    }
+}
+
+void ImpulseResponseLoader::deleteRetiredKernels() {
+    PartitionedConvolutionKernel* pKernel;
+    while (m_retiredKernels.read(&pKernel, 1) == 1) {
+        delete pKernel;
+    }
+}
+
+PartitionedConvolutionKernel* ImpulseResponseLoader::loadKernel(
+        int index, SINT sampleRate) {
+    if (index < 0 || sampleRate <= 0) {
+        return nullptr;
+    }
+    std::vector<CSAMPLE> samples;
+    if (index < kSynthesizedImpulseResponseCount) {
+        samples = synthesizeImpulseResponse(
+                kSynthesizedImpulseResponses[index], sampleRate);
+    } else if (index - kSynthesizedImpulseResponseCount < impulseResponseFiles().size()) {
+        samples = readImpulseResponse(
+                impulseResponseFiles().at(index - kSynthesizedImpulseResponseCount),
+                sampleRate);
+    }
+    if (!conditionImpulseResponse(&samples)) {
+        return nullptr;
+    }
+    return new PartitionedConvolutionKernel(samples.data(),
+            static_cast<SINT>(samples.size()) / kChannelCount,
+            sampleRate);
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <QSemaphore>
+#include <QStringList>
+#include <QThread>
+
+#include <atomic>
+
+#include "util/class.h"
+#include "util/fifo.h"
+#include "util/types.h"
+
+class PartitionedConvolutionKernel;
+
+// Prepares the impulse responses of ConvolutionReverbEffect off the engine
+// thread. The engine thread requests a kernel, picks it up when it is
+// ready and hands the kernels that are no longer used back for deletion,
+// all without locking.
+class ImpulseResponseLoader : public QThread {
+    Q_OBJECT
+  public:
+    // The synthesized impulse responses come first, followed by the
+    // audio files in the impulse_responses directory of the settings
+    // directory. The directory is only scanned once.
+    static QStringList impulseResponseNames();
+
+    ImpulseResponseLoader();
+    ~ImpulseResponseLoader() override;
+
+    // Engine thread. Repeating the previous request does nothing.
+    void requestKernel(int index, SINT sampleRate);
+    // Engine thread. Returns each loaded kernel once, or null if the
+    // requested one is not ready yet. The caller takes ownership.
+    PartitionedConvolutionKernel* takeKernel();
+    // Engine thread. The kernel is deleted by the loader.
+    void retireKernel(PartitionedConvolutionKernel* pKernel);
+
+  protected:
+    void run() override;
+
+  private:
+    static qint64 packRequest(int index, SINT sampleRate) {
+        return (static_cast<qint64>(index) << 32) | sampleRate;
+    }
+
+    void deleteRetiredKernels();
+    // Returns null if the impulse response can't be read
+    PartitionedConvolutionKernel* loadKernel(int index, SINT sampleRate);
+
+    std::atomic<bool> m_stop;
+    QSemaphore m_semaRun;
+
+    // Only accessed by the engine thread
+    qint64 m_lastRequest;
+    std::atomic<qint64> m_request;
+    std::atomic<PartitionedConvolutionKernel*> m_pLoadedKernel;
+    FIFO<PartitionedConvolutionKernel*> m_retiredKernels;
+
+    DISALLOW_COPY_AND_ASSIGN(ImpulseResponseLoader);
+};
@@ -36,7 +36,8 @@ LinkwitzRiley8EQEffectGroupState::LinkwitzRiley8EQEffectGroupState(
           old_high(1.0),
           m_oldSampleRate(kStartupSamplerate),
           m_loFreq(kStartupLoFreq),
-          m_hiFreq(kStartupHiFreq) {
+          m_hiFreq(kStartupHiFreq),
+          m_pBatchedInput(nullptr) {
 
     m_pLowBuf = SampleUtil::alloc(MAX_BUFFER_LEN);
     m_pMidBuf = SampleUtil::alloc(MAX_BUFFER_LEN);
@@ -102,18 +103,16 @@ void LinkwitzRiley8EQEffect::processChannel(const ChannelHandle& handle,
         fHigh = m_pPotHigh->value();
     }
 
-    if (pState->m_oldSampleRate != bufferParameters.sampleRate() ||
-            (pState->m_loFreq != static_cast<int>(m_pLoFreqCorner->get())) ||
-            (pState->m_hiFreq != static_cast<int>(m_pHiFreqCorner->get()))) {
-        pState->m_loFreq = static_cast<int>(m_pLoFreqCorner->get());
-        pState->m_hiFreq = static_cast<int>(m_pHiFreqCorner->get());
-        pState->m_oldSampleRate = bufferParameters.sampleRate();
-        pState->setFilters(bufferParameters.sampleRate(), pState->m_loFreq, pState->m_hiFreq);
+    if (pState->m_pBatchedInput) {
+        // The first runs have been done in the batch of prepareChannelBatch()
+        DEBUG_ASSERT(pState->m_pBatchedInput == pInput);
+        pState->m_pBatchedInput = nullptr;
+    } else {
+        updateFilters(pState, bufferParameters);
+        pState->m_high2->process(pInput, pState->m_pHighBuf, bufferParameters.samplesPerBuffer()); // HighPass first run
+        pState->m_low2->process(pInput, pState->m_pLowBuf, bufferParameters.samplesPerBuffer()); // LowPass first run for low and bandpass
     }
 
-    pState->m_high2->process(pInput, pState->m_pHighBuf, bufferParameters.samplesPerBuffer()); // HighPass first run
-    pState->m_low2->process(pInput, pState->m_pLowBuf, bufferParameters.samplesPerBuffer()); // LowPass first run for low and bandpass
-
     if (fMid != pState->old_mid || fHigh != pState->old_high) {
         SampleUtil::applyRampingGain(pState->m_pHighBuf,
                                      pState->old_high, fHigh,
@@ -159,3 +158,33 @@ void LinkwitzRiley8EQEffect::processChannel(const ChannelHandle& handle,
         pState->old_high = fHigh;
     }
 }
+
+void LinkwitzRiley8EQEffect::prepareChannelBatch(const ChannelHandle& handle,
+                                                 LinkwitzRiley8EQEffectGroupState* pState,
+                                                 const CSAMPLE* pInput,
+                                                 const mixxx::EngineParameters& bufferParameters,
+                                                 EngineFilterIIRBatch* pBatch) {
+    Q_UNUSED(handle);
+
+    updateFilters(pState, bufferParameters);
+    // The first runs do not depend on the gains
+    if (!pBatch->add(pState->m_high2, pInput, pState->m_pHighBuf)) {
+        pState->m_high2->process(pInput, pState->m_pHighBuf, bufferParameters.samplesPerBuffer());
+    }
+    if (!pBatch->add(pState->m_low2, pInput, pState->m_pLowBuf)) {
+        pState->m_low2->process(pInput, pState->m_pLowBuf, bufferParameters.samplesPerBuffer());
+    }
+    pState->m_pBatchedInput = pInput;
+}
+
+void LinkwitzRiley8EQEffect::updateFilters(LinkwitzRiley8EQEffectGroupState* pState,
+                                           const mixxx::EngineParameters& bufferParameters) {
+    if (pState->m_oldSampleRate != bufferParameters.sampleRate() ||
+            (pState->m_loFreq != static_cast<int>(m_pLoFreqCorner->get())) ||
+            (pState->m_hiFreq != static_cast<int>(m_pHiFreqCorner->get()))) {
+        pState->m_loFreq = static_cast<int>(m_pLoFreqCorner->get());
+        pState->m_hiFreq = static_cast<int>(m_pHiFreqCorner->get());
+        pState->m_oldSampleRate = bufferParameters.sampleRate();
+        pState->setFilters(bufferParameters.sampleRate(), pState->m_loFreq, pState->m_hiFreq);
+    }
+}
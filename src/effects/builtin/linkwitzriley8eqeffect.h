@@ -8,6 +8,7 @@
 #include "effects/effectprocessor.h"
 #include "engine/effects/engineeffect.h"
 #include "engine/effects/engineeffectparameter.h"
+#include "engine/filters/enginefilteriirbatch.h"
 #include "engine/filters/enginefilterlinkwitzriley8.h"
 #include "util/class.h"
 #include "util/defs.h"
@@ -37,6 +38,10 @@ class LinkwitzRiley8EQEffectGroupState : public EffectState {
     unsigned int m_oldSampleRate;
     int m_loFreq;
     int m_hiFreq;
+
+    // The input of the last prepareChannelBatch(), which ran the first
+    // filters, until processChannel()
+    const CSAMPLE* m_pBatchedInput;
 };
 
 class LinkwitzRiley8EQEffect : public EffectProcessorImpl<LinkwitzRiley8EQEffectGroupState> {
@@ -55,11 +60,21 @@ class LinkwitzRiley8EQEffect : public EffectProcessorImpl<LinkwitzRiley8EQEffect
                         const EffectEnableState enableState,
                         const GroupFeatureState& groupFeatureState);
 
+    // See effectprocessor.h
+    void prepareChannelBatch(const ChannelHandle& handle,
+                             LinkwitzRiley8EQEffectGroupState* pState,
+                             const CSAMPLE* pInput,
+                             const mixxx::EngineParameters& bufferParameters,
+                             EngineFilterIIRBatch* pBatch);
+
   private:
     QString debugString() const {
         return getId();
     }
 
+    void updateFilters(LinkwitzRiley8EQEffectGroupState* pState,
+                       const mixxx::EngineParameters& bufferParameters);
+
     EngineEffectParameter* m_pPotLow;
     EngineEffectParameter* m_pPotMid;
     EngineEffectParameter* m_pPotHigh;
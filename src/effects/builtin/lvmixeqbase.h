@@ -3,6 +3,8 @@
 
 #include "effects/effectprocessor.h"
 #include "engine/filters/enginefilterdelay.h"
+#include "engine/filters/enginefilteriirbatch.h"
+#include "util/assert.h"
 #include "util/defs.h"
 #include "util/math.h"
 #include "util/sample.h"
@@ -25,7 +27,8 @@ class LVMixEQEffectGroupState : public EffectState {
           m_rampHoldOff(kRampDone),
           m_oldSampleRate(bufferParameters.sampleRate()),
           m_loFreq(kStartupLoFreq),
-          m_hiFreq(kStartupHiFreq) {
+          m_hiFreq(kStartupHiFreq),
+          m_pBatchedInput(nullptr) {
         m_pLowBuf = SampleUtil::alloc(bufferParameters.samplesPerBuffer());
         m_pBandBuf = SampleUtil::alloc(bufferParameters.samplesPerBuffer());
         m_pHighBuf = SampleUtil::alloc(bufferParameters.samplesPerBuffer());
@@ -58,20 +61,25 @@ class LVMixEQEffectGroupState : public EffectState {
         m_groupDelay = delayLow1 * 2;
     }
 
+    // Adds the filters of this buffer to pBatch, so that the following
+    // processChannel() with the same input and gains only mixes the bands.
+    // It keeps the corner frequencies of this call.
+    void prepareBatch(const CSAMPLE* pInput,
+                      const int numSamples,
+                      const unsigned int sampleRate,
+                      double fLow, double fMid, double fHigh,
+                      double loFreq, double hiFreq,
+                      EngineFilterIIRBatch* pBatch) {
+        updateFilters(sampleRate, loFreq, hiFreq);
+        filterBands(pInput, numSamples, fLow - fMid, fMid - fHigh, fHigh, pBatch);
+        m_pBatchedInput = pInput;
+    }
+
     void processChannel(const CSAMPLE* pInput, CSAMPLE* pOutput,
                         const int numSamples,
                         const unsigned int sampleRate,
                         double fLow, double fMid, double fHigh,
                         double loFreq, double hiFreq) {
-        if (m_oldSampleRate != sampleRate ||
-                (m_loFreq != loFreq) ||
-                (m_hiFreq != hiFreq)) {
-            m_loFreq = loFreq;
-            m_hiFreq = hiFreq;
-            m_oldSampleRate = sampleRate;
-            setFilters(sampleRate, loFreq, hiFreq);
-        }
-
         // Since a Bessel Low pass Filter has a constant group delay in the pass band,
         // we can subtract or add the filtered signal to the dry signal if we compensate this delay
         // The dry signal represents the high gain
@@ -79,21 +87,13 @@ class LVMixEQEffectGroupState : public EffectState {
         fLow = fLow - fMid;
         fMid = fMid - fHigh;
 
-        // Note: We do not call pauseFilter() here because this will introduce a
-        // buffer size-dependent start delay. During such start delay some unwanted
-        // frequencies are slipping though or wanted frequencies are damped.
-        // We know the exact group delay here so we can just hold off the ramping.
-        if (fHigh || m_oldHigh) {
-            m_delay3->process(pInput, m_pHighBuf, numSamples);
-        }
-
-        if (fMid || m_oldMid) {
-            m_delay2->process(pInput, m_pBandBuf, numSamples);
-            m_low2->process(m_pBandBuf, m_pBandBuf, numSamples);
-        }
-
-        if (fLow || m_oldLow) {
-            m_low1->process(pInput, m_pLowBuf, numSamples);
+        if (m_pBatchedInput) {
+            // The bands have been filtered in the batch of prepareBatch()
+            DEBUG_ASSERT(m_pBatchedInput == pInput);
+            m_pBatchedInput = nullptr;
+        } else {
+            updateFilters(sampleRate, loFreq, hiFreq);
+            filterBands(pInput, numSamples, fLow, fMid, fHigh, nullptr);
         }
 
         // Test code for comparing streams as two stereo channels
@@ -236,6 +236,44 @@ class LVMixEQEffectGroupState : public EffectState {
 */
 
   private:
+    void updateFilters(const unsigned int sampleRate, double loFreq, double hiFreq) {
+        if (m_oldSampleRate != sampleRate ||
+                (m_loFreq != loFreq) ||
+                (m_hiFreq != hiFreq)) {
+            m_loFreq = loFreq;
+            m_hiFreq = hiFreq;
+            m_oldSampleRate = sampleRate;
+            setFilters(sampleRate, loFreq, hiFreq);
+        }
+    }
+
+    // Fills the band buffers for the gains of processChannel(). The low pass
+    // filters run in pBatch if it is not null.
+    void filterBands(const CSAMPLE* pInput, const int numSamples,
+                     double fLow, double fMid, double fHigh,
+                     EngineFilterIIRBatch* pBatch) {
+        // Note: We do not call pauseFilter() here because this will introduce a
+        // buffer size-dependent start delay. During such start delay some unwanted
+        // frequencies are slipping though or wanted frequencies are damped.
+        // We know the exact group delay here so we can just hold off the ramping.
+        if (fHigh || m_oldHigh) {
+            m_delay3->process(pInput, m_pHighBuf, numSamples);
+        }
+
+        if (fMid || m_oldMid) {
+            m_delay2->process(pInput, m_pBandBuf, numSamples);
+            if (!pBatch || !pBatch->add(m_low2, m_pBandBuf, m_pBandBuf)) {
+                m_low2->process(m_pBandBuf, m_pBandBuf, numSamples);
+            }
+        }
+
+        if (fLow || m_oldLow) {
+            if (!pBatch || !pBatch->add(m_low1, pInput, m_pLowBuf)) {
+                m_low1->process(pInput, m_pLowBuf, numSamples);
+            }
+        }
+    }
+
     LPF* m_low1;
     LPF* m_low2;
     EngineFilterDelay<kMaxDelay>* m_delay2;
@@ -255,6 +293,9 @@ class LVMixEQEffectGroupState : public EffectState {
     CSAMPLE* m_pLowBuf;
     CSAMPLE* m_pBandBuf;
     CSAMPLE* m_pHighBuf;
+
+    // The input of the last prepareBatch() until processChannel()
+    const CSAMPLE* m_pBatchedInput;
 };
 
 #endif // BESSELLVMIXEQBASE_H
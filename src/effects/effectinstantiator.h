@@ -32,20 +32,30 @@ class LV2EffectProcessorInstantiator : public EffectInstantiator {
   public:
     LV2EffectProcessorInstantiator(const LilvPlugin* plugin,
                                    QList<int> audioPortIndices,
-                                   QList<int> controlPortIndices)
+                                   QList<int> controlPortIndices,
+                                   LV2HostFeatures* pHostFeatures,
+                                   const LilvState* pDefaultState,
+                                   LV2CpuMeter* pCpuMeter)
             : m_pPlugin(plugin),
               m_audioPortIndices(audioPortIndices),
-              m_controlPortIndices(controlPortIndices) { }
+              m_controlPortIndices(controlPortIndices),
+              m_pHostFeatures(pHostFeatures),
+              m_pDefaultState(pDefaultState),
+              m_pCpuMeter(pCpuMeter) { }
 
     EffectProcessor* instantiate(EngineEffect* pEngineEffect,
                                  EffectManifestPointer pManifest) {
         return new LV2EffectProcessor(pEngineEffect, pManifest, m_pPlugin,
-                                      m_audioPortIndices, m_controlPortIndices);
+                                      m_audioPortIndices, m_controlPortIndices,
+                                      m_pHostFeatures, m_pDefaultState, m_pCpuMeter);
     }
   private:
     const LilvPlugin* m_pPlugin;
     const QList<int> m_audioPortIndices;
     const QList<int> m_controlPortIndices;
+    LV2HostFeatures* m_pHostFeatures;
+    const LilvState* m_pDefaultState;
+    LV2CpuMeter* m_pCpuMeter;
 
 };
 #endif /* __LILV__ */
@@ -214,13 +214,12 @@ void EffectParameter::updateEngineState() {
     if (!pEngineEffect) {
         return;
     }
-    EffectsRequest* pRequest = new EffectsRequest();
-    pRequest->type = EffectsRequest::SET_PARAMETER_PARAMETERS;
-    pRequest->pTargetEffect = pEngineEffect;
-    pRequest->SetParameterParameters.iParameter = m_iParameterNumber;
-    pRequest->value = m_value;
-    pRequest->minimum = m_minimum;
-    pRequest->maximum = m_maximum;
-    pRequest->default_value = m_default;
-    m_pEffectsManager->writeRequest(pRequest);
+    EffectParameterUpdate update;
+    update.pEffect = pEngineEffect;
+    update.iParameter = m_iParameterNumber;
+    update.value = m_value;
+    update.minimum = m_minimum;
+    update.maximum = m_maximum;
+    update.default_value = m_default;
+    m_pEffectsManager->queueParameterUpdate(update);
 }
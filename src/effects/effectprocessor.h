@@ -6,16 +6,20 @@
 #include <QHash>
 #include <QDebug>
 #include <QPair>
+#include <memory>
 
+#include "util/fifo.h"
 #include "util/types.h"
 #include "engine/engine.h"
 #include "effects/defs.h"
+#include "effects/effectstatepool.h"
 #include "engine/effects/groupfeaturestate.h"
 #include "engine/effects/message.h"
 #include "engine/channelhandle.h"
 #include "effects/effectsmanager.h"
 
 class EngineEffect;
+class EngineFilterIIRBatch;
 
 // Effects are implemented as two separate classes, an EffectState subclass and
 // an EffectProcessorImpl subclass. Separating state from the DSP code allows
@@ -37,7 +41,9 @@ class EngineEffect;
 // enabled for a chain. Also, when a new effect is loaded to a chain,
 // EffectStates are only allocated for input signals that are enabled at that
 // time. This allows for scaling up to an arbitrary number of input signals
-// without wasting a lot of memory.
+// without wasting a lot of memory. The EffectStates of an EffectProcessorImpl
+// are kept together in an EffectStatePool, which is sized for all routings of
+// the registered channels when the effect is loaded.
 class EffectState {
   public:
     EffectState(const mixxx::EngineParameters& bufferParameters) {
@@ -82,6 +88,22 @@ class EffectProcessor {
                          const mixxx::EngineParameters& bufferParameters,
                          const EffectEnableState enableState,
                          const GroupFeatureState& groupFeatures) = 0;
+
+    // Called before process() for an enabled effect that is the first to
+    // process the channel, with the same input. Effects can add their
+    // filters to pBatch to run them together with those of other channels,
+    // and use the results in the following process().
+    virtual void prepareBatch(const ChannelHandle& inputHandle,
+                              const ChannelHandle& outputHandle,
+                              const CSAMPLE* pInput,
+                              const mixxx::EngineParameters& bufferParameters,
+                              EngineFilterIIRBatch* pBatch) {
+        Q_UNUSED(inputHandle);
+        Q_UNUSED(outputHandle);
+        Q_UNUSED(pInput);
+        Q_UNUSED(bufferParameters);
+        Q_UNUSED(pBatch);
+    }
 };
 
 // EffectProcessorImpl manages a separate EffectState for every routing of
@@ -112,13 +134,14 @@ class EffectProcessorImpl : public EffectProcessor {
                              << "for input ChannelHandle(" << inputChannelHandleNumber << ")"
                              << "and output ChannelHandle(" << outputChannelHandleNumber << ")";
                 }
-                delete pState;
+                destroySpecificState(pState);
                 outputChannelHandleNumber++;
             }
             outputsMap.clear();
             inputChannelHandleNumber++;
         }
         m_channelStateMatrix.clear();
+        destroyStaleStates();
     };
 
     // NOTE: Subclasses must implement the following static methods for
@@ -137,6 +160,19 @@ class EffectProcessorImpl : public EffectProcessor {
                                 const EffectEnableState enableState,
                                 const GroupFeatureState& groupFeatures) = 0;
 
+    // Optional, see EffectProcessor::prepareBatch()
+    virtual void prepareChannelBatch(const ChannelHandle& handle,
+                                     EffectSpecificState* channelState,
+                                     const CSAMPLE* pInput,
+                                     const mixxx::EngineParameters& bufferParameters,
+                                     EngineFilterIIRBatch* pBatch) {
+        Q_UNUSED(handle);
+        Q_UNUSED(channelState);
+        Q_UNUSED(pInput);
+        Q_UNUSED(bufferParameters);
+        Q_UNUSED(pBatch);
+    }
+
     void process(const ChannelHandle& inputHandle, const ChannelHandle& outputHandle,
                          const CSAMPLE* pInput, CSAMPLE* pOutput,
                          const mixxx::EngineParameters& bufferParameters,
@@ -151,16 +187,38 @@ class EffectProcessorImpl : public EffectProcessor {
                            << "EffectState should have been preallocated in the"
                               "main thread.";
             }
-            pState = createSpecificState(bufferParameters);
+            // The pool must not be touched by the engine thread
+            pState = new EffectSpecificState(bufferParameters);
             m_channelStateMatrix[inputHandle][outputHandle] = pState;
         }
         processChannel(inputHandle, pState, pInput, pOutput, bufferParameters,
                        enableState, groupFeatures);
     }
 
+    void prepareBatch(const ChannelHandle& inputHandle,
+                      const ChannelHandle& outputHandle,
+                      const CSAMPLE* pInput,
+                      const mixxx::EngineParameters& bufferParameters,
+                      EngineFilterIIRBatch* pBatch) final {
+        EffectSpecificState* pState = m_channelStateMatrix[inputHandle][outputHandle];
+        if (pState == nullptr) {
+            // process() takes care of the missing state
+            return;
+        }
+        prepareChannelBatch(inputHandle, pState, pInput, bufferParameters, pBatch);
+    }
+
     void initialize(const QSet<ChannelHandleAndGroup>& activeInputChannels,
             EffectsManager* pEffectsManager,
             const mixxx::EngineParameters& bufferParameters) final {
+        // Room for the states of all input channels that may be enabled
+        // later, before any state is allocated
+        const int numStates =
+                pEffectsManager->registeredInputChannels().size() *
+                pEffectsManager->registeredOutputChannels().size();
+        m_statePool.reserve(numStates);
+        m_pStaleStates = std::make_unique<FIFO<EffectSpecificState*>>(
+                std::max(numStates, 1));
         for (const ChannelHandleAndGroup& inputChannel : activeInputChannels) {
             if (kEffectDebugOutput) {
                 qDebug() << this << "EffectProcessorImpl::initialize allocating "
@@ -212,8 +270,14 @@ class EffectProcessorImpl : public EffectProcessor {
           // effectSpecificStatesMap should be empty and this loop should
           // not go through any iterations.
           for (EffectSpecificState* pState : effectSpecificStatesMap) {
+              // Neither the pool nor the heap must be touched by the engine
+              // thread, so a stale state is handed over to the main thread.
               VERIFY_OR_DEBUG_ASSERT(pState == nullptr) {
-                  delete pState;
+                  VERIFY_OR_DEBUG_ASSERT(m_pStaleStates &&
+                          m_pStaleStates->write(&pState, 1) == 1) {
+                      // Leaked rather than blocking the engine thread
+                      continue;
+                  }
               }
           }
 
@@ -257,22 +321,50 @@ class EffectProcessorImpl : public EffectProcessor {
                       qDebug() << "EffectProcessorImpl::deleteStatesForInputChannel"
                                << this << "deleting state" << pState;
                 }
-                delete pState;
+                destroySpecificState(pState);
           }
           stateMap.clear();
+          destroyStaleStates();
     };
 
   private:
 
     EffectSpecificState* createSpecificState(const mixxx::EngineParameters& bufferParameters) {
-        EffectSpecificState* pState = new EffectSpecificState(bufferParameters);
+        EffectSpecificState* pState = m_statePool.acquire(bufferParameters);
         if (kEffectDebugOutput) {
             qDebug() << this << "EffectProcessorImpl creating EffectState" << pState;
         }
         return pState;
     };
 
+    void destroySpecificState(EffectSpecificState* pState) {
+        // States that have been created by the engine thread as a fallback
+        // are not from the pool
+        if (!m_statePool.release(pState)) {
+            delete pState;
+        }
+    }
+
+    // Destroys the states that loadStatesForInputChannel() has replaced in
+    // the engine thread. Called from the main thread.
+    void destroyStaleStates() {
+        if (!m_pStaleStates) {
+            return;
+        }
+        EffectSpecificState* pState;
+        while (m_pStaleStates->read(&pState, 1) == 1) {
+            if (kEffectDebugOutput) {
+                qDebug() << this << "EffectProcessorImpl deleting stale EffectState"
+                         << pState;
+            }
+            destroySpecificState(pState);
+        }
+    }
+
     EffectsManager* m_pEffectsManager;
+    EffectStatePool<EffectSpecificState> m_statePool;
+    // States replaced in the engine thread that wait for destroyStaleStates()
+    std::unique_ptr<FIFO<EffectSpecificState*>> m_pStaleStates;
     ChannelHandleMap<ChannelHandleMap<EffectSpecificState*>> m_channelStateMatrix;
 };
 
@@ -12,6 +12,7 @@
 #include "engine/effects/engineeffectrack.h"
 #include "engine/effects/engineeffectchain.h"
 #include "util/assert.h"
+#include "util/counter.h"
 
 namespace {
 const QString kEffectGroupSeparator = "_";
@@ -26,6 +27,10 @@ EffectsManager::EffectsManager(QObject* pParent,
           m_pChannelHandleFactory(pChannelHandleFactory),
           m_pEffectChainManager(new EffectChainManager(pConfig, this)),
           m_nextRequestId(0),
+          m_pPendingParameterBatch(new EffectParameterBatch()),
+          m_parameterFlushScheduled(false),
+          m_coalescedParameterUpdates(0),
+          m_droppedParameterUpdates(0),
           m_pLoEqFreq(NULL),
           m_pHiEqFreq(NULL),
           m_underDestruction(false) {
@@ -39,6 +44,9 @@ EffectsManager::EffectsManager(QObject* pParent,
 
     m_pNumEffectsAvailable = new ControlObject(ConfigKey("[Master]", "num_effectsavailable"));
     m_pNumEffectsAvailable->setReadOnly();
+
+    // The second buffer for the parameter updates
+    m_freeParameterBatches.append(new EffectParameterBatch());
 }
 
 EffectsManager::~EffectsManager() {
@@ -54,9 +62,15 @@ EffectsManager::~EffectsManager() {
     }
     for (QHash<qint64, EffectsRequest*>::iterator it = m_activeRequests.begin();
          it != m_activeRequests.end();) {
-        delete it.value();
+        EffectsRequest* pRequest = it.value();
+        if (pRequest->type == EffectsRequest::SET_PARAMETER_BATCH) {
+            delete pRequest->SetParameterBatch.pBatch;
+        }
+        delete pRequest;
         it = m_activeRequests.erase(it);
     }
+    delete m_pPendingParameterBatch;
+    qDeleteAll(m_freeParameterBatches);
 
     delete m_pHiEqFreq;
     delete m_pLoEqFreq;
@@ -410,6 +424,13 @@ void EffectsManager::refeshAllRacks() {
 }
 
 bool EffectsManager::writeRequest(EffectsRequest* request) {
+    // The pending parameter updates must not be overtaken, e.g. by the
+    // removal of their effect
+    flushParameterUpdates();
+    return writeRequestToPipe(request);
+}
+
+bool EffectsManager::writeRequestToPipe(EffectsRequest* request) {
     if (m_underDestruction) {
         // Catch all delete Messages since the engine is already down
         // and we cannot wait for a communication cycle
@@ -417,7 +438,7 @@ bool EffectsManager::writeRequest(EffectsRequest* request) {
     }
 
     if (m_pRequestPipe.isNull()) {
-        delete request;
+        discardRequest(request);
         return false;
     }
 
@@ -431,10 +452,84 @@ bool EffectsManager::writeRequest(EffectsRequest* request) {
         m_activeRequests[request->request_id] = request;
         return true;
     }
-    delete request;
+    discardRequest(request);
     return false;
 }
 
+void EffectsManager::discardRequest(EffectsRequest* request) {
+    if (request->type == EffectsRequest::SET_PARAMETER_BATCH) {
+        EffectParameterBatch* pBatch = request->SetParameterBatch.pBatch;
+        m_droppedParameterUpdates += pBatch->size;
+        Counter counter("EffectsManager::parameter updates dropped");
+        counter.increment(pBatch->size);
+        recycleParameterBatch(pBatch);
+    }
+    delete request;
+}
+
+void EffectsManager::queueParameterUpdate(const EffectParameterUpdate& update) {
+    const QPair<EngineEffect*, int> key(update.pEffect, update.iParameter);
+    const auto it = m_pendingParameterUpdates.constFind(key);
+    if (it != m_pendingParameterUpdates.constEnd()) {
+        // Only the latest update of a parameter is applied
+        m_pPendingParameterBatch->updates[it.value()] = update;
+        ++m_coalescedParameterUpdates;
+        Counter counter("EffectsManager::parameter updates coalesced");
+        counter.increment();
+        return;
+    }
+
+    if (m_pPendingParameterBatch->isFull()) {
+        flushParameterUpdates();
+    }
+    const int index = m_pPendingParameterBatch->size++;
+    m_pPendingParameterBatch->updates[index] = update;
+    m_pendingParameterUpdates.insert(key, index);
+
+    if (!m_parameterFlushScheduled) {
+        // Collect all updates caused by the current event, e.g. all
+        // parameters that are linked to a metaknob
+        m_parameterFlushScheduled = true;
+        QMetaObject::invokeMethod(this, "flushParameterUpdates",
+                Qt::QueuedConnection);
+    }
+}
+
+void EffectsManager::flushParameterUpdates() {
+    m_parameterFlushScheduled = false;
+    if (m_pPendingParameterBatch->size == 0) {
+        return;
+    }
+    m_pendingParameterUpdates.clear();
+    if (m_underDestruction) {
+        // The engine is already down
+        m_pPendingParameterBatch->size = 0;
+        return;
+    }
+
+    EffectsRequest* pRequest = new EffectsRequest();
+    pRequest->type = EffectsRequest::SET_PARAMETER_BATCH;
+    pRequest->SetParameterBatch.pBatch = m_pPendingParameterBatch;
+    // Responses are processed before writing, which might return the
+    // previous batch
+    writeRequestToPipe(pRequest);
+    m_pPendingParameterBatch = takeFreeParameterBatch();
+}
+
+EffectParameterBatch* EffectsManager::takeFreeParameterBatch() {
+    if (m_freeParameterBatches.isEmpty()) {
+        // The engine has not applied the previous batches yet, e.g. while
+        // the sound device is closed
+        return new EffectParameterBatch();
+    }
+    return m_freeParameterBatches.takeLast();
+}
+
+void EffectsManager::recycleParameterBatch(EffectParameterBatch* pBatch) {
+    pBatch->size = 0;
+    m_freeParameterBatches.append(pBatch);
+}
+
 void EffectsManager::processEffectsResponses() {
     if (m_pRequestPipe.isNull()) {
         return;
@@ -483,6 +578,8 @@ void EffectsManager::collectGarbage(const EffectsRequest* pRequest) {
             qDebug() << debugString() << "delete" << pRequest->RemoveEffectRack.pRack;
         }
         delete pRequest->RemoveEffectRack.pRack;
+    } else if (pRequest->type == EffectsRequest::SET_PARAMETER_BATCH) {
+        recycleParameterBatch(pRequest->SetParameterBatch.pBatch);
     } else if (pRequest->type == EffectsRequest::DISABLE_EFFECT_CHAIN_FOR_INPUT_CHANNEL) {
         if (kEffectDebugOutput) {
             qDebug() << debugString() << "deleting states for input channel" << pRequest->DisableInputChannelForChain.pChannelHandle << "for EngineEffectChain" << pRequest->pTargetChain;
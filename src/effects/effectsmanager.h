@@ -16,6 +16,7 @@
 #include "util/class.h"
 #include "util/fifo.h"
 
+class EngineEffect;
 class EngineEffectsManager;
 class EffectChainManager;
 class EffectManifest;
@@ -105,6 +106,26 @@ class EffectsManager : public QObject {
     // ownership of request and deletes it once a response is received.
     bool writeRequest(EffectsRequest* request);
 
+    // Queue an update of an EngineEffectParameter. It replaces a pending
+    // update of the same parameter. The pending updates are written in a
+    // single SET_PARAMETER_BATCH request when control returns to the event
+    // loop, or before the next request is written.
+    void queueParameterUpdate(const EffectParameterUpdate& update);
+
+    // The number of parameter updates that have been replaced by a later
+    // update before being written
+    int coalescedParameterUpdates() const {
+        return m_coalescedParameterUpdates;
+    }
+    // The number of parameter updates that could not be written
+    int droppedParameterUpdates() const {
+        return m_droppedParameterUpdates;
+    }
+
+  public slots:
+    // Write the pending parameter updates immediately
+    void flushParameterUpdates();
+
   signals:
     // TODO() Not connected. Can be used when we implement effect PlugIn loading at runtime
     void availableEffectsUpdated(EffectManifestPointer);
@@ -118,9 +139,14 @@ class EffectsManager : public QObject {
         return "EffectsManager";
     }
 
+    bool writeRequestToPipe(EffectsRequest* request);
+    void discardRequest(EffectsRequest* request);
     void processEffectsResponses();
     void collectGarbage(const EffectsRequest* pResponse);
 
+    EffectParameterBatch* takeFreeParameterBatch();
+    void recycleParameterBatch(EffectParameterBatch* pBatch);
+
     ChannelHandleFactoryPointer m_pChannelHandleFactory;
 
     EffectChainManager* m_pEffectChainManager;
@@ -134,6 +160,17 @@ class EffectsManager : public QObject {
     qint64 m_nextRequestId;
     QHash<qint64, EffectsRequest*> m_activeRequests;
 
+    // The parameter updates are double-buffered: The pending batch is filled
+    // while the previous one is applied by the engine. The batches are reused
+    // after the engine has responded.
+    EffectParameterBatch* m_pPendingParameterBatch;
+    // The index of the pending update of each parameter in the pending batch
+    QHash<QPair<EngineEffect*, int>, int> m_pendingParameterUpdates;
+    QList<EffectParameterBatch*> m_freeParameterBatches;
+    bool m_parameterFlushScheduled;
+    int m_coalescedParameterUpdates;
+    int m_droppedParameterUpdates;
+
     ControlObject* m_pNumEffectsAvailable;
     // We need to create Control Objects for Equalizers' frequencies
     ControlPotmeter* m_pLoEqFreq;
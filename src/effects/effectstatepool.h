@@ -0,0 +1,143 @@
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "util/assert.h"
+#include "util/class.h"
+
+// Stores the EffectStates of one EffectProcessorImpl side by side in a few
+// large chunks instead of one heap allocation per routing of input channel
+// to output channel. The slot of a released state is reused for the next
+// acquired one.
+//
+// Only the main thread acquires and releases states, so the pool needs no
+// locking. The engine thread only uses the acquired states.
+template<typename State>
+class EffectStatePool {
+  public:
+    EffectStatePool()
+            : m_capacity(0),
+              m_size(0),
+              m_pFreeSlots(nullptr) {
+    }
+    ~EffectStatePool() {
+        // States that have not been released are destroyed with the pool
+        for (const auto& chunk : m_chunks) {
+            for (int i = 0; i < chunk.capacity; ++i) {
+                if (chunk.pSlots[i].acquired) {
+                    chunk.pSlots[i].state()->~State();
+                }
+            }
+        }
+    }
+
+    // The number of slots
+    int capacity() const {
+        return m_capacity;
+    }
+    // The number of acquired states
+    int size() const {
+        return m_size;
+    }
+
+    // Allocates slots for at least count states at once
+    void reserve(int count) {
+        if (count > m_capacity) {
+            addChunk(count - m_capacity);
+        }
+    }
+
+    // Constructs a state in a free slot, which only allocates if all
+    // slots are in use
+    template<typename... Args>
+    State* acquire(Args&&... args) {
+        if (!m_pFreeSlots) {
+            // Grow exponentially like a vector
+            addChunk(std::max(m_capacity, kMinChunkCapacity));
+        }
+        Slot* pSlot = m_pFreeSlots;
+        m_pFreeSlots = pSlot->pNextFree;
+        State* pState = new (&pSlot->storage) State(std::forward<Args>(args)...);
+        pSlot->acquired = true;
+        ++m_size;
+        return pState;
+    }
+
+    // Destroys a state and frees its slot. Returns false without touching
+    // the state if it has not been acquired from this pool.
+    bool release(State* pState) {
+        Slot* pSlot = findSlot(pState);
+        if (!pSlot) {
+            return false;
+        }
+        VERIFY_OR_DEBUG_ASSERT(pSlot->acquired) {
+            return true;
+        }
+        pState->~State();
+        pSlot->acquired = false;
+        pSlot->pNextFree = m_pFreeSlots;
+        m_pFreeSlots = pSlot;
+        --m_size;
+        return true;
+    }
+
+  private:
+    static constexpr int kMinChunkCapacity = 4;
+
+    struct Slot {
+        State* state() {
+            return reinterpret_cast<State*>(&storage);
+        }
+
+        typename std::aligned_storage<sizeof(State), alignof(State)>::type storage;
+        Slot* pNextFree;
+        bool acquired;
+    };
+
+    struct Chunk {
+        std::unique_ptr<Slot[]> pSlots;
+        int capacity;
+    };
+
+    void addChunk(int capacity) {
+        Chunk chunk;
+        chunk.pSlots.reset(new Slot[capacity]);
+        chunk.capacity = capacity;
+        // Hand out the slots in the order of their addresses
+        for (int i = capacity - 1; i >= 0; --i) {
+            chunk.pSlots[i].acquired = false;
+            chunk.pSlots[i].pNextFree = m_pFreeSlots;
+            m_pFreeSlots = &chunk.pSlots[i];
+        }
+        m_chunks.push_back(std::move(chunk));
+        m_capacity += capacity;
+    }
+
+    Slot* findSlot(State* pState) const {
+        const auto* pStorage = reinterpret_cast<const char*>(pState);
+        for (const auto& chunk : m_chunks) {
+            const auto* pBegin = reinterpret_cast<const char*>(chunk.pSlots.get());
+            const auto* pEnd = reinterpret_cast<const char*>(
+                    chunk.pSlots.get() + chunk.capacity);
+            if (pStorage >= pBegin && pStorage < pEnd) {
+                return &chunk.pSlots[(pStorage - pBegin) / sizeof(Slot)];
+            }
+        }
+        return nullptr;
+    }
+
+    std::vector<Chunk> m_chunks;
+    int m_capacity;
+    int m_size;
+    Slot* m_pFreeSlots;
+
+    DISALLOW_COPY_AND_ASSIGN(EffectStatePool);
+};
+
+template<typename State>
+constexpr int EffectStatePool<State>::kMinChunkCapacity;
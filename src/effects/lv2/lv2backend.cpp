@@ -10,6 +10,19 @@ LV2Backend::LV2Backend(QObject* pParent)
 }
 
 LV2Backend::~LV2Backend() {
+    for (auto it = m_cpuMeters.constBegin(); it != m_cpuMeters.constEnd(); ++it) {
+        if (it.value()->hasLoad()) {
+            qDebug() << debugString() << it.key() << "used"
+                     << it.value()->averageLoad() * 100 << "% of the real time on average and"
+                     << it.value()->peakLoad() * 100 << "% at peak";
+        }
+        delete it.value();
+    }
+    foreach(LilvState* state, m_defaultStates) {
+        if (state) {
+            lilv_state_free(state);
+        }
+    }
     foreach(LilvNode* node, m_properties) {
         lilv_node_free(node);
     }
@@ -30,6 +43,10 @@ void LV2Backend::enumeratePlugins() {
         lv2Manifest->getEffectManifest()->setBackendType(m_type);
         m_registeredEffects.insert(lv2Manifest->getEffectManifest()->id(),
                                    lv2Manifest);
+        if (lv2Manifest->isValid()) {
+            m_cpuMeters.insert(lv2Manifest->getEffectManifest()->id(),
+                               new LV2CpuMeter());
+        }
     }
 }
 
@@ -82,6 +99,21 @@ LV2Manifest* LV2Backend::getLV2Manifest(const QString& effectId) const {
     return m_registeredEffects[effectId];
 }
 
+const LV2CpuMeter* LV2Backend::getCpuMeter(const QString& effectId) const {
+    return m_cpuMeters.value(effectId, nullptr);
+}
+
+const LilvState* LV2Backend::getDefaultState(const QString& effectId) {
+    if (!m_defaultStates.contains(effectId)) {
+        LV2Manifest* lv2Manifest = m_registeredEffects[effectId];
+        LilvState* state = lilv_state_new_from_world(m_pWorld,
+                m_hostFeatures.uridMap(),
+                lilv_plugin_get_uri(lv2Manifest->getPlugin()));
+        m_defaultStates.insert(effectId, state);
+    }
+    return m_defaultStates[effectId];
+}
+
 EffectPointer LV2Backend::instantiateEffect(EffectsManager* pEffectsManager,
                                             const QString& effectId) {
     if (!canInstantiateEffect(effectId)) {
@@ -98,5 +130,8 @@ EffectPointer LV2Backend::instantiateEffect(EffectsManager* pEffectsManager,
                         new LV2EffectProcessorInstantiator(
                                 lv2manifest->getPlugin(),
                                 lv2manifest->getAudioPortIndices(),
-                                lv2manifest->getControlPortIndices()))));
+                                lv2manifest->getControlPortIndices(),
+                                &m_hostFeatures,
+                                getDefaultState(effectId),
+                                m_cpuMeters[effectId]))));
 }
@@ -3,6 +3,8 @@
 
 #include "effects/defs.h"
 #include "effects/effectsbackend.h"
+#include "effects/lv2/lv2cpumeter.h"
+#include "effects/lv2/lv2hostfeatures.h"
 #include "effects/lv2/lv2manifest.h"
 #include "preferences/usersettings.h"
 #include <lilv-0/lilv/lilv.h>
@@ -21,12 +23,21 @@ class LV2Backend : public EffectsBackend {
     bool canInstantiateEffect(const QString& effectId) const;
     EffectPointer instantiateEffect(EffectsManager* pEffectsManager,
                                     const QString& effectId);
+    // Measures the load of the instances of an available plugin, so they
+    // can be checked before they are used live
+    const LV2CpuMeter* getCpuMeter(const QString& effectId) const;
 
   private:
     void initializeProperties();
+    // Returns null if the plugin has no default state
+    const LilvState* getDefaultState(const QString& effectId);
+
     LilvWorld* m_pWorld;
+    LV2HostFeatures m_hostFeatures;
     QHash<QString, LilvNode*> m_properties;
     QHash<QString, LV2Manifest*> m_registeredEffects;
+    QHash<QString, LilvState*> m_defaultStates;
+    QHash<QString, LV2CpuMeter*> m_cpuMeters;
 
     QString debugString() const {
         return "LV2Backend";
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <QtGlobal>
+
+#include <atomic>
+
+#include "util/types.h"
+
+// Measures how much of the real time one instance of an LV2 plugin needs
+// to process its audio, as a fraction where 1 uses up all of it. The
+// engine thread adds the buffers of all instances without locking, the
+// main thread reads the load.
+class LV2CpuMeter {
+  public:
+    LV2CpuMeter()
+            : m_processNanos(0),
+              m_audioNanos(0),
+              m_peakLoadPermille(0) {
+    }
+
+    // Engine thread
+    void addBuffer(qint64 processNanos, SINT frames, SINT sampleRate) {
+        if (frames <= 0 || sampleRate <= 0) {
+            return;
+        }
+        const qint64 audioNanos = frames * Q_INT64_C(1000000000) / sampleRate;
+        m_processNanos.fetch_add(processNanos, std::memory_order_relaxed);
+        m_audioNanos.fetch_add(audioNanos, std::memory_order_relaxed);
+        const qint64 loadPermille = processNanos * 1000 / qMax(audioNanos, Q_INT64_C(1));
+        qint64 peakLoadPermille = m_peakLoadPermille.load(std::memory_order_relaxed);
+        while (loadPermille > peakLoadPermille &&
+                !m_peakLoadPermille.compare_exchange_weak(peakLoadPermille,
+                        loadPermille,
+                        std::memory_order_relaxed)) {
+        }
+    }
+
+    // Returns false until a buffer has been processed
+    bool hasLoad() const {
+        return m_audioNanos.load(std::memory_order_relaxed) > 0;
+    }
+    double averageLoad() const {
+        const qint64 audioNanos = m_audioNanos.load(std::memory_order_relaxed);
+        if (audioNanos <= 0) {
+            return 0.0;
+        }
+        return static_cast<double>(m_processNanos.load(std::memory_order_relaxed)) /
+                audioNanos;
+    }
+    // The load of the most expensive buffer
+    double peakLoad() const {
+        return m_peakLoadPermille.load(std::memory_order_relaxed) / 1000.0;
+    }
+
+  private:
+    std::atomic<qint64> m_processNanos;
+    std::atomic<qint64> m_audioNanos;
+    std::atomic<qint64> m_peakLoadPermille;
+};
@@ -1,17 +1,66 @@
 #include "effects/lv2/lv2effectprocessor.h"
 #include "engine/effects/engineeffect.h"
 #include "control/controlobject.h"
+#include "util/performancetimer.h"
 #include "util/sample.h"
 #include "util/defs.h"
 
+#include <lv2/lv2plug.in/ns/ext/state/state.h>
+
+LV2EffectGroupState::LV2EffectGroupState(const mixxx::EngineParameters& bufferParameters,
+                                         const LilvPlugin* pPlugin,
+                                         LV2HostFeatures* pHostFeatures,
+                                         const LilvState* pDefaultState)
+        : EffectState(bufferParameters),
+          m_worker(pHostFeatures->workerThread()) {
+    // Keep in sync with LV2HostFeatures::isSupported()
+    m_uridMapFeature.URI = LV2_URID__map;
+    m_uridMapFeature.data = pHostFeatures->uridMap();
+    m_uridUnmapFeature.URI = LV2_URID__unmap;
+    m_uridUnmapFeature.data = pHostFeatures->uridUnmap();
+    m_scheduleFeature.URI = LV2_WORKER__schedule;
+    m_scheduleFeature.data = m_worker.schedule();
+    m_loadDefaultStateFeature.URI = LV2_STATE__loadDefaultState;
+    m_loadDefaultStateFeature.data = nullptr;
+    m_features[0] = &m_uridMapFeature;
+    m_features[1] = &m_uridUnmapFeature;
+    m_features[2] = &m_scheduleFeature;
+    m_features[3] = &m_loadDefaultStateFeature;
+    m_features[4] = nullptr;
+
+    m_pInstance = lilv_plugin_instantiate(pPlugin, bufferParameters.sampleRate(), m_features);
+    m_worker.setInstance(m_pInstance);
+    if (m_pInstance && pDefaultState) {
+        // The port values of the state are not restored, because the
+        // parameters of the effect are written to the control ports anyway.
+        lilv_state_restore(pDefaultState, m_pInstance, nullptr, nullptr, 0, m_features);
+    }
+}
+
+LV2EffectGroupState::~LV2EffectGroupState() {
+    if (!m_pInstance) {
+        return;
+    }
+    // Waits for the work in progress
+    m_worker.setInstance(nullptr);
+    lilv_instance_deactivate(m_pInstance);
+    lilv_instance_free(m_pInstance);
+}
+
 LV2EffectProcessor::LV2EffectProcessor(EngineEffect* pEngineEffect,
                                        EffectManifestPointer pManifest,
                                        const LilvPlugin* plugin,
                                        QList<int> audioPortIndices,
-                                       QList<int> controlPortIndices)
+                                       QList<int> controlPortIndices,
+                                       LV2HostFeatures* pHostFeatures,
+                                       const LilvState* pDefaultState,
+                                       LV2CpuMeter* pCpuMeter)
             : m_pPlugin(plugin),
               m_audioPortIndices(audioPortIndices),
               m_controlPortIndices(controlPortIndices),
+              m_pHostFeatures(pHostFeatures),
+              m_pDefaultState(pDefaultState),
+              m_pCpuMeter(pCpuMeter),
               m_pEffectsManager(nullptr) {
     m_inputL = new float[MAX_BUFFER_LEN];
     m_inputR = new float[MAX_BUFFER_LEN];
@@ -127,7 +176,12 @@ void LV2EffectProcessor::process(const ChannelHandle& inputHandle,
         j++;
     }
 
+    PerformanceTimer timer;
+    timer.start();
     lilv_instance_run(pState->lilvIinstance(), bufferParameters.framesPerBuffer());
+    pState->worker()->deliverResponses();
+    m_pCpuMeter->addBuffer(timer.elapsed().toIntegerNanos(),
+            bufferParameters.framesPerBuffer(), bufferParameters.sampleRate());
 
     j = 0;
     for (unsigned int i = 0; i < bufferParameters.samplesPerBuffer(); i += 2) {
@@ -138,7 +192,8 @@ void LV2EffectProcessor::process(const ChannelHandle& inputHandle,
 }
 
 LV2EffectGroupState* LV2EffectProcessor::createGroupState(const mixxx::EngineParameters& bufferParameters) {
-    LV2EffectGroupState * pState = new LV2EffectGroupState(bufferParameters, m_pPlugin);
+    LV2EffectGroupState * pState = new LV2EffectGroupState(bufferParameters,
+            m_pPlugin, m_pHostFeatures, m_pDefaultState);
     LilvInstance* handle = pState->lilvIinstance();
     if (handle) {
         for (int i = 0; i < m_parameters.size(); i++) {
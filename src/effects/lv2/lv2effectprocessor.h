@@ -6,23 +6,35 @@
 #include "engine/effects/engineeffectparameter.h"
 #include <lilv-0/lilv/lilv.h>
 #include "effects/defs.h"
+#include "effects/lv2/lv2cpumeter.h"
+#include "effects/lv2/lv2hostfeatures.h"
+#include "effects/lv2/lv2worker.h"
 #include "engine/engine.h"
 
 class LV2EffectGroupState : public EffectState {
   public:
-    LV2EffectGroupState(const mixxx::EngineParameters& bufferParameters, const LilvPlugin* pPlugin)
-            : EffectState(bufferParameters) {
-        m_pInstance = lilv_plugin_instantiate(pPlugin, bufferParameters.sampleRate(), nullptr);
-    }
-    ~LV2EffectGroupState() {
-        lilv_instance_deactivate(m_pInstance);
-        lilv_instance_free(m_pInstance);
-    }
+    // Restores pDefaultState, if the plugin has one
+    LV2EffectGroupState(const mixxx::EngineParameters& bufferParameters,
+            const LilvPlugin* pPlugin,
+            LV2HostFeatures* pHostFeatures,
+            const LilvState* pDefaultState);
+    ~LV2EffectGroupState();
 
     LilvInstance* lilvIinstance() {
         return m_pInstance;
     }
+    LV2Worker* worker() {
+        return &m_worker;
+    }
   private:
+    // Must outlive the instance
+    LV2Worker m_worker;
+    LV2_Feature m_uridMapFeature;
+    LV2_Feature m_uridUnmapFeature;
+    LV2_Feature m_scheduleFeature;
+    LV2_Feature m_loadDefaultStateFeature;
+    const LV2_Feature* m_features[5];
+
     LilvInstance* m_pInstance;
 };
 
@@ -32,7 +44,10 @@ class LV2EffectProcessor : public EffectProcessor {
                        EffectManifestPointer pManifest,
                        const LilvPlugin* plugin,
                        QList<int> audioPortIndices,
-                       QList<int> controlPortIndices);
+                       QList<int> controlPortIndices,
+                       LV2HostFeatures* pHostFeatures,
+                       const LilvState* pDefaultState,
+                       LV2CpuMeter* pCpuMeter);
     ~LV2EffectProcessor();
 
     void initialize(
@@ -64,6 +79,9 @@ class LV2EffectProcessor : public EffectProcessor {
     const LilvPlugin* m_pPlugin;
     const QList<int> m_audioPortIndices;
     const QList<int> m_controlPortIndices;
+    LV2HostFeatures* m_pHostFeatures;
+    const LilvState* m_pDefaultState;
+    LV2CpuMeter* m_pCpuMeter;
 
     EffectsManager* m_pEffectsManager;
     ChannelHandleMap<ChannelHandleMap<LV2EffectGroupState*>> m_channelStateMatrix;
@@ -0,0 +1,54 @@
+#include "effects/lv2/lv2hostfeatures.h"
+
+#include <QMutexLocker>
+
+#include <lv2/lv2plug.in/ns/ext/state/state.h>
+#include <lv2/lv2plug.in/ns/ext/worker/worker.h>
+
+// static
+bool LV2HostFeatures::isSupported(const QString& featureUri) {
+    // Keep in sync with the features passed by LV2EffectGroupState
+    return featureUri == LV2_URID__map ||
+            featureUri == LV2_URID__unmap ||
+            featureUri == LV2_WORKER__schedule ||
+            featureUri == LV2_STATE__loadDefaultState;
+}
+
+LV2HostFeatures::LV2HostFeatures() {
+    m_uridMap.handle = this;
+    m_uridMap.map = &LV2HostFeatures::mapUri;
+    m_uridUnmap.handle = this;
+    m_uridUnmap.unmap = &LV2HostFeatures::unmapUrid;
+    m_workerThread.start(QThread::LowPriority);
+}
+
+LV2_URID LV2HostFeatures::map(const char* uri) {
+    const QByteArray key(uri);
+    QMutexLocker locker(&m_uridMutex);
+    LV2_URID urid = m_urids.value(key, 0);
+    if (urid == 0) {
+        m_uris.append(key);
+        urid = m_uris.size();
+        m_urids.insert(key, urid);
+    }
+    return urid;
+}
+
+const char* LV2HostFeatures::unmap(LV2_URID urid) {
+    QMutexLocker locker(&m_uridMutex);
+    if (urid == 0 || urid > static_cast<LV2_URID>(m_uris.size())) {
+        return nullptr;
+    }
+    // The data of the QByteArray is not touched by appending to the list
+    return m_uris.at(urid - 1).constData();
+}
+
+// static
+LV2_URID LV2HostFeatures::mapUri(LV2_URID_Map_Handle handle, const char* uri) {
+    return static_cast<LV2HostFeatures*>(handle)->map(uri);
+}
+
+// static
+const char* LV2HostFeatures::unmapUrid(LV2_URID_Unmap_Handle handle, LV2_URID urid) {
+    return static_cast<LV2HostFeatures*>(handle)->unmap(urid);
+}
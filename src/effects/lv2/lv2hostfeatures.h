@@ -0,0 +1,56 @@
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+
+#include <lv2/lv2plug.in/ns/ext/urid/urid.h>
+
+#include "effects/lv2/lv2worker.h"
+#include "util/class.h"
+
+// The LV2 features that Mixxx provides to the plugins it instantiates,
+// shared by all of them.
+//
+// URIs are mapped to URIDs once and looked up in a cache afterwards. The
+// plugins map URIs while they are instantiated or from their worker, which
+// can happen concurrently, so the cache is locked. URIDs stay valid as long
+// as the LV2HostFeatures.
+class LV2HostFeatures {
+  public:
+    LV2HostFeatures();
+
+    // Returns true if plugins that require the feature can be instantiated
+    static bool isSupported(const QString& featureUri);
+
+    LV2_URID map(const char* uri);
+    // Returns null for unknown URIDs
+    const char* unmap(LV2_URID urid);
+
+    LV2_URID_Map* uridMap() {
+        return &m_uridMap;
+    }
+    LV2_URID_Unmap* uridUnmap() {
+        return &m_uridUnmap;
+    }
+    LV2WorkerThread* workerThread() {
+        return &m_workerThread;
+    }
+
+  private:
+    static LV2_URID mapUri(LV2_URID_Map_Handle handle, const char* uri);
+    static const char* unmapUrid(LV2_URID_Unmap_Handle handle, LV2_URID urid);
+
+    QMutex m_uridMutex;
+    QHash<QByteArray, LV2_URID> m_urids;
+    // The URI of URID n is at index n - 1, because 0 is not a valid URID
+    QList<QByteArray> m_uris;
+    LV2_URID_Map m_uridMap;
+    LV2_URID_Unmap m_uridUnmap;
+
+    LV2WorkerThread m_workerThread;
+
+    DISALLOW_COPY_AND_ASSIGN(LV2HostFeatures);
+};
@@ -1,5 +1,6 @@
 #include "effects/lv2/lv2manifest.h"
 #include "effects/effectmanifestparameter.h"
+#include "effects/lv2/lv2hostfeatures.h"
 #include "util/math.h"
 
 LV2Manifest::LV2Manifest(const LilvPlugin* plug,
@@ -145,10 +146,13 @@ LV2Manifest::LV2Manifest(const LilvPlugin* plug,
         m_status = IO_NOT_STEREO;
     }
 
-    // We don't support any features
+    // We only support the features of LV2HostFeatures
     LilvNodes* features = lilv_plugin_get_required_features(m_pLV2plugin);
-    if (lilv_nodes_size(features) > 0) {
-        m_status = HAS_REQUIRED_FEATURES;
+    LILV_FOREACH(nodes, i, features) {
+        const LilvNode* feature = lilv_nodes_get(features, i);
+        if (!LV2HostFeatures::isSupported(lilv_node_as_uri(feature))) {
+            m_status = HAS_REQUIRED_FEATURES;
+        }
     }
     lilv_nodes_free(features);
 }
@@ -0,0 +1,184 @@
+#include "effects/lv2/lv2worker.h"
+
+#include <QMutexLocker>
+#include <QtDebug>
+
+#include <algorithm>
+
+#include "util/math.h"
+
+constexpr int LV2Worker::kFifoSize;
+
+namespace {
+
+// Copies to the two write regions of a FIFO as if they were one
+void copyToRegions(char* pRegion1, ring_buffer_size_t size1, char* pRegion2,
+        ring_buffer_size_t offset, const void* pData, ring_buffer_size_t size) {
+    const char* pBytes = static_cast<const char*>(pData);
+    const ring_buffer_size_t sizeInRegion1 = math_clamp<ring_buffer_size_t>(
+            size1 - offset, 0, size);
+    std::copy(pBytes, pBytes + sizeInRegion1, pRegion1 + offset);
+    std::copy(pBytes + sizeInRegion1, pBytes + size,
+            pRegion2 + math_max<ring_buffer_size_t>(offset - size1, 0));
+}
+
+} // anonymous namespace
+
+LV2Worker::LV2Worker(LV2WorkerThread* pThread)
+        : m_pThread(pThread),
+          m_pInstance(nullptr),
+          m_pInterface(nullptr) {
+    m_schedule.handle = this;
+    m_schedule.schedule_work = &LV2Worker::scheduleWork;
+}
+
+LV2Worker::~LV2Worker() {
+    if (m_pInterface) {
+        m_pThread->removeWorker(this);
+    }
+}
+
+void LV2Worker::setInstance(LilvInstance* pInstance) {
+    if (m_pInterface) {
+        m_pThread->removeWorker(this);
+        m_pInterface = nullptr;
+    }
+    m_pInstance = pInstance;
+    if (!m_pInstance) {
+        return;
+    }
+    m_pInterface = static_cast<const LV2_Worker_Interface*>(
+            lilv_instance_get_extension_data(m_pInstance, LV2_WORKER__interface));
+    if (!m_pInterface) {
+        return;
+    }
+    if (!m_pRequests) {
+        m_pRequests = std::make_unique<FIFO<char>>(kFifoSize);
+        m_pResponses = std::make_unique<FIFO<char>>(kFifoSize);
+        m_request.resize(kFifoSize);
+        m_response.resize(kFifoSize);
+    }
+    m_pThread->addWorker(this);
+}
+
+void LV2Worker::deliverResponses() {
+    if (!m_pInterface) {
+        return;
+    }
+    LV2_Handle handle = lilv_instance_get_handle(m_pInstance);
+    uint32_t size;
+    while (readMessage(m_pResponses.get(), &m_response, &size)) {
+        m_pInterface->work_response(handle, size, m_response.data());
+    }
+    if (m_pInterface->end_run) {
+        m_pInterface->end_run(handle);
+    }
+}
+
+void LV2Worker::work() {
+    LV2_Handle handle = lilv_instance_get_handle(m_pInstance);
+    uint32_t size;
+    while (readMessage(m_pRequests.get(), &m_request, &size)) {
+        m_pInterface->work(handle, &LV2Worker::respond, this, size, m_request.data());
+    }
+}
+
+// static
+LV2_Worker_Status LV2Worker::scheduleWork(LV2_Worker_Schedule_Handle handle,
+        uint32_t size,
+        const void* data) {
+    auto* pWorker = static_cast<LV2Worker*>(handle);
+    if (!pWorker->m_pInterface) {
+        return LV2_WORKER_ERR_UNKNOWN;
+    }
+    const LV2_Worker_Status status = writeMessage(pWorker->m_pRequests.get(), size, data);
+    if (status == LV2_WORKER_SUCCESS) {
+        pWorker->m_pThread->wake();
+    }
+    return status;
+}
+
+// static
+LV2_Worker_Status LV2Worker::respond(LV2_Worker_Respond_Handle handle,
+        uint32_t size,
+        const void* data) {
+    auto* pWorker = static_cast<LV2Worker*>(handle);
+    return writeMessage(pWorker->m_pResponses.get(), size, data);
+}
+
+// static
+LV2_Worker_Status LV2Worker::writeMessage(FIFO<char>* pFifo,
+        uint32_t size,
+        const void* data) {
+    if (size > static_cast<uint32_t>(kFifoSize)) {
+        return LV2_WORKER_ERR_NO_SPACE;
+    }
+    const int messageSize = static_cast<int>(sizeof(size) + size);
+    if (pFifo->writeAvailable() < messageSize) {
+        return LV2_WORKER_ERR_NO_SPACE;
+    }
+    char* pRegion1;
+    ring_buffer_size_t size1;
+    char* pRegion2;
+    ring_buffer_size_t size2;
+    pFifo->aquireWriteRegions(messageSize, &pRegion1, &size1, &pRegion2, &size2);
+    copyToRegions(pRegion1, size1, pRegion2, 0, &size, sizeof(size));
+    copyToRegions(pRegion1, size1, pRegion2, sizeof(size), data, size);
+    pFifo->releaseWriteRegions(messageSize);
+    return LV2_WORKER_SUCCESS;
+}
+
+// static
+bool LV2Worker::readMessage(FIFO<char>* pFifo,
+        std::vector<char>* pBuffer,
+        uint32_t* pSize) {
+    while (pFifo->readAvailable() >= static_cast<int>(sizeof(*pSize))) {
+        pFifo->read(reinterpret_cast<char*>(pSize), sizeof(*pSize));
+        if (*pSize <= pBuffer->size()) {
+            pFifo->read(pBuffer->data(), *pSize);
+            return true;
+        }
+        // Not written by writeMessage()
+        qWarning() << "LV2Worker: Dropping message of" << *pSize << "bytes";
+        pFifo->flushReadData(*pSize);
+    }
+    return false;
+}
+
+LV2WorkerThread::LV2WorkerThread()
+        : m_stop(false) {
+}
+
+LV2WorkerThread::~LV2WorkerThread() {
+    m_stop = true;
+    m_semaRun.release();
+    wait();
+}
+
+void LV2WorkerThread::addWorker(LV2Worker* pWorker) {
+    QMutexLocker locker(&m_workersMutex);
+    m_workers.append(pWorker);
+}
+
+void LV2WorkerThread::removeWorker(LV2Worker* pWorker) {
+    QMutexLocker locker(&m_workersMutex);
+    m_workers.removeAll(pWorker);
+}
+
+void LV2WorkerThread::run() {
+    QThread::currentThread()->setObjectName("LV2WorkerThread");
+
+    while (!m_stop.load()) {
+        m_semaRun.acquire();
+        if (m_stop.load()) {
+            break;
+        }
+        // All scheduled work is run below, so the wake ups in between
+        // can be skipped.
+        m_semaRun.tryAcquire(m_semaRun.available());
+        QMutexLocker locker(&m_workersMutex);
+        for (LV2Worker* pWorker : m_workers) {
+            pWorker->work();
+        }
+    }
+}
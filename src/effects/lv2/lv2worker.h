@@ -0,0 +1,115 @@
+#pragma once
+
+#include <QList>
+#include <QMutex>
+#include <QSemaphore>
+#include <QThread>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <lilv-0/lilv/lilv.h>
+#include <lv2/lv2plug.in/ns/ext/worker/worker.h>
+
+#include "util/class.h"
+#include "util/fifo.h"
+
+class LV2WorkerThread;
+
+// Implements the LV2 worker extension for one plugin instance. The plugin
+// schedules work that is not realtime safe, like loading a file, from its
+// run() in the engine thread. The work is passed through a lock-free FIFO
+// to the LV2WorkerThread. The responses come back through another FIFO and
+// are delivered to the plugin after its next run().
+class LV2Worker {
+  public:
+    explicit LV2Worker(LV2WorkerThread* pThread);
+    ~LV2Worker();
+
+    LV2_Worker_Schedule* schedule() {
+        return &m_schedule;
+    }
+
+    // Main thread, after instantiating the plugin and with null before
+    // deactivating it, which waits for the work in progress. Plugins
+    // without a worker interface are not given any work.
+    void setInstance(LilvInstance* pInstance);
+
+    // Engine thread, after each run() of the plugin
+    void deliverResponses();
+
+    // Worker thread. Runs all scheduled work of the plugin.
+    void work();
+
+  private:
+    // The FIFOs fit a few files worth of paths or a small sample
+    static constexpr int kFifoSize = 1 << 16;
+
+    static LV2_Worker_Status scheduleWork(LV2_Worker_Schedule_Handle handle,
+            uint32_t size,
+            const void* data);
+    static LV2_Worker_Status respond(LV2_Worker_Respond_Handle handle,
+            uint32_t size,
+            const void* data);
+
+    // Writes the size and the data of a message at once, so the reader
+    // never sees one without the other
+    static LV2_Worker_Status writeMessage(FIFO<char>* pFifo,
+            uint32_t size,
+            const void* data);
+    // Returns false if there is no message. Messages that do not fit into
+    // the buffer are dropped.
+    static bool readMessage(FIFO<char>* pFifo,
+            std::vector<char>* pBuffer,
+            uint32_t* pSize);
+
+    LV2WorkerThread* const m_pThread;
+    LilvInstance* m_pInstance;
+    const LV2_Worker_Interface* m_pInterface;
+    LV2_Worker_Schedule m_schedule;
+
+    // Only allocated for plugins with a worker interface. The buffers are
+    // preallocated, so reading a message never allocates. The request is
+    // only used by the worker thread, the response by the engine thread.
+    std::unique_ptr<FIFO<char>> m_pRequests;
+    std::unique_ptr<FIFO<char>> m_pResponses;
+    std::vector<char> m_request;
+    std::vector<char> m_response;
+
+    friend class LV2WorkerTest;
+
+    DISALLOW_COPY_AND_ASSIGN(LV2Worker);
+};
+
+// The thread that runs the work of all LV2Workers, so that the engine
+// thread only has to wake it up.
+class LV2WorkerThread : public QThread {
+    Q_OBJECT
+  public:
+    LV2WorkerThread();
+    ~LV2WorkerThread() override;
+
+    // Main thread
+    void addWorker(LV2Worker* pWorker);
+    // Main thread. Waits for the work of the worker that is in progress,
+    // so its plugin can be freed afterwards.
+    void removeWorker(LV2Worker* pWorker);
+
+    // Engine thread
+    void wake() {
+        m_semaRun.release();
+    }
+
+  protected:
+    void run() override;
+
+  private:
+    std::atomic<bool> m_stop;
+    QSemaphore m_semaRun;
+
+    QMutex m_workersMutex;
+    QList<LV2Worker*> m_workers;
+
+    DISALLOW_COPY_AND_ASSIGN(LV2WorkerThread);
+};
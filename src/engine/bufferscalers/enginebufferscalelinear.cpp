@@ -2,27 +2,190 @@
 
 #include <QtDebug>
 
+#include <cstring>
+
 #include "track/keyutils.h"
 #include "util/assert.h"
 #include "util/math.h"
 #include "util/sample.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ENGINEBUFFERSCALELINEAR_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// The frames of the previous read that are kept in front of the buffer.
+// The cubic interpolation needs up to 3 of them after a read.
+constexpr SINT kHistoryFrames = 4;
+constexpr SINT kHistorySamples = 2 * kHistoryFrames;
+// The samples after the buffer. The frames at the end of a span might be
+// rounded differently by the vectorized code under -ffast-math. The
+// additional frame that might be read then has a weight close to 0.
+constexpr SINT kPaddingSamples = kHistorySamples;
+constexpr SINT kBufferIntWithHistorySize =
+        kHistorySamples + kiLinearScaleReadAheadLength + kPaddingSamples;
+
+// laurent de soras - punked from musicdsp.org (mad props)
+inline float hermite4(float frac_pos, float xm1, float x0, float x1, float x2)
+{
+    const float c = (x1 - xm1) * 0.5f;
+    const float v = x0 - x1;
+    const float w = c + v;
+    const float a = w + v + (x2 - x0) * 0.5f;
+    const float b_neg = w + a;
+    return ((((a * frac_pos) - b_neg) * frac_pos + c) * frac_pos + x0);
+}
+
+// The input position of output frame j relative to the buffer is
+//   offset + j * rate + j * (j - 1) * halfRateDelta
+// i.e. the rate is ramped linearly over the output buffer. The positions
+// are computed directly instead of accumulating them, so that any number
+// of following frames can be processed at once.
+struct PositionRamp {
+    double offset;
+    double rate;
+    double halfRateDelta;
+
+    double at(SINT frame) const {
+        const double j = static_cast<double>(frame);
+        return offset + j * rate + j * (j - 1) * halfRateDelta;
+    }
+};
+
+// Fast floor() for positions that are not less than -kHistoryFrames
+inline int floorPosition(double position) {
+    return static_cast<int>(position + kHistoryFrames) - kHistoryFrames;
+}
+
+#ifdef ENGINEBUFFERSCALELINEAR_SSE2
+// The positions of the output frames in both lanes of j, with the same
+// operations as PositionRamp::at()
+inline __m128d positionsAt(const PositionRamp& ramp, __m128d j) {
+    return _mm_add_pd(
+            _mm_add_pd(_mm_set1_pd(ramp.offset),
+                    _mm_mul_pd(j, _mm_set1_pd(ramp.rate))),
+            _mm_mul_pd(_mm_mul_pd(j, _mm_sub_pd(j, _mm_set1_pd(1.0))),
+                    _mm_set1_pd(ramp.halfRateDelta)));
+}
+
+// Splits two positions into their floors and fractions like
+// floorPosition(). The fractions are returned for both channels of both
+// frames.
+inline __m128 splitPositions(__m128d positions, int* pFloor0, int* pFloor1) {
+    const __m128i floors = _mm_sub_epi32(
+            _mm_cvttpd_epi32(_mm_add_pd(positions,
+                    _mm_set1_pd(static_cast<double>(kHistoryFrames)))),
+            _mm_set1_epi32(kHistoryFrames));
+    *pFloor0 = _mm_cvtsi128_si32(floors);
+    *pFloor1 = _mm_cvtsi128_si32(_mm_srli_si128(floors, 4));
+    const __m128 fracs = _mm_cvtpd_ps(
+            _mm_sub_pd(positions, _mm_cvtepi32_pd(floors)));
+    return _mm_unpacklo_ps(fracs, fracs);
+}
+#endif
+
+// Interpolates the interleaved stereo output frames [begin, end) between
+// the input frame at the floor of their position and the following one
+void interpolateLinear(CSAMPLE* pOutput, const CSAMPLE* pFrames,
+        const PositionRamp& ramp, SINT begin, SINT end) {
+    SINT i = begin;
+#ifdef ENGINEBUFFERSCALELINEAR_SSE2
+    // Two output frames per vector. Both input frames of an output frame
+    // are loaded at once.
+    __m128d j = _mm_setr_pd(static_cast<double>(i), static_cast<double>(i + 1));
+    for (; i + 2 <= end; i += 2) {
+        int floor0, floor1;
+        const __m128 frac = splitPositions(positionsAt(ramp, j), &floor0, &floor1);
+        const __m128 a = _mm_loadu_ps(pFrames + 2 * floor0);
+        const __m128 b = _mm_loadu_ps(pFrames + 2 * floor1);
+        const __m128 x0 = _mm_movelh_ps(a, b);
+        const __m128 x1 = _mm_movehl_ps(b, a);
+        _mm_storeu_ps(pOutput + 2 * i,
+                _mm_add_ps(x0, _mm_mul_ps(frac, _mm_sub_ps(x1, x0))));
+        j = _mm_add_pd(j, _mm_set1_pd(2.0));
+    }
+#endif
+    for (; i < end; ++i) {
+        const double position = ramp.at(i);
+        const int floor = floorPosition(position);
+        const CSAMPLE* pFloorFrame = pFrames + 2 * floor;
+        // For the current index, what percentage is it
+        // between the previous and the next?
+        const CSAMPLE frac = static_cast<CSAMPLE>(position - floor);
+        pOutput[2 * i] = pFloorFrame[0] + frac * (pFloorFrame[2] - pFloorFrame[0]);
+        pOutput[2 * i + 1] = pFloorFrame[1] + frac * (pFloorFrame[3] - pFloorFrame[1]);
+    }
+}
+
+// Interpolates the interleaved stereo output frames [begin, end) between
+// the input frames from the one before the floor of their position to the
+// second one after it
+void interpolateCubic(CSAMPLE* pOutput, const CSAMPLE* pFrames,
+        const PositionRamp& ramp, SINT begin, SINT end) {
+    SINT i = begin;
+#ifdef ENGINEBUFFERSCALELINEAR_SSE2
+    const __m128 half = _mm_set1_ps(0.5f);
+    __m128d j = _mm_setr_pd(static_cast<double>(i), static_cast<double>(i + 1));
+    for (; i + 2 <= end; i += 2) {
+        int floor0, floor1;
+        const __m128 frac = splitPositions(positionsAt(ramp, j), &floor0, &floor1);
+        const __m128 aLow = _mm_loadu_ps(pFrames + 2 * (floor0 - 1));
+        const __m128 aHigh = _mm_loadu_ps(pFrames + 2 * (floor0 + 1));
+        const __m128 bLow = _mm_loadu_ps(pFrames + 2 * (floor1 - 1));
+        const __m128 bHigh = _mm_loadu_ps(pFrames + 2 * (floor1 + 1));
+        const __m128 xm1 = _mm_movelh_ps(aLow, bLow);
+        const __m128 x0 = _mm_movehl_ps(bLow, aLow);
+        const __m128 x1 = _mm_movelh_ps(aHigh, bHigh);
+        const __m128 x2 = _mm_movehl_ps(bHigh, aHigh);
+        // Same operations as hermite4()
+        const __m128 c = _mm_mul_ps(_mm_sub_ps(x1, xm1), half);
+        const __m128 v = _mm_sub_ps(x0, x1);
+        const __m128 w = _mm_add_ps(c, v);
+        const __m128 a = _mm_add_ps(_mm_add_ps(w, v),
+                _mm_mul_ps(_mm_sub_ps(x2, x0), half));
+        const __m128 b_neg = _mm_add_ps(w, a);
+        __m128 result = _mm_sub_ps(_mm_mul_ps(a, frac), b_neg);
+        result = _mm_add_ps(_mm_mul_ps(result, frac), c);
+        result = _mm_add_ps(_mm_mul_ps(result, frac), x0);
+        _mm_storeu_ps(pOutput + 2 * i, result);
+        j = _mm_add_pd(j, _mm_set1_pd(2.0));
+    }
+#endif
+    for (; i < end; ++i) {
+        const double position = ramp.at(i);
+        const int floor = floorPosition(position);
+        const CSAMPLE* pFloorFrame = pFrames + 2 * floor;
+        const CSAMPLE frac = static_cast<CSAMPLE>(position - floor);
+        for (int channel = 0; channel < 2; ++channel) {
+            pOutput[2 * i + channel] = hermite4(frac,
+                    pFloorFrame[channel - 2],
+                    pFloorFrame[channel],
+                    pFloorFrame[channel + 2],
+                    pFloorFrame[channel + 4]);
+        }
+    }
+}
+
+} // anonymous namespace
+
 EngineBufferScaleLinear::EngineBufferScaleLinear(ReadAheadManager *pReadAheadManager)
     : m_pReadAheadManager(pReadAheadManager),
-      m_bufferInt(SampleUtil::alloc(kiLinearScaleReadAheadLength)),
+      m_bufferIntWithHistory(SampleUtil::alloc(kBufferIntWithHistorySize)),
+      m_bufferInt(m_bufferIntWithHistory + kHistorySamples),
       m_bufferIntSize(0),
+      m_interpolation(Interpolation::Linear),
       m_bClear(false),
       m_dRate(1.0),
       m_dOldRate(1.0),
       m_dCurrentFrame(0.0),
       m_dNextFrame(0.0) {
-    m_floorSampleOld[0] = 0.0;
-    m_floorSampleOld[1] = 0.0;
-    SampleUtil::clear(m_bufferInt, kiLinearScaleReadAheadLength);
+    SampleUtil::clear(m_bufferIntWithHistory, kBufferIntWithHistorySize);
 }
 
 EngineBufferScaleLinear::~EngineBufferScaleLinear() {
-    SampleUtil::free(m_bufferInt);
+    SampleUtil::free(m_bufferIntWithHistory);
 }
 
 void EngineBufferScaleLinear::setScaleParameters(double base_rate,
@@ -39,19 +202,20 @@ void EngineBufferScaleLinear::clear() {
     // Clear out buffer and saved sample data
     m_bufferIntSize = 0;
     m_dNextFrame = 0;
-    m_floorSampleOld[0] = 0;
-    m_floorSampleOld[1] = 0;
+    SampleUtil::clear(m_bufferIntWithHistory, kHistorySamples);
 }
 
-// laurent de soras - punked from musicdsp.org (mad props)
-inline float hermite4(float frac_pos, float xm1, float x0, float x1, float x2)
-{
-    const float c = (x1 - xm1) * 0.5f;
-    const float v = x0 - x1;
-    const float w = c + v;
-    const float a = w + v + (x2 - x0) * 0.5f;
-    const float b_neg = w + a;
-    return ((((a * frac_pos) - b_neg) * frac_pos + c) * frac_pos + x0);
+void EngineBufferScaleLinear::setHistory(
+        const CSAMPLE* pFrames, SINT frames, SINT stride) {
+    if (frames <= 0) {
+        return;
+    }
+    for (SINT i = 0; i < kHistoryFrames; ++i) {
+        // Repeat the last given frame
+        const CSAMPLE* pFrame = pFrames + 2 * stride * math_min(i, frames - 1);
+        m_bufferInt[-2 * (i + 1)] = pFrame[0];
+        m_bufferInt[-2 * (i + 1) + 1] = pFrame[1];
+    }
 }
 
 // Determine if we're changing directions (scratching) and then perform
@@ -81,12 +245,13 @@ double EngineBufferScaleLinear::scaleBuffer(
         m_dRate = 0.0;
         frames_read += do_scale(pOutputBuffer, getOutputSignal().samples2frames(iOutputBufferSize));
 
-        // reset m_floorSampleOld in a way as we were coming from
-        // the other direction
+        // reset the frames in front of the buffer in a way as we were
+        // coming from the other direction
         SINT iNextSample = getOutputSignal().frames2samples(static_cast<SINT>(ceil(m_dNextFrame)));
-        if (iNextSample + 1 < m_bufferIntSize) {
-            m_floorSampleOld[0] = m_bufferInt[iNextSample];
-            m_floorSampleOld[1] = m_bufferInt[iNextSample + 1];
+        if (iNextSample >= 0 && iNextSample + 1 < m_bufferIntSize) {
+            setHistory(&m_bufferInt[iNextSample],
+                    getOutputSignal().samples2frames(m_bufferIntSize - iNextSample),
+                    1);
         }
 
         // if the buffer has extra samples, do a read so RAMAN ends up back where
@@ -169,8 +334,9 @@ SINT EngineBufferScaleLinear::do_copy(CSAMPLE* buf, SINT buf_size) {
     m_bufferIntSize = 0; // force buffer read
     m_dNextFrame = 0;
     if (read_samples > 1) {
-        m_floorSampleOld[0] = buf[read_samples - 2];
-        m_floorSampleOld[1] = buf[read_samples - 1];
+        setHistory(&buf[read_samples - 2],
+                getOutputSignal().samples2frames(read_samples),
+                -1);
     }
     return read_samples;
 }
@@ -219,62 +385,32 @@ SINT EngineBufferScaleLinear::do_scale(CSAMPLE* buf, SINT buf_size) {
     SINT unscaled_frames_needed = static_cast<SINT>(frames +
             m_dNextFrame - floor(m_dNextFrame));
 
-    int read_failed_count = 0;
-    CSAMPLE floor_sample[2];
-    CSAMPLE ceil_sample[2];
-
-    floor_sample[0] = 0;
-    floor_sample[1] = 0;
-    ceil_sample[0] = 0;
-    ceil_sample[1] = 0;
+    // The input frames that are needed after the floor frame of a position
+    const SINT lookahead_frames = m_interpolation == Interpolation::Cubic ? 2 : 1;
+    unscaled_frames_needed += lookahead_frames - 1;
 
+    int read_failed_count = 0;
     SINT frames_read = 0;
-    SINT i = 0;
-    //int screwups_debug = 0;
 
-    double rate_add = fabs(rate_old);
+    const double rate_add = fabs(rate_old);
     const double rate_delta_abs =
             rate_old < 0 || rate_new < 0 ? -rate_delta : rate_delta;
+    PositionRamp ramp{m_dNextFrame, rate_add, rate_delta_abs / 2};
+    // The largest rate is at either end of the ramp
+    const double rate_max = math_max(rate_add,
+            rate_add + (bufferSizeFrames - 1) * rate_delta_abs);
 
-    // Hot frame loop
-    while (i < buf_size) {
-        // shift indices
-        m_dCurrentFrame = m_dNextFrame;
-
-        // Because our index is a float value, we're going to be interpolating
-        // between two samples, a lower (prev) and upper (cur) sample.
-        // If the lower sample is off the end of the buffer (values between
-        // -.999 and 0), load it from the saved globals.
-
-        // The first bounds check (< m_bufferIntSize) is probably not needed.
-
-        SINT currentFrameFloor = static_cast<SINT>(floor(m_dCurrentFrame));
-
-        if (currentFrameFloor < 0) {
-            // we have advanced to a new buffer in the previous run,
-            // but the floor still points to the old buffer
-            // so take the cached sample, this happens on slow rates
-            floor_sample[0] = m_floorSampleOld[0];
-            floor_sample[1] = m_floorSampleOld[1];
-            ceil_sample[0] = m_bufferInt[0];
-            ceil_sample[1] = m_bufferInt[1];
-        } else if (getOutputSignal().frames2samples(currentFrameFloor) + 3 < m_bufferIntSize) {
-            // take floor_sample form the buffer of the previous run
-            floor_sample[0] = m_bufferInt[getOutputSignal().frames2samples(currentFrameFloor)];
-            floor_sample[1] = m_bufferInt[getOutputSignal().frames2samples(currentFrameFloor) + 1];
-            ceil_sample[0] = m_bufferInt[getOutputSignal().frames2samples(currentFrameFloor) + 2];
-            ceil_sample[1] = m_bufferInt[getOutputSignal().frames2samples(currentFrameFloor) + 3];
-        } else {
-            // if we don't have the ceil_sample in buffer, load some more
-
-            if (getOutputSignal().frames2samples(currentFrameFloor) + 1 < m_bufferIntSize) {
-                // take floor_sample form the buffer of the previous run
-                floor_sample[0] = m_bufferInt[getOutputSignal().frames2samples(currentFrameFloor)];
-                floor_sample[1] = m_bufferInt[getOutputSignal().frames2samples(currentFrameFloor) + 1];
-            }
-
+    SINT i = 0;
+    while (i < bufferSizeFrames) {
+        double currentPosition = ramp.at(i);
+        // Positions are never more than lookahead_frames in front of the
+        // buffer, see below
+        int currentFrameFloor = floorPosition(currentPosition);
+        SINT bufferFrames = getOutputSignal().samples2frames(m_bufferIntSize);
+
+        if (currentFrameFloor + lookahead_frames >= bufferFrames) {
+            // if we don't have the following frames in buffer, load some more
             do {
-                SINT old_bufsize = m_bufferIntSize;
                 if (unscaled_frames_needed == 0) {
                     // protection against infinite loop
                     // This may happen due to double precision issues
@@ -285,10 +421,20 @@ SINT EngineBufferScaleLinear::do_scale(CSAMPLE* buf, SINT buf_size) {
                         kiLinearScaleReadAheadLength,
                         getOutputSignal().frames2samples(unscaled_frames_needed));
 
+                // Keep the last frames in front of the new ones
+                std::memmove(m_bufferIntWithHistory,
+                        m_bufferIntWithHistory + m_bufferIntSize,
+                        kHistorySamples * sizeof(CSAMPLE));
                 m_bufferIntSize = m_pReadAheadManager->getNextSamples(
                         rate_new == 0 ? rate_old : rate_new,
                         m_bufferInt, samples_to_read);
 
+                // adapt the position to the index of the new buffer
+                ramp.offset -= bufferFrames;
+                currentPosition = ramp.at(i);
+                currentFrameFloor = floorPosition(currentPosition);
+                bufferFrames = getOutputSignal().samples2frames(m_bufferIntSize);
+
                 if (m_bufferIntSize == 0) {
                     if (++read_failed_count > 1) {
                         break;
@@ -297,52 +443,44 @@ SINT EngineBufferScaleLinear::do_scale(CSAMPLE* buf, SINT buf_size) {
                     }
                 }
 
-                frames_read += getOutputSignal().samples2frames(m_bufferIntSize);
-                unscaled_frames_needed -= getOutputSignal().samples2frames(m_bufferIntSize);
-
-                // adapt the m_dCurrentFrame the index of the new buffer
-                m_dCurrentFrame -= getOutputSignal().samples2frames(old_bufsize);
-                currentFrameFloor = static_cast<SINT>(floor(m_dCurrentFrame));
-            } while (getOutputSignal().frames2samples(currentFrameFloor) + 3 >= m_bufferIntSize);
+                frames_read += bufferFrames;
+                unscaled_frames_needed -= bufferFrames;
+            } while (currentFrameFloor + lookahead_frames >= bufferFrames);
 
             // I guess?
             if (read_failed_count > 1) {
                 break;
             }
+        }
 
-            // Now that the buffer is up to date, we can get the value of the sample
-            // at the floor of our position.
-            if (currentFrameFloor >= 0) {
-                // the previous position is in the new buffer
-                floor_sample[0] = m_bufferInt[getOutputSignal().frames2samples(currentFrameFloor)];
-                floor_sample[1] = m_bufferInt[getOutputSignal().frames2samples(currentFrameFloor) + 1];
+        // The following output frames whose input frames are all in the
+        // buffer. The positions only increase, so all frames before the
+        // last one that fits also fit.
+        const SINT endFrame = bufferFrames - lookahead_frames;
+        SINT spanFrames = bufferSizeFrames - i;
+        if (rate_max > 0) {
+            const double estimate = ceil((endFrame - currentPosition) / rate_max);
+            if (estimate < spanFrames) {
+                spanFrames = math_max<SINT>(static_cast<SINT>(estimate), 1);
             }
-            ceil_sample[0] = m_bufferInt[getOutputSignal().frames2samples(currentFrameFloor) + 2];
-            ceil_sample[1] = m_bufferInt[getOutputSignal().frames2samples(currentFrameFloor) + 3];
+        }
+        while (spanFrames > 1 && ramp.at(i + spanFrames - 1) >= endFrame) {
+            --spanFrames;
         }
 
-        // For the current index, what percentage is it
-        // between the previous and the next?
-        CSAMPLE frac = static_cast<CSAMPLE>(m_dCurrentFrame) - currentFrameFloor;
-
-        // Perform linear interpolation
-        buf[i] = floor_sample[0] + frac * (ceil_sample[0] - floor_sample[0]);
-        buf[i + 1] = floor_sample[1] + frac * (ceil_sample[1] - floor_sample[1]);
-
-        m_floorSampleOld[0] = floor_sample[0];
-        m_floorSampleOld[1] = floor_sample[1];
-
-        // increment the index for the next loop
-        m_dNextFrame = m_dCurrentFrame + rate_add;
-
-        // Smooth any changes in the playback rate over one buf_size
-        // samples. This prevents the change from being discontinuous and helps
-        // improve sound quality.
-        rate_add += rate_delta_abs;
-        i += getOutputSignal().getChannelCount();
+        if (m_interpolation == Interpolation::Cubic) {
+            interpolateCubic(buf, m_bufferInt, ramp, i, i + spanFrames);
+        } else {
+            interpolateLinear(buf, m_bufferInt, ramp, i, i + spanFrames);
+        }
+        i += spanFrames;
     }
 
-    SampleUtil::clear(&buf[i], buf_size - i);
+    m_dCurrentFrame = ramp.at(math_max<SINT>(i - 1, 0));
+    m_dNextFrame = ramp.at(i);
+
+    SampleUtil::clear(&buf[getOutputSignal().frames2samples(i)],
+            buf_size - getOutputSignal().frames2samples(i));
 
     return frames_read;
 }
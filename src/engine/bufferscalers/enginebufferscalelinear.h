@@ -10,6 +10,14 @@ const int kiLinearScaleReadAheadLength = 10240;
 
 class EngineBufferScaleLinear : public EngineBufferScale  {
   public:
+    // How the output samples are interpolated between the input frames
+    enum class Interpolation {
+        Linear,
+        // 4-point Hermite, less aliasing at the cost of one more frame
+        // that is read ahead
+        Cubic,
+    };
+
     explicit EngineBufferScaleLinear(
             ReadAheadManager *pReadAheadManager);
     ~EngineBufferScaleLinear() override;
@@ -23,20 +31,33 @@ class EngineBufferScaleLinear : public EngineBufferScale  {
                             double* pTempoRatio,
                              double* pPitchRatio) override;
 
+    void setInterpolation(Interpolation interpolation) {
+        m_interpolation = interpolation;
+    }
+    Interpolation getInterpolation() const {
+        return m_interpolation;
+    }
+
   private:
     void onSampleRateChanged() override {}
 
     SINT do_scale(CSAMPLE* buf, SINT buf_size);
     SINT do_copy(CSAMPLE* buf, SINT buf_size);
 
+    // Stores the given frames in front of m_bufferInt, as if they were read
+    // before it. The first frame is the one directly in front.
+    void setHistory(const CSAMPLE* pFrames, SINT frames, SINT stride);
+
     // The read-ahead manager that we use to fetch samples
     ReadAheadManager* m_pReadAheadManager;
 
-    // Buffer for handling calls to ReadAheadManager
+    // Buffer for handling calls to ReadAheadManager, preceded by the last
+    // frames of the previous call for interpolating across calls
+    CSAMPLE* m_bufferIntWithHistory;
     CSAMPLE* m_bufferInt;
     SINT m_bufferIntSize;
 
-    CSAMPLE m_floorSampleOld[2];
+    Interpolation m_interpolation;
 
     bool m_bClear;
     double m_dRate;
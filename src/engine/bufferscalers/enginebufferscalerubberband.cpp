@@ -4,8 +4,9 @@
 
 #include <QtDebug>
 
+#include <cmath>
+
 #include "control/controlobject.h"
-#include "engine/readaheadmanager.h"
 #include "track/keyutils.h"
 #include "util/counter.h"
 #include "util/defs.h"
@@ -19,13 +20,46 @@ namespace {
 // This is the default increment from RubberBand 1.8.1.
 size_t kRubberBandBlockSize = 256;
 
+// The output frames that are rendered ahead of the play position in the
+// lookahead mode. Only buffers of up to half of them are rendered ahead,
+// larger ones do not need it.
+constexpr SINT kLookaheadFrames = 2048;
+// Enough for restarting a stretcher at the audible input frame after the
+// lookahead stretcher has consumed the input ahead of it, even at the
+// maximum input ratio
+constexpr SINT kInputHistoryFrames = 32768;
+// Input frames per output frame that are rendered ahead
+constexpr double kMinLookaheadRatio = 0.25;
+constexpr double kMaxLookaheadRatio = 2.0;
+// The input frames that are written to the worker at once
+constexpr SINT kFeedFrames = 1024;
+
 }  // namespace
 
 EngineBufferScaleRubberBand::EngineBufferScaleRubberBand(
-        ReadAheadManager* pReadAheadManager)
-        : m_pReadAheadManager(pReadAheadManager),
-          m_buffer_back(SampleUtil::alloc(MAX_BUFFER_LEN)),
-          m_bBackwards(false) {
+        ReadAheadManager* pReadAheadManager,
+        const QString& group)
+        : m_buffer_back(SampleUtil::alloc(MAX_BUFFER_LEN)),
+          m_bBackwards(false),
+          m_dTimeRatio(1.0),
+          m_dPitchScale(1.0),
+          m_inputHistory(pReadAheadManager, kInputHistoryFrames),
+          m_directInputPosition(0),
+          m_directAudiblePosition(0.0),
+          m_directDelayFrames(0),
+          m_directDiscardFrames(0),
+          m_worker(group),
+          m_workerBound(false),
+          m_lookaheadEnabled(false),
+          m_mode(Mode::Direct),
+          m_lookaheadInputStart(0),
+          m_lookaheadRatio(0.0),
+          m_lookaheadLatencyFrames(0),
+          m_lookaheadInputPosition(0),
+          m_lookaheadOutputFrames(0),
+          m_lookaheadParametersChanged(false),
+          m_lookahead_buffer(SampleUtil::alloc(MAX_BUFFER_LEN)),
+          m_stableFrames(0) {
     m_retrieve_buffer[0] = SampleUtil::alloc(MAX_BUFFER_LEN);
     m_retrieve_buffer[1] = SampleUtil::alloc(MAX_BUFFER_LEN);
     // Initialize the internal buffers to prevent re-allocations
@@ -34,9 +68,25 @@ EngineBufferScaleRubberBand::EngineBufferScaleRubberBand(
 }
 
 EngineBufferScaleRubberBand::~EngineBufferScaleRubberBand() {
+    // The worker might still use the lookahead stretcher
+    m_worker.quitWait();
     SampleUtil::free(m_buffer_back);
     SampleUtil::free(m_retrieve_buffer[0]);
     SampleUtil::free(m_retrieve_buffer[1]);
+    SampleUtil::free(m_lookahead_buffer);
+}
+
+void EngineBufferScaleRubberBand::bindWorker(
+        EngineWorkerScheduler* pWorkerScheduler) {
+    m_worker.setScheduler(pWorkerScheduler);
+    m_workerBound = true;
+}
+
+void EngineBufferScaleRubberBand::setLookaheadEnabled(bool enabled) {
+    if (enabled && m_workerBound && !m_worker.isRunning()) {
+        m_worker.start(QThread::HighPriority);
+    }
+    m_lookaheadEnabled.store(enabled);
 }
 
 void EngineBufferScaleRubberBand::setScaleParameters(double base_rate,
@@ -44,6 +94,7 @@ void EngineBufferScaleRubberBand::setScaleParameters(double base_rate,
                                                      double* pPitchRatio) {
     // Negative speed means we are going backwards. pitch does not affect
     // the playback direction.
+    const bool directionChanged = m_bBackwards != (*pTempoRatio < 0);
     m_bBackwards = *pTempoRatio < 0;
 
     // Due to a bug in RubberBand, setting the timeRatio to a large value can
@@ -67,6 +118,7 @@ void EngineBufferScaleRubberBand::setScaleParameters(double base_rate,
     if (pitchScale > 0) {
         //qDebug() << "EngineBufferScaleRubberBand setPitchScale" << *pitch << pitchScale;
         m_pRubberBand->setPitchScale(pitchScale);
+        m_dPitchScale = pitchScale;
     }
 
     // RubberBand handles checking for whether the change in timeRatio is a
@@ -77,6 +129,7 @@ void EngineBufferScaleRubberBand::setScaleParameters(double base_rate,
     if (timeRatioInverse > 0) {
         //qDebug() << "EngineBufferScaleRubberBand setTimeRatio" << 1 / timeRatioInverse;
         m_pRubberBand->setTimeRatio(1.0 / timeRatioInverse);
+        m_dTimeRatio = 1.0 / timeRatioInverse;
     }
 
     if (m_pRubberBand->getInputIncrement() == 0) {
@@ -90,10 +143,25 @@ void EngineBufferScaleRubberBand::setScaleParameters(double base_rate,
             timeRatioInverse += 0.001;
             m_pRubberBand->setTimeRatio(1.0 / timeRatioInverse);
         }
+        m_dTimeRatio = 1.0 / timeRatioInverse;
         speed_abs = timeRatioInverse / base_rate;
         *pTempoRatio = m_bBackwards ? -speed_abs : speed_abs;
     }
 
+    if (directionChanged ||
+            base_rate != m_dBaseRate ||
+            speed_abs != m_dTempoRatio ||
+            *pPitchRatio != m_dPitchRatio) {
+        m_stableFrames = 0;
+        if (m_mode == Mode::Warmup) {
+            // The stretcher of the audio callback is still in use
+            stopLookahead();
+        } else if (m_mode == Mode::Lookahead) {
+            // Falls back when scaling the next buffer
+            m_lookaheadParametersChanged = true;
+        }
+    }
+
     // Used by other methods so we need to keep them up to date.
     m_dBaseRate = base_rate;
     m_dTempoRatio = speed_abs;
@@ -104,20 +172,15 @@ void EngineBufferScaleRubberBand::onSampleRateChanged() {
     // TODO: Resetting the sample rate will cause internal
     // memory allocations that may block the real-time thread.
     // When is this function actually invoked??
+    if (m_mode != Mode::Direct) {
+        stopLookahead();
+    }
+    // The lookahead stretcher is replaced by tryStartWarmup()
     if (!getOutputSignal().isValid()) {
         m_pRubberBand.reset();
         return;
     }
-    m_pRubberBand = std::make_unique<RubberBandStretcher>(
-            getOutputSignal().getSampleRate(),
-            getOutputSignal().getChannelCount(),
-            RubberBandStretcher::OptionProcessRealTime);
-    m_pRubberBand->setMaxProcessSize(kRubberBandBlockSize);
-    // Setting the time ratio to a very high value will cause RubberBand
-    // to preallocate buffers large enough to (almost certainly)
-    // avoid memory reallocations during playback.
-    m_pRubberBand->setTimeRatio(2.0);
-    m_pRubberBand->setTimeRatio(1.0);
+    m_pRubberBand = RubberBandWorker::createStretcher(getOutputSignal());
 }
 
 void EngineBufferScaleRubberBand::clear() {
@@ -125,6 +188,17 @@ void EngineBufferScaleRubberBand::clear() {
         return;
     }
     m_pRubberBand->reset();
+
+    if (m_mode != Mode::Direct) {
+        stopLookahead();
+    }
+    m_inputHistory.clear();
+    m_directInputPosition = 0;
+    m_directAudiblePosition = 0.0;
+    // The output starts delayed by the latency like before
+    m_directDelayFrames = m_pRubberBand->getLatency();
+    m_directDiscardFrames = 0;
+    m_stableFrames = 0;
 }
 
 SINT EngineBufferScaleRubberBand::retrieveAndDeinterleave(
@@ -152,6 +226,24 @@ void EngineBufferScaleRubberBand::deinterleaveAndProcess(
                            frames, flush);
 }
 
+void EngineBufferScaleRubberBand::discardLatency() {
+    while (m_directDiscardFrames > 0) {
+        const SINT frames = math_min(
+                math_min(m_directDiscardFrames,
+                        static_cast<SINT>(m_pRubberBand->available())),
+                static_cast<SINT>(MAX_BUFFER_LEN));
+        if (frames <= 0) {
+            return;
+        }
+        const SINT discardedFrames = m_pRubberBand->retrieve(
+                (float* const*)m_retrieve_buffer, frames);
+        if (discardedFrames <= 0) {
+            return;
+        }
+        m_directDiscardFrames -= discardedFrames;
+    }
+}
+
 double EngineBufferScaleRubberBand::scaleBuffer(
         CSAMPLE* pOutputBuffer,
         SINT iOutputBufferSize) {
@@ -162,20 +254,73 @@ double EngineBufferScaleRubberBand::scaleBuffer(
         return 0.0;
     }
 
+    const SINT frames = getOutputSignal().samples2frames(iOutputBufferSize);
+    const bool lookaheadEnabled = m_lookaheadEnabled.load(std::memory_order_relaxed);
     SINT total_received_frames = 0;
-    SINT total_read_frames = 0;
+    if (m_mode == Mode::Lookahead) {
+        if (m_lookaheadParametersChanged || !lookaheadEnabled) {
+            total_received_frames = fallBackToDirect(pOutputBuffer, frames);
+        } else {
+            total_received_frames = scaleLookahead(pOutputBuffer, frames);
+        }
+    } else {
+        if (m_mode == Mode::Warmup && !lookaheadEnabled) {
+            stopLookahead();
+        }
+        const double directPosition = m_directAudiblePosition;
+        total_received_frames = scaleDirect(pOutputBuffer, frames);
+        if (m_mode == Mode::Warmup) {
+            feedLookahead(m_directAudiblePosition);
+            if (total_received_frames == frames) {
+                tryFinishWarmup(pOutputBuffer, frames, directPosition);
+            }
+        } else {
+            m_stableFrames += frames;
+            tryStartWarmup(frames);
+        }
+    }
 
-    SINT remaining_frames = getOutputSignal().samples2frames(iOutputBufferSize);
+    if (total_received_frames < frames) {
+        SampleUtil::clear(
+                pOutputBuffer + getOutputSignal().frames2samples(total_received_frames),
+                getOutputSignal().frames2samples(frames - total_received_frames));
+        Counter counter("EngineBufferScaleRubberBand::getScaled underflow");
+        counter.increment();
+    }
+
+    // framesRead is interpreted as the total number of virtual sample frames
+    // consumed to produce the scaled buffer. Due to this, we do not take into
+    // account directionality or starting point.
+    // NOTE(rryan): Why no m_dPitchAdjust here? Pitch does not change the time
+    // ratio. m_dSpeedAdjust is the ratio of unstretched time to stretched
+    // time. So, if we used total_received_frames in stretched time, then
+    // multiplying that by the ratio of unstretched time to stretched time
+    // will get us the unstretched sample frames read.
+    double framesRead = m_dBaseRate * m_dTempoRatio * total_received_frames;
+
+    return framesRead;
+}
+
+SINT EngineBufferScaleRubberBand::scaleDirect(
+        CSAMPLE* pOutputBuffer,
+        SINT frames) {
+    SINT total_received_frames = 0;
+
+    SINT remaining_frames = frames;
     CSAMPLE* read = pOutputBuffer;
     bool last_read_failed = false;
     bool break_out_after_retrieve_and_reset_rubberband = false;
     while (remaining_frames > 0) {
+        // After a restart, the output that is delayed by the latency is
+        // dropped before retrieving any frames
+        discardLatency();
         // ReadAheadManager will eventually read the requested frames with
         // enough calls to retrieveAndDeinterleave because CachingReader returns
         // zeros for reads that are not in cache. So it's safe to loop here
         // without any checks for failure in retrieveAndDeinterleave.
-        SINT received_frames = retrieveAndDeinterleave(
-                read, remaining_frames);
+        SINT received_frames = m_directDiscardFrames > 0
+                ? 0
+                : retrieveAndDeinterleave(read, remaining_frames);
         remaining_frames -= received_frames;
         total_received_frames += received_frames;
         read += getOutputSignal().frames2samples(received_frames);
@@ -185,6 +330,7 @@ double EngineBufferScaleRubberBand::scaleBuffer(
             // If we break out early then we have flushed RubberBand and need to
             // reset it.
             m_pRubberBand->reset();
+            m_directDelayFrames = m_pRubberBand->getLatency();
             break;
         }
 
@@ -203,17 +349,14 @@ double EngineBufferScaleRubberBand::scaleBuffer(
         //qDebug() << "iLenFramesRequired" << iLenFramesRequired;
 
         if (remaining_frames > 0 && iLenFramesRequired > 0) {
-            SINT iAvailSamples = m_pReadAheadManager->getNextSamples(
-                        // The value doesn't matter here. All that matters is we
-                        // are going forward or backward.
-                        (m_bBackwards ? -1.0 : 1.0) * m_dBaseRate * m_dTempoRatio,
-                        m_buffer_back,
-                        getOutputSignal().frames2samples(iLenFramesRequired));
-            SINT iAvailFrames = getOutputSignal().samples2frames(iAvailSamples);
+            SINT iAvailFrames = m_inputHistory.read(
+                    &m_directInputPosition,
+                    m_buffer_back,
+                    static_cast<SINT>(iLenFramesRequired),
+                    readAheadRate());
 
             if (iAvailFrames > 0) {
                 last_read_failed = false;
-                total_read_frames += iAvailFrames;
                 deinterleaveAndProcess(m_buffer_back, iAvailFrames, false);
             } else {
                 if (last_read_failed) {
@@ -228,21 +371,176 @@ double EngineBufferScaleRubberBand::scaleBuffer(
         }
     }
 
-    if (remaining_frames > 0) {
-        SampleUtil::clear(read, getOutputSignal().frames2samples(remaining_frames));
-        Counter counter("EngineBufferScaleRubberBand::getScaled underflow");
+    // The output frames that are delayed by the latency after a seek
+    // do not advance the audible input position
+    const SINT delayedFrames = math_min(total_received_frames, m_directDelayFrames);
+    m_directDelayFrames -= delayedFrames;
+    m_directAudiblePosition += (total_received_frames - delayedFrames) * inputRatio();
+    return total_received_frames;
+}
+
+SINT EngineBufferScaleRubberBand::scaleLookahead(
+        CSAMPLE* pOutputBuffer,
+        SINT frames) {
+    FIFO<CSAMPLE>* pOutputFifo = m_worker.outputFifo();
+    if (pOutputFifo->readAvailable() < getOutputSignal().frames2samples(frames)) {
+        // The worker did not keep up
+        Counter counter("EngineBufferScaleRubberBand::lookahead underrun");
         counter.increment();
+        return fallBackToDirect(pOutputBuffer, frames);
     }
+    pOutputFifo->read(pOutputBuffer, getOutputSignal().frames2samples(frames));
+    m_lookaheadOutputFrames += frames;
+    feedLookahead(lookaheadPosition());
+    return frames;
+}
 
-    // framesRead is interpreted as the total number of virtual sample frames
-    // consumed to produce the scaled buffer. Due to this, we do not take into
-    // account directionality or starting point.
-    // NOTE(rryan): Why no m_dPitchAdjust here? Pitch does not change the time
-    // ratio. m_dSpeedAdjust is the ratio of unstretched time to stretched
-    // time. So, if we used total_received_frames in stretched time, then
-    // multiplying that by the ratio of unstretched time to stretched time
-    // will get us the unstretched sample frames read.
-    double framesRead = m_dBaseRate * m_dTempoRatio * total_received_frames;
+SINT EngineBufferScaleRubberBand::fallBackToDirect(
+        CSAMPLE* pOutputBuffer,
+        SINT frames) {
+    const double position = lookaheadPosition();
+    // The output that has already been rendered ahead fades out
+    FIFO<CSAMPLE>* pOutputFifo = m_worker.outputFifo();
+    const SINT fadeOutFrames = math_min(frames,
+            getOutputSignal().samples2frames(pOutputFifo->readAvailable()));
+    if (fadeOutFrames > 0) {
+        pOutputFifo->read(m_lookahead_buffer,
+                getOutputSignal().frames2samples(fadeOutFrames));
+    }
+    stopLookahead();
 
-    return framesRead;
+    // Restart at the input frame that is audible next. This processes
+    // the input for the latency of the stretcher at once.
+    m_pRubberBand->reset();
+    m_directInputPosition = math_max(m_inputHistory.oldest(),
+            static_cast<SINT>(std::round(position)));
+    m_directAudiblePosition = m_directInputPosition;
+    m_directDelayFrames = 0;
+    m_directDiscardFrames = m_pRubberBand->getLatency();
+    const SINT receivedFrames = scaleDirect(pOutputBuffer, frames);
+    if (fadeOutFrames == frames && receivedFrames == frames) {
+        SampleUtil::linearCrossfadeBuffersIn(pOutputBuffer,
+                m_lookahead_buffer,
+                getOutputSignal().frames2samples(frames));
+    }
+    return receivedFrames;
+}
+
+void EngineBufferScaleRubberBand::stopLookahead() {
+    // The worker hands the stretcher back asynchronously, and the
+    // lookahead mode is only entered again after it did
+    m_worker.requestStop();
+    m_mode = Mode::Direct;
+    m_lookaheadParametersChanged = false;
+}
+
+void EngineBufferScaleRubberBand::tryStartWarmup(SINT frames) {
+    if (!m_lookaheadEnabled.load(std::memory_order_relaxed) ||
+            !m_workerBound ||
+            frames > kLookaheadFrames / 2 ||
+            m_stableFrames < getOutputSignal().getSampleRate() / 4 ||
+            // Only when the audible input position is exact
+            m_directDelayFrames > 0 ||
+            m_directDiscardFrames > 0 ||
+            !m_worker.isIdle()) {
+        return;
+    }
+    const double ratio = inputRatio();
+    if (ratio < kMinLookaheadRatio || ratio > kMaxLookaheadRatio) {
+        return;
+    }
+    const mixxx::audio::SampleRate sampleRate = getOutputSignal().getSampleRate();
+    if (!m_pLookaheadStretcher ||
+            m_pLookaheadStretcher->sampleRate != sampleRate) {
+        // The worker creates the stretcher for the current sample rate,
+        // warming up is tried again after it is ready
+        auto pStretcher = m_worker.takeStretcher(sampleRate);
+        if (!pStretcher) {
+            return;
+        }
+        m_worker.retireStretcher(std::move(m_pLookaheadStretcher));
+        m_pLookaheadStretcher = std::move(pStretcher);
+    }
+    RubberBandStretcher* pLookaheadRubberBand =
+            m_pLookaheadStretcher->pStretcher.get();
+
+    m_worker.flushFifos();
+    pLookaheadRubberBand->reset();
+    pLookaheadRubberBand->setTimeRatio(m_dTimeRatio);
+    pLookaheadRubberBand->setPitchScale(m_dPitchScale);
+    // Starts at the input frame that is audible next. The output of the
+    // stretcher of the audio callback is still used until the lookahead
+    // has caught up.
+    m_lookaheadInputStart = math_max(m_inputHistory.oldest(),
+            static_cast<SINT>(std::round(m_directAudiblePosition)));
+    m_lookaheadInputPosition = m_lookaheadInputStart;
+    m_lookaheadRatio = ratio;
+    m_lookaheadLatencyFrames = pLookaheadRubberBand->getLatency();
+    m_lookaheadOutputFrames = 0;
+    m_lookaheadParametersChanged = false;
+    m_mode = Mode::Warmup;
+    m_worker.startProcessing(
+            pLookaheadRubberBand, m_lookaheadLatencyFrames);
+    feedLookahead(m_directAudiblePosition);
+}
+
+void EngineBufferScaleRubberBand::tryFinishWarmup(
+        CSAMPLE* pOutputBuffer,
+        SINT frames,
+        double directPosition) {
+    // The output frame of the lookahead stretcher at the input position
+    // where this buffer started
+    const SINT startFrame = static_cast<SINT>(std::round(
+            (directPosition - m_lookaheadInputStart) / m_lookaheadRatio));
+    FIFO<CSAMPLE>* pOutputFifo = m_worker.outputFifo();
+    // Drop the output that has already been played from the other
+    // stretcher, otherwise the FIFO fills up
+    const SINT skipFrames = math_min(startFrame - m_lookaheadOutputFrames,
+            getOutputSignal().samples2frames(pOutputFifo->readAvailable()));
+    if (skipFrames > 0) {
+        pOutputFifo->flushReadData(getOutputSignal().frames2samples(skipFrames));
+        m_lookaheadOutputFrames += skipFrames;
+    }
+    if (m_lookaheadOutputFrames != startFrame ||
+            getOutputSignal().samples2frames(pOutputFifo->readAvailable()) <
+                    frames + kLookaheadFrames / 2) {
+        // Not caught up yet
+        return;
+    }
+    pOutputFifo->read(m_lookahead_buffer, getOutputSignal().frames2samples(frames));
+    m_lookaheadOutputFrames += frames;
+    SampleUtil::linearCrossfadeBuffersOut(pOutputBuffer,
+            m_lookahead_buffer,
+            getOutputSignal().frames2samples(frames));
+    m_mode = Mode::Lookahead;
+}
+
+void EngineBufferScaleRubberBand::feedLookahead(double audiblePosition) {
+    // Keep the input for the lookahead and the latency of the
+    // stretcher ahead of the audible position
+    const SINT targetPosition = static_cast<SINT>(audiblePosition +
+                                        (kLookaheadFrames + m_lookaheadLatencyFrames) *
+                                                m_lookaheadRatio) +
+            static_cast<SINT>(kRubberBandBlockSize);
+    FIFO<CSAMPLE>* pInputFifo = m_worker.inputFifo();
+    while (m_lookaheadInputPosition < targetPosition) {
+        const SINT frames = math_min(targetPosition - m_lookaheadInputPosition,
+                math_min(kFeedFrames,
+                        getOutputSignal().samples2frames(
+                                pInputFifo->writeAvailable())));
+        if (frames <= 0) {
+            break;
+        }
+        const SINT readFrames = m_inputHistory.read(
+                &m_lookaheadInputPosition, m_buffer_back, frames, readAheadRate());
+        pInputFifo->write(m_buffer_back, getOutputSignal().frames2samples(readFrames));
+        if (readFrames < frames) {
+            break;
+        }
+    }
+    m_worker.workReady();
+}
+
+double EngineBufferScaleRubberBand::lookaheadPosition() const {
+    return m_lookaheadInputStart + m_lookaheadOutputFrames * m_lookaheadRatio;
 }
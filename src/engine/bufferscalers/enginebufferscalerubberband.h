@@ -1,21 +1,42 @@
 #ifndef ENGINEBUFFERSCALERUBBERBAND_H
 #define ENGINEBUFFERSCALERUBBERBAND_H
 
+#include <atomic>
+
 #include "engine/bufferscalers/enginebufferscale.h"
+#include "engine/bufferscalers/rubberbandworker.h"
+#include "engine/bufferscalers/scaleinputhistory.h"
 #include "util/memory.h"
 
 namespace RubberBand {
 class RubberBandStretcher;
 }  // namespace RubberBand
 
+class EngineWorkerScheduler;
 class ReadAheadManager;
 
 // Uses librubberband to scale audio.  This class is not thread safe.
+//
+// In the lookahead mode a second stretcher renders the output ahead of the
+// play position on a RubberBandWorker while the scale parameters are
+// stable, and the audio callback only copies the rendered frames. Any
+// change of the parameters, a seek or an underrun of the worker falls back
+// to processing in the audio callback. The stretchers are switched with a
+// short crossfade at the same input position, which is tracked in the
+// ScaleInputHistory that both stretchers read from.
+//
+// In the lookahead mode the input is read from the ReadAheadManager up to
+// 2048 output frames plus the latency of the stretcher ahead of the play
+// position, i.e. about 46 ms plus the latency at 44.1 kHz. Loops are taken
+// by the ReadAheadManager while reading, so moving the loop out point into
+// the input that has already been read only takes effect after that input
+// has been played. Seeks clear the scaler and are not delayed.
 class EngineBufferScaleRubberBand : public EngineBufferScale {
     Q_OBJECT
   public:
     explicit EngineBufferScaleRubberBand(
-            ReadAheadManager* pReadAheadManager);
+            ReadAheadManager* pReadAheadManager,
+            const QString& group);
     ~EngineBufferScaleRubberBand() override;
 
     void setScaleParameters(double base_rate,
@@ -29,15 +50,48 @@ class EngineBufferScaleRubberBand : public EngineBufferScale {
     // Flush buffer.
     void clear() override;
 
+    void bindWorker(EngineWorkerScheduler* pWorkerScheduler);
+    // Not invoked from the engine thread, starts the worker when enabled
+    // for the first time.
+    void setLookaheadEnabled(bool enabled);
+
   private:
+    enum class Mode {
+        // Only the stretcher of the audio callback is used
+        Direct,
+        // The worker renders ahead, but its output is not used yet
+        Warmup,
+        // The output is rendered by the worker
+        Lookahead,
+    };
+
     // Reset RubberBand library with new audio signal
     void onSampleRateChanged() override;
 
     void deinterleaveAndProcess(const CSAMPLE* pBuffer, SINT frames, bool flush);
     SINT retrieveAndDeinterleave(CSAMPLE* pBuffer, SINT frames);
+    void discardLatency();
+
+    // The input frames per output frame
+    double inputRatio() const {
+        return m_dBaseRate * m_dTempoRatio;
+    }
+    double readAheadRate() const {
+        // The value doesn't matter here. All that matters is we
+        // are going forward or backward.
+        return (m_bBackwards ? -1.0 : 1.0) * inputRatio();
+    }
 
-    // The read-ahead manager that we use to fetch samples
-    ReadAheadManager* m_pReadAheadManager;
+    SINT scaleDirect(CSAMPLE* pOutputBuffer, SINT frames);
+    SINT scaleLookahead(CSAMPLE* pOutputBuffer, SINT frames);
+    SINT fallBackToDirect(CSAMPLE* pOutputBuffer, SINT frames);
+    void stopLookahead();
+    void tryStartWarmup(SINT frames);
+    void tryFinishWarmup(CSAMPLE* pOutputBuffer, SINT frames,
+            double directPosition);
+    void feedLookahead(double audiblePosition);
+    // The input position of the output frame that is audible next
+    double lookaheadPosition() const;
 
     std::unique_ptr<RubberBand::RubberBandStretcher> m_pRubberBand;
 
@@ -46,6 +100,48 @@ class EngineBufferScaleRubberBand : public EngineBufferScale {
 
     // Holds the playback direction
     bool m_bBackwards;
+
+    // The parameters of m_pRubberBand, for starting the lookahead
+    // stretcher with the same ones
+    double m_dTimeRatio;
+    double m_dPitchScale;
+
+    // Both stretchers read their input from the read-ahead manager
+    // through here
+    ScaleInputHistory m_inputHistory;
+    // The next input frame of m_pRubberBand
+    SINT m_directInputPosition;
+    // The input frame of the output frame of m_pRubberBand that is
+    // audible next
+    double m_directAudiblePosition;
+    // Output frames of m_pRubberBand after a seek that are delayed by its
+    // latency and do not advance m_directAudiblePosition
+    SINT m_directDelayFrames;
+    // Output frames of m_pRubberBand that are dropped to compensate its
+    // latency after it has been restarted at m_directAudiblePosition
+    SINT m_directDiscardFrames;
+
+    // Created and destroyed by the worker
+    std::unique_ptr<RubberBandWorker::Stretcher> m_pLookaheadStretcher;
+    RubberBandWorker m_worker;
+    bool m_workerBound;
+    std::atomic<bool> m_lookaheadEnabled;
+    Mode m_mode;
+    // The lookahead stretcher starts at this input frame and its output
+    // frames are counted from there with a constant ratio
+    SINT m_lookaheadInputStart;
+    double m_lookaheadRatio;
+    SINT m_lookaheadLatencyFrames;
+    // The next input frame that is written to the worker
+    SINT m_lookaheadInputPosition;
+    // The output frames that have been read from the worker
+    SINT m_lookaheadOutputFrames;
+    bool m_lookaheadParametersChanged;
+    CSAMPLE* m_lookahead_buffer;
+    // Output frames since the scale parameters have changed
+    SINT m_stableFrames;
+
+    friend class EngineBufferScaleRubberBandTest;
 };
 
 
@@ -0,0 +1,223 @@
+#include "engine/bufferscalers/rubberbandworker.h"
+
+#include <rubberband/RubberBandStretcher.h>
+
+#include "util/assert.h"
+#include "util/event.h"
+#include "util/math.h"
+#include "util/sample.h"
+
+namespace {
+
+constexpr SINT kChannelCount = 2;
+
+// The maximum number of frames that are processed or retrieved at once.
+// RubberBand requires input in small blocks anyway.
+constexpr SINT kBlockFrames = 1024;
+
+// This is the default increment from RubberBand 1.8.1.
+constexpr SINT kRubberBandBlockSize = 256;
+
+} // anonymous namespace
+
+// static
+std::unique_ptr<RubberBand::RubberBandStretcher> RubberBandWorker::createStretcher(
+        const mixxx::audio::SignalInfo& signal) {
+    auto pStretcher = std::make_unique<RubberBand::RubberBandStretcher>(
+            signal.getSampleRate(),
+            signal.getChannelCount(),
+            RubberBand::RubberBandStretcher::OptionProcessRealTime);
+    pStretcher->setMaxProcessSize(kRubberBandBlockSize);
+    // Setting the time ratio to a very high value will cause RubberBand
+    // to preallocate buffers large enough to (almost certainly)
+    // avoid memory reallocations during playback.
+    pStretcher->setTimeRatio(2.0);
+    pStretcher->setTimeRatio(1.0);
+    return pStretcher;
+}
+
+RubberBandWorker::RubberBandWorker(const QString& group)
+        : m_tag(QString("RubberBandWorker %1").arg(group)),
+          m_state(State::Idle),
+          m_stop(false),
+          m_pStretcher(nullptr),
+          m_discardFrames(0),
+          m_requestedSampleRate(0),
+          m_pPreparedStretcher(nullptr),
+          m_pRetiredStretcher(nullptr),
+          m_inputFifo(kChannelCount * kInputFifoFrames),
+          m_outputFifo(kChannelCount * kOutputFifoFrames),
+          m_pInterleaved(SampleUtil::alloc(kChannelCount * kBlockFrames)) {
+    m_pChannels[0] = SampleUtil::alloc(kBlockFrames);
+    m_pChannels[1] = SampleUtil::alloc(kBlockFrames);
+}
+
+RubberBandWorker::~RubberBandWorker() {
+    delete m_pPreparedStretcher.load();
+    delete m_pRetiredStretcher.load();
+    SampleUtil::free(m_pInterleaved);
+    SampleUtil::free(m_pChannels[0]);
+    SampleUtil::free(m_pChannels[1]);
+}
+
+std::unique_ptr<RubberBandWorker::Stretcher> RubberBandWorker::takeStretcher(
+        mixxx::audio::SampleRate sampleRate) {
+    std::unique_ptr<Stretcher> pStretcher(
+            m_pPreparedStretcher.exchange(nullptr, std::memory_order_acquire));
+    if (pStretcher && pStretcher->sampleRate == sampleRate) {
+        return pStretcher;
+    }
+    if (pStretcher) {
+        // Created for a previous sample rate
+        retireStretcher(std::move(pStretcher));
+    }
+    m_requestedSampleRate.store(sampleRate, std::memory_order_relaxed);
+    workReady();
+    return nullptr;
+}
+
+void RubberBandWorker::retireStretcher(std::unique_ptr<Stretcher> pStretcher) {
+    if (!pStretcher) {
+        return;
+    }
+    Stretcher* pPending = m_pRetiredStretcher.exchange(
+            pStretcher.release(), std::memory_order_release);
+    // The worker destroys the retired stretcher before it prepares the
+    // next one that can be taken.
+    DEBUG_ASSERT(!pPending);
+    Q_UNUSED(pPending);
+}
+
+void RubberBandWorker::startProcessing(
+        RubberBand::RubberBandStretcher* pStretcher,
+        SINT discardFrames) {
+    VERIFY_OR_DEBUG_ASSERT(isIdle()) {
+        return;
+    }
+    m_pStretcher = pStretcher;
+    m_discardFrames = discardFrames;
+    m_state.store(State::Running, std::memory_order_release);
+    workReady();
+}
+
+void RubberBandWorker::requestStop() {
+    State expected = State::Running;
+    if (m_state.compare_exchange_strong(expected, State::Stopping)) {
+        // Wake up the worker for acknowledging the stop, even if
+        // there is nothing to process
+        workReady();
+    }
+}
+
+void RubberBandWorker::flushFifos() {
+    VERIFY_OR_DEBUG_ASSERT(isIdle()) {
+        return;
+    }
+    m_inputFifo.flushReadData(m_inputFifo.readAvailable());
+    m_outputFifo.flushReadData(m_outputFifo.readAvailable());
+}
+
+void RubberBandWorker::run() {
+    QThread::currentThread()->setObjectName(m_tag);
+
+    while (!m_stop.load()) {
+        m_semaRun.acquire();
+        if (m_stop.load()) {
+            break;
+        }
+        runIteration();
+    }
+}
+
+void RubberBandWorker::runIteration() {
+    prepareStretcher();
+    if (m_state.load(std::memory_order_acquire) == State::Running) {
+        Event::start(m_tag);
+        process();
+        Event::end(m_tag);
+    }
+    // Hand the stretcher and the FIFOs back to the engine thread. Only
+    // the worker leaves the Stopping state.
+    if (m_state.load(std::memory_order_acquire) == State::Stopping) {
+        m_pStretcher = nullptr;
+        m_state.store(State::Idle, std::memory_order_release);
+    }
+}
+
+void RubberBandWorker::quitWait() {
+    m_stop = true;
+    m_semaRun.release();
+    wait();
+}
+
+void RubberBandWorker::prepareStretcher() {
+    delete m_pRetiredStretcher.exchange(nullptr, std::memory_order_acquire);
+    if (m_pPreparedStretcher.load(std::memory_order_acquire)) {
+        // Not taken yet
+        return;
+    }
+    const auto sampleRate = mixxx::audio::SampleRate(
+            m_requestedSampleRate.exchange(0, std::memory_order_relaxed));
+    if (!sampleRate.isValid()) {
+        return;
+    }
+    auto pStretcher = std::make_unique<Stretcher>();
+    pStretcher->pStretcher = createStretcher(mixxx::audio::SignalInfo(
+            mixxx::audio::ChannelCount(kChannelCount), sampleRate));
+    pStretcher->sampleRate = sampleRate;
+    m_pPreparedStretcher.store(pStretcher.release(), std::memory_order_release);
+}
+
+void RubberBandWorker::process() {
+    DEBUG_ASSERT(m_pStretcher);
+    while (m_state.load(std::memory_order_acquire) == State::Running) {
+        const SINT availableFrames = m_pStretcher->available();
+        if (availableFrames > 0) {
+            // The discarded frames are retrieved separately, because
+            // the output FIFO might not have room for them
+            const SINT writableFrames = m_discardFrames > 0
+                    ? m_discardFrames
+                    : m_outputFifo.writeAvailable() / kChannelCount;
+            const SINT frames = math_min(availableFrames,
+                    math_min(writableFrames, kBlockFrames));
+            if (frames <= 0) {
+                // Continued after the engine thread has read output frames
+                return;
+            }
+            writeOutput(frames);
+            continue;
+        }
+
+        SINT requiredFrames = m_pStretcher->getSamplesRequired();
+        if (requiredFrames == 0) {
+            // Same workaround as in EngineBufferScaleRubberBand
+            requiredFrames = kRubberBandBlockSize;
+        }
+        requiredFrames = math_min(requiredFrames, kBlockFrames);
+        if (m_inputFifo.readAvailable() < kChannelCount * requiredFrames) {
+            // Continued after the engine thread has written input frames
+            return;
+        }
+        m_inputFifo.read(m_pInterleaved, kChannelCount * requiredFrames);
+        SampleUtil::deinterleaveBuffer(
+                m_pChannels[0], m_pChannels[1], m_pInterleaved, requiredFrames);
+        m_pStretcher->process(
+                (const float* const*)m_pChannels, requiredFrames, false);
+    }
+}
+
+void RubberBandWorker::writeOutput(SINT frames) {
+    const SINT retrievedFrames = m_pStretcher->retrieve(
+            (float* const*)m_pChannels, frames);
+    const SINT discardFrames = math_min(m_discardFrames, retrievedFrames);
+    m_discardFrames -= discardFrames;
+    const SINT outputFrames = retrievedFrames - discardFrames;
+    if (outputFrames <= 0) {
+        return;
+    }
+    SampleUtil::interleaveBuffer(m_pInterleaved,
+            m_pChannels[0] + discardFrames,
+            m_pChannels[1] + discardFrames,
+            outputFrames);
+    m_outputFifo.write(m_pInterleaved, kChannelCount * outputFrames);
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <QString>
+
+#include <atomic>
+#include <memory>
+
+#include "audio/signalinfo.h"
+#include "engine/engineworker.h"
+#include "util/class.h"
+#include "util/fifo.h"
+#include "util/types.h"
+
+namespace RubberBand {
+class RubberBandStretcher;
+}  // namespace RubberBand
+
+// Runs a RubberBandStretcher ahead of the play position for
+// EngineBufferScaleRubberBand. The engine thread writes the interleaved
+// input frames into the input FIFO and reads the stretched output frames
+// from the output FIFO. The worker is woken after the audio callback like
+// the other EngineWorkers and processes until the output FIFO is full or
+// the input FIFO is empty.
+//
+// The stretcher and both FIFOs are owned by the worker while it is
+// running. The engine thread only touches the stretcher or flushes the
+// FIFOs after a requested stop has been acknowledged, i.e. isIdle()
+// returns true. The engine thread never waits for the worker.
+//
+// Creating a stretcher allocates and sets up FFTs, so the stretchers for
+// the lookahead are created and destroyed by the worker as well. They are
+// handed over to the engine thread and back through atomic pointers.
+class RubberBandWorker : public EngineWorker {
+    Q_OBJECT
+  public:
+    // The capacities of the FIFOs in stereo frames
+    static constexpr SINT kInputFifoFrames = 8192;
+    static constexpr SINT kOutputFifoFrames = 4096;
+
+    // A stereo stretcher and the sample rate it has been created for
+    struct Stretcher {
+        std::unique_ptr<RubberBand::RubberBandStretcher> pStretcher;
+        mixxx::audio::SampleRate sampleRate;
+    };
+
+    // Creates a real-time stretcher with preallocated buffers. Allocates!
+    static std::unique_ptr<RubberBand::RubberBandStretcher> createStretcher(
+            const mixxx::audio::SignalInfo& signal);
+
+    explicit RubberBandWorker(const QString& group);
+    ~RubberBandWorker() override;
+
+    // Engine thread. Returns the stretcher that has been created for the
+    // sample rate or requests it from the worker and returns nullptr.
+    std::unique_ptr<Stretcher> takeStretcher(
+            mixxx::audio::SampleRate sampleRate);
+    // Engine thread. The stretcher is destroyed by the worker. At most one
+    // stretcher is retired for each stretcher that has been taken.
+    void retireStretcher(std::unique_ptr<Stretcher> pStretcher);
+
+    // Engine thread, only while idle. Starts processing with the given
+    // stretcher that has been reset. The first discardFrames output frames
+    // are dropped to compensate the latency of the stretcher.
+    void startProcessing(RubberBand::RubberBandStretcher* pStretcher,
+            SINT discardFrames);
+    // Engine thread. Processing stops after the current iteration.
+    void requestStop();
+    bool isIdle() const {
+        return m_state.load(std::memory_order_acquire) == State::Idle;
+    }
+
+    // Engine thread, only while idle
+    void flushFifos();
+
+    // The engine thread is the writer
+    FIFO<CSAMPLE>* inputFifo() {
+        return &m_inputFifo;
+    }
+    // The engine thread is the reader
+    FIFO<CSAMPLE>* outputFifo() {
+        return &m_outputFifo;
+    }
+
+    void run() override;
+    void quitWait();
+
+  private:
+    enum class State {
+        Idle,
+        Running,
+        Stopping,
+    };
+
+    // Everything the worker does after it has been woken up
+    void runIteration();
+    // Destroys the retired stretcher and creates the requested one
+    void prepareStretcher();
+    void process();
+    void writeOutput(SINT frames);
+
+    const QString m_tag;
+    std::atomic<State> m_state;
+    std::atomic<bool> m_stop;
+
+    RubberBand::RubberBandStretcher* m_pStretcher;
+    SINT m_discardFrames;
+
+    std::atomic<mixxx::audio::SampleRate::value_t> m_requestedSampleRate;
+    std::atomic<Stretcher*> m_pPreparedStretcher;
+    std::atomic<Stretcher*> m_pRetiredStretcher;
+
+    FIFO<CSAMPLE> m_inputFifo;
+    FIFO<CSAMPLE> m_outputFifo;
+    CSAMPLE* m_pInterleaved;
+    CSAMPLE* m_pChannels[2];
+
+    // Runs the worker synchronously
+    friend class EngineBufferScaleRubberBandTest;
+
+    DISALLOW_COPY_AND_ASSIGN(RubberBandWorker);
+};
@@ -0,0 +1,83 @@
+#include "engine/bufferscalers/scaleinputhistory.h"
+
+#include "engine/readaheadmanager.h"
+#include "util/assert.h"
+#include "util/math.h"
+#include "util/sample.h"
+
+namespace {
+
+constexpr SINT kChannelCount = 2;
+
+} // anonymous namespace
+
+ScaleInputHistory::ScaleInputHistory(
+        ReadAheadManager* pReadAheadManager,
+        SINT capacityFrames)
+        : m_pReadAheadManager(pReadAheadManager),
+          m_capacityFrames(capacityFrames),
+          m_samples(kChannelCount * capacityFrames),
+          m_frontier(0) {
+    DEBUG_ASSERT(m_capacityFrames > 0);
+}
+
+void ScaleInputHistory::clear() {
+    m_frontier = 0;
+}
+
+SINT ScaleInputHistory::oldest() const {
+    return math_max(SINT(0), m_frontier - m_capacityFrames);
+}
+
+SINT ScaleInputHistory::read(
+        SINT* pPosition,
+        CSAMPLE* pDest,
+        SINT frames,
+        double rate) {
+    DEBUG_ASSERT(*pPosition <= m_frontier);
+    // Reading ahead must not overwrite the frames that are copied
+    VERIFY_OR_DEBUG_ASSERT(frames <= m_capacityFrames) {
+        frames = m_capacityFrames;
+    }
+    if (*pPosition < oldest()) {
+        *pPosition = oldest();
+    }
+    const SINT missingFrames = *pPosition + frames - m_frontier;
+    if (missingFrames > 0) {
+        readAhead(missingFrames, rate);
+    }
+
+    const SINT copyFrames = math_min(frames, m_frontier - *pPosition);
+    SINT copiedFrames = 0;
+    while (copiedFrames < copyFrames) {
+        const SINT ringFrame = (*pPosition + copiedFrames) % m_capacityFrames;
+        const SINT chunkFrames = math_min(
+                copyFrames - copiedFrames, m_capacityFrames - ringFrame);
+        SampleUtil::copy(pDest + kChannelCount * copiedFrames,
+                &m_samples[kChannelCount * ringFrame],
+                kChannelCount * chunkFrames);
+        copiedFrames += chunkFrames;
+    }
+    *pPosition += copyFrames;
+    return copyFrames;
+}
+
+SINT ScaleInputHistory::readAhead(SINT frames, double rate) {
+    SINT readFrames = 0;
+    while (readFrames < frames) {
+        const SINT ringFrame = m_frontier % m_capacityFrames;
+        const SINT chunkFrames = math_min(
+                frames - readFrames, m_capacityFrames - ringFrame);
+        const SINT samples = m_pReadAheadManager->getNextSamples(
+                rate,
+                &m_samples[kChannelCount * ringFrame],
+                kChannelCount * chunkFrames);
+        const SINT chunkReadFrames = samples / kChannelCount;
+        m_frontier += chunkReadFrames;
+        readFrames += chunkReadFrames;
+        if (chunkReadFrames < chunkFrames) {
+            break;
+        }
+    }
+    return readFrames;
+}
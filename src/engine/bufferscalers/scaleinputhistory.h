@@ -0,0 +1,51 @@
+#pragma once
+
+#include <vector>
+
+#include "util/class.h"
+#include "util/types.h"
+
+class ReadAheadManager;
+
+// The input of a scaler as a stream of interleaved stereo frames that are
+// numbered from the last clear(). The frames are read from the
+// ReadAheadManager on demand, and the most recent ones are kept, so that
+// the stream can be read again from an earlier position. This allows
+// EngineBufferScaleRubberBand to restart a stretcher at the input frame
+// that is currently audible, while another stretcher has already consumed
+// the input ahead of it.
+//
+// Not thread-safe, owned by the engine thread.
+class ScaleInputHistory {
+  public:
+    ScaleInputHistory(ReadAheadManager* pReadAheadManager, SINT capacityFrames);
+
+    // Forgets all frames, i.e. after a seek
+    void clear();
+
+    // The number of frames that have been read from the ReadAheadManager
+    SINT frontier() const {
+        return m_frontier;
+    }
+    // The oldest frame that is still available
+    SINT oldest() const;
+
+    // Copies up to the given number of frames starting at *pPosition into
+    // pDest and advances *pPosition. Frames beyond the frontier are read
+    // from the ReadAheadManager in the direction of the rate. A position
+    // before the oldest frame is moved forward to it. Returns the number
+    // of copied frames, which is less if the ReadAheadManager did not
+    // return enough samples.
+    SINT read(SINT* pPosition, CSAMPLE* pDest, SINT frames, double rate);
+
+  private:
+    // Reads up to the given number of frames into the ring buffer
+    SINT readAhead(SINT frames, double rate);
+
+    ReadAheadManager* const m_pReadAheadManager;
+    const SINT m_capacityFrames;
+    std::vector<CSAMPLE> m_samples;
+    SINT m_frontier;
+
+    DISALLOW_COPY_AND_ASSIGN(ScaleInputHistory);
+};
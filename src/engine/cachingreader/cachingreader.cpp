@@ -3,6 +3,7 @@
 
 #include "engine/cachingreader/cachingreader.h"
 #include "control/controlobject.h"
+#include "control/controlpushbutton.h"
 #include "track/track.h"
 #include "util/assert.h"
 #include "util/counter.h"
@@ -16,11 +17,6 @@ namespace {
 
 mixxx::Logger kLogger("CachingReader");
 
-// This is the default hint frameCount that is adopted in case of Hint::kFrameCountForward and
-// Hint::kFrameCountBackward count is provided. It matches 23 ms @ 44.1 kHz
-// TODO() Do we suffer cache misses if we use an audio buffer of above 23 ms?
-const SINT kDefaultHintFrames = 1024;
-
 // With CachingReaderChunk::kFrames = 8192 each chunk consumes
 // 8192 frames * 2 channels/frame * 4-bytes per sample = 65 kB.
 //
@@ -32,17 +28,39 @@ const SINT kDefaultHintFrames = 1024;
 // CachingReader must be multiplied by the number of decks to calculate
 // the total amount!
 //
-// NOTE(uklotzde, 2019-09-05): Reduce this number to just few chunks
-// (kNumberOfCachedChunksInMemory = 1, 2, 3, ...) for testing purposes
-// to verify that the MRU/LRU cache works as expected. Even though
-// massive drop outs are expected to occur Mixxx should run reliably!
-const SINT kNumberOfCachedChunksInMemory = 80;
+// NOTE(uklotzde, 2019-09-05): Reduce the memory budget to just few chunks
+// for testing purposes to verify that the MRU/LRU cache works as expected.
+// Even though massive drop outs are expected to occur Mixxx should run
+// reliably!
+const int kDefaultMemoryBudgetKiB = 5120;
+const SINT kMinNumberOfCachedChunks = 8;
+
+// Prefetching of potential jump targets may occupy all chunks of the pool
+// except for this fraction that is kept for reading around the play
+// position.
+const SINT kPlaybackReserveDivisor = 4;
+
+SINT numberOfCachedChunksForBudget(const UserSettingsPointer& pConfig) {
+    int memoryBudgetKiB = kDefaultMemoryBudgetKiB;
+    if (pConfig) {
+        memoryBudgetKiB = pConfig->getValue(
+                ConfigKey("[Master]", "caching_reader_memory_budget_kb"),
+                kDefaultMemoryBudgetKiB);
+    }
+    const SINT chunkBytes = CachingReaderChunk::kSamples * sizeof(CSAMPLE);
+    return math_max(
+            static_cast<SINT>(memoryBudgetKiB) * 1024 / chunkBytes,
+            kMinNumberOfCachedChunks);
+}
 
 } // anonymous namespace
 
 CachingReader::CachingReader(QString group,
-        UserSettingsPointer config)
+        UserSettingsPointer config,
+        PreloadBudget* pPreloadBudget,
+        mixxx::PcmCache* pPcmCache)
         : m_pConfig(config),
+          m_numberOfCachedChunks(numberOfCachedChunksForBudget(config)),
           // Limit the number of in-flight requests to the worker. This should
           // prevent to overload the worker when it is not able to fetch those
           // requests from the FIFO timely. Otherwise outdated requests pile up
@@ -52,21 +70,33 @@ CachingReader::CachingReader(QString group,
           // buffer, where new requests replace old requests when full. Those
           // old requests need to be returned immediately to the CachingReader
           // that must take ownership and free them!!!
-          m_chunkReadRequestFIFO(kNumberOfCachedChunksInMemory / 4),
+          m_chunkReadRequestFIFO(m_numberOfCachedChunks / 4),
           // The capacity of the back channel must be equal to the number of
           // allocated chunks, because the worker use writeBlocking(). Otherwise
           // the worker could get stuck in a hot loop!!!
-          m_readerStatusUpdateFIFO(kNumberOfCachedChunksInMemory),
+          m_readerStatusUpdateFIFO(m_numberOfCachedChunks),
           m_state(STATE_IDLE),
           m_mruCachingReaderChunk(nullptr),
           m_lruCachingReaderChunk(nullptr),
-          m_sampleBuffer(CachingReaderChunk::kSamples * kNumberOfCachedChunksInMemory),
-          m_worker(group, &m_chunkReadRequestFIFO, &m_readerStatusUpdateFIFO) {
-    m_allocatedCachingReaderChunks.reserve(kNumberOfCachedChunksInMemory);
+          m_sampleBuffer(CachingReaderChunk::kSamples * m_numberOfCachedChunks),
+          m_hintedChunkCount(0),
+          m_readAfterSeek(false),
+          m_chunkMissCounter(group + " CachingReader chunk misses"),
+          m_unavailableReadCounter(group + " CachingReader unavailable reads"),
+          m_unavailableReadAfterSeekCounter(
+                  group + " CachingReader unavailable reads after seek"),
+          m_pPreloadFully(nullptr),
+          m_worker(group,
+                  &m_chunkReadRequestFIFO,
+                  &m_readerStatusUpdateFIFO,
+                  &m_preloadedTrackSlot,
+                  pPreloadBudget,
+                  pPcmCache) {
+    m_allocatedCachingReaderChunks.reserve(m_numberOfCachedChunks);
     // Divide up the allocated raw memory buffer into total_chunks
     // chunks. Initialize each chunk to hold nothing and add it to the free
     // list.
-    for (SINT i = 0; i < kNumberOfCachedChunksInMemory; ++i) {
+    for (SINT i = 0; i < m_numberOfCachedChunks; ++i) {
         CachingReaderChunkForOwner* c =
                 new CachingReaderChunkForOwner(
                         mixxx::SampleBuffer::WritableSlice(
@@ -77,6 +107,15 @@ CachingReader::CachingReader(QString group,
         m_freeChunks.push_back(c);
     }
 
+    if (pPreloadBudget) {
+        m_pPreloadFully = new ControlPushButton(ConfigKey(group, "preload_fully"), true);
+        m_pPreloadFully->setButtonMode(ControlPushButton::TOGGLE);
+        connect(m_pPreloadFully, &ControlObject::valueChanged,
+                this, &CachingReader::slotPreloadFullyChanged,
+                Qt::DirectConnection);
+        m_worker.setPreloadEnabled(m_pPreloadFully->toBool());
+    }
+
     // Forward signals from worker
     connect(&m_worker, &CachingReaderWorker::trackLoading,
             this, &CachingReader::trackLoading,
@@ -93,9 +132,14 @@ CachingReader::CachingReader(QString group,
 
 CachingReader::~CachingReader() {
     m_worker.quitWait();
+    delete m_pPreloadFully;
     qDeleteAll(m_chunks);
 }
 
+void CachingReader::slotPreloadFullyChanged(double v) {
+    m_worker.setPreloadEnabled(v > 0);
+}
+
 void CachingReader::freeChunkFromList(CachingReaderChunkForOwner* pChunk) {
     pChunk->removeFromList(
             &m_mruCachingReaderChunk,
@@ -337,6 +381,10 @@ CachingReader::ReadResult CachingReader::read(SINT startSample, SINT numSamples,
                     CachingReaderChunk::samples2frames(numSamples));
     DEBUG_ASSERT(!remainingFrameIndexRange.empty());
 
+    // Prevents that the worker frees a preloaded track while reading from it
+    const PreloadedTrackSlot::ReadScope preloadedTrackScope(&m_preloadedTrackSlot);
+    const PreloadedTrack* const pPreloadedTrack = preloadedTrackScope.track();
+
     auto result = ReadResult::AVAILABLE;
     if (!intersect(remainingFrameIndexRange, m_readableFrameIndexRange).empty()) {
         // Fill the buffer up to the first readable sample with
@@ -419,8 +467,31 @@ CachingReader::ReadResult CachingReader::read(SINT startSample, SINT numSamples,
                 }
 
                 mixxx::IndexRange bufferedFrameIndexRange;
-                const CachingReaderChunkForOwner* const pChunk = lookupChunkAndFreshen(chunkIndex);
-                if (pChunk && (pChunk->getState() == CachingReaderChunkForOwner::READY)) {
+                if (pPreloadedTrack) {
+                    // Read from the decoded track without touching any chunks
+                    const auto chunkFrameIndexRange = intersect(
+                            remainingFrameIndexRange,
+                            mixxx::IndexRange::forward(
+                                    chunkIndex * CachingReaderChunk::kFrames,
+                                    CachingReaderChunk::kFrames));
+                    if (reverse) {
+                        bufferedFrameIndexRange =
+                                pPreloadedTrack->readSampleFramesReverse(
+                                        &buffer[samplesRemaining],
+                                        chunkFrameIndexRange);
+                    } else {
+                        bufferedFrameIndexRange =
+                                pPreloadedTrack->readSampleFrames(
+                                        buffer,
+                                        chunkFrameIndexRange);
+                    }
+                }
+                const CachingReaderChunkForOwner* const pChunk =
+                        bufferedFrameIndexRange.empty() ? lookupChunkAndFreshen(chunkIndex) : nullptr;
+                if (!bufferedFrameIndexRange.empty()) {
+                    ++m_stats.chunkHits;
+                } else if (pChunk && (pChunk->getState() == CachingReaderChunkForOwner::READY)) {
+                    ++m_stats.chunkHits;
                     if (reverse) {
                         bufferedFrameIndexRange =
                                 pChunk->readBufferedSampleFramesReverse(
@@ -439,6 +510,8 @@ CachingReader::ReadResult CachingReader::read(SINT startSample, SINT numSamples,
                     DEBUG_ASSERT(!pChunk ||
                             (pChunk->getState() == CachingReaderChunkForOwner::READ_PENDING));
                     Counter("CachingReader::read(): Failed to read chunk on cache miss")++;
+                    ++m_stats.chunkMisses;
+                    m_chunkMissCounter.increment();
                     if (kLogger.traceEnabled()) {
                         kLogger.trace()
                                 << "Cache miss for chunk with index"
@@ -455,6 +528,13 @@ CachingReader::ReadResult CachingReader::read(SINT startSample, SINT numSamples,
                         // the first required chunk. Inform the calling code that no
                         // data has been written into the buffer and to handle this
                         // situation appropriately.
+                        ++m_stats.unavailableReads;
+                        m_unavailableReadCounter.increment();
+                        if (m_readAfterSeek) {
+                            ++m_stats.unavailableReadsAfterSeek;
+                            m_unavailableReadAfterSeekCounter.increment();
+                            m_readAfterSeek = false;
+                        }
                         return ReadResult::UNAVAILABLE;
                     }
                     // No more readable data available. Exit the loop and
@@ -495,6 +575,7 @@ CachingReader::ReadResult CachingReader::read(SINT startSample, SINT numSamples,
             }
         }
     }
+    m_readAfterSeek = false;
     // Finally fill the remaining buffer with silence
     DEBUG_ASSERT(samplesRemaining >= 0);
     if (samplesRemaining > 0) {
@@ -504,85 +585,132 @@ CachingReader::ReadResult CachingReader::read(SINT startSample, SINT numSamples,
     return result;
 }
 
+void CachingReader::notifySeek() {
+    m_readAfterSeek = true;
+}
+
 void CachingReader::hintAndMaybeWake(const HintVector& hintList) {
     // If no file is loaded, skip.
     if (atomicLoadRelaxed(m_state) != STATE_TRACK_LOADED) {
         return;
     }
 
+    // All chunks are read from the preloaded track
+    if (m_preloadedTrackSlot.isPublished()) {
+        return;
+    }
+
     // For every chunk that the hints indicated, check if it is in the cache. If
     // any are not, then wake.
     bool shouldWake = false;
+    m_hintedChunkCount = 0;
 
-    for (const auto& hint: hintList) {
-        SINT hintFrame = hint.frame;
-        SINT hintFrameCount = hint.frameCount;
-
-        // Handle some special length values
-        if (hintFrameCount == Hint::kFrameCountForward) {
-        	hintFrameCount = kDefaultHintFrames;
-        } else if (hintFrameCount == Hint::kFrameCountBackward) {
-        	hintFrame -= kDefaultHintFrames;
-        	hintFrameCount = kDefaultHintFrames;
-            if (hintFrame < 0) {
-            	hintFrameCount += hintFrame;
-                hintFrame = 0;
-            }
+    // Hints for imminent reads go first, so they get the free chunks and
+    // the free slots in the request FIFO before any prefetch hints.
+    for (const auto& hint : hintList) {
+        if (hint.priority < Hint::kPriorityPrefetch) {
+            shouldWake |= hintChunks(hint, false);
         }
-
-        VERIFY_OR_DEBUG_ASSERT(hintFrameCount > 0) {
-            kLogger.warning() << "ERROR: Negative hint length. Ignoring.";
-            continue;
+    }
+    for (const auto& hint : hintList) {
+        if (hint.priority >= Hint::kPriorityPrefetch) {
+            shouldWake |= hintChunks(hint, true);
         }
+    }
 
-        const auto readableFrameIndexRange = intersect(
-                m_readableFrameIndexRange,
-                mixxx::IndexRange::forward(hintFrame, hintFrameCount));
-        if (readableFrameIndexRange.empty()) {
-            continue;
+    // If there are chunks to be read, wake up.
+    if (shouldWake) {
+        m_worker.workReady();
+    }
+}
+
+bool CachingReader::hintChunks(const Hint& hint, bool prefetch) {
+    SINT hintFrame = hint.frame;
+    SINT hintFrameCount = hint.frameCount;
+
+    // Handle some special length values
+    if (hintFrameCount == Hint::kFrameCountForward) {
+        hintFrameCount = Hint::kDefaultFrameCount;
+    } else if (hintFrameCount == Hint::kFrameCountBackward) {
+        hintFrame -= Hint::kDefaultFrameCount;
+        hintFrameCount = Hint::kDefaultFrameCount;
+        if (hintFrame < 0) {
+            hintFrameCount += hintFrame;
+            hintFrame = 0;
         }
+    }
 
-        const int firstChunkIndex = CachingReaderChunk::indexForFrame(readableFrameIndexRange.start());
-        const int lastChunkIndex = CachingReaderChunk::indexForFrame(readableFrameIndexRange.end() - 1);
-        for (int chunkIndex = firstChunkIndex; chunkIndex <= lastChunkIndex; ++chunkIndex) {
-            CachingReaderChunkForOwner* pChunk = lookupChunk(chunkIndex);
-            if (!pChunk) {
-                shouldWake = true;
-                pChunk = allocateChunkExpireLRU(chunkIndex);
-                if (!pChunk) {
-                    kLogger.warning()
-                            << "Failed to allocate chunk"
-                            << chunkIndex
-                            << "for read request";
-                    continue;
-                }
-                // Do not insert the allocated chunk into the MRU/LRU list,
-                // because it will be handed over to the worker immediately
-                CachingReaderChunkReadRequest request;
-                request.giveToWorker(pChunk);
+    VERIFY_OR_DEBUG_ASSERT(hintFrameCount > 0) {
+        kLogger.warning() << "ERROR: Negative hint length. Ignoring.";
+        return false;
+    }
+
+    const auto readableFrameIndexRange = intersect(
+            m_readableFrameIndexRange,
+            mixxx::IndexRange::forward(hintFrame, hintFrameCount));
+    if (readableFrameIndexRange.empty()) {
+        return false;
+    }
+
+    // Prefetching must not expire chunks that have just been hinted. This
+    // limit also prevents that the LRU list is thrashed if the prefetch
+    // targets don't fit into the cache.
+    const SINT maxPrefetchedChunkCount =
+            m_numberOfCachedChunks - m_numberOfCachedChunks / kPlaybackReserveDivisor;
+
+    bool chunksRequested = false;
+    const int firstChunkIndex = CachingReaderChunk::indexForFrame(readableFrameIndexRange.start());
+    const int lastChunkIndex = CachingReaderChunk::indexForFrame(readableFrameIndexRange.end() - 1);
+    for (int chunkIndex = firstChunkIndex; chunkIndex <= lastChunkIndex; ++chunkIndex) {
+        CachingReaderChunkForOwner* pChunk = lookupChunk(chunkIndex);
+        if (!pChunk) {
+            if (prefetch && m_hintedChunkCount >= maxPrefetchedChunkCount) {
                 if (kLogger.traceEnabled()) {
                     kLogger.trace()
-                            << "Requesting read of chunk"
-                            << request.chunk;
-                }
-                if (m_chunkReadRequestFIFO.write(&request, 1) != 1) {
-                    kLogger.warning()
-                            << "Failed to submit read request for chunk"
+                            << "Skipping prefetch of chunk"
                             << chunkIndex;
-                    // Revoke the chunk from the worker and free it
-                    pChunk->takeFromWorker();
-                    freeChunk(pChunk);
                 }
-            } else if (pChunk->getState() == CachingReaderChunkForOwner::READY) {
-                // This will cause the chunk to be 'freshened' in the cache. The
-                // chunk will be moved to the end of the LRU list.
-                freshenChunk(pChunk);
+                return chunksRequested;
+            }
+            chunksRequested = true;
+            pChunk = allocateChunkExpireLRU(chunkIndex);
+            if (!pChunk) {
+                kLogger.warning()
+                        << "Failed to allocate chunk"
+                        << chunkIndex
+                        << "for read request";
+                continue;
+            }
+            // Do not insert the allocated chunk into the MRU/LRU list,
+            // because it will be handed over to the worker immediately
+            CachingReaderChunkReadRequest request;
+            request.giveToWorker(pChunk);
+            if (kLogger.traceEnabled()) {
+                kLogger.trace()
+                        << "Requesting read of chunk"
+                        << request.chunk;
+            }
+            if (m_chunkReadRequestFIFO.write(&request, 1) != 1) {
+                kLogger.warning()
+                        << "Failed to submit read request for chunk"
+                        << chunkIndex;
+                // Revoke the chunk from the worker and free it
+                pChunk->takeFromWorker();
+                freeChunk(pChunk);
+                // The request FIFO is full, so the remaining chunks
+                // will be requested by one of the next callbacks.
+                return chunksRequested;
             }
+            ++m_hintedChunkCount;
+        } else if (pChunk->getState() == CachingReaderChunkForOwner::READY) {
+            // This will cause the chunk to be 'freshened' in the cache. The
+            // chunk will be moved to the end of the LRU list.
+            freshenChunk(pChunk);
+            ++m_hintedChunkCount;
+        } else {
+            // The read is still pending
+            ++m_hintedChunkCount;
         }
     }
-
-    // If there are chunks to be read, wake up.
-    if (shouldWake) {
-        m_worker.workReady();
-    }
+    return chunksRequested;
 }
@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include <gtest/gtest_prod.h>
+
 #include <QAtomicInt>
 #include <QHash>
 #include <QList>
@@ -14,9 +16,12 @@
 #include "engine/engineworker.h"
 #include "preferences/usersettings.h"
 #include "track/track.h"
+#include "util/counter.h"
 #include "util/fifo.h"
 #include "util/types.h"
 
+class ControlPushButton;
+
 // A Hint is an indication to the CachingReader that a certain section of a
 // SoundSource will be used 'soon' and so it should be brought into memory by
 // the reader work thread.
@@ -26,17 +31,23 @@ typedef struct Hint {
     // If a range of frames should be present, use frameCount to indicate that the
     // range (frame, frame + frameCount) should be present in memory.
     SINT frameCount;
-    // Currently unused -- but in the future could be used to prioritize certain
-    // hints over others. A priority of 1 is the highest priority and should be
-    // used for samples that will be read imminently. Hints for samples that
-    // have the potential to be read (i.e. a cue point) should be issued with
-    // priority >10.
+    // A priority of 1 is the highest priority and should be used for samples
+    // that will be read imminently. Hints for samples that have the potential
+    // to be read (i.e. a cue point) should be issued with a priority of
+    // kPriorityPrefetch or higher. Prefetch hints are processed after all
+    // other hints and never evict the chunks of other hints from the cache.
     int priority;
 
+    static constexpr int kPriorityPrefetch = 10;
+
     // for the default frame count in forward direction
     static constexpr SINT kFrameCountForward = 0;
     static constexpr SINT kFrameCountBackward = -1;
 
+    // The number of frames that kFrameCountForward and kFrameCountBackward
+    // stand for. It matches 23 ms @ 44.1 kHz.
+    static constexpr SINT kDefaultFrameCount = 1024;
+
 } Hint;
 
 // Note that we use a QVarLengthArray here instead of a QVector. Since this list
@@ -74,9 +85,13 @@ class CachingReader : public QObject {
     Q_OBJECT
 
   public:
-    // Construct a CachingReader with the given group.
+    // Construct a CachingReader with the given group. Tracks can only be
+    // preloaded into memory completely if a pPreloadBudget is provided.
+    // Decoded tracks are read from and written to the optional pPcmCache.
     CachingReader(QString group,
-                  UserSettingsPointer _config);
+                  UserSettingsPointer _config,
+                  PreloadBudget* pPreloadBudget = nullptr,
+                  mixxx::PcmCache* pPcmCache = nullptr);
     ~CachingReader() override;
 
     void process();
@@ -96,12 +111,51 @@ class CachingReader : public QObject {
     // It support reading stereo samples in reverse (backward) order.
     virtual ReadResult read(SINT startSample, SINT numSamples, bool reverse, CSAMPLE* buffer);
 
+    // The whole track has been decoded into memory and is read
+    // without waiting for the worker
+    bool isTrackPreloaded() const {
+        return m_preloadedTrackSlot.isPublished();
+    }
+
+    // A track has been requested by newTrack(), but has not been loaded or
+    // failed to load yet
+    bool isTrackLoadPending() const {
+        return m_worker.isTrackLoadPending();
+    }
+
     // Issue a list of hints, but check whether any of the hints request a chunk
     // that is not in the cache. If any hints do request a chunk not in cache,
     // then wake the reader so that it can process them. Must only be called
     // from the engine callback.
     void hintAndMaybeWake(const HintVector& hintList);
 
+    // Informs the reader that the next read() is caused by a jump to a new
+    // position, e.g. a hotcue. Cache misses of this read are counted
+    // separately. Must only be called from the engine callback.
+    void notifySeek();
+
+    // Cache statistics of this reader since it has been created. All but
+    // the chunk hits, which happen for nearly every read, are also reported
+    // to the StatsManager per deck. Must only be accessed from the engine
+    // callback.
+    struct Stats {
+        // Chunks that were found in the cache or not while reading
+        int chunkHits = 0;
+        int chunkMisses = 0;
+        // Reads that returned ReadResult::UNAVAILABLE
+        int unavailableReads = 0;
+        // Reads that returned ReadResult::UNAVAILABLE after a jump
+        int unavailableReadsAfterSeek = 0;
+    };
+    const Stats& stats() const {
+        return m_stats;
+    }
+
+    // The number of chunks that fit into the configured memory budget
+    SINT numberOfCachedChunks() const {
+        return m_numberOfCachedChunks;
+    }
+
     // Request that the CachingReader load a new track. These requests are
     // processed in the work thread, so the reader must be woken up via wake()
     // for this to take effect.
@@ -117,9 +171,18 @@ class CachingReader : public QObject {
     void trackLoaded(TrackPointer pTrack, int iSampleRate, int iNumSamples);
     void trackLoadFailed(TrackPointer pTrack, QString reason);
 
+  private slots:
+    void slotPreloadFullyChanged(double v);
+
   private:
+    FRIEND_TEST(EngineBufferE2ETest, HotcueJumpIsPrefetched);
+    FRIEND_TEST(EngineBufferE2ETest, ReadsFromPreloadedTrack);
+
     const UserSettingsPointer m_pConfig;
 
+    // The size of the chunk pool, see numberOfCachedChunks()
+    const SINT m_numberOfCachedChunks;
+
     // Thread-safe FIFOs for communication between the engine callback and
     // reader thread.
     FIFO<CachingReaderChunkReadRequest> m_chunkReadRequestFIFO;
@@ -150,6 +213,10 @@ class CachingReader : public QObject {
     // Gets a chunk from the free list, frees the LRU CachingReaderChunk if none available.
     CachingReaderChunkForOwner* allocateChunkExpireLRU(SINT chunkIndex);
 
+    // Ensures that the chunks of a hint are cached or requested from the
+    // worker. Returns true if a chunk has been requested.
+    bool hintChunks(const Hint& hint, bool prefetch);
+
     enum State {
         STATE_IDLE,
         STATE_TRACK_LOADING,
@@ -179,5 +246,19 @@ class CachingReader : public QObject {
     // The readable frame index range as reported by the worker.
     mixxx::IndexRange m_readableFrameIndexRange;
 
+    // The number of chunks that have been freshened or allocated by the
+    // current invocation of hintAndMaybeWake().
+    SINT m_hintedChunkCount;
+
+    bool m_readAfterSeek;
+    Stats m_stats;
+    Counter m_chunkMissCounter;
+    Counter m_unavailableReadCounter;
+    Counter m_unavailableReadAfterSeekCounter;
+
+    // The track that has been decoded completely by the worker, if any
+    PreloadedTrackSlot m_preloadedTrackSlot;
+    ControlPushButton* m_pPreloadFully;
+
     CachingReaderWorker m_worker;
 };
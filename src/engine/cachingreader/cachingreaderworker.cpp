@@ -20,13 +20,28 @@ mixxx::Logger kLogger("CachingReaderWorker");
 CachingReaderWorker::CachingReaderWorker(
         QString group,
         FIFO<CachingReaderChunkReadRequest>* pChunkReadRequestFIFO,
-        FIFO<ReaderStatusUpdate>* pReaderStatusFIFO)
+        FIFO<ReaderStatusUpdate>* pReaderStatusFIFO,
+        PreloadedTrackSlot* pPreloadedTrackSlot,
+        PreloadBudget* pPreloadBudget,
+        mixxx::PcmCache* pPcmCache)
         : m_group(group),
           m_tag(QString("CachingReaderWorker %1").arg(m_group)),
           m_pChunkReadRequestFIFO(pChunkReadRequestFIFO),
           m_pReaderStatusFIFO(pReaderStatusFIFO),
           m_newTrackAvailable(false),
+          m_trackLoadPending(false),
+          m_pPreloadedTrackSlot(pPreloadedTrackSlot),
+          m_pPreloadBudget(pPreloadBudget),
+          m_preloadEnabled(false),
+          m_preloadState(PreloadState::Idle),
+          m_pPcmCache(pPcmCache),
+          m_provisionalWaveformSamples(CachingReaderChunk::kSamples),
           m_stop(0) {
+    DEBUG_ASSERT(m_pPreloadedTrackSlot);
+}
+
+CachingReaderWorker::~CachingReaderWorker() {
+    stopPreload();
 }
 
 ReaderStatusUpdate CachingReaderWorker::processReadRequest(
@@ -57,6 +72,13 @@ ReaderStatusUpdate CachingReaderWorker::processReadRequest(
     DEBUG_ASSERT(bufferedFrameIndexRange.empty() ||
             bufferedFrameIndexRange <= chunkFrameIndexRange);
 
+    if (!bufferedFrameIndexRange.empty() &&
+            m_provisionalWaveformBuilder.isActive()) {
+        m_provisionalWaveformFrames = pChunk->readBufferedSampleFrames(
+                m_provisionalWaveformSamples.data(),
+                bufferedFrameIndexRange);
+    }
+
     ReaderStatus status = bufferedFrameIndexRange.empty() ? CHUNK_READ_EOF : CHUNK_READ_SUCCESS;
     if (bufferedFrameIndexRange != chunkFrameIndexRange) {
         kLogger.warning()
@@ -80,6 +102,7 @@ void CachingReaderWorker::newTrack(TrackPointer pTrack) {
         QMutexLocker locker(&m_newTrackMutex);
         m_pNewTrack = pTrack;
         m_newTrackAvailable = true;
+        m_trackLoadPending = true;
     }
     workReady();
 }
@@ -101,10 +124,21 @@ void CachingReaderWorker::run() {
                 m_newTrackAvailable = false;
             } // implicitly unlocks the mutex
             loadTrack(pLoadTrack);
+            QMutexLocker locker(&m_newTrackMutex);
+            // Unless another track has been requested in the meantime
+            if (!m_newTrackAvailable) {
+                m_trackLoadPending = false;
+            }
         } else if (m_pChunkReadRequestFIFO->read(&request, 1) == 1) {
             // Read the requested chunk and send the result
             const ReaderStatusUpdate update(processReadRequest(request));
             m_pReaderStatusFIFO->writeBlocking(&update, 1);
+            addProvisionalWaveformFrames();
+        } else if (processPreload()) {
+            // Pending read requests are checked again after decoding
+            // each part of the preloaded track
+        } else if (processPcmCacheWriter()) {
+            // Same for writing the cache entry
         } else {
             Event::end(m_tag);
             m_semaRun.acquire();
@@ -122,6 +156,9 @@ void CachingReaderWorker::loadTrack(const TrackPointer& pTrack) {
     }
 
     // Unload the track
+    stopPreload();
+    m_provisionalWaveformBuilder.stop();
+    m_pPcmCacheWriter.reset(); // Discards an incomplete cache entry
     m_pAudioSource.reset(); // Close open file handles
 
     if (!pTrack) {
@@ -147,9 +184,16 @@ void CachingReaderWorker::loadTrack(const TrackPointer& pTrack) {
         return;
     }
 
-    mixxx::AudioSource::OpenParams config;
-    config.setChannelCount(CachingReaderChunk::kChannels);
-    m_pAudioSource = SoundSourceProxy(pTrack).openAudioSource(config);
+    bool cached = false;
+    if (m_pPcmCache) {
+        m_pAudioSource = m_pPcmCache->openAudioSource(pTrack);
+        cached = static_cast<bool>(m_pAudioSource);
+    }
+    if (!m_pAudioSource) {
+        mixxx::AudioSource::OpenParams config;
+        config.setChannelCount(CachingReaderChunk::kChannels);
+        m_pAudioSource = SoundSourceProxy(pTrack).openAudioSource(config);
+    }
     if (!m_pAudioSource) {
         kLogger.warning()
                 << m_group
@@ -199,6 +243,38 @@ void CachingReaderWorker::loadTrack(const TrackPointer& pTrack) {
             pTrack,
             m_pAudioSource->getSignalInfo().getSampleRate(),
             sampleCount);
+
+    m_provisionalWaveformBuilder.start(
+            pTrack,
+            m_pAudioSource->frameIndexRange(),
+            m_pAudioSource->getSignalInfo().getSampleRate());
+
+    if (m_pPcmCache && !cached) {
+        // Decodes the track a second time with a separate decoder, because
+        // the chunks are read in random order
+        m_pPcmCacheWriter = m_pPcmCache->newWriter(pTrack);
+    }
+}
+
+bool CachingReaderWorker::processPcmCacheWriter() {
+    if (!m_pPcmCacheWriter) {
+        return false;
+    }
+    if (!m_pPcmCacheWriter->writeNextFrames() ||
+            m_pPcmCacheWriter->isFinished()) {
+        m_pPcmCacheWriter.reset();
+    }
+    return true;
+}
+
+void CachingReaderWorker::addProvisionalWaveformFrames() {
+    if (m_provisionalWaveformFrames.empty()) {
+        return;
+    }
+    m_provisionalWaveformBuilder.addFrames(
+            m_provisionalWaveformFrames,
+            m_provisionalWaveformSamples.data());
+    m_provisionalWaveformFrames = mixxx::IndexRange();
 }
 
 void CachingReaderWorker::quitWait() {
@@ -206,3 +282,136 @@ void CachingReaderWorker::quitWait() {
     m_semaRun.release();
     wait();
 }
+
+void CachingReaderWorker::setPreloadEnabled(bool enabled) {
+    if (m_preloadEnabled.exchange(enabled) != enabled) {
+        // Wake up the worker directly, because this is not invoked
+        // from the engine callback
+        m_semaRun.release();
+    }
+}
+
+bool CachingReaderWorker::processPreload() {
+    if (!m_pPreloadBudget) {
+        return false;
+    }
+    PreloadState state;
+    {
+        QMutexLocker locker(&m_preloadMutex);
+        state = m_preloadState;
+    }
+    if (!m_preloadEnabled.load()) {
+        if (state != PreloadState::Idle) {
+            stopPreload();
+        }
+        return false;
+    }
+    if (!m_pAudioSource) {
+        return false;
+    }
+    switch (state) {
+    case PreloadState::Idle:
+        startPreload();
+        return true;
+    case PreloadState::Decoding:
+        decodePreload();
+        return true;
+    default:
+        return false;
+    }
+}
+
+void CachingReaderWorker::startPreload() {
+    const auto frameIndexRange = m_pAudioSource->frameIndexRange();
+    {
+        QMutexLocker locker(&m_preloadMutex);
+        DEBUG_ASSERT(m_preloadState == PreloadState::Idle);
+        // Set in advance, because another worker might evict the track
+        // as soon as the memory has been reserved
+        m_preloadState = PreloadState::Decoding;
+    }
+    if (!m_pPreloadBudget->reserve(
+                this, PreloadedTrack::bytesForFrames(frameIndexRange.length()))) {
+        kLogger.info()
+                << m_group
+                << "Streaming the track, because it exceeds the preload budget";
+        QMutexLocker locker(&m_preloadMutex);
+        m_preloadState = PreloadState::Abandoned;
+        return;
+    }
+    // Allocate the memory without holding the lock
+    auto pPreloadedTrack = std::make_unique<PreloadedTrack>(frameIndexRange);
+    QMutexLocker locker(&m_preloadMutex);
+    if (m_preloadState != PreloadState::Decoding) {
+        // Already evicted again
+        return;
+    }
+    m_pPreloadedTrack = std::move(pPreloadedTrack);
+}
+
+void CachingReaderWorker::decodePreload() {
+    bool failed = false;
+    {
+        QMutexLocker locker(&m_preloadMutex);
+        if (m_preloadState != PreloadState::Decoding) {
+            return;
+        }
+        DEBUG_ASSERT(m_pPreloadedTrack);
+        const SINT decodedFrameIndex = m_pPreloadedTrack->decodedFrameIndexRange().end();
+        if (!m_pPreloadedTrack->decodeNextFrames(
+                    m_pAudioSource,
+                    mixxx::SampleBuffer::WritableSlice(m_tempReadBuffer),
+                    CachingReaderChunk::kFrames)) {
+            kLogger.warning()
+                    << m_group
+                    << "Failed to preload the track after decoding"
+                    << m_pPreloadedTrack->decodedFrameIndexRange();
+            failed = true;
+        } else if (m_pPreloadedTrack->isDecoded()) {
+            kLogger.info()
+                    << m_group
+                    << "Preloaded the track with"
+                    << m_pPreloadedTrack->frameIndexRange().length()
+                    << "frames";
+            m_pPreloadedTrackSlot->publish(m_pPreloadedTrack.get());
+            m_preloadState = PreloadState::Published;
+        }
+        if (!failed && m_provisionalWaveformBuilder.isActive()) {
+            m_provisionalWaveformFrames = m_pPreloadedTrack->readSampleFrames(
+                    m_provisionalWaveformSamples.data(),
+                    mixxx::IndexRange::between(
+                            decodedFrameIndex,
+                            m_pPreloadedTrack->decodedFrameIndexRange().end()));
+        }
+    }
+    addProvisionalWaveformFrames();
+    if (failed) {
+        // Free the memory and don't retry, the chunks will report the
+        // read errors
+        stopPreload();
+        QMutexLocker locker(&m_preloadMutex);
+        m_preloadState = PreloadState::Abandoned;
+    }
+}
+
+void CachingReaderWorker::stopPreload() {
+    std::unique_ptr<PreloadedTrack> pPreloadedTrack;
+    {
+        QMutexLocker locker(&m_preloadMutex);
+        m_pPreloadedTrackSlot->unpublish();
+        pPreloadedTrack = std::move(m_pPreloadedTrack);
+        m_preloadState = PreloadState::Idle;
+    }
+    // Must not be called while holding the lock, see evictPreload()
+    if (m_pPreloadBudget) {
+        m_pPreloadBudget->release(this);
+    }
+}
+
+void CachingReaderWorker::evictPreload() {
+    QMutexLocker locker(&m_preloadMutex);
+    m_pPreloadedTrackSlot->unpublish();
+    m_pPreloadedTrack.reset();
+    // Continue streaming the track chunk by chunk
+    m_preloadState = PreloadState::Abandoned;
+}
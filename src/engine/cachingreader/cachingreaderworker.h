@@ -7,11 +7,18 @@
 #include <QThread>
 #include <QString>
 
+#include <atomic>
+#include <memory>
+
 #include "engine/cachingreader/cachingreaderchunk.h"
+#include "engine/cachingreader/preloadbudget.h"
+#include "engine/cachingreader/preloadedtrack.h"
 #include "track/track.h"
 #include "engine/engineworker.h"
 #include "sources/audiosource.h"
+#include "sources/pcmcache.h"
 #include "util/fifo.h"
+#include "waveform/provisionalwaveformbuilder.h"
 
 
 // POD with trivial ctor/dtor/copy for passing through FIFO
@@ -93,19 +100,44 @@ typedef struct ReaderStatusUpdate {
     }
 } ReaderStatusUpdate;
 
-class CachingReaderWorker : public EngineWorker {
+// The worker optionally decodes the whole track into memory after it has
+// been loaded (see PreloadedTrack). Decoding happens in the background
+// whenever no chunk read requests are pending, so the track can be played
+// while it is preloaded. The memory is accounted by a PreloadBudget that is
+// shared by all workers.
+//
+// With a PcmCache tracks that have been decoded before are read from the
+// memory mapped cache entry instead of the original file. Otherwise a new
+// entry is written in the background while idle, like preloading.
+class CachingReaderWorker : public EngineWorker, public PreloadBudget::Client {
     Q_OBJECT
 
   public:
-    // Construct a CachingReader with the given group.
+    // Construct a CachingReader with the given group. Preloading is not
+    // available without a pPreloadBudget.
     CachingReaderWorker(QString group,
             FIFO<CachingReaderChunkReadRequest>* pChunkReadRequestFIFO,
-            FIFO<ReaderStatusUpdate>* pReaderStatusFIFO);
-    ~CachingReaderWorker() override = default;
+            FIFO<ReaderStatusUpdate>* pReaderStatusFIFO,
+            PreloadedTrackSlot* pPreloadedTrackSlot,
+            PreloadBudget* pPreloadBudget,
+            mixxx::PcmCache* pPcmCache);
+    ~CachingReaderWorker() override;
 
     // Request to load a new track. wake() must be called afterwards.
     void newTrack(TrackPointer pTrack);
 
+    // A track has been requested by newTrack(), but has not been loaded or
+    // failed to load yet. May be called from any thread.
+    bool isTrackLoadPending() const {
+        return m_trackLoadPending.load();
+    }
+
+    // Enables or disables decoding whole tracks into memory. May be called
+    // from any thread.
+    void setPreloadEnabled(bool enabled);
+
+    void evictPreload() override;
+
     // Run upkeep operations like loading tracks and reading from file. Run by a
     // thread pool via the EngineWorkerScheduler.
     void run() override;
@@ -132,6 +164,8 @@ class CachingReaderWorker : public EngineWorker {
     QMutex m_newTrackMutex;
     bool m_newTrackAvailable;
     TrackPointer m_pNewTrack;
+    // Cleared after trackLoaded() or trackLoadFailed() has been emitted
+    std::atomic<bool> m_trackLoadPending;
 
     // Internal method to load a track. Emits trackLoaded when finished.
     void loadTrack(const TrackPointer& pTrack);
@@ -139,6 +173,46 @@ class CachingReaderWorker : public EngineWorker {
     ReaderStatusUpdate processReadRequest(
             const CachingReaderChunkReadRequest& request);
 
+    enum class PreloadState {
+        Idle,
+        Decoding,
+        Published,
+        // Failed or evicted, not retried for the current track
+        Abandoned,
+    };
+
+    // Starts, continues or stops preloading the current track. Returns
+    // false if there is nothing to do.
+    bool processPreload();
+    void startPreload();
+    void decodePreload();
+    void stopPreload();
+
+    PreloadedTrackSlot* const m_pPreloadedTrackSlot;
+    PreloadBudget* const m_pPreloadBudget;
+    std::atomic<bool> m_preloadEnabled;
+
+    // Guards the preloaded track that might be evicted by other workers
+    QMutex m_preloadMutex;
+    PreloadState m_preloadState;
+    std::unique_ptr<PreloadedTrack> m_pPreloadedTrack;
+
+    // Writes the next frames of the current track into the PcmCache.
+    // Returns false if there is nothing to do.
+    bool processPcmCacheWriter();
+
+    mixxx::PcmCache* const m_pPcmCache;
+    std::unique_ptr<mixxx::PcmCache::Writer> m_pPcmCacheWriter;
+
+    // Fills a provisional waveform from the decoded frames until the
+    // analyzed one is available. The frames of a chunk are copied before
+    // responding and added afterwards to not delay the response.
+    void addProvisionalWaveformFrames();
+
+    ProvisionalWaveformBuilder m_provisionalWaveformBuilder;
+    mixxx::SampleBuffer m_provisionalWaveformSamples;
+    mixxx::IndexRange m_provisionalWaveformFrames;
+
     // The current audio source of the track loaded
     mixxx::AudioSourcePointer m_pAudioSource;
 
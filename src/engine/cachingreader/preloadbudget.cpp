@@ -0,0 +1,61 @@
+#include "engine/cachingreader/preloadbudget.h"
+
+#include <QMutexLocker>
+
+#include "util/assert.h"
+#include "util/logger.h"
+
+namespace {
+
+mixxx::Logger kLogger("PreloadBudget");
+
+} // anonymous namespace
+
+PreloadBudget::PreloadBudget(qint64 limitBytes)
+        : m_limitBytes(limitBytes),
+          m_reservedBytes(0) {
+}
+
+qint64 PreloadBudget::reservedBytes() const {
+    QMutexLocker locker(&m_mutex);
+    return m_reservedBytes;
+}
+
+bool PreloadBudget::reserve(Client* pClient, qint64 bytes) {
+    DEBUG_ASSERT(pClient);
+    DEBUG_ASSERT(bytes >= 0);
+    QMutexLocker locker(&m_mutex);
+    releaseLocked(pClient);
+    if (bytes > m_limitBytes) {
+        kLogger.info()
+                << "Track with" << bytes
+                << "bytes exceeds the budget of" << m_limitBytes << "bytes";
+        return false;
+    }
+    while (m_reservedBytes + bytes > m_limitBytes) {
+        DEBUG_ASSERT(!m_reservations.isEmpty());
+        const Reservation evicted = m_reservations.takeFirst();
+        m_reservedBytes -= evicted.bytes;
+        kLogger.info()
+                << "Evicting preloaded track with" << evicted.bytes << "bytes";
+        evicted.pClient->evictPreload();
+    }
+    m_reservations.append(Reservation{pClient, bytes});
+    m_reservedBytes += bytes;
+    return true;
+}
+
+void PreloadBudget::release(Client* pClient) {
+    QMutexLocker locker(&m_mutex);
+    releaseLocked(pClient);
+}
+
+void PreloadBudget::releaseLocked(Client* pClient) {
+    for (int i = 0; i < m_reservations.size(); ++i) {
+        if (m_reservations[i].pClient == pClient) {
+            m_reservedBytes -= m_reservations[i].bytes;
+            m_reservations.removeAt(i);
+            return;
+        }
+    }
+}
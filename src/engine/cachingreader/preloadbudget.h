@@ -0,0 +1,57 @@
+#pragma once
+
+#include <QList>
+#include <QMutex>
+
+#include "util/class.h"
+
+// Limits the total memory of all tracks that are decoded completely into
+// memory by the CachingReaders of decks and samplers (see PreloadedTrack).
+//
+// If a new reservation does not fit into the budget the tracks that have
+// been reserved first are evicted until it fits. If it would not fit even
+// after evicting all other tracks nothing is evicted and the reservation
+// fails. The reader then falls back to streaming the track chunk by chunk.
+class PreloadBudget {
+  public:
+    class Client {
+      public:
+        virtual ~Client() = default;
+
+        // Frees the preloaded track of the client. Invoked from the thread
+        // of the client that needs the memory while the budget is locked,
+        // so implementations must not call back into the budget.
+        virtual void evictPreload() = 0;
+    };
+
+    explicit PreloadBudget(qint64 limitBytes);
+
+    qint64 limitBytes() const {
+        return m_limitBytes;
+    }
+    qint64 reservedBytes() const;
+
+    // Reserves memory for the track of the client and replaces any previous
+    // reservation of the client. Returns false if the budget is exceeded.
+    bool reserve(Client* pClient, qint64 bytes);
+
+    // Releases the reservation of the client, if any.
+    void release(Client* pClient);
+
+  private:
+    struct Reservation {
+        Client* pClient;
+        qint64 bytes;
+    };
+
+    void releaseLocked(Client* pClient);
+
+    const qint64 m_limitBytes;
+
+    mutable QMutex m_mutex;
+    // Ordered by the time of the reservation
+    QList<Reservation> m_reservations;
+    qint64 m_reservedBytes;
+
+    DISALLOW_COPY_AND_ASSIGN(PreloadBudget);
+};
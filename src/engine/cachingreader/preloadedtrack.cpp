@@ -0,0 +1,112 @@
+#include "engine/cachingreader/preloadedtrack.h"
+
+#include <QThread>
+
+#include "engine/cachingreader/cachingreaderchunk.h"
+#include "sources/audiosourcestereoproxy.h"
+#include "util/math.h"
+#include "util/sample.h"
+
+PreloadedTrack::PreloadedTrack(mixxx::IndexRange frameIndexRange)
+        : m_frameIndexRange(frameIndexRange),
+          m_decodedFrameIndexRange(mixxx::IndexRange::forward(frameIndexRange.start(), 0)),
+          m_sampleBuffer(CachingReaderChunk::frames2samples(frameIndexRange.length())) {
+}
+
+// static
+qint64 PreloadedTrack::bytesForFrames(SINT frameCount) {
+    return static_cast<qint64>(CachingReaderChunk::frames2samples(frameCount)) *
+            sizeof(CSAMPLE);
+}
+
+bool PreloadedTrack::decodeNextFrames(
+        const mixxx::AudioSourcePointer& pAudioSource,
+        mixxx::SampleBuffer::WritableSlice tempOutputBuffer,
+        SINT maxFrameCount) {
+    DEBUG_ASSERT(pAudioSource);
+    const auto nextFrameIndexRange = mixxx::IndexRange::forward(
+            m_decodedFrameIndexRange.end(),
+            math_min(maxFrameCount,
+                    m_frameIndexRange.end() - m_decodedFrameIndexRange.end()));
+    if (nextFrameIndexRange.empty()) {
+        return true;
+    }
+    mixxx::AudioSourceStereoProxy audioSourceProxy(
+            pAudioSource,
+            tempOutputBuffer);
+    const auto readableSampleFrames =
+            audioSourceProxy.readSampleFrames(
+                    mixxx::WritableSampleFrames(
+                            nextFrameIndexRange,
+                            mixxx::SampleBuffer::WritableSlice(
+                                    m_sampleBuffer,
+                                    CachingReaderChunk::frames2samples(
+                                            nextFrameIndexRange.start() -
+                                            m_frameIndexRange.start()),
+                                    CachingReaderChunk::frames2samples(
+                                            nextFrameIndexRange.length()))));
+    // The decoded frames must stay contiguous
+    if (readableSampleFrames.frameIndexRange() != nextFrameIndexRange) {
+        return false;
+    }
+    m_decodedFrameIndexRange.growBack(nextFrameIndexRange.length());
+    return true;
+}
+
+const CSAMPLE* PreloadedTrack::samplesOfFrame(SINT frameIndex) const {
+    DEBUG_ASSERT(m_decodedFrameIndexRange.containsIndex(frameIndex));
+    return m_sampleBuffer.data(
+            CachingReaderChunk::frames2samples(frameIndex - m_frameIndexRange.start()));
+}
+
+mixxx::IndexRange PreloadedTrack::readSampleFrames(
+        CSAMPLE* sampleBuffer,
+        const mixxx::IndexRange& frameIndexRange) const {
+    const auto copyableFrameIndexRange =
+            intersect(frameIndexRange, m_decodedFrameIndexRange);
+    if (!copyableFrameIndexRange.empty()) {
+        const SINT dstSampleOffset = CachingReaderChunk::frames2samples(
+                copyableFrameIndexRange.start() - frameIndexRange.start());
+        SampleUtil::copy(
+                sampleBuffer + dstSampleOffset,
+                samplesOfFrame(copyableFrameIndexRange.start()),
+                CachingReaderChunk::frames2samples(copyableFrameIndexRange.length()));
+    }
+    return copyableFrameIndexRange;
+}
+
+mixxx::IndexRange PreloadedTrack::readSampleFramesReverse(
+        CSAMPLE* reverseSampleBuffer,
+        const mixxx::IndexRange& frameIndexRange) const {
+    const auto copyableFrameIndexRange =
+            intersect(frameIndexRange, m_decodedFrameIndexRange);
+    if (!copyableFrameIndexRange.empty()) {
+        const SINT dstSampleOffset = CachingReaderChunk::frames2samples(
+                copyableFrameIndexRange.start() - frameIndexRange.start());
+        const SINT sampleCount =
+                CachingReaderChunk::frames2samples(copyableFrameIndexRange.length());
+        SampleUtil::copyReverse(
+                reverseSampleBuffer - dstSampleOffset - sampleCount,
+                samplesOfFrame(copyableFrameIndexRange.start()),
+                sampleCount);
+    }
+    return copyableFrameIndexRange;
+}
+
+void PreloadedTrackSlot::publish(const PreloadedTrack* pTrack) {
+    DEBUG_ASSERT(pTrack);
+    DEBUG_ASSERT(pTrack->isDecoded());
+    DEBUG_ASSERT(!m_pTrack.load(std::memory_order_relaxed));
+    m_pTrack.store(pTrack);
+}
+
+void PreloadedTrackSlot::unpublish() {
+    if (!m_pTrack.exchange(nullptr)) {
+        return;
+    }
+    // A read that started before the exchange might still access the
+    // track. Reads are short, so just wait for it to finish.
+    while (m_reading.load()) {
+        QThread::yieldCurrentThread();
+    }
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>
+
+#include "sources/audiosource.h"
+#include "util/class.h"
+#include "util/samplebuffer.h"
+
+// A track that is decoded completely into memory by the CachingReaderWorker
+// in the background. Once all frames have been decoded it is published to
+// the CachingReader, which then reads from it directly without requesting
+// any chunks from the worker.
+//
+// The samples are always stored as stereo frames like in the chunks of
+// the CachingReader.
+class PreloadedTrack {
+  public:
+    explicit PreloadedTrack(mixxx::IndexRange frameIndexRange);
+
+    // The number of bytes needed for preloading the given number of frames
+    static qint64 bytesForFrames(SINT frameCount);
+
+    const mixxx::IndexRange& frameIndexRange() const {
+        return m_frameIndexRange;
+    }
+
+    // The leading frames that have been decoded so far
+    const mixxx::IndexRange& decodedFrameIndexRange() const {
+        return m_decodedFrameIndexRange;
+    }
+
+    bool isDecoded() const {
+        return m_decodedFrameIndexRange == m_frameIndexRange;
+    }
+
+    // Decodes up to maxFrameCount frames after the decoded frames. Returns
+    // false if the audio source failed to provide the requested frames.
+    bool decodeNextFrames(
+            const mixxx::AudioSourcePointer& pAudioSource,
+            mixxx::SampleBuffer::WritableSlice tempOutputBuffer,
+            SINT maxFrameCount);
+
+    // Same semantics as CachingReaderChunk::readBufferedSampleFrames()
+    mixxx::IndexRange readSampleFrames(
+            CSAMPLE* sampleBuffer,
+            const mixxx::IndexRange& frameIndexRange) const;
+    mixxx::IndexRange readSampleFramesReverse(
+            CSAMPLE* reverseSampleBuffer,
+            const mixxx::IndexRange& frameIndexRange) const;
+
+  private:
+    const CSAMPLE* samplesOfFrame(SINT frameIndex) const;
+
+    const mixxx::IndexRange m_frameIndexRange;
+    mixxx::IndexRange m_decodedFrameIndexRange;
+    mixxx::SampleBuffer m_sampleBuffer;
+
+    DISALLOW_COPY_AND_ASSIGN(PreloadedTrack);
+};
+
+// Publishes a PreloadedTrack from the worker thread to the engine thread.
+//
+// The engine thread only flags that it is reading from the published
+// track, neither reading nor publishing blocks. The worker must unpublish
+// the track before deleting it, which waits until the engine thread has
+// finished a read that might still access it.
+class PreloadedTrackSlot {
+  public:
+    PreloadedTrackSlot()
+            : m_pTrack(nullptr),
+              m_reading(false) {
+    }
+
+    // Called by the engine thread while reading
+    class ReadScope {
+      public:
+        explicit ReadScope(PreloadedTrackSlot* pSlot)
+                : m_pSlot(pSlot) {
+            m_pSlot->m_reading.store(true);
+            m_pTrack = m_pSlot->m_pTrack.load();
+        }
+        ~ReadScope() {
+            m_pSlot->m_reading.store(false, std::memory_order_release);
+        }
+
+        // The published track or nullptr
+        const PreloadedTrack* track() const {
+            return m_pTrack;
+        }
+
+      private:
+        PreloadedTrackSlot* const m_pSlot;
+        const PreloadedTrack* m_pTrack;
+    };
+
+    // A hint that is not synchronized with reading
+    bool isPublished() const {
+        return m_pTrack.load(std::memory_order_relaxed) != nullptr;
+    }
+
+    // Called by the worker thread
+    void publish(const PreloadedTrack* pTrack);
+    void unpublish();
+
+  private:
+    std::atomic<const PreloadedTrack*> m_pTrack;
+    std::atomic<bool> m_reading;
+
+    DISALLOW_COPY_AND_ASSIGN(PreloadedTrackSlot);
+};
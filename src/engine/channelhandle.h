@@ -212,8 +212,10 @@ class ChannelHandleMap {
 
   private:
     inline void maybeExpand(int iSize) {
-        if (m_data.size() < iSize) {
-            m_data.resize(iSize);
+        // QVarLengthArray::resize() does not initialize the new elements
+        // of types like pointers, so they are appended one by one
+        while (m_data.size() < iSize) {
+            m_data.append(T());
         }
     }
     container_type m_data;
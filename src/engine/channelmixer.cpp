@@ -0,0 +1,190 @@
+#include "engine/channelmixer.h"
+
+#include <algorithm>
+
+#include "util/sample.h"
+#include "util/samplekernels.h"
+
+namespace {
+
+// Number of samples that are mixed per tile. With 16 active channels the
+// input tiles and the output tile (17 * 2 KiB) still fit into a 32 KiB L1
+// data cache. Must be even to keep tiles aligned to stereo frames.
+constexpr unsigned int kTileSamples = 512;
+static_assert(kTileSamples % 2 == 0, "Tiles must contain whole stereo frames");
+
+// A channel that is mixed in the fused tile pass, i.e. without post-fader
+// effects processing or after in-place effects processing.
+struct FusedChannel {
+    CSAMPLE* pBuffer;
+    CSAMPLE_GAIN oldGain;
+    CSAMPLE_GAIN newGain;
+    // The per-frame gain increment of the ramp over the whole buffer, like
+    // computed by SampleUtil::applyRampingGain().
+    CSAMPLE_GAIN gainDelta;
+};
+
+CSAMPLE_GAIN calculateGain(
+        const EngineMaster::GainCalculator& gainCalculator,
+        EngineMaster::ChannelInfo* pChannel,
+        EngineMaster::GainCache* pGainCache,
+        CSAMPLE_GAIN* pOldGain) {
+    *pOldGain = pGainCache->m_gain;
+    CSAMPLE_GAIN newGain;
+    if (pGainCache->m_fadeout) {
+        newGain = 0;
+        pGainCache->m_fadeout = false;
+    } else {
+        newGain = gainCalculator.getGain(pChannel);
+    }
+    pGainCache->m_gain = newGain;
+    return newGain;
+}
+
+// Applies the gain ramp of the channel to the samples of one tile and either
+// adds the result to pOutputTile (inPlace == false) or writes it back to
+// the channel buffer before adding it to pOutputTile (inPlace == true).
+//
+// The ramp is continued across tiles: Frame i of the buffer is scaled by
+// oldGain + gainDelta * (i + 1), matching the ramp of the non-tiled
+// SampleUtil functions up to the rounding of the tile's start gain.
+template<bool inPlace>
+void mixTile(const mixxx::samplekernels::Table& kernels,
+        const FusedChannel& channel,
+        CSAMPLE* pOutputTile,
+        unsigned int tileOffset,
+        unsigned int tileSamples) {
+    CSAMPLE* pInputTile = channel.pBuffer + tileOffset;
+    if (channel.oldGain == CSAMPLE_GAIN_ZERO &&
+            channel.newGain == CSAMPLE_GAIN_ZERO) {
+        if (inPlace) {
+            SampleUtil::clear(pInputTile, tileSamples);
+        }
+        return;
+    }
+    if (channel.gainDelta) {
+        const CSAMPLE_GAIN startGain = channel.oldGain +
+                channel.gainDelta * CSAMPLE_GAIN(tileOffset / 2 + 1);
+        if (inPlace) {
+            kernels.applyRampingGain(pInputTile,
+                    startGain, channel.gainDelta, tileSamples / 2);
+            kernels.add(pOutputTile, pInputTile, tileSamples);
+        } else {
+            kernels.addWithRampingGain(pOutputTile, pInputTile,
+                    startGain, channel.gainDelta, tileSamples / 2);
+        }
+    } else if (channel.oldGain == CSAMPLE_GAIN_ONE) {
+        kernels.add(pOutputTile, pInputTile, tileSamples);
+    } else {
+        if (inPlace) {
+            kernels.applyGain(pInputTile, channel.oldGain, tileSamples);
+            kernels.add(pOutputTile, pInputTile, tileSamples);
+        } else {
+            kernels.addWithGain(pOutputTile, pInputTile,
+                    channel.oldGain, tileSamples);
+        }
+    }
+}
+
+template<bool inPlace>
+void mixChannelsFused(
+        const EngineMaster::GainCalculator& gainCalculator,
+        QVarLengthArray<EngineMaster::ChannelInfo*, kPreallocatedChannels>* activeChannels,
+        QVarLengthArray<EngineMaster::GainCache, kPreallocatedChannels>* channelGainCache,
+        CSAMPLE* pOutput, const ChannelHandle& outputHandle,
+        unsigned int iBufferSize,
+        unsigned int iSampleRate,
+        EngineEffectsManager* pEngineEffectsManager) {
+    // Signal flow overview:
+    // 1. Calculate gains for each channel
+    // 2. Channels with enabled post-fader effects are processed by
+    //    pEngineEffectsManager like in the generated functions.
+    //    If not in place, they are mixed into the cleared pOutput by
+    //    pEngineEffectsManager. In place, they are added unchanged below.
+    // 3. All other channels are scaled and mixed into pOutput tile by tile.
+    //    Each tile of pOutput stays in the L1 cache while all channels are
+    //    added to it and each channel buffer is only read once.
+    QVarLengthArray<FusedChannel, kPreallocatedChannels> fusedChannels;
+    if (!inPlace) {
+        SampleUtil::clear(pOutput, iBufferSize);
+    }
+    const CSAMPLE_GAIN numFrames = CSAMPLE_GAIN(iBufferSize / 2);
+    for (EngineMaster::ChannelInfo* pChannel : *activeChannels) {
+        CSAMPLE_GAIN oldGain;
+        const CSAMPLE_GAIN newGain = calculateGain(gainCalculator, pChannel,
+                &(*channelGainCache)[pChannel->m_index], &oldGain);
+        CSAMPLE* pBuffer = pChannel->m_pBuffer;
+        if (pEngineEffectsManager &&
+                pEngineEffectsManager->postFaderEffectsActiveForChannel(
+                        pChannel->m_handle, outputHandle)) {
+            if (inPlace) {
+                pEngineEffectsManager->processPostFaderInPlace(
+                        pChannel->m_handle, outputHandle, pBuffer,
+                        iBufferSize, iSampleRate, pChannel->m_features,
+                        oldGain, newGain);
+                fusedChannels.append(FusedChannel{
+                        pBuffer, CSAMPLE_GAIN_ONE, CSAMPLE_GAIN_ONE, 0});
+            } else {
+                pEngineEffectsManager->processPostFaderAndMix(
+                        pChannel->m_handle, outputHandle, pBuffer, pOutput,
+                        iBufferSize, iSampleRate, pChannel->m_features,
+                        oldGain, newGain);
+            }
+        } else {
+            fusedChannels.append(FusedChannel{
+                    pBuffer, oldGain, newGain,
+                    (newGain - oldGain) / numFrames});
+        }
+    }
+
+    const mixxx::samplekernels::Table& kernels =
+            mixxx::samplekernels::activeTable();
+    for (unsigned int tileOffset = 0; tileOffset < iBufferSize;
+            tileOffset += kTileSamples) {
+        const unsigned int tileSamples =
+                std::min(kTileSamples, iBufferSize - tileOffset);
+        CSAMPLE* pOutputTile = pOutput + tileOffset;
+        if (inPlace) {
+            // Overwrite the pOutput from the last engine callback
+            SampleUtil::clear(pOutputTile, tileSamples);
+        }
+        for (const FusedChannel& channel : fusedChannels) {
+            mixTile<inPlace>(kernels, channel, pOutputTile,
+                    tileOffset, tileSamples);
+        }
+    }
+}
+
+} // anonymous namespace
+
+// static
+void ChannelMixer::applyEffectsAndMixChannelsFused(
+        const EngineMaster::GainCalculator& gainCalculator,
+        QVarLengthArray<EngineMaster::ChannelInfo*, kPreallocatedChannels>* activeChannels,
+        QVarLengthArray<EngineMaster::GainCache, kPreallocatedChannels>* channelGainCache,
+        CSAMPLE* pOutput, const ChannelHandle& outputHandle,
+        unsigned int iBufferSize,
+        unsigned int iSampleRate,
+        EngineEffectsManager* pEngineEffectsManager) {
+    mixChannelsFused<false>(gainCalculator,
+            activeChannels, channelGainCache,
+            pOutput, outputHandle,
+            iBufferSize, iSampleRate,
+            pEngineEffectsManager);
+}
+
+// static
+void ChannelMixer::applyEffectsInPlaceAndMixChannelsFused(
+        const EngineMaster::GainCalculator& gainCalculator,
+        QVarLengthArray<EngineMaster::ChannelInfo*, kPreallocatedChannels>* activeChannels,
+        QVarLengthArray<EngineMaster::GainCache, kPreallocatedChannels>* channelGainCache,
+        CSAMPLE* pOutput, const ChannelHandle& outputHandle,
+        unsigned int iBufferSize,
+        unsigned int iSampleRate,
+        EngineEffectsManager* pEngineEffectsManager) {
+    mixChannelsFused<true>(gainCalculator,
+            activeChannels, channelGainCache,
+            pOutput, outputHandle,
+            iBufferSize, iSampleRate,
+            pEngineEffectsManager);
+}
@@ -29,6 +29,31 @@ class ChannelMixer {
         unsigned int iBufferSize,
         unsigned int iSampleRate,
         EngineEffectsManager* pEngineEffectsManager);
+
+    // Fused variants of the functions above. The results only differ by the
+    // rounding of the gain ramps. Channels without any enabled post-fader
+    // effects skip the temporary buffer of EngineEffectsManager: Their
+    // gain ramp and the accumulation into pOutput are done in one blocked
+    // pass over cache-sized tiles, so each input buffer is read only once per
+    // callback. Channels with enabled effects are processed as before.
+    // Unlike the generated functions above these are instantiated from a
+    // single template for any number of active channels.
+    static void applyEffectsAndMixChannelsFused(
+        const EngineMaster::GainCalculator& gainCalculator,
+        QVarLengthArray<EngineMaster::ChannelInfo*, kPreallocatedChannels>* activeChannels,
+        QVarLengthArray<EngineMaster::GainCache, kPreallocatedChannels>* channelGainCache,
+        CSAMPLE* pOutput, const ChannelHandle& outputHandle,
+        unsigned int iBufferSize,
+        unsigned int iSampleRate,
+        EngineEffectsManager* pEngineEffectsManager);
+    static void applyEffectsInPlaceAndMixChannelsFused(
+        const EngineMaster::GainCalculator& gainCalculator,
+        QVarLengthArray<EngineMaster::ChannelInfo*, kPreallocatedChannels>* activeChannels,
+        QVarLengthArray<EngineMaster::GainCache, kPreallocatedChannels>* channelGainCache,
+        CSAMPLE* pOutput, const ChannelHandle& outputHandle,
+        unsigned int iBufferSize,
+        unsigned int iSampleRate,
+        EngineEffectsManager* pEngineEffectsManager);
 };
 
 #endif /* CHANNELMIXER_H */
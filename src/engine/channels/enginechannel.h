@@ -68,7 +68,33 @@ class EngineChannel : public EngineObject {
         return m_bIsPrimaryDeck;
     };
 
+    // Called for all active channels one after another before process().
+    // Everything that accesses the state of other channels or of the
+    // EngineSync must be done here, because process() may run concurrently
+    // for different channels.
+    virtual void preProcess(const int iBufferSize) {
+        Q_UNUSED(iBufferSize);
+    }
     virtual void process(CSAMPLE* pOut, const int iBufferSize) = 0;
+
+    // EngineMaster may split process() for batching the pre-fader effects
+    // of all channels, see EngineEffectsManager::prepareBatchedPreFader().
+    // Then processBeforeEffects() is called instead of process(). If it
+    // returns true, prepareEffects() is called for all channels one after
+    // another and processEffects() finishes process() afterwards.
+    virtual bool processBeforeEffects(CSAMPLE* pOut, const int iBufferSize) {
+        process(pOut, iBufferSize);
+        return false;
+    }
+    virtual void prepareEffects(const CSAMPLE* pOut, const int iBufferSize) {
+        Q_UNUSED(pOut);
+        Q_UNUSED(iBufferSize);
+    }
+    virtual void processEffects(CSAMPLE* pOut, const int iBufferSize) {
+        Q_UNUSED(pOut);
+        Q_UNUSED(iBufferSize);
+    }
+
     virtual void collectFeatures(GroupFeatureState* pGroupFeatures) const = 0;
     virtual void postProcess(const int iBuffersize) = 0;
 
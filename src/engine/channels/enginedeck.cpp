@@ -19,6 +19,7 @@
 
 #include "control/controlpushbutton.h"
 #include "effects/effectsmanager.h"
+#include "engine/deckstate.h"
 #include "engine/effects/engineeffectsmanager.h"
 #include "engine/enginebuffer.h"
 #include "engine/enginepregain.h"
@@ -55,6 +56,7 @@ EngineDeck::EngineDeck(const ChannelHandleAndGroup& handle_group,
 
     m_pPregain = new EnginePregain(getGroup());
     m_pBuffer = new EngineBuffer(getGroup(), pConfig, this, pMixingEngine);
+    m_pDeckStatePublisher = DeckStatePublisher::createPublisher(getGroup());
 }
 
 EngineDeck::~EngineDeck() {
@@ -64,6 +66,12 @@ EngineDeck::~EngineDeck() {
 }
 
 void EngineDeck::process(CSAMPLE* pOut, const int iBufferSize) {
+    if (processBeforeEffects(pOut, iBufferSize)) {
+        processEffects(pOut, iBufferSize);
+    }
+}
+
+bool EngineDeck::processBeforeEffects(CSAMPLE* pOut, const int iBufferSize) {
     // Feed the incoming audio through if passthrough is active
     const CSAMPLE* sampleBuffer = m_sampleBuffer; // save pointer on stack
     if (isPassthroughActive() && sampleBuffer) {
@@ -76,7 +84,7 @@ void EngineDeck::process(CSAMPLE* pOut, const int iBufferSize) {
         if (m_bPassthroughWasActive) {
             SampleUtil::clear(pOut, iBufferSize);
             m_bPassthroughWasActive = false;
-            return;
+            return false;
         }
 
         // Process the raw audio
@@ -87,7 +95,19 @@ void EngineDeck::process(CSAMPLE* pOut, const int iBufferSize) {
 
     // Apply pregain
     m_pPregain->process(pOut, iBufferSize);
+    return true;
+}
 
+void EngineDeck::prepareEffects(const CSAMPLE* pOut, const int iBufferSize) {
+    EngineEffectsManager* pEngineEffectsManager = m_pEffectsManager->getEngineEffectsManager();
+    if (pEngineEffectsManager != nullptr) {
+        pEngineEffectsManager->prepareBatchedPreFader(
+            m_group.handle(), m_pEffectsManager->getMasterHandle(),
+            pOut, iBufferSize, m_pSampleRate->get());
+    }
+}
+
+void EngineDeck::processEffects(CSAMPLE* pOut, const int iBufferSize) {
     EngineEffectsManager* pEngineEffectsManager = m_pEffectsManager->getEngineEffectsManager();
     if (pEngineEffectsManager != nullptr) {
         pEngineEffectsManager->processPreFaderInPlace(
@@ -99,6 +119,10 @@ void EngineDeck::process(CSAMPLE* pOut, const int iBufferSize) {
     m_vuMeter.process(pOut, iBufferSize);
 }
 
+void EngineDeck::preProcess(const int iBufferSize) {
+    m_pBuffer->preProcess(iBufferSize);
+}
+
 void EngineDeck::collectFeatures(GroupFeatureState* pGroupFeatures) const {
     m_pBuffer->collectFeatures(pGroupFeatures);
     m_vuMeter.collectFeatures(pGroupFeatures);
@@ -107,6 +131,16 @@ void EngineDeck::collectFeatures(GroupFeatureState* pGroupFeatures) const {
 
 void EngineDeck::postProcess(const int iBufferSize) {
     m_pBuffer->postProcess(iBufferSize);
+    publishDeckState();
+}
+
+void EngineDeck::publishDeckState() {
+    DeckState state;
+    m_pBuffer->fillDeckState(&state);
+    state.vuMeter = m_vuMeter.getVolume();
+    state.vuMeterLeft = m_vuMeter.getVolumeLeft();
+    state.vuMeterRight = m_vuMeter.getVolumeRight();
+    m_pDeckStatePublisher->publish(state);
 }
 
 EngineBuffer* EngineDeck::getEngineBuffer() {
@@ -123,6 +157,8 @@ bool EngineDeck::isActive() {
 
     if (!active && m_wasActive) {
         m_vuMeter.reset();
+        // Inactive decks are not post-processed
+        publishDeckState();
     }
     m_wasActive = active;
     return active;
@@ -19,6 +19,7 @@
 #define ENGINEDECK_H
 
 #include <QScopedPointer>
+#include <QSharedPointer>
 
 #include "preferences/usersettings.h"
 #include "control/controlproxy.h"
@@ -36,6 +37,7 @@ class EngineMaster;
 class EngineVuMeter;
 class EngineEffectsManager;
 class ControlPushButton;
+class DeckStatePublisher;
 
 class EngineDeck : public EngineChannel, public AudioDestination {
     Q_OBJECT
@@ -48,7 +50,11 @@ class EngineDeck : public EngineChannel, public AudioDestination {
             bool primaryDeck);
     virtual ~EngineDeck();
 
+    virtual void preProcess(const int iBufferSize);
     virtual void process(CSAMPLE* pOutput, const int iBufferSize);
+    bool processBeforeEffects(CSAMPLE* pOutput, const int iBufferSize) override;
+    void prepareEffects(const CSAMPLE* pOutput, const int iBufferSize) override;
+    void processEffects(CSAMPLE* pOutput, const int iBufferSize) override;
     virtual void collectFeatures(GroupFeatureState* pGroupFeatures) const;
     virtual void postProcess(const int iBufferSize);
 
@@ -84,9 +90,12 @@ class EngineDeck : public EngineChannel, public AudioDestination {
     void slotPassthroughChangeRequest(double v);
 
   private:
+    void publishDeckState();
+
     UserSettingsPointer m_pConfig;
     EngineBuffer* m_pBuffer;
     EnginePregain* m_pPregain;
+    QSharedPointer<DeckStatePublisher> m_pDeckStatePublisher;
 
     // Begin vinyl passthrough fields
     QScopedPointer<ControlObject> m_pInputConfigured;
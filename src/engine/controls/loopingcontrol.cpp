@@ -460,6 +460,22 @@ void LoopingControl::hintReader(HintVector* pHintList) {
             loop_hint.frameCount = Hint::kFrameCountForward;
             pHintList->append(loop_hint);
         }
+
+        // Prefetch the targets of the beatjump buttons
+        mixxx::BeatsPointer pBeats = m_pBeats;
+        const double beatJumpSize = m_pCOBeatJumpSize->get();
+        if (pBeats && beatJumpSize > 0) {
+            const double currentSample = m_currentSample.getValue();
+            loop_hint.priority = 10;
+            loop_hint.frameCount = Hint::kFrameCountForward;
+            for (const double beats : {beatJumpSize, -beatJumpSize}) {
+                const double target = pBeats->findNBeatsFromSample(currentSample, beats);
+                if (target >= 0) {
+                    loop_hint.frame = SampleUtil::floorPlayPosToFrame(target);
+                    pHintList->append(loop_hint);
+                }
+            }
+        }
     }
 }
 
@@ -871,6 +887,12 @@ bool LoopingControl::isLoopingEnabled() {
     return m_bLoopingEnabled;
 }
 
+void LoopingControl::getLoopPositions(double* pStart, double* pEnd) const {
+    const LoopSamples loopSamples = m_loopSamples.getValue();
+    *pStart = loopSamples.start;
+    *pEnd = loopSamples.end;
+}
+
 void LoopingControl::trackLoaded(TrackPointer pNewTrack) {
     m_pTrack = pNewTrack;
     mixxx::BeatsPointer pBeats;
@@ -53,6 +53,8 @@ class LoopingControl : public EngineControl {
     void notifySeek(double dNewPlaypos) override;
     void setRateControl(RateControl* rateControl);
     bool isLoopingEnabled();
+    // The loop in and loop out samples, kNoTrigger if not set
+    void getLoopPositions(double* pStart, double* pEnd) const;
 
     void trackLoaded(TrackPointer pNewTrack) override;
     void trackBeatsUpdated(mixxx::BeatsPointer pBeats) override;
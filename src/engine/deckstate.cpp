@@ -0,0 +1,42 @@
+#include "engine/deckstate.h"
+
+#include <QMutexLocker>
+
+// static
+QMutex DeckStatePublisher::s_publishersMutex;
+// static
+QMap<QString, QWeakPointer<DeckStatePublisher>> DeckStatePublisher::s_publishers;
+
+DeckStatePublisher::DeckStatePublisher(const QString& group)
+        : m_group(group),
+          m_version(0) {
+}
+
+// static
+QSharedPointer<DeckStatePublisher> DeckStatePublisher::createPublisher(
+        const QString& group) {
+    QMutexLocker locker(&s_publishersMutex);
+    QSharedPointer<DeckStatePublisher> pPublisher = s_publishers.value(group);
+    if (pPublisher.isNull()) {
+        pPublisher = QSharedPointer<DeckStatePublisher>(new DeckStatePublisher(group));
+        s_publishers.insert(group, pPublisher);
+    }
+    return pPublisher;
+}
+
+// static
+QSharedPointer<DeckStatePublisher> DeckStatePublisher::getPublisher(
+        const QString& group) {
+    QMutexLocker locker(&s_publishersMutex);
+    return s_publishers.value(group);
+}
+
+void DeckStatePublisher::publish(const DeckState& state) {
+    ++m_version;
+    for (auto& buffer : m_buffers) {
+        DeckState& writeState = buffer.writeBuffer();
+        writeState = state;
+        writeState.version = m_version;
+        buffer.publish();
+    }
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <QMap>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QString>
+#include <QWeakPointer>
+
+#include "util/class.h"
+#include "util/triplebuffer.h"
+#include "util/types.h"
+
+// A consistent snapshot of the state of a deck at the end of an engine
+// callback.
+struct DeckState {
+    // Incremented with each published snapshot, 0 if nothing has
+    // been published yet
+    quint64 version = 0;
+    // The fraction of the track, like [ChannelN],playposition
+    double playPosition = 0.0;
+    // The effective playback speed including the scratch and the
+    // sample rate ratio, 1.0 for normal playback
+    double rate = 0.0;
+    // Like [ChannelN],beat_distance
+    double beatDistance = 0.0;
+    // In samples, like [ChannelN],loop_start_position and
+    // [ChannelN],loop_end_position. -1 if not set.
+    double loopStartPosition = -1.0;
+    double loopEndPosition = -1.0;
+    bool loopEnabled = false;
+    double trackSamples = 0.0;
+    // Like [ChannelN],VuMeter, [ChannelN],VuMeterL and [ChannelN],VuMeterR
+    CSAMPLE vuMeter = 0;
+    CSAMPLE vuMeterLeft = 0;
+    CSAMPLE vuMeterRight = 0;
+};
+
+// Hands the DeckState over from the engine to the GUI and the controllers
+// once per callback without locking or waiting on either side. This saves
+// the readers from polling each of the underlying controls separately.
+//
+// Each reader thread has its own triple buffer. The snapshot returned by
+// read() is only valid on the thread of the reader until its next read().
+class DeckStatePublisher {
+  public:
+    enum class Reader {
+        // The main thread, i.e. the widgets
+        Gui = 0,
+        // The thread of the ControllerManager, i.e. the controller scripts
+        Controllers,
+    };
+    static constexpr int kReaderCount = static_cast<int>(Reader::Controllers) + 1;
+
+    // Creates the publisher for a deck. Called by the engine.
+    static QSharedPointer<DeckStatePublisher> createPublisher(const QString& group);
+    // Returns nullptr if the group is not a deck
+    static QSharedPointer<DeckStatePublisher> getPublisher(const QString& group);
+
+    const QString& getGroup() const {
+        return m_group;
+    }
+
+    // Engine thread
+    void publish(const DeckState& state);
+
+    // The latest published snapshot
+    const DeckState& read(Reader reader) {
+        TripleBuffer<DeckState>& buffer = m_buffers[static_cast<int>(reader)];
+        buffer.update();
+        return buffer.readBuffer();
+    }
+
+  private:
+    explicit DeckStatePublisher(const QString& group);
+
+    static QMutex s_publishersMutex;
+    static QMap<QString, QWeakPointer<DeckStatePublisher>> s_publishers;
+
+    const QString m_group;
+    // Engine thread only
+    quint64 m_version;
+    TripleBuffer<DeckState> m_buffers[kReaderCount];
+
+    DISALLOW_COPY_AND_ASSIGN(DeckStatePublisher);
+};
@@ -136,29 +136,31 @@ bool EngineEffect::processEffectsRequest(EffectsRequest& message,
     return false;
 }
 
-bool EngineEffect::process(const ChannelHandle& inputHandle,
-                           const ChannelHandle& outputHandle,
-                           const CSAMPLE* pInput, CSAMPLE* pOutput,
-                           const unsigned int numSamples,
-                           const unsigned int sampleRate,
-                           const EffectEnableState chainEnableState,
-                           const GroupFeatureState& groupFeatures) {
-    // Compute the effective enable state from the combination of the effect's state
-    // for the channel and the state passed from the EngineEffectChain.
-
-    // When the chain's input routing switch or chain enable switches are changed,
-    // the chain sends an intermediate enabling/disabling signal. The chain also sends
-    // intermediate enabling/disabling signals when its dry/wet knob is turned down to
-    // fully dry then turned back up to let some wet signal through.
-
-    // Analagously, when the Effect is switched on/off, it sends this EngineEffect an
-    // intermediate enabling/disabling signal.
-
-    // The effective enable state is then passed down to the EffectProcessor, which is
-    // responsible for taking appropriate action when it gets an intermediate
-    // enabling/disabling signal. For example, the Echo effect clears its
-    // internal buffer for the channel when it gets the intermediate disabling signal.
+bool EngineEffect::updateParameter(const EffectParameterUpdate& update) {
+    if (kEffectDebugOutput) {
+        qDebug() << debugString() << "SET_PARAMETER_BATCH"
+                 << "parameter" << update.iParameter
+                 << "minimum" << update.minimum
+                 << "maximum" << update.maximum
+                 << "default_value" << update.default_value
+                 << "value" << update.value;
+    }
+    EngineEffectParameter* pParameter =
+            m_parameters.value(update.iParameter, NULL);
+    if (!pParameter) {
+        return false;
+    }
+    pParameter->setMinimum(update.minimum);
+    pParameter->setMaximum(update.maximum);
+    pParameter->setDefaultValue(update.default_value);
+    pParameter->setValue(update.value);
+    return true;
+}
 
+EffectEnableState EngineEffect::effectiveEnableState(
+        const ChannelHandle& inputHandle,
+        const ChannelHandle& outputHandle,
+        const EffectEnableState chainEnableState) {
     EffectEnableState effectiveEffectEnableState =
         m_effectEnableStateForChannelMatrix[inputHandle][outputHandle];
 
@@ -185,6 +187,53 @@ bool EngineEffect::process(const ChannelHandle& inputHandle,
             }
         }
     }
+    return effectiveEffectEnableState;
+}
+
+bool EngineEffect::prepareBatch(const ChannelHandle& inputHandle,
+                                const ChannelHandle& outputHandle,
+                                const CSAMPLE* pInput,
+                                const unsigned int numSamples,
+                                const unsigned int sampleRate,
+                                const EffectEnableState chainEnableState,
+                                EngineFilterIIRBatch* pBatch) {
+    const EffectEnableState effectiveEffectEnableState =
+            effectiveEnableState(inputHandle, outputHandle, chainEnableState);
+    if (effectiveEffectEnableState == EffectEnableState::Enabled) {
+        const mixxx::EngineParameters bufferParameters(
+              mixxx::audio::SampleRate(sampleRate),
+              numSamples / mixxx::kEngineChannelCount);
+        m_pProcessor->prepareBatch(inputHandle, outputHandle, pInput,
+                                   bufferParameters, pBatch);
+    }
+    return effectiveEffectEnableState != EffectEnableState::Disabled;
+}
+
+bool EngineEffect::process(const ChannelHandle& inputHandle,
+                           const ChannelHandle& outputHandle,
+                           const CSAMPLE* pInput, CSAMPLE* pOutput,
+                           const unsigned int numSamples,
+                           const unsigned int sampleRate,
+                           const EffectEnableState chainEnableState,
+                           const GroupFeatureState& groupFeatures) {
+    // Compute the effective enable state from the combination of the effect's state
+    // for the channel and the state passed from the EngineEffectChain.
+
+    // When the chain's input routing switch or chain enable switches are changed,
+    // the chain sends an intermediate enabling/disabling signal. The chain also sends
+    // intermediate enabling/disabling signals when its dry/wet knob is turned down to
+    // fully dry then turned back up to let some wet signal through.
+
+    // Analagously, when the Effect is switched on/off, it sends this EngineEffect an
+    // intermediate enabling/disabling signal.
+
+    // The effective enable state is then passed down to the EffectProcessor, which is
+    // responsible for taking appropriate action when it gets an intermediate
+    // enabling/disabling signal. For example, the Echo effect clears its
+    // internal buffer for the channel when it gets the intermediate disabling signal.
+
+    const EffectEnableState effectiveEffectEnableState =
+            effectiveEnableState(inputHandle, outputHandle, chainEnableState);
 
     bool processingOccured = false;
 
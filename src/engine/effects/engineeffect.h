@@ -17,6 +17,8 @@
 #include "engine/effects/message.h"
 #include "engine/effects/groupfeaturestate.h"
 
+class EngineFilterIIRBatch;
+
 class EngineEffect : public EffectsRequestHandler {
   public:
     EngineEffect(EffectManifestPointer pManifest,
@@ -43,6 +45,10 @@ class EngineEffect : public EffectsRequestHandler {
         EffectsRequest& message,
         EffectsResponsePipe* pResponsePipe);
 
+    // Applies an update of a SET_PARAMETER_BATCH request. Returns false if
+    // there is no such parameter.
+    bool updateParameter(const EffectParameterUpdate& update);
+
     bool process(const ChannelHandle& inputHandle, const ChannelHandle& outputHandle,
                  const CSAMPLE* pInput, CSAMPLE* pOutput,
                  const unsigned int numSamples,
@@ -50,6 +56,17 @@ class EngineEffect : public EffectsRequestHandler {
                  const EffectEnableState chainEnableState,
                  const GroupFeatureState& groupFeatures);
 
+    // Lets the processor prepare the batched work for the following
+    // process(), see EffectProcessor::prepareBatch(). Returns true if
+    // process() will process the channel.
+    bool prepareBatch(const ChannelHandle& inputHandle,
+                      const ChannelHandle& outputHandle,
+                      const CSAMPLE* pInput,
+                      const unsigned int numSamples,
+                      const unsigned int sampleRate,
+                      const EffectEnableState chainEnableState,
+                      EngineFilterIIRBatch* pBatch);
+
     const EffectManifestPointer getManifest() const {
         return m_pManifest;
     }
@@ -59,6 +76,10 @@ class EngineEffect : public EffectsRequestHandler {
         return QString("EngineEffect(%1)").arg(m_pManifest->name());
     }
 
+    EffectEnableState effectiveEnableState(const ChannelHandle& inputHandle,
+                                           const ChannelHandle& outputHandle,
+                                           const EffectEnableState chainEnableState);
+
     EffectManifestPointer m_pManifest;
     EffectProcessor* m_pProcessor;
     ChannelHandleMap<ChannelHandleMap<EffectEnableState>> m_effectEnableStateForChannelMatrix;
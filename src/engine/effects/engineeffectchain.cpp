@@ -162,6 +162,10 @@ bool EngineEffectChain::enableForInputChannel(const ChannelHandle* inputHandle,
             return false;
         }
         outputChannelStatus.enableState = EffectEnableState::Enabling;
+        // process() is not called for channels that are not routed to
+        // any active chain. Start ramping from the current mix knob
+        // instead of a stale value from the last time it was routed.
+        outputChannelStatus.oldMixKnob = m_dMix;
     }
     for (int i = 0; i < m_effects.size(); ++i) {
         if (m_effects[i] != nullptr) {
@@ -179,6 +183,14 @@ bool EngineEffectChain::enableForInputChannel(const ChannelHandle* inputHandle,
     return true;
 }
 
+bool EngineEffectChain::activeForChannel(const ChannelHandle& inputHandle,
+                                         const ChannelHandle& outputHandle) {
+    // The chain's own enable state cannot activate a channel that has
+    // not been routed to this chain, see process().
+    const ChannelStatus& channelStatus = getChannelStatus(inputHandle, outputHandle);
+    return channelStatus.enableState != EffectEnableState::Disabled;
+}
+
 bool EngineEffectChain::disableForInputChannel(const ChannelHandle* inputHandle) {
     auto& outputMap = m_chainStatusForChannelMatrix[*inputHandle];
     for (auto&& outputChannelStatus : outputMap) {
@@ -226,6 +238,44 @@ EngineEffectChain::ChannelStatus& EngineEffectChain::getChannelStatus(
     return status;
 }
 
+EffectEnableState EngineEffectChain::effectiveEnableState(
+        const ChannelStatus& channelStatus) const {
+    EffectEnableState effectiveChainEnableState = channelStatus.enableState;
+
+    // If the channel is fully disabled, do not let intermediate
+    // enabling/disabing signals from the chain's enable switch override
+    // the channel's state.
+    if (effectiveChainEnableState != EffectEnableState::Disabled) {
+        if (m_enableState != EffectEnableState::Enabled) {
+            effectiveChainEnableState = m_enableState;
+        }
+    }
+    return effectiveChainEnableState;
+}
+
+bool EngineEffectChain::prepareBatch(const ChannelHandle& inputHandle,
+                                     const ChannelHandle& outputHandle,
+                                     const CSAMPLE* pIn,
+                                     const unsigned int numSamples,
+                                     const unsigned int sampleRate,
+                                     EngineFilterIIRBatch* pBatch) {
+    const EffectEnableState effectiveChainEnableState = effectiveEnableState(
+            getChannelStatus(inputHandle, outputHandle));
+    if (effectiveChainEnableState == EffectEnableState::Disabled) {
+        return false;
+    }
+    // Only the first effect that processes the channel gets pIn, see process()
+    for (EngineEffect* pEffect: m_effects) {
+        if (pEffect != nullptr &&
+                pEffect->prepareBatch(inputHandle, outputHandle, pIn,
+                                      numSamples, sampleRate,
+                                      effectiveChainEnableState, pBatch)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 bool EngineEffectChain::process(const ChannelHandle& inputHandle,
                                 const ChannelHandle& outputHandle,
                                 CSAMPLE* pIn, CSAMPLE* pOut,
@@ -241,16 +291,8 @@ bool EngineEffectChain::process(const ChannelHandle& inputHandle,
     // when it gets the intermediate disabling signal.
 
     ChannelStatus& channelStatus = m_chainStatusForChannelMatrix[inputHandle][outputHandle];
-    EffectEnableState effectiveChainEnableState = channelStatus.enableState;
-
-    // If the channel is fully disabled, do not let intermediate
-    // enabling/disabing signals from the chain's enable switch override
-    // the channel's state.
-    if (effectiveChainEnableState != EffectEnableState::Disabled) {
-        if (m_enableState != EffectEnableState::Enabled) {
-            effectiveChainEnableState = m_enableState;
-        }
-    }
+    const EffectEnableState effectiveChainEnableState =
+            effectiveEnableState(channelStatus);
 
     CSAMPLE currentMixKnob = m_dMix;
     CSAMPLE lastCallbackMixKnob = channelStatus.oldMixKnob;
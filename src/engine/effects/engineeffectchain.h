@@ -13,6 +13,7 @@
 #include "effects/effectchain.h"
 
 class EngineEffect;
+class EngineFilterIIRBatch;
 
 class EngineEffectChain : public EffectsRequestHandler {
   public:
@@ -32,12 +33,28 @@ class EngineEffectChain : public EffectsRequestHandler {
                  const unsigned int sampleRate,
                  const GroupFeatureState& groupFeatures);
 
+    // Lets the first effect that processes the channel prepare its batched
+    // work for the following process(), see EffectProcessor::prepareBatch().
+    // Returns true if process() will modify the channel.
+    bool prepareBatch(const ChannelHandle& inputHandle,
+                      const ChannelHandle& outputHandle,
+                      const CSAMPLE* pIn,
+                      const unsigned int numSamples,
+                      const unsigned int sampleRate,
+                      EngineFilterIIRBatch* pBatch);
+
     const QString& id() const {
         return m_id;
     }
 
     bool enabledForChannel(const ChannelHandle& handle) const;
 
+    // Returns false if process() would neither produce output nor have to
+    // send an intermediate enabling/disabling signal for this channel
+    // combination, i.e. if calling process() can be skipped.
+    bool activeForChannel(const ChannelHandle& inputHandle,
+                          const ChannelHandle& outputHandle);
+
     void deleteStatesForInputChannel(const ChannelHandle* channel);
 
   private:
@@ -54,6 +71,9 @@ class EngineEffectChain : public EffectsRequestHandler {
         return QString("EngineEffectChain(%1)").arg(m_id);
     }
 
+    // The enable state that process() passes to the effects
+    EffectEnableState effectiveEnableState(const ChannelStatus& channelStatus) const;
+
     bool updateParameters(const EffectsRequest& message);
     bool addEffect(EngineEffect* pEffect, int iIndex);
     bool removeEffect(EngineEffect* pEffect, int iIndex);
@@ -44,6 +44,24 @@ bool EngineEffectRack::processEffectsRequest(EffectsRequest& message,
     return true;
 }
 
+bool EngineEffectRack::prepareBatch(const ChannelHandle& inputHandle,
+                                    const ChannelHandle& outputHandle,
+                                    const CSAMPLE* pIn,
+                                    const unsigned int numSamples,
+                                    const unsigned int sampleRate,
+                                    EngineFilterIIRBatch* pBatch) {
+    // The chains are applied in place, so only the first one that modifies
+    // the channel gets pIn
+    for (EngineEffectChain* pChain : m_chains) {
+        if (pChain != nullptr &&
+                pChain->prepareBatch(inputHandle, outputHandle, pIn,
+                                     numSamples, sampleRate, pBatch)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 bool EngineEffectRack::process(const ChannelHandle& inputHandle,
                                const ChannelHandle& outputHandle,
                                CSAMPLE* pIn, CSAMPLE* pOut,
@@ -138,3 +156,14 @@ bool EngineEffectRack::removeEffectChain(EngineEffectChain* pChain, int iIndex)
     m_chains.replace(iIndex, NULL);
     return true;
 }
+
+bool EngineEffectRack::activeForChannel(const ChannelHandle& inputHandle,
+                                        const ChannelHandle& outputHandle) {
+    for (EngineEffectChain* pChain : m_chains) {
+        if (pChain != nullptr &&
+                pChain->activeForChannel(inputHandle, outputHandle)) {
+            return true;
+        }
+    }
+    return false;
+}
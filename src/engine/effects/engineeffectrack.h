@@ -9,6 +9,7 @@
 #include "util/samplebuffer.h"
 
 class EngineEffectChain;
+class EngineFilterIIRBatch;
 
 //TODO(Be): Remove this superfluous class.
 class EngineEffectRack : public EffectsRequestHandler {
@@ -27,6 +28,21 @@ class EngineEffectRack : public EffectsRequestHandler {
                  const unsigned int sampleRate,
                  const GroupFeatureState& groupFeatures);
 
+    // Lets the chains prepare the batched work for the following in place
+    // process(), see EngineEffectChain::prepareBatch(). Returns true if
+    // process() will modify the channel.
+    bool prepareBatch(const ChannelHandle& inputHandle,
+                      const ChannelHandle& outputHandle,
+                      const CSAMPLE* pIn,
+                      const unsigned int numSamples,
+                      const unsigned int sampleRate,
+                      EngineFilterIIRBatch* pBatch);
+
+    // Returns true if any chain of this rack needs to be processed for
+    // this channel combination.
+    bool activeForChannel(const ChannelHandle& inputHandle,
+                          const ChannelHandle& outputHandle);
+
     int number() const {
         return m_iRackNumber;
     }
@@ -5,6 +5,7 @@
 #include "engine/effects/engineeffect.h"
 
 #include "util/defs.h"
+#include "util/performancetimer.h"
 #include "util/sample.h"
 
 EngineEffectsManager::EngineEffectsManager(EffectsResponsePipe* pResponsePipe)
@@ -107,6 +108,14 @@ void EngineEffectsManager::onCallbackStart() {
                     response.status = EffectsResponse::INVALID_REQUEST;
                 }
                 break;
+            case EffectsRequest::SET_PARAMETER_BATCH:
+                VERIFY_OR_DEBUG_ASSERT(request->SetParameterBatch.pBatch) {
+                    response.success = false;
+                    response.status = EffectsResponse::INVALID_REQUEST;
+                    break;
+                }
+                applyParameterBatch(*request->SetParameterBatch.pBatch, &response);
+                break;
             default:
                 response.success = false;
                 response.status = EffectsResponse::UNHANDLED_MESSAGE_TYPE;
@@ -119,6 +128,32 @@ void EngineEffectsManager::onCallbackStart() {
     }
 }
 
+void EngineEffectsManager::applyParameterBatch(
+        const EffectParameterBatch& batch,
+        EffectsResponse* pResponse) {
+    pResponse->success = true;
+    // The updates of an effect are usually adjacent, so the effect is only
+    // looked up when it changes.
+    const EngineEffect* pCheckedEffect = nullptr;
+    bool effectExists = false;
+    for (int i = 0; i < batch.size; ++i) {
+        const EffectParameterUpdate& update = batch.updates[i];
+        if (update.pEffect != pCheckedEffect) {
+            pCheckedEffect = update.pEffect;
+            effectExists = m_effects.contains(update.pEffect);
+        }
+        VERIFY_OR_DEBUG_ASSERT(effectExists) {
+            pResponse->success = false;
+            pResponse->status = EffectsResponse::NO_SUCH_EFFECT;
+            continue;
+        }
+        if (!update.pEffect->updateParameter(update)) {
+            pResponse->success = false;
+            pResponse->status = EffectsResponse::NO_SUCH_PARAMETER;
+        }
+    }
+}
+
 void EngineEffectsManager::processPreFaderInPlace(const ChannelHandle& inputHandle,
                                                   const ChannelHandle& outputHandle,
                                                   CSAMPLE* pInOut,
@@ -136,6 +171,29 @@ void EngineEffectsManager::processPreFaderInPlace(const ChannelHandle& inputHand
                  numSamples, sampleRate, featureState);
 }
 
+void EngineEffectsManager::prepareBatchedPreFader(const ChannelHandle& inputHandle,
+                                                  const ChannelHandle& outputHandle,
+                                                  const CSAMPLE* pIn,
+                                                  const unsigned int numSamples,
+                                                  const unsigned int sampleRate) {
+    // The racks are applied in place, so only the first one that modifies
+    // the channel gets pIn
+    const QList<EngineEffectRack*>& racks =
+            m_racksByStage.value(SignalProcessingStage::Prefader);
+    for (EngineEffectRack* pRack : racks) {
+        if (pRack != nullptr &&
+                pRack->prepareBatch(inputHandle, outputHandle, pIn,
+                                    numSamples, sampleRate,
+                                    &m_preFaderFilterBatch)) {
+            return;
+        }
+    }
+}
+
+void EngineEffectsManager::processPreFaderBatch(const unsigned int numSamples) {
+    m_preFaderFilterBatch.process(numSamples);
+}
+
 void EngineEffectsManager::processPostFaderInPlace(
     const ChannelHandle& inputHandle,
     const ChannelHandle& outputHandle,
@@ -145,11 +203,14 @@ void EngineEffectsManager::processPostFaderInPlace(
     const GroupFeatureState& groupFeatures,
     const CSAMPLE_GAIN oldGain,
     const CSAMPLE_GAIN newGain) {
+    PerformanceTimer timer;
+    timer.start();
     processInner(SignalProcessingStage::Postfader,
                  inputHandle, outputHandle,
                  pInOut, pInOut,
                  numSamples, sampleRate, groupFeatures,
                  oldGain, newGain);
+    m_postFaderProcessDuration += timer.elapsed();
 }
 
 void EngineEffectsManager::processPostFaderAndMix(
@@ -161,11 +222,28 @@ void EngineEffectsManager::processPostFaderAndMix(
     const GroupFeatureState& groupFeatures,
     const CSAMPLE_GAIN oldGain,
     const CSAMPLE_GAIN newGain) {
+    PerformanceTimer timer;
+    timer.start();
     processInner(SignalProcessingStage::Postfader,
                  inputHandle, outputHandle,
                  pIn, pOut,
                  numSamples, sampleRate, groupFeatures,
                  oldGain, newGain);
+    m_postFaderProcessDuration += timer.elapsed();
+}
+
+bool EngineEffectsManager::postFaderEffectsActiveForChannel(
+    const ChannelHandle& inputHandle,
+    const ChannelHandle& outputHandle) {
+    const QList<EngineEffectRack*>& racks =
+            m_racksByStage.value(SignalProcessingStage::Postfader);
+    for (EngineEffectRack* pRack : racks) {
+        if (pRack != nullptr &&
+                pRack->activeForChannel(inputHandle, outputHandle)) {
+            return true;
+        }
+    }
+    return false;
 }
 
 void EngineEffectsManager::processInner(
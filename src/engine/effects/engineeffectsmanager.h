@@ -3,12 +3,14 @@
 
 #include <QScopedPointer>
 
+#include "util/duration.h"
 #include "util/samplebuffer.h"
 #include "util/types.h"
 #include "util/fifo.h"
 #include "engine/effects/message.h"
 #include "engine/effects/groupfeaturestate.h"
 #include "engine/channelhandle.h"
+#include "engine/filters/enginefilteriirbatch.h"
 
 class EngineEffectRack;
 class EngineEffectChain;
@@ -35,6 +37,19 @@ class EngineEffectsManager : public EffectsRequestHandler {
         const unsigned int numSamples,
         const unsigned int sampleRate);
 
+    // The pre-fader effects of several channels can share work, e.g. the
+    // equalizers of all decks filter the same bands in one batch. For this
+    // the channels call prepareBatchedPreFader() one after another with the
+    // buffer that they pass to processPreFaderInPlace() afterwards, and
+    // processPreFaderBatch() runs the collected work in between.
+    void prepareBatchedPreFader(
+        const ChannelHandle& inputHandle,
+        const ChannelHandle& outputHandle,
+        const CSAMPLE* pIn,
+        const unsigned int numSamples,
+        const unsigned int sampleRate);
+    void processPreFaderBatch(const unsigned int numSamples);
+
     void processPostFaderInPlace(
         const ChannelHandle& inputHandle,
         const ChannelHandle& outputHandle,
@@ -55,10 +70,25 @@ class EngineEffectsManager : public EffectsRequestHandler {
         const CSAMPLE_GAIN oldGain = CSAMPLE_GAIN_ONE,
         const CSAMPLE_GAIN newGain = CSAMPLE_GAIN_ONE);
 
+    // Returns false if the post-fader effects processing for this channel
+    // combination would only apply the gain, e.g. because no effect chain
+    // is enabled for the channel. In that case the caller can apply the gain
+    // and mix the channel itself without calling processPostFader*().
+    bool postFaderEffectsActiveForChannel(
+        const ChannelHandle& inputHandle,
+        const ChannelHandle& outputHandle);
+
     bool processEffectsRequest(
         EffectsRequest& message,
         EffectsResponsePipe* pResponsePipe);
 
+    // The accumulated time spent in post-fader effects processing. Only
+    // to be called from the engine thread, e.g. for comparing it before
+    // and after a part of the callback.
+    mixxx::Duration getPostFaderProcessDuration() const {
+        return m_postFaderProcessDuration;
+    }
+
   private:
     QString debugString() const {
         return QString("EngineEffectsManager");
@@ -73,6 +103,11 @@ class EngineEffectsManager : public EffectsRequestHandler {
     bool addPostFaderEffectRack(EngineEffectRack* pRack);
     bool removePostFaderEffectRack(EngineEffectRack* pRack);
 
+    // Applies all parameter updates of a SET_PARAMETER_BATCH request, so that
+    // they take effect in the same callback.
+    void applyParameterBatch(const EffectParameterBatch& batch,
+            EffectsResponse* pResponse);
+
     void processInner(const SignalProcessingStage stage,
                       const ChannelHandle& inputHandle,
                       const ChannelHandle& outputHandle,
@@ -90,6 +125,10 @@ class EngineEffectsManager : public EffectsRequestHandler {
 
     mixxx::SampleBuffer m_buffer1;
     mixxx::SampleBuffer m_buffer2;
+
+    EngineFilterIIRBatch m_preFaderFilterBatch;
+
+    mixxx::Duration m_postFaderProcessDuration;
 };
 
 
@@ -14,11 +14,40 @@ class EngineEffectRack;
 class EngineEffectChain;
 class EngineEffect;
 
+// The new parameters of an EffectParameter for its EngineEffectParameter
+struct EffectParameterUpdate {
+    EngineEffect* pEffect;
+    int iParameter;
+    double minimum;
+    double maximum;
+    double default_value;
+    double value;
+};
+
+// The parameter updates that are applied at once at the start of an audio
+// callback. The batches are allocated and recycled by the EffectsManager, so
+// that applying them does not allocate or free memory in the engine thread.
+struct EffectParameterBatch {
+    static constexpr int kCapacity = 64;
+
+    EffectParameterBatch()
+            : size(0) {
+    }
+
+    bool isFull() const {
+        return size >= kCapacity;
+    }
+
+    int size;
+    EffectParameterUpdate updates[kCapacity];
+};
+
 struct EffectsRequest {
     enum MessageType {
         // Messages for EngineEffectsManager
         ADD_EFFECT_RACK = 0,
         REMOVE_EFFECT_RACK,
+        SET_PARAMETER_BATCH,
 
         // Messages for EngineEffectRack
         ADD_CHAIN_TO_RACK,
@@ -63,6 +92,7 @@ struct EffectsRequest {
         CLEAR_STRUCT(SetEffectChainParameters);
         CLEAR_STRUCT(SetEffectParameters);
         CLEAR_STRUCT(SetParameterParameters);
+        CLEAR_STRUCT(SetParameterBatch);
 #undef CLEAR_STRUCT
     }
 
@@ -145,6 +175,9 @@ struct EffectsRequest {
         struct {
             int iParameter;
         } SetParameterParameters;
+        struct {
+            EffectParameterBatch* pBatch;
+        } SetParameterBatch;
     };
 
     // Used by SET_EFFECT_PARAMETER.
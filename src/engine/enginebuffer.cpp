@@ -21,6 +21,7 @@
 #include "engine/controls/loopingcontrol.h"
 #include "engine/controls/quantizecontrol.h"
 #include "engine/controls/ratecontrol.h"
+#include "engine/deckstate.h"
 #include "engine/enginemaster.h"
 #include "engine/engineworkerscheduler.h"
 #include "engine/readaheadmanager.h"
@@ -35,6 +36,7 @@
 #include "util/defs.h"
 #include "util/logger.h"
 #include "util/math.h"
+#include "util/performancetimer.h"
 #include "util/sample.h"
 #include "util/timer.h"
 #include "waveform/visualplayposition.h"
@@ -70,7 +72,9 @@ EngineBuffer::EngineBuffer(const QString& group,
           m_filepos_play(DBL_MIN),
           m_speed_old(0),
           m_tempo_ratio_old(1.),
+          m_beatDistanceOld(0.0),
           m_scratching_old(false),
+          m_bStopAtEndOfTrack(false),
           m_reverse_old(false),
           m_pitch_old(0),
           m_baserate_old(0),
@@ -97,7 +101,10 @@ EngineBuffer::EngineBuffer(const QString& group,
     // zero out crossfade buffer
     SampleUtil::clear(m_pCrossfadeBuffer, MAX_BUFFER_LEN);
 
-    m_pReader = new CachingReader(group, pConfig);
+    m_pReader = new CachingReader(group,
+            pConfig,
+            pMixingEngine->getPreloadBudget(),
+            pMixingEngine->getPcmCache());
     connect(m_pReader, &CachingReader::trackLoading,
             this, &EngineBuffer::slotTrackLoading,
             Qt::DirectConnection);
@@ -166,6 +173,9 @@ EngineBuffer::EngineBuffer(const QString& group,
     m_pKeylockEngine = new ControlProxy("[Master]", "keylock_engine", this);
     m_pKeylockEngine->connectValueChanged(this, &EngineBuffer::slotKeylockEngineChanged,
                                           Qt::DirectConnection);
+    m_pKeylockLookahead = new ControlProxy("[Master]", "keylock_lookahead", this);
+    m_pKeylockLookahead->connectValueChanged(this, &EngineBuffer::slotKeylockLookaheadChanged,
+                                             Qt::DirectConnection);
 
     m_pTrackSamples = new ControlObject(ConfigKey(m_group, "track_samples"));
     m_pTrackSampleRate = new ControlObject(ConfigKey(m_group, "track_samplerate"));
@@ -173,6 +183,11 @@ EngineBuffer::EngineBuffer(const QString& group,
     m_pKeylock = new ControlPushButton(ConfigKey(m_group, "keylock"), true);
     m_pKeylock->setButtonMode(ControlPushButton::TOGGLE);
 
+    // Cubic instead of linear interpolation when playing without keylock
+    m_pVinylInterpolation = new ControlPushButton(
+            ConfigKey(m_group, "vinyl_interpolation"), true);
+    m_pVinylInterpolation->setButtonMode(ControlPushButton::TOGGLE);
+
     m_pEject = new ControlPushButton(ConfigKey(m_group, "eject"));
     connect(m_pEject, &ControlObject::valueChanged,
             this, &EngineBuffer::slotEjectTrack,
@@ -239,7 +254,7 @@ EngineBuffer::EngineBuffer(const QString& group,
     // Construct scaling objects
     m_pScaleLinear = new EngineBufferScaleLinear(m_pReadAheadManager);
     m_pScaleST = new EngineBufferScaleST(m_pReadAheadManager);
-    m_pScaleRB = new EngineBufferScaleRubberBand(m_pReadAheadManager);
+    m_pScaleRB = new EngineBufferScaleRubberBand(m_pReadAheadManager, group);
     if (m_pKeylockEngine->get() == SOUNDTOUCH) {
         m_pScaleKeylock = m_pScaleST;
     } else {
@@ -297,6 +312,7 @@ EngineBuffer::~EngineBuffer() {
     delete m_pScaleRB;
 
     delete m_pKeylock;
+    delete m_pVinylInterpolation;
     delete m_pEject;
 
     SampleUtil::free(m_pCrossfadeBuffer);
@@ -427,7 +443,10 @@ void EngineBuffer::readToCrossfadeBuffer(const int iBufferSize) {
     if (!m_bCrossfadeReady) {
         // Read buffer, as if there where no parameter change
         // (Must be called only once per callback)
+        PerformanceTimer scaleTimer;
+        scaleTimer.start();
         m_pScale->scaleBuffer(m_pCrossfadeBuffer, iBufferSize);
+        m_lastScaleDuration += scaleTimer.elapsed();
         // Restore the original position that was lost due to scaleBuffer() above
         m_pReadAheadManager->notifySeek(m_filepos_play);
         m_bCrossfadeReady = true;
@@ -712,6 +731,10 @@ void EngineBuffer::slotKeylockEngineChanged(double dIndex) {
     }
 }
 
+void EngineBuffer::slotKeylockLookaheadChanged(double enabled) {
+    m_pScaleRB->setLookaheadEnabled(enabled > 0.0);
+}
+
 void EngineBuffer::processTrackLocked(
         CSAMPLE* pOutput, const int iBufferSize, int sample_rate) {
     ScopedTimer t("EngineBuffer::process_pauselock");
@@ -724,9 +747,6 @@ void EngineBuffer::processTrackLocked(
         baserate = m_trackSampleRateOld / sample_rate;
     }
 
-    // Sync requests can affect rate, so process those first.
-    processSyncRequests();
-
     // Note: play is also active during cue preview
     bool paused = !m_playButton->toBool();
     KeyControl::PitchTempoRatio pitchTempoRatio = m_pKeyControl->getPitchTempoRatio();
@@ -867,6 +887,10 @@ void EngineBuffer::processTrackLocked(
         requestSyncPhase();
     }
 
+    m_pScaleLinear->setInterpolation(m_pVinylInterpolation->toBool()
+                    ? EngineBufferScaleLinear::Interpolation::Cubic
+                    : EngineBufferScaleLinear::Interpolation::Linear);
+
     double rate = 0;
     // If the baserate, speed, or pitch has changed, we need to update the
     // scaler. Also, if we have changed scalers then we need to update the
@@ -943,8 +967,11 @@ void EngineBuffer::processTrackLocked(
     // If the buffer is not paused, then scale the audio.
     if (!bCurBufferPaused) {
         // Perform scaling of Reader buffer into buffer.
+        PerformanceTimer scaleTimer;
+        scaleTimer.start();
         double framesRead =
                 m_pScale->scaleBuffer(pOutput, iBufferSize);
+        m_lastScaleDuration += scaleTimer.elapsed();
 
         // TODO(XXX): The result framesRead might not be an integer value.
         // Converting to samples here does not make sense. All positional
@@ -1012,7 +1039,7 @@ void EngineBuffer::processTrackLocked(
             double fractionalPos = at_start ? 1.0 : 0;
             doSeekFractional(fractionalPos, SEEK_STANDARD);
         } else {
-            m_playButton->set(0.);
+            m_bStopAtEndOfTrack = true;
         }
     }
 
@@ -1021,11 +1048,30 @@ void EngineBuffer::processTrackLocked(
     hintReader(rate);
 }
 
+void EngineBuffer::preProcess(const int iBufferSize) {
+    Q_UNUSED(iBufferSize);
+    // Sync requests modify the EngineSync and other decks and cloning reads
+    // the position of another deck. Both must not happen in process() that
+    // may run concurrently for all decks. If a track is loading the requests
+    // stay queued until the next callback, like before.
+    bool bTrackLoading = atomicLoadRelaxed(m_iTrackLoading) != 0;
+    if (!bTrackLoading && m_pause.tryLock()) {
+        // Sync requests can affect rate, so process those first.
+        processSyncRequests();
+        // Check if we are cloning another channel before doing any seeking.
+        processCloneRequest();
+        m_pause.unlock();
+    }
+}
+
 void EngineBuffer::process(CSAMPLE* pOutput, const int iBufferSize) {
     // Bail if we receive a buffer size with incomplete sample frames. Assert in debug builds.
     VERIFY_OR_DEBUG_ASSERT((iBufferSize % kSamplesPerFrame) == 0) {
         return;
     }
+    PerformanceTimer processTimer;
+    processTimer.start();
+    m_lastScaleDuration = mixxx::Duration::empty();
     m_pReader->process();
     // Steps:
     // - Lookup new reader information
@@ -1085,11 +1131,15 @@ void EngineBuffer::process(CSAMPLE* pOutput, const int iBufferSize) {
     if (isMaster(m_pSyncControl->getSyncMode())) {
         // Report our speed to SyncControl immediately instead of waiting
         // for postProcess so we can broadcast this update to followers.
+        // This is safe, because the master is processed before the followers
+        // and the sync mode of the decks only changes in preProcess() and
+        // postProcess().
         m_pSyncControl->reportPlayerSpeed(m_speed_old, m_scratching_old);
     }
 
     m_iLastBufferSize = iBufferSize;
     m_bCrossfadeReady = false;
+    m_lastProcessDuration = processTimer.elapsed();
 }
 
 void EngineBuffer::processSlip(int iBufferSize) {
@@ -1141,13 +1191,14 @@ void EngineBuffer::processSyncRequests() {
     }
 }
 
-void EngineBuffer::processSeek(bool paused) {
-    // Check if we are cloning another channel before doing any seeking.
+void EngineBuffer::processCloneRequest() {
     EngineChannel* pChannel = m_pChannelToCloneFrom.fetchAndStoreRelaxed(NULL);
     if (pChannel) {
         seekCloneBuffer(pChannel->getEngineBuffer());
     }
+}
 
+void EngineBuffer::processSeek(bool paused) {
     // We need to read position just after reading seekType, to ensure that we
     // read the matching position to seek_typ or a position from a new (second)
     // seek just queued from another thread
@@ -1221,8 +1272,14 @@ void EngineBuffer::postProcess(const int iBufferSize) {
     if (kLogger.traceEnabled()) {
         kLogger.trace() << getGroup() << "EngineBuffer::postProcess";
     }
+    if (m_bStopAtEndOfTrack) {
+        m_bStopAtEndOfTrack = false;
+        // Notifies EngineSync through SyncControl::slotControlPlay()
+        m_playButton->set(0.);
+    }
     double local_bpm = m_pBpmControl->updateLocalBpm();
     double beat_distance = m_pBpmControl->updateBeatDistance();
+    m_beatDistanceOld = beat_distance;
     m_pSyncControl->setLocalBpm(local_bpm);
     SyncMode mode = m_pSyncControl->getSyncMode();
     if (isMaster(mode)) {
@@ -1285,6 +1342,16 @@ void EngineBuffer::updateIndicators(double speed, int iBufferSize) {
             tempoTrackSeconds);
 }
 
+void EngineBuffer::fillDeckState(DeckState* pState) {
+    pState->playPosition = fractionalPlayposFromAbsolute(m_filepos_play);
+    pState->rate = m_speed_old * m_baserate_old;
+    pState->beatDistance = m_beatDistanceOld;
+    m_pLoopingControl->getLoopPositions(
+            &pState->loopStartPosition, &pState->loopEndPosition);
+    pState->loopEnabled = m_pLoopingControl->isLoopingEnabled();
+    pState->trackSamples = m_trackSamplesOld;
+}
+
 void EngineBuffer::hintReader(const double dRate) {
     m_hintList.clear();
     m_pReadAheadManager->hintReader(dRate, &m_hintList);
@@ -1302,9 +1369,33 @@ void EngineBuffer::hintReader(const double dRate) {
         m_hintList.append(hint);
     }
 
+    const int firstControlHint = m_hintList.size();
     for (const auto& pControl: qAsConst(m_engineControls)) {
         pControl->hintReader(&m_hintList);
     }
+
+    // A quantized jump to a cue point, hotcue or loop keeps the beat phase
+    // of the sync target and lands up to half a beat before or after its
+    // target (see BpmControl::getBeatMatchPosition()). Prefetch the whole
+    // beat around each target to avoid a cache miss after the jump.
+    const double localBpm = m_pBpmControl->getLocalBpm();
+    if (m_pQuantize->toBool() && localBpm > 0 && m_trackSampleRateOld > 0) {
+        const SINT halfBeatFrames = static_cast<SINT>(
+                ceil(30.0 * m_trackSampleRateOld / localBpm));
+        for (int i = firstControlHint; i < m_hintList.size(); ++i) {
+            Hint& hint = m_hintList[i];
+            if (hint.priority >= Hint::kPriorityPrefetch &&
+                    hint.frameCount == Hint::kFrameCountForward) {
+                hint.frameCount = 2 * halfBeatFrames + Hint::kDefaultFrameCount;
+                hint.frame -= halfBeatFrames;
+                if (hint.frame < 0) {
+                    hint.frameCount += hint.frame;
+                    hint.frame = 0;
+                }
+            }
+        }
+    }
+
     m_pReader->hintAndMaybeWake(m_hintList);
 }
 
@@ -1329,6 +1420,9 @@ void EngineBuffer::addControl(EngineControl* pControl) {
 
 void EngineBuffer::bindWorkers(EngineWorkerScheduler* pWorkerScheduler) {
     m_pReader->setScheduler(pWorkerScheduler);
+    m_pScaleRB->bindWorker(pWorkerScheduler);
+    // The worker of the lookahead is only started after it has been bound
+    m_pScaleRB->setLookaheadEnabled(m_pKeylockLookahead->toBool());
 }
 
 bool EngineBuffer::isTrackLoaded() {
@@ -1338,6 +1432,14 @@ bool EngineBuffer::isTrackLoaded() {
     return false;
 }
 
+bool EngineBuffer::isTrackPreloaded() const {
+    return m_pReader->isTrackPreloaded();
+}
+
+bool EngineBuffer::isTrackLoadPending() const {
+    return m_pReader->isTrackLoadPending();
+}
+
 bool EngineBuffer::getQueuedSeekPosition(double* pSeekPosition) {
     bool isSeekQueued = m_iSeekQueued.loadAcquire() != SEEK_NONE;
     if (isSeekQueued) {
@@ -28,6 +28,7 @@
 #include "engine/engineobject.h"
 #include "engine/sync/syncable.h"
 #include "track/track.h"
+#include "util/duration.h"
 #include "util/rotary.h"
 #include "util/types.h"
 
@@ -63,6 +64,7 @@ class EngineSync;
 class EngineWorkerScheduler;
 class VisualPlayPosition;
 class EngineMaster;
+struct DeckState;
 
 /**
   *@author Tue and Ken Haste Andersen
@@ -135,12 +137,26 @@ class EngineBuffer : public EngineObject {
     void requestClonePosition(EngineChannel* pChannel);
 
     // The process methods all run in the audio callback.
+    void preProcess(const int iBufferSize);
     void process(CSAMPLE* pOut, const int iBufferSize);
     void processSlip(int iBufferSize);
     void postProcess(const int iBufferSize);
 
     QString getGroup();
     bool isTrackLoaded();
+    // The whole track has been decoded into memory
+    bool isTrackPreloaded() const;
+    // Loading a track has been requested, but trackLoaded() or
+    // trackLoadFailed() has not been emitted yet
+    bool isTrackLoadPending() const;
+    // The time spent in the last process() call and in the
+    // scaler within it
+    mixxx::Duration getLastProcessDuration() const {
+        return m_lastProcessDuration;
+    }
+    mixxx::Duration getLastScaleDuration() const {
+        return m_lastScaleDuration;
+    }
     // return true if a seek is currently cueued but not yet processed, false otherwise
     // if no seek was queued, the seek position is set to -1
     bool getQueuedSeekPosition(double* pSeekPosition);
@@ -156,6 +172,9 @@ class EngineBuffer : public EngineObject {
 
     double getRateRatio() const;
 
+    // Fills in the transport, beat and loop state after postProcess()
+    void fillDeckState(DeckState* pState);
+
     // For dependency injection of readers.
     //void setReader(CachingReader* pReader);
 
@@ -193,6 +212,7 @@ class EngineBuffer : public EngineObject {
     void slotControlSeekAbs(double);
     void slotControlSeekExact(double);
     void slotKeylockEngineChanged(double);
+    void slotKeylockLookaheadChanged(double);
 
     void slotEjectTrack(double);
 
@@ -241,6 +261,7 @@ class EngineBuffer : public EngineObject {
     void setNewPlaypos(double playpos);
 
     void processSyncRequests();
+    void processCloneRequest();
     void processSeek(bool paused);
 
     bool updateIndicatorsAndModifyPlay(bool newPlay);
@@ -298,9 +319,17 @@ class EngineBuffer : public EngineObject {
     // The previous callback's tempo ratio.
     double m_tempo_ratio_old;
 
+    // The beat distance of the previous callback
+    double m_beatDistanceOld;
+
     // True if the previous callback was scratching.
     bool m_scratching_old;
 
+    // Set by process() when the end of the track stopped playback. Stopping
+    // notifies EngineSync which may change other decks, so it is applied
+    // in postProcess() when the decks are no longer processed concurrently.
+    bool m_bStopAtEndOfTrack;
+
     // True if the previous callback was reverse.
     bool m_reverse_old;
 
@@ -351,7 +380,9 @@ class EngineBuffer : public EngineObject {
     ControlPotmeter* m_playposSlider;
     ControlProxy* m_pSampleRate;
     ControlProxy* m_pKeylockEngine;
+    ControlProxy* m_pKeylockLookahead;
     ControlPushButton* m_pKeylock;
+    ControlPushButton* m_pVinylInterpolation;
 
     // This ControlProxys is created as parent to this and deleted by
     // the Qt object tree. This helps that they are deleted by the creating
@@ -377,6 +408,8 @@ class EngineBuffer : public EngineObject {
     FRIEND_TEST(EngineBufferTest, ReadFadeOut);
     FRIEND_TEST(EngineBufferTest, RateTempTest);
     FRIEND_TEST(EngineBufferTest, RatePermTest);
+    FRIEND_TEST(EngineBufferE2ETest, HotcueJumpIsPrefetched);
+    FRIEND_TEST(EngineBufferE2ETest, ReadsFromPreloadedTrack);
     EngineBufferScale* m_pScaleVinyl;
     // The keylock engine is configurable, so it could flip flop between
     // ScaleST and ScaleRB during a single callback.
@@ -419,6 +452,9 @@ class EngineBuffer : public EngineObject {
     bool m_bCrossfadeReady;
     int m_iLastBufferSize;
 
+    mixxx::Duration m_lastProcessDuration;
+    mixxx::Duration m_lastScaleDuration;
+
     QSharedPointer<VisualPlayPosition> m_visualPlayPos;
 };
 
@@ -0,0 +1,340 @@
+#include "engine/enginecallbacktelemetry.h"
+
+#include <QFile>
+
+#include <algorithm>
+#include <iterator>
+
+#include "util/assert.h"
+#include "util/logger.h"
+#include "util/timer.h"
+
+namespace {
+
+const mixxx::Logger kLogger("EngineCallbackTelemetry");
+
+// Callbacks that have not been collected by publish() are dropped
+// when the FIFO is full
+constexpr int kHandOverCapacity = 64;
+
+const double kPublishedPercentile = 0.99;
+
+bool hasSequence(
+        const std::vector<EngineCallbackTelemetry::CallbackRecord>& records,
+        quint64 sequence) {
+    return std::any_of(records.begin(),
+            records.end(),
+            [sequence](const EngineCallbackTelemetry::CallbackRecord& record) {
+                return record.sequence == sequence;
+            });
+}
+
+QString formatMicros(qint64 nanos) {
+    return QString::number(nanos / 1000.0, 'f', 1) + QStringLiteral(" us");
+}
+
+} // anonymous namespace
+
+// static
+QString EngineCallbackTelemetry::stageName(Stage stage) {
+    switch (stage) {
+    case Stage::Callback:
+        return QStringLiteral("Callback");
+    case Stage::Channels:
+        return QStringLiteral("Channels");
+    case Stage::EngineBuffer:
+        return QStringLiteral("EngineBuffer");
+    case Stage::Scaler:
+        return QStringLiteral("Scaler");
+    case Stage::ChannelMixer:
+        return QStringLiteral("ChannelMixer");
+    case Stage::Effects:
+        return QStringLiteral("Effects");
+    case Stage::MasterEffects:
+        return QStringLiteral("MasterEffects");
+    case Stage::SideChain:
+        return QStringLiteral("SideChain");
+    }
+    DEBUG_ASSERT(!"unreachable");
+    return QString();
+}
+
+EngineCallbackTelemetry::EngineCallbackTelemetry()
+        : m_callbackCount(0),
+          m_xrunCount(0),
+          m_xrunPending(false),
+          m_handOver(kHandOverCapacity) {
+    for (auto& histogram : m_histograms) {
+        for (auto& count : histogram) {
+            count.store(0, std::memory_order_relaxed);
+        }
+    }
+    m_current = CallbackRecord();
+    m_previous = CallbackRecord();
+    m_worstNanos.fill(0);
+    for (int stage = 0; stage < kStageCount; ++stage) {
+        m_publishedHistograms[stage].fill(0);
+        m_statTags[stage] = QString("EngineCallbackTelemetry %1 p99")
+                                    .arg(stageName(static_cast<Stage>(stage)));
+    }
+    m_worstCallbacks.reserve(kWorstCallbackCount);
+    m_xrunCallbacks.reserve(kXrunCallbackCount);
+}
+
+void EngineCallbackTelemetry::setChannelGroup(int channelIndex, const QString& group) {
+    if (channelIndex < 0 || channelIndex >= kMaxChannels) {
+        kLogger.debug() << "Not tracking channel" << group << "separately";
+        return;
+    }
+    m_channelGroups[channelIndex] = group;
+}
+
+void EngineCallbackTelemetry::beginCallback(int bufferFrames, int sampleRate) {
+    m_current.sequence = m_callbackCount.load(std::memory_order_relaxed);
+    m_current.bufferNanos = sampleRate > 0
+            ? mixxx::Duration::kNanosPerSecond * bufferFrames / sampleRate
+            : 0;
+    std::fill(std::begin(m_current.stageNanos), std::end(m_current.stageNanos), 0);
+    std::fill(std::begin(m_current.engineBufferNanos),
+            std::end(m_current.engineBufferNanos),
+            -1);
+    std::fill(std::begin(m_current.scalerNanos), std::end(m_current.scalerNanos), -1);
+    m_current.xrun = false;
+}
+
+// static
+int EngineCallbackTelemetry::bucketIndex(qint64 nanos) {
+    qint64 micros = nanos / 1000;
+    int bucket = 0;
+    while (micros > 0 && bucket < kHistogramBucketCount - 1) {
+        micros >>= 1;
+        ++bucket;
+    }
+    return bucket;
+}
+
+void EngineCallbackTelemetry::countInHistogram(Stage stage, qint64 nanos) {
+    // Only the engine thread writes, so no read-modify-write is needed
+    auto& count = m_histograms[static_cast<int>(stage)][bucketIndex(nanos)];
+    count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+void EngineCallbackTelemetry::handOver(const CallbackRecord& record) {
+    // Drops the record if the reader does not keep up
+    m_handOver.write(&record, 1);
+}
+
+void EngineCallbackTelemetry::endCallback(mixxx::Duration callback) {
+    m_current.stageNanos[static_cast<int>(Stage::Callback)] = callback.toIntegerNanos();
+    for (int channel = 0; channel < kMaxChannels; ++channel) {
+        if (m_current.engineBufferNanos[channel] >= 0) {
+            m_current.stageNanos[static_cast<int>(Stage::EngineBuffer)] +=
+                    m_current.engineBufferNanos[channel];
+            m_current.stageNanos[static_cast<int>(Stage::Scaler)] +=
+                    m_current.scalerNanos[channel];
+            countInHistogram(Stage::EngineBuffer, m_current.engineBufferNanos[channel]);
+            countInHistogram(Stage::Scaler, m_current.scalerNanos[channel]);
+        }
+    }
+    for (int stage = 0; stage < kStageCount; ++stage) {
+        if (stage != static_cast<int>(Stage::EngineBuffer) &&
+                stage != static_cast<int>(Stage::Scaler)) {
+            countInHistogram(static_cast<Stage>(stage), m_current.stageNanos[stage]);
+        }
+    }
+
+    // The sound device reports an xrun after the callback that
+    // was too late, which might also be the previous one
+    if (m_xrunPending.exchange(false, std::memory_order_relaxed)) {
+        m_xrunCount.fetch_add(1, std::memory_order_relaxed);
+        m_current.xrun = true;
+        if (m_previous.sequence + 1 == m_current.sequence && !m_previous.xrun) {
+            m_previous.xrun = true;
+            handOver(m_previous);
+        }
+    }
+
+    const qint64 callbackNanos = m_current.stageNanos[static_cast<int>(Stage::Callback)];
+    if (callbackNanos > m_worstNanos[0]) {
+        // Keep the durations sorted with the fastest first
+        m_worstNanos[0] = callbackNanos;
+        for (int i = 1; i < kWorstCallbackCount && m_worstNanos[i] < m_worstNanos[i - 1]; ++i) {
+            std::swap(m_worstNanos[i], m_worstNanos[i - 1]);
+        }
+        handOver(m_current);
+    } else if (m_current.xrun) {
+        handOver(m_current);
+    }
+    m_previous = m_current;
+
+    m_callbackCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+void EngineCallbackTelemetry::publish() {
+    CallbackRecord record;
+    while (m_handOver.read(&record, 1) == 1) {
+        if (record.xrun) {
+            if (!hasSequence(m_xrunCallbacks, record.sequence)) {
+                if (static_cast<int>(m_xrunCallbacks.size()) >= kXrunCallbackCount) {
+                    m_xrunCallbacks.erase(m_xrunCallbacks.begin());
+                }
+                m_xrunCallbacks.push_back(record);
+                std::sort(m_xrunCallbacks.begin(),
+                        m_xrunCallbacks.end(),
+                        [](const CallbackRecord& lhs, const CallbackRecord& rhs) {
+                            return lhs.sequence < rhs.sequence;
+                        });
+            }
+            for (int stage = 0; stage < kStageCount; ++stage) {
+                Stat::track(QString("EngineCallbackTelemetry %1 around xrun")
+                                    .arg(stageName(static_cast<Stage>(stage))),
+                        Stat::DURATION_NANOSEC,
+                        kDefaultComputeFlags,
+                        record.stageNanos[stage]);
+            }
+        }
+
+        // The previous callback is handed over again if an xrun
+        // is reported after it
+        const auto existing = std::find_if(m_worstCallbacks.begin(),
+                m_worstCallbacks.end(),
+                [&record](const CallbackRecord& worst) {
+                    return worst.sequence == record.sequence;
+                });
+        if (existing != m_worstCallbacks.end()) {
+            existing->xrun = existing->xrun || record.xrun;
+            continue;
+        }
+        m_worstCallbacks.push_back(record);
+        std::sort(m_worstCallbacks.begin(),
+                m_worstCallbacks.end(),
+                [](const CallbackRecord& lhs, const CallbackRecord& rhs) {
+                    const int callback = static_cast<int>(Stage::Callback);
+                    return lhs.stageNanos[callback] > rhs.stageNanos[callback];
+                });
+        if (static_cast<int>(m_worstCallbacks.size()) > kWorstCallbackCount) {
+            m_worstCallbacks.pop_back();
+        }
+    }
+
+    // Publish the percentile of the callbacks since the last call
+    for (int stage = 0; stage < kStageCount; ++stage) {
+        const Histogram current = histogram(static_cast<Stage>(stage));
+        Histogram recent;
+        quint64 recentCount = 0;
+        for (int bucket = 0; bucket < kHistogramBucketCount; ++bucket) {
+            recent[bucket] = current[bucket] - m_publishedHistograms[stage][bucket];
+            recentCount += recent[bucket];
+        }
+        m_publishedHistograms[stage] = current;
+        if (recentCount > 0) {
+            Stat::track(m_statTags[stage],
+                    Stat::DURATION_NANOSEC,
+                    kDefaultComputeFlags,
+                    percentile(recent, kPublishedPercentile).toIntegerNanos());
+        }
+    }
+}
+
+EngineCallbackTelemetry::Histogram EngineCallbackTelemetry::histogram(Stage stage) const {
+    Histogram result;
+    for (int bucket = 0; bucket < kHistogramBucketCount; ++bucket) {
+        result[bucket] = m_histograms[static_cast<int>(stage)][bucket].load(
+                std::memory_order_relaxed);
+    }
+    return result;
+}
+
+// static
+mixxx::Duration EngineCallbackTelemetry::percentile(
+        const Histogram& histogram, double fraction) {
+    quint64 totalCount = 0;
+    for (const auto count : histogram) {
+        totalCount += count;
+    }
+    if (totalCount == 0) {
+        return mixxx::Duration::empty();
+    }
+    const double targetCount = fraction * totalCount;
+    quint64 count = 0;
+    int bucket = 0;
+    for (; bucket < kHistogramBucketCount - 1; ++bucket) {
+        count += histogram[bucket];
+        if (count >= targetCount) {
+            break;
+        }
+    }
+    return mixxx::Duration::fromMicros(qint64(1) << bucket);
+}
+
+void EngineCallbackTelemetry::writeRecord(
+        QTextStream* pStream, const CallbackRecord& record) const {
+    QTextStream& out = *pStream;
+    out << "#" << record.sequence << ": "
+        << formatMicros(record.stageNanos[static_cast<int>(Stage::Callback)])
+        << " of " << formatMicros(record.bufferNanos)
+        << (record.xrun ? " (xrun)" : "") << "\n";
+    for (int stage = static_cast<int>(Stage::Callback) + 1; stage < kStageCount; ++stage) {
+        out << "    " << stageName(static_cast<Stage>(stage)) << ": "
+            << formatMicros(record.stageNanos[stage]) << "\n";
+    }
+    for (int channel = 0; channel < kMaxChannels; ++channel) {
+        if (record.engineBufferNanos[channel] < 0) {
+            continue;
+        }
+        out << "    " << m_channelGroups[channel] << ": "
+            << formatMicros(record.engineBufferNanos[channel])
+            << " (scaler " << formatMicros(record.scalerNanos[channel]) << ")\n";
+    }
+}
+
+void EngineCallbackTelemetry::writeReport(QTextStream* pStream) const {
+    QTextStream& out = *pStream;
+    out << "Engine callbacks: " << callbackCount()
+        << ", xruns: " << xrunCount() << "\n\n";
+
+    out << "Stage durations (p50 / p99 / max bucket):\n";
+    for (int stage = 0; stage < kStageCount; ++stage) {
+        const Histogram stageHistogram = histogram(static_cast<Stage>(stage));
+        int maxBucket = -1;
+        for (int bucket = 0; bucket < kHistogramBucketCount; ++bucket) {
+            if (stageHistogram[bucket] > 0) {
+                maxBucket = bucket;
+            }
+        }
+        if (maxBucket < 0) {
+            continue;
+        }
+        out << "    " << stageName(static_cast<Stage>(stage)) << ": "
+            << percentile(stageHistogram, 0.5).formatMicrosWithUnit() << " / "
+            << percentile(stageHistogram, 0.99).formatMicrosWithUnit() << " / "
+            << mixxx::Duration::fromMicros(qint64(1) << maxBucket).formatMicrosWithUnit()
+            << "\n";
+        out << "       ";
+        for (int bucket = 0; bucket <= maxBucket; ++bucket) {
+            out << " <" << (qint64(1) << bucket) << "us:" << stageHistogram[bucket];
+        }
+        out << "\n";
+    }
+
+    out << "\nSlowest callbacks:\n";
+    for (const auto& record : m_worstCallbacks) {
+        writeRecord(pStream, record);
+    }
+    out << "\nCallbacks around xruns:\n";
+    for (const auto& record : m_xrunCallbacks) {
+        writeRecord(pStream, record);
+    }
+}
+
+bool EngineCallbackTelemetry::writeReportFile(const QString& filePath) const {
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        kLogger.warning()
+                << "Failed to open" << filePath << ":" << file.errorString();
+        return false;
+    }
+    QTextStream out(&file);
+    writeReport(&out);
+    return true;
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <QString>
+#include <QTextStream>
+
+#include <array>
+#include <atomic>
+#include <vector>
+
+#include "util/class.h"
+#include "util/duration.h"
+#include "util/fifo.h"
+#include "util/types.h"
+
+// Always-on timing of the stages of each engine callback for tracing xruns
+// back to the stage that took too long.
+//
+// The engine thread folds the stage durations into histograms when the
+// callback ends and hands the slowest callbacks and those around an xrun
+// over to a reader thread through a lock-free FIFO. Nothing in the callback
+// allocates or locks. The per-channel stages may be recorded by the channel
+// workers, but each channel only by a single thread within a callback.
+//
+// All methods that are not marked otherwise must only be called from a
+// single non-realtime thread, e.g. the main thread.
+class EngineCallbackTelemetry {
+  public:
+    enum class Stage {
+        // EngineMaster::process as a whole
+        Callback = 0,
+        // Processing of all channels, including pre-fader effects
+        Channels,
+        // EngineBuffer::process of a single deck, including the scaler
+        EngineBuffer,
+        // The scaler of a single deck
+        Scaler,
+        // Mixing the channels into the headphone, talkover and
+        // crossfader buses, excluding the effects
+        ChannelMixer,
+        // Post-fader effects of the channels and buses
+        Effects,
+        MasterEffects,
+        // Handing the record/broadcast mix over to the side chain
+        SideChain,
+    };
+    static constexpr int kStageCount = static_cast<int>(Stage::SideChain) + 1;
+    static QString stageName(Stage stage);
+
+    // Same as kPreallocatedChannels of EngineMaster
+    static constexpr int kMaxChannels = 64;
+    // Bucket 0 counts durations below 1 us and bucket i > 0 those
+    // in [2^(i-1), 2^i) us. The last bucket also counts all longer ones.
+    static constexpr int kHistogramBucketCount = 24;
+    static constexpr int kWorstCallbackCount = 16;
+    static constexpr int kXrunCallbackCount = 32;
+
+    typedef std::array<quint64, kHistogramBucketCount> Histogram;
+
+    struct CallbackRecord {
+        quint64 sequence;
+        // The audio duration of the buffer, i.e. the deadline
+        qint64 bufferNanos;
+        // The per-channel stages are summed over all channels
+        qint64 stageNanos[kStageCount];
+        // Negative for channels that have not been processed
+        qint64 engineBufferNanos[kMaxChannels];
+        qint64 scalerNanos[kMaxChannels];
+        // An xrun was reported during or right after this callback
+        bool xrun;
+    };
+
+    EngineCallbackTelemetry();
+
+    // Names the channel in the report. Must be called before the
+    // channel is processed for the first time.
+    void setChannelGroup(int channelIndex, const QString& group);
+
+    // Engine thread
+    void beginCallback(int bufferFrames, int sampleRate);
+    void recordStage(Stage stage, mixxx::Duration duration) {
+        m_current.stageNanos[static_cast<int>(stage)] += duration.toIntegerNanos();
+    }
+    // Engine thread or channel worker
+    void recordChannel(int channelIndex,
+            mixxx::Duration engineBuffer,
+            mixxx::Duration scaler) {
+        if (channelIndex < 0 || channelIndex >= kMaxChannels) {
+            return;
+        }
+        m_current.engineBufferNanos[channelIndex] = engineBuffer.toIntegerNanos();
+        m_current.scalerNanos[channelIndex] = scaler.toIntegerNanos();
+    }
+    // Engine thread, after all channel workers have finished
+    void endCallback(mixxx::Duration callback);
+
+    // Any thread, e.g. the sound device callback
+    void xrunHappened() {
+        m_xrunPending.store(true, std::memory_order_relaxed);
+    }
+
+    // Collects the callbacks handed over by the engine thread and
+    // reports the recent stage durations to the StatsManager
+    void publish();
+
+    quint64 callbackCount() const {
+        return m_callbackCount.load(std::memory_order_relaxed);
+    }
+    quint64 xrunCount() const {
+        return m_xrunCount.load(std::memory_order_relaxed);
+    }
+    Histogram histogram(Stage stage) const;
+    // Sorted by descending callback duration, as of the last publish()
+    const std::vector<CallbackRecord>& worstCallbacks() const {
+        return m_worstCallbacks;
+    }
+    // Sorted by sequence, as of the last publish()
+    const std::vector<CallbackRecord>& xrunCallbacks() const {
+        return m_xrunCallbacks;
+    }
+
+    // Upper bound of the bucket that contains the given fraction
+    // of all counts
+    static mixxx::Duration percentile(const Histogram& histogram, double fraction);
+
+    void writeReport(QTextStream* pStream) const;
+    bool writeReportFile(const QString& filePath) const;
+
+  private:
+    static int bucketIndex(qint64 nanos);
+    void countInHistogram(Stage stage, qint64 nanos);
+    void handOver(const CallbackRecord& record);
+    void writeRecord(QTextStream* pStream, const CallbackRecord& record) const;
+
+    QString m_channelGroups[kMaxChannels];
+
+    // Written by the engine thread, read by the reader
+    std::atomic<quint64> m_histograms[kStageCount][kHistogramBucketCount];
+    std::atomic<quint64> m_callbackCount;
+    std::atomic<quint64> m_xrunCount;
+    std::atomic<bool> m_xrunPending;
+    FIFO<CallbackRecord> m_handOver;
+
+    // Engine thread only
+    CallbackRecord m_current;
+    CallbackRecord m_previous;
+    // Ascending callback durations of the slowest callbacks so far
+    std::array<qint64, kWorstCallbackCount> m_worstNanos;
+
+    // Reader only
+    std::vector<CallbackRecord> m_worstCallbacks;
+    std::vector<CallbackRecord> m_xrunCallbacks;
+    Histogram m_publishedHistograms[kStageCount];
+    QString m_statTags[kStageCount];
+
+    DISALLOW_COPY_AND_ASSIGN(EngineCallbackTelemetry);
+};
@@ -17,8 +17,10 @@
 #ifndef ENGINEDELAY_H
 #define ENGINEDELAY_H
 
+#include "engine/engine.h"
 #include "engine/engineobject.h"
 #include "preferences/usersettings.h"
+#include "util/delayline.h"
 
 class ControlPotmeter;
 class ControlProxy;
@@ -39,9 +41,8 @@ class EngineDelay : public EngineObject {
   private:
     ControlPotmeter* m_pDelayPot;
     ControlProxy* m_pSampleRate;
-    CSAMPLE* m_pDelayBuffer;
-    int m_iDelayPos;
-    int m_iDelay;
+    mixxx::DelayLine<CSAMPLE, mixxx::kEngineChannelCount> m_delayLine;
+    int m_iDelayFrames;
 };
 
 #endif
@@ -1,8 +1,10 @@
 #include "engine/enginemaster.h"
 
 #include <QtDebug>
+#include <QDir>
 #include <QList>
 #include <QPair>
+#include <QThread>
 
 #include "preferences/usersettings.h"
 #include "control/controlaudiotaperpot.h"
@@ -10,8 +12,10 @@
 #include "control/controlpotmeter.h"
 #include "control/controlpushbutton.h"
 #include "effects/effectsmanager.h"
+#include "engine/cachingreader/preloadbudget.h"
 #include "engine/channelmixer.h"
 #include "engine/effects/engineeffectsmanager.h"
+#include "engine/enginecallbacktelemetry.h"
 #include "engine/enginebuffer.h"
 #include "engine/enginebuffer.h"
 #include "engine/channels/enginechannel.h"
@@ -21,14 +25,43 @@
 #include "engine/enginevumeter.h"
 #include "engine/engineworkerscheduler.h"
 #include "engine/enginexfader.h"
+#include "engine/realtimeworkerpool.h"
 #include "engine/sidechain/enginesidechain.h"
 #include "engine/sync/enginesync.h"
 #include "mixer/playermanager.h"
+#include "sources/pcmcache.h"
+#include "util/cmdlineargs.h"
 #include "util/defs.h"
+#include "util/math.h"
+#include "util/performancetimer.h"
 #include "util/sample.h"
 #include "util/timer.h"
 #include "util/trace.h"
 
+// Processes a range of active channels, one job per channel.
+class EngineMaster::ProcessChannelJobs : public RealtimeWorkerPool::Jobs {
+  public:
+    ProcessChannelJobs(EngineMaster* pEngineMaster,
+            ChannelInfo* const* ppChannelInfos,
+            void (EngineMaster::*process)(ChannelInfo*, int),
+            int iBufferSize)
+            : m_pEngineMaster(pEngineMaster),
+              m_ppChannelInfos(ppChannelInfos),
+              m_process(process),
+              m_iBufferSize(iBufferSize) {
+    }
+
+    void run(int index) override {
+        (m_pEngineMaster->*m_process)(m_ppChannelInfos[index], m_iBufferSize);
+    }
+
+  private:
+    EngineMaster* const m_pEngineMaster;
+    ChannelInfo* const* const m_ppChannelInfos;
+    void (EngineMaster::* const m_process)(ChannelInfo*, int);
+    const int m_iBufferSize;
+};
+
 EngineMaster::EngineMaster(
         UserSettingsPointer pConfig,
         const QString& group,
@@ -64,9 +97,51 @@ EngineMaster::EngineMaster(
     m_bBusOutputConnected[EngineChannel::CENTER] = false;
     m_bBusOutputConnected[EngineChannel::RIGHT] = false;
     m_bExternalRecordBroadcastInputConnected = false;
+    // Mix channels without post-fader effects in a single blocked pass
+    // instead of using the generated per-channel-count functions.
+    m_bFusedChannelMixer = pConfig->getValue(
+            ConfigKey(group, "fused_channel_mixer"), true);
+    // Batching is slower than processing the channels separately unless the
+    // compiler vectorizes the batched filters, so it is opt-in.
+    m_bBatchPreFaderEffects = pConfig->getValue(
+            ConfigKey(group, "batch_prefader_effects"), false);
+
+    // Optionally process the channels on multiple cores. The callback thread
+    // takes part in the processing, so one worker less than cores is used.
+    const int numChannelWorkers = math_min(
+            pConfig->getValue(ConfigKey(group, "channel_worker_threads"), 0),
+            QThread::idealThreadCount() - 1);
+    setChannelWorkerThreads(numChannelWorkers,
+            pConfig->getValue(ConfigKey(group, "channel_worker_pinning"), true));
     m_pWorkerScheduler = new EngineWorkerScheduler(this);
     m_pWorkerScheduler->start(QThread::HighPriority);
 
+    // Decks with [ChannelN],preload_fully decode their tracks completely
+    // into memory as long as they fit into this budget.
+    m_pPreloadBudget = std::make_unique<PreloadBudget>(
+            pConfig->getValue(ConfigKey(group, "preload_memory_budget_mb"), 1024) *
+            qint64(1024 * 1024));
+
+    // Decoded tracks are written to disk and mapped into memory when
+    // loading them again, which skips decoding compressed formats.
+    if (pConfig->getValue(ConfigKey(group, "pcm_cache_enabled"), false)) {
+        m_pPcmCache = std::make_unique<mixxx::PcmCache>(
+                pConfig->getSettingsPath() + "/pcmcache",
+                pConfig->getValue(ConfigKey(group, "pcm_cache_size_mb"), 4096) *
+                        qint64(1024 * 1024));
+    }
+
+    // The engine hands slow callbacks over to the telemetry which are
+    // collected periodically in the main thread
+    m_pCallbackTelemetry = std::make_unique<EngineCallbackTelemetry>();
+    m_callbackTelemetryReportPath = QDir(pConfig->getSettingsPath())
+                                            .filePath("engine_callback_telemetry.txt");
+    connect(&m_callbackTelemetryTimer,
+            &QTimer::timeout,
+            this,
+            &EngineMaster::slotPublishCallbackTelemetry);
+    m_callbackTelemetryTimer.start(1000);
+
     // Master sample rate
     m_pMasterSampleRate = new ControlObject(ConfigKey(group, "samplerate"), true, true);
     m_pMasterSampleRate->set(44100.);
@@ -177,6 +252,10 @@ EngineMaster::EngineMaster(
                                          true, false, true);
     m_pKeylockEngine->set(pConfig->getValueString(
             ConfigKey(group, "keylock_engine")).toDouble());
+    // Renders RubberBand keylock ahead of the play position on a worker
+    // thread while the tempo and pitch of a deck are stable
+    m_pKeylockLookahead = new ControlObject(ConfigKey(group, "keylock_lookahead"),
+            true, false, true);  // persist = true
 
     // TODO: Make this read only and make EngineMaster decide whether
     // processing the master mix is necessary.
@@ -196,7 +275,15 @@ EngineMaster::EngineMaster(
 
 EngineMaster::~EngineMaster() {
     //qDebug() << "in ~EngineMaster()";
+    m_callbackTelemetryTimer.stop();
+    slotPublishCallbackTelemetry();
+    if (m_pCallbackTelemetry->xrunCount() > 0 ||
+            CmdlineArgs::Instance().getDeveloper()) {
+        m_pCallbackTelemetry->writeReportFile(m_callbackTelemetryReportPath);
+    }
+    m_pChannelWorkerPool.reset();
     delete m_pKeylockEngine;
+    delete m_pKeylockLookahead;
     delete m_pCrossfader;
     delete m_pBalance;
     delete m_pHeadMix;
@@ -254,6 +341,10 @@ EngineMaster::~EngineMaster() {
     }
 }
 
+void EngineMaster::slotPublishCallbackTelemetry() {
+    m_pCallbackTelemetry->publish();
+}
+
 const CSAMPLE* EngineMaster::getMasterBuffer() const {
     return m_pMaster;
 }
@@ -270,6 +361,16 @@ const CSAMPLE* EngineMaster::getSidechainBuffer() const {
     return m_pSidechainMix;
 }
 
+void EngineMaster::setChannelWorkerThreads(int numWorkers, bool pinThreads) {
+    m_pChannelWorkerPool.reset();
+    if (numWorkers > 0) {
+        m_pChannelWorkerPool = std::make_unique<RealtimeWorkerPool>(
+                "EngineChannelWorker",
+                numWorkers,
+                pinThreads);
+    }
+}
+
 void EngineMaster::processChannels(int iBufferSize) {
     // Update internal master sync rate.
     m_pMasterSync->onCallbackStart(m_iSampleRate, m_iBufferSize);
@@ -353,20 +454,42 @@ void EngineMaster::processChannels(int iBufferSize) {
         }
     }
 
-    // Now that the list is built and ordered, do the processing.
+    // Handle everything that depends on other channels in order.
     for (int i = activeChannelsStartIndex;
-             i < m_activeChannels.size(); ++i) {
-        ChannelInfo* pChannelInfo = m_activeChannels[i];
-        EngineChannel* pChannel = pChannelInfo->m_pChannel;
-        pChannel->process(pChannelInfo->m_pBuffer, iBufferSize);
+            i < m_activeChannels.size(); ++i) {
+        m_activeChannels[i]->m_pChannel->preProcess(iBufferSize);
+    }
 
-        // Collect metadata for effects
-        if (m_pEngineEffectsManager) {
-            GroupFeatureState features;
-            pChannel->collectFeatures(&features);
-            pChannelInfo->m_features = features;
+    // Now that the list is built and ordered, do the processing.
+    if (activeChannelsStartIndex == 0) {
+        // The followers depend on the sync master processed first
+        processChannel(m_activeChannels[0], iBufferSize);
+    }
+    runChannelJobs(m_activeChannels.constData() + 1,
+            m_activeChannels.size() - 1,
+            &EngineMaster::processChannel,
+            iBufferSize);
+
+    // The pre-fader effects of the channels, for which processChannel()
+    // left them pending, share their batched work.
+    m_batchedEffectsChannels.clear();
+    for (int i = activeChannelsStartIndex;
+            i < m_activeChannels.size(); ++i) {
+        if (m_activeChannels[i]->m_bEffectsPending) {
+            m_batchedEffectsChannels.append(m_activeChannels[i]);
+        }
+    }
+    if (m_batchedEffectsChannels.size() > 1) {
+        for (ChannelInfo* pChannelInfo : m_batchedEffectsChannels) {
+            pChannelInfo->m_pChannel->prepareEffects(
+                    pChannelInfo->m_pBuffer, iBufferSize);
         }
+        m_pEngineEffectsManager->processPreFaderBatch(iBufferSize);
     }
+    runChannelJobs(m_batchedEffectsChannels.constData(),
+            m_batchedEffectsChannels.size(),
+            &EngineMaster::processChannelEffects,
+            iBufferSize);
 
     // Do internal master sync post-processing before the other
     // channels.
@@ -382,6 +505,60 @@ void EngineMaster::processChannels(int iBufferSize) {
     }
 }
 
+void EngineMaster::runChannelJobs(ChannelInfo* const* ppChannelInfos,
+        int numChannels,
+        void (EngineMaster::*process)(ChannelInfo*, int),
+        int iBufferSize) {
+    if (m_pChannelWorkerPool && numChannels > 1) {
+        ProcessChannelJobs jobs(this, ppChannelInfos, process, iBufferSize);
+        m_pChannelWorkerPool->runJobs(&jobs, numChannels);
+    } else {
+        for (int i = 0; i < numChannels; ++i) {
+            (this->*process)(ppChannelInfos[i], iBufferSize);
+        }
+    }
+}
+
+void EngineMaster::processChannel(ChannelInfo* pChannelInfo, int iBufferSize) {
+    EngineChannel* pChannel = pChannelInfo->m_pChannel;
+    // The batch runs on the callback thread only, while the channel worker
+    // pool processes the effects of the channels concurrently.
+    if (m_bBatchPreFaderEffects && m_pEngineEffectsManager &&
+            !m_pChannelWorkerPool) {
+        pChannelInfo->m_bEffectsPending = pChannel->processBeforeEffects(
+                pChannelInfo->m_pBuffer, iBufferSize);
+    } else {
+        pChannel->process(pChannelInfo->m_pBuffer, iBufferSize);
+        pChannelInfo->m_bEffectsPending = false;
+    }
+
+    EngineBuffer* pEngineBuffer = pChannel->getEngineBuffer();
+    if (pEngineBuffer) {
+        m_pCallbackTelemetry->recordChannel(pChannelInfo->m_index,
+                pEngineBuffer->getLastProcessDuration(),
+                pEngineBuffer->getLastScaleDuration());
+    }
+
+    if (!pChannelInfo->m_bEffectsPending) {
+        collectChannelFeatures(pChannelInfo);
+    }
+}
+
+void EngineMaster::processChannelEffects(ChannelInfo* pChannelInfo, int iBufferSize) {
+    pChannelInfo->m_pChannel->processEffects(pChannelInfo->m_pBuffer, iBufferSize);
+    pChannelInfo->m_bEffectsPending = false;
+    collectChannelFeatures(pChannelInfo);
+}
+
+void EngineMaster::collectChannelFeatures(ChannelInfo* pChannelInfo) {
+    // Collect metadata for effects
+    if (m_pEngineEffectsManager) {
+        GroupFeatureState features;
+        pChannelInfo->m_pChannel->collectFeatures(&features);
+        pChannelInfo->m_features = features;
+    }
+}
+
 void EngineMaster::process(const int iBufferSize) {
     static bool haveSetName = false;
     if (!haveSetName) {
@@ -389,6 +566,8 @@ void EngineMaster::process(const int iBufferSize) {
         haveSetName = true;
     }
     //Trace t("EngineMaster::process");
+    PerformanceTimer callbackTimer;
+    callbackTimer.start();
 
     bool masterEnabled = m_pMasterEnabled->get();
     bool boothEnabled = m_pBoothEnabled->get();
@@ -400,12 +579,23 @@ void EngineMaster::process(const int iBufferSize) {
     const unsigned int kChannels = 2;
     const unsigned int iFrames = iBufferSize / kChannels;
 
+    m_pCallbackTelemetry->beginCallback(iFrames, m_iSampleRate);
+
     if (m_pEngineEffectsManager) {
         m_pEngineEffectsManager->onCallbackStart();
     }
 
     // Prepare all channels for output
+    PerformanceTimer stageTimer;
+    stageTimer.start();
     processChannels(m_iBufferSize);
+    m_pCallbackTelemetry->recordStage(
+            EngineCallbackTelemetry::Stage::Channels, stageTimer.restart());
+    // The post-fader effects are processed while mixing the channels
+    // and are reported separately
+    const mixxx::Duration effectsDurationBeforeMixing = m_pEngineEffectsManager
+            ? m_pEngineEffectsManager->getPostFaderProcessDuration()
+            : mixxx::Duration::empty();
 
     // Compute headphone mix
     // Head phone left/right mix
@@ -426,12 +616,21 @@ void EngineMaster::process(const int iBufferSize) {
         // Process effects and mix PFL channels together for the headphones.
         // Effects will be reprocessed post-fader for the crossfader busses
         // and master mix, so the channel input buffers cannot be modified here.
-        ChannelMixer::applyEffectsAndMixChannels(
-            m_headphoneGain, &m_activeHeadphoneChannels,
-            &m_channelHeadphoneGainCache,
-            m_pHead, m_headphoneHandle.handle(),
-            m_iBufferSize, m_iSampleRate,
-            m_pEngineEffectsManager);
+        if (m_bFusedChannelMixer) {
+            ChannelMixer::applyEffectsAndMixChannelsFused(
+                m_headphoneGain, &m_activeHeadphoneChannels,
+                &m_channelHeadphoneGainCache,
+                m_pHead, m_headphoneHandle.handle(),
+                m_iBufferSize, m_iSampleRate,
+                m_pEngineEffectsManager);
+        } else {
+            ChannelMixer::applyEffectsAndMixChannels(
+                m_headphoneGain, &m_activeHeadphoneChannels,
+                &m_channelHeadphoneGainCache,
+                m_pHead, m_headphoneHandle.handle(),
+                m_iBufferSize, m_iSampleRate,
+                m_pEngineEffectsManager);
+        }
 
         // Process headphone channel effects
         if (m_pEngineEffectsManager) {
@@ -456,11 +655,19 @@ void EngineMaster::process(const int iBufferSize) {
 
     // Mix all the talkover enabled channels together.
     // Effects processing is done in place to avoid unnecessary buffer copying.
-    ChannelMixer::applyEffectsInPlaceAndMixChannels(
-            m_talkoverGain, &m_activeTalkoverChannels,
-            &m_channelTalkoverGainCache,
-            m_pTalkover, m_masterHandle.handle(),
-            m_iBufferSize, m_iSampleRate, m_pEngineEffectsManager);
+    if (m_bFusedChannelMixer) {
+        ChannelMixer::applyEffectsInPlaceAndMixChannelsFused(
+                m_talkoverGain, &m_activeTalkoverChannels,
+                &m_channelTalkoverGainCache,
+                m_pTalkover, m_masterHandle.handle(),
+                m_iBufferSize, m_iSampleRate, m_pEngineEffectsManager);
+    } else {
+        ChannelMixer::applyEffectsInPlaceAndMixChannels(
+                m_talkoverGain, &m_activeTalkoverChannels,
+                &m_channelTalkoverGainCache,
+                m_pTalkover, m_masterHandle.handle(),
+                m_iBufferSize, m_iSampleRate, m_pEngineEffectsManager);
+    }
 
     // Process effects on all microphones mixed together
     // We have no metadata for mixed effect buses, so use an empty GroupFeatureState.
@@ -503,12 +710,21 @@ void EngineMaster::process(const int iBufferSize) {
                             m_pTalkoverDucking->getGain(m_iBufferSize / 2));
 
     for (int o = EngineChannel::LEFT; o <= EngineChannel::RIGHT; o++) {
-        ChannelMixer::applyEffectsInPlaceAndMixChannels(
-            m_masterGain,
-            &m_activeBusChannels[o],
-            &m_channelMasterGainCache, // no [o] because the old gain follows an orientation switch
-            m_pOutputBusBuffers[o], m_masterHandle.handle(),
-            m_iBufferSize, m_iSampleRate, m_pEngineEffectsManager);
+        if (m_bFusedChannelMixer) {
+            ChannelMixer::applyEffectsInPlaceAndMixChannelsFused(
+                m_masterGain,
+                &m_activeBusChannels[o],
+                &m_channelMasterGainCache, // no [o] because the old gain follows an orientation switch
+                m_pOutputBusBuffers[o], m_masterHandle.handle(),
+                m_iBufferSize, m_iSampleRate, m_pEngineEffectsManager);
+        } else {
+            ChannelMixer::applyEffectsInPlaceAndMixChannels(
+                m_masterGain,
+                &m_activeBusChannels[o],
+                &m_channelMasterGainCache, // no [o] because the old gain follows an orientation switch
+                m_pOutputBusBuffers[o], m_masterHandle.handle(),
+                m_iBufferSize, m_iSampleRate, m_pEngineEffectsManager);
+        }
     }
 
     // Process crossfader orientation bus channel effects
@@ -530,6 +746,17 @@ void EngineMaster::process(const int iBufferSize) {
             m_iBufferSize, m_iSampleRate, busFeatures);
     }
 
+    const mixxx::Duration mixingDuration = stageTimer.elapsed();
+    const mixxx::Duration effectsDuration = m_pEngineEffectsManager
+            ? m_pEngineEffectsManager->getPostFaderProcessDuration() -
+                    effectsDurationBeforeMixing
+            : mixxx::Duration::empty();
+    m_pCallbackTelemetry->recordStage(
+            EngineCallbackTelemetry::Stage::Effects, effectsDuration);
+    m_pCallbackTelemetry->recordStage(
+            EngineCallbackTelemetry::Stage::ChannelMixer,
+            mixingDuration - effectsDuration);
+
     if (masterEnabled) {
         // Mix the crossfader orientation buffers together into the master mix
         SampleUtil::copy3WithGain(m_pMaster,
@@ -684,12 +911,16 @@ void EngineMaster::process(const int iBufferSize) {
         // EngineSideChain::receiveBuffer has copied the input buffer to m_pSidechainMix
         // via before (called by SoundManager::pushInputBuffers())
         if (m_pEngineSideChain) {
+            stageTimer.start();
             m_pEngineSideChain->writeSamples(m_pSidechainMix, iFrames);
+            m_pCallbackTelemetry->recordStage(
+                    EngineCallbackTelemetry::Stage::SideChain, stageTimer.elapsed());
         }
 
         // Process effects that apply to master hardware output only but not
         // record/broadcast signal
         if (m_pEngineEffectsManager) {
+            stageTimer.start();
             GroupFeatureState masterFeatures;
             masterFeatures.has_gain = true;
             masterFeatures.gain = m_pMasterGain->get();
@@ -699,6 +930,8 @@ void EngineMaster::process(const int iBufferSize) {
                     m_pMaster,
                     m_iBufferSize, m_iSampleRate,
                     masterFeatures);
+            m_pCallbackTelemetry->recordStage(
+                    EngineCallbackTelemetry::Stage::MasterEffects, stageTimer.elapsed());
         }
 
         // Balance values
@@ -744,11 +977,15 @@ void EngineMaster::process(const int iBufferSize) {
     // We're close to the end of the callback. Wake up the engine worker
     // scheduler so that it runs the workers.
     m_pWorkerScheduler->runWorkers();
+
+    m_pCallbackTelemetry->endCallback(callbackTimer.elapsed());
 }
 
 void EngineMaster::applyMasterEffects() {
     // Apply master effects
     if (m_pEngineEffectsManager) {
+        PerformanceTimer timer;
+        timer.start();
         GroupFeatureState masterFeatures;
         masterFeatures.has_gain = true;
         masterFeatures.gain = m_pMasterGain->get();
@@ -757,6 +994,8 @@ void EngineMaster::applyMasterEffects() {
                                                          m_pMaster,
                                                          m_iBufferSize, m_iSampleRate,
                                                          masterFeatures);
+        m_pCallbackTelemetry->recordStage(
+                EngineCallbackTelemetry::Stage::MasterEffects, timer.elapsed());
     }
 }
 
@@ -800,6 +1039,7 @@ void EngineMaster::addChannel(EngineChannel* pChannel) {
     pChannelInfo->m_pBuffer = SampleUtil::alloc(MAX_BUFFER_LEN);
     SampleUtil::clear(pChannelInfo->m_pBuffer, MAX_BUFFER_LEN);
     m_channels.append(pChannelInfo);
+    m_pCallbackTelemetry->setChannelGroup(pChannelInfo->m_index, group);
     const GainCache gainCacheDefault = {0, false};
     m_channelHeadphoneGainCache.append(gainCacheDefault);
     m_channelTalkoverGainCache.append(gainCacheDefault);
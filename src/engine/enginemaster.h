@@ -19,7 +19,9 @@
 #define ENGINEMASTER_H
 
 #include <QObject>
+#include <QTimer>
 #include <QVarLengthArray>
+#include <memory>
 
 #include "preferences/usersettings.h"
 #include "control/controlobject.h"
@@ -31,6 +33,7 @@
 #include "soundio/soundmanagerutil.h"
 #include "recording/recordingmanager.h"
 
+class EngineCallbackTelemetry;
 class EngineWorkerScheduler;
 class EngineBuffer;
 class EngineChannel;
@@ -47,6 +50,12 @@ class GuiTick;
 class EngineSync;
 class EngineTalkoverDucking;
 class EngineDelay;
+class RealtimeWorkerPool;
+class PreloadBudget;
+
+namespace mixxx {
+class PcmCache;
+} // namespace mixxx
 
 // The number of channels to pre-allocate in various structures in the
 // engine. Prevents memory allocation in EngineMaster::addChannel.
@@ -110,6 +119,24 @@ class EngineMaster : public QObject, public AudioSource {
         return m_pMasterSync;
     }
 
+    // The memory budget for tracks that are decoded completely into memory,
+    // shared by the readers of all decks and samplers.
+    PreloadBudget* getPreloadBudget() const {
+        return m_pPreloadBudget.get();
+    }
+
+    // The disk cache for decoded tracks shared by the readers of all decks
+    // and samplers. Null if disabled.
+    mixxx::PcmCache* getPcmCache() const {
+        return m_pPcmCache.get();
+    }
+
+    // Timing of the stages of each callback. Xruns reported by the sound
+    // devices are attributed to the callbacks around them.
+    EngineCallbackTelemetry* getCallbackTelemetry() const {
+        return m_pCallbackTelemetry.get();
+    }
+
     // These are really only exposed for tests to use.
     const CSAMPLE* getMasterBuffer() const;
     const CSAMPLE* getBoothBuffer() const;
@@ -129,7 +156,8 @@ class EngineMaster : public QObject, public AudioSource {
                   m_pBuffer(NULL),
                   m_pVolumeControl(NULL),
                   m_pMuteControl(NULL),
-                  m_index(index) {
+                  m_index(index),
+                  m_bEffectsPending(false) {
         }
         ChannelHandle m_handle;
         EngineChannel* m_pChannel;
@@ -138,6 +166,8 @@ class EngineMaster : public QObject, public AudioSource {
         ControlPushButton* m_pMuteControl;
         GroupFeatureState m_features;
         int m_index;
+        // processBeforeEffects() returned true in this callback
+        bool m_bEffectsPending;
     };
 
     struct GainCache {
@@ -262,13 +292,36 @@ class EngineMaster : public QObject, public AudioSource {
     ControlObject* m_pHeadphoneEnabled;
     ControlObject* m_pBoothEnabled;
 
+    // Replaces the channel worker pool configured by
+    // [Master],channel_worker_threads. Zero workers process serially.
+    void setChannelWorkerThreads(int numWorkers, bool pinThreads);
+
+  private slots:
+    void slotPublishCallbackTelemetry();
+
   private:
     // Processes active channels. The master sync channel (if any) is processed
-    // first and all others are processed after. Populates m_activeChannels,
-    // m_activeBusChannels, m_activeHeadphoneChannels, and
-    // m_activeTalkoverChannels with each channel that is active for the
-    // respective output.
+    // first and all others are processed after, concurrently if the channel
+    // worker pool is enabled. If [Master],batch_prefader_effects is set and
+    // the worker pool is disabled, the pre-fader effects of all channels
+    // follow in a second pass, which lets them batch work across channels.
+    // Populates m_activeChannels, m_activeBusChannels,
+    // m_activeHeadphoneChannels, and m_activeTalkoverChannels with each
+    // channel that is active for the respective output.
     void processChannels(int iBufferSize);
+    void processChannel(ChannelInfo* pChannelInfo, int iBufferSize);
+    // Finishes a channel for which processChannel() left the pre-fader
+    // effects pending
+    void processChannelEffects(ChannelInfo* pChannelInfo, int iBufferSize);
+    void collectChannelFeatures(ChannelInfo* pChannelInfo);
+    // Runs processChannel() or processChannelEffects() for the channels,
+    // concurrently if the channel worker pool is enabled
+    void runChannelJobs(ChannelInfo* const* ppChannelInfos,
+            int numChannels,
+            void (EngineMaster::*process)(ChannelInfo*, int),
+            int iBufferSize);
+
+    class ProcessChannelJobs;
 
     ChannelHandleFactoryPointer m_pChannelHandleFactory;
     void applyMasterEffects();
@@ -291,6 +344,8 @@ class EngineMaster : public QObject, public AudioSource {
     QVarLengthArray<ChannelInfo*, kPreallocatedChannels> m_activeBusChannels[3];
     QVarLengthArray<ChannelInfo*, kPreallocatedChannels> m_activeHeadphoneChannels;
     QVarLengthArray<ChannelInfo*, kPreallocatedChannels> m_activeTalkoverChannels;
+    // The active channels whose pre-fader effects are batched
+    QVarLengthArray<ChannelInfo*, kPreallocatedChannels> m_batchedEffectsChannels;
 
     unsigned int m_iSampleRate;
     unsigned int m_iBufferSize;
@@ -304,6 +359,15 @@ class EngineMaster : public QObject, public AudioSource {
     CSAMPLE* m_pSidechainMix;
 
     EngineWorkerScheduler* m_pWorkerScheduler;
+    // Optional workers for processing channels in parallel within a
+    // callback. Channels are processed serially if this is null.
+    std::unique_ptr<RealtimeWorkerPool> m_pChannelWorkerPool;
+    std::unique_ptr<PreloadBudget> m_pPreloadBudget;
+    std::unique_ptr<mixxx::PcmCache> m_pPcmCache;
+    std::unique_ptr<EngineCallbackTelemetry> m_pCallbackTelemetry;
+    QTimer m_callbackTelemetryTimer;
+    // The report is written on shutdown after xruns or in developer mode
+    QString m_callbackTelemetryReportPath;
     EngineSync* m_pMasterSync;
 
     ControlObject* m_pMasterGain;
@@ -334,6 +398,7 @@ class EngineMaster : public QObject, public AudioSource {
     ControlPushButton* m_pXFaderReverse;
     ControlPushButton* m_pHeadSplitEnabled;
     ControlObject* m_pKeylockEngine;
+    ControlObject* m_pKeylockLookahead;
 
     PflGainCalculator m_headphoneGain;
     TalkoverGainCalculator m_talkoverGain;
@@ -358,6 +423,11 @@ class EngineMaster : public QObject, public AudioSource {
 
     volatile bool m_bBusOutputConnected[3];
     bool m_bExternalRecordBroadcastInputConnected;
+    // Use the fused ChannelMixer functions instead of the generated ones.
+    bool m_bFusedChannelMixer;
+    // Process the pre-fader effects of all channels after their audio, so
+    // that the equalizers of all decks can filter in one batch.
+    bool m_bBatchPreFaderEffects;
 };
 
 #endif
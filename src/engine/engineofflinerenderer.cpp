@@ -0,0 +1,291 @@
+#include "engine/engineofflinerenderer.h"
+
+#include <QAtomicInt>
+#include <QFile>
+#include <QObject>
+#include <QRegExp>
+#include <QThread>
+
+#include <algorithm>
+#include <memory>
+
+#include "control/controlobject.h"
+#include "engine/channels/enginedeck.h"
+#include "engine/engine.h"
+#include "engine/enginebuffer.h"
+#include "engine/enginemaster.h"
+#include "engine/sidechain/enginerecord.h"
+#include "recording/defs_recording.h"
+#include "soundio/soundmanagerutil.h"
+#include "util/defs.h"
+#include "util/logger.h"
+#include "util/math.h"
+#include "util/performancetimer.h"
+
+namespace {
+
+const mixxx::Logger kLogger("EngineOfflineRenderer");
+
+const ConfigKey kSampleRateKey("[Master]", "samplerate");
+const ConfigKey kRecordingStatusKey(RECORDING_PREF_KEY, "status");
+
+// Interval for polling the preload state of the decks
+constexpr int kPreloadPollMillis = 10;
+
+} // anonymous namespace
+
+EngineOfflineRenderer::EngineOfflineRenderer(
+        EngineMaster* pEngineMaster,
+        UserSettingsPointer pConfig,
+        SINT bufferFrames)
+        : m_pEngineMaster(pEngineMaster),
+          m_pConfig(std::move(pConfig)),
+          m_bufferFrames(bufferFrames),
+          m_nextControlChange(0),
+          m_framesRendered(0) {
+    DEBUG_ASSERT(m_pEngineMaster);
+    DEBUG_ASSERT(m_bufferFrames > 0);
+    DEBUG_ASSERT(mixxx::kEngineChannelCount * m_bufferFrames <=
+            static_cast<SINT>(MAX_BUFFER_LEN));
+    // Process the master mix like with a connected sound device
+    m_pEngineMaster->onOutputConnected(AudioOutput(AudioOutput::MASTER, 0, 2));
+}
+
+EngineOfflineRenderer::~EngineOfflineRenderer() {
+    finish();
+}
+
+// static
+bool EngineOfflineRenderer::parseTimeline(
+        QTextStream* pStream,
+        std::vector<ControlChange>* pControlChanges,
+        QString* pErrorMessage) {
+    DEBUG_ASSERT(pStream);
+    DEBUG_ASSERT(pControlChanges);
+    int lineNumber = 0;
+    while (!pStream->atEnd()) {
+        const QString line = pStream->readLine().trimmed();
+        ++lineNumber;
+        if (line.isEmpty() || line.startsWith('#')) {
+            continue;
+        }
+        const QStringList fields = line.split(QRegExp("\\s+"));
+        bool secondsValid = false;
+        bool valueValid = false;
+        ControlChange controlChange;
+        if (fields.size() == 4) {
+            controlChange.seconds = fields[0].toDouble(&secondsValid);
+            controlChange.key = ConfigKey(fields[1], fields[2]);
+            controlChange.value = fields[3].toDouble(&valueValid);
+        }
+        if (!secondsValid || !valueValid || controlChange.seconds < 0) {
+            if (pErrorMessage) {
+                *pErrorMessage = QString("Invalid control change in line %1: %2")
+                                         .arg(QString::number(lineNumber), line);
+            }
+            return false;
+        }
+        pControlChanges->push_back(controlChange);
+    }
+    return true;
+}
+
+bool EngineOfflineRenderer::loadTimeline(
+        const QString& filePath, QString* pErrorMessage) {
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        if (pErrorMessage) {
+            *pErrorMessage = QString("Failed to open timeline %1: %2")
+                                     .arg(filePath, file.errorString());
+        }
+        return false;
+    }
+    QTextStream stream(&file);
+    std::vector<ControlChange> controlChanges;
+    if (!parseTimeline(&stream, &controlChanges, pErrorMessage)) {
+        return false;
+    }
+    for (const auto& controlChange : controlChanges) {
+        addControlChange(
+                controlChange.seconds,
+                controlChange.key,
+                controlChange.value);
+    }
+    return true;
+}
+
+void EngineOfflineRenderer::addControlChange(
+        double seconds, const ConfigKey& key, double value) {
+    // Changes with the same time are applied in the order they were added.
+    // Changes in the past are applied before the next buffer.
+    const auto begin = m_controlChanges.begin() + m_nextControlChange;
+    const auto pos = std::upper_bound(
+            begin,
+            m_controlChanges.end(),
+            seconds,
+            [](double seconds, const ControlChange& controlChange) {
+                return seconds < controlChange.seconds;
+            });
+    m_controlChanges.insert(pos, ControlChange{seconds, key, value});
+}
+
+void EngineOfflineRenderer::addSink(SideChainWorker* pSink) {
+    DEBUG_ASSERT(pSink);
+    m_sinks.push_back(pSink);
+}
+
+void EngineOfflineRenderer::recordTo(const QString& filePath) {
+    if (!ControlObject::getControl(kRecordingStatusKey, false)) {
+        m_pRecordingStatus = std::make_unique<ControlObject>(kRecordingStatusKey);
+    }
+    if (!m_pRecord) {
+        m_pRecord = std::make_unique<EngineRecord>(m_pConfig);
+    }
+    // The recording starts when processing the next buffer,
+    // just like when requested by the RecordingManager
+    m_pConfig->setValue(ConfigKey(RECORDING_PREF_KEY, "Path"), filePath);
+    ControlObject::set(kRecordingStatusKey, RECORD_READY);
+}
+
+bool EngineOfflineRenderer::preloadTracks(
+        const QStringList& groups, int timeoutMillis) {
+    struct PendingDeck {
+        EngineBuffer* pEngineBuffer;
+        // Set by the reader thread when a load has finished or failed
+        std::shared_ptr<QAtomicInt> pLoadFinished;
+        QMetaObject::Connection trackLoadedConnection;
+        QMetaObject::Connection trackLoadFailedConnection;
+    };
+    std::vector<PendingDeck> decks;
+    for (const auto& group : groups) {
+        ControlObject::set(ConfigKey(group, "preload_fully"), 1.0);
+        auto* pDeck = dynamic_cast<EngineDeck*>(m_pEngineMaster->getChannel(group));
+        VERIFY_OR_DEBUG_ASSERT(pDeck) {
+            kLogger.warning() << "No deck found for" << group;
+            continue;
+        }
+        PendingDeck deck;
+        deck.pEngineBuffer = pDeck->getEngineBuffer();
+        deck.pLoadFinished = std::make_shared<QAtomicInt>(0);
+        // Connected before checking for a pending load, so a track that
+        // finishes loading in between is not missed
+        const auto pLoadFinished = deck.pLoadFinished;
+        deck.trackLoadedConnection = QObject::connect(
+                deck.pEngineBuffer,
+                &EngineBuffer::trackLoaded,
+                [pLoadFinished] {
+                    pLoadFinished->storeRelease(1);
+                });
+        deck.trackLoadFailedConnection = QObject::connect(
+                deck.pEngineBuffer,
+                &EngineBuffer::trackLoadFailed,
+                [pLoadFinished] {
+                    pLoadFinished->storeRelease(1);
+                });
+        decks.push_back(std::move(deck));
+    }
+
+    PerformanceTimer timer;
+    timer.start();
+    bool preloaded = false;
+    while (true) {
+        preloaded = true;
+        for (const auto& deck : decks) {
+            // A track that is still loading has not been preloaded yet
+            if (deck.pEngineBuffer->isTrackLoadPending() &&
+                    !deck.pLoadFinished->loadAcquire()) {
+                preloaded = false;
+                break;
+            }
+            if (deck.pEngineBuffer->isTrackLoaded() &&
+                    !deck.pEngineBuffer->isTrackPreloaded()) {
+                preloaded = false;
+                break;
+            }
+        }
+        if (preloaded) {
+            break;
+        }
+        if (timer.elapsed().toIntegerMillis() >= timeoutMillis) {
+            kLogger.warning()
+                    << "Timed out while preloading the tracks of" << groups;
+            break;
+        }
+        QThread::msleep(kPreloadPollMillis);
+    }
+
+    for (const auto& deck : decks) {
+        QObject::disconnect(deck.trackLoadedConnection);
+        QObject::disconnect(deck.trackLoadFailedConnection);
+    }
+    return preloaded;
+}
+
+void EngineOfflineRenderer::applyControlChanges(double untilSeconds) {
+    while (m_nextControlChange < m_controlChanges.size()) {
+        const auto& controlChange = m_controlChanges[m_nextControlChange];
+        if (controlChange.seconds >= untilSeconds) {
+            return;
+        }
+        ++m_nextControlChange;
+        ControlObject* pControl = ControlObject::getControl(controlChange.key);
+        if (pControl) {
+            pControl->set(controlChange.value);
+        }
+    }
+}
+
+EngineOfflineRenderer::Result EngineOfflineRenderer::render(double seconds) {
+    Result result;
+    const double sampleRate = ControlObject::get(kSampleRateKey);
+    VERIFY_OR_DEBUG_ASSERT(sampleRate > 0) {
+        result.succeeded = false;
+        return result;
+    }
+    const auto framesToRender = static_cast<SINT>(seconds * sampleRate);
+
+    PerformanceTimer timer;
+    timer.start();
+    while (result.frames < framesToRender) {
+        const SINT bufferFrames = math_min(m_bufferFrames, framesToRender - result.frames);
+        const SINT bufferSamples = mixxx::kEngineChannelCount * bufferFrames;
+
+        applyControlChanges((m_framesRendered + bufferFrames) / sampleRate);
+        m_pEngineMaster->process(static_cast<int>(bufferSamples));
+
+        const CSAMPLE* pMaster = m_pEngineMaster->getMasterBuffer();
+        for (auto* pSink : m_sinks) {
+            pSink->process(pMaster, static_cast<int>(bufferSamples));
+        }
+        if (m_pRecord) {
+            m_pRecord->process(pMaster, static_cast<int>(bufferSamples));
+            if (ControlObject::get(kRecordingStatusKey) == RECORD_OFF) {
+                kLogger.warning() << "Failed to start the recording";
+                m_pRecord.reset();
+                result.succeeded = false;
+                break;
+            }
+        }
+
+        result.frames += bufferFrames;
+        m_framesRendered += bufferFrames;
+    }
+    result.elapsed = timer.elapsed();
+    result.audioDuration = mixxx::Duration::fromSeconds(result.frames / sampleRate);
+
+    kLogger.info()
+            << "Rendered" << result.audioDuration.formatSecondsWithUnit()
+            << "in" << result.elapsed.formatMillisWithUnit()
+            << QString("(%1x realtime)").arg(result.realtimeMultiple(), 0, 'f', 1);
+    return result;
+}
+
+void EngineOfflineRenderer::finish() {
+    if (!m_pRecord) {
+        return;
+    }
+    // Closes the file after encoding the remaining samples
+    ControlObject::set(kRecordingStatusKey, RECORD_OFF);
+    m_pRecord->process(m_pEngineMaster->getMasterBuffer(), 0);
+    m_pRecord.reset();
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QTextStream>
+
+#include <memory>
+#include <vector>
+
+#include "preferences/usersettings.h"
+#include "util/class.h"
+#include "util/duration.h"
+#include "util/types.h"
+
+class ControlObject;
+class EngineMaster;
+class EngineRecord;
+class SideChainWorker;
+
+// Drives EngineMaster without a sound device as fast as the CPU allows,
+// e.g. for bouncing mixes, regression checks of the audio output or
+// generating reference buffers. Control changes are applied from a
+// scripted timeline.
+//
+// Must not be used while SoundManager drives the same engine. Decks read
+// their tracks asynchronously like in the audio callback, so the tracks
+// should be preloaded completely before rendering faster than realtime.
+class EngineOfflineRenderer {
+  public:
+    static constexpr SINT kDefaultBufferFrames = 1024;
+
+    struct ControlChange {
+        double seconds;
+        ConfigKey key;
+        double value;
+    };
+
+    struct Result {
+        Result()
+                : frames(0),
+                  succeeded(true) {
+        }
+
+        // How many times faster than realtime
+        double realtimeMultiple() const {
+            const double elapsedSeconds = elapsed.toDoubleSeconds();
+            if (elapsedSeconds <= 0) {
+                return 0;
+            }
+            return audioDuration.toDoubleSeconds() / elapsedSeconds;
+        }
+
+        SINT frames;
+        mixxx::Duration audioDuration;
+        mixxx::Duration elapsed;
+        // False if the recording could not be started
+        bool succeeded;
+    };
+
+    EngineOfflineRenderer(
+            EngineMaster* pEngineMaster,
+            UserSettingsPointer pConfig,
+            SINT bufferFrames = kDefaultBufferFrames);
+    ~EngineOfflineRenderer();
+
+    // Each line of a timeline contains the time in seconds, the group,
+    // the item and the value of a control change separated by whitespace,
+    // e.g. "12.5 [Channel1] play 1". Empty lines and lines starting with
+    // '#' are ignored.
+    static bool parseTimeline(
+            QTextStream* pStream,
+            std::vector<ControlChange>* pControlChanges,
+            QString* pErrorMessage = nullptr);
+    bool loadTimeline(const QString& filePath, QString* pErrorMessage = nullptr);
+
+    // Changes are applied at the start of the buffer that contains
+    // their time relative to the start of rendering
+    void addControlChange(double seconds, const ConfigKey& key, double value);
+
+    // The sink receives the master output of each buffer
+    void addSink(SideChainWorker* pSink);
+
+    // Encodes the master output like EngineRecord does for a recording
+    // with the file format and metadata selected in the preferences
+    void recordTo(const QString& filePath);
+
+    // Enables the whole-track preload of the decks and waits until their
+    // tracks have been loaded and decoded into memory. Tracks that are
+    // still loading are waited for. Returns false on timeout, e.g. if the
+    // tracks exceed the preload memory budget.
+    bool preloadTracks(const QStringList& groups, int timeoutMillis);
+
+    // Continues where the previous call stopped
+    Result render(double seconds);
+
+    // Stops the recording and flushes the encoder
+    void finish();
+
+    SINT framesRendered() const {
+        return m_framesRendered;
+    }
+
+  private:
+    void applyControlChanges(double untilSeconds);
+
+    EngineMaster* const m_pEngineMaster;
+    const UserSettingsPointer m_pConfig;
+    const SINT m_bufferFrames;
+
+    // Sorted by time
+    std::vector<ControlChange> m_controlChanges;
+    size_t m_nextControlChange;
+
+    std::vector<SideChainWorker*> m_sinks;
+
+    // Only created if the recording manager does not exist
+    std::unique_ptr<ControlObject> m_pRecordingStatus;
+    std::unique_ptr<EngineRecord> m_pRecord;
+
+    SINT m_framesRendered;
+
+    DISALLOW_COPY_AND_ASSIGN(EngineOfflineRenderer);
+};
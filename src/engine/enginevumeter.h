@@ -41,6 +41,17 @@ class EngineVuMeter : public EngineObject {
 
     void reset();
 
+    // The smoothed levels that are published to the VuMeter controls
+    CSAMPLE getVolume() const {
+        return (m_fRMSvolumeL + m_fRMSvolumeR) / 2;
+    }
+    CSAMPLE getVolumeLeft() const {
+        return m_fRMSvolumeL;
+    }
+    CSAMPLE getVolumeRight() const {
+        return m_fRMSvolumeR;
+    }
+
   private:
     void doSmooth(CSAMPLE &currentVolume, CSAMPLE newVolume);
 
@@ -20,7 +20,8 @@ EngineWorkerScheduler::~EngineWorkerScheduler() {
 }
 
 void EngineWorkerScheduler::workerReady() {
-    m_bWakeScheduler = true;
+    // Publishes the worker's ready state to the thread that wakes it
+    m_bWakeScheduler.store(true, std::memory_order_release);
 }
 
 void EngineWorkerScheduler::addWorker(EngineWorker* pWorker) {
@@ -31,10 +32,9 @@ void EngineWorkerScheduler::addWorker(EngineWorker* pWorker) {
 
 void EngineWorkerScheduler::runWorkers() {
     // Wake the scheduler if we have written a worker-ready message to the
-    // scheduler. There is no race condition in accessing this boolean because
-    // both workerReady and runWorkers are called from the callback thread.
-    if (m_bWakeScheduler) {
-        m_bWakeScheduler = false;
+    // scheduler. workerReady() is called from the callback thread and from
+    // the threads of the channel worker pool while the callback joins them.
+    if (m_bWakeScheduler.exchange(false, std::memory_order_acq_rel)) {
         m_waitCondition.wakeAll();
     }
 }
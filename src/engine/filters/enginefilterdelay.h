@@ -3,6 +3,7 @@
 
 #include "engine/engineobject.h"
 #include "util/assert.h"
+#include "util/delayline.h"
 #include "util/sample.h"
 
 template<unsigned int SIZE>
@@ -11,10 +12,8 @@ class EngineFilterDelay : public EngineObjectConstIn {
     EngineFilterDelay()
             : m_delaySamples(0),
               m_oldDelaySamples(0),
-              m_delayPos(0),
+              m_delayLine(SIZE),
               m_doStart(false) {
-        // Set the current buffers to 0
-        memset(m_buf, 0, sizeof(m_buf));
     }
 
     virtual ~EngineFilterDelay() {};
@@ -22,7 +21,7 @@ class EngineFilterDelay : public EngineObjectConstIn {
     void pauseFilter() {
         // Set the current buffers to 0
         if (!m_doStart) {
-            memset(m_buf, 0, sizeof(m_buf));
+            m_delayLine.clear();
             m_oldDelaySamples = 0;
             m_doStart = true;
         }
@@ -34,44 +33,16 @@ class EngineFilterDelay : public EngineObjectConstIn {
 
     virtual void process(const CSAMPLE* pIn, CSAMPLE* pOutput,
                          const int iBufferSize) {
+        VERIFY_OR_DEBUG_ASSERT(m_delaySamples >= 0 &&
+                m_delaySamples < m_delayLine.capacity()) {
+            SampleUtil::copy(pOutput, pIn, iBufferSize);
+            return;
+        }
         if (m_oldDelaySamples == m_delaySamples) {
-            int delaySourcePos = (m_delayPos + SIZE - m_delaySamples) % SIZE;
-
-            VERIFY_OR_DEBUG_ASSERT(delaySourcePos >= 0) {
-                SampleUtil::copy(pOutput, pIn, iBufferSize);
-                return;
-            }
-            VERIFY_OR_DEBUG_ASSERT(delaySourcePos <= static_cast<int>(SIZE)) {
-                SampleUtil::copy(pOutput, pIn, iBufferSize);
-                return;
-            }
-
-            for (int i = 0; i < iBufferSize; ++i) {
-                // put sample into delay buffer:
-                m_buf[m_delayPos] = pIn[i];
-                m_delayPos = (m_delayPos + 1) % SIZE;
-
-                // Take delayed sample from delay buffer and copy it to dest buffer:
-                pOutput[i] = m_buf[delaySourcePos];
-                delaySourcePos = (delaySourcePos + 1) % SIZE;
-            }
+            m_delayLine.process(pIn, pOutput, iBufferSize, m_delaySamples);
         } else {
-            int delaySourcePos = (m_delayPos + SIZE - m_delaySamples + iBufferSize / 2) % SIZE;
-            int oldDelaySourcePos = (m_delayPos + SIZE - m_oldDelaySamples) % SIZE;
-
-            VERIFY_OR_DEBUG_ASSERT(delaySourcePos >= 0) {
-                SampleUtil::copy(pOutput, pIn, iBufferSize);
-                return;
-            }
-            VERIFY_OR_DEBUG_ASSERT(delaySourcePos <= static_cast<int>(SIZE)) {
-                SampleUtil::copy(pOutput, pIn, iBufferSize);
-                return;
-            }
-            VERIFY_OR_DEBUG_ASSERT(oldDelaySourcePos >= 0) {
-                SampleUtil::copy(pOutput, pIn, iBufferSize);
-                return;
-            }
-            VERIFY_OR_DEBUG_ASSERT(oldDelaySourcePos <= static_cast<int>(SIZE)) {
+            VERIFY_OR_DEBUG_ASSERT(m_oldDelaySamples >= 0 &&
+                    m_oldDelaySamples < m_delayLine.capacity()) {
                 SampleUtil::copy(pOutput, pIn, iBufferSize);
                 return;
             }
@@ -81,21 +52,18 @@ class EngineFilterDelay : public EngineObjectConstIn {
 
             for (int i = 0; i < iBufferSize; ++i) {
                 // put sample into delay buffer:
-                m_buf[m_delayPos] = pIn[i];
-                m_delayPos = (m_delayPos + 1) % SIZE;
+                m_delayLine.writeFrame(&pIn[i]);
 
                 // Take delayed sample from delay buffer and copy it to dest buffer:
                 if (i < iBufferSize / 2) {
                     // only ramp the second half of the buffer, because we do
                     // the same in the IIR filter to wait for settling
-                    pOutput[i] = m_buf[oldDelaySourcePos];
+                    pOutput[i] = *m_delayLine.frame(m_oldDelaySamples);
                 } else {
-                    pOutput[i] = m_buf[oldDelaySourcePos] * (1.0 - cross_mix);
-                    pOutput[i] += m_buf[delaySourcePos] * cross_mix;
-                    delaySourcePos = (delaySourcePos + 1) % SIZE;
+                    pOutput[i] = *m_delayLine.frame(m_oldDelaySamples) * (1.0 - cross_mix);
+                    pOutput[i] += *m_delayLine.frame(m_delaySamples) * cross_mix;
                     cross_mix += cross_inc;
                 }
-                oldDelaySourcePos = (oldDelaySourcePos + 1) % SIZE;
             }
             m_oldDelaySamples = m_delaySamples;
         }
@@ -118,8 +86,8 @@ class EngineFilterDelay : public EngineObjectConstIn {
   protected:
     int m_delaySamples;
     int m_oldDelaySamples;
-    int m_delayPos;
-    double m_buf[SIZE];
+    // The samples are delayed one by one, regardless of the channel
+    mixxx::DelayLine<CSAMPLE, 1> m_delayLine;
     bool m_doStart;
 };
 
@@ -8,6 +8,11 @@
 #include "engine/engineobject.h"
 #include "util/sample.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ENGINEFILTERIIR_SSE2
+#include <emmintrin.h>
+#endif
+
 // set to 1 to print some analysis data using qDebug()
 // It prints the resulting delay after 50 % of impulse have passed
 // and the gain and phase shift at some sample frequencies
@@ -25,6 +30,178 @@ enum IIRPass {
 };
 
 
+// The left and the right channel of a stereo frame in double precision.
+// processSample() is written for this type as well as for double, so that
+// the recursion of both channels runs in the two lanes of one SSE2 vector.
+// The operations are the same per channel, so the results do not differ
+// from processing each channel on its own.
+struct EngineFilterIIRFrame {
+    static EngineFilterIIRFrame load(const CSAMPLE* pIn);
+    void store(CSAMPLE* pOut) const;
+
+    // Not aligned, because the filters are allocated with new
+    double v[2];
+};
+
+#ifdef ENGINEFILTERIIR_SSE2
+
+inline __m128d loadIIRFrameLanes(const EngineFilterIIRFrame& frame) {
+    return _mm_loadu_pd(frame.v);
+}
+
+inline EngineFilterIIRFrame storeIIRFrameLanes(__m128d lanes) {
+    EngineFilterIIRFrame frame;
+    _mm_storeu_pd(frame.v, lanes);
+    return frame;
+}
+
+inline EngineFilterIIRFrame EngineFilterIIRFrame::load(const CSAMPLE* pIn) {
+    return storeIIRFrameLanes(_mm_cvtps_pd(_mm_castpd_ps(
+            _mm_load_sd(reinterpret_cast<const double*>(pIn)))));
+}
+
+inline void EngineFilterIIRFrame::store(CSAMPLE* pOut) const {
+    _mm_storel_pi(reinterpret_cast<__m64*>(pOut),
+            _mm_cvtpd_ps(loadIIRFrameLanes(*this)));
+}
+
+inline EngineFilterIIRFrame operator+(
+        const EngineFilterIIRFrame& a, const EngineFilterIIRFrame& b) {
+    return storeIIRFrameLanes(_mm_add_pd(loadIIRFrameLanes(a), loadIIRFrameLanes(b)));
+}
+
+inline EngineFilterIIRFrame operator-(
+        const EngineFilterIIRFrame& a, const EngineFilterIIRFrame& b) {
+    return storeIIRFrameLanes(_mm_sub_pd(loadIIRFrameLanes(a), loadIIRFrameLanes(b)));
+}
+
+inline EngineFilterIIRFrame operator-(const EngineFilterIIRFrame& a) {
+    // Flip the sign bits like the unary minus of double
+    return storeIIRFrameLanes(_mm_xor_pd(loadIIRFrameLanes(a), _mm_set1_pd(-0.0)));
+}
+
+inline EngineFilterIIRFrame operator*(const EngineFilterIIRFrame& a, double b) {
+    return storeIIRFrameLanes(_mm_mul_pd(loadIIRFrameLanes(a), _mm_set1_pd(b)));
+}
+
+#else
+
+inline EngineFilterIIRFrame EngineFilterIIRFrame::load(const CSAMPLE* pIn) {
+    return {{pIn[0], pIn[1]}};
+}
+
+inline void EngineFilterIIRFrame::store(CSAMPLE* pOut) const {
+    pOut[0] = static_cast<CSAMPLE>(v[0]);
+    pOut[1] = static_cast<CSAMPLE>(v[1]);
+}
+
+inline EngineFilterIIRFrame operator+(
+        const EngineFilterIIRFrame& a, const EngineFilterIIRFrame& b) {
+    return {{a.v[0] + b.v[0], a.v[1] + b.v[1]}};
+}
+
+inline EngineFilterIIRFrame operator-(
+        const EngineFilterIIRFrame& a, const EngineFilterIIRFrame& b) {
+    return {{a.v[0] - b.v[0], a.v[1] - b.v[1]}};
+}
+
+inline EngineFilterIIRFrame operator-(const EngineFilterIIRFrame& a) {
+    return {{-a.v[0], -a.v[1]}};
+}
+
+inline EngineFilterIIRFrame operator*(const EngineFilterIIRFrame& a, double b) {
+    return {{a.v[0] * b, a.v[1] * b}};
+}
+
+#endif
+
+inline EngineFilterIIRFrame operator*(double a, const EngineFilterIIRFrame& b) {
+    return b * a;
+}
+
+inline EngineFilterIIRFrame& operator+=(
+        EngineFilterIIRFrame& a, const EngineFilterIIRFrame& b) {
+    a = a + b;
+    return a;
+}
+
+inline EngineFilterIIRFrame& operator-=(
+        EngineFilterIIRFrame& a, const EngineFilterIIRFrame& b) {
+    a = a - b;
+    return a;
+}
+
+// The stereo frames of LANES filters with the same coefficients, e.g. of the
+// same EQ band on several decks. processSample() is written for this type as
+// well, so that the recursions of all filters run side by side. They do not
+// depend on each other, so the CPU overlaps them instead of waiting for each
+// step of a single recursion. The operators are plain loops over all
+// samples, which the compiler vectorizes for the available instruction set.
+template<int LANES>
+struct EngineFilterIIRLanes {
+    // The left and the right channel of each lane
+    double v[2 * LANES];
+};
+
+template<int LANES>
+inline EngineFilterIIRLanes<LANES> operator+(
+        const EngineFilterIIRLanes<LANES>& a, const EngineFilterIIRLanes<LANES>& b) {
+    EngineFilterIIRLanes<LANES> result;
+    for (int i = 0; i < 2 * LANES; ++i) {
+        result.v[i] = a.v[i] + b.v[i];
+    }
+    return result;
+}
+
+template<int LANES>
+inline EngineFilterIIRLanes<LANES> operator-(
+        const EngineFilterIIRLanes<LANES>& a, const EngineFilterIIRLanes<LANES>& b) {
+    EngineFilterIIRLanes<LANES> result;
+    for (int i = 0; i < 2 * LANES; ++i) {
+        result.v[i] = a.v[i] - b.v[i];
+    }
+    return result;
+}
+
+template<int LANES>
+inline EngineFilterIIRLanes<LANES> operator-(const EngineFilterIIRLanes<LANES>& a) {
+    EngineFilterIIRLanes<LANES> result;
+    for (int i = 0; i < 2 * LANES; ++i) {
+        result.v[i] = -a.v[i];
+    }
+    return result;
+}
+
+template<int LANES>
+inline EngineFilterIIRLanes<LANES> operator*(
+        const EngineFilterIIRLanes<LANES>& a, double b) {
+    EngineFilterIIRLanes<LANES> result;
+    for (int i = 0; i < 2 * LANES; ++i) {
+        result.v[i] = a.v[i] * b;
+    }
+    return result;
+}
+
+template<int LANES>
+inline EngineFilterIIRLanes<LANES> operator*(
+        double a, const EngineFilterIIRLanes<LANES>& b) {
+    return b * a;
+}
+
+template<int LANES>
+inline EngineFilterIIRLanes<LANES>& operator+=(
+        EngineFilterIIRLanes<LANES>& a, const EngineFilterIIRLanes<LANES>& b) {
+    a = a + b;
+    return a;
+}
+
+template<int LANES>
+inline EngineFilterIIRLanes<LANES>& operator-=(
+        EngineFilterIIRLanes<LANES>& a, const EngineFilterIIRLanes<LANES>& b) {
+    a = a - b;
+    return a;
+}
+
 class EngineFilterIIRBase : public EngineObjectConstIn {
   public:
     virtual void assumeSettled() = 0;
@@ -82,11 +259,9 @@ class EngineFilterIIR : public EngineFilterIIRBase {
 
     void initBuffers() {
         // Copy the current buffers into the old buffers
-        memcpy(m_oldBuf1, m_buf1, sizeof(m_buf1));
-        memcpy(m_oldBuf2, m_buf2, sizeof(m_buf2));
+        memcpy(m_oldBuf, m_buf, sizeof(m_buf));
         // Set the current buffers to 0
-        memset(m_buf1, 0, sizeof(m_buf1));
-        memset(m_buf2, 0, sizeof(m_buf2));
+        memset(m_buf, 0, sizeof(m_buf));
         m_doRamping = true;
     }
 
@@ -205,8 +380,8 @@ class EngineFilterIIR : public EngineFilterIIRBase {
                          const int iBufferSize) {
         if (!m_doRamping) {
             for (int i = 0; i < iBufferSize; i += 2) {
-                pOutput[i] = processSample(m_coef, m_buf1, pIn[i]);
-                pOutput[i+1] = processSample(m_coef, m_buf2, pIn[i + 1]);
+                processSample(m_coef, m_buf,
+                        EngineFilterIIRFrame::load(pIn + i)).store(pOutput + i);
             }
         } else {
             double cross_mix = 0.0;
@@ -223,32 +398,25 @@ class EngineFilterIIR : public EngineFilterIIRBase {
                 // of the new filter but it turns out that this produces
                 // a gain drop due to the filter delay which is more
                 // conspicuous than the settling noise.
-                double old1;
-                double old2;
+                const EngineFilterIIRFrame in = EngineFilterIIRFrame::load(pIn + i);
+                EngineFilterIIRFrame oldFrame;
                 if (!m_doStart) {
                     // Process old filter, but only if we do not do a fresh start
-                    old1 = processSample(m_oldCoef, m_oldBuf1, pIn[i]);
-                    old2 = processSample(m_oldCoef, m_oldBuf2, pIn[i + 1]);
+                    oldFrame = processSample(m_oldCoef, m_oldBuf, in);
                 } else {
                     if (m_startFromDry) {
-                        old1 = pIn[i];
-                        old2 = pIn[i + 1];
+                        oldFrame = in;
                     } else {
-                        old1 = 0;
-                        old2 = 0;
+                        oldFrame = EngineFilterIIRFrame{};
                     }
                 }
-                double new1 = processSample(m_coef, m_buf1, pIn[i]);
-                double new2 = processSample(m_coef, m_buf2, pIn[i + 1]);
+                EngineFilterIIRFrame newFrame = processSample(m_coef, m_buf, in);
 
                 if (i < iBufferSize / 2) {
-                    pOutput[i] = old1;
-                    pOutput[i + 1] = old2;
+                    oldFrame.store(pOutput + i);
                 } else {
-                    pOutput[i] = new1 * cross_mix +
-                                 old1 * (1.0 - cross_mix);
-                    pOutput[i + 1] = new2  * cross_mix +
-                                     old2 * (1.0 - cross_mix);
+                    (newFrame * cross_mix +
+                            oldFrame * (1.0 - cross_mix)).store(pOutput + i);
                     cross_mix += cross_inc;
                 }
             }
@@ -257,12 +425,57 @@ class EngineFilterIIR : public EngineFilterIIRBase {
         }
     }
 
+    // Returns true if process() of both filters can run as lanes of
+    // processLanes(), because they do the same without ramping.
+    bool canShareLanes(const EngineFilterIIR& other) const {
+        return !m_doRamping && !other.m_doRamping &&
+                memcmp(m_coef, other.m_coef, sizeof(m_coef)) == 0;
+    }
+
+    // Does process() of LANES filters, which must share lanes, in one pass.
+    // Each lane does the operations of process(), so the output is the same.
+    // The buffers of different lanes must not overlap.
+    template<int LANES>
+    static void processLanes(EngineFilterIIR* const* ppFilters,
+            const CSAMPLE* const* ppIn,
+            CSAMPLE* const* ppOutput,
+            const int iBufferSize) {
+        EngineFilterIIR* pFirst = ppFilters[0];
+        EngineFilterIIRLanes<LANES> buf[SIZE];
+        for (unsigned int i = 0; i < SIZE; ++i) {
+            for (int lane = 0; lane < LANES; ++lane) {
+                buf[i].v[2 * lane] = ppFilters[lane]->m_buf[i].v[0];
+                buf[i].v[2 * lane + 1] = ppFilters[lane]->m_buf[i].v[1];
+            }
+        }
+        for (int i = 0; i < iBufferSize; i += 2) {
+            EngineFilterIIRLanes<LANES> in;
+            for (int lane = 0; lane < LANES; ++lane) {
+                in.v[2 * lane] = ppIn[lane][i];
+                in.v[2 * lane + 1] = ppIn[lane][i + 1];
+            }
+            const EngineFilterIIRLanes<LANES> out =
+                    pFirst->processSample(pFirst->m_coef, buf, in);
+            for (int lane = 0; lane < LANES; ++lane) {
+                ppOutput[lane][i] = static_cast<CSAMPLE>(out.v[2 * lane]);
+                ppOutput[lane][i + 1] = static_cast<CSAMPLE>(out.v[2 * lane + 1]);
+            }
+        }
+        for (unsigned int i = 0; i < SIZE; ++i) {
+            for (int lane = 0; lane < LANES; ++lane) {
+                ppFilters[lane]->m_buf[i].v[0] = buf[i].v[2 * lane];
+                ppFilters[lane]->m_buf[i].v[1] = buf[i].v[2 * lane + 1];
+            }
+        }
+    }
+
   protected:
-    inline double processSample(double* coef, double* buf, double val);
+    // Implemented for double and EngineFilterIIRFrame
+    template<typename T>
+    inline T processSample(const double* coef, T* buf, T val);
     inline void pauseFilterInner() {
         // Set the current buffers to 0
-        memset(m_buf1, 0, sizeof(m_buf1));
-        memset(m_buf2, 0, sizeof(m_buf2));
+        memset(m_buf, 0, sizeof(m_buf));
         m_doRamping = true;
         m_doStart = true;
     }
@@ -271,15 +484,10 @@ class EngineFilterIIR : public EngineFilterIIRBase {
     // Old coefficients needed for ramping
     double m_oldCoef[SIZE + 1];
 
-    // Channel 1 state
-    double m_buf1[SIZE];
-    // Old channel 1 buffer needed for ramping
-    double m_oldBuf1[SIZE];
-
-    // Channel 2 state
-    double m_buf2[SIZE];
-    // Old channel 2 buffer needed for ramping
-    double m_oldBuf2[SIZE];
+    // State of both channels
+    EngineFilterIIRFrame m_buf[SIZE];
+    // Old state needed for ramping
+    EngineFilterIIRFrame m_oldBuf[SIZE];
 
     // Flag set to true if ramping needs to be done
     bool m_doRamping;
@@ -290,10 +498,11 @@ class EngineFilterIIR : public EngineFilterIIRBase {
 };
 
 template<>
-inline double EngineFilterIIR<2, IIR_LP>::processSample(double* coef,
-                                                        double* buf,
-                                                        double val) {
-    double tmp, fir, iir;
+template<typename T>
+inline T EngineFilterIIR<2, IIR_LP>::processSample(const double* coef,
+                                                   T* buf,
+                                                   T val) {
+    T tmp, fir, iir;
     tmp = buf[0]; buf[0] = buf[1];
     iir = val * coef[0];
     iir -= coef[1] * tmp; fir = tmp;
@@ -304,10 +513,11 @@ inline double EngineFilterIIR<2, IIR_LP>::processSample(double* coef,
 }
 
 template<>
-inline double EngineFilterIIR<2, IIR_BP>::processSample(double* coef,
-                                                        double* buf,
-                                                        double val) {
-    double tmp, fir, iir;
+template<typename T>
+inline T EngineFilterIIR<2, IIR_BP>::processSample(const double* coef,
+                                                   T* buf,
+                                                   T val) {
+    T tmp, fir, iir;
     tmp = buf[0]; buf[0] = buf[1];
     iir = val * coef[0];
     iir -= coef[1] * tmp; fir = -tmp;
@@ -318,10 +528,11 @@ inline double EngineFilterIIR<2, IIR_BP>::processSample(double* coef,
 }
 
 template<>
-inline double EngineFilterIIR<2, IIR_HP>::processSample(double* coef,
-                                                        double* buf,
-                                                        double val) {
-    double tmp, fir, iir;
+template<typename T>
+inline T EngineFilterIIR<2, IIR_HP>::processSample(const double* coef,
+                                                   T* buf,
+                                                   T val) {
+    T tmp, fir, iir;
     tmp = buf[0]; buf[0] = buf[1];
     iir = val * coef[0];
     iir -= coef[1] * tmp; fir = tmp;
@@ -332,10 +543,11 @@ inline double EngineFilterIIR<2, IIR_HP>::processSample(double* coef,
 }
 
 template<>
-inline double EngineFilterIIR<4, IIR_LP>::processSample(double* coef,
-                                                        double* buf,
-                                                        double val) {
-    double tmp, fir, iir;
+template<typename T>
+inline T EngineFilterIIR<4, IIR_LP>::processSample(const double* coef,
+                                                   T* buf,
+                                                   T val) {
+    T tmp, fir, iir;
     tmp = buf[0]; buf[0] = buf[1]; buf[1] = buf[2]; buf[2] = buf[3];
     iir = val * coef[0];
     iir -= coef[1] * tmp; fir = tmp;
@@ -351,10 +563,11 @@ inline double EngineFilterIIR<4, IIR_LP>::processSample(double* coef,
 }
 
 template<>
-inline double EngineFilterIIR<8, IIR_BP>::processSample(double* coef,
-                                                        double* buf,
-                                                        double val) {
-    double tmp, fir, iir;
+template<typename T>
+inline T EngineFilterIIR<8, IIR_BP>::processSample(const double* coef,
+                                                   T* buf,
+                                                   T val) {
+    T tmp, fir, iir;
     tmp = buf[0]; buf[0] = buf[1]; buf[1] = buf[2]; buf[2] = buf[3];
     buf[3] = buf[4]; buf[4] = buf[5]; buf[5] = buf[6]; buf[6] = buf[7];
     iir = val * coef[0];
@@ -381,10 +594,11 @@ inline double EngineFilterIIR<8, IIR_BP>::processSample(double* coef,
 }
 
 template<>
-inline double EngineFilterIIR<4, IIR_HP>::processSample(double* coef,
-                                                        double* buf,
-                                                        double val) {
-    double tmp, fir, iir;
+template<typename T>
+inline T EngineFilterIIR<4, IIR_HP>::processSample(const double* coef,
+                                                   T* buf,
+                                                   T val) {
+    T tmp, fir, iir;
     tmp = buf[0]; buf[0] = buf[1]; buf[1] = buf[2]; buf[2] = buf[3];
     iir= val * coef[0];
     iir -= coef[1] * tmp; fir = tmp;
@@ -400,10 +614,11 @@ inline double EngineFilterIIR<4, IIR_HP>::processSample(double* coef,
 }
 
 template<>
-inline double EngineFilterIIR<8, IIR_LP>::processSample(double* coef,
-                                                        double* buf,
-                                                        double val) {
-    double tmp, fir, iir;
+template<typename T>
+inline T EngineFilterIIR<8, IIR_LP>::processSample(const double* coef,
+                                                   T* buf,
+                                                   T val) {
+    T tmp, fir, iir;
     tmp = buf[0]; buf[0] = buf[1]; buf[1] = buf[2]; buf[2] = buf[3];
     buf[3] = buf[4]; buf[4] = buf[5]; buf[5] = buf[6]; buf[6] = buf[7];
     iir = val * coef[0];
@@ -430,10 +645,11 @@ inline double EngineFilterIIR<8, IIR_LP>::processSample(double* coef,
 }
 
 template<>
-inline double EngineFilterIIR<16, IIR_BP>::processSample(double* coef,
-                                                         double* buf,
-                                                         double val) {
-    double tmp, fir, iir;
+template<typename T>
+inline T EngineFilterIIR<16, IIR_BP>::processSample(const double* coef,
+                                                    T* buf,
+                                                    T val) {
+    T tmp, fir, iir;
     tmp = buf[0]; buf[0] = buf[1]; buf[1] = buf[2]; buf[2] = buf[3];
     buf[3] = buf[4]; buf[4] = buf[5]; buf[5] = buf[6]; buf[6] = buf[7];
     buf[7] = buf[8]; buf[8] = buf[9]; buf[9] = buf[10]; buf[10] = buf[11];
@@ -482,10 +698,11 @@ inline double EngineFilterIIR<16, IIR_BP>::processSample(double* coef,
 }
 
 template<>
-inline double EngineFilterIIR<8, IIR_HP>::processSample(double* coef,
-                                                        double* buf,
-                                                        double val) {
-    double tmp, fir, iir;
+template<typename T>
+inline T EngineFilterIIR<8, IIR_HP>::processSample(const double* coef,
+                                                   T* buf,
+                                                   T val) {
+    T tmp, fir, iir;
     tmp = buf[0]; buf[0] = buf[1]; buf[1] = buf[2]; buf[2] = buf[3];
     buf[3] = buf[4]; buf[4] = buf[5]; buf[5] = buf[6]; buf[6] = buf[7];
     iir = val * coef[0];
@@ -513,10 +730,11 @@ inline double EngineFilterIIR<8, IIR_HP>::processSample(double* coef,
 
 // IIR_LP and IIR_HP use the same processSample routine
 template<>
-inline double EngineFilterIIR<5, IIR_BP>::processSample(double* coef,
-                                                        double* buf,
-                                                        double val) {
-    double tmp, fir, iir;
+template<typename T>
+inline T EngineFilterIIR<5, IIR_BP>::processSample(const double* coef,
+                                                   T* buf,
+                                                   T val) {
+    T tmp, fir, iir;
     tmp = buf[0]; buf[0] = buf[1];
     iir = val * coef[0];
     iir -= coef[1] * tmp; fir = coef[2] * tmp;
@@ -527,10 +745,11 @@ inline double EngineFilterIIR<5, IIR_BP>::processSample(double* coef,
 }
 
 template<>
-inline double EngineFilterIIR<4, IIR_LPMO>::processSample(double* coef,
-                                                        double* buf,
-                                                        double val) {
-   double tmp, fir, iir;
+template<typename T>
+inline T EngineFilterIIR<4, IIR_LPMO>::processSample(const double* coef,
+                                                     T* buf,
+                                                     T val) {
+   T tmp, fir, iir;
    tmp= buf[0]; buf[0] = buf[1]; buf[1] = buf[2]; buf[2] = buf[3];
    iir= val * coef[0];
    iir -= coef[1]*tmp; fir= tmp;
@@ -553,10 +772,11 @@ inline double EngineFilterIIR<4, IIR_LPMO>::processSample(double* coef,
 
 
 template<>
-inline double EngineFilterIIR<4, IIR_HPMO>::processSample(double* coef,
-                                                        double* buf,
-                                                        double val) {
-   double tmp, fir, iir;
+template<typename T>
+inline T EngineFilterIIR<4, IIR_HPMO>::processSample(const double* coef,
+                                                     T* buf,
+                                                     T val) {
+   T tmp, fir, iir;
    tmp= buf[0]; buf[0] = buf[1]; buf[1] = buf[2]; buf[2] = buf[3];
    iir= val * coef[0];
    iir -= coef[1]*tmp; fir= -tmp;
@@ -578,10 +798,11 @@ inline double EngineFilterIIR<4, IIR_HPMO>::processSample(double* coef,
 }
 
 template<>
-inline double EngineFilterIIR<2, IIR_LP2>::processSample(double* coef,
-                                                        double* buf,
-                                                        double val) {
-    double tmp, fir, iir;
+template<typename T>
+inline T EngineFilterIIR<2, IIR_LP2>::processSample(const double* coef,
+                                                    T* buf,
+                                                    T val) {
+    T tmp, fir, iir;
     tmp = buf[0];
     iir = val * coef[0];
     iir -= coef[1] * tmp; fir = tmp;
@@ -599,10 +820,11 @@ inline double EngineFilterIIR<2, IIR_LP2>::processSample(double* coef,
 
 
 template<>
-inline double EngineFilterIIR<2, IIR_HP2>::processSample(double* coef,
-                                                        double* buf,
-                                                        double val) {
-    double tmp, fir, iir;
+template<typename T>
+inline T EngineFilterIIR<2, IIR_HP2>::processSample(const double* coef,
+                                                    T* buf,
+                                                    T val) {
+    T tmp, fir, iir;
     tmp = buf[0];
     iir = val * -coef[0]; // swap gain to be in phase with LP2
     iir -= coef[1] * tmp; fir = -tmp;
@@ -0,0 +1,127 @@
+#ifndef ENGINEFILTERIIRBATCH_H
+#define ENGINEFILTERIIRBATCH_H
+
+#include "engine/filters/enginefilteriir.h"
+
+// Collects the filters of several channels, e.g. of the equalizers of all
+// decks, and runs them in one go. Filters of the same type with the same
+// coefficients run as lanes of EngineFilterIIR::processLanes(), which is
+// the case for the same band of an EQ on all decks.
+class EngineFilterIIRBatch {
+  public:
+    static constexpr int kMaxFilters = 32;
+
+    EngineFilterIIRBatch()
+            : m_numJobs(0) {
+    }
+
+    // Adds a filter to run over pIn into pOutput in process(). pIn may be
+    // equal to pOutput. Returns false if the batch is full, then the caller
+    // has to run the filter itself.
+    template<unsigned int SIZE, enum IIRPass PASS>
+    bool add(EngineFilterIIR<SIZE, PASS>* pFilter,
+            const CSAMPLE* pIn, CSAMPLE* pOutput) {
+        if (m_numJobs >= kMaxFilters) {
+            return false;
+        }
+        Job& job = m_jobs[m_numJobs++];
+        job.pFilter = pFilter;
+        job.pIn = pIn;
+        job.pOutput = pOutput;
+        job.run = &runJobs<SIZE, PASS>;
+        return true;
+    }
+
+    bool isEmpty() const {
+        return m_numJobs == 0;
+    }
+
+    // Runs all added filters and empties the batch
+    void process(const int iBufferSize) {
+        Job group[kMaxFilters];
+        bool grouped[kMaxFilters] = {};
+        for (int i = 0; i < m_numJobs; ++i) {
+            if (grouped[i]) {
+                continue;
+            }
+            // All filters of one type
+            int groupSize = 0;
+            for (int j = i; j < m_numJobs; ++j) {
+                if (!grouped[j] && m_jobs[j].run == m_jobs[i].run) {
+                    group[groupSize++] = m_jobs[j];
+                    grouped[j] = true;
+                }
+            }
+            m_jobs[i].run(group, groupSize, iBufferSize);
+        }
+        m_numJobs = 0;
+    }
+
+  private:
+    struct Job;
+    typedef void (*RunFunction)(const Job* pJobs, int numJobs, int iBufferSize);
+
+    struct Job {
+        EngineFilterIIRBase* pFilter;
+        const CSAMPLE* pIn;
+        CSAMPLE* pOutput;
+        RunFunction run;
+    };
+
+    // Runs jobs whose filters are all of this type
+    template<unsigned int SIZE, enum IIRPass PASS>
+    static void runJobs(const Job* pJobs, int numJobs, int iBufferSize) {
+        typedef EngineFilterIIR<SIZE, PASS> Filter;
+        Filter* filters[kMaxFilters];
+        const CSAMPLE* ins[kMaxFilters];
+        CSAMPLE* outputs[kMaxFilters];
+        bool done[kMaxFilters] = {};
+        for (int i = 0; i < numJobs; ++i) {
+            if (done[i]) {
+                continue;
+            }
+            Filter* pFirst = static_cast<Filter*>(pJobs[i].pFilter);
+            int numLanes = 0;
+            for (int j = i; j < numJobs; ++j) {
+                Filter* pFilter = static_cast<Filter*>(pJobs[j].pFilter);
+                if (!done[j] && (j == i || pFirst->canShareLanes(*pFilter))) {
+                    filters[numLanes] = pFilter;
+                    ins[numLanes] = pJobs[j].pIn;
+                    outputs[numLanes] = pJobs[j].pOutput;
+                    ++numLanes;
+                    done[j] = true;
+                }
+            }
+            runLanes(filters, ins, outputs, numLanes, iBufferSize);
+        }
+    }
+
+    template<unsigned int SIZE, enum IIRPass PASS>
+    static void runLanes(EngineFilterIIR<SIZE, PASS>* const* ppFilters,
+            const CSAMPLE* const* ppIn,
+            CSAMPLE* const* ppOutput,
+            int numLanes,
+            int iBufferSize) {
+        typedef EngineFilterIIR<SIZE, PASS> Filter;
+        // With more than four lanes the state of the recursions no longer
+        // fits into the registers, so eight decks run as two groups of four
+        int lane = 0;
+        for (; numLanes - lane >= 4; lane += 4) {
+            Filter::template processLanes<4>(&ppFilters[lane],
+                    &ppIn[lane], &ppOutput[lane], iBufferSize);
+        }
+        if (numLanes - lane >= 2) {
+            Filter::template processLanes<2>(&ppFilters[lane],
+                    &ppIn[lane], &ppOutput[lane], iBufferSize);
+            lane += 2;
+        }
+        if (lane < numLanes) {
+            ppFilters[lane]->process(ppIn[lane], ppOutput[lane], iBufferSize);
+        }
+    }
+
+    Job m_jobs[kMaxFilters];
+    int m_numJobs;
+};
+
+#endif // ENGINEFILTERIIRBATCH_H
@@ -0,0 +1,399 @@
+#include <dsp/transforms/FFT.h>
+
+// Class header comes after library includes here since our preprocessor
+// definitions interfere with qm-dsp's headers.
+#include "engine/filters/partitionedconvolution.h"
+
+#include <algorithm>
+#include <atomic>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PARTITIONEDCONVOLUTION_SSE2
+#endif
+
+#include "util/assert.h"
+#include "util/math.h"
+
+namespace {
+
+quint64 nextKernelSerial() {
+    static std::atomic<quint64> s_serial(0);
+    return ++s_serial;
+}
+
+// sum += x * h for stride complex bins, stride is a multiple of 4
+inline void complexMultiplyAccumulate(float* pSumReal, float* pSumImag,
+        const float* pReal1, const float* pImag1,
+        const float* pReal2, const float* pImag2,
+        SINT stride) {
+#ifdef PARTITIONEDCONVOLUTION_SSE2
+    for (SINT i = 0; i < stride; i += 4) {
+        const __m128 real1 = _mm_loadu_ps(pReal1 + i);
+        const __m128 imag1 = _mm_loadu_ps(pImag1 + i);
+        const __m128 real2 = _mm_loadu_ps(pReal2 + i);
+        const __m128 imag2 = _mm_loadu_ps(pImag2 + i);
+        const __m128 real = _mm_sub_ps(
+                _mm_mul_ps(real1, real2), _mm_mul_ps(imag1, imag2));
+        const __m128 imag = _mm_add_ps(
+                _mm_mul_ps(real1, imag2), _mm_mul_ps(imag1, real2));
+        _mm_storeu_ps(pSumReal + i, _mm_add_ps(_mm_loadu_ps(pSumReal + i), real));
+        _mm_storeu_ps(pSumImag + i, _mm_add_ps(_mm_loadu_ps(pSumImag + i), imag));
+    }
+#else
+    for (SINT i = 0; i < stride; ++i) {
+        pSumReal[i] += pReal1[i] * pReal2[i] - pImag1[i] * pImag2[i];
+        pSumImag[i] += pReal1[i] * pImag2[i] + pImag1[i] * pReal2[i];
+    }
+#endif
+}
+
+// size is a multiple of 4
+inline float dotProduct(const float* pSamples1, const float* pSamples2,
+        SINT size) {
+#ifdef PARTITIONEDCONVOLUTION_SSE2
+    __m128 sum = _mm_setzero_ps();
+    for (SINT i = 0; i < size; i += 4) {
+        sum = _mm_add_ps(sum, _mm_mul_ps(
+                _mm_loadu_ps(pSamples1 + i), _mm_loadu_ps(pSamples2 + i)));
+    }
+    // Add the upper to the lower half, then the two remaining lanes
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+    return _mm_cvtss_f32(sum);
+#else
+    float sum = 0;
+    for (SINT i = 0; i < size; ++i) {
+        sum += pSamples1[i] * pSamples2[i];
+    }
+    return sum;
+#endif
+}
+
+} // anonymous namespace
+
+constexpr int PartitionedConvolutionKernel::kChannelCount;
+constexpr SINT PartitionedConvolutionKernel::kDirectFrames;
+constexpr SINT PartitionedConvolutionKernel::kLongBlockFrames;
+constexpr SINT PartitionedConvolutionKernel::kMaxShortPartitions;
+constexpr SINT PartitionedConvolutionKernel::kMaxLongPartitions;
+constexpr SINT PartitionedConvolutionKernel::kMaxFrames;
+
+PartitionedConvolutionKernel::PartitionedConvolutionKernel(
+        const CSAMPLE* pFrames,
+        SINT frames,
+        SINT sampleRate)
+        : m_frames(math_clamp(frames, SINT(0), kMaxFrames)),
+          m_sampleRate(sampleRate),
+          m_serial(nextKernelSerial()) {
+    for (int channel = 0; channel < kChannelCount; ++channel) {
+        std::vector<float>& taps = m_directTaps[channel];
+        taps.assign(kDirectFrames, 0);
+        for (SINT frame = 0; frame < math_min(m_frames, kDirectFrames); ++frame) {
+            taps[kDirectFrames - 1 - frame] = pFrames[kChannelCount * frame + channel];
+        }
+    }
+    computeSpectra(&m_shortSpectra,
+            pFrames,
+            kDirectFrames,
+            math_min(m_frames, kLongBlockFrames));
+    computeSpectra(&m_longSpectra, pFrames, kLongBlockFrames, m_frames);
+    DEBUG_ASSERT(m_shortSpectra.partitions <= kMaxShortPartitions);
+    DEBUG_ASSERT(m_longSpectra.partitions <= kMaxLongPartitions);
+}
+
+// static
+void PartitionedConvolutionKernel::computeSpectra(Spectra* pSpectra,
+        const CSAMPLE* pFrames,
+        SINT blockFrames,
+        SINT endFrame) {
+    pSpectra->partitions = math_max(SINT(0),
+            (endFrame + blockFrames - 1) / blockFrames - 1);
+    const SINT stride = spectrumStride(blockFrames);
+    const SINT size = kChannelCount * pSpectra->partitions * stride;
+    // The padding bins stay zero
+    pSpectra->real.assign(size, 0);
+    pSpectra->imag.assign(size, 0);
+
+    const SINT fftSize = 2 * blockFrames;
+    FFTReal fft(fftSize);
+    std::vector<double> time(fftSize);
+    std::vector<double> real(fftSize);
+    std::vector<double> imag(fftSize);
+    for (int channel = 0; channel < kChannelCount; ++channel) {
+        for (SINT partition = 0; partition < pSpectra->partitions; ++partition) {
+            const SINT firstFrame = (partition + 1) * blockFrames;
+            std::fill(time.begin(), time.end(), 0.0);
+            for (SINT i = 0; i < math_min(blockFrames, endFrame - firstFrame); ++i) {
+                time[i] = pFrames[kChannelCount * (firstFrame + i) + channel];
+            }
+            fft.forward(time.data(), real.data(), imag.data());
+            const SINT offset = (channel * pSpectra->partitions + partition) * stride;
+            for (SINT bin = 0; bin <= blockFrames; ++bin) {
+                pSpectra->real[offset + bin] = static_cast<float>(real[bin]);
+                pSpectra->imag[offset + bin] = static_cast<float>(imag[bin]);
+            }
+        }
+    }
+}
+
+PartitionedConvolver::Partitions::Partitions(
+        SINT blockFrames, SINT maxPartitions)
+        : blockFrames(blockFrames),
+          stride(PartitionedConvolutionKernel::spectrumStride(blockFrames)),
+          maxPartitions(maxPartitions),
+          delayLineReal(kChannelCount * maxPartitions * stride),
+          delayLineImag(kChannelCount * maxPartitions * stride),
+          newestPartition(0) {
+    for (int channel = 0; channel < kChannelCount; ++channel) {
+        input[channel].resize(2 * blockFrames);
+        output[0][channel].resize(blockFrames);
+        output[1][channel].resize(blockFrames);
+    }
+}
+
+PartitionedConvolver::PartitionedConvolver()
+        : m_fading(false),
+          m_shortFrame(0),
+          m_longFrame(0),
+          m_short(kDirectFrames, PartitionedConvolutionKernel::kMaxShortPartitions),
+          m_long(kLongBlockFrames, PartitionedConvolutionKernel::kMaxLongPartitions),
+          m_pShortFft(std::make_unique<FFTReal>(2 * kDirectFrames)),
+          m_pLongFft(std::make_unique<FFTReal>(2 * kLongBlockFrames)),
+          m_fftTime(2 * kLongBlockFrames),
+          m_fftReal(2 * kLongBlockFrames),
+          m_fftImag(2 * kLongBlockFrames),
+          m_sumReal(m_long.stride),
+          m_sumImag(m_long.stride) {
+}
+
+PartitionedConvolver::~PartitionedConvolver() {
+}
+
+void PartitionedConvolver::setKernel(const PartitionedConvolutionKernel* pKernel) {
+    m_pendingKernel = KernelSlot();
+    if (pKernel) {
+        m_pendingKernel.pKernel = pKernel;
+        m_pendingKernel.serial = pKernel->serial();
+    }
+}
+
+void PartitionedConvolver::retainKernels(
+        const PartitionedConvolutionKernel* pKernel1,
+        const PartitionedConvolutionKernel* pKernel2) {
+    // The serials are compared because a deleted kernel might have been
+    // replaced by another one at the same address
+    auto retain = [pKernel1, pKernel2](KernelSlot* pSlot) {
+        if (!pSlot->pKernel) {
+            return;
+        }
+        if ((pSlot->pKernel == pKernel1 && pSlot->serial == pKernel1->serial()) ||
+                (pSlot->pKernel == pKernel2 && pSlot->serial == pKernel2->serial())) {
+            return;
+        }
+        *pSlot = KernelSlot();
+    };
+    retain(&m_currentKernel);
+    retain(&m_fadingKernel);
+    retain(&m_pendingKernel);
+}
+
+void PartitionedConvolver::clear() {
+    for (Partitions* pPartitions : {&m_short, &m_long}) {
+        for (int channel = 0; channel < kChannelCount; ++channel) {
+            std::fill(pPartitions->input[channel].begin(),
+                    pPartitions->input[channel].end(), 0.0f);
+            std::fill(pPartitions->output[0][channel].begin(),
+                    pPartitions->output[0][channel].end(), 0.0f);
+            std::fill(pPartitions->output[1][channel].begin(),
+                    pPartitions->output[1][channel].end(), 0.0f);
+        }
+        std::fill(pPartitions->delayLineReal.begin(),
+                pPartitions->delayLineReal.end(), 0.0f);
+        std::fill(pPartitions->delayLineImag.begin(),
+                pPartitions->delayLineImag.end(), 0.0f);
+        pPartitions->newestPartition = 0;
+    }
+    m_shortFrame = 0;
+    m_longFrame = 0;
+    m_currentKernel = m_pendingKernel;
+    m_fadingKernel = KernelSlot();
+    m_fading = false;
+}
+
+void PartitionedConvolver::process(
+        const CSAMPLE* pInput, CSAMPLE* pOutput, SINT frames) {
+    SINT processedFrames = 0;
+    while (processedFrames < frames) {
+        // A short block never spans the boundary of a long block
+        const SINT blockFrames = math_min(
+                frames - processedFrames, kDirectFrames - m_shortFrame);
+        processBlock(pInput + kChannelCount * processedFrames,
+                pOutput + kChannelCount * processedFrames,
+                blockFrames);
+        processedFrames += blockFrames;
+    }
+}
+
+void PartitionedConvolver::processBlock(
+        const CSAMPLE* pInput, CSAMPLE* pOutput, SINT frames) {
+    for (int channel = 0; channel < kChannelCount; ++channel) {
+        float* pShortInput = &m_short.input[channel][kDirectFrames + m_shortFrame];
+        float* pLongInput = &m_long.input[channel][kLongBlockFrames + m_longFrame];
+        for (SINT i = 0; i < frames; ++i) {
+            pShortInput[i] = pInput[kChannelCount * i + channel];
+            pLongInput[i] = pInput[kChannelCount * i + channel];
+        }
+    }
+
+    for (int channel = 0; channel < kChannelCount; ++channel) {
+        const float* pShortOutput = &m_short.output[0][channel][m_shortFrame];
+        const float* pLongOutput = &m_long.output[0][channel][m_longFrame];
+        if (m_currentKernel.pKernel) {
+            for (SINT i = 0; i < frames; ++i) {
+                pOutput[kChannelCount * i + channel] =
+                        convolveDirect(m_currentKernel, channel, m_shortFrame + i) +
+                        pShortOutput[i] + pLongOutput[i];
+            }
+        } else {
+            for (SINT i = 0; i < frames; ++i) {
+                pOutput[kChannelCount * i + channel] = 0;
+            }
+        }
+        if (!m_fading) {
+            continue;
+        }
+        const float* pFadingShortOutput = &m_short.output[1][channel][m_shortFrame];
+        const float* pFadingLongOutput = &m_long.output[1][channel][m_longFrame];
+        for (SINT i = 0; i < frames; ++i) {
+            CSAMPLE fadingSample = 0;
+            if (m_fadingKernel.pKernel) {
+                fadingSample =
+                        convolveDirect(m_fadingKernel, channel, m_shortFrame + i) +
+                        pFadingShortOutput[i] + pFadingLongOutput[i];
+            }
+            const CSAMPLE_GAIN gain =
+                    static_cast<CSAMPLE_GAIN>(m_longFrame + i) / kLongBlockFrames;
+            CSAMPLE* pSample = &pOutput[kChannelCount * i + channel];
+            *pSample = fadingSample + (*pSample - fadingSample) * gain;
+        }
+    }
+
+    m_shortFrame += frames;
+    m_longFrame += frames;
+    if (m_longFrame == kLongBlockFrames) {
+        switchKernels();
+    }
+    if (m_shortFrame == kDirectFrames) {
+        finishBlock(&m_short, m_pShortFft.get(),
+                &PartitionedConvolutionKernel::m_shortSpectra);
+        m_shortFrame = 0;
+    }
+    if (m_longFrame == kLongBlockFrames) {
+        finishBlock(&m_long, m_pLongFft.get(),
+                &PartitionedConvolutionKernel::m_longSpectra);
+        m_longFrame = 0;
+    }
+}
+
+CSAMPLE PartitionedConvolver::convolveDirect(
+        const KernelSlot& slot, int channel, SINT frame) const {
+    // The reversed taps are aligned with the kDirectFrames input samples
+    // that end at the current one
+    return dotProduct(slot.pKernel->m_directTaps[channel].data(),
+            &m_short.input[channel][frame + 1],
+            kDirectFrames);
+}
+
+void PartitionedConvolver::finishBlock(Partitions* pPartitions,
+        FFTReal* pFft,
+        PartitionedConvolutionKernel::Spectra
+                PartitionedConvolutionKernel::*spectra) {
+    const SINT blockFrames = pPartitions->blockFrames;
+    const SINT stride = pPartitions->stride;
+    pPartitions->newestPartition =
+            (pPartitions->newestPartition + 1) % pPartitions->maxPartitions;
+
+    for (int channel = 0; channel < kChannelCount; ++channel) {
+        // Overlap-save: the spectrum of the previous and the current block
+        std::vector<float>& input = pPartitions->input[channel];
+        std::copy(input.begin(), input.end(), m_fftTime.begin());
+        pFft->forward(m_fftTime.data(), m_fftReal.data(), m_fftImag.data());
+        const SINT offset = (channel * pPartitions->maxPartitions +
+                                    pPartitions->newestPartition) *
+                stride;
+        for (SINT bin = 0; bin <= blockFrames; ++bin) {
+            pPartitions->delayLineReal[offset + bin] = static_cast<float>(m_fftReal[bin]);
+            pPartitions->delayLineImag[offset + bin] = static_cast<float>(m_fftImag[bin]);
+        }
+        std::copy(input.begin() + blockFrames, input.end(), input.begin());
+
+        const KernelSlot* slots[] = {&m_currentKernel, &m_fadingKernel};
+        for (int slot = 0; slot < (m_fading ? 2 : 1); ++slot) {
+            float* pOutput = pPartitions->output[slot][channel].data();
+            const PartitionedConvolutionKernel* pKernel = slots[slot]->pKernel;
+            if (pKernel) {
+                convolvePartitions(*pPartitions,
+                        pKernel->*spectra,
+                        pFft,
+                        channel,
+                        pOutput);
+            } else {
+                std::fill(pOutput, pOutput + blockFrames, 0.0f);
+            }
+        }
+    }
+}
+
+void PartitionedConvolver::convolvePartitions(const Partitions& partitions,
+        const PartitionedConvolutionKernel::Spectra& spectra,
+        FFTReal* pFft,
+        int channel,
+        float* pOutput) {
+    const SINT blockFrames = partitions.blockFrames;
+    const SINT stride = partitions.stride;
+    if (spectra.partitions == 0) {
+        std::fill(pOutput, pOutput + blockFrames, 0.0f);
+        return;
+    }
+
+    // The output block after the newest input block gets the first
+    // partition of the kernel applied to the newest input block, the
+    // second one to the input block before and so on.
+    std::fill(m_sumReal.begin(), m_sumReal.begin() + stride, 0.0f);
+    std::fill(m_sumImag.begin(), m_sumImag.begin() + stride, 0.0f);
+    for (SINT partition = 0; partition < spectra.partitions; ++partition) {
+        const SINT delayed = (partitions.newestPartition - partition +
+                                     partitions.maxPartitions) %
+                partitions.maxPartitions;
+        const SINT inputOffset =
+                (channel * partitions.maxPartitions + delayed) * stride;
+        const SINT kernelOffset = (channel * spectra.partitions + partition) * stride;
+        complexMultiplyAccumulate(m_sumReal.data(), m_sumImag.data(),
+                &partitions.delayLineReal[inputOffset],
+                &partitions.delayLineImag[inputOffset],
+                &spectra.real[kernelOffset],
+                &spectra.imag[kernelOffset],
+                stride);
+    }
+
+    for (SINT bin = 0; bin <= blockFrames; ++bin) {
+        m_fftReal[bin] = m_sumReal[bin];
+        m_fftImag[bin] = m_sumImag[bin];
+    }
+    pFft->inverse(m_fftReal.data(), m_fftImag.data(), m_fftTime.data());
+    // The first half is aliased by the circular convolution
+    for (SINT i = 0; i < blockFrames; ++i) {
+        pOutput[i] = static_cast<float>(m_fftTime[blockFrames + i]);
+    }
+}
+
+void PartitionedConvolver::switchKernels() {
+    m_fadingKernel = KernelSlot();
+    m_fading = false;
+    if (m_pendingKernel != m_currentKernel) {
+        m_fadingKernel = m_currentKernel;
+        m_currentKernel = m_pendingKernel;
+        m_fading = true;
+    }
+}
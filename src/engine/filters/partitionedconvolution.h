@@ -0,0 +1,193 @@
+#pragma once
+
+#include <QtGlobal>
+
+#include <memory>
+#include <vector>
+
+#include "util/class.h"
+#include "util/types.h"
+
+class FFTReal;
+
+// A stereo impulse response that is prepared for PartitionedConvolver.
+//
+// The response is split into three parts. The first kDirectFrames taps are
+// convolved directly in the time domain, so there is no latency. The taps
+// up to kLongBlockFrames are convolved in uniform partitions of
+// kDirectFrames, and the remaining taps in uniform partitions of
+// kLongBlockFrames. Each partition is stored as the spectrum of a zero
+// padded FFT of twice its size.
+//
+// A kernel is immutable after construction, which allocates and must not
+// be done in the engine thread.
+class PartitionedConvolutionKernel {
+  public:
+    static constexpr int kChannelCount = 2;
+    static constexpr SINT kDirectFrames = 128;
+    static constexpr SINT kLongBlockFrames = 1024;
+    static constexpr SINT kMaxShortPartitions =
+            kLongBlockFrames / kDirectFrames - 1;
+    static constexpr SINT kMaxLongPartitions = 95;
+    // Longer responses are truncated
+    static constexpr SINT kMaxFrames =
+            (kMaxLongPartitions + 1) * kLongBlockFrames;
+
+    // The frames are interleaved stereo
+    PartitionedConvolutionKernel(const CSAMPLE* pFrames,
+            SINT frames,
+            SINT sampleRate);
+
+    SINT frames() const {
+        return m_frames;
+    }
+    SINT sampleRate() const {
+        return m_sampleRate;
+    }
+    // Unique for each kernel, unlike the address
+    quint64 serial() const {
+        return m_serial;
+    }
+
+  private:
+    friend class PartitionedConvolver;
+
+    // The spectra of the partitions of one block size. The bins of
+    // partition p of channel c start at (c * partitions + p) * stride in
+    // both arrays. The first partition holds the taps at
+    // [blockFrames, 2 * blockFrames), because the taps before are
+    // convolved by the smaller block size.
+    struct Spectra {
+        SINT partitions;
+        std::vector<float> real;
+        std::vector<float> imag;
+    };
+
+    // The bins of a spectrum are padded for SIMD
+    static SINT spectrumStride(SINT blockFrames) {
+        return blockFrames + 4;
+    }
+
+    // Computes the partitions for the taps before endFrame
+    static void computeSpectra(Spectra* pSpectra,
+            const CSAMPLE* pFrames,
+            SINT blockFrames,
+            SINT endFrame);
+
+    const SINT m_frames;
+    const SINT m_sampleRate;
+    const quint64 m_serial;
+
+    // The direct taps of each channel in reverse order
+    std::vector<float> m_directTaps[kChannelCount];
+    Spectra m_shortSpectra;
+    Spectra m_longSpectra;
+
+    DISALLOW_COPY_AND_ASSIGN(PartitionedConvolutionKernel);
+};
+
+// Convolves interleaved stereo samples with a PartitionedConvolutionKernel
+// without latency. The frequency domain delay lines only hold the spectra
+// of the input, so the kernel can be switched at any time. The switch
+// happens at the next boundary of a long block with a crossfade that lasts
+// one long block.
+//
+// Only construction allocates. The convolver never owns a kernel.
+class PartitionedConvolver {
+  public:
+    PartitionedConvolver();
+    ~PartitionedConvolver();
+
+    // The kernel is faded in at the next long block boundary. It must
+    // stay alive until the convolver has been told otherwise with
+    // retainKernels().
+    void setKernel(const PartitionedConvolutionKernel* pKernel);
+
+    // Immediately stops using all kernels except the given ones, because
+    // they are about to be deleted. Both may be null.
+    void retainKernels(const PartitionedConvolutionKernel* pKernel1,
+            const PartitionedConvolutionKernel* pKernel2);
+
+    // Forgets all input and switches to the latest kernel without a
+    // crossfade
+    void clear();
+
+    // The output only contains the convolved signal. pInput and pOutput
+    // may be the same buffer.
+    void process(const CSAMPLE* pInput, CSAMPLE* pOutput, SINT frames);
+
+  private:
+    static constexpr int kChannelCount =
+            PartitionedConvolutionKernel::kChannelCount;
+    static constexpr SINT kDirectFrames =
+            PartitionedConvolutionKernel::kDirectFrames;
+    static constexpr SINT kLongBlockFrames =
+            PartitionedConvolutionKernel::kLongBlockFrames;
+
+    struct KernelSlot {
+        bool operator==(const KernelSlot& other) const {
+            return pKernel == other.pKernel && serial == other.serial;
+        }
+        bool operator!=(const KernelSlot& other) const {
+            return !(*this == other);
+        }
+        const PartitionedConvolutionKernel* pKernel = nullptr;
+        quint64 serial = 0;
+    };
+
+    // The input of one block size with its frequency domain delay line
+    struct Partitions {
+        Partitions(SINT blockFrames, SINT maxPartitions);
+
+        const SINT blockFrames;
+        const SINT stride;
+        const SINT maxPartitions;
+        // The previous and the current block of each channel
+        std::vector<float> input[kChannelCount];
+        // The spectra of the last maxPartitions blocks of each channel,
+        // laid out like PartitionedConvolutionKernel::Spectra
+        std::vector<float> delayLineReal;
+        std::vector<float> delayLineImag;
+        SINT newestPartition;
+        // The output of the convolution with the current and the fading
+        // kernel for the current block of each channel
+        std::vector<float> output[2][kChannelCount];
+    };
+
+    void processBlock(const CSAMPLE* pInput, CSAMPLE* pOutput, SINT frames);
+    CSAMPLE convolveDirect(const KernelSlot& slot, int channel, SINT frame) const;
+    // Transforms the completed input block and convolves the next
+    // output block with the current and the fading kernel
+    void finishBlock(Partitions* pPartitions,
+            FFTReal* pFft,
+            PartitionedConvolutionKernel::Spectra
+                    PartitionedConvolutionKernel::*spectra);
+    void convolvePartitions(const Partitions& partitions,
+            const PartitionedConvolutionKernel::Spectra& spectra,
+            FFTReal* pFft,
+            int channel,
+            float* pOutput);
+    void switchKernels();
+
+    KernelSlot m_currentKernel;
+    // Faded out during the current long block if m_fading is set
+    KernelSlot m_fadingKernel;
+    bool m_fading;
+    KernelSlot m_pendingKernel;
+
+    // The position in the current block of each size
+    SINT m_shortFrame;
+    SINT m_longFrame;
+
+    Partitions m_short;
+    Partitions m_long;
+    std::unique_ptr<FFTReal> m_pShortFft;
+    std::unique_ptr<FFTReal> m_pLongFft;
+    std::vector<double> m_fftTime;
+    std::vector<double> m_fftReal;
+    std::vector<double> m_fftImag;
+    std::vector<float> m_sumReal;
+    std::vector<float> m_sumImag;
+
+    DISALLOW_COPY_AND_ASSIGN(PartitionedConvolver);
+};
@@ -176,6 +176,7 @@ void ReadAheadManager::notifySeek(double seekPosition) {
     m_currentPosition = seekPosition;
     m_cacheMissHappened = false;
     m_readAheadLog.clear();
+    m_pReader->notifySeek();
 
     // TODO(XXX) notifySeek on the engine controls. EngineBuffer currently does
     // a fine job of this so it isn't really necessary but eventually I think
@@ -0,0 +1,201 @@
+#include "engine/realtimeworkerpool.h"
+
+#include <QThread>
+#include <QtDebug>
+
+#ifdef __LINUX__
+#include <pthread.h>
+#include <sched.h>
+#endif
+#ifdef __WINDOWS__
+#include <windows.h>
+#endif
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+#include "util/assert.h"
+#include "util/denormalsarezero.h"
+#include "util/performancetimer.h"
+
+namespace {
+
+// How long an idle worker keeps spinning after it finished its last job.
+// This covers the time between two callbacks for small buffer sizes, so the
+// workers are ready to pick up the jobs of the next callback immediately.
+const mixxx::Duration kSpinDuration = mixxx::Duration::fromMillis(10);
+// How long an idle worker keeps yielding after spinning before it starts
+// to sleep, e.g. while the audio device is stopped.
+const mixxx::Duration kYieldDuration = mixxx::Duration::fromMillis(100);
+const unsigned long kIdleSleepMicros = 500;
+
+// The state packs the generation, the number of jobs and the index of the
+// next unclaimed job into 32, 16 and 16 bits
+const quint32 kMaxJobs = 0xFFFF;
+
+inline quint64 makeState(quint32 generation, quint32 numJobs, quint32 nextJob) {
+    return (static_cast<quint64>(generation) << 32) |
+            (static_cast<quint64>(numJobs) << 16) | nextJob;
+}
+
+inline quint32 generationOfState(quint64 state) {
+    return static_cast<quint32>(state >> 32);
+}
+
+inline quint32 numJobsOfState(quint64 state) {
+    return static_cast<quint32>(state >> 16) & kMaxJobs;
+}
+
+inline quint32 nextJobOfState(quint64 state) {
+    return static_cast<quint32>(state) & kMaxJobs;
+}
+
+inline void cpuRelax() {
+#ifdef __SSE__
+    _mm_pause();
+#endif
+}
+
+void pinCurrentThreadToCpu(int cpu) {
+#if defined(__LINUX__)
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    CPU_SET(cpu, &cpuSet);
+    int result = pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+    if (result != 0) {
+        qWarning() << "Failed to pin realtime worker thread to CPU" << cpu
+                   << "error" << result;
+    }
+#elif defined(__WINDOWS__)
+    if (!SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << cpu)) {
+        qWarning() << "Failed to pin realtime worker thread to CPU" << cpu
+                   << "error" << GetLastError();
+    }
+#else
+    // Thread affinities are not supported, e.g. on macOS
+    Q_UNUSED(cpu);
+#endif
+}
+
+} // anonymous namespace
+
+class RealtimeWorkerThread : public QThread {
+  public:
+    RealtimeWorkerThread(RealtimeWorkerPool* pPool, int workerIndex, int cpu)
+            : m_pPool(pPool),
+              m_workerIndex(workerIndex),
+              m_cpu(cpu) {
+    }
+
+  protected:
+    void run() override {
+        if (m_cpu >= 0) {
+            pinCurrentThreadToCpu(m_cpu);
+        }
+        // Jobs are processed with the same floating point settings as
+        // on the audio callback thread, see SoundDevicePortAudio.
+#ifdef __SSE__
+        _MM_SET_DENORMALS_ZERO_MODE(_MM_DENORMALS_ZERO_ON);
+        _MM_SET_FLUSH_ZERO_MODE(_MM_FLUSH_ZERO_ON);
+#endif
+        m_pPool->workerLoop(m_workerIndex);
+    }
+
+  private:
+    RealtimeWorkerPool* const m_pPool;
+    const int m_workerIndex;
+    const int m_cpu;
+};
+
+RealtimeWorkerPool::RealtimeWorkerPool(
+        const QString& name, int numWorkers, bool pinThreads)
+        : m_state(makeState(0, 0, 0)),
+          m_pJobs(nullptr),
+          m_pendingJobs(0),
+          m_quit(false) {
+    const int numCpus = QThread::idealThreadCount();
+    for (int i = 0; i < numWorkers; ++i) {
+        // Leave the first core for the audio callback thread
+        const int cpu = (pinThreads && numCpus > 1) ? (i + 1) % numCpus : -1;
+        auto pWorker = new RealtimeWorkerThread(this, i, cpu);
+        pWorker->setObjectName(QString("%1 %2").arg(name).arg(i + 1));
+        pWorker->start(QThread::TimeCriticalPriority);
+        m_workers.push_back(pWorker);
+    }
+    qDebug() << "Started" << numWorkers << "realtime workers for" << name
+             << (pinThreads ? "pinned to CPU cores" : "");
+}
+
+RealtimeWorkerPool::~RealtimeWorkerPool() {
+    m_quit.store(true);
+    for (RealtimeWorkerThread* pWorker : m_workers) {
+        pWorker->wait();
+        delete pWorker;
+    }
+}
+
+void RealtimeWorkerPool::runJobs(Jobs* pJobs, int numJobs) {
+    if (numJobs <= 0) {
+        return;
+    }
+    VERIFY_OR_DEBUG_ASSERT(static_cast<quint32>(numJobs) <= kMaxJobs) {
+        numJobs = kMaxJobs;
+    }
+    const quint32 generation =
+            generationOfState(m_state.load(std::memory_order_relaxed)) + 1;
+    m_pJobs.store(pJobs, std::memory_order_relaxed);
+    m_pendingJobs.store(numJobs, std::memory_order_relaxed);
+    // Publish the jobs to the workers
+    m_state.store(makeState(generation, numJobs, 0), std::memory_order_release);
+
+    runClaimedJobs(generation);
+
+    // Join: Wait for the workers that are still busy with the last jobs
+    while (m_pendingJobs.load(std::memory_order_acquire) > 0) {
+        cpuRelax();
+    }
+}
+
+void RealtimeWorkerPool::runClaimedJobs(quint32 generation) {
+    quint64 state = m_state.load(std::memory_order_acquire);
+    while (generationOfState(state) == generation &&
+            nextJobOfState(state) < numJobsOfState(state)) {
+        if (!m_state.compare_exchange_weak(state, state + 1,
+                    std::memory_order_acquire, std::memory_order_acquire)) {
+            continue;
+        }
+        // The claimed job keeps runJobs() from returning, so the jobs
+        // cannot be replaced by the next generation before it has run.
+        Jobs* pJobs = m_pJobs.load(std::memory_order_relaxed);
+        pJobs->run(static_cast<int>(nextJobOfState(state)));
+        // Make the results visible to the thread that joins
+        m_pendingJobs.fetch_sub(1, std::memory_order_release);
+        state = m_state.load(std::memory_order_acquire);
+    }
+}
+
+void RealtimeWorkerPool::workerLoop(int workerIndex) {
+    Q_UNUSED(workerIndex);
+    quint32 lastGeneration =
+            generationOfState(m_state.load(std::memory_order_acquire));
+    PerformanceTimer idleTimer;
+    idleTimer.start();
+    while (!m_quit.load(std::memory_order_relaxed)) {
+        const quint32 generation =
+                generationOfState(m_state.load(std::memory_order_acquire));
+        if (generation != lastGeneration) {
+            lastGeneration = generation;
+            runClaimedJobs(generation);
+            idleTimer.restart();
+            continue;
+        }
+        const mixxx::Duration idle = idleTimer.elapsed();
+        if (idle < kSpinDuration) {
+            cpuRelax();
+        } else if (idle < kSpinDuration + kYieldDuration) {
+            QThread::yieldCurrentThread();
+        } else {
+            QThread::usleep(kIdleSleepMicros);
+        }
+    }
+}
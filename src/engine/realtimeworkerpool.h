@@ -0,0 +1,69 @@
+#pragma once
+
+#include <QString>
+#include <atomic>
+#include <vector>
+
+#include "util/class.h"
+
+class RealtimeWorkerThread;
+
+// A pool of worker threads that lets the engine callback fan out independent
+// jobs within a single callback and join them before it continues.
+//
+// Dispatching and joining never blocks or calls into the operating system:
+// The jobs are published with a single atomic store and claimed by the
+// workers and the calling thread with a compare-and-swap loop. The calling
+// thread participates in processing the jobs and spin-waits for the workers
+// that are still busy with the last jobs. Idle workers spin for a short time
+// after each callback, yield for a while and finally fall back to sleeping
+// in short intervals when the engine is idle.
+//
+// The worker threads run with time critical priority, have denormals
+// disabled like the audio callback thread and are optionally pinned to
+// a CPU core each.
+class RealtimeWorkerPool {
+  public:
+    // A set of jobs that can be run concurrently. run() is called exactly
+    // once for each index and may be called from any thread of the pool.
+    class Jobs {
+      public:
+        virtual ~Jobs() = default;
+        virtual void run(int index) = 0;
+    };
+
+    RealtimeWorkerPool(const QString& name, int numWorkers, bool pinThreads);
+    ~RealtimeWorkerPool();
+
+    int numWorkers() const {
+        return static_cast<int>(m_workers.size());
+    }
+
+    // Runs pJobs->run(i) for all i in [0, numJobs) and returns after all of
+    // them have finished. Must only be called from one thread at a time.
+    // numJobs must not exceed 65535.
+    void runJobs(Jobs* pJobs, int numJobs);
+
+  private:
+    friend class RealtimeWorkerThread;
+
+    // Called by the worker threads.
+    void workerLoop(int workerIndex);
+
+    // Claims and runs jobs of the given generation until none are left.
+    void runClaimedJobs(quint32 generation);
+
+    // The upper 32 bits contain the generation that is incremented for each
+    // call of runJobs(), the next 16 bits the number of jobs and the lower
+    // 16 bits the index of the next job that has not been claimed yet.
+    // Combining them in a single atomic prevents that a worker that is late
+    // claims a job with the count of another generation.
+    std::atomic<quint64> m_state;
+    std::atomic<Jobs*> m_pJobs;
+    std::atomic<int> m_pendingJobs;
+    std::atomic<bool> m_quit;
+
+    std::vector<RealtimeWorkerThread*> m_workers;
+
+    DISALLOW_COPY_AND_ASSIGN(RealtimeWorkerPool);
+};
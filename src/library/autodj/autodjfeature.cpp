@@ -62,6 +62,14 @@ AutoDJFeature::AutoDJFeature(Library* pLibrary,
     qRegisterMetaType<AutoDJProcessor::AutoDJState>("AutoDJState");
     m_pAutoDJProcessor = new AutoDJProcessor(
             this, m_pConfig, pPlayerManager, pLibrary->trackCollections(), m_iAutoDJPlaylistId);
+    // Connected first, so that receivers know the origin of the following
+    // load request
+    connect(m_pAutoDJProcessor,
+            &AutoDJProcessor::loadTrackToPlayer,
+            this,
+            [this](TrackPointer pTrack, QString group, bool /*play*/) {
+                emit loadingTrackToPlayerByAutoDJ(pTrack, group);
+            });
     connect(m_pAutoDJProcessor,
             &AutoDJProcessor::loadTrackToPlayer,
             this,
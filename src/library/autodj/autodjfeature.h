@@ -60,6 +60,11 @@ class AutoDJFeature : public LibraryFeature {
     // Temporary, until WCrateTableView can be written.
     void onRightClickChild(const QPoint& globalPos, QModelIndex index) override;
 
+  signals:
+    // Emitted before loadTrackToPlayer() when AutoDJ itself loads the
+    // track, e.g. for analyzing it with the priority of AutoDJ tracks
+    void loadingTrackToPlayerByAutoDJ(TrackPointer pTrack, QString group);
+
   private:
     TrackCollection* const m_pTrackCollection;
 
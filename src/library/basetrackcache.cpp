@@ -3,8 +3,10 @@
 
 #include "library/basetrackcache.h"
 
+#include "library/dao/trackschema.h"
 #include "library/trackcollection.h"
 #include "library/searchqueryparser.h"
+#include "library/tracksearchindex.h"
 #include "library/queryutil.h"
 #include "track/keyutils.h"
 #include "track/globaltrackcache.h"
@@ -15,6 +17,28 @@ namespace {
 
 constexpr bool sDebug = false;
 
+// The columns that are searched with TextFilterNode
+QStringList searchIndexColumns(const ColumnCache& columnCache) {
+    const QStringList textColumns = {
+            LIBRARYTABLE_ARTIST,
+            LIBRARYTABLE_ALBUMARTIST,
+            LIBRARYTABLE_ALBUM,
+            LIBRARYTABLE_TITLE,
+            LIBRARYTABLE_GENRE,
+            LIBRARYTABLE_COMPOSER,
+            LIBRARYTABLE_GROUPING,
+            LIBRARYTABLE_COMMENT,
+            LIBRARYTABLE_LOCATION,
+    };
+    QStringList columns;
+    for (const auto& column : textColumns) {
+        if (columnCache.fieldIndex(column) >= 0) {
+            columns << column;
+        }
+    }
+    return columns;
+}
+
 }  // namespace
 
 BaseTrackCache::BaseTrackCache(TrackCollection* pTrackCollection,
@@ -28,6 +52,7 @@ BaseTrackCache::BaseTrackCache(TrackCollection* pTrackCollection,
           m_columnsJoined(columns.join(",")),
           m_columnCache(columns),
           m_pQueryParser(new SearchQueryParser(pTrackCollection)),
+          m_pSearchIndex(new TrackSearchIndex(searchIndexColumns(m_columnCache))),
           m_bIndexBuilt(false),
           m_bIsCaching(isCaching),
           m_database(pTrackCollection->database()) {
@@ -47,6 +72,10 @@ BaseTrackCache::BaseTrackCache(TrackCollection* pTrackCollection,
     for (int i = 0; i < m_searchColumns.size(); ++i) {
         m_searchColumnIndices[i] = m_columnCache.fieldIndex(m_searchColumns[i]);
     }
+
+    for (const auto& column : m_pSearchIndex->columns()) {
+        m_searchIndexFieldIndices.append(m_columnCache.fieldIndex(column));
+    }
 }
 
 BaseTrackCache::~BaseTrackCache() {
@@ -94,6 +123,7 @@ void BaseTrackCache::slotTracksRemoved(QSet<TrackId> trackIds) {
     }
     for (const auto& trackId : qAsConst(trackIds)) {
         m_trackInfo.remove(trackId);
+        m_pSearchIndex->removeTrack(trackId);
         m_dirtyTracks.remove(trackId);
     }
 }
@@ -228,6 +258,7 @@ bool BaseTrackCache::updateTrackInIndex(
         for (int i = 0; i < numColumns; ++i) {
             getTrackValueForColumn(pTrack, i, record[i]);
         }
+        updateTrackInSearchIndex(trackId, record);
         if (m_bIsCaching) {
             replaceRecentTrack(std::move(trackId), std::move(pTrack));
         }
@@ -284,12 +315,30 @@ bool BaseTrackCache::updateIndexWithQuery(const QString& queryString) {
                 record[i] = query.value(i);
             }
         }
+        updateTrackInSearchIndex(trackId, record);
     }
 
     qDebug() << this << "updateIndexWithQuery took" << timer.elapsed().debugMillisWithUnit();
     return true;
 }
 
+void BaseTrackCache::updateTrackInSearchIndex(
+        TrackId trackId, const QVector<QVariant>& record) {
+    const int locationIndex =
+            fieldIndex(ColumnCache::COLUMN_LIBRARYTABLE_NATIVELOCATION);
+    QStringList values;
+    values.reserve(m_searchIndexFieldIndices.size());
+    for (const int i : qAsConst(m_searchIndexFieldIndices)) {
+        if (i == locationIndex) {
+            // The database is searched for locations with Qt separators
+            values << QDir::fromNativeSeparators(record.value(i).toString());
+        } else {
+            values << record.value(i).toString();
+        }
+    }
+    m_pSearchIndex->updateTrack(trackId, values);
+}
+
 void BaseTrackCache::buildIndex() {
     if (sDebug) {
         qDebug() << this << "buildIndex()";
@@ -306,6 +355,7 @@ void BaseTrackCache::buildIndex() {
     // clear the table, and keep track of what IDs we see, then delete the ones
     // we don't see.
     m_trackInfo.clear();
+    m_pSearchIndex->clear();
 
     if (!updateIndexWithQuery(queryString)) {
         qDebug() << "buildIndex failed!";
@@ -472,12 +522,10 @@ void BaseTrackCache::filterAndSort(const QSet<TrackId>& trackIds,
         buildIndex();
     }
 
-    QStringList idStrings;
     // TODO(rryan) consider making this the data passed in and a separate
     // QVector for output
     QSet<TrackId> dirtyTracks;
     for (const auto& trackId: trackIds) {
-        idStrings << trackId.toString();
         if (m_dirtyTracks.contains(trackId)) {
             dirtyTracks.insert(trackId);
         }
@@ -487,18 +535,46 @@ void BaseTrackCache::filterAndSort(const QSet<TrackId>& trackIds,
     if (!extraFilter.isNull() && extraFilter != "") {
         queryFragments << QString("(%1)").arg(extraFilter);
     }
-    if (idStrings.size() > 0) {
-        queryFragments << QString("%1 in (%2)")
+
+    QStringList idStrings;
+    QString filter;
+    std::unique_ptr<QueryNode> pQuery;
+    QBitArray rows;
+    if (!searchQuery.isEmpty() && m_pSearchIndex->rowsOf(trackIds, &rows)) {
+        // Narrow down the tracks in memory and only leave the
+        // terms to the database that are not covered by the index
+        pQuery = m_pQueryParser->parseQuery(
+                searchQuery,
+                m_searchColumns,
+                queryFragments.join(" AND "));
+        filter = pQuery->toSqlFilteringRows(*m_pSearchIndex, &rows);
+        for (int row = 0; row < rows.size(); ++row) {
+            if (rows.testBit(row)) {
+                idStrings << m_pSearchIndex->trackId(row).toString();
+            }
+        }
+        // The database accepts an empty list that never matches
+        QStringList filterFragments;
+        if (!filter.isEmpty()) {
+            filterFragments << QString("(%1)").arg(filter);
+        }
+        filterFragments << QString("%1 in (%2)")
                 .arg(m_idColumn, idStrings.join(","));
+        filter = filterFragments.join(" AND ");
+    } else {
+        for (const auto& trackId: trackIds) {
+            idStrings << trackId.toString();
+        }
+        if (idStrings.size() > 0) {
+            queryFragments << QString("%1 in (%2)")
+                    .arg(m_idColumn, idStrings.join(","));
+        }
+        pQuery = m_pQueryParser->parseQuery(
+                searchQuery,
+                m_searchColumns,
+                queryFragments.join(" AND "));
+        filter = pQuery->toSql();
     }
-
-    const std::unique_ptr<QueryNode> pQuery =
-            m_pQueryParser->parseQuery(
-                    searchQuery,
-                    m_searchColumns,
-                    queryFragments.join(" AND "));
-
-    QString filter = pQuery->toSql();
     if (!filter.isEmpty()) {
         filter.prepend("WHERE ");
     }
@@ -18,6 +18,7 @@
 
 class SearchQueryParser;
 class TrackCollection;
+class TrackSearchIndex;
 
 class SortColumn {
   public:
@@ -35,6 +36,10 @@ class SortColumn {
 // waste of memory because all the table-models were caching the same data
 // (track properties). Furthermore, the base SQL tables of these table-models
 // involve complicated joins, which are very slow.
+//
+// The text columns are additionally kept in a TrackSearchIndex that
+// evaluates most search terms in memory. Only the remaining terms,
+// the extra filter and the sorting are left for the database.
 class BaseTrackCache : public QObject {
     Q_OBJECT
   public:
@@ -89,6 +94,7 @@ class BaseTrackCache : public QObject {
     void resetRecentTrack() const;
 
     bool updateIndexWithQuery(const QString& query);
+    void updateTrackInSearchIndex(TrackId trackId, const QVector<QVariant>& record);
     void updateTrackInIndex(TrackId trackId);
     bool updateTrackInIndex(const TrackPointer& pTrack);
     void updateTracksInIndex(const QSet<TrackId>& trackIds);
@@ -118,6 +124,10 @@ class BaseTrackCache : public QObject {
 
     const std::unique_ptr<SearchQueryParser> m_pQueryParser;
 
+    const std::unique_ptr<TrackSearchIndex> m_pSearchIndex;
+    // The field index for each column of the search index
+    QVector<int> m_searchIndexFieldIndices;
+
     const StringCollator m_collator;
 
     QStringList m_searchColumns;
@@ -84,15 +84,19 @@ QList<AnalysisDao::AnalysisInfo> AnalysisDao::loadAnalysesFromQuery(TrackId trac
         int checksum = query->value(dataChecksumColumn).toInt();
         QString dataPath = analysisPath.absoluteFilePath(
             QString::number(info.analysisId));
-        QByteArray compressedData = loadDataFromFile(dataPath);
-        int file_checksum = qChecksum(compressedData.constData(),
-                                      compressedData.length());
+        QByteArray fileData = loadDataFromFile(dataPath);
+        int file_checksum = qChecksum(fileData.constData(),
+                                      fileData.length());
         if (checksum != file_checksum) {
             qDebug() << "WARNING: Corrupt analysis loaded from" << dataPath
-                     << "length" << compressedData.length();
+                     << "length" << fileData.length();
             continue;
         }
-        info.data = qUncompress(compressedData);
+        if (Waveform::isBinaryFormat(fileData)) {
+            info.data = fileData;
+        } else {
+            info.data = qUncompress(fileData);
+        }
         bytes += info.data.length();
         analyses.append(info);
     }
@@ -114,9 +118,15 @@ bool AnalysisDao::saveAnalysis(AnalysisDao::AnalysisInfo* info) {
     PerformanceTimer time;
     time.start();
 
-    QByteArray compressedData = qCompress(info->data, kCompressionLevel);
-    int checksum = qChecksum(compressedData.constData(),
-                             compressedData.length());
+    // Waveforms in the binary format are stored uncompressed for loading
+    // them without decompressing. The qCompress()ed data of other analyses
+    // starts with the uncompressed size as a big endian number, which
+    // never matches the magic of the binary format.
+    QByteArray fileData = Waveform::isBinaryFormat(info->data)
+            ? info->data
+            : qCompress(info->data, kCompressionLevel);
+    int checksum = qChecksum(fileData.constData(),
+                             fileData.length());
 
     QSqlQuery query(m_db);
     if (info->analysisId == -1) {
@@ -161,14 +171,14 @@ bool AnalysisDao::saveAnalysis(AnalysisDao::AnalysisInfo* info) {
 
     QString dataPath = getAnalysisStoragePath().absoluteFilePath(
         QString::number(info->analysisId));
-    if (!saveDataToFile(dataPath, compressedData)) {
+    if (!saveDataToFile(dataPath, fileData)) {
         qDebug() << "WARNING: Couldn't save analysis data to file" << dataPath;
         return false;
     }
 
     qDebug() << "AnalysisDAO saved analysis" << info->analysisId
-             << QString("%1 (%2 compressed)").arg(QString::number(info->data.length()),
-                                                  QString::number(compressedData.length()))
+             << QString("%1 (%2 stored)").arg(QString::number(info->data.length()),
+                                              QString::number(fileData.length()))
              << "bytes for track"
              << info->trackId << "in" << time.elapsed().debugMillisWithUnit();
     return true;
@@ -315,8 +325,9 @@ void AnalysisDao::saveTrackAnalyses(
         return;
     }
 
-    // Don't try to save invalid or non-dirty waveforms.
+    // Don't try to save invalid, non-dirty or provisional waveforms.
     if (!pWaveform || pWaveform->saveState() != Waveform::SaveState::SavePending ||
+        pWaveform->isProvisional() ||
         !pWaveSummary || pWaveSummary->saveState() != Waveform::SaveState::SavePending) {
         return;
     }
@@ -341,6 +352,9 @@ void AnalysisDao::saveTrackAnalyses(
 
     // Clear analysisId since we are re-using the AnalysisInfo
     analysis.analysisId = -1;
+    if (pWaveSummary->getId() != -1) {
+        analysis.analysisId = pWaveSummary->getId();
+    }
     analysis.type = AnalysisDao::TYPE_WAVESUMMARY;
     analysis.description = pWaveSummary->getDescription();
     analysis.version = pWaveSummary->getVersion();
@@ -91,7 +91,12 @@ Library::Library(
             m_pConfig);
     addFeature(m_pMixxxLibraryFeature);
 
-    addFeature(new AutoDJFeature(this, m_pConfig, pPlayerManager));
+    AutoDJFeature* pAutoDJFeature = new AutoDJFeature(this, m_pConfig, pPlayerManager);
+    addFeature(pAutoDJFeature);
+    connect(pAutoDJFeature,
+            &AutoDJFeature::loadingTrackToPlayerByAutoDJ,
+            pPlayerManager,
+            &PlayerManager::slotLoadingTrackToPlayerByAutoDJ);
     m_pPlaylistFeature = new PlaylistFeature(this, UserSettingsPointer(m_pConfig));
     addFeature(m_pPlaylistFeature);
     m_pCrateFeature = new CrateFeature(this, m_pConfig);
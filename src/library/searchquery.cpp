@@ -4,6 +4,7 @@
 
 #include "library/dao/trackschema.h"
 #include "library/queryutil.h"
+#include "library/tracksearchindex.h"
 #include "library/trackset/crate/crateschema.h"
 #include "track/keyutils.h"
 #include "util/db/dbconnection.h"
@@ -86,6 +87,30 @@ bool AndNode::match(const TrackPointer& pTrack) const {
     return true;
 }
 
+bool AndNode::filterRows(const TrackSearchIndex& index, QBitArray* pRows) const {
+    // Don't modify the rows unless all nodes can be evaluated
+    QBitArray rows = *pRows;
+    for (const auto& pNode: m_nodes) {
+        if (!pNode->filterRows(index, &rows)) {
+            return false;
+        }
+    }
+    *pRows = rows;
+    return true;
+}
+
+QString AndNode::toSqlFilteringRows(const TrackSearchIndex& index, QBitArray* pRows) const {
+    QStringList queryFragments;
+    queryFragments.reserve(static_cast<int>(m_nodes.size()));
+    for (const auto& pNode: m_nodes) {
+        QString sql = pNode->toSqlFilteringRows(index, pRows);
+        if (!sql.isEmpty()) {
+            queryFragments << sql;
+        }
+    }
+    return concatSqlClauses(queryFragments, "AND");
+}
+
 QString AndNode::toSql() const {
     QStringList queryFragments;
     queryFragments.reserve(static_cast<int>(m_nodes.size()));
@@ -115,6 +140,23 @@ bool OrNode::match(const TrackPointer& pTrack) const {
     return false;
 }
 
+bool OrNode::filterRows(const TrackSearchIndex& index, QBitArray* pRows) const {
+    VERIFY_OR_DEBUG_ASSERT(!m_nodes.empty()) {
+        // Consistent with match()
+        return true;
+    }
+    QBitArray matchingRows(pRows->size());
+    for (const auto& pNode: m_nodes) {
+        QBitArray rows = *pRows;
+        if (!pNode->filterRows(index, &rows)) {
+            return false;
+        }
+        matchingRows |= rows;
+    }
+    *pRows = matchingRows;
+    return true;
+}
+
 QString OrNode::toSql() const {
     QStringList queryFragments;
     queryFragments.reserve(static_cast<int>(m_nodes.size()));
@@ -131,6 +173,15 @@ bool NotNode::match(const TrackPointer& pTrack) const {
     return !m_pNode->match(pTrack);
 }
 
+bool NotNode::filterRows(const TrackSearchIndex& index, QBitArray* pRows) const {
+    QBitArray matchingRows = *pRows;
+    if (!m_pNode->filterRows(index, &matchingRows)) {
+        return false;
+    }
+    *pRows &= ~matchingRows;
+    return true;
+}
+
 QString NotNode::toSql() const {
     QString sql(m_pNode->toSql());
     if (sql.isEmpty()) {
@@ -168,6 +219,28 @@ bool TextFilterNode::match(const TrackPointer& pTrack) const {
     return false;
 }
 
+bool TextFilterNode::filterRows(const TrackSearchIndex& index, QBitArray* pRows) const {
+    // The argument is used as a LIKE pattern, see toSql(). Leave
+    // wildcards and a trailing space to the database.
+    if (m_argument.isEmpty() ||
+            m_argument[m_argument.size() - 1].isSpace() ||
+            m_argument.contains(kSqlLikeMatchAll) ||
+            m_argument.contains(kSqlLikeMatchOne)) {
+        return false;
+    }
+    QVector<int> columns;
+    columns.reserve(m_sqlColumns.size());
+    for (const auto& sqlColumn: m_sqlColumns) {
+        const int column = index.columnIndex(sqlColumn);
+        if (column < 0) {
+            return false;
+        }
+        columns.append(column);
+    }
+    index.filterRows(columns, m_argument, pRows);
+    return true;
+}
+
 QString TextFilterNode::toSql() const {
     FieldEscaper escaper(m_database);
     QString argument = m_argument;
@@ -214,7 +287,7 @@ CrateFilterNode::CrateFilterNode(const CrateStorage* pCrateStorage,
       m_matchInitialized(false) {
 }
 
-bool CrateFilterNode::match(const TrackPointer& pTrack) const {
+void CrateFilterNode::initMatchingTrackIds() const {
     if (!m_matchInitialized) {
         CrateTrackSelectResult crateTracks(
              m_pCrateStorage->selectTracksSortedByCrateNameLike(m_crateNameLike));
@@ -225,10 +298,26 @@ bool CrateFilterNode::match(const TrackPointer& pTrack) const {
 
         m_matchInitialized = true;
     }
+}
 
+bool CrateFilterNode::match(const TrackPointer& pTrack) const {
+    initMatchingTrackIds();
     return std::binary_search(m_matchingTrackIds.begin(), m_matchingTrackIds.end(), pTrack->getId());
 }
 
+bool CrateFilterNode::filterRows(const TrackSearchIndex& index, QBitArray* pRows) const {
+    initMatchingTrackIds();
+    QBitArray matchingRows(pRows->size());
+    for (const auto& trackId: m_matchingTrackIds) {
+        const int row = index.row(trackId);
+        if (row >= 0) {
+            matchingRows.setBit(row);
+        }
+    }
+    *pRows &= matchingRows;
+    return true;
+}
+
 QString CrateFilterNode::toSql() const {
     return QString("id IN (%1)").arg(
             m_pCrateStorage->formatQueryForTrackIdsByCrateNameLike(m_crateNameLike));
@@ -240,7 +329,7 @@ NoCrateFilterNode::NoCrateFilterNode(const CrateStorage* pCrateStorage)
       m_matchInitialized(false) {
 }
 
-bool NoCrateFilterNode::match(const TrackPointer& pTrack) const {
+void NoCrateFilterNode::initMatchingTrackIds() const {
     if (!m_matchInitialized) {
         TrackSelectResult tracks(
                 m_pCrateStorage->selectAllTracksSorted());
@@ -251,10 +340,25 @@ bool NoCrateFilterNode::match(const TrackPointer& pTrack) const {
 
         m_matchInitialized = true;
     }
+}
 
+bool NoCrateFilterNode::match(const TrackPointer& pTrack) const {
+    initMatchingTrackIds();
     return !std::binary_search(m_matchingTrackIds.begin(), m_matchingTrackIds.end(), pTrack->getId());
 }
 
+bool NoCrateFilterNode::filterRows(const TrackSearchIndex& index, QBitArray* pRows) const {
+    initMatchingTrackIds();
+    // The matching tracks are those without a crate
+    for (const auto& trackId: m_matchingTrackIds) {
+        const int row = index.row(trackId);
+        if (row >= 0) {
+            pRows->clearBit(row);
+        }
+    }
+    return true;
+}
+
 QString NoCrateFilterNode::toSql() const {
     return QString("%1 NOT IN (%2)").arg(
             CRATETABLE_ID,
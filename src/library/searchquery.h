@@ -1,6 +1,7 @@
 #ifndef SEARCHQUERY_H
 #define SEARCHQUERY_H
 
+#include <QBitArray>
 #include <QList>
 #include <QRegExp>
 #include <QSqlDatabase>
@@ -15,6 +16,8 @@
 #include "util/assert.h"
 #include "util/memory.h"
 
+class TrackSearchIndex;
+
 const QString kMissingFieldSearchTerm = "\"\""; // "" searches for an empty string
 
 QVariant getTrackValueForColumn(const TrackPointer& pTrack, const QString& column);
@@ -27,6 +30,24 @@ class QueryNode {
     virtual bool match(const TrackPointer& pTrack) const = 0;
     virtual QString toSql() const = 0;
 
+    // Clears all rows of the in-memory index that don't match. Returns
+    // false without modifying the rows if the node can only be evaluated
+    // by the database.
+    virtual bool filterRows(const TrackSearchIndex& index, QBitArray* pRows) const {
+        Q_UNUSED(index);
+        Q_UNUSED(pRows);
+        return false;
+    }
+
+    // Evaluates the node in memory if possible and otherwise returns
+    // the SQL for the database.
+    virtual QString toSqlFilteringRows(const TrackSearchIndex& index, QBitArray* pRows) const {
+        if (filterRows(index, pRows)) {
+            return QString();
+        }
+        return toSql();
+    }
+
   protected:
     QueryNode() {}
 
@@ -51,12 +72,17 @@ class OrNode : public GroupNode {
   public:
     bool match(const TrackPointer& pTrack) const override;
     QString toSql() const override;
+    bool filterRows(const TrackSearchIndex& index, QBitArray* pRows) const override;
 };
 
 class AndNode : public GroupNode {
   public:
     bool match(const TrackPointer& pTrack) const override;
     QString toSql() const override;
+    bool filterRows(const TrackSearchIndex& index, QBitArray* pRows) const override;
+    // Evaluates each node separately, i.e. only the nodes that cannot
+    // be evaluated in memory are left for the database.
+    QString toSqlFilteringRows(const TrackSearchIndex& index, QBitArray* pRows) const override;
 };
 
 class NotNode : public QueryNode {
@@ -68,6 +94,7 @@ class NotNode : public QueryNode {
 
     bool match(const TrackPointer& pTrack) const override;
     QString toSql() const override;
+    bool filterRows(const TrackSearchIndex& index, QBitArray* pRows) const override;
 
   private:
     std::unique_ptr<QueryNode> m_pNode;
@@ -81,6 +108,7 @@ class TextFilterNode : public QueryNode {
 
     bool match(const TrackPointer& pTrack) const override;
     QString toSql() const override;
+    bool filterRows(const TrackSearchIndex& index, QBitArray* pRows) const override;
 
   private:
     QSqlDatabase m_database;
@@ -112,8 +140,11 @@ class CrateFilterNode : public QueryNode {
 
     bool match(const TrackPointer& pTrack) const override;
     QString toSql() const override;
+    bool filterRows(const TrackSearchIndex& index, QBitArray* pRows) const override;
 
   private:
+    void initMatchingTrackIds() const;
+
     const CrateStorage* m_pCrateStorage;
     QString m_crateNameLike;
     mutable bool m_matchInitialized;
@@ -126,8 +157,11 @@ class NoCrateFilterNode : public QueryNode {
 
     bool match(const TrackPointer& pTrack) const override;
     QString toSql() const override;
+    bool filterRows(const TrackSearchIndex& index, QBitArray* pRows) const override;
 
   private:
+    void initMatchingTrackIds() const;
+
     const CrateStorage* m_pCrateStorage;
     QString m_crateNameLike;
     mutable bool m_matchInitialized;
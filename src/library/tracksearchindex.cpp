@@ -0,0 +1,190 @@
+#include "library/tracksearchindex.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include "util/assert.h"
+#include "util/db/dbconnection.h"
+
+namespace {
+
+constexpr int kTrigramLength = 3;
+
+inline quint64 trigramAt(const QString& value, int pos) {
+    DEBUG_ASSERT(pos + kTrigramLength <= value.size());
+    return (static_cast<quint64>(value.at(pos).unicode()) << 32) |
+            (static_cast<quint64>(value.at(pos + 1).unicode()) << 16) |
+            static_cast<quint64>(value.at(pos + 2).unicode());
+}
+
+} // anonymous namespace
+
+TrackSearchIndex::TrackSearchIndex(const QStringList& columns)
+        : m_columns(columns),
+          m_valueIndices(columns.size()) {
+    clear();
+}
+
+void TrackSearchIndex::clear() {
+    m_trackIds.clear();
+    m_rowByTrackId.clear();
+    m_freeRows.clear();
+    for (auto& valueIndices : m_valueIndices) {
+        valueIndices.clear();
+    }
+    m_values.clear();
+    m_valueIndexByValue.clear();
+    m_valueIndicesByTrigram.clear();
+    // Missing values are stored as the empty string
+    internValue(QString());
+}
+
+quint32 TrackSearchIndex::internValue(const QString& value) {
+    const auto i = m_valueIndexByValue.constFind(value);
+    if (i != m_valueIndexByValue.constEnd()) {
+        return i.value();
+    }
+    const auto valueIndex = static_cast<quint32>(m_values.size());
+    m_values.append(value);
+    m_valueIndexByValue.insert(value, valueIndex);
+    // The new index is greater than all indices in the lists
+    // and appending it keeps them sorted
+    for (int pos = 0; pos + kTrigramLength <= value.size(); ++pos) {
+        auto& valueIndices = m_valueIndicesByTrigram[trigramAt(value, pos)];
+        if (valueIndices.empty() || valueIndices.back() != valueIndex) {
+            valueIndices.push_back(valueIndex);
+        }
+    }
+    return valueIndex;
+}
+
+void TrackSearchIndex::updateTrack(TrackId trackId, const QStringList& values) {
+    VERIFY_OR_DEBUG_ASSERT(values.size() == m_columns.size()) {
+        return;
+    }
+    int row = m_rowByTrackId.value(trackId, -1);
+    if (row < 0) {
+        if (m_freeRows.isEmpty()) {
+            row = m_trackIds.size();
+            m_trackIds.append(trackId);
+            for (auto& valueIndices : m_valueIndices) {
+                valueIndices.push_back(0);
+            }
+        } else {
+            row = m_freeRows.takeLast();
+            m_trackIds[row] = trackId;
+        }
+        m_rowByTrackId.insert(trackId, row);
+    }
+    for (int column = 0; column < values.size(); ++column) {
+        QString value = values.at(column);
+        mixxx::DbConnection::makeStringLatinLow(&value);
+        m_valueIndices[column][row] = internValue(value);
+    }
+}
+
+void TrackSearchIndex::removeTrack(TrackId trackId) {
+    const int row = m_rowByTrackId.value(trackId, -1);
+    if (row < 0) {
+        return;
+    }
+    m_rowByTrackId.remove(trackId);
+    m_trackIds[row] = TrackId();
+    for (auto& valueIndices : m_valueIndices) {
+        valueIndices[row] = 0;
+    }
+    m_freeRows.append(row);
+}
+
+bool TrackSearchIndex::rowsOf(
+        const QSet<TrackId>& trackIds,
+        QBitArray* pRows) const {
+    DEBUG_ASSERT(pRows);
+    pRows->fill(false, rowCount());
+    for (const auto& trackId : trackIds) {
+        const int row = m_rowByTrackId.value(trackId, -1);
+        if (row < 0) {
+            return false;
+        }
+        pRows->setBit(row);
+    }
+    return true;
+}
+
+QBitArray TrackSearchIndex::matchValues(const QString& argument) const {
+    QBitArray matchingValues(m_values.size());
+    if (argument.size() < kTrigramLength) {
+        // Scanning all distinct values is still much cheaper
+        // than scanning all columns of all rows
+        for (int valueIndex = 0; valueIndex < m_values.size(); ++valueIndex) {
+            if (m_values.at(valueIndex).contains(argument)) {
+                matchingValues.setBit(valueIndex);
+            }
+        }
+        return matchingValues;
+    }
+
+    // Start with the shortest list of candidates
+    std::vector<const std::vector<quint32>*> candidateLists;
+    for (int pos = 0; pos + kTrigramLength <= argument.size(); ++pos) {
+        const auto i = m_valueIndicesByTrigram.constFind(trigramAt(argument, pos));
+        if (i == m_valueIndicesByTrigram.constEnd()) {
+            return matchingValues;
+        }
+        candidateLists.push_back(&i.value());
+    }
+    std::sort(candidateLists.begin(),
+            candidateLists.end(),
+            [](const std::vector<quint32>* lhs, const std::vector<quint32>* rhs) {
+                return lhs->size() < rhs->size();
+            });
+    std::vector<quint32> candidates = *candidateLists.front();
+    std::vector<quint32> intersection;
+    for (size_t i = 1; i < candidateLists.size() && !candidates.empty(); ++i) {
+        intersection.clear();
+        std::set_intersection(
+                candidates.begin(),
+                candidates.end(),
+                candidateLists[i]->begin(),
+                candidateLists[i]->end(),
+                std::back_inserter(intersection));
+        candidates.swap(intersection);
+    }
+
+    // All trigrams might occur in a value without
+    // the argument occurring as a whole
+    for (const auto valueIndex : candidates) {
+        if (m_values.at(valueIndex).contains(argument)) {
+            matchingValues.setBit(valueIndex);
+        }
+    }
+    return matchingValues;
+}
+
+void TrackSearchIndex::filterRows(
+        const QVector<int>& columns,
+        const QString& argument,
+        QBitArray* pRows) const {
+    DEBUG_ASSERT(pRows);
+    DEBUG_ASSERT(pRows->size() == rowCount());
+    const QBitArray matchingValues = matchValues(argument);
+    if (matchingValues.count(true) == 0) {
+        pRows->fill(false);
+        return;
+    }
+    for (int row = 0; row < rowCount(); ++row) {
+        if (!pRows->testBit(row)) {
+            continue;
+        }
+        bool matches = false;
+        for (const int column : columns) {
+            if (matchingValues.testBit(m_valueIndices[column][row])) {
+                matches = true;
+                break;
+            }
+        }
+        if (!matches) {
+            pRows->clearBit(row);
+        }
+    }
+}
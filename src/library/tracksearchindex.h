@@ -0,0 +1,96 @@
+#pragma once
+
+#include <QBitArray>
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include <vector>
+
+#include "track/trackid.h"
+#include "util/class.h"
+
+// Columnar in-memory index of the text columns of a BaseTrackCache for
+// evaluating search terms without asking the database.
+//
+// Values are normalized like for the LIKE operator of the database (see
+// DbConnection::makeStringLatinLow()) and interned, i.e. each distinct
+// value is stored only once and each column is a plain array that refers
+// to the values by their index. A trigram index maps each sequence of 3
+// characters onto all values that contain it. Searching for a term first
+// selects the matching values and then scans the columns once.
+//
+// Values are not removed until the index is cleared, they are shared by
+// many rows and the index is rebuilt regularly.
+class TrackSearchIndex {
+  public:
+    explicit TrackSearchIndex(const QStringList& columns);
+
+    const QStringList& columns() const {
+        return m_columns;
+    }
+    // Returns -1 if the column is not indexed
+    int columnIndex(const QString& column) const {
+        return m_columns.indexOf(column);
+    }
+
+    void clear();
+
+    // The values must be ordered like columns()
+    void updateTrack(TrackId trackId, const QStringList& values);
+    void removeTrack(TrackId trackId);
+
+    int trackCount() const {
+        return m_rowByTrackId.size();
+    }
+    // The number of distinct values of all columns
+    int valueCount() const {
+        return m_values.size();
+    }
+
+    // Rows of removed tracks are reused. The row count
+    // is the size of all row sets.
+    int rowCount() const {
+        return m_trackIds.size();
+    }
+    // Returns -1 if the track is not indexed
+    int row(TrackId trackId) const {
+        return m_rowByTrackId.value(trackId, -1);
+    }
+    TrackId trackId(int row) const {
+        return m_trackIds.at(row);
+    }
+
+    // Returns false if at least one of the tracks is not indexed
+    bool rowsOf(const QSet<TrackId>& trackIds, QBitArray* pRows) const;
+
+    // Clears all rows in which none of the columns contains the already
+    // normalized argument
+    void filterRows(
+            const QVector<int>& columns,
+            const QString& argument,
+            QBitArray* pRows) const;
+
+  private:
+    quint32 internValue(const QString& value);
+    QBitArray matchValues(const QString& argument) const;
+
+    const QStringList m_columns;
+
+    QVector<TrackId> m_trackIds;
+    QHash<TrackId, int> m_rowByTrackId;
+    QVector<int> m_freeRows;
+
+    // One array of value indices per column
+    std::vector<std::vector<quint32>> m_valueIndices;
+
+    QVector<QString> m_values;
+    QHash<QString, quint32> m_valueIndexByValue;
+
+    // The indices of the values are sorted in ascending order
+    QHash<quint64, std::vector<quint32>> m_valueIndicesByTrigram;
+
+    DISALLOW_COPY_AND_ASSIGN(TrackSearchIndex);
+};
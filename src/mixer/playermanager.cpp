@@ -673,12 +673,31 @@ void PlayerManager::slotLoadTrackIntoNextAvailableSampler(TrackPointer pTrack) {
     }
 }
 
+void PlayerManager::slotLoadingTrackToPlayerByAutoDJ(TrackPointer pTrack, QString group) {
+    if (pTrack) {
+        m_autoDjLoadingTrackIds.insert(group, pTrack->getId());
+    } else {
+        m_autoDjLoadingTrackIds.remove(group);
+    }
+}
+
 void PlayerManager::slotAnalyzeTrack(TrackPointer track) {
     VERIFY_OR_DEBUG_ASSERT(track) {
         return;
     }
     if (m_pTrackAnalysisScheduler) {
-        if (m_pTrackAnalysisScheduler->scheduleTrackById(track->getId())) {
+        // Tracks that will be played soon are analyzed first
+        auto priority = TrackAnalysisScheduler::Priority::DeckLoaded;
+        if (qobject_cast<Sampler*>(sender())) {
+            priority = TrackAnalysisScheduler::Priority::Background;
+        } else if (Deck* pDeck = qobject_cast<Deck*>(sender())) {
+            // Tracks loaded by the user keep the priority of deck loads
+            // while AutoDJ is enabled
+            if (m_autoDjLoadingTrackIds.take(pDeck->getGroup()) == track->getId()) {
+                priority = TrackAnalysisScheduler::Priority::AutoDjUpcoming;
+            }
+        }
+        if (m_pTrackAnalysisScheduler->scheduleTrackById(track->getId(), priority)) {
             m_pTrackAnalysisScheduler->resume();
         }
         // The first progress signal will suspend a running batch analysis
@@ -6,6 +6,7 @@
 
 #include <QObject>
 #include <QList>
+#include <QHash>
 #include <QMap>
 #include <QMutex>
 
@@ -204,6 +205,9 @@ class PlayerManager : public QObject, public PlayerManagerInterface {
     void slotChangeNumMicrophones(double v);
     void slotChangeNumAuxiliaries(double v);
 
+    // AutoDJ is about to load the track into the deck
+    void slotLoadingTrackToPlayerByAutoDJ(TrackPointer pTrack, QString group);
+
   private slots:
     void slotAnalyzeTrack(TrackPointer track);
 
@@ -271,6 +275,8 @@ class PlayerManager : public QObject, public PlayerManagerInterface {
     ControlObject* m_pCONumMicrophones;
     ControlObject* m_pCONumAuxiliaries;
     parented_ptr<ControlProxy> m_pAutoDjEnabled;
+    // The tracks that AutoDJ is loading, by the group of the deck
+    QHash<QString, TrackId> m_autoDjLoadingTrackIds;
 
     TrackAnalysisScheduler::Pointer m_pTrackAnalysisScheduler;
 
@@ -54,6 +54,7 @@ DlgPrefLV2::DlgPrefLV2(QWidget* pParent, LV2Backend* lv2Backend,
             button->setDisabled(true);
         } else {
             button->setDisabled(false);
+            m_instantiableButtons.append(button);
         }
 
         lv2_vertical_layout_left->addWidget(button);
@@ -112,8 +113,21 @@ void DlgPrefLV2::slotDisplayParameters() {
 }
 
 void DlgPrefLV2::slotUpdate() {
-    // This preferences page will be removed in PR #2618 anyway, so we'll just
-    // leave this empty for now.
+    // The plugins have only been measured after they processed audio
+    updateCpuMeterToolTips();
+}
+
+void DlgPrefLV2::updateCpuMeterToolTips() {
+    for (QPushButton* button : qAsConst(m_instantiableButtons)) {
+        const LV2CpuMeter* pCpuMeter = m_pLV2Backend->getCpuMeter(
+                button->property("id").toString());
+        if (pCpuMeter && pCpuMeter->hasLoad()) {
+            button->setToolTip(QObject::tr("Uses %1% of the real time "
+                                           "on average and %2% at peak")
+                                       .arg(pCpuMeter->averageLoad() * 100, 0, 'f', 1)
+                                       .arg(pCpuMeter->peakLoad() * 100, 0, 'f', 1));
+        }
+    }
 }
 
 void DlgPrefLV2::slotResetToDefaults() {
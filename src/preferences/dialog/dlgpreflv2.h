@@ -3,6 +3,7 @@
 
 #include <QWidget>
 #include <QCheckBox>
+#include <QPushButton>
 
 #include "preferences/dialog/ui_dlgpreflv2dlg.h"
 #include "preferences/usersettings.h"
@@ -31,9 +32,12 @@ class DlgPrefLV2 : public DlgPreferencePage, public Ui::DlgPrefLV2Dlg  {
     void slotUpdateOnParameterCheck(int state);
 
   private:
+    void updateCpuMeterToolTips();
+
     LV2Backend* m_pLV2Backend;
     QString m_currentEffectId;
     QList<QCheckBox*> m_pluginParameters;
+    QList<QPushButton*> m_instantiableButtons;
     int m_iCheckedParameters;
     EffectsManager* m_pEffectsManager;
 };
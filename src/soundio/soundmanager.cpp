@@ -25,6 +25,7 @@
 #include "control/controlobject.h"
 #include "control/controlproxy.h"
 #include "engine/enginebuffer.h"
+#include "engine/enginecallbacktelemetry.h"
 #include "engine/enginemaster.h"
 #include "engine/sidechain/enginenetworkstream.h"
 #include "engine/sidechain/enginesidechain.h"
@@ -695,6 +696,17 @@ int SoundManager::getConfiguredDeckCount() const {
     return m_config.getDeckCount();
 }
 
+void SoundManager::underflowHappened(int code) {
+    m_underflowHappened = 1;
+    // Attributed to the callbacks around it in the telemetry
+    m_pMaster->getCallbackTelemetry()->xrunHappened();
+    // Disable the engine warnings by default, because printing a warning is a
+    // locking function that will make the problem worse
+    if (CmdlineArgs::Instance().getDeveloper()) {
+        qWarning() << "underflowHappened code:" << code;
+    }
+}
+
 void SoundManager::processUnderflowHappened() {
     if (m_underflowUpdateCount == 0) {
         if (atomicLoadRelaxed(m_underflowHappened)) {
@@ -116,14 +116,7 @@ class SoundManager : public QObject {
         return m_pNetworkStream;
     }
 
-    void underflowHappened(int code) {
-        m_underflowHappened = 1;
-        // Disable the engine warnings by default, because printing a warning is a
-        // locking function that will make the problem worse
-        if (CmdlineArgs::Instance().getDeveloper()) {
-            qWarning() << "underflowHappened code:" << code;
-        }
-    }
+    void underflowHappened(int code);
 
     void processUnderflowHappened();
 
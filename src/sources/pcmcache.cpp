@@ -0,0 +1,456 @@
+#include "sources/pcmcache.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QMutexLocker>
+#include <QSaveFile>
+
+#include <cstring>
+
+#include "sources/audiosourcestereoproxy.h"
+#include "sources/audiosourcetrackproxy.h"
+#include "sources/soundsourceproxy.h"
+#include "util/logger.h"
+#include "util/math.h"
+#include "util/sample.h"
+
+namespace mixxx {
+
+namespace {
+
+const Logger kLogger("PcmCache");
+
+const QString kEntryFileSuffix = QStringLiteral(".pcm");
+
+// Only the beginning of a track file is hashed for identifying it,
+// because reading the whole file would take much longer than decoding
+// it from the cache.
+constexpr qint64 kHashedFileBytes = 64 * 1024;
+
+// The number of frames that are decoded and written at once
+constexpr SINT kWriterFrameCount = 8192;
+
+constexpr SINT kChannelCount = 2;
+
+constexpr char kMagic[8] = {'M', 'I', 'X', 'X', 'X', 'P', 'C', 'M'};
+constexpr quint32 kVersion = 1;
+
+// Samples are stored in native byte order, because the cache
+// is never shared between different machines.
+struct EntryHeader {
+    char magic[8];
+    quint32 version;
+    quint32 channelCount;
+    quint32 sampleRate;
+    quint32 bitrate;
+    qint64 frameIndexStart;
+    qint64 frameCount;
+};
+
+// The samples start at an aligned offset after the header
+constexpr qint64 kSampleDataOffset = 64;
+static_assert(sizeof(EntryHeader) <= kSampleDataOffset,
+        "The header must fit in front of the sample data");
+
+qint64 entryBytesForFrames(qint64 frameCount) {
+    return kSampleDataOffset + frameCount * kChannelCount * sizeof(CSAMPLE);
+}
+
+// Reads the samples of an entry directly from the memory mapped file
+class AudioSourcePcmCacheEntry final : public AudioSource {
+  public:
+    explicit AudioSourcePcmCacheEntry(const QString& filePath)
+            : AudioSource(QUrl::fromLocalFile(filePath)),
+              m_file(filePath),
+              m_pMappedData(nullptr),
+              m_pSamples(nullptr) {
+    }
+    ~AudioSourcePcmCacheEntry() override {
+        close();
+    }
+
+    void close() override {
+        if (m_pMappedData) {
+            m_file.unmap(m_pMappedData);
+            m_pMappedData = nullptr;
+            m_pSamples = nullptr;
+        }
+        m_file.close();
+    }
+
+  protected:
+    ReadableSampleFrames readSampleFramesClamped(
+            WritableSampleFrames writableSampleFrames) override {
+        const auto frameIndexRange = writableSampleFrames.frameIndexRange();
+        const SINT sampleCount =
+                getSignalInfo().frames2samples(frameIndexRange.length());
+        if (!writableSampleFrames.writableData()) {
+            // Skipping frames is free
+            return ReadableSampleFrames(frameIndexRange);
+        }
+        SampleUtil::copy(
+                writableSampleFrames.writableData(),
+                m_pSamples +
+                        getSignalInfo().frames2samples(
+                                frameIndexRange.start() - frameIndexMin()),
+                sampleCount);
+        return ReadableSampleFrames(
+                frameIndexRange,
+                SampleBuffer::ReadableSlice(
+                        writableSampleFrames.writableData(),
+                        sampleCount));
+    }
+
+  private:
+    OpenResult tryOpen(
+            OpenMode /*mode*/,
+            const OpenParams& /*params*/) override {
+        DEBUG_ASSERT(!m_pMappedData);
+        if (!m_file.open(QIODevice::ReadOnly)) {
+            return OpenResult::Failed;
+        }
+        const qint64 fileSize = m_file.size();
+        if (fileSize < kSampleDataOffset) {
+            kLogger.warning()
+                    << "Truncated entry"
+                    << m_file.fileName();
+            return OpenResult::Failed;
+        }
+        EntryHeader header;
+        if (m_file.read(reinterpret_cast<char*>(&header), sizeof(header)) !=
+                        sizeof(header) ||
+                std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+                header.version != kVersion ||
+                header.channelCount != kChannelCount ||
+                header.frameCount <= 0 ||
+                entryBytesForFrames(header.frameCount) != fileSize) {
+            kLogger.warning()
+                    << "Invalid entry"
+                    << m_file.fileName();
+            return OpenResult::Failed;
+        }
+        m_pMappedData = m_file.map(0, fileSize);
+        if (!m_pMappedData) {
+            kLogger.warning()
+                    << "Failed to map entry"
+                    << m_file.fileName()
+                    << m_file.errorString();
+            return OpenResult::Failed;
+        }
+        m_pSamples = reinterpret_cast<const CSAMPLE*>(
+                m_pMappedData + kSampleDataOffset);
+
+        initChannelCountOnce(static_cast<SINT>(header.channelCount));
+        initSampleRateOnce(static_cast<SINT>(header.sampleRate));
+        if (header.bitrate > 0) {
+            initBitrateOnce(static_cast<SINT>(header.bitrate));
+        }
+        initFrameIndexRangeOnce(IndexRange::forward(
+                static_cast<SINT>(header.frameIndexStart),
+                static_cast<SINT>(header.frameCount)));
+        return OpenResult::Succeeded;
+    }
+
+    QFile m_file;
+    uchar* m_pMappedData;
+    const CSAMPLE* m_pSamples;
+};
+
+} // anonymous namespace
+
+PcmCache::PcmCache(const QString& directoryPath, qint64 limitBytes)
+        : m_directoryPath(directoryPath),
+          m_limitBytes(limitBytes) {
+    QDir dir(m_directoryPath);
+    if (!dir.mkpath(".")) {
+        kLogger.warning()
+                << "Failed to create directory"
+                << m_directoryPath;
+        return;
+    }
+    // Temporary files of entries that have not been committed
+    // before a crash
+    const auto staleFileInfos = dir.entryInfoList(
+            QStringList{QStringLiteral("*") + kEntryFileSuffix + QStringLiteral(".*")},
+            QDir::Files);
+    for (const auto& fileInfo : staleFileInfos) {
+        kLogger.info()
+                << "Deleting stale temporary file"
+                << fileInfo.fileName();
+        QFile::remove(fileInfo.absoluteFilePath());
+    }
+    evictEntries();
+}
+
+PcmCache::~PcmCache() {
+    DEBUG_ASSERT(m_writingKeys.isEmpty());
+}
+
+// static
+QString PcmCache::keyForTrackFile(const TrackFile& trackFile) {
+    QFile file(trackFile.location());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QString();
+    }
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(file.read(kHashedFileBytes));
+    hash.addData(QByteArray::number(trackFile.fileSize()));
+    hash.addData(QByteArray::number(
+            trackFile.fileLastModified().toMSecsSinceEpoch()));
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+QString PcmCache::entryFilePath(const QString& key) const {
+    return QDir(m_directoryPath).filePath(key + kEntryFileSuffix);
+}
+
+AudioSourcePointer PcmCache::openAudioSource(const TrackPointer& pTrack) {
+    DEBUG_ASSERT(pTrack);
+    const QString key = keyForTrackFile(pTrack->getFileInfo());
+    if (key.isEmpty()) {
+        return nullptr;
+    }
+    auto pAudioSource = openEntry(key);
+    if (!pAudioSource) {
+        return nullptr;
+    }
+    kLogger.info()
+            << "Reading decoded samples of"
+            << pTrack->getLocation()
+            << "from"
+            << pAudioSource->getUrlString();
+    // The track metadata is not updated, because the entry always
+    // contains a stereo signal independent of the original file
+    return AudioSourceTrackProxy::create(pTrack, std::move(pAudioSource));
+}
+
+AudioSourcePointer PcmCache::openEntry(const QString& key) {
+    const QString filePath = entryFilePath(key);
+    {
+        QFile file(filePath);
+        if (!file.exists()) {
+            return nullptr;
+        }
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+        // The modification time of an entry is its last use
+        if (file.open(QIODevice::ReadWrite)) {
+            file.setFileTime(
+                    QDateTime::currentDateTimeUtc(),
+                    QFileDevice::FileModificationTime);
+        }
+#endif
+    }
+    auto pAudioSource = std::make_shared<AudioSourcePcmCacheEntry>(filePath);
+    if (pAudioSource->open(AudioSource::OpenMode::Strict) !=
+            AudioSource::OpenResult::Succeeded) {
+        pAudioSource.reset();
+        QFile::remove(filePath);
+        return nullptr;
+    }
+    return pAudioSource;
+}
+
+std::unique_ptr<PcmCache::Writer> PcmCache::newWriter(
+        const TrackPointer& pTrack) {
+    DEBUG_ASSERT(pTrack);
+    const QString key = keyForTrackFile(pTrack->getFileInfo());
+    if (key.isEmpty()) {
+        return nullptr;
+    }
+    if (QFile::exists(entryFilePath(key))) {
+        // Don't open another decoder unnecessarily
+        return nullptr;
+    }
+    mixxx::AudioSource::OpenParams params;
+    params.setChannelCount(kChannelCount);
+    auto pAudioSource = SoundSourceProxy(pTrack).openAudioSource(params);
+    if (!pAudioSource) {
+        return nullptr;
+    }
+    return newWriter(key, std::move(pAudioSource));
+}
+
+std::unique_ptr<PcmCache::Writer> PcmCache::newWriter(
+        const QString& key,
+        AudioSourcePointer pAudioSource) {
+    DEBUG_ASSERT(!key.isEmpty());
+    DEBUG_ASSERT(pAudioSource);
+    if (pAudioSource->frameIndexRange().empty() ||
+            entryBytesForFrames(pAudioSource->frameLength()) > m_limitBytes) {
+        return nullptr;
+    }
+    const QString filePath = entryFilePath(key);
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_writingKeys.contains(key) || QFile::exists(filePath)) {
+            return nullptr;
+        }
+        m_writingKeys.insert(key);
+    }
+
+    auto pFile = std::make_unique<QSaveFile>(filePath);
+    EntryHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.channelCount = kChannelCount;
+    header.sampleRate = static_cast<quint32>(
+            pAudioSource->getSignalInfo().getSampleRate());
+    header.bitrate = pAudioSource->getBitrate().isValid()
+            ? static_cast<quint32>(pAudioSource->getBitrate())
+            : 0;
+    header.frameIndexStart = pAudioSource->frameIndexMin();
+    header.frameCount = pAudioSource->frameLength();
+    QByteArray headerBytes(kSampleDataOffset, '\0');
+    std::memcpy(headerBytes.data(), &header, sizeof(header));
+    if (!pFile->open(QIODevice::WriteOnly) ||
+            pFile->write(headerBytes) != headerBytes.size()) {
+        kLogger.warning()
+                << "Failed to create entry"
+                << filePath
+                << pFile->errorString();
+        pFile.reset();
+        finishWriting(key, false);
+        return nullptr;
+    }
+    return std::unique_ptr<Writer>(new Writer(
+            this,
+            key,
+            std::move(pAudioSource),
+            std::move(pFile)));
+}
+
+void PcmCache::finishWriting(const QString& key, bool committed) {
+    {
+        QMutexLocker locker(&m_mutex);
+        DEBUG_ASSERT(m_writingKeys.contains(key));
+        m_writingKeys.remove(key);
+    }
+    if (committed) {
+        evictEntries();
+    }
+}
+
+qint64 PcmCache::totalBytes() const {
+    const auto fileInfos = QDir(m_directoryPath).entryInfoList(
+            QStringList{QStringLiteral("*") + kEntryFileSuffix},
+            QDir::Files);
+    qint64 bytes = 0;
+    for (const auto& fileInfo : fileInfos) {
+        bytes += fileInfo.size();
+    }
+    return bytes;
+}
+
+void PcmCache::evictEntries() {
+    QMutexLocker locker(&m_mutex);
+    // Sorted by modification time, most recently used first
+    const auto fileInfos = QDir(m_directoryPath).entryInfoList(
+            QStringList{QStringLiteral("*") + kEntryFileSuffix},
+            QDir::Files,
+            QDir::Time);
+    qint64 bytes = 0;
+    for (const auto& fileInfo : fileInfos) {
+        bytes += fileInfo.size();
+    }
+    for (auto i = fileInfos.crbegin(); i != fileInfos.crend(); ++i) {
+        if (bytes <= m_limitBytes) {
+            break;
+        }
+        // Fails for entries that are currently mapped on Windows
+        if (QFile::remove(i->absoluteFilePath())) {
+            kLogger.info()
+                    << "Evicted entry"
+                    << i->fileName();
+            bytes -= i->size();
+        }
+    }
+}
+
+PcmCache::Writer::Writer(
+        PcmCache* pCache,
+        QString key,
+        AudioSourcePointer pAudioSource,
+        std::unique_ptr<QSaveFile> pFile)
+        : m_pCache(pCache),
+          m_key(std::move(key)),
+          m_pAudioSource(AudioSourceStereoProxy::create(
+                  std::move(pAudioSource), kWriterFrameCount)),
+          m_pFile(std::move(pFile)),
+          m_writtenFrameIndexRange(IndexRange::forward(
+                  m_pAudioSource->frameIndexMin(), 0)),
+          m_sampleBuffer(kChannelCount * kWriterFrameCount),
+          m_finished(false) {
+}
+
+PcmCache::Writer::~Writer() {
+    if (!m_finished) {
+        // Deletes the temporary file
+        m_pFile->cancelWriting();
+    }
+    m_pCache->finishWriting(m_key, m_finished);
+}
+
+bool PcmCache::Writer::writeNextFrames() {
+    VERIFY_OR_DEBUG_ASSERT(!m_finished) {
+        return true;
+    }
+    const auto frameIndexRange = IndexRange::forward(
+            m_writtenFrameIndexRange.end(),
+            math_min(kWriterFrameCount,
+                    m_pAudioSource->frameIndexMax() -
+                            m_writtenFrameIndexRange.end()));
+    if (!frameIndexRange.empty()) {
+        const auto readableSampleFrames =
+                m_pAudioSource->readSampleFrames(
+                        WritableSampleFrames(
+                                frameIndexRange,
+                                SampleBuffer::WritableSlice(
+                                        m_sampleBuffer,
+                                        0,
+                                        kChannelCount * frameIndexRange.length())));
+        // The entry must contain all frames
+        if (readableSampleFrames.frameIndexRange() != frameIndexRange) {
+            kLogger.warning()
+                    << "Discarding entry after failing to decode"
+                    << frameIndexRange
+                    << "of"
+                    << m_pAudioSource->getUrlString();
+            return false;
+        }
+        const qint64 bytes =
+                readableSampleFrames.readableLength() * sizeof(CSAMPLE);
+        if (m_pFile->write(
+                    reinterpret_cast<const char*>(
+                            readableSampleFrames.readableData()),
+                    bytes) != bytes) {
+            kLogger.warning()
+                    << "Failed to write entry"
+                    << m_pFile->fileName()
+                    << m_pFile->errorString();
+            return false;
+        }
+        m_writtenFrameIndexRange.growBack(frameIndexRange.length());
+    }
+    if (m_writtenFrameIndexRange.end() < m_pAudioSource->frameIndexMax()) {
+        return true;
+    }
+    if (!m_pFile->commit()) {
+        kLogger.warning()
+                << "Failed to commit entry"
+                << m_pFile->fileName()
+                << m_pFile->errorString();
+        return false;
+    }
+    kLogger.info()
+            << "Cached decoded samples of"
+            << m_pAudioSource->getUrlString()
+            << "in"
+            << m_pFile->fileName();
+    m_finished = true;
+    return true;
+}
+
+} // namespace mixxx
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <QMutex>
+#include <QSet>
+#include <QString>
+
+#include <memory>
+
+#include "sources/audiosource.h"
+#include "track/track.h"
+#include "util/class.h"
+#include "util/samplebuffer.h"
+
+class QSaveFile;
+
+namespace mixxx {
+
+// Stores the decoded stereo samples of tracks in files. When the same track
+// is loaded again, either into another deck or in a later session, the file
+// is mapped into memory and no decoding is needed at all.
+//
+// Entries are identified by a hash of the beginning of the track file
+// together with its size and modification time. Moving or renaming a file
+// keeps the entry valid while modifying the file invalidates it. When the
+// total size of all entries exceeds the limit the entries that have not been
+// used for the longest time are deleted.
+//
+// New entries are written into a temporary file that is only renamed after
+// all samples have been written. A crash never leaves a partially written
+// entry behind and stale temporary files are deleted on startup.
+//
+// All functions are thread-safe.
+class PcmCache {
+  public:
+    // Decodes the samples of a track and writes them into a new entry
+    // incrementally. The entry is discarded if the writer is deleted
+    // before it has finished.
+    class Writer {
+      public:
+        ~Writer();
+
+        // Decodes and writes the next frames. The entry is committed after
+        // the last frames have been written. Returns false on failure.
+        bool writeNextFrames();
+
+        bool isFinished() const {
+            return m_finished;
+        }
+
+      private:
+        friend class PcmCache;
+        Writer(PcmCache* pCache,
+                QString key,
+                AudioSourcePointer pAudioSource,
+                std::unique_ptr<QSaveFile> pFile);
+
+        PcmCache* const m_pCache;
+        const QString m_key;
+        const AudioSourcePointer m_pAudioSource;
+        const std::unique_ptr<QSaveFile> m_pFile;
+        IndexRange m_writtenFrameIndexRange;
+        SampleBuffer m_sampleBuffer;
+        bool m_finished;
+
+        DISALLOW_COPY_AND_ASSIGN(Writer);
+    };
+
+    PcmCache(const QString& directoryPath, qint64 limitBytes);
+    ~PcmCache();
+
+    qint64 limitBytes() const {
+        return m_limitBytes;
+    }
+
+    // Returns an empty key if the file could not be read
+    static QString keyForTrackFile(const TrackFile& trackFile);
+
+    // Opens the cached samples of the track. Returns nullptr if the
+    // track is not cached.
+    AudioSourcePointer openAudioSource(const TrackPointer& pTrack);
+    AudioSourcePointer openEntry(const QString& key);
+
+    // Opens another decoder for the track and returns a writer for a new
+    // entry. Returns nullptr if the entry exists already, is currently
+    // written by another writer or would not fit into the cache.
+    std::unique_ptr<Writer> newWriter(const TrackPointer& pTrack);
+    std::unique_ptr<Writer> newWriter(
+            const QString& key,
+            AudioSourcePointer pAudioSource);
+
+    // The total size of all entries in bytes
+    qint64 totalBytes() const;
+
+  private:
+    QString entryFilePath(const QString& key) const;
+
+    void finishWriting(const QString& key, bool committed);
+    void evictEntries();
+
+    const QString m_directoryPath;
+    const qint64 m_limitBytes;
+
+    mutable QMutex m_mutex;
+    QSet<QString> m_writingKeys;
+
+    DISALLOW_COPY_AND_ASSIGN(PcmCache);
+};
+
+} // namespace mixxx
@@ -1,11 +1,17 @@
+#include <benchmark/benchmark.h>
 #include <gtest/gtest.h>
 #include <QDir>
 #include <QtDebug>
 
+#include <vector>
+
 #include "test/mixxxtest.h"
 
 #include "analyzer/analyzerwaveform.h"
+#include "analyzer/waveformfilterbank.h"
+#include "engine/filters/enginefilterbessel4.h"
 #include "library/dao/analysisdao.h"
+#include "test/noise.h"
 #include "track/track.h"
 
 #define BIGBUF_SIZE (1024 * 1024) //Megabyte
@@ -109,4 +115,83 @@ TEST_F(AnalyzerWaveformTest, wrongTotalSamples) {
         EXPECT_FLOAT_EQ(canaryBigBuf[i], CANARY_FLOAT);
     }
 }
+
+// The vectorized filter bank must match the engine filters that the
+// waveform has been analyzed with so far
+TEST(WaveformFilterBankTest, matchesEngineFilters) {
+    const int sampleRate = 44100;
+    const int bufferSize = 1024;
+    const std::vector<CSAMPLE> input = noise(8 * bufferSize);
+
+    EngineFilterBessel4Low low(sampleRate, 600);
+    EngineFilterBessel4Band mid(sampleRate, 600, 4000);
+    EngineFilterBessel4High high(sampleRate, 4000);
+    low.assumeSettled();
+    mid.assumeSettled();
+    high.assumeSettled();
+    WaveformFilterBank filterBank(sampleRate, 600, 4000);
+
+    std::vector<CSAMPLE> expected[FilterCount];
+    std::vector<CSAMPLE> actual[FilterCount];
+    for (int f = 0; f < FilterCount; ++f) {
+        expected[f].resize(bufferSize);
+        actual[f].resize(bufferSize);
+    }
+    for (int offset = 0; offset < static_cast<int>(input.size()); offset += bufferSize) {
+        low.process(&input[offset], expected[Low].data(), bufferSize);
+        mid.process(&input[offset], expected[Mid].data(), bufferSize);
+        high.process(&input[offset], expected[High].data(), bufferSize);
+        filterBank.process(&input[offset],
+                actual[Low].data(),
+                actual[Mid].data(),
+                actual[High].data(),
+                bufferSize);
+        for (int f = 0; f < FilterCount; ++f) {
+            for (int i = 0; i < bufferSize; ++i) {
+                // Allow for rounding differences with -ffast-math
+                ASSERT_NEAR(expected[f][i], actual[f][i], 1e-6)
+                        << "filter " << f << " sample " << offset + i;
+            }
+        }
+    }
+}
+
+static void BM_WaveformEngineFilters(benchmark::State& state) {
+    const int bufferSize = static_cast<int>(state.range(0));
+    const std::vector<CSAMPLE> input = noise(bufferSize);
+    std::vector<CSAMPLE> output(bufferSize);
+    EngineFilterBessel4Low low(44100, 600);
+    EngineFilterBessel4Band mid(44100, 600, 4000);
+    EngineFilterBessel4High high(44100, 4000);
+    low.assumeSettled();
+    mid.assumeSettled();
+    high.assumeSettled();
+    while (state.KeepRunning()) {
+        low.process(input.data(), output.data(), bufferSize);
+        mid.process(input.data(), output.data(), bufferSize);
+        high.process(input.data(), output.data(), bufferSize);
+    }
+    state.SetItemsProcessed(state.iterations() * bufferSize / 2);
+}
+BENCHMARK(BM_WaveformEngineFilters)->Range(1024, 65536);
+
+static void BM_WaveformFilterBank(benchmark::State& state) {
+    const int bufferSize = static_cast<int>(state.range(0));
+    const std::vector<CSAMPLE> input = noise(bufferSize);
+    std::vector<CSAMPLE> output[FilterCount];
+    for (auto& bandOutput : output) {
+        bandOutput.resize(bufferSize);
+    }
+    WaveformFilterBank filterBank(44100, 600, 4000);
+    while (state.KeepRunning()) {
+        filterBank.process(input.data(),
+                output[Low].data(),
+                output[Mid].data(),
+                output[High].data(),
+                bufferSize);
+    }
+    state.SetItemsProcessed(state.iterations() * bufferSize / 2);
+}
+BENCHMARK(BM_WaveformFilterBank)->Range(1024, 65536);
+
 } // namespace
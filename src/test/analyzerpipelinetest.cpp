@@ -0,0 +1,138 @@
+#include <gtest/gtest.h>
+
+#include <QThread>
+
+#include "test/mixxxtest.h"
+
+#include "analyzer/analyzerpipeline.h"
+#include "analyzer/constants.h"
+
+namespace {
+
+constexpr int kNumBlocks = 50;
+
+struct AnalyzerResult {
+    AnalyzerResult()
+            : sum(0.0),
+              numSamples(0),
+              inOrder(true),
+              stored(false),
+              cleanedUp(false) {
+    }
+    double sum;
+    int numSamples;
+    bool inOrder;
+    bool stored;
+    bool cleanedUp;
+};
+
+// Checks that the samples arrive in order and sums them up. The analyzer
+// might be slow for testing that decoding does not overwrite samples that
+// have not been processed yet.
+class FakeAnalyzer : public Analyzer {
+  public:
+    FakeAnalyzer(AnalyzerResult* pResult, bool slow)
+            : m_pResult(pResult),
+              m_slow(slow) {
+    }
+
+    bool initialize(TrackPointer /*tio*/, int /*sampleRate*/, int /*totalSamples*/) override {
+        return true;
+    }
+
+    bool processSamples(const CSAMPLE* pIn, const int iLen) override {
+        if (m_slow) {
+            QThread::usleep(100);
+        }
+        for (int i = 0; i < iLen; ++i) {
+            if (pIn[i] != static_cast<CSAMPLE>(m_pResult->numSamples)) {
+                m_pResult->inOrder = false;
+            }
+            m_pResult->sum += pIn[i];
+            ++m_pResult->numSamples;
+        }
+        return true;
+    }
+
+    void storeResults(TrackPointer /*tio*/) override {
+        m_pResult->stored = true;
+    }
+
+    void cleanup() override {
+        m_pResult->cleanedUp = true;
+    }
+
+  private:
+    AnalyzerResult* const m_pResult;
+    const bool m_slow;
+};
+
+class AnalyzerPipelineTest : public MixxxTest {
+  protected:
+    AnalyzerPipelineTest()
+            : m_results(3) {
+        std::vector<AnalyzerWithState> analyzers;
+        for (size_t i = 0; i < m_results.size(); ++i) {
+            analyzers.push_back(AnalyzerWithState(
+                    std::make_unique<FakeAnalyzer>(&m_results[i], i == 0)));
+        }
+        m_pPipeline = std::make_unique<AnalyzerPipeline>(
+                "AnalyzerPipelineTest", std::move(analyzers));
+    }
+
+    void processBlocks() {
+        std::vector<CSAMPLE> samples(mixxx::kAnalysisSamplesPerChunk);
+        int sampleIndex = 0;
+        for (int block = 0; block < kNumBlocks; ++block) {
+            for (auto& sample : samples) {
+                sample = static_cast<CSAMPLE>(sampleIndex++);
+            }
+            m_pPipeline->processSamples(samples.data(), static_cast<int>(samples.size()));
+        }
+    }
+
+    std::vector<AnalyzerResult> m_results;
+    std::unique_ptr<AnalyzerPipeline> m_pPipeline;
+};
+
+TEST_F(AnalyzerPipelineTest, AllAnalyzersProcessAllSamples) {
+    TrackPointer pTrack = Track::newTemporary();
+    ASSERT_TRUE(m_pPipeline->initialize(pTrack, 44100, 0));
+    processBlocks();
+    m_pPipeline->finish(pTrack);
+
+    const int numSamples = kNumBlocks * mixxx::kAnalysisSamplesPerChunk;
+    for (const auto& result : m_results) {
+        EXPECT_EQ(numSamples, result.numSamples);
+        EXPECT_TRUE(result.inOrder);
+        EXPECT_TRUE(result.stored);
+        EXPECT_TRUE(result.cleanedUp);
+    }
+}
+
+TEST_F(AnalyzerPipelineTest, Cancel) {
+    TrackPointer pTrack = Track::newTemporary();
+    ASSERT_TRUE(m_pPipeline->initialize(pTrack, 44100, 0));
+    processBlocks();
+    m_pPipeline->cancel();
+
+    for (const auto& result : m_results) {
+        EXPECT_TRUE(result.inOrder);
+        EXPECT_FALSE(result.stored);
+        EXPECT_TRUE(result.cleanedUp);
+    }
+
+    // The pipeline can be reused for the next track
+    for (auto& result : m_results) {
+        result = AnalyzerResult();
+    }
+    ASSERT_TRUE(m_pPipeline->initialize(pTrack, 44100, 0));
+    processBlocks();
+    m_pPipeline->finish(pTrack);
+    for (const auto& result : m_results) {
+        EXPECT_EQ(kNumBlocks * mixxx::kAnalysisSamplesPerChunk, result.numSamples);
+        EXPECT_TRUE(result.stored);
+    }
+}
+
+} // anonymous namespace
@@ -66,4 +66,18 @@ TEST(ChannelHandleTest, ChannelHandleMap) {
     EXPECT_QSTRING_EQ("foo", map.at(test));
 }
 
+TEST(ChannelHandleTest, ChannelHandleMapInitializesPointers) {
+    ChannelHandleFactory factory;
+    ChannelHandle test = factory.getOrCreateHandle("[Test]");
+    ChannelHandle test2 = factory.getOrCreateHandle("[Test2]");
+    ChannelHandle test3 = factory.getOrCreateHandle("[Test3]");
+
+    int value = 0;
+    ChannelHandleMap<int*> map;
+    map.insert(test2, &value);
+    EXPECT_EQ(nullptr, map.at(test));
+    EXPECT_EQ(&value, map.at(test2));
+    EXPECT_EQ(nullptr, map[test3]);
+}
+
 }  // namespace
@@ -0,0 +1,174 @@
+#include <gtest/gtest.h>
+
+#include <QtDebug>
+#include <random>
+#include <vector>
+
+#include "effects/effectsmanager.h"
+#include "engine/channelhandle.h"
+#include "engine/channelmixer.h"
+#include "engine/enginemaster.h"
+#include "test/mixxxtest.h"
+#include "util/defs.h"
+#include "util/sample.h"
+#include "util/types.h"
+
+namespace {
+
+const unsigned int kSampleRate = 44100;
+// Not a multiple of the tile size to test the partial last tile
+const unsigned int kBufferSize = 2 * 1000;
+const int kMaxChannels = 9;
+
+class IndexGainCalculator : public EngineMaster::GainCalculator {
+  public:
+    double getGain(EngineMaster::ChannelInfo* pChannelInfo) const override {
+        return m_gains.at(pChannelInfo->m_index);
+    }
+
+    std::vector<double> m_gains;
+};
+
+// Compares the fused ChannelMixer functions to the generated ones.
+class ChannelMixerTest : public MixxxTest,
+                         public ::testing::WithParamInterface<int> {
+  protected:
+    ChannelMixerTest()
+            : m_pChannelHandleFactory(std::make_shared<ChannelHandleFactory>()),
+              m_pEffectsManager(new EffectsManager(
+                      nullptr, config(), m_pChannelHandleFactory)),
+              m_outputHandle(m_pChannelHandleFactory->getOrCreateHandle("[Master]")),
+              m_rng(42) {
+        std::uniform_real_distribution<double> gainDist(0.0, 1.0);
+        for (int i = 0; i < kMaxChannels; ++i) {
+            // Alternate between constant, ramping, unity and faded out
+            // channels.
+            const double gain = gainDist(m_rng);
+            m_calculator.m_gains.push_back(i % 4 == 2 ? 1.0 : gain);
+            EngineMaster::GainCache gainCache;
+            gainCache.m_gain = i % 2 ? gain : 0.5;
+            gainCache.m_fadeout = i % 4 == 3;
+            m_gainCache.append(gainCache);
+        }
+    }
+
+    ~ChannelMixerTest() override {
+        for (EngineMaster::ChannelInfo* pChannelInfo : m_channels) {
+            SampleUtil::free(pChannelInfo->m_pBuffer);
+            delete pChannelInfo;
+        }
+        delete m_pEffectsManager;
+    }
+
+    // Creates the channels with random buffer contents.
+    void createChannels(int numChannels) {
+        std::uniform_real_distribution<CSAMPLE> sampleDist(-1.0f, 1.0f);
+        for (int i = 0; i < numChannels; ++i) {
+            auto pChannelInfo = new EngineMaster::ChannelInfo(i);
+            pChannelInfo->m_handle = m_pChannelHandleFactory->getOrCreateHandle(
+                    QString("[Channel%1]").arg(i + 1));
+            pChannelInfo->m_pBuffer = SampleUtil::alloc(kBufferSize);
+            for (unsigned int j = 0; j < kBufferSize; ++j) {
+                pChannelInfo->m_pBuffer[j] = sampleDist(m_rng);
+            }
+            m_channels.append(pChannelInfo);
+        }
+    }
+
+    std::vector<CSAMPLE> channelBuffer(int i) const {
+        const CSAMPLE* pBuffer = m_channels.at(i)->m_pBuffer;
+        return std::vector<CSAMPLE>(pBuffer, pBuffer + kBufferSize);
+    }
+
+    void restoreChannelBuffer(int i, const std::vector<CSAMPLE>& buffer) {
+        SampleUtil::copy(m_channels.at(i)->m_pBuffer, buffer.data(), kBufferSize);
+    }
+
+    static void expectBuffersNear(const std::vector<CSAMPLE>& expected,
+            const std::vector<CSAMPLE>& actual) {
+        ASSERT_EQ(expected.size(), actual.size());
+        for (size_t i = 0; i < expected.size(); ++i) {
+            EXPECT_NEAR(expected[i], actual[i], 1e-5) << "at sample " << i;
+        }
+    }
+
+    ChannelHandleFactoryPointer m_pChannelHandleFactory;
+    EffectsManager* m_pEffectsManager;
+    const ChannelHandle m_outputHandle;
+    std::mt19937 m_rng;
+    IndexGainCalculator m_calculator;
+    QVarLengthArray<EngineMaster::ChannelInfo*, kPreallocatedChannels> m_channels;
+    QVarLengthArray<EngineMaster::GainCache, kPreallocatedChannels> m_gainCache;
+};
+
+TEST_P(ChannelMixerTest, FusedMatchesGenerated) {
+    createChannels(GetParam());
+    EngineEffectsManager* pEngineEffectsManager =
+            m_pEffectsManager->getEngineEffectsManager();
+
+    QVarLengthArray<EngineMaster::GainCache, kPreallocatedChannels> gainCache =
+            m_gainCache;
+    std::vector<CSAMPLE> expected(kBufferSize, 0.0f);
+    // Two callbacks: The first one ramps from the cached gains
+    for (int callback = 0; callback < 2; ++callback) {
+        ChannelMixer::applyEffectsAndMixChannels(
+                m_calculator, &m_channels, &gainCache,
+                expected.data(), m_outputHandle,
+                kBufferSize, kSampleRate, pEngineEffectsManager);
+    }
+
+    gainCache = m_gainCache;
+    std::vector<CSAMPLE> actual(kBufferSize, 0.0f);
+    for (int callback = 0; callback < 2; ++callback) {
+        ChannelMixer::applyEffectsAndMixChannelsFused(
+                m_calculator, &m_channels, &gainCache,
+                actual.data(), m_outputHandle,
+                kBufferSize, kSampleRate, pEngineEffectsManager);
+    }
+    expectBuffersNear(expected, actual);
+}
+
+TEST_P(ChannelMixerTest, InPlaceFusedMatchesGenerated) {
+    createChannels(GetParam());
+    EngineEffectsManager* pEngineEffectsManager =
+            m_pEffectsManager->getEngineEffectsManager();
+
+    std::vector<std::vector<CSAMPLE>> inputs;
+    for (int i = 0; i < m_channels.size(); ++i) {
+        inputs.push_back(channelBuffer(i));
+    }
+
+    QVarLengthArray<EngineMaster::GainCache, kPreallocatedChannels> gainCache =
+            m_gainCache;
+    // Stale contents must be overwritten
+    std::vector<CSAMPLE> expected(kBufferSize, 1.0f);
+    ChannelMixer::applyEffectsInPlaceAndMixChannels(
+            m_calculator, &m_channels, &gainCache,
+            expected.data(), m_outputHandle,
+            kBufferSize, kSampleRate, pEngineEffectsManager);
+    std::vector<std::vector<CSAMPLE>> expectedChannels;
+    for (int i = 0; i < m_channels.size(); ++i) {
+        expectedChannels.push_back(channelBuffer(i));
+        restoreChannelBuffer(i, inputs[i]);
+    }
+
+    gainCache = m_gainCache;
+    std::vector<CSAMPLE> actual(kBufferSize, 1.0f);
+    ChannelMixer::applyEffectsInPlaceAndMixChannelsFused(
+            m_calculator, &m_channels, &gainCache,
+            actual.data(), m_outputHandle,
+            kBufferSize, kSampleRate, pEngineEffectsManager);
+    expectBuffersNear(expected, actual);
+    for (int i = 0; i < m_channels.size(); ++i) {
+        expectBuffersNear(expectedChannels[i], channelBuffer(i));
+        const CSAMPLE_GAIN newGain = i % 4 == 3 ? 0 : m_calculator.m_gains[i];
+        EXPECT_EQ(newGain, gainCache[i].m_gain);
+        EXPECT_FALSE(gainCache[i].m_fadeout);
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(ChannelMixerTest,
+        ChannelMixerTest,
+        ::testing::Range(0, kMaxChannels + 1));
+
+} // anonymous namespace
@@ -1,8 +1,12 @@
 #include <gtest/gtest.h>
+#include <benchmark/benchmark.h>
 #include <QtDebug>
+#include <vector>
 
 #include "control/controlobject.h"
+#include "control/controlproxy.h"
 #include "util/memory.h"
+#include "util/mutex.h"
 #include "test/mixxxtest.h"
 
 namespace {
@@ -49,6 +53,76 @@ TEST_F(ControlObjectTest, AliasRetrieval) {
     EXPECT_EQ(ControlObject::getControl(ckAlias), co.get());
 }
 
+TEST_F(ControlObjectTest, getControlById) {
+    const ControlId id1 = ControlDoublePrivate::getControlId(ck1);
+    const ControlId id2 = ControlDoublePrivate::getControlId(ck2);
+    EXPECT_NE(kInvalidControlId, id1);
+    EXPECT_NE(id1, id2);
+    EXPECT_EQ(id1, ControlDoublePrivate::getControlId(ck1));
+    EXPECT_EQ(ControlObject::getControl(id1), co1.get());
+    EXPECT_EQ(ControlObject::getControl(id2), co2.get());
+
+    ControlObject::set(id1, 1.0);
+    EXPECT_DOUBLE_EQ(1.0, co1->get());
+    EXPECT_DOUBLE_EQ(1.0, ControlObject::get(id1));
+
+    // The id stays valid if the control is deleted and created again
+    co2.reset();
+    EXPECT_EQ(ControlObject::getControl(id2, false), (ControlObject*)nullptr);
+    co2 = std::make_unique<ControlObject>(ck2);
+    EXPECT_EQ(id2, ControlDoublePrivate::getControlId(ck2));
+    EXPECT_EQ(ControlObject::getControl(id2), co2.get());
+}
+
+TEST_F(ControlObjectTest, getControlIdBeforeCreation) {
+    ConfigKey ck("[Test]", "notYetCreated");
+    EXPECT_EQ(ControlObject::getControl(ck, false), (ControlObject*)nullptr);
+    // Unknown keys are not interned
+    EXPECT_EQ(kInvalidControlId, ControlDoublePrivate::getControlId(ck));
+    EXPECT_EQ(ControlObject::getControl(kInvalidControlId, false),
+            (ControlObject*)nullptr);
+
+    ControlObject co(ck);
+    const ControlId id = ControlDoublePrivate::getControlId(ck);
+    EXPECT_NE(kInvalidControlId, id);
+    EXPECT_EQ(ControlObject::getControl(id), &co);
+}
+
+TEST_F(ControlObjectTest, ControlProxyResolvesId) {
+    ControlProxy proxy(ck1);
+    EXPECT_EQ(ControlDoublePrivate::getControlId(ck1), proxy.getControlId());
+    EXPECT_EQ(ControlObject::getControl(proxy.getControlId()), co1.get());
+
+    ControlProxy unknownProxy(ConfigKey("[Test]", "unknown"));
+    EXPECT_FALSE(unknownProxy.valid());
+    EXPECT_EQ(kInvalidControlId, unknownProxy.getControlId());
+}
+
+TEST_F(ControlObjectTest, AliasRetrievalById) {
+    ConfigKey ck("[Microphone1]", "pregain");
+    ConfigKey ckAlias("[Microphone]", "pregain");
+    auto co = std::make_unique<ControlObject>(ck);
+    ControlDoublePrivate::insertAlias(ckAlias, ck);
+
+    const ControlId aliasId = ControlDoublePrivate::getControlId(ckAlias);
+    EXPECT_NE(ControlDoublePrivate::getControlId(ck), aliasId);
+    EXPECT_EQ(ControlObject::getControl(aliasId), co.get());
+    EXPECT_EQ(ControlDoublePrivate::getControlAliases().value(ck), ckAlias);
+}
+
+TEST_F(ControlObjectTest, getControls) {
+    QList<QSharedPointer<ControlDoublePrivate>> controls;
+    ControlDoublePrivate::getControls(&controls);
+    int found = 0;
+    for (const auto& pControl : controls) {
+        if (pControl->getCreatorCO() == co1.get() ||
+                pControl->getCreatorCO() == co2.get()) {
+            ++found;
+        }
+    }
+    EXPECT_EQ(2, found);
+}
+
 TEST_F(ControlObjectTest, Persistence_NotPresent) {
     ConfigKey ck("[Test]", "persist");
     ASSERT_FALSE(m_pConfig->exists(ck));
@@ -84,4 +158,94 @@ TEST_F(ControlObjectTest, Persistence_ValidValue) {
     EXPECT_DOUBLE_EQ(5.0, co.get());
 }
 
+// Lookup throughput of a large number of controls, e.g. while loading a skin
+// or from controller scripts, with contending threads.
+const int kNumBenchmarkControls = 4096;
+
+std::vector<std::unique_ptr<ControlObject>> s_benchmarkControls;
+std::vector<ConfigKey> s_benchmarkKeys;
+std::vector<ControlId> s_benchmarkIds;
+
+// The previous implementation of the control hash with a global mutex for
+// comparison.
+QHash<ConfigKey, QWeakPointer<ControlDoublePrivate>> s_benchmarkHash;
+MMutex s_benchmarkHashMutex;
+
+void setUpBenchmarkControls() {
+    for (int i = 0; i < kNumBenchmarkControls; ++i) {
+        ConfigKey key(QString("[Benchmark%1]").arg(i / 64),
+                QString("control%1").arg(i));
+        s_benchmarkControls.push_back(std::make_unique<ControlObject>(key));
+        s_benchmarkKeys.push_back(key);
+        s_benchmarkIds.push_back(ControlDoublePrivate::getControlId(key));
+        s_benchmarkHash.insert(key, ControlDoublePrivate::getControl(key));
+    }
+}
+
+void tearDownBenchmarkControls() {
+    s_benchmarkHash.clear();
+    s_benchmarkIds.clear();
+    s_benchmarkKeys.clear();
+    s_benchmarkControls.clear();
+}
+
+static void BM_ControlLookup_ByKey(benchmark::State& state) {
+    if (state.thread_index == 0) {
+        setUpBenchmarkControls();
+    }
+    // Each thread starts with different controls
+    int i = state.thread_index * (kNumBenchmarkControls / state.threads);
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(ControlDoublePrivate::getControl(
+                s_benchmarkKeys[i], false));
+        i = (i + 1) % kNumBenchmarkControls;
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index == 0) {
+        tearDownBenchmarkControls();
+    }
+}
+BENCHMARK(BM_ControlLookup_ByKey)->ThreadRange(1, 8)->UseRealTime();
+
+static void BM_ControlLookup_ById(benchmark::State& state) {
+    if (state.thread_index == 0) {
+        setUpBenchmarkControls();
+    }
+    int i = state.thread_index * (kNumBenchmarkControls / state.threads);
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(ControlDoublePrivate::getControl(
+                s_benchmarkIds[i], false));
+        i = (i + 1) % kNumBenchmarkControls;
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index == 0) {
+        tearDownBenchmarkControls();
+    }
+}
+BENCHMARK(BM_ControlLookup_ById)->ThreadRange(1, 8)->UseRealTime();
+
+static void BM_ControlLookup_GlobalMutex(benchmark::State& state) {
+    if (state.thread_index == 0) {
+        setUpBenchmarkControls();
+    }
+    int i = state.thread_index * (kNumBenchmarkControls / state.threads);
+    while (state.KeepRunning()) {
+        QSharedPointer<ControlDoublePrivate> pControl;
+        {
+            MMutexLocker locker(&s_benchmarkHashMutex);
+            auto it = s_benchmarkHash.constFind(s_benchmarkKeys[i]);
+            if (it != s_benchmarkHash.constEnd()) {
+                pControl = it.value();
+            }
+        }
+        benchmark::DoNotOptimize(pControl);
+        i = (i + 1) % kNumBenchmarkControls;
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index == 0) {
+        tearDownBenchmarkControls();
+    }
+}
+BENCHMARK(BM_ControlLookup_GlobalMutex)->ThreadRange(1, 8)->UseRealTime();
+
 }
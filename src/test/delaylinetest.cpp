@@ -0,0 +1,173 @@
+#include <benchmark/benchmark.h>
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+#include "util/delayline.h"
+
+namespace {
+
+constexpr int kChannelCount = 2;
+using StereoDelayLine = mixxx::DelayLine<CSAMPLE, kChannelCount>;
+
+std::vector<CSAMPLE> ramp(SINT frames) {
+    std::vector<CSAMPLE> samples(kChannelCount * frames);
+    for (std::size_t i = 0; i < samples.size(); ++i) {
+        samples[i] = static_cast<CSAMPLE>(i + 1);
+    }
+    return samples;
+}
+
+TEST(DelayLineTest, CapacityIsPowerOfTwo) {
+    EXPECT_EQ(1, StereoDelayLine(0).capacity());
+    EXPECT_EQ(1024, StereoDelayLine(1024).capacity());
+    EXPECT_EQ(2048, StereoDelayLine(1025).capacity());
+}
+
+TEST(DelayLineTest, FramesAreCountedByAge) {
+    StereoDelayLine delayLine(4);
+    const std::vector<CSAMPLE> input = ramp(6);
+    for (SINT frame = 0; frame < 6; ++frame) {
+        delayLine.writeFrame(&input[kChannelCount * frame]);
+    }
+    for (SINT age = 0; age < 4; ++age) {
+        EXPECT_EQ(input[kChannelCount * (5 - age)], delayLine.frame(age)[0]);
+        EXPECT_EQ(input[kChannelCount * (5 - age) + 1], delayLine.frame(age)[1]);
+    }
+}
+
+TEST(DelayLineTest, ProcessDelaysBuffersOfAnyLength) {
+    const SINT frames = 10000;
+    const std::vector<CSAMPLE> input = ramp(frames);
+    std::mt19937 generator(1);
+    for (SINT delayFrames : {0, 1, 100, 1023}) {
+        StereoDelayLine delayLine(1024);
+        std::vector<CSAMPLE> output(input);
+        SINT frame = 0;
+        while (frame < frames) {
+            // Longer than the capacity as well
+            const SINT bufferFrames = std::min<SINT>(
+                    frames - frame, generator() % 3000 + 1);
+            delayLine.process(&output[kChannelCount * frame],
+                    &output[kChannelCount * frame],
+                    bufferFrames,
+                    delayFrames);
+            frame += bufferFrames;
+        }
+        for (std::size_t i = 0; i < output.size(); ++i) {
+            const SINT inputIndex = static_cast<SINT>(i) - kChannelCount * delayFrames;
+            ASSERT_EQ(inputIndex >= 0 ? input[inputIndex] : 0.0f, output[i])
+                    << "delay " << delayFrames << " sample " << i;
+        }
+    }
+}
+
+TEST(DelayLineTest, InterpolatedFramesAreLinear) {
+    StereoDelayLine delayLine(16);
+    const std::vector<CSAMPLE> input = ramp(16);
+    delayLine.write(input.data(), 16);
+
+    CSAMPLE frame[kChannelCount];
+    delayLine.readInterpolated(frame, 3.0);
+    EXPECT_FLOAT_EQ(input[kChannelCount * 12], frame[0]);
+    delayLine.readInterpolated(frame, 3.25);
+    EXPECT_FLOAT_EQ(input[kChannelCount * 12] - 0.25f * kChannelCount, frame[0]);
+    EXPECT_FLOAT_EQ(input[kChannelCount * 12 + 1] - 0.25f * kChannelCount, frame[1]);
+}
+
+// A delay wrapped by modulo one sample at a time, like the delays that
+// used to be in EngineDelay and EngineFilterDelay.
+static void BM_ModuloDelay(benchmark::State& state) {
+    const SINT frames = static_cast<SINT>(state.range(0));
+    const int length = 44100 * kChannelCount;
+    const int delay = 1000 * kChannelCount;
+    std::vector<CSAMPLE> delayBuffer(length);
+    std::vector<CSAMPLE> buffer = ramp(frames);
+    int writePos = 0;
+    while (state.KeepRunning()) {
+        int readPos = (writePos + length - delay) % length;
+        for (std::size_t i = 0; i < buffer.size(); ++i) {
+            delayBuffer[writePos] = buffer[i];
+            writePos = (writePos + 1) % length;
+            buffer[i] = delayBuffer[readPos];
+            readPos = (readPos + 1) % length;
+        }
+        benchmark::DoNotOptimize(buffer.data());
+    }
+    state.SetItemsProcessed(state.iterations() * frames);
+}
+BENCHMARK(BM_ModuloDelay)->RangeMultiplier(4)->Range(64, 4096);
+
+static void BM_DelayLineProcess(benchmark::State& state) {
+    const SINT frames = static_cast<SINT>(state.range(0));
+    StereoDelayLine delayLine(44100);
+    std::vector<CSAMPLE> buffer = ramp(frames);
+    while (state.KeepRunning()) {
+        delayLine.process(buffer.data(), buffer.data(), frames, 1000);
+        benchmark::DoNotOptimize(buffer.data());
+    }
+    state.SetItemsProcessed(state.iterations() * frames);
+}
+BENCHMARK(BM_DelayLineProcess)->RangeMultiplier(4)->Range(64, 4096);
+
+// A modulated feedback delay with separate channel buffers wrapped by
+// modulo, like the one that used to be in FlangerEffect.
+static void BM_ModuloModulatedDelay(benchmark::State& state) {
+    const SINT frames = static_cast<SINT>(state.range(0));
+    const SINT length = 1344;
+    std::vector<CSAMPLE> delayLeft(length);
+    std::vector<CSAMPLE> delayRight(length);
+    std::vector<CSAMPLE> buffer = ramp(frames);
+    SINT delayPos = 0;
+    double delayFrames = 300.5;
+    while (state.KeepRunning()) {
+        for (SINT i = 0; i < kChannelCount * frames; i += kChannelCount) {
+            delayFrames += 0.01;
+            const SINT framePrev = (delayPos - static_cast<SINT>(floor(delayFrames))
+                    + length) % length;
+            const SINT frameNext = (delayPos - static_cast<SINT>(ceil(delayFrames))
+                    + length) % length;
+            const CSAMPLE frac = delayFrames - floor(delayFrames);
+            const CSAMPLE left = delayLeft[framePrev] +
+                    frac * (delayLeft[frameNext] - delayLeft[framePrev]);
+            const CSAMPLE right = delayRight[framePrev] +
+                    frac * (delayRight[frameNext] - delayRight[framePrev]);
+            delayLeft[delayPos] = buffer[i] + 0.5f * left;
+            delayRight[delayPos] = buffer[i + 1] + 0.5f * right;
+            delayPos = (delayPos + 1) % length;
+            buffer[i] = left;
+            buffer[i + 1] = right;
+        }
+        delayFrames = 300.5;
+        benchmark::DoNotOptimize(buffer.data());
+    }
+    state.SetItemsProcessed(state.iterations() * frames);
+}
+BENCHMARK(BM_ModuloModulatedDelay)->RangeMultiplier(4)->Range(64, 4096);
+
+static void BM_DelayLineModulatedDelay(benchmark::State& state) {
+    const SINT frames = static_cast<SINT>(state.range(0));
+    StereoDelayLine delayLine(1344);
+    std::vector<CSAMPLE> buffer = ramp(frames);
+    double delayFrames = 300.5;
+    while (state.KeepRunning()) {
+        for (SINT i = 0; i < kChannelCount * frames; i += kChannelCount) {
+            delayFrames += 0.01;
+            CSAMPLE delayedFrame[kChannelCount];
+            delayLine.readInterpolated(delayedFrame, delayFrames - 1);
+            const CSAMPLE writtenFrame[] = {
+                    buffer[i] + 0.5f * delayedFrame[0],
+                    buffer[i + 1] + 0.5f * delayedFrame[1]};
+            delayLine.writeFrame(writtenFrame);
+            buffer[i] = delayedFrame[0];
+            buffer[i + 1] = delayedFrame[1];
+        }
+        delayFrames = 300.5;
+        benchmark::DoNotOptimize(buffer.data());
+    }
+    state.SetItemsProcessed(state.iterations() * frames);
+}
+BENCHMARK(BM_DelayLineModulatedDelay)->RangeMultiplier(4)->Range(64, 4096);
+
+}  // namespace
@@ -0,0 +1,203 @@
+#include <gtest/gtest.h>
+
+#include <QSet>
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+#include "effects/effectprocessor.h"
+#include "test/baseeffecttest.h"
+
+namespace {
+
+constexpr SINT kFramesPerBuffer = 64;
+
+// Counts the live states, and separately the states that are allocated on
+// and deleted from the heap instead of the pool
+class CountingState : public EffectState {
+  public:
+    CountingState(const mixxx::EngineParameters& bufferParameters)
+            : EffectState(bufferParameters),
+              processed(0) {
+        ++s_liveStates;
+    }
+    ~CountingState() override {
+        --s_liveStates;
+    }
+
+    static void* operator new(std::size_t size) {
+        ++s_heapAllocations;
+        return ::operator new(size);
+    }
+    // Used by the pool, which must not be counted
+    static void* operator new(std::size_t size, void* pPlace) {
+        Q_UNUSED(size);
+        return pPlace;
+    }
+    static void operator delete(void* pState) {
+        ++s_heapDeletions;
+        ::operator delete(pState);
+    }
+
+    int processed;
+
+    static int s_liveStates;
+    static int s_heapAllocations;
+    static int s_heapDeletions;
+};
+
+int CountingState::s_liveStates = 0;
+int CountingState::s_heapAllocations = 0;
+int CountingState::s_heapDeletions = 0;
+
+class CountingEffect : public EffectProcessorImpl<CountingState> {
+  public:
+    void processChannel(const ChannelHandle& handle,
+            CountingState* pState,
+            const CSAMPLE* pInput,
+            CSAMPLE* pOutput,
+            const mixxx::EngineParameters& bufferParameters,
+            const EffectEnableState enableState,
+            const GroupFeatureState& groupFeatures) override {
+        Q_UNUSED(handle);
+        Q_UNUSED(pInput);
+        Q_UNUSED(pOutput);
+        Q_UNUSED(bufferParameters);
+        Q_UNUSED(enableState);
+        Q_UNUSED(groupFeatures);
+        ++pState->processed;
+    }
+};
+
+class EffectProcessorTest : public BaseEffectTest {
+  protected:
+    EffectProcessorTest()
+            : m_master(m_pChannelHandleFactory->getOrCreateHandle("[Master]"),
+                      "[Master]"),
+              m_headphone(m_pChannelHandleFactory->getOrCreateHandle("[Headphone]"),
+                      "[Headphone]"),
+              m_deck1(m_pChannelHandleFactory->getOrCreateHandle("[Channel1]"),
+                      "[Channel1]"),
+              m_deck2(m_pChannelHandleFactory->getOrCreateHandle("[Channel2]"),
+                      "[Channel2]"),
+              m_bufferParameters(mixxx::audio::SampleRate(44100), kFramesPerBuffer),
+              m_input(kFramesPerBuffer * mixxx::kEngineChannelCount),
+              m_output(kFramesPerBuffer * mixxx::kEngineChannelCount) {
+        CountingState::s_liveStates = 0;
+        CountingState::s_heapAllocations = 0;
+        CountingState::s_heapDeletions = 0;
+        m_pEffectsManager->registerOutputChannel(m_master);
+        m_pEffectsManager->registerOutputChannel(m_headphone);
+        m_pEffectsManager->registerInputChannel(m_deck1);
+        m_pEffectsManager->registerInputChannel(m_deck2);
+    }
+
+    void initialize(CountingEffect* pEffect,
+            const QSet<ChannelHandleAndGroup>& activeInputChannels) {
+        pEffect->initialize(activeInputChannels, m_pEffectsManager.data(), m_bufferParameters);
+    }
+
+    // Like the states that EngineEffectChain sends for enabling an input
+    EffectStatesMap createStates(CountingEffect* pEffect) {
+        EffectStatesMap states;
+        states.insert(m_master.handle(), pEffect->createState(m_bufferParameters));
+        states.insert(m_headphone.handle(), pEffect->createState(m_bufferParameters));
+        return states;
+    }
+
+    void process(CountingEffect* pEffect,
+            const ChannelHandleAndGroup& input,
+            const ChannelHandleAndGroup& output) {
+        pEffect->process(input.handle(),
+                output.handle(),
+                m_input.data(),
+                m_output.data(),
+                m_bufferParameters,
+                EffectEnableState::Enabled,
+                GroupFeatureState());
+    }
+
+    ChannelHandleAndGroup m_master;
+    ChannelHandleAndGroup m_headphone;
+    ChannelHandleAndGroup m_deck1;
+    ChannelHandleAndGroup m_deck2;
+    mixxx::EngineParameters m_bufferParameters;
+    std::vector<CSAMPLE> m_input;
+    std::vector<CSAMPLE> m_output;
+};
+
+TEST_F(EffectProcessorTest, StatesComeFromThePool) {
+    {
+        CountingEffect effect;
+        initialize(&effect, {m_deck1});
+        EXPECT_EQ(2, CountingState::s_liveStates);
+
+        EffectStatesMap states = createStates(&effect);
+        EXPECT_TRUE(effect.loadStatesForInputChannel(&m_deck2.handle(), &states));
+        EXPECT_EQ(4, CountingState::s_liveStates);
+
+        effect.deleteStatesForInputChannel(&m_deck2.handle());
+        EXPECT_EQ(2, CountingState::s_liveStates);
+    }
+    EXPECT_EQ(0, CountingState::s_liveStates);
+    EXPECT_EQ(0, CountingState::s_heapAllocations);
+    EXPECT_EQ(0, CountingState::s_heapDeletions);
+}
+
+TEST_F(EffectProcessorTest, LoadOverNonEmptyMapKeepsStaleStates) {
+    CountingEffect effect;
+    initialize(&effect, {m_deck1});
+    EXPECT_EQ(2, CountingState::s_liveStates);
+
+    // The states of deck 1 have not been deleted before, which is a debug
+    // assertion. They must not be destroyed in the engine thread, but are
+    // destroyed later with the new states.
+    EffectStatesMap states = createStates(&effect);
+    EXPECT_TRUE(effect.loadStatesForInputChannel(&m_deck1.handle(), &states));
+    EXPECT_EQ(4, CountingState::s_liveStates);
+
+    process(&effect, m_deck1, m_master);
+    EXPECT_EQ(1, static_cast<CountingState*>(states.at(m_master.handle()))->processed);
+
+    effect.deleteStatesForInputChannel(&m_deck1.handle());
+    EXPECT_EQ(0, CountingState::s_liveStates);
+    EXPECT_EQ(0, CountingState::s_heapDeletions);
+}
+
+TEST_F(EffectProcessorTest, FallbackStatesAreDeleted) {
+    CountingEffect effect;
+    initialize(&effect, {});
+    EXPECT_EQ(0, CountingState::s_liveStates);
+
+    // No state has been preallocated for deck 1, so the engine thread
+    // creates one on the heap, which is a debug assertion
+    process(&effect, m_deck1, m_master);
+    EXPECT_EQ(1, CountingState::s_liveStates);
+    EXPECT_EQ(1, CountingState::s_heapAllocations);
+
+    effect.deleteStatesForInputChannel(&m_deck1.handle());
+    EXPECT_EQ(0, CountingState::s_liveStates);
+    EXPECT_EQ(1, CountingState::s_heapDeletions);
+}
+
+TEST_F(EffectProcessorTest, StaleFallbackStatesAreDeleted) {
+    CountingEffect effect;
+    initialize(&effect, {m_deck1});
+    process(&effect, m_deck2, m_master);
+    EXPECT_EQ(3, CountingState::s_liveStates);
+    EXPECT_EQ(1, CountingState::s_heapAllocations);
+
+    // Replaces the state on the heap with pooled states
+    EffectStatesMap states = createStates(&effect);
+    EXPECT_TRUE(effect.loadStatesForInputChannel(&m_deck2.handle(), &states));
+    EXPECT_EQ(5, CountingState::s_liveStates);
+    EXPECT_EQ(0, CountingState::s_heapDeletions);
+
+    // The stale state is deleted, the pooled states are released
+    effect.deleteStatesForInputChannel(&m_deck2.handle());
+    EXPECT_EQ(2, CountingState::s_liveStates);
+    EXPECT_EQ(1, CountingState::s_heapDeletions);
+}
+
+}  // namespace
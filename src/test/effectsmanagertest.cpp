@@ -9,6 +9,9 @@
 #include "effects/effectchainslot.h"
 #include "effects/effectsmanager.h"
 #include "effects/effectmanifest.h"
+#include "effects/effectrack.h"
+#include "engine/effects/engineeffect.h"
+#include "engine/effects/engineeffectsmanager.h"
 
 #include "test/baseeffecttest.h"
 
@@ -36,3 +39,39 @@ TEST_F(EffectsManagerTest, CanInstantiateEffectsFromBackend) {
     EffectPointer pEffect = m_pEffectsManager->instantiateEffect(pManifest->id());
     EXPECT_FALSE(pEffect.isNull());
 }
+
+TEST_F(EffectsManagerTest, ParameterUpdatesAreCoalescedAndBatched) {
+    EffectManifestPointer pManifest(new EffectManifest());
+    pManifest->setId("org.mixxx.test.effect");
+    pManifest->setName("Test Effect");
+    EffectManifestParameterPointer pParameterManifest = pManifest->addParameter();
+    pParameterManifest->setId("parameter");
+    pParameterManifest->setMinimum(0.0);
+    pParameterManifest->setMaximum(1.0);
+    pParameterManifest->setDefault(0.5);
+    registerTestEffect(pManifest, true);
+
+    StandardEffectRackPointer pRack = m_pEffectsManager->addStandardEffectRack();
+    EffectChainPointer pChain(new EffectChain(m_pEffectsManager.data(),
+                                              "org.mixxx.test.chain1"));
+    pChain->addToEngine(pRack->getEngineEffectRack(), 0);
+    EffectPointer pEffect = m_pEffectsManager->instantiateEffect(pManifest->id());
+    pChain->addEffect(pEffect);
+    EngineEffect* pEngineEffect = pEffect->getEngineEffect();
+    ASSERT_NE(nullptr, pEngineEffect);
+    m_pEffectsManager->flushParameterUpdates();
+
+    // Only the last value is written to the engine.
+    const int coalesced = m_pEffectsManager->coalescedParameterUpdates();
+    EffectParameter* pParameter = pEffect->getParameterById("parameter");
+    pParameter->setValue(0.1);
+    pParameter->setValue(0.2);
+    pParameter->setValue(0.3);
+    EXPECT_EQ(coalesced + 2, m_pEffectsManager->coalescedParameterUpdates());
+
+    // The batch is applied by the engine at the start of the callback.
+    m_pEffectsManager->flushParameterUpdates();
+    m_pEffectsManager->getEngineEffectsManager()->onCallbackStart();
+    EXPECT_DOUBLE_EQ(0.3, pEngineEffect->getParameterById("parameter")->value());
+    EXPECT_EQ(0, m_pEffectsManager->droppedParameterUpdates());
+}
@@ -0,0 +1,125 @@
+#include <benchmark/benchmark.h>
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+#include "effects/effectstatepool.h"
+
+namespace {
+
+class TestState {
+  public:
+    explicit TestState(int* pLiveStates)
+            : m_pLiveStates(pLiveStates) {
+        ++*m_pLiveStates;
+    }
+    ~TestState() {
+        --*m_pLiveStates;
+    }
+
+    // Like the filter memory of a real state
+    double buffer[8];
+
+  private:
+    int* m_pLiveStates;
+};
+
+class EffectStatePoolTest : public testing::Test {
+  protected:
+    int m_liveStates = 0;
+};
+
+TEST_F(EffectStatePoolTest, ReservedStatesAreContiguous) {
+    EffectStatePool<TestState> pool;
+    pool.reserve(16);
+    EXPECT_EQ(16, pool.capacity());
+
+    std::vector<TestState*> states;
+    for (int i = 0; i < 16; ++i) {
+        states.push_back(pool.acquire(&m_liveStates));
+    }
+    EXPECT_EQ(16, pool.capacity());
+    EXPECT_EQ(16, pool.size());
+    EXPECT_EQ(16, m_liveStates);
+    for (int i = 1; i < 16; ++i) {
+        EXPECT_LT(states[i - 1], states[i]);
+        EXPECT_LT(reinterpret_cast<char*>(states[i]) -
+                        reinterpret_cast<char*>(states[i - 1]),
+                2 * static_cast<std::ptrdiff_t>(sizeof(TestState)));
+    }
+}
+
+TEST_F(EffectStatePoolTest, ReleasedSlotsAreReused) {
+    EffectStatePool<TestState> pool;
+    pool.reserve(2);
+    TestState* pState1 = pool.acquire(&m_liveStates);
+    TestState* pState2 = pool.acquire(&m_liveStates);
+    EXPECT_TRUE(pool.release(pState1));
+    EXPECT_EQ(1, m_liveStates);
+    EXPECT_EQ(pState1, pool.acquire(&m_liveStates));
+    EXPECT_EQ(2, pool.capacity());
+
+    // Grows when all slots are in use
+    TestState* pState3 = pool.acquire(&m_liveStates);
+    EXPECT_NE(pState2, pState3);
+    EXPECT_LT(2, pool.capacity());
+    EXPECT_EQ(3, pool.size());
+}
+
+TEST_F(EffectStatePoolTest, ForeignStatesAreNotReleased) {
+    EffectStatePool<TestState> pool;
+    pool.reserve(2);
+    pool.acquire(&m_liveStates);
+    auto pForeignState = std::make_unique<TestState>(&m_liveStates);
+    EXPECT_FALSE(pool.release(pForeignState.get()));
+    EXPECT_EQ(2, m_liveStates);
+}
+
+TEST_F(EffectStatePoolTest, UnreleasedStatesAreDestroyedWithThePool) {
+    {
+        EffectStatePool<TestState> pool;
+        for (int i = 0; i < 10; ++i) {
+            pool.acquire(&m_liveStates);
+        }
+        EXPECT_EQ(10, m_liveStates);
+    }
+    EXPECT_EQ(0, m_liveStates);
+}
+
+// Enabling and disabling a chain for a deck with all output channels
+static void BM_EffectStatePoolAcquireRelease(benchmark::State& state) {
+    const int count = static_cast<int>(state.range(0));
+    int liveStates = 0;
+    EffectStatePool<TestState> pool;
+    pool.reserve(count);
+    std::vector<TestState*> states(count);
+    while (state.KeepRunning()) {
+        for (auto& pState : states) {
+            pState = pool.acquire(&liveStates);
+        }
+        for (auto* pState : states) {
+            pool.release(pState);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_EffectStatePoolAcquireRelease)->Arg(4)->Arg(64);
+
+static void BM_EffectStateNewDelete(benchmark::State& state) {
+    const int count = static_cast<int>(state.range(0));
+    int liveStates = 0;
+    std::vector<TestState*> states(count);
+    while (state.KeepRunning()) {
+        for (auto& pState : states) {
+            pState = new TestState(&liveStates);
+        }
+        for (auto* pState : states) {
+            delete pState;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_EffectStateNewDelete)->Arg(4)->Arg(64);
+
+}  // namespace
@@ -1,3 +1,4 @@
+#include <benchmark/benchmark.h>
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
@@ -59,6 +60,28 @@ class ReadAheadManagerMock : public ReadAheadManager {
     SINT m_iSamplesRead;
 };
 
+// Returns a stereo sine in the direction of the rate, for the benchmarks
+class ReadAheadManagerSine : public ReadAheadManager {
+  public:
+    ReadAheadManagerSine()
+            : ReadAheadManager(),
+              m_frame(0) {
+    }
+
+    SINT getNextSamples(double dRate, CSAMPLE* buffer, SINT requested_samples) override {
+        const SINT frames = requested_samples / 2;
+        for (SINT i = 0; i < frames; ++i) {
+            buffer[2 * i] = static_cast<CSAMPLE>(sin(m_frame * 0.01));
+            buffer[2 * i + 1] = static_cast<CSAMPLE>(cos(m_frame * 0.01));
+            m_frame += dRate < 0 ? -1 : 1;
+        }
+        return 2 * frames;
+    }
+
+  private:
+    SINT m_frame;
+};
+
 class EngineBufferScaleLinearTest : public MixxxTest {
   protected:
     void SetUp() override {
@@ -296,4 +319,117 @@ TEST_F(EngineBufferScaleLinearTest, TestRepeatedScaleCalls) {
     SampleUtil::free(pOutput);
 }
 
+TEST_F(EngineBufferScaleLinearTest, CubicScaleConstant) {
+    m_pScaler->setInterpolation(EngineBufferScaleLinear::Interpolation::Cubic);
+    SetRateNoLerp(0.75);
+
+    CSAMPLE readBuffer[1] = { 1.0f };
+    m_pReadAheadMock->setReadBuffer(readBuffer, 1);
+
+    // Tell the RAMAN mock to invoke getNextSamplesFake
+    EXPECT_CALL(*m_pReadAheadMock, getNextSamples(_, _, _))
+            .WillRepeatedly(Invoke(m_pReadAheadMock, &ReadAheadManagerMock::getNextSamplesFake));
+
+    CSAMPLE* pOutput = SampleUtil::alloc(kiLinearScaleReadAheadLength);
+    m_pScaler->scaleBuffer(pOutput, kiLinearScaleReadAheadLength);
+    // The first frames are interpolated with the silence before the track
+    AssertWholeBufferEquals(pOutput + 4, 1.0f, kiLinearScaleReadAheadLength - 4);
+
+    // One frame more is read ahead than with linear interpolation, which
+    // reads kiLinearScaleReadAheadLength * 3 / 4 + 2 samples
+    ASSERT_EQ(kiLinearScaleReadAheadLength * 3 / 4 + 4,
+            m_pReadAheadMock->getSamplesRead());
+
+    SampleUtil::free(pOutput);
+}
+
+TEST_F(EngineBufferScaleLinearTest, CubicDoubleSpeedHitsTheSamples) {
+    m_pScaler->setInterpolation(EngineBufferScaleLinear::Interpolation::Cubic);
+    SetRateNoLerp(2.0);
+
+    CSAMPLE readBuffer[] = { 1.0, 1.0,
+                             0.0, 0.0,
+                             -1.0, -1.0,
+                             0.0, 0.0 };
+    m_pReadAheadMock->setReadBuffer(readBuffer, 8);
+
+    // Tell the RAMAN mock to invoke getNextSamplesFake
+    EXPECT_CALL(*m_pReadAheadMock, getNextSamples(_, _, _))
+            .WillRepeatedly(Invoke(m_pReadAheadMock, &ReadAheadManagerMock::getNextSamplesFake));
+
+    CSAMPLE* pOutput = SampleUtil::alloc(kiLinearScaleReadAheadLength);
+    m_pScaler->scaleBuffer(pOutput, kiLinearScaleReadAheadLength);
+
+    // The positions are integers, so the cubic interpolation returns the
+    // input frames like the linear one
+    CSAMPLE expectedResult[] = { 1.0, 1.0,
+                                 -1.0, -1.0 };
+    AssertBufferCycles(pOutput, kiLinearScaleReadAheadLength, expectedResult, 4);
+
+    SampleUtil::free(pOutput);
+}
+
+TEST_F(EngineBufferScaleLinearTest, CubicFollowsLinearSignal) {
+    m_pScaler->setInterpolation(EngineBufferScaleLinear::Interpolation::Cubic);
+    SetRateNoLerp(0.5);
+
+    // A ramp is interpolated exactly, apart from the first frames that are
+    // interpolated with the silence before the track
+    QVector<CSAMPLE> readBuffer;
+    for (int i = 0; i < 1000; ++i) {
+        readBuffer.push_back(i / 2);
+    }
+    m_pReadAheadMock->setReadBuffer(readBuffer.data(), readBuffer.size());
+
+    // Tell the RAMAN mock to invoke getNextSamplesFake
+    EXPECT_CALL(*m_pReadAheadMock, getNextSamples(_, _, _))
+            .WillRepeatedly(Invoke(m_pReadAheadMock, &ReadAheadManagerMock::getNextSamplesFake));
+
+    const int kOutputSamples = 1600;
+    CSAMPLE pOutput[kOutputSamples];
+    m_pScaler->scaleBuffer(pOutput, kOutputSamples);
+
+    for (int i = 8; i < kOutputSamples; ++i) {
+        EXPECT_FLOAT_EQ((i / 2) * 0.5f, pOutput[i]);
+    }
+}
+
+// The scaler in the main modes: playing at a constant rate, playing in
+// reverse and scratching, which changes the rate and direction with every
+// buffer. The argument selects the interpolation.
+void scaleBenchmark(benchmark::State& state, const std::vector<double>& rates) {
+    ReadAheadManagerSine readAheadManager;
+    EngineBufferScaleLinear scaler(&readAheadManager);
+    scaler.setSampleRate(mixxx::audio::SampleRate(44100));
+    scaler.setInterpolation(state.range(0) == 0
+                    ? EngineBufferScaleLinear::Interpolation::Linear
+                    : EngineBufferScaleLinear::Interpolation::Cubic);
+    const SINT kBufferSize = 2 * 1024;
+    std::vector<CSAMPLE> output(kBufferSize);
+    size_t rateIndex = 0;
+    while (state.KeepRunning()) {
+        double tempoRatio = rates[rateIndex];
+        double pitchRatio = tempoRatio;
+        scaler.setScaleParameters(1.0, &tempoRatio, &pitchRatio);
+        scaler.scaleBuffer(output.data(), kBufferSize);
+        rateIndex = (rateIndex + 1) % rates.size();
+    }
+    state.SetItemsProcessed(state.iterations() * kBufferSize / 2);
+}
+
+static void BM_ScaleLinearConstantRate(benchmark::State& state) {
+    scaleBenchmark(state, {0.97});
+}
+BENCHMARK(BM_ScaleLinearConstantRate)->Arg(0)->Arg(1);
+
+static void BM_ScaleLinearReverse(benchmark::State& state) {
+    scaleBenchmark(state, {-1.03});
+}
+BENCHMARK(BM_ScaleLinearReverse)->Arg(0)->Arg(1);
+
+static void BM_ScaleLinearScratch(benchmark::State& state) {
+    scaleBenchmark(state, {2.5, 1.2, 0.3, -0.8, -3.1, -1.5, 0.6, 4.0});
+}
+BENCHMARK(BM_ScaleLinearScratch)->Arg(0)->Arg(1);
+
 }  // namespace
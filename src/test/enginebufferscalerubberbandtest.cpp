@@ -0,0 +1,239 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+#include "engine/bufferscalers/enginebufferscalerubberband.h"
+#include "engine/engineworkerscheduler.h"
+#include "engine/readaheadmanager.h"
+#include "util/math.h"
+#include "util/types.h"
+
+namespace {
+
+constexpr SINT kSampleRate = 44100;
+constexpr SINT kBufferFrames = 256;
+// A stereo sine that changes by at most 0.016 between two frames
+constexpr double kAmplitude = 0.5;
+constexpr double kOmega = 2 * M_PI * 220.0 / kSampleRate;
+// Gaps or phase jumps when switching between the stretchers change the
+// output by a lot more than the sine itself
+constexpr CSAMPLE kMaxStep = 0.1f;
+// The output after a restart that is not checked for continuity
+constexpr SINT kSettleFrames = 8192;
+// Enough buffers for the quarter second of stable parameters and for
+// warming up the lookahead stretcher
+constexpr int kMaxBuffersUntilLookahead = 400;
+
+// Returns a stereo sine in the direction of the rate
+class ReadAheadManagerSine : public ReadAheadManager {
+  public:
+    ReadAheadManagerSine()
+            : ReadAheadManager(),
+              m_frame(0) {
+    }
+
+    SINT getNextSamples(double dRate, CSAMPLE* buffer, SINT requested_samples) override {
+        const SINT frames = requested_samples / 2;
+        for (SINT i = 0; i < frames; ++i) {
+            buffer[2 * i] = static_cast<CSAMPLE>(kAmplitude * sin(m_frame * kOmega));
+            buffer[2 * i + 1] = static_cast<CSAMPLE>(kAmplitude * cos(m_frame * kOmega));
+            m_frame += dRate < 0 ? -1 : 1;
+        }
+        return 2 * frames;
+    }
+
+    void seek(SINT frame) {
+        m_frame = frame;
+    }
+
+  private:
+    SINT m_frame;
+};
+
+}  // namespace
+
+// The worker is not started. Instead the tests run it synchronously after
+// each audio callback, or not at all for a worker that does not keep up.
+class EngineBufferScaleRubberBandTest : public testing::Test {
+  protected:
+    typedef EngineBufferScaleRubberBand::Mode Mode;
+
+    EngineBufferScaleRubberBandTest()
+            : m_output(2 * kBufferFrames),
+              m_tempo(1.0),
+              m_checkedFrames(0),
+              m_maxStep(0.0f) {
+        m_pScaler = std::make_unique<EngineBufferScaleRubberBand>(
+                &m_readAheadManager, "[Test]");
+        m_pScaler->setSampleRate(mixxx::audio::SampleRate(kSampleRate));
+        m_pScaler->bindWorker(&m_workerScheduler);
+        m_pScaler->m_lookaheadEnabled.store(true);
+        setTempo(1.0);
+        seek(0);
+    }
+
+    Mode mode() const {
+        return m_pScaler->m_mode;
+    }
+
+    void runWorker() {
+        m_pScaler->m_worker.runIteration();
+    }
+
+    void setTempo(double tempo) {
+        m_tempo = tempo;
+        double pitch = 1.0;
+        m_pScaler->setScaleParameters(1.0, &tempo, &pitch);
+    }
+
+    // Like EngineBuffer does
+    void seek(SINT frame) {
+        m_readAheadManager.seek(frame);
+        m_pScaler->clear();
+        m_checkedFrames = -kSettleFrames;
+    }
+
+    // Scales one buffer, which must be complete, and checks that the
+    // output continues the previous buffer
+    void scale() {
+        const double framesRead = m_pScaler->scaleBuffer(
+                m_output.data(), static_cast<SINT>(m_output.size()));
+        EXPECT_DOUBLE_EQ(m_tempo * kBufferFrames, framesRead);
+        for (SINT i = 0; i < kBufferFrames; ++i) {
+            if (m_checkedFrames > 0) {
+                for (int c = 0; c < 2; ++c) {
+                    const CSAMPLE step = std::fabs(m_output[2 * i + c] - m_previous[c]);
+                    if (step > m_maxStep) {
+                        m_maxStep = step;
+                    }
+                }
+            }
+            m_previous[0] = m_output[2 * i];
+            m_previous[1] = m_output[2 * i + 1];
+            ++m_checkedFrames;
+        }
+    }
+
+    void scaleAndRunWorker() {
+        scale();
+        runWorker();
+    }
+
+    // Returns the number of buffers until the lookahead mode has been
+    // reached, which is more than kMaxBuffersUntilLookahead if not
+    int scaleUntilLookahead() {
+        int buffers = 0;
+        while (mode() != Mode::Lookahead && buffers <= kMaxBuffersUntilLookahead) {
+            scaleAndRunWorker();
+            ++buffers;
+        }
+        return buffers;
+    }
+
+    ReadAheadManagerSine m_readAheadManager;
+    EngineWorkerScheduler m_workerScheduler;
+    std::unique_ptr<EngineBufferScaleRubberBand> m_pScaler;
+    std::vector<CSAMPLE> m_output;
+    double m_tempo;
+    CSAMPLE m_previous[2];
+    SINT m_checkedFrames;
+    // The largest change between two output frames
+    CSAMPLE m_maxStep;
+};
+
+TEST_F(EngineBufferScaleRubberBandTest, WarmupSwitchesToLookahead) {
+    bool warmup = false;
+    int buffers = 0;
+    while (mode() != Mode::Lookahead && buffers <= kMaxBuffersUntilLookahead) {
+        scaleAndRunWorker();
+        warmup = warmup || mode() == Mode::Warmup;
+        ++buffers;
+    }
+    EXPECT_TRUE(warmup);
+    ASSERT_EQ(Mode::Lookahead, mode());
+
+    for (int i = 0; i < 100; ++i) {
+        scaleAndRunWorker();
+        EXPECT_EQ(Mode::Lookahead, mode());
+    }
+    EXPECT_LT(m_maxStep, kMaxStep);
+}
+
+TEST_F(EngineBufferScaleRubberBandTest, LateWorkerFallsBackToDirect) {
+    ASSERT_LE(scaleUntilLookahead(), kMaxBuffersUntilLookahead);
+
+    // The output that has been rendered ahead is played until it runs out
+    int buffers = 0;
+    while (mode() == Mode::Lookahead && buffers < 64) {
+        scale();
+        ++buffers;
+    }
+    EXPECT_GT(buffers, 1);
+    EXPECT_EQ(Mode::Direct, mode());
+    for (int i = 0; i < 20; ++i) {
+        scale();
+    }
+    EXPECT_LT(m_maxStep, kMaxStep);
+
+    // Continues ahead after the worker has caught up again
+    EXPECT_LE(scaleUntilLookahead(), kMaxBuffersUntilLookahead);
+    EXPECT_LT(m_maxStep, kMaxStep);
+}
+
+TEST_F(EngineBufferScaleRubberBandTest, ParameterChangeFallsBackToDirect) {
+    ASSERT_LE(scaleUntilLookahead(), kMaxBuffersUntilLookahead);
+
+    // The tempo changes, but the keylocked pitch does not
+    setTempo(1.05);
+    EXPECT_EQ(Mode::Lookahead, mode());
+    scaleAndRunWorker();
+    EXPECT_EQ(Mode::Direct, mode());
+    for (int i = 0; i < 20; ++i) {
+        scaleAndRunWorker();
+        EXPECT_EQ(Mode::Direct, mode());
+    }
+    EXPECT_LT(m_maxStep, kMaxStep);
+
+    EXPECT_LE(scaleUntilLookahead(), kMaxBuffersUntilLookahead);
+    EXPECT_LT(m_maxStep, kMaxStep);
+}
+
+TEST_F(EngineBufferScaleRubberBandTest, ParameterChangeStopsWarmup) {
+    int buffers = 0;
+    while (mode() != Mode::Warmup && buffers <= kMaxBuffersUntilLookahead) {
+        scaleAndRunWorker();
+        ++buffers;
+    }
+    ASSERT_EQ(Mode::Warmup, mode());
+
+    setTempo(0.95);
+    EXPECT_EQ(Mode::Direct, mode());
+    for (int i = 0; i < 20; ++i) {
+        scaleAndRunWorker();
+        EXPECT_EQ(Mode::Direct, mode());
+    }
+    EXPECT_LT(m_maxStep, kMaxStep);
+
+    EXPECT_LE(scaleUntilLookahead(), kMaxBuffersUntilLookahead);
+    EXPECT_LT(m_maxStep, kMaxStep);
+}
+
+TEST_F(EngineBufferScaleRubberBandTest, SeekRestartsDirect) {
+    ASSERT_LE(scaleUntilLookahead(), kMaxBuffersUntilLookahead);
+
+    seek(100000);
+    EXPECT_EQ(Mode::Direct, mode());
+    // The output after the seek starts delayed by the latency, but the
+    // buffers are still complete
+    for (int i = 0; i < 20; ++i) {
+        scaleAndRunWorker();
+        EXPECT_EQ(Mode::Direct, mode());
+    }
+
+    EXPECT_LE(scaleUntilLookahead(), kMaxBuffersUntilLookahead);
+    for (int i = 0; i < 20; ++i) {
+        scaleAndRunWorker();
+    }
+    EXPECT_LT(m_maxStep, kMaxStep);
+}
@@ -5,6 +5,8 @@
 #include <QtDebug>
 #include <QTest>
 
+#include <vector>
+
 #include "mixer/basetrackplayer.h"
 #include "preferences/usersettings.h"
 #include "control/controlobject.h"
@@ -526,3 +528,102 @@ TEST_F(EngineBufferTest, RatePermTest) {
     ControlObject::set(ConfigKey(m_sGroup1, "rate_perm_up_small"), 0);
     EXPECT_EQ(1.06, m_pChannel1->getEngineBuffer()->m_speed_old);
 }
+
+TEST_F(EngineBufferE2ETest, HotcueJumpIsPrefetched) {
+    // Store a hotcue far away from the start of the track
+    ControlObject::set(ConfigKey(m_sGroup1, "playposition"), 0.8);
+    ProcessBuffer();
+    ControlObject::set(ConfigKey(m_sGroup1, "hotcue_1_set"), 1.0);
+    ControlObject::set(ConfigKey(m_sGroup1, "hotcue_1_set"), 0.0);
+    ControlObject::set(ConfigKey(m_sGroup1, "playposition"), 0.0);
+    ControlObject::set(ConfigKey(m_sGroup1, "play"), 1.0);
+
+    // Wait until the reader has prefetched the chunks of the hotcue hint
+    CachingReader* pReader = m_pChannel1->getEngineBuffer()->m_pReader;
+    const SINT hotcueFrame = static_cast<SINT>(
+            ControlObject::get(ConfigKey(m_sGroup1, "hotcue_1_position")) /
+            mixxx::kEngineChannelCount);
+    const auto hotcueChunksReady = [pReader, hotcueFrame] {
+        const SINT firstChunkIndex = CachingReaderChunk::indexForFrame(hotcueFrame);
+        const SINT lastChunkIndex = CachingReaderChunk::indexForFrame(
+                hotcueFrame + Hint::kDefaultFrameCount - 1);
+        for (SINT chunkIndex = firstChunkIndex; chunkIndex <= lastChunkIndex; ++chunkIndex) {
+            const CachingReaderChunkForOwner* pChunk = pReader->lookupChunk(chunkIndex);
+            if (!pChunk || pChunk->getState() != CachingReaderChunkForOwner::READY) {
+                return false;
+            }
+        }
+        return true;
+    };
+    for (int i = 0; i < 5000 && !hotcueChunksReady(); ++i) {
+        ProcessBuffer();
+        QTest::qSleep(1); // millis
+    }
+    ASSERT_TRUE(hotcueChunksReady());
+    const CachingReader::Stats& stats = pReader->stats();
+    const int unavailableReadsAfterSeek = stats.unavailableReadsAfterSeek;
+    const int chunkHits = stats.chunkHits;
+
+    ControlObject::set(ConfigKey(m_sGroup1, "hotcue_1_goto"), 1.0);
+    ProcessBuffer();
+    EXPECT_NEAR(0.8, ControlObject::get(ConfigKey(m_sGroup1, "playposition")), 0.01);
+    EXPECT_EQ(unavailableReadsAfterSeek, stats.unavailableReadsAfterSeek);
+    EXPECT_LT(chunkHits, stats.chunkHits);
+}
+
+TEST_F(EngineBufferE2ETest, ReadsFromPreloadedTrack) {
+    CachingReader* pReader = m_pChannel1->getEngineBuffer()->m_pReader;
+    ControlObject::set(ConfigKey(m_sGroup1, "preload_fully"), 1.0);
+    for (int i = 0; i < 5000 && !pReader->isTrackPreloaded(); ++i) {
+        QTest::qSleep(1); // millis
+    }
+    ASSERT_TRUE(pReader->isTrackPreloaded());
+
+    // Far from the play position, so no chunk has been cached there
+    const mixxx::IndexRange& trackFrames = pReader->m_readableFrameIndexRange;
+    const SINT frame = trackFrames.start() + trackFrames.length() * 3 / 4;
+    const SINT numSamples = CachingReaderChunk::frames2samples(Hint::kDefaultFrameCount);
+    const SINT startSample = CachingReaderChunk::frames2samples(frame);
+    ASSERT_LE(frame + CachingReaderChunk::samples2frames(numSamples), trackFrames.end());
+    const SINT chunkIndex = CachingReaderChunk::indexForFrame(frame);
+    ASSERT_EQ(nullptr, pReader->lookupChunk(chunkIndex));
+
+    std::vector<CSAMPLE> preloaded(numSamples);
+    EXPECT_EQ(CachingReader::ReadResult::AVAILABLE,
+            pReader->read(startSample, numSamples, false, preloaded.data()));
+    std::vector<CSAMPLE> reversed(numSamples);
+    EXPECT_EQ(CachingReader::ReadResult::AVAILABLE,
+            pReader->read(startSample + numSamples, numSamples, true, reversed.data()));
+    for (SINT i = 0; i < numSamples; i += 2) {
+        EXPECT_EQ(preloaded[numSamples - 2 - i], reversed[i]);
+        EXPECT_EQ(preloaded[numSamples - 1 - i], reversed[i + 1]);
+    }
+    // Read without requesting any chunk
+    EXPECT_EQ(nullptr, pReader->lookupChunk(chunkIndex));
+    EXPECT_EQ(0, pReader->stats().unavailableReads);
+
+    // The chunks that are streamed after unloading contain the same samples
+    ControlObject::set(ConfigKey(m_sGroup1, "preload_fully"), 0.0);
+    for (int i = 0; i < 5000 && pReader->isTrackPreloaded(); ++i) {
+        QTest::qSleep(1); // millis
+    }
+    ASSERT_FALSE(pReader->isTrackPreloaded());
+    HintVector hints;
+    Hint hint;
+    hint.frame = frame;
+    hint.frameCount = CachingReaderChunk::samples2frames(numSamples);
+    hint.priority = 1;
+    hints.append(hint);
+    std::vector<CSAMPLE> streamed(numSamples);
+    auto result = CachingReader::ReadResult::UNAVAILABLE;
+    for (int i = 0; i < 5000; ++i) {
+        pReader->hintAndMaybeWake(hints);
+        result = pReader->read(startSample, numSamples, false, streamed.data());
+        if (result != CachingReader::ReadResult::UNAVAILABLE) {
+            break;
+        }
+        QTest::qSleep(1); // millis
+    }
+    EXPECT_EQ(CachingReader::ReadResult::AVAILABLE, result);
+    EXPECT_EQ(preloaded, streamed);
+}
@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+
+#include <QString>
+#include <QTextStream>
+
+#include "engine/enginecallbacktelemetry.h"
+
+namespace {
+
+typedef EngineCallbackTelemetry::Stage Stage;
+
+class EngineCallbackTelemetryTest : public testing::Test {
+  protected:
+    void processCallback(int callbackMicros, int deckMicros, int scalerMicros) {
+        m_telemetry.beginCallback(1024, 44100);
+        m_telemetry.recordChannel(1,
+                mixxx::Duration::fromMicros(deckMicros),
+                mixxx::Duration::fromMicros(scalerMicros));
+        m_telemetry.recordStage(Stage::Channels, mixxx::Duration::fromMicros(deckMicros));
+        m_telemetry.endCallback(mixxx::Duration::fromMicros(callbackMicros));
+    }
+
+    EngineCallbackTelemetry m_telemetry;
+};
+
+TEST_F(EngineCallbackTelemetryTest, Histograms) {
+    for (int i = 0; i < 99; ++i) {
+        processCallback(100, 60, 20);
+    }
+    processCallback(5000, 4000, 3000);
+    EXPECT_EQ(100u, m_telemetry.callbackCount());
+
+    // 100 us are counted in the bucket [64, 128) us
+    const auto callbacks = m_telemetry.histogram(Stage::Callback);
+    EXPECT_EQ(99u, callbacks[7]);
+    EXPECT_EQ(mixxx::Duration::fromMicros(128),
+            EngineCallbackTelemetry::percentile(callbacks, 0.5));
+    EXPECT_EQ(mixxx::Duration::fromMicros(128),
+            EngineCallbackTelemetry::percentile(callbacks, 0.99));
+    EXPECT_EQ(mixxx::Duration::fromMicros(8192),
+            EngineCallbackTelemetry::percentile(callbacks, 1.0));
+
+    // Only the processed channel is counted
+    const auto scaler = m_telemetry.histogram(Stage::Scaler);
+    EXPECT_EQ(99u, scaler[5]);
+    EXPECT_EQ(1u, scaler[12]);
+
+    // Stages that have not been recorded are counted as 0
+    EXPECT_EQ(100u, m_telemetry.histogram(Stage::SideChain)[0]);
+}
+
+TEST_F(EngineCallbackTelemetryTest, WorstCallbacks) {
+    m_telemetry.setChannelGroup(1, "[Channel2]");
+    for (int i = 0; i < 100; ++i) {
+        processCallback(100 + i, 50, 10);
+        // Each of these is slower than the previous ones
+        // and handed over
+        m_telemetry.publish();
+    }
+    processCallback(9000, 8000, 7000);
+    m_telemetry.publish();
+
+    const auto& worst = m_telemetry.worstCallbacks();
+    ASSERT_EQ(static_cast<size_t>(EngineCallbackTelemetry::kWorstCallbackCount),
+            worst.size());
+    EXPECT_EQ(100u, worst[0].sequence);
+    EXPECT_EQ(9000000, worst[0].stageNanos[static_cast<int>(Stage::Callback)]);
+    EXPECT_EQ(8000000, worst[0].engineBufferNanos[1]);
+    EXPECT_EQ(7000000, worst[0].scalerNanos[1]);
+    EXPECT_GT(0, worst[0].engineBufferNanos[0]);
+    EXPECT_EQ(99u, worst[1].sequence);
+    EXPECT_TRUE(m_telemetry.xrunCallbacks().empty());
+
+    QString report;
+    QTextStream stream(&report);
+    m_telemetry.writeReport(&stream);
+    EXPECT_TRUE(report.contains("[Channel2]: 8000.0 us (scaler 7000.0 us)"));
+}
+
+TEST_F(EngineCallbackTelemetryTest, XrunAttribution) {
+    processCallback(100, 50, 10);
+    processCallback(9000, 8000, 7000);
+    // Reported by the sound device after the late callback
+    m_telemetry.xrunHappened();
+    processCallback(100, 50, 10);
+    processCallback(100, 50, 10);
+    m_telemetry.publish();
+
+    EXPECT_EQ(1u, m_telemetry.xrunCount());
+    const auto& xruns = m_telemetry.xrunCallbacks();
+    ASSERT_EQ(2u, xruns.size());
+    EXPECT_EQ(1u, xruns[0].sequence);
+    EXPECT_EQ(8000000, xruns[0].engineBufferNanos[1]);
+    EXPECT_EQ(2u, xruns[1].sequence);
+
+    // The slow callback was handed over before the xrun was reported
+    const auto& worst = m_telemetry.worstCallbacks();
+    ASSERT_FALSE(worst.empty());
+    EXPECT_EQ(1u, worst[0].sequence);
+    EXPECT_TRUE(worst[0].xrun);
+}
+
+} // anonymous namespace
@@ -0,0 +1,227 @@
+#include <benchmark/benchmark.h>
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+#include "effects/builtin/lvmixeqbase.h"
+#include "engine/engine.h"
+#include "engine/filters/enginefilterbessel4.h"
+#include "engine/filters/enginefilterbiquad1.h"
+#include "engine/filters/enginefilteriirbatch.h"
+#include "test/noise.h"
+
+namespace {
+
+constexpr int kSampleRate = 44100;
+constexpr int kBufferSize = 1024;
+
+std::vector<CSAMPLE> swapChannels(const std::vector<CSAMPLE>& samples) {
+    std::vector<CSAMPLE> swapped(samples.size());
+    for (std::size_t i = 0; i < samples.size(); i += 2) {
+        swapped[i] = samples[i + 1];
+        swapped[i + 1] = samples[i];
+    }
+    return swapped;
+}
+
+class EngineFilterIIRTest : public testing::Test {
+  protected:
+    // Both channels are processed at once, but each must be filtered
+    // exactly as if it was on the other side.
+    template<typename Filter>
+    void assertChannelsIndependent(Filter* pFilter, Filter* pSwappedFilter) {
+        const std::vector<CSAMPLE> input = noise(kBufferSize * 8, 42);
+        const std::vector<CSAMPLE> swappedInput = swapChannels(input);
+        std::vector<CSAMPLE> output(input.size());
+        std::vector<CSAMPLE> swappedOutput(input.size());
+
+        for (int offset = 0; offset < static_cast<int>(input.size());
+                offset += kBufferSize) {
+            if (offset == 4 * kBufferSize) {
+                // Cross fade to a fresh start
+                pFilter->pauseFilter();
+                pSwappedFilter->pauseFilter();
+            }
+            pFilter->process(&input[offset], &output[offset], kBufferSize);
+            pSwappedFilter->process(&swappedInput[offset],
+                    &swappedOutput[offset],
+                    kBufferSize);
+        }
+
+        const std::vector<CSAMPLE> expected = swapChannels(swappedOutput);
+        for (std::size_t i = 0; i < output.size(); ++i) {
+            ASSERT_EQ(expected[i], output[i]) << "sample " << i;
+        }
+    }
+};
+
+TEST_F(EngineFilterIIRTest, Bessel4ChannelsAreIndependent) {
+    EngineFilterBessel4Band filter(kSampleRate, 250, 2500);
+    EngineFilterBessel4Band swappedFilter(kSampleRate, 250, 2500);
+    // Cross fade from the coefficients of the constructor
+    filter.setFrequencyCorners(kSampleRate, 300, 3000);
+    swappedFilter.setFrequencyCorners(kSampleRate, 300, 3000);
+    assertChannelsIndependent(&filter, &swappedFilter);
+}
+
+TEST_F(EngineFilterIIRTest, BiquadChannelsAreIndependent) {
+    EngineFilterBiquad1Peaking filter(kSampleRate, 1000, 1.75);
+    EngineFilterBiquad1Peaking swappedFilter(kSampleRate, 1000, 1.75);
+    filter.setFrequencyCorners(kSampleRate, 1000, 1.75, -12);
+    swappedFilter.setFrequencyCorners(kSampleRate, 1000, 1.75, -12);
+    assertChannelsIndependent(&filter, &swappedFilter);
+}
+
+// The same band on eight decks, where one deck uses other corners and one
+// cross fades to new ones. Only the others run as lanes, but all must give
+// the same results as when processed on their own.
+TEST_F(EngineFilterIIRTest, BatchMatchesSeparateFilters) {
+    constexpr int kDecks = 8;
+    std::vector<std::unique_ptr<EngineFilterBessel4Low>> filters;
+    std::vector<std::unique_ptr<EngineFilterBessel4Low>> batchedFilters;
+    for (int deck = 0; deck < kDecks; ++deck) {
+        const double freq = deck == 5 ? 300 : 250;
+        filters.push_back(std::make_unique<EngineFilterBessel4Low>(
+                kSampleRate, freq));
+        batchedFilters.push_back(std::make_unique<EngineFilterBessel4Low>(
+                kSampleRate, freq));
+    }
+    filters[2]->setFrequencyCorners(kSampleRate, 200);
+    batchedFilters[2]->setFrequencyCorners(kSampleRate, 200);
+
+    std::vector<std::vector<CSAMPLE>> input;
+    std::vector<std::vector<CSAMPLE>> output(kDecks);
+    std::vector<std::vector<CSAMPLE>> batchedOutput(kDecks);
+    for (int deck = 0; deck < kDecks; ++deck) {
+        input.push_back(noise(kBufferSize * 4, deck));
+        output[deck].resize(input[deck].size());
+        batchedOutput[deck].resize(input[deck].size());
+    }
+
+    EngineFilterIIRBatch batch;
+    for (int offset = 0; offset < kBufferSize * 4; offset += kBufferSize) {
+        for (int deck = 0; deck < kDecks; ++deck) {
+            filters[deck]->process(&input[deck][offset],
+                    &output[deck][offset],
+                    kBufferSize);
+            ASSERT_TRUE(batch.add(batchedFilters[deck].get(),
+                    &input[deck][offset],
+                    &batchedOutput[deck][offset]));
+        }
+        batch.process(kBufferSize);
+        EXPECT_TRUE(batch.isEmpty());
+    }
+
+    for (int deck = 0; deck < kDecks; ++deck) {
+        for (std::size_t i = 0; i < output[deck].size(); ++i) {
+            ASSERT_EQ(output[deck][i], batchedOutput[deck][i])
+                    << "deck " << deck << " sample " << i;
+        }
+    }
+}
+
+TEST_F(EngineFilterIIRTest, BatchedLVMixEQMatchesUnbatched) {
+    typedef LVMixEQEffectGroupState<EngineFilterBessel4Low> EQState;
+    constexpr int kDecks = 4;
+    const mixxx::EngineParameters bufferParameters(
+            mixxx::audio::SampleRate(kSampleRate), kBufferSize / 2);
+    std::vector<std::unique_ptr<EQState>> states;
+    std::vector<std::unique_ptr<EQState>> batchedStates;
+    std::vector<std::vector<CSAMPLE>> input;
+    for (int deck = 0; deck < kDecks; ++deck) {
+        states.push_back(std::make_unique<EQState>(bufferParameters));
+        batchedStates.push_back(std::make_unique<EQState>(bufferParameters));
+        input.push_back(noise(kBufferSize, deck));
+    }
+    std::vector<CSAMPLE> output(kBufferSize);
+    std::vector<CSAMPLE> batchedOutput(kBufferSize);
+
+    EngineFilterIIRBatch batch;
+    for (int buffer = 0; buffer < 4; ++buffer) {
+        for (int deck = 0; deck < kDecks; ++deck) {
+            batchedStates[deck]->prepareBatch(input[deck].data(),
+                    kBufferSize, kSampleRate, 1.5, 1.0, 0.5, 250, 2500, &batch);
+        }
+        batch.process(kBufferSize);
+        for (int deck = 0; deck < kDecks; ++deck) {
+            states[deck]->processChannel(input[deck].data(), output.data(),
+                    kBufferSize, kSampleRate, 1.5, 1.0, 0.5, 250, 2500);
+            batchedStates[deck]->processChannel(input[deck].data(),
+                    batchedOutput.data(),
+                    kBufferSize, kSampleRate, 1.5, 1.0, 0.5, 250, 2500);
+            for (int i = 0; i < kBufferSize; ++i) {
+                ASSERT_EQ(output[i], batchedOutput[i])
+                        << "buffer " << buffer << " deck " << deck
+                        << " sample " << i;
+            }
+        }
+    }
+}
+
+// The low, band and high filters of the Bessel4 LV-Mix EQ on each deck
+static void BM_EngineFilterBessel4EQ(benchmark::State& state) {
+    const int decks = static_cast<int>(state.range(0));
+    std::vector<std::vector<CSAMPLE>> input;
+    std::vector<std::unique_ptr<EngineFilterIIRBase>> filters;
+    for (int deck = 0; deck < decks; ++deck) {
+        input.push_back(noise(kBufferSize, deck));
+        filters.push_back(std::make_unique<EngineFilterBessel4Low>(
+                kSampleRate, 250));
+        filters.push_back(std::make_unique<EngineFilterBessel4Band>(
+                kSampleRate, 250, 2500));
+        filters.push_back(std::make_unique<EngineFilterBessel4High>(
+                kSampleRate, 2500));
+    }
+    for (const auto& pFilter : filters) {
+        pFilter->assumeSettled();
+    }
+    std::vector<CSAMPLE> output(kBufferSize);
+    while (state.KeepRunning()) {
+        for (std::size_t i = 0; i < filters.size(); ++i) {
+            filters[i]->process(input[i / 3].data(), output.data(), kBufferSize);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * decks * kBufferSize / 2);
+}
+BENCHMARK(BM_EngineFilterBessel4EQ)->Arg(1)->Arg(4)->Arg(8);
+
+// The same filters as above in one batch, like the EQs of all decks in the
+// mixer
+static void BM_EngineFilterBessel4EQBatch(benchmark::State& state) {
+    const int decks = static_cast<int>(state.range(0));
+    std::vector<std::vector<CSAMPLE>> input;
+    std::vector<std::vector<CSAMPLE>> output;
+    std::vector<std::unique_ptr<EngineFilterBessel4Low>> lowFilters;
+    std::vector<std::unique_ptr<EngineFilterBessel4Band>> bandFilters;
+    std::vector<std::unique_ptr<EngineFilterBessel4High>> highFilters;
+    for (int deck = 0; deck < decks; ++deck) {
+        input.push_back(noise(kBufferSize, deck));
+        output.push_back(std::vector<CSAMPLE>(kBufferSize * 3));
+        lowFilters.push_back(std::make_unique<EngineFilterBessel4Low>(
+                kSampleRate, 250));
+        bandFilters.push_back(std::make_unique<EngineFilterBessel4Band>(
+                kSampleRate, 250, 2500));
+        highFilters.push_back(std::make_unique<EngineFilterBessel4High>(
+                kSampleRate, 2500));
+        lowFilters.back()->assumeSettled();
+        bandFilters.back()->assumeSettled();
+        highFilters.back()->assumeSettled();
+    }
+    EngineFilterIIRBatch batch;
+    while (state.KeepRunning()) {
+        for (int deck = 0; deck < decks; ++deck) {
+            batch.add(lowFilters[deck].get(), input[deck].data(),
+                    &output[deck][0]);
+            batch.add(bandFilters[deck].get(), input[deck].data(),
+                    &output[deck][kBufferSize]);
+            batch.add(highFilters[deck].get(), input[deck].data(),
+                    &output[deck][kBufferSize * 2]);
+        }
+        batch.process(kBufferSize);
+    }
+    state.SetItemsProcessed(state.iterations() * decks * kBufferSize / 2);
+}
+BENCHMARK(BM_EngineFilterBessel4EQBatch)->Arg(1)->Arg(4)->Arg(8);
+
+}  // namespace
@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+
+#include <QDir>
+#include <QString>
+#include <QTextStream>
+
+#include <cmath>
+
+#include "engine/enginebuffer.h"
+#include "engine/engineofflinerenderer.h"
+#include "engine/sidechain/sidechainworker.h"
+#include "test/signalpathtest.h"
+#include "util/math.h"
+
+namespace {
+
+// Collects the rendered samples
+class BufferSink : public SideChainWorker {
+  public:
+    void process(const CSAMPLE* pBuffer, const int iBufferSize) override {
+        m_samples.insert(m_samples.end(), pBuffer, pBuffer + iBufferSize);
+    }
+    void shutdown() override {
+    }
+
+    std::vector<CSAMPLE> m_samples;
+};
+
+class EngineOfflineRendererTest : public SignalPathTest {
+};
+
+TEST_F(EngineOfflineRendererTest, ParseTimeline) {
+    QString timeline(
+            "# Start the first deck\n"
+            "0 [Channel1] play 1\n"
+            "\n"
+            "  1.5\t[Master] crossfader  -0.5\n");
+    QTextStream stream(&timeline);
+    std::vector<EngineOfflineRenderer::ControlChange> controlChanges;
+    ASSERT_TRUE(EngineOfflineRenderer::parseTimeline(&stream, &controlChanges));
+    ASSERT_EQ(2u, controlChanges.size());
+    EXPECT_EQ(0.0, controlChanges[0].seconds);
+    EXPECT_EQ(ConfigKey("[Channel1]", "play"), controlChanges[0].key);
+    EXPECT_EQ(1.0, controlChanges[0].value);
+    EXPECT_EQ(1.5, controlChanges[1].seconds);
+    EXPECT_EQ(ConfigKey("[Master]", "crossfader"), controlChanges[1].key);
+    EXPECT_EQ(-0.5, controlChanges[1].value);
+
+    QString invalidTimeline("0 [Channel1] play\n");
+    QTextStream invalidStream(&invalidTimeline);
+    QString errorMessage;
+    EXPECT_FALSE(EngineOfflineRenderer::parseTimeline(
+            &invalidStream, &controlChanges, &errorMessage));
+    EXPECT_TRUE(errorMessage.contains("line 1"));
+}
+
+TEST_F(EngineOfflineRendererTest, PreloadWaitsForPendingLoad) {
+    const QString trackLocation = QDir::currentPath() + "/src/test/sine-30.wav";
+    TrackPointer pTrack(Track::newTemporary(trackLocation));
+    // Not waiting for the load like loadTrack() does
+    m_pMixerDeck2->slotLoadTrack(pTrack, false);
+
+    EngineOfflineRenderer renderer(m_pEngineMaster, config(), 512);
+    ASSERT_TRUE(renderer.preloadTracks(QStringList() << m_sGroup2, 10000));
+    EngineBuffer* pEngineBuffer = m_pChannel2->getEngineBuffer();
+    EXPECT_FALSE(pEngineBuffer->isTrackLoadPending());
+    EXPECT_EQ(pTrack, pEngineBuffer->getLoadedTrack());
+    EXPECT_TRUE(pEngineBuffer->isTrackPreloaded());
+}
+
+TEST_F(EngineOfflineRendererTest, RenderTimeline) {
+    EngineOfflineRenderer renderer(m_pEngineMaster, config(), 512);
+    ASSERT_TRUE(renderer.preloadTracks(QStringList() << m_sGroup1, 10000));
+
+    BufferSink sink;
+    renderer.addSink(&sink);
+    renderer.addControlChange(0.25, ConfigKey(m_sGroup1, "play"), 1.0);
+
+    const double sampleRate = ControlObject::get(ConfigKey("[Master]", "samplerate"));
+    const auto result = renderer.render(0.5);
+    EXPECT_TRUE(result.succeeded);
+    EXPECT_EQ(static_cast<SINT>(0.5 * sampleRate), result.frames);
+    EXPECT_EQ(result.frames, renderer.framesRendered());
+    EXPECT_EQ(static_cast<size_t>(2 * result.frames), sink.m_samples.size());
+    EXPECT_DOUBLE_EQ(1.0, ControlObject::get(ConfigKey(m_sGroup1, "play")));
+
+    // Silent until the deck starts playing
+    const auto startSample = 2 * static_cast<size_t>(0.25 * sampleRate);
+    CSAMPLE maxBefore = 0;
+    CSAMPLE maxAfter = 0;
+    for (size_t i = 0; i < sink.m_samples.size(); ++i) {
+        if (i < startSample - 2 * 512) {
+            maxBefore = math_max(maxBefore, std::abs(sink.m_samples[i]));
+        } else if (i >= startSample + 2 * 512) {
+            maxAfter = math_max(maxAfter, std::abs(sink.m_samples[i]));
+        }
+    }
+    EXPECT_EQ(0.0f, maxBefore);
+    EXPECT_LT(0.0f, maxAfter);
+}
+
+} // anonymous namespace
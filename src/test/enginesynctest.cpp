@@ -2314,3 +2314,41 @@ TEST_F(EngineSyncTest, BpmAdjustFactor) {
     ASSERT_TRUE(isFollower(m_sGroup2));
     ASSERT_TRUE(isSoftMaster(m_sInternalClockGroup));
 }
+
+TEST_F(EngineSyncTest, FollowerStopsAtEndOfTrackOnWorkerPool) {
+    // A follower that stops at the end of the track notifies EngineSync. This
+    // must not happen while the other followers are processed concurrently.
+    m_pEngineMaster->setChannelWorkerThreads(2, false);
+
+    mixxx::BeatsPointer pBeats1 = BeatFactory::makeBeatGrid(*m_pTrack1, 120, 0.0);
+    m_pTrack1->setBeats(pBeats1);
+    mixxx::BeatsPointer pBeats2 = BeatFactory::makeBeatGrid(*m_pTrack2, 128, 0.0);
+    m_pTrack2->setBeats(pBeats2);
+    mixxx::BeatsPointer pBeats3 = BeatFactory::makeBeatGrid(*m_pTrack3, 140, 0.0);
+    m_pTrack3->setBeats(pBeats3);
+
+    ControlObject::set(ConfigKey(m_sGroup1, "sync_mode"), SYNC_MASTER_EXPLICIT);
+    ControlObject::set(ConfigKey(m_sGroup2, "sync_mode"), SYNC_FOLLOWER);
+    ControlObject::set(ConfigKey(m_sGroup3, "sync_mode"), SYNC_FOLLOWER);
+    ControlObject::set(ConfigKey(m_sGroup1, "play"), 1.0);
+    ControlObject::set(ConfigKey(m_sGroup2, "play"), 1.0);
+    ControlObject::set(ConfigKey(m_sGroup3, "play"), 1.0);
+    ProcessBuffer();
+
+    ASSERT_TRUE(isExplicitMaster(m_sGroup1));
+    ASSERT_TRUE(isFollower(m_sGroup2));
+    ASSERT_TRUE(isFollower(m_sGroup3));
+
+    ControlObject::set(ConfigKey(m_sGroup2, "playposition"), 1.0);
+    ProcessBuffer();
+    ProcessBuffer();
+
+    EXPECT_EQ(0.0, ControlObject::get(ConfigKey(m_sGroup2, "play")));
+    EXPECT_EQ(1.0, ControlObject::get(ConfigKey(m_sGroup1, "play")));
+    EXPECT_EQ(1.0, ControlObject::get(ConfigKey(m_sGroup3, "play")));
+    ASSERT_TRUE(isExplicitMaster(m_sGroup1));
+    ASSERT_TRUE(isFollower(m_sGroup2));
+    ASSERT_TRUE(isFollower(m_sGroup3));
+    EXPECT_FLOAT_EQ(120.0, ControlObject::get(ConfigKey(m_sGroup2, "bpm")));
+    EXPECT_FLOAT_EQ(120.0, ControlObject::get(ConfigKey(m_sGroup3, "bpm")));
+}
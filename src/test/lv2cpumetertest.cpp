@@ -0,0 +1,48 @@
+#include <gtest/gtest.h>
+
+#include "effects/lv2/lv2cpumeter.h"
+
+namespace {
+
+constexpr SINT kSampleRate = 48000;
+// 10 ms of audio
+constexpr SINT kFrames = 480;
+constexpr qint64 kBufferNanos = 10000000;
+
+TEST(LV2CpuMeterTest, NoLoadBeforeFirstBuffer) {
+    LV2CpuMeter meter;
+    EXPECT_FALSE(meter.hasLoad());
+    EXPECT_DOUBLE_EQ(0.0, meter.averageLoad());
+    EXPECT_DOUBLE_EQ(0.0, meter.peakLoad());
+}
+
+TEST(LV2CpuMeterTest, InvalidBuffersAreIgnored) {
+    LV2CpuMeter meter;
+    meter.addBuffer(kBufferNanos, 0, kSampleRate);
+    meter.addBuffer(kBufferNanos, kFrames, 0);
+    EXPECT_FALSE(meter.hasLoad());
+}
+
+TEST(LV2CpuMeterTest, AverageAndPeakLoad) {
+    LV2CpuMeter meter;
+    meter.addBuffer(kBufferNanos / 10, kFrames, kSampleRate);
+    EXPECT_TRUE(meter.hasLoad());
+    EXPECT_DOUBLE_EQ(0.1, meter.averageLoad());
+    EXPECT_DOUBLE_EQ(0.1, meter.peakLoad());
+
+    meter.addBuffer(kBufferNanos / 2, kFrames, kSampleRate);
+    meter.addBuffer(kBufferNanos / 5, kFrames, kSampleRate);
+    EXPECT_NEAR(0.8 / 3, meter.averageLoad(), 1e-9);
+    EXPECT_DOUBLE_EQ(0.5, meter.peakLoad());
+}
+
+TEST(LV2CpuMeterTest, AverageIsWeightedByBufferLength) {
+    LV2CpuMeter meter;
+    // A long buffer with a low load and a short one at full load
+    meter.addBuffer(kBufferNanos, 4 * kFrames, kSampleRate);
+    meter.addBuffer(kBufferNanos, kFrames, kSampleRate);
+    EXPECT_DOUBLE_EQ(0.4, meter.averageLoad());
+    EXPECT_DOUBLE_EQ(1.0, meter.peakLoad());
+}
+
+} // namespace
@@ -0,0 +1,93 @@
+#ifdef __LILV__
+
+#include <gtest/gtest.h>
+
+#include <QByteArray>
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "effects/lv2/lv2hostfeatures.h"
+
+namespace {
+
+const char* kUri1 = "http://example.org/test#one";
+const char* kUri2 = "http://example.org/test#two";
+
+TEST(LV2HostFeaturesTest, MapIsStable) {
+    LV2HostFeatures features;
+    const LV2_URID urid1 = features.map(kUri1);
+    const LV2_URID urid2 = features.map(kUri2);
+    // 0 is not a valid URID
+    EXPECT_NE(0u, urid1);
+    EXPECT_NE(0u, urid2);
+    EXPECT_NE(urid1, urid2);
+    EXPECT_EQ(urid1, features.map(kUri1));
+    // Equal strings at a different address
+    const QByteArray copy(kUri2);
+    EXPECT_EQ(urid2, features.map(copy.constData()));
+}
+
+TEST(LV2HostFeaturesTest, UnmapRoundTrip) {
+    LV2HostFeatures features;
+    const LV2_URID urid1 = features.map(kUri1);
+    const LV2_URID urid2 = features.map(kUri2);
+    EXPECT_STREQ(kUri1, features.unmap(urid1));
+    EXPECT_STREQ(kUri2, features.unmap(urid2));
+
+    EXPECT_EQ(nullptr, features.unmap(0));
+    EXPECT_EQ(nullptr, features.unmap(urid2 + 1));
+}
+
+TEST(LV2HostFeaturesTest, UnmappedUriStaysValid) {
+    LV2HostFeatures features;
+    const char* pUri = features.unmap(features.map(kUri1));
+    ASSERT_NE(nullptr, pUri);
+    for (int i = 0; i < 1000; ++i) {
+        features.map(QByteArray("http://example.org/test#").append(
+                QByteArray::number(i)).constData());
+    }
+    EXPECT_STREQ(kUri1, pUri);
+    EXPECT_EQ(pUri, features.unmap(features.map(kUri1)));
+}
+
+TEST(LV2HostFeaturesTest, MapThroughFeatures) {
+    LV2HostFeatures features;
+    LV2_URID_Map* pMap = features.uridMap();
+    LV2_URID_Unmap* pUnmap = features.uridUnmap();
+    const LV2_URID urid = pMap->map(pMap->handle, kUri1);
+    EXPECT_EQ(features.map(kUri1), urid);
+    EXPECT_STREQ(kUri1, pUnmap->unmap(pUnmap->handle, urid));
+}
+
+TEST(LV2HostFeaturesTest, ConcurrentMap) {
+    LV2HostFeatures features;
+    constexpr int kUriCount = 200;
+    std::vector<QByteArray> uris;
+    for (int i = 0; i < kUriCount; ++i) {
+        uris.push_back(QByteArray("http://example.org/test#").append(
+                QByteArray::number(i)));
+    }
+    // Plugins map URIs while being instantiated and from their worker
+    std::vector<LV2_URID> urids1(kUriCount);
+    std::vector<LV2_URID> urids2(kUriCount);
+    std::thread thread([&features, &uris, &urids2] {
+        for (int i = kUriCount - 1; i >= 0; --i) {
+            urids2[i] = features.map(uris[i].constData());
+        }
+    });
+    for (int i = 0; i < kUriCount; ++i) {
+        urids1[i] = features.map(uris[i].constData());
+    }
+    thread.join();
+
+    EXPECT_EQ(urids1, urids2);
+    for (int i = 0; i < kUriCount; ++i) {
+        EXPECT_STREQ(uris[i].constData(), features.unmap(urids1[i]));
+    }
+}
+
+} // anonymous namespace
+
+#endif // __LILV__
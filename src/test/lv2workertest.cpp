@@ -0,0 +1,216 @@
+#ifdef __LILV__
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "effects/lv2/lv2worker.h"
+
+namespace {
+
+// A FIFO of 64 bytes, so the messages wrap around after a few writes
+constexpr int kSmallFifoSize = 64;
+constexpr int kHeaderSize = sizeof(uint32_t);
+
+} // anonymous namespace
+
+class LV2WorkerTest : public testing::Test {
+  protected:
+    static LV2_Worker_Status write(FIFO<char>* pFifo, const std::string& message) {
+        return LV2Worker::writeMessage(pFifo,
+                static_cast<uint32_t>(message.size()),
+                message.data());
+    }
+
+    // Returns the next message or "<none>"
+    static std::string read(FIFO<char>* pFifo, std::vector<char>* pBuffer) {
+        uint32_t size;
+        if (!LV2Worker::readMessage(pFifo, pBuffer, &size)) {
+            return "<none>";
+        }
+        return std::string(pBuffer->data(), size);
+    }
+
+    static int fifoSize() {
+        return LV2Worker::kFifoSize;
+    }
+
+    static bool hasFifos(const LV2Worker& worker) {
+        return worker.m_pRequests && worker.m_pResponses;
+    }
+};
+
+namespace {
+
+// A plugin without any state that answers each request with the same
+// message, for testing the worker without a plugin library
+class FakePlugin {
+  public:
+    explicit FakePlugin(bool hasWorkerInterface) {
+        std::memset(&m_descriptor, 0, sizeof(m_descriptor));
+        m_descriptor.extension_data = hasWorkerInterface
+                ? &FakePlugin::workerExtensionData
+                : &FakePlugin::noExtensionData;
+        m_instance.lv2_descriptor = &m_descriptor;
+        m_instance.lv2_handle = this;
+        m_instance.pimpl = nullptr;
+    }
+
+    LilvInstance* instance() {
+        return &m_instance;
+    }
+
+    std::vector<std::string> responses;
+
+  private:
+    static const void* workerExtensionData(const char* uri) {
+        return std::strcmp(uri, LV2_WORKER__interface) == 0 ? &s_interface : nullptr;
+    }
+    static const void* noExtensionData(const char* uri) {
+        Q_UNUSED(uri);
+        return nullptr;
+    }
+
+    static LV2_Worker_Status work(LV2_Handle instance,
+            LV2_Worker_Respond_Function respond,
+            LV2_Worker_Respond_Handle handle,
+            uint32_t size,
+            const void* data) {
+        Q_UNUSED(instance);
+        return respond(handle, size, data);
+    }
+    static LV2_Worker_Status workResponse(LV2_Handle instance,
+            uint32_t size,
+            const void* body) {
+        static_cast<FakePlugin*>(instance)->responses.push_back(
+                std::string(static_cast<const char*>(body), size));
+        return LV2_WORKER_SUCCESS;
+    }
+
+    static const LV2_Worker_Interface s_interface;
+
+    LV2_Descriptor m_descriptor;
+    LilvInstance m_instance;
+};
+
+const LV2_Worker_Interface FakePlugin::s_interface = {
+        &FakePlugin::work,
+        &FakePlugin::workResponse,
+        nullptr};
+
+} // anonymous namespace
+
+TEST_F(LV2WorkerTest, ReadWrittenMessages) {
+    FIFO<char> fifo(kSmallFifoSize);
+    std::vector<char> buffer(kSmallFifoSize);
+    EXPECT_EQ("<none>", read(&fifo, &buffer));
+
+    EXPECT_EQ(LV2_WORKER_SUCCESS, write(&fifo, "first"));
+    EXPECT_EQ(LV2_WORKER_SUCCESS, write(&fifo, ""));
+    EXPECT_EQ(LV2_WORKER_SUCCESS, write(&fifo, "third"));
+    EXPECT_EQ(3 * kHeaderSize + 10, fifo.readAvailable());
+
+    EXPECT_EQ("first", read(&fifo, &buffer));
+    EXPECT_EQ("", read(&fifo, &buffer));
+    EXPECT_EQ("third", read(&fifo, &buffer));
+    EXPECT_EQ("<none>", read(&fifo, &buffer));
+}
+
+TEST_F(LV2WorkerTest, DataWrapsAround) {
+    FIFO<char> fifo(kSmallFifoSize);
+    std::vector<char> buffer(kSmallFifoSize);
+    // Moves the indices to 40
+    const std::string first(40 - kHeaderSize, 'a');
+    ASSERT_EQ(LV2_WORKER_SUCCESS, write(&fifo, first));
+    ASSERT_EQ(first, read(&fifo, &buffer));
+
+    // The header fits before the end, the data continues at the start
+    const std::string second = "0123456789abcdefghijklmnopqrstuvwxyz";
+    EXPECT_EQ(LV2_WORKER_SUCCESS, write(&fifo, second));
+    EXPECT_EQ(second, read(&fifo, &buffer));
+}
+
+TEST_F(LV2WorkerTest, HeaderSplitAcrossRegions) {
+    FIFO<char> fifo(kSmallFifoSize);
+    std::vector<char> buffer(kSmallFifoSize);
+    // Moves the indices to 2 bytes before the end
+    const std::string first(kSmallFifoSize - 2 - kHeaderSize, 'a');
+    ASSERT_EQ(LV2_WORKER_SUCCESS, write(&fifo, first));
+    ASSERT_EQ(first, read(&fifo, &buffer));
+
+    // The first 2 bytes of the header are at the end, the rest of the
+    // header and the data at the start
+    EXPECT_EQ(LV2_WORKER_SUCCESS, write(&fifo, "split"));
+    EXPECT_EQ(LV2_WORKER_SUCCESS, write(&fifo, "after"));
+    EXPECT_EQ("split", read(&fifo, &buffer));
+    EXPECT_EQ("after", read(&fifo, &buffer));
+}
+
+TEST_F(LV2WorkerTest, NoSpace) {
+    FIFO<char> fifo(kSmallFifoSize);
+    std::vector<char> buffer(kSmallFifoSize);
+    const std::string message(kSmallFifoSize / 2 - kHeaderSize, 'a');
+    EXPECT_EQ(LV2_WORKER_SUCCESS, write(&fifo, message));
+    EXPECT_EQ(LV2_WORKER_SUCCESS, write(&fifo, message));
+    // Neither the header nor a part of the message is written
+    EXPECT_EQ(LV2_WORKER_ERR_NO_SPACE, write(&fifo, ""));
+    EXPECT_EQ(kSmallFifoSize, fifo.readAvailable());
+
+    EXPECT_EQ(message, read(&fifo, &buffer));
+    EXPECT_EQ(message, read(&fifo, &buffer));
+    EXPECT_EQ("<none>", read(&fifo, &buffer));
+
+    // Larger than any FIFO of a worker
+    const std::vector<char> oversized(fifoSize() + 1);
+    EXPECT_EQ(LV2_WORKER_ERR_NO_SPACE,
+            LV2Worker::writeMessage(&fifo,
+                    static_cast<uint32_t>(oversized.size()),
+                    oversized.data()));
+    EXPECT_EQ(0, fifo.readAvailable());
+}
+
+TEST_F(LV2WorkerTest, OversizedMessageIsFlushed) {
+    FIFO<char> fifo(kSmallFifoSize);
+    std::vector<char> smallBuffer(8);
+    EXPECT_EQ(LV2_WORKER_SUCCESS, write(&fifo, "does not fit"));
+    EXPECT_EQ(LV2_WORKER_SUCCESS, write(&fifo, "fits"));
+
+    // The message that does not fit is dropped, and the next one is
+    // read instead
+    EXPECT_EQ("fits", read(&fifo, &smallBuffer));
+    EXPECT_EQ(0, fifo.readAvailable());
+}
+
+TEST_F(LV2WorkerTest, FifosOnlyForWorkerInterface) {
+    LV2WorkerThread thread;
+    LV2Worker worker(&thread);
+    EXPECT_FALSE(hasFifos(worker));
+    const char data[] = "work";
+    EXPECT_EQ(LV2_WORKER_ERR_UNKNOWN,
+            worker.schedule()->schedule_work(
+                    worker.schedule()->handle, sizeof(data), data));
+
+    FakePlugin pluginWithoutWorker(false);
+    worker.setInstance(pluginWithoutWorker.instance());
+    EXPECT_FALSE(hasFifos(worker));
+    worker.setInstance(nullptr);
+
+    FakePlugin plugin(true);
+    worker.setInstance(plugin.instance());
+    EXPECT_TRUE(hasFifos(worker));
+
+    // The worker thread is not started, the work is run here
+    EXPECT_EQ(LV2_WORKER_SUCCESS,
+            worker.schedule()->schedule_work(
+                    worker.schedule()->handle, sizeof(data), data));
+    worker.work();
+    worker.deliverResponses();
+    ASSERT_EQ(1u, plugin.responses.size());
+    EXPECT_EQ(std::string(data, sizeof(data)), plugin.responses.front());
+
+    worker.setInstance(nullptr);
+}
+
+#endif // __LILV__
@@ -7,7 +7,9 @@
 #include "effects/builtin/autopaneffect.h"
 #include "effects/builtin/bessel4lvmixeqeffect.h"
 #include "effects/builtin/bessel8lvmixeqeffect.h"
+#include "effects/builtin/biquadfullkilleqeffect.h"
 #include "effects/builtin/bitcrushereffect.h"
+#include "effects/builtin/convolutionreverbeffect.h"
 #include "effects/builtin/echoeffect.h"
 #include "effects/builtin/filtereffect.h"
 #include "effects/builtin/flangereffect.h"
@@ -18,6 +20,7 @@
 #include "effects/builtin/reverbeffect.h"
 #include "engine/channelhandle.h"
 #include "engine/effects/groupfeaturestate.h"
+#include "engine/filters/enginefilteriirbatch.h"
 #include "test/baseeffecttest.h"
 #include "util/samplebuffer.h"
 
@@ -32,18 +35,23 @@ class EffectsBenchmarkTest : public BaseEffectTest {
 
 template <class EffectType>
 void benchmarkBuiltInEffectDefaultParameters(const mixxx::EngineParameters& bufferParameters,
+                                            int decks,
                                             benchmark::State* pState, EffectsManager* pEffectsManager) {
     EffectManifestPointer pManifest = EffectType::getManifest();
 
     ChannelHandleFactory factory;
     QSet<ChannelHandleAndGroup> activeInputChannels;
 
-    QString channel1_group = QString("[Channel1]");
-    ChannelHandle channel1 = factory.getOrCreateHandle(channel1_group);
-    ChannelHandleAndGroup handle_and_group(channel1, channel1_group);
-    pEffectsManager->registerInputChannel(handle_and_group);
-    pEffectsManager->registerOutputChannel(handle_and_group);
-    activeInputChannels.insert(handle_and_group);
+    QList<ChannelHandle> channels;
+    for (int i = 1; i <= decks; ++i) {
+        QString group = QString("[Channel%1]").arg(i);
+        ChannelHandle channel = factory.getOrCreateHandle(group);
+        ChannelHandleAndGroup handle_and_group(channel, group);
+        pEffectsManager->registerInputChannel(handle_and_group);
+        pEffectsManager->registerOutputChannel(handle_and_group);
+        activeInputChannels.insert(handle_and_group);
+        channels.append(channel);
+    }
     EffectInstantiatorPointer pInstantiator = EffectInstantiatorPointer(
         new EffectProcessorInstantiator<EffectType>());
     EngineEffect effect(pManifest, activeInputChannels, pEffectsManager, pInstantiator);
@@ -54,16 +62,32 @@ void benchmarkBuiltInEffectDefaultParameters(const mixxx::EngineParameters& buff
     mixxx::SampleBuffer input(bufferParameters.samplesPerBuffer());
     mixxx::SampleBuffer output(bufferParameters.samplesPerBuffer());
 
+    EngineFilterIIRBatch batch;
+
     while (pState->KeepRunning()) {
-        effect.process(channel1, channel1, input.data(), output.data(),
-                       bufferParameters.samplesPerBuffer(),
-                       bufferParameters.sampleRate(),
-                       enableState, featureState);
+        // Each deck has its own state, like the EQ of each deck in the mixer,
+        // and the filters of all decks run in one batch
+        for (const ChannelHandle& channel : channels) {
+            effect.prepareBatch(channel, channel, input.data(),
+                                bufferParameters.samplesPerBuffer(),
+                                bufferParameters.sampleRate(),
+                                enableState, &batch);
+        }
+        batch.process(bufferParameters.samplesPerBuffer());
+        for (const ChannelHandle& channel : channels) {
+            effect.process(channel, channel, input.data(), output.data(),
+                           bufferParameters.samplesPerBuffer(),
+                           bufferParameters.sampleRate(),
+                           enableState, featureState);
+        }
     }
 }
 
 #define FOR_COMMON_BUFFER_SIZES(bm) bm->Arg(32)->Arg(64)->Arg(128)->Arg(256)->Arg(512)->Arg(1024)->Arg(2048)->Arg(4096);
 
+// The buffer size and the number of decks
+#define FOR_COMMON_DECK_COUNTS(bm) bm->ArgPair(1024, 1)->ArgPair(1024, 4)->ArgPair(1024, 8);
+
 #define DECLARE_EFFECT_BENCHMARK(EffectName)                           \
 TEST_F(EffectsBenchmarkTest, BM_BuiltInEffects_DefaultParameters_##EffectName) { \
     ControlPotmeter loEqFrequency(                                     \
@@ -76,13 +100,30 @@ TEST_F(EffectsBenchmarkTest, BM_BuiltInEffects_DefaultParameters_##EffectName) {
         mixxx::audio::SampleRate(44100),                         \
         state.range_x());                                              \
     benchmarkBuiltInEffectDefaultParameters<EffectName>(                \
-        bufferParameters, &state, m_pEffectsManager);                                     \
+        bufferParameters, 1, &state, m_pEffectsManager);                                     \
 }                                                                      \
 FOR_COMMON_BUFFER_SIZES(BENCHMARK(BM_BuiltInEffects_DefaultParameters_##EffectName));
 
+#define DECLARE_DECKS_EFFECT_BENCHMARK(EffectName)                     \
+TEST_F(EffectsBenchmarkTest, BM_BuiltInEffects_Decks_##EffectName) {   \
+    ControlPotmeter loEqFrequency(                                     \
+        ConfigKey("[Mixer Profile]", "LoEQFrequency"), 0., 22040);     \
+    loEqFrequency.setDefaultValue(250.0);                              \
+    ControlPotmeter hiEqFrequency(                                     \
+        ConfigKey("[Mixer Profile]", "HiEQFrequency"), 0., 22040);     \
+    hiEqFrequency.setDefaultValue(2500.0);                             \
+    mixxx::EngineParameters bufferParameters(                          \
+        mixxx::audio::SampleRate(44100),                         \
+        state.range_x());                                              \
+    benchmarkBuiltInEffectDefaultParameters<EffectName>(                \
+        bufferParameters, state.range_y(), &state, m_pEffectsManager); \
+}                                                                      \
+FOR_COMMON_DECK_COUNTS(BENCHMARK(BM_BuiltInEffects_Decks_##EffectName));
+
 DECLARE_EFFECT_BENCHMARK(Bessel4LVMixEQEffect)
 DECLARE_EFFECT_BENCHMARK(Bessel8LVMixEQEffect)
 DECLARE_EFFECT_BENCHMARK(BitCrusherEffect)
+DECLARE_EFFECT_BENCHMARK(ConvolutionReverbEffect)
 DECLARE_EFFECT_BENCHMARK(EchoEffect)
 DECLARE_EFFECT_BENCHMARK(FilterEffect)
 DECLARE_EFFECT_BENCHMARK(FlangerEffect)
@@ -92,5 +133,10 @@ DECLARE_EFFECT_BENCHMARK(MoogLadder4FilterEffect)
 DECLARE_EFFECT_BENCHMARK(PhaserEffect)
 DECLARE_EFFECT_BENCHMARK(ReverbEffect)
 
+DECLARE_DECKS_EFFECT_BENCHMARK(Bessel4LVMixEQEffect)
+DECLARE_DECKS_EFFECT_BENCHMARK(BiquadFullKillEQEffect)
+DECLARE_DECKS_EFFECT_BENCHMARK(FilterEffect)
+DECLARE_DECKS_EFFECT_BENCHMARK(LinkwitzRiley8EQEffect)
+
 }  // namespace
 #endif
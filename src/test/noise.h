@@ -0,0 +1,23 @@
+#ifndef TEST_NOISE_H
+#define TEST_NOISE_H
+
+#include <random>
+#include <vector>
+
+#include "util/types.h"
+
+// Uniform white noise in [-amplitude, amplitude]. The same seed always gives
+// the same samples, so tests can compare against a reference.
+inline std::vector<CSAMPLE> noise(int size,
+        unsigned int seed = 42,
+        CSAMPLE amplitude = 1.0f) {
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<CSAMPLE> distribution(-amplitude, amplitude);
+    std::vector<CSAMPLE> samples(size);
+    for (auto& sample : samples) {
+        sample = distribution(generator);
+    }
+    return samples;
+}
+
+#endif // TEST_NOISE_H
@@ -0,0 +1,146 @@
+#include <benchmark/benchmark.h>
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+#include "engine/filters/partitionedconvolution.h"
+#include "test/noise.h"
+#include "util/math.h"
+
+namespace {
+
+constexpr SINT kChannelCount = 2;
+constexpr SINT kSampleRate = 44100;
+constexpr SINT kBufferFrames = 1024;
+
+std::vector<double> convolveDirectly(const std::vector<CSAMPLE>& input,
+        const std::vector<CSAMPLE>& impulseResponse) {
+    const SINT frames = static_cast<SINT>(input.size()) / kChannelCount;
+    const SINT taps = static_cast<SINT>(impulseResponse.size()) / kChannelCount;
+    std::vector<double> output(input.size());
+    for (SINT frame = 0; frame < frames; ++frame) {
+        for (SINT channel = 0; channel < kChannelCount; ++channel) {
+            double sum = 0;
+            for (SINT tap = 0; tap < taps && tap <= frame; ++tap) {
+                sum += static_cast<double>(impulseResponse[kChannelCount * tap + channel]) *
+                        input[kChannelCount * (frame - tap) + channel];
+            }
+            output[kChannelCount * frame + channel] = sum;
+        }
+    }
+    return output;
+}
+
+class PartitionedConvolutionTest : public testing::Test {
+  protected:
+    // Processes the input in place in buffers of varying sizes, switching
+    // to pSwitchKernel at switchFrame
+    std::vector<CSAMPLE> process(PartitionedConvolver* pConvolver,
+            const std::vector<CSAMPLE>& input,
+            const PartitionedConvolutionKernel* pSwitchKernel = nullptr,
+            SINT switchFrame = 0) {
+        std::vector<CSAMPLE> output(input);
+        const SINT frames = static_cast<SINT>(input.size()) / kChannelCount;
+        std::mt19937 generator(7);
+        SINT frame = 0;
+        while (frame < frames) {
+            if (pSwitchKernel && frame >= switchFrame) {
+                pConvolver->setKernel(pSwitchKernel);
+                pSwitchKernel = nullptr;
+            }
+            SINT bufferFrames = std::min<SINT>(
+                    frames - frame, generator() % kBufferFrames + 1);
+            if (pSwitchKernel) {
+                bufferFrames = std::min(bufferFrames, switchFrame - frame);
+            }
+            pConvolver->process(&output[kChannelCount * frame],
+                    &output[kChannelCount * frame],
+                    bufferFrames);
+            frame += bufferFrames;
+        }
+        return output;
+    }
+};
+
+TEST_F(PartitionedConvolutionTest, MatchesDirectConvolution) {
+    const std::vector<CSAMPLE> input = noise(kChannelCount * 16384, 1, 1.0f);
+    // Only direct taps, a partial short partition, a partial long partition
+    for (SINT taps : {1, 100, 129, 1025, 5000}) {
+        const std::vector<CSAMPLE> impulseResponse = noise(kChannelCount * taps, taps, 0.05f);
+        PartitionedConvolutionKernel kernel(
+                impulseResponse.data(), taps, kSampleRate);
+        PartitionedConvolver convolver;
+        convolver.setKernel(&kernel);
+        convolver.clear();
+
+        const std::vector<CSAMPLE> output = process(&convolver, input);
+        const std::vector<double> expected = convolveDirectly(input, impulseResponse);
+        for (std::size_t i = 0; i < output.size(); ++i) {
+            ASSERT_NEAR(expected[i], output[i], 1e-5) << "taps " << taps << " sample " << i;
+        }
+    }
+}
+
+TEST_F(PartitionedConvolutionTest, KernelsAreCrossfaded) {
+    const SINT kLongBlockFrames = PartitionedConvolutionKernel::kLongBlockFrames;
+    const std::vector<CSAMPLE> input = noise(kChannelCount * 8 * kLongBlockFrames, 1, 1.0f);
+    const std::vector<CSAMPLE> impulseResponse1 = noise(kChannelCount * 3000, 2, 0.05f);
+    const std::vector<CSAMPLE> impulseResponse2 = noise(kChannelCount * 2000, 3, 0.05f);
+    PartitionedConvolutionKernel kernel1(impulseResponse1.data(), 3000, kSampleRate);
+    PartitionedConvolutionKernel kernel2(impulseResponse2.data(), 2000, kSampleRate);
+    PartitionedConvolver convolver;
+    convolver.setKernel(&kernel1);
+    convolver.clear();
+
+    // The crossfade starts at the next long block boundary
+    const std::vector<CSAMPLE> output = process(
+            &convolver, input, &kernel2, 3 * kLongBlockFrames + 100);
+    const std::vector<double> expected1 = convolveDirectly(input, impulseResponse1);
+    const std::vector<double> expected2 = convolveDirectly(input, impulseResponse2);
+    const SINT fadeStart = 4 * kLongBlockFrames;
+    for (std::size_t i = 0; i < output.size(); ++i) {
+        const SINT frame = static_cast<SINT>(i) / kChannelCount;
+        const double gain = math_clamp(
+                static_cast<double>(frame - fadeStart) / kLongBlockFrames, 0.0, 1.0);
+        const double expected = expected1[i] + (expected2[i] - expected1[i]) * gain;
+        ASSERT_NEAR(expected, output[i], 1e-5) << "sample " << i;
+    }
+}
+
+TEST_F(PartitionedConvolutionTest, RetiredKernelsAreDropped) {
+    const std::vector<CSAMPLE> input = noise(kChannelCount * kBufferFrames, 1, 1.0f);
+    const std::vector<CSAMPLE> impulseResponse = noise(kChannelCount * 3000, 2, 0.05f);
+    PartitionedConvolutionKernel kernel(impulseResponse.data(), 3000, kSampleRate);
+    PartitionedConvolver convolver;
+    convolver.setKernel(&kernel);
+    convolver.clear();
+    process(&convolver, input);
+
+    convolver.retainKernels(nullptr, nullptr);
+    for (const CSAMPLE sample : process(&convolver, input)) {
+        ASSERT_EQ(0.0f, sample);
+    }
+}
+
+static void BM_PartitionedConvolver(benchmark::State& state) {
+    const SINT taps = static_cast<SINT>(state.range(0));
+    const std::vector<CSAMPLE> impulseResponse = noise(kChannelCount * taps, 2, 0.05f);
+    PartitionedConvolutionKernel kernel(impulseResponse.data(), taps, kSampleRate);
+    PartitionedConvolver convolver;
+    convolver.setKernel(&kernel);
+    convolver.clear();
+
+    const std::vector<CSAMPLE> input = noise(kChannelCount * kBufferFrames, 1, 1.0f);
+    std::vector<CSAMPLE> output(input.size());
+    while (state.KeepRunning()) {
+        convolver.process(input.data(), output.data(), kBufferFrames);
+    }
+    state.SetItemsProcessed(state.iterations() * kBufferFrames);
+}
+BENCHMARK(BM_PartitionedConvolver)
+        ->Arg(PartitionedConvolutionKernel::kLongBlockFrames)
+        ->Arg(kSampleRate)
+        ->Arg(PartitionedConvolutionKernel::kMaxFrames);
+
+}  // namespace
@@ -0,0 +1,157 @@
+#include <gtest/gtest.h>
+
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QThread>
+
+#include "sources/pcmcache.h"
+#include "test/mixxxtest.h"
+
+namespace {
+
+constexpr SINT kFrameCount = 20000;
+
+// A stereo ramp whose samples encode their frame index
+class RampAudioSource : public mixxx::AudioSource {
+  public:
+    RampAudioSource()
+            : AudioSource(QUrl("test:ramp")) {
+    }
+
+    void close() override {
+    }
+
+  protected:
+    mixxx::ReadableSampleFrames readSampleFramesClamped(
+            mixxx::WritableSampleFrames writableSampleFrames) override {
+        const auto frameIndexRange = writableSampleFrames.frameIndexRange();
+        CSAMPLE* pSample = writableSampleFrames.writableData();
+        for (SINT i = frameIndexRange.start(); i < frameIndexRange.end(); ++i) {
+            *pSample++ = static_cast<CSAMPLE>(i);
+            *pSample++ = -static_cast<CSAMPLE>(i);
+        }
+        return mixxx::ReadableSampleFrames(
+                frameIndexRange,
+                mixxx::SampleBuffer::ReadableSlice(
+                        writableSampleFrames.writableData(),
+                        getSignalInfo().frames2samples(frameIndexRange.length())));
+    }
+
+  private:
+    OpenResult tryOpen(
+            OpenMode /*mode*/,
+            const OpenParams& /*params*/) override {
+        initChannelCountOnce(2);
+        initSampleRateOnce(44100);
+        initFrameIndexRangeOnce(mixxx::IndexRange::forward(0, kFrameCount));
+        return OpenResult::Succeeded;
+    }
+};
+
+class PcmCacheTest : public MixxxTest {
+  protected:
+    static mixxx::AudioSourcePointer openRamp() {
+        auto pAudioSource = std::make_shared<RampAudioSource>();
+        pAudioSource->open(mixxx::AudioSource::OpenMode::Strict);
+        return pAudioSource;
+    }
+
+    static bool writeEntry(mixxx::PcmCache* pCache, const QString& key) {
+        auto pWriter = pCache->newWriter(key, openRamp());
+        if (!pWriter) {
+            return false;
+        }
+        while (!pWriter->isFinished()) {
+            if (!pWriter->writeNextFrames()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static qint64 entryBytes() {
+        // Header + stereo samples
+        return 64 + kFrameCount * 2 * sizeof(CSAMPLE);
+    }
+
+    QTemporaryDir m_cacheDir;
+};
+
+TEST_F(PcmCacheTest, WriteAndRead) {
+    mixxx::PcmCache cache(m_cacheDir.path(), 10 * entryBytes());
+    EXPECT_FALSE(cache.openEntry("ramp"));
+    ASSERT_TRUE(writeEntry(&cache, "ramp"));
+    EXPECT_EQ(entryBytes(), cache.totalBytes());
+
+    // Entries are never overwritten
+    EXPECT_FALSE(cache.newWriter("ramp", openRamp()));
+
+    auto pAudioSource = cache.openEntry("ramp");
+    ASSERT_TRUE(pAudioSource);
+    EXPECT_EQ(mixxx::IndexRange::forward(0, kFrameCount),
+            pAudioSource->frameIndexRange());
+    EXPECT_EQ(mixxx::audio::SampleRate(44100),
+            pAudioSource->getSignalInfo().getSampleRate());
+
+    mixxx::SampleBuffer buffer(2 * 100);
+    const auto readable = pAudioSource->readSampleFrames(
+            mixxx::WritableSampleFrames(
+                    mixxx::IndexRange::forward(12345, 100),
+                    mixxx::SampleBuffer::WritableSlice(buffer)));
+    ASSERT_EQ(mixxx::IndexRange::forward(12345, 100), readable.frameIndexRange());
+    for (SINT i = 0; i < 100; ++i) {
+        EXPECT_EQ(static_cast<CSAMPLE>(12345 + i), readable.readableData()[2 * i]);
+        EXPECT_EQ(-static_cast<CSAMPLE>(12345 + i), readable.readableData()[2 * i + 1]);
+    }
+}
+
+TEST_F(PcmCacheTest, IncompleteEntryIsDiscarded) {
+    mixxx::PcmCache cache(m_cacheDir.path(), 10 * entryBytes());
+    {
+        auto pWriter = cache.newWriter("ramp", openRamp());
+        ASSERT_TRUE(pWriter);
+        // Only one writer per entry
+        EXPECT_FALSE(cache.newWriter("ramp", openRamp()));
+        EXPECT_TRUE(pWriter->writeNextFrames());
+        EXPECT_FALSE(pWriter->isFinished());
+    }
+    EXPECT_FALSE(cache.openEntry("ramp"));
+    EXPECT_TRUE(QDir(m_cacheDir.path()).entryList(QDir::Files).isEmpty());
+}
+
+TEST_F(PcmCacheTest, CorruptEntryIsDeleted) {
+    mixxx::PcmCache cache(m_cacheDir.path(), 10 * entryBytes());
+    ASSERT_TRUE(writeEntry(&cache, "ramp"));
+    const QString filePath = QDir(m_cacheDir.path()).filePath("ramp.pcm");
+    {
+        QFile file(filePath);
+        ASSERT_TRUE(file.open(QIODevice::ReadWrite));
+        ASSERT_TRUE(file.resize(entryBytes() - 1));
+    }
+    EXPECT_FALSE(cache.openEntry("ramp"));
+    EXPECT_FALSE(QFile::exists(filePath));
+}
+
+TEST_F(PcmCacheTest, EvictsLeastRecentlyUsedEntries) {
+    mixxx::PcmCache cache(m_cacheDir.path(), 2 * entryBytes());
+    ASSERT_TRUE(writeEntry(&cache, "first"));
+    ASSERT_TRUE(writeEntry(&cache, "second"));
+    EXPECT_EQ(2 * entryBytes(), cache.totalBytes());
+
+    // Modification times have a limited resolution
+    QThread::msleep(1100);
+    EXPECT_TRUE(cache.openEntry("first"));
+    ASSERT_TRUE(writeEntry(&cache, "third"));
+    EXPECT_EQ(2 * entryBytes(), cache.totalBytes());
+    EXPECT_TRUE(cache.openEntry("first"));
+    EXPECT_FALSE(cache.openEntry("second"));
+    EXPECT_TRUE(cache.openEntry("third"));
+}
+
+TEST_F(PcmCacheTest, TooLargeEntryIsNotWritten) {
+    mixxx::PcmCache cache(m_cacheDir.path(), entryBytes() - 1);
+    EXPECT_FALSE(cache.newWriter("ramp", openRamp()));
+}
+
+} // anonymous namespace
@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+
+#include "engine/cachingreader/preloadbudget.h"
+
+namespace {
+
+class FakeClient : public PreloadBudget::Client {
+  public:
+    FakeClient()
+            : m_evictions(0) {
+    }
+
+    void evictPreload() override {
+        ++m_evictions;
+    }
+
+    int m_evictions;
+};
+
+TEST(PreloadBudgetTest, ReserveAndRelease) {
+    PreloadBudget budget(100);
+    FakeClient client1;
+    FakeClient client2;
+    EXPECT_TRUE(budget.reserve(&client1, 60));
+    EXPECT_TRUE(budget.reserve(&client2, 40));
+    EXPECT_EQ(100, budget.reservedBytes());
+
+    budget.release(&client1);
+    EXPECT_EQ(40, budget.reservedBytes());
+    // Releasing twice is a no-op
+    budget.release(&client1);
+    EXPECT_EQ(40, budget.reservedBytes());
+    EXPECT_EQ(0, client1.m_evictions);
+    EXPECT_EQ(0, client2.m_evictions);
+}
+
+TEST(PreloadBudgetTest, ReserveReplacesPreviousReservation) {
+    PreloadBudget budget(100);
+    FakeClient client;
+    EXPECT_TRUE(budget.reserve(&client, 80));
+    EXPECT_TRUE(budget.reserve(&client, 90));
+    EXPECT_EQ(90, budget.reservedBytes());
+    EXPECT_EQ(0, client.m_evictions);
+}
+
+TEST(PreloadBudgetTest, EvictsOldestReservationsFirst) {
+    PreloadBudget budget(100);
+    FakeClient client1;
+    FakeClient client2;
+    FakeClient client3;
+    FakeClient client4;
+    EXPECT_TRUE(budget.reserve(&client1, 30));
+    EXPECT_TRUE(budget.reserve(&client2, 30));
+    EXPECT_TRUE(budget.reserve(&client3, 30));
+
+    EXPECT_TRUE(budget.reserve(&client4, 50));
+    EXPECT_EQ(1, client1.m_evictions);
+    EXPECT_EQ(1, client2.m_evictions);
+    EXPECT_EQ(0, client3.m_evictions);
+    EXPECT_EQ(80, budget.reservedBytes());
+
+    // Evicted clients don't hold a reservation anymore
+    budget.release(&client1);
+    EXPECT_EQ(80, budget.reservedBytes());
+}
+
+TEST(PreloadBudgetTest, TooLargeReservationDoesNotEvict) {
+    PreloadBudget budget(100);
+    FakeClient client1;
+    FakeClient client2;
+    EXPECT_TRUE(budget.reserve(&client1, 50));
+    EXPECT_FALSE(budget.reserve(&client2, 101));
+    EXPECT_EQ(0, client1.m_evictions);
+    EXPECT_EQ(50, budget.reservedBytes());
+}
+
+} // anonymous namespace
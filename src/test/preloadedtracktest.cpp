@@ -0,0 +1,193 @@
+#include <gtest/gtest.h>
+
+#include <QThread>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "engine/cachingreader/cachingreaderchunk.h"
+#include "engine/cachingreader/preloadedtrack.h"
+#include "test/mixxxtest.h"
+
+namespace {
+
+constexpr SINT kFrameCount = 20000;
+constexpr SINT kDecodeFrames = 8192;
+
+// A stereo ramp whose samples encode their frame index
+class RampAudioSource : public mixxx::AudioSource {
+  public:
+    RampAudioSource()
+            : AudioSource(QUrl("test:ramp")) {
+    }
+
+    void close() override {
+    }
+
+  protected:
+    mixxx::ReadableSampleFrames readSampleFramesClamped(
+            mixxx::WritableSampleFrames writableSampleFrames) override {
+        const auto frameIndexRange = writableSampleFrames.frameIndexRange();
+        CSAMPLE* pSample = writableSampleFrames.writableData();
+        for (SINT i = frameIndexRange.start(); i < frameIndexRange.end(); ++i) {
+            *pSample++ = static_cast<CSAMPLE>(i);
+            *pSample++ = -static_cast<CSAMPLE>(i);
+        }
+        return mixxx::ReadableSampleFrames(
+                frameIndexRange,
+                mixxx::SampleBuffer::ReadableSlice(
+                        writableSampleFrames.writableData(),
+                        getSignalInfo().frames2samples(frameIndexRange.length())));
+    }
+
+  private:
+    OpenResult tryOpen(
+            OpenMode /*mode*/,
+            const OpenParams& /*params*/) override {
+        initChannelCountOnce(2);
+        initSampleRateOnce(44100);
+        initFrameIndexRangeOnce(mixxx::IndexRange::forward(0, kFrameCount));
+        return OpenResult::Succeeded;
+    }
+};
+
+class PreloadedTrackTest : public MixxxTest {
+  protected:
+    PreloadedTrackTest()
+            : m_pAudioSource(std::make_shared<RampAudioSource>()),
+              m_tempBuffer(CachingReaderChunk::frames2samples(kDecodeFrames)),
+              m_track(mixxx::IndexRange::forward(0, kFrameCount)) {
+        m_pAudioSource->open(mixxx::AudioSource::OpenMode::Strict);
+    }
+
+    bool decodeNextFrames() {
+        return m_track.decodeNextFrames(
+                m_pAudioSource,
+                mixxx::SampleBuffer::WritableSlice(m_tempBuffer),
+                kDecodeFrames);
+    }
+
+    mixxx::AudioSourcePointer m_pAudioSource;
+    mixxx::SampleBuffer m_tempBuffer;
+    PreloadedTrack m_track;
+};
+
+TEST_F(PreloadedTrackTest, DecodesInParts) {
+    EXPECT_EQ(static_cast<qint64>(2 * kFrameCount * sizeof(CSAMPLE)),
+            PreloadedTrack::bytesForFrames(kFrameCount));
+    EXPECT_TRUE(m_track.decodedFrameIndexRange().empty());
+    EXPECT_FALSE(m_track.isDecoded());
+
+    EXPECT_TRUE(decodeNextFrames());
+    EXPECT_EQ(mixxx::IndexRange::forward(0, kDecodeFrames),
+            m_track.decodedFrameIndexRange());
+    EXPECT_TRUE(decodeNextFrames());
+    EXPECT_FALSE(m_track.isDecoded());
+    // The last part is shorter
+    EXPECT_TRUE(decodeNextFrames());
+    EXPECT_TRUE(m_track.isDecoded());
+    EXPECT_EQ(m_track.frameIndexRange(), m_track.decodedFrameIndexRange());
+
+    // Nothing left to decode
+    EXPECT_TRUE(decodeNextFrames());
+    EXPECT_TRUE(m_track.isDecoded());
+}
+
+TEST_F(PreloadedTrackTest, ReadsOnlyDecodedFrames) {
+    ASSERT_TRUE(decodeNextFrames());
+
+    // Starts before and ends after the decoded frames
+    const auto frameIndexRange = mixxx::IndexRange::forward(kDecodeFrames - 100, 200);
+    std::vector<CSAMPLE> buffer(CachingReaderChunk::frames2samples(200), 1000.0f);
+    EXPECT_EQ(mixxx::IndexRange::forward(kDecodeFrames - 100, 100),
+            m_track.readSampleFrames(buffer.data(), frameIndexRange));
+    for (SINT i = 0; i < 100; ++i) {
+        EXPECT_EQ(static_cast<CSAMPLE>(kDecodeFrames - 100 + i), buffer[2 * i]);
+        EXPECT_EQ(-static_cast<CSAMPLE>(kDecodeFrames - 100 + i), buffer[2 * i + 1]);
+    }
+    // Untouched like with a chunk that has been read partially
+    EXPECT_EQ(1000.0f, buffer[200]);
+    EXPECT_EQ(1000.0f, buffer.back());
+
+    const auto undecodedFrameIndexRange = mixxx::IndexRange::forward(kDecodeFrames, 100);
+    EXPECT_TRUE(m_track.readSampleFrames(buffer.data(), undecodedFrameIndexRange).empty());
+}
+
+TEST_F(PreloadedTrackTest, ReadsReverse) {
+    while (!m_track.isDecoded()) {
+        ASSERT_TRUE(decodeNextFrames());
+    }
+
+    // The buffer is filled backwards from its end like by CachingReader
+    const auto frameIndexRange = mixxx::IndexRange::forward(kFrameCount - 100, 100);
+    std::vector<CSAMPLE> buffer(CachingReaderChunk::frames2samples(100));
+    EXPECT_EQ(frameIndexRange,
+            m_track.readSampleFramesReverse(
+                    buffer.data() + buffer.size(), frameIndexRange));
+    for (SINT i = 0; i < 100; ++i) {
+        EXPECT_EQ(static_cast<CSAMPLE>(kFrameCount - 1 - i), buffer[2 * i]);
+        EXPECT_EQ(-static_cast<CSAMPLE>(kFrameCount - 1 - i), buffer[2 * i + 1]);
+    }
+}
+
+TEST_F(PreloadedTrackTest, SlotPublishesTrack) {
+    while (!m_track.isDecoded()) {
+        ASSERT_TRUE(decodeNextFrames());
+    }
+
+    PreloadedTrackSlot slot;
+    EXPECT_FALSE(slot.isPublished());
+    {
+        const PreloadedTrackSlot::ReadScope scope(&slot);
+        EXPECT_EQ(nullptr, scope.track());
+    }
+
+    slot.publish(&m_track);
+    EXPECT_TRUE(slot.isPublished());
+    {
+        const PreloadedTrackSlot::ReadScope scope(&slot);
+        EXPECT_EQ(&m_track, scope.track());
+    }
+
+    slot.unpublish();
+    EXPECT_FALSE(slot.isPublished());
+    {
+        const PreloadedTrackSlot::ReadScope scope(&slot);
+        EXPECT_EQ(nullptr, scope.track());
+    }
+    // Unpublishing twice is a no-op
+    slot.unpublish();
+}
+
+TEST_F(PreloadedTrackTest, UnpublishWaitsForRead) {
+    while (!m_track.isDecoded()) {
+        ASSERT_TRUE(decodeNextFrames());
+    }
+    PreloadedTrackSlot slot;
+    slot.publish(&m_track);
+
+    std::atomic<bool> unpublished(false);
+    std::unique_ptr<std::thread> pWorker;
+    {
+        const PreloadedTrackSlot::ReadScope scope(&slot);
+        ASSERT_EQ(&m_track, scope.track());
+        pWorker = std::make_unique<std::thread>([&slot, &unpublished] {
+            slot.unpublish();
+            unpublished.store(true);
+        });
+        // The track is unpublished, but must stay valid while reading
+        while (slot.isPublished()) {
+            QThread::yieldCurrentThread();
+        }
+        QThread::msleep(10);
+        EXPECT_FALSE(unpublished.load());
+        EXPECT_EQ(&m_track, scope.track());
+    }
+    pWorker->join();
+    EXPECT_TRUE(unpublished.load());
+    EXPECT_FALSE(slot.isPublished());
+}
+
+} // anonymous namespace
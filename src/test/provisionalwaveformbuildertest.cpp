@@ -0,0 +1,159 @@
+#include <gtest/gtest.h>
+
+#include <QSqlDatabase>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "analyzer/analyzerwaveform.h"
+#include "test/mixxxtest.h"
+#include "track/track.h"
+#include "waveform/provisionalwaveformbuilder.h"
+
+namespace {
+
+constexpr int kSampleRate = 44100;
+constexpr SINT kFrameCount = 2 * kSampleRate + 123;
+constexpr SINT kChunkFrames = 8192;
+
+class ProvisionalWaveformBuilderTest : public MixxxTest {
+  protected:
+    void SetUp() override {
+        m_pTrack = Track::newTemporary();
+        std::mt19937 generator(42);
+        std::uniform_real_distribution<CSAMPLE> distribution(-1.0f, 1.0f);
+        m_samples.resize(ChannelCount * kFrameCount);
+        for (auto& sample : m_samples) {
+            sample = distribution(generator);
+        }
+    }
+
+    void addChunk(ProvisionalWaveformBuilder* pBuilder, SINT chunkIndex) {
+        const auto frames = mixxx::IndexRange::between(
+                chunkIndex * kChunkFrames,
+                std::min((chunkIndex + 1) * kChunkFrames, kFrameCount));
+        pBuilder->addFrames(frames, &m_samples[ChannelCount * frames.start()]);
+    }
+
+    static SINT chunkCount() {
+        return (kFrameCount + kChunkFrames - 1) / kChunkFrames;
+    }
+
+    TrackPointer m_pTrack;
+    std::vector<CSAMPLE> m_samples;
+};
+
+TEST_F(ProvisionalWaveformBuilderTest, MatchesAnalyzerInOrder) {
+    ProvisionalWaveformBuilder builder;
+    builder.start(m_pTrack, mixxx::IndexRange::forward(0, kFrameCount), kSampleRate);
+    const WaveformPointer pWaveform = builder.getWaveform();
+    ASSERT_TRUE(pWaveform);
+    EXPECT_TRUE(pWaveform->isProvisional());
+    EXPECT_EQ(pWaveform.data(), m_pTrack->getWaveform().data());
+    for (SINT i = 0; i < chunkCount(); ++i) {
+        addChunk(&builder, i);
+    }
+    EXPECT_FALSE(builder.isActive());
+    EXPECT_EQ(pWaveform->getDataSize(), pWaveform->getCompletion());
+
+    TrackPointer pAnalyzedTrack = Track::newTemporary();
+    AnalyzerWaveform analyzer(config(), QSqlDatabase());
+    ASSERT_TRUE(analyzer.initialize(pAnalyzedTrack, kSampleRate, ChannelCount * kFrameCount));
+    ASSERT_TRUE(analyzer.processSamples(&m_samples[0], ChannelCount * kFrameCount));
+    ConstWaveformPointer pAnalyzedWaveform = pAnalyzedTrack->getWaveform();
+    ASSERT_EQ(pAnalyzedWaveform->getDataSize(), pWaveform->getDataSize());
+    // The analyzer does not store the last incomplete visual sample
+    const int completion = pAnalyzedWaveform->getCompletion();
+    ASSERT_LT(0, completion);
+    for (int i = 0; i < completion; ++i) {
+        EXPECT_EQ(pAnalyzedWaveform->get(i).m_i, pWaveform->get(i).m_i) << i;
+    }
+    analyzer.cleanup();
+}
+
+TEST_F(ProvisionalWaveformBuilderTest, ChunksInAnyOrder) {
+    TrackPointer pInOrderTrack = Track::newTemporary();
+    ProvisionalWaveformBuilder inOrderBuilder;
+    inOrderBuilder.start(pInOrderTrack,
+            mixxx::IndexRange::forward(0, kFrameCount), kSampleRate);
+    const WaveformPointer pInOrderWaveform = inOrderBuilder.getWaveform();
+    for (SINT i = 0; i < chunkCount(); ++i) {
+        addChunk(&inOrderBuilder, i);
+    }
+
+    ProvisionalWaveformBuilder builder;
+    builder.start(m_pTrack, mixxx::IndexRange::forward(0, kFrameCount), kSampleRate);
+    const WaveformPointer pWaveform = builder.getWaveform();
+    // Seek into the middle, then play from the start
+    addChunk(&builder, 5);
+    addChunk(&builder, 6);
+    const int completion = pWaveform->getCompletion();
+    EXPECT_LT(0, completion);
+    // Frames that have been added before are not counted again
+    addChunk(&builder, 6);
+    EXPECT_EQ(completion, pWaveform->getCompletion());
+    for (SINT i = 0; i < chunkCount(); ++i) {
+        addChunk(&builder, i);
+    }
+    EXPECT_FALSE(builder.isActive());
+    EXPECT_EQ(pWaveform->getDataSize(), pWaveform->getCompletion());
+
+    // The band filters restart after the gaps, but the peaks of the
+    // unfiltered signal are the same
+    for (int i = 0; i < pWaveform->getDataSize(); ++i) {
+        EXPECT_EQ(pInOrderWaveform->getAll(i), pWaveform->getAll(i)) << i;
+    }
+}
+
+TEST_F(ProvisionalWaveformBuilderTest, StopsWhenReplaced) {
+    ProvisionalWaveformBuilder builder;
+    builder.start(m_pTrack, mixxx::IndexRange::forward(0, kFrameCount), kSampleRate);
+    addChunk(&builder, 0);
+    EXPECT_TRUE(builder.isActive());
+
+    // Like the AnalyzerWaveform
+    WaveformPointer pAnalyzedWaveform(new Waveform(kSampleRate,
+            ChannelCount * kFrameCount,
+            AnalyzerWaveform::kMainWaveformSampleRate,
+            -1));
+    m_pTrack->setWaveform(pAnalyzedWaveform);
+    addChunk(&builder, 1);
+    EXPECT_FALSE(builder.isActive());
+    EXPECT_EQ(pAnalyzedWaveform.data(), m_pTrack->getWaveform().data());
+
+    // The analyzed waveform is not replaced when loading the track again
+    builder.start(m_pTrack, mixxx::IndexRange::forward(0, kFrameCount), kSampleRate);
+    EXPECT_FALSE(builder.isActive());
+    EXPECT_EQ(pAnalyzedWaveform.data(), m_pTrack->getWaveform().data());
+}
+
+TEST_F(ProvisionalWaveformBuilderTest, TrackKeepsAnalyzedWaveform) {
+    WaveformPointer pProvisionalWaveform(new Waveform(kSampleRate,
+            ChannelCount * kFrameCount,
+            AnalyzerWaveform::kMainWaveformSampleRate,
+            -1));
+    pProvisionalWaveform->setProvisional(true);
+    EXPECT_TRUE(m_pTrack->setProvisionalWaveform(pProvisionalWaveform));
+    EXPECT_EQ(pProvisionalWaveform.data(), m_pTrack->getWaveform().data());
+
+    // Replaces a provisional waveform
+    WaveformPointer pNextProvisionalWaveform(new Waveform(kSampleRate,
+            ChannelCount * kFrameCount,
+            AnalyzerWaveform::kMainWaveformSampleRate,
+            -1));
+    pNextProvisionalWaveform->setProvisional(true);
+    EXPECT_TRUE(m_pTrack->setProvisionalWaveform(pNextProvisionalWaveform));
+    EXPECT_EQ(pNextProvisionalWaveform.data(), m_pTrack->getWaveform().data());
+
+    // But not an analyzed one
+    WaveformPointer pAnalyzedWaveform(new Waveform(kSampleRate,
+            ChannelCount * kFrameCount,
+            AnalyzerWaveform::kMainWaveformSampleRate,
+            -1));
+    m_pTrack->setWaveform(pAnalyzedWaveform);
+    EXPECT_FALSE(m_pTrack->setProvisionalWaveform(pProvisionalWaveform));
+    EXPECT_EQ(pAnalyzedWaveform.data(), m_pTrack->getWaveform().data());
+}
+
+} // anonymous namespace
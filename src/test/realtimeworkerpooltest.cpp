@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+
+#include <QtDebug>
+#include <atomic>
+#include <vector>
+
+#include "engine/realtimeworkerpool.h"
+
+namespace {
+
+class CountingJobs : public RealtimeWorkerPool::Jobs {
+  public:
+    explicit CountingJobs(int numJobs)
+            : m_runs(numJobs),
+              m_results(numJobs, 0) {
+    }
+
+    void run(int index) override {
+        m_runs[index].fetch_add(1, std::memory_order_relaxed);
+        // Not atomic: Must be visible after runJobs() returned
+        m_results[index] += index;
+    }
+
+    std::vector<std::atomic<int>> m_runs;
+    std::vector<int> m_results;
+};
+
+class RealtimeWorkerPoolTest : public testing::TestWithParam<int> {
+};
+
+TEST_P(RealtimeWorkerPoolTest, RunsEachJobOncePerCall) {
+    RealtimeWorkerPool pool("RealtimeWorkerPoolTest", GetParam(), false);
+    EXPECT_EQ(GetParam(), pool.numWorkers());
+
+    const int kNumJobs = 23;
+    const int kNumCalls = 1000;
+    CountingJobs jobs(kNumJobs);
+    for (int call = 1; call <= kNumCalls; ++call) {
+        // Vary the number of jobs, including none
+        const int numJobs = call % (kNumJobs + 1);
+        pool.runJobs(&jobs, numJobs);
+        for (int i = 0; i < kNumJobs; ++i) {
+            ASSERT_EQ(jobs.m_runs[i].exchange(0), i < numJobs ? 1 : 0)
+                    << "call " << call << " job " << i;
+        }
+    }
+
+    for (int i = 0; i < kNumJobs; ++i) {
+        int runs = 0;
+        for (int call = 1; call <= kNumCalls; ++call) {
+            runs += i < call % (kNumJobs + 1) ? 1 : 0;
+        }
+        EXPECT_EQ(runs * i, jobs.m_results[i]);
+    }
+}
+
+// Like the two passes of EngineMaster::processChannels(): A late worker
+// must neither claim a job with the count of the next call nor run the jobs
+// of a call that has already returned.
+TEST_P(RealtimeWorkerPoolTest, BackToBackCallsWithAlternatingCounts) {
+    RealtimeWorkerPool pool("RealtimeWorkerPoolTest", GetParam(), false);
+
+    const int kNumCalls = 20000;
+    for (int call = 0; call < kNumCalls; ++call) {
+        const int numJobs = call % 2 == 0 ? 2 : 7;
+        // Destroyed after each call, so stale jobs would be detected by
+        // the run counts of the next call or the sanitizers
+        CountingJobs jobs(numJobs);
+        pool.runJobs(&jobs, numJobs);
+        for (int i = 0; i < numJobs; ++i) {
+            ASSERT_EQ(1, jobs.m_runs[i].load()) << "call " << call << " job " << i;
+            ASSERT_EQ(i, jobs.m_results[i]) << "call " << call << " job " << i;
+        }
+    }
+}
+
+TEST_P(RealtimeWorkerPoolTest, PinnedWorkers) {
+    RealtimeWorkerPool pool("RealtimeWorkerPoolTest", GetParam(), true);
+    CountingJobs jobs(8);
+    pool.runJobs(&jobs, 8);
+    for (int i = 0; i < 8; ++i) {
+        EXPECT_EQ(1, jobs.m_runs[i].load());
+        EXPECT_EQ(i, jobs.m_results[i]);
+    }
+}
+
+// Without workers all jobs are run serially on the calling thread
+INSTANTIATE_TEST_CASE_P(RealtimeWorkerPoolTest,
+        RealtimeWorkerPoolTest,
+        ::testing::Values(0, 1, 3));
+
+} // anonymous namespace
@@ -4,8 +4,10 @@
 #include <QtDebug>
 #include <QList>
 #include <QPair>
+#include <random>
 
 #include "util/sample.h"
+#include "util/samplekernels.h"
 #include "util/timer.h"
 
 namespace {
@@ -397,6 +399,184 @@ TEST_F(SampleUtilTest, copyReverse) {
     }
 }
 
+class SampleKernelsTest : public testing::TestWithParam<mixxx::samplekernels::Isa> {
+  protected:
+    void SetUp() override {
+        m_pKernels = mixxx::samplekernels::tableForIsa(GetParam());
+        m_pReference = mixxx::samplekernels::tableForIsa(
+                mixxx::samplekernels::Isa::Scalar);
+        // Odd sizes and sizes that are not a multiple of the vector width
+        // exercise the scalar tails of the SIMD kernels.
+        for (int size : {0, 1, 2, 3, 7, 8, 15, 16, 17, 31, 33, 1024, 1027}) {
+            m_sizes.append(size);
+        }
+    }
+
+    bool isSupported() const {
+        return m_pKernels != nullptr;
+    }
+
+    // Values above CSAMPLE_PEAK are included for testing clamping
+    CSAMPLE* allocRandomBuffer(int size) {
+        std::uniform_real_distribution<CSAMPLE> distribution(-1.5f, 1.5f);
+        CSAMPLE* pBuffer = SampleUtil::alloc(size > 0 ? size : 1);
+        for (int i = 0; i < size; ++i) {
+            pBuffer[i] = distribution(m_randomEngine);
+        }
+        return pBuffer;
+    }
+
+    static void assertBitExact(const CSAMPLE* pExpected,
+            const CSAMPLE* pActual,
+            int size) {
+        ASSERT_EQ(0, memcmp(pExpected, pActual, sizeof(CSAMPLE) * size))
+                << "size " << size;
+    }
+
+    const mixxx::samplekernels::Table* m_pKernels;
+    const mixxx::samplekernels::Table* m_pReference;
+    QList<int> m_sizes;
+    std::mt19937 m_randomEngine;
+};
+
+TEST_P(SampleKernelsTest, applyGainIsBitExact) {
+    if (!isSupported()) {
+        return;
+    }
+    for (int size : m_sizes) {
+        CSAMPLE* pExpected = allocRandomBuffer(size);
+        CSAMPLE* pActual = SampleUtil::alloc(size > 0 ? size : 1);
+        SampleUtil::copy(pActual, pExpected, size);
+        m_pReference->applyGain(pExpected, 0.7f, size);
+        m_pKernels->applyGain(pActual, 0.7f, size);
+        assertBitExact(pExpected, pActual, size);
+        SampleUtil::free(pExpected);
+        SampleUtil::free(pActual);
+    }
+}
+
+TEST_P(SampleKernelsTest, applyRampingGainIsBitExact) {
+    if (!isSupported()) {
+        return;
+    }
+    for (int size : m_sizes) {
+        CSAMPLE* pExpected = allocRandomBuffer(size);
+        CSAMPLE* pActual = SampleUtil::alloc(size > 0 ? size : 1);
+        SampleUtil::copy(pActual, pExpected, size);
+        m_pReference->applyRampingGain(pExpected, 0.1f, 0.0013f, size / 2);
+        m_pKernels->applyRampingGain(pActual, 0.1f, 0.0013f, size / 2);
+        assertBitExact(pExpected, pActual, size);
+        SampleUtil::free(pExpected);
+        SampleUtil::free(pActual);
+    }
+}
+
+TEST_P(SampleKernelsTest, copyWithRampingGainIsBitExact) {
+    if (!isSupported()) {
+        return;
+    }
+    for (int size : m_sizes) {
+        CSAMPLE* pSrc = allocRandomBuffer(size);
+        CSAMPLE* pExpected = allocRandomBuffer(size);
+        CSAMPLE* pActual = SampleUtil::alloc(size > 0 ? size : 1);
+        SampleUtil::copy(pActual, pExpected, size);
+        m_pReference->copyWithGain(pExpected, pSrc, 0.3f, size);
+        m_pKernels->copyWithGain(pActual, pSrc, 0.3f, size);
+        assertBitExact(pExpected, pActual, size);
+        m_pReference->copyWithRampingGain(pExpected, pSrc, 0.9f, -0.0021f, size / 2);
+        m_pKernels->copyWithRampingGain(pActual, pSrc, 0.9f, -0.0021f, size / 2);
+        assertBitExact(pExpected, pActual, size);
+        SampleUtil::free(pSrc);
+        SampleUtil::free(pExpected);
+        SampleUtil::free(pActual);
+    }
+}
+
+TEST_P(SampleKernelsTest, addWithGainIsBitExact) {
+    if (!isSupported()) {
+        return;
+    }
+    for (int size : m_sizes) {
+        CSAMPLE* pSrc1 = allocRandomBuffer(size);
+        CSAMPLE* pSrc2 = allocRandomBuffer(size);
+        CSAMPLE* pSrc3 = allocRandomBuffer(size);
+        CSAMPLE* pExpected = allocRandomBuffer(size);
+        CSAMPLE* pActual = SampleUtil::alloc(size > 0 ? size : 1);
+        SampleUtil::copy(pActual, pExpected, size);
+        m_pReference->add(pExpected, pSrc1, size);
+        m_pKernels->add(pActual, pSrc1, size);
+        assertBitExact(pExpected, pActual, size);
+        m_pReference->addWithGain(pExpected, pSrc1, 0.3f, size);
+        m_pKernels->addWithGain(pActual, pSrc1, 0.3f, size);
+        assertBitExact(pExpected, pActual, size);
+        m_pReference->addWithRampingGain(pExpected, pSrc2, 0.2f, 0.0007f, size / 2);
+        m_pKernels->addWithRampingGain(pActual, pSrc2, 0.2f, 0.0007f, size / 2);
+        assertBitExact(pExpected, pActual, size);
+        m_pReference->add2WithGain(pExpected, pSrc1, 0.3f, pSrc2, 0.77f, size);
+        m_pKernels->add2WithGain(pActual, pSrc1, 0.3f, pSrc2, 0.77f, size);
+        assertBitExact(pExpected, pActual, size);
+        m_pReference->add3WithGain(pExpected,
+                pSrc1, 0.3f, pSrc2, 0.77f, pSrc3, 1.1f, size);
+        m_pKernels->add3WithGain(pActual,
+                pSrc1, 0.3f, pSrc2, 0.77f, pSrc3, 1.1f, size);
+        assertBitExact(pExpected, pActual, size);
+        SampleUtil::free(pSrc1);
+        SampleUtil::free(pSrc2);
+        SampleUtil::free(pSrc3);
+        SampleUtil::free(pExpected);
+        SampleUtil::free(pActual);
+    }
+}
+
+TEST_P(SampleKernelsTest, copyClampBufferIsBitExact) {
+    if (!isSupported()) {
+        return;
+    }
+    for (int size : m_sizes) {
+        CSAMPLE* pSrc = allocRandomBuffer(size);
+        CSAMPLE* pExpected = SampleUtil::alloc(size > 0 ? size : 1);
+        CSAMPLE* pActual = SampleUtil::alloc(size > 0 ? size : 1);
+        m_pReference->copyClampBuffer(pExpected, pSrc, size);
+        m_pKernels->copyClampBuffer(pActual, pSrc, size);
+        assertBitExact(pExpected, pActual, size);
+        SampleUtil::free(pSrc);
+        SampleUtil::free(pExpected);
+        SampleUtil::free(pActual);
+    }
+}
+
+TEST_P(SampleKernelsTest, interleaveBufferIsBitExact) {
+    if (!isSupported()) {
+        return;
+    }
+    for (int size : m_sizes) {
+        CSAMPLE* pSrc1 = allocRandomBuffer(size);
+        CSAMPLE* pSrc2 = allocRandomBuffer(size);
+        CSAMPLE* pExpected = SampleUtil::alloc(size > 0 ? size * 2 : 1);
+        CSAMPLE* pActual = SampleUtil::alloc(size > 0 ? size * 2 : 1);
+        m_pReference->interleaveBuffer(pExpected, pSrc1, pSrc2, size);
+        m_pKernels->interleaveBuffer(pActual, pSrc1, pSrc2, size);
+        assertBitExact(pExpected, pActual, size * 2);
+
+        // Round trip
+        m_pReference->deinterleaveBuffer(pSrc1, pSrc2, pExpected, size);
+        m_pKernels->deinterleaveBuffer(pExpected, pExpected + size, pActual, size);
+        assertBitExact(pSrc1, pExpected, size);
+        assertBitExact(pSrc2, pExpected + size, size);
+        SampleUtil::free(pSrc1);
+        SampleUtil::free(pSrc2);
+        SampleUtil::free(pExpected);
+        SampleUtil::free(pActual);
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(SampleKernelsTest,
+        SampleKernelsTest,
+        testing::Values(
+                mixxx::samplekernels::Isa::Scalar,
+                mixxx::samplekernels::Isa::Avx2,
+                mixxx::samplekernels::Isa::Avx512));
+
 static void BM_MemCpy(benchmark::State& state) {
     size_t size = state.range(0);
     CSAMPLE* buffer = SampleUtil::alloc(size);
@@ -583,4 +763,125 @@ static void BM_Copy2WithRampingGain(benchmark::State& state) {
 }
 BENCHMARK(BM_Copy2WithRampingGain)->Range(64, 4096);
 
+// The kernel benchmarks take the instruction set as a captured argument, e.g.
+// BM_ApplyRampingGainKernel/avx2/1024
+static void BM_ApplyRampingGainKernel(benchmark::State& state,
+        mixxx::samplekernels::Isa isa) {
+    const mixxx::samplekernels::Table* pKernels =
+            mixxx::samplekernels::tableForIsa(isa);
+    if (!pKernels) {
+        state.SkipWithError("Not supported by this CPU or build");
+        return;
+    }
+    size_t size = state.range(0);
+    CSAMPLE* buffer = SampleUtil::alloc(size);
+    SampleUtil::fill(buffer, 0.5f, size);
+
+    while (state.KeepRunning()) {
+        pKernels->applyRampingGain(buffer, 1.0f, -0.0001f, size / 2);
+    }
+
+    SampleUtil::free(buffer);
+}
+BENCHMARK_CAPTURE(BM_ApplyRampingGainKernel, scalar,
+        mixxx::samplekernels::Isa::Scalar)->Range(64, 4096);
+BENCHMARK_CAPTURE(BM_ApplyRampingGainKernel, avx2,
+        mixxx::samplekernels::Isa::Avx2)->Range(64, 4096);
+BENCHMARK_CAPTURE(BM_ApplyRampingGainKernel, avx512,
+        mixxx::samplekernels::Isa::Avx512)->Range(64, 4096);
+
+static void BM_Add3WithGainKernel(benchmark::State& state,
+        mixxx::samplekernels::Isa isa) {
+    const mixxx::samplekernels::Table* pKernels =
+            mixxx::samplekernels::tableForIsa(isa);
+    if (!pKernels) {
+        state.SkipWithError("Not supported by this CPU or build");
+        return;
+    }
+    size_t size = state.range(0);
+    CSAMPLE* buffer = SampleUtil::alloc(size);
+    SampleUtil::fill(buffer, 0.0f, size);
+    CSAMPLE* buffer2 = SampleUtil::alloc(size);
+    SampleUtil::fill(buffer2, 0.1f, size);
+    CSAMPLE* buffer3 = SampleUtil::alloc(size);
+    SampleUtil::fill(buffer3, 0.2f, size);
+    CSAMPLE* buffer4 = SampleUtil::alloc(size);
+    SampleUtil::fill(buffer4, 0.3f, size);
+
+    while (state.KeepRunning()) {
+        pKernels->add3WithGain(buffer,
+                buffer2, 0.5f, buffer3, 0.5f, buffer4, 0.5f, size);
+    }
+
+    SampleUtil::free(buffer);
+    SampleUtil::free(buffer2);
+    SampleUtil::free(buffer3);
+    SampleUtil::free(buffer4);
+}
+BENCHMARK_CAPTURE(BM_Add3WithGainKernel, scalar,
+        mixxx::samplekernels::Isa::Scalar)->Range(64, 4096);
+BENCHMARK_CAPTURE(BM_Add3WithGainKernel, avx2,
+        mixxx::samplekernels::Isa::Avx2)->Range(64, 4096);
+BENCHMARK_CAPTURE(BM_Add3WithGainKernel, avx512,
+        mixxx::samplekernels::Isa::Avx512)->Range(64, 4096);
+
+static void BM_CopyClampBufferKernel(benchmark::State& state,
+        mixxx::samplekernels::Isa isa) {
+    const mixxx::samplekernels::Table* pKernels =
+            mixxx::samplekernels::tableForIsa(isa);
+    if (!pKernels) {
+        state.SkipWithError("Not supported by this CPU or build");
+        return;
+    }
+    size_t size = state.range(0);
+    CSAMPLE* buffer = SampleUtil::alloc(size);
+    SampleUtil::fill(buffer, 0.0f, size);
+    CSAMPLE* buffer2 = SampleUtil::alloc(size);
+    SampleUtil::fill(buffer2, 1.5f, size);
+
+    while (state.KeepRunning()) {
+        pKernels->copyClampBuffer(buffer, buffer2, size);
+    }
+
+    SampleUtil::free(buffer);
+    SampleUtil::free(buffer2);
+}
+BENCHMARK_CAPTURE(BM_CopyClampBufferKernel, scalar,
+        mixxx::samplekernels::Isa::Scalar)->Range(64, 4096);
+BENCHMARK_CAPTURE(BM_CopyClampBufferKernel, avx2,
+        mixxx::samplekernels::Isa::Avx2)->Range(64, 4096);
+BENCHMARK_CAPTURE(BM_CopyClampBufferKernel, avx512,
+        mixxx::samplekernels::Isa::Avx512)->Range(64, 4096);
+
+static void BM_InterleaveBufferKernel(benchmark::State& state,
+        mixxx::samplekernels::Isa isa) {
+    const mixxx::samplekernels::Table* pKernels =
+            mixxx::samplekernels::tableForIsa(isa);
+    if (!pKernels) {
+        state.SkipWithError("Not supported by this CPU or build");
+        return;
+    }
+    size_t size = state.range(0);
+    CSAMPLE* buffer = SampleUtil::alloc(size * 2);
+    SampleUtil::fill(buffer, 0.0f, size * 2);
+    CSAMPLE* buffer2 = SampleUtil::alloc(size);
+    SampleUtil::fill(buffer2, 0.1f, size);
+    CSAMPLE* buffer3 = SampleUtil::alloc(size);
+    SampleUtil::fill(buffer3, 0.2f, size);
+
+    while (state.KeepRunning()) {
+        pKernels->interleaveBuffer(buffer, buffer2, buffer3, size);
+    }
+
+    SampleUtil::free(buffer);
+    SampleUtil::free(buffer2);
+    SampleUtil::free(buffer3);
+}
+BENCHMARK_CAPTURE(BM_InterleaveBufferKernel, scalar,
+        mixxx::samplekernels::Isa::Scalar)->Range(64, 4096);
+BENCHMARK_CAPTURE(BM_InterleaveBufferKernel, avx2,
+        mixxx::samplekernels::Isa::Avx2)->Range(64, 4096);
+BENCHMARK_CAPTURE(BM_InterleaveBufferKernel, avx512,
+        mixxx::samplekernels::Isa::Avx512)->Range(64, 4096);
+
 }  // namespace
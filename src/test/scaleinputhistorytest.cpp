@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "engine/bufferscalers/scaleinputhistory.h"
+#include "engine/readaheadmanager.h"
+#include "util/types.h"
+
+namespace {
+
+// Returns the running sample index as sample value, up to a limit
+class ReadAheadManagerFake : public ReadAheadManager {
+  public:
+    explicit ReadAheadManagerFake(SINT limitSamples)
+            : ReadAheadManager(),
+              m_limitSamples(limitSamples),
+              m_samplesRead(0) {
+    }
+
+    SINT getNextSamples(double dRate, CSAMPLE* buffer, SINT requested_samples) override {
+        Q_UNUSED(dRate);
+        SINT samples = 0;
+        while (samples < requested_samples && m_samplesRead < m_limitSamples) {
+            buffer[samples++] = static_cast<CSAMPLE>(m_samplesRead++);
+        }
+        return samples;
+    }
+
+    SINT samplesRead() const {
+        return m_samplesRead;
+    }
+
+  private:
+    const SINT m_limitSamples;
+    SINT m_samplesRead;
+};
+
+constexpr SINT kCapacityFrames = 16;
+
+TEST(ScaleInputHistoryTest, ReadAgainFromEarlierPosition) {
+    ReadAheadManagerFake readAheadManager(1000);
+    ScaleInputHistory history(&readAheadManager, kCapacityFrames);
+
+    std::vector<CSAMPLE> buffer(2 * kCapacityFrames);
+    SINT first = 0;
+    EXPECT_EQ(10, history.read(&first, buffer.data(), 10, 1.0));
+    EXPECT_EQ(10, first);
+    EXPECT_EQ(10, history.frontier());
+
+    // The second reader starts behind and only reads ahead what is missing
+    SINT second = 4;
+    EXPECT_EQ(8, history.read(&second, buffer.data(), 8, 1.0));
+    EXPECT_EQ(12, second);
+    EXPECT_EQ(12, history.frontier());
+    EXPECT_EQ(24, readAheadManager.samplesRead());
+    for (SINT i = 0; i < 2 * 8; ++i) {
+        EXPECT_EQ(static_cast<CSAMPLE>(2 * 4 + i), buffer[i]);
+    }
+}
+
+TEST(ScaleInputHistoryTest, WrapAroundAndOldest) {
+    ReadAheadManagerFake readAheadManager(1000);
+    ScaleInputHistory history(&readAheadManager, kCapacityFrames);
+
+    std::vector<CSAMPLE> buffer(2 * kCapacityFrames);
+    SINT position = 0;
+    history.read(&position, buffer.data(), 12, 1.0);
+    history.read(&position, buffer.data(), 12, 1.0);
+    EXPECT_EQ(24, history.frontier());
+    EXPECT_EQ(24 - kCapacityFrames, history.oldest());
+
+    // A position that has been overwritten is moved forward
+    SINT old = 2;
+    EXPECT_EQ(10, history.read(&old, buffer.data(), 10, 1.0));
+    EXPECT_EQ(24 - kCapacityFrames + 10, old);
+    for (SINT i = 0; i < 2 * 10; ++i) {
+        EXPECT_EQ(static_cast<CSAMPLE>(2 * (24 - kCapacityFrames) + i), buffer[i]);
+    }
+}
+
+TEST(ScaleInputHistoryTest, ShortReadAndClear) {
+    ReadAheadManagerFake readAheadManager(2 * 6);
+    ScaleInputHistory history(&readAheadManager, kCapacityFrames);
+
+    std::vector<CSAMPLE> buffer(2 * kCapacityFrames);
+    SINT position = 0;
+    EXPECT_EQ(6, history.read(&position, buffer.data(), 10, 1.0));
+    EXPECT_EQ(6, history.frontier());
+
+    history.clear();
+    EXPECT_EQ(0, history.frontier());
+    EXPECT_EQ(0, history.oldest());
+}
+
+} // anonymous namespace
@@ -5,6 +5,7 @@
 #include "test/librarytest.h"
 
 #include "library/searchqueryparser.h"
+#include "library/tracksearchindex.h"
 #include "util/assert.h"
 
 TrackPointer newTestTrack(int sampleRate) {
@@ -989,3 +990,34 @@ TEST_F(SearchQueryParserTest, CrateFilterWithCrateFilterAndNegation){
                             ") AND (NOT (" + m_crateFilterQuery.arg(searchTermB) + "))"),
                  qPrintable(pQueryB->toSql()));
 }
+
+TEST_F(SearchQueryParserTest, FilterRowsWithSearchIndex) {
+    QStringList searchColumns;
+    searchColumns << "artist"
+                  << "title";
+
+    TrackSearchIndex index(searchColumns);
+    index.updateTrack(TrackId(1), QStringList() << "Foo" << "Intro");
+    index.updateTrack(TrackId(2), QStringList() << "Bar" << "Foobar");
+    index.updateTrack(TrackId(3), QStringList() << "Baz" << "Outro");
+
+    auto pQuery(
+        m_parser.parseQuery("foo -bar bpm:>120", searchColumns, ""));
+
+    QBitArray rows;
+    ASSERT_TRUE(index.rowsOf(
+            QSet<TrackId>() << TrackId(1) << TrackId(2) << TrackId(3), &rows));
+
+    // Only the numeric filter is left for the database
+    EXPECT_STREQ(
+        qPrintable(QString("bpm > 120")),
+        qPrintable(pQuery->toSqlFilteringRows(index, &rows)));
+    EXPECT_TRUE(rows.testBit(index.row(TrackId(1))));
+    EXPECT_FALSE(rows.testBit(index.row(TrackId(2))));
+    EXPECT_FALSE(rows.testBit(index.row(TrackId(3))));
+
+    // Wildcards are left for the database
+    auto pWildcardQuery(
+        m_parser.parseQuery("f_o", searchColumns, ""));
+    EXPECT_FALSE(pWildcardQuery->filterRows(index, &rows));
+}
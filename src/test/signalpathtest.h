@@ -53,6 +53,8 @@ class TestEngineMaster : public EngineMaster {
     CSAMPLE* masterBuffer() {
         return m_pMaster;
     }
+
+    using EngineMaster::setChannelWorkerThreads;
 };
 
 class BaseSignalPathTest : public MixxxTest {
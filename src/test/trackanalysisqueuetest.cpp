@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+
+#include "analyzer/trackanalysisqueue.h"
+
+namespace {
+
+typedef TrackAnalysisPriority Priority;
+
+class TrackAnalysisQueueTest : public testing::Test {
+  protected:
+    // Pops all tracks in the order of the queue
+    QList<TrackId> popAll() {
+        QList<TrackId> trackIds;
+        TrackId trackId;
+        Priority priority;
+        while (m_queue.front(&trackId, &priority)) {
+            trackIds.append(trackId);
+            m_queue.popFront();
+        }
+        EXPECT_TRUE(m_queue.isEmpty());
+        return trackIds;
+    }
+
+    TrackAnalysisQueue m_queue;
+};
+
+TEST_F(TrackAnalysisQueueTest, HigherPriorityFirstThenInOrder) {
+    m_queue.enqueue(TrackId(1), Priority::Batch);
+    m_queue.enqueue(TrackId(2), Priority::Background);
+    m_queue.enqueue(TrackId(3), Priority::DeckLoaded);
+    m_queue.enqueue(TrackId(4), Priority::Batch);
+    m_queue.enqueue(TrackId(5), Priority::AutoDjUpcoming);
+    EXPECT_EQ(5, m_queue.size());
+    EXPECT_EQ(2, m_queue.size(Priority::Batch));
+
+    const QList<TrackId> expected = {
+            TrackId(3), TrackId(5), TrackId(1), TrackId(4), TrackId(2)};
+    EXPECT_EQ(expected, m_queue.trackIds());
+    EXPECT_EQ(expected, popAll());
+    EXPECT_EQ(0, m_queue.size(Priority::Batch));
+}
+
+TEST_F(TrackAnalysisQueueTest, PromotedTrackMovesForward) {
+    m_queue.enqueue(TrackId(1), Priority::Batch);
+    m_queue.enqueue(TrackId(2), Priority::Batch);
+    m_queue.enqueue(TrackId(3), Priority::DeckLoaded);
+    // A deck load of a track that waits for the batch analysis
+    m_queue.enqueue(TrackId(2), Priority::DeckLoaded);
+    EXPECT_EQ(3, m_queue.size());
+    EXPECT_EQ(1, m_queue.size(Priority::Batch));
+    EXPECT_EQ(2, m_queue.size(Priority::DeckLoaded));
+
+    TrackId trackId;
+    Priority priority;
+    ASSERT_TRUE(m_queue.front(&trackId, &priority));
+    EXPECT_EQ(TrackId(3), trackId);
+    EXPECT_EQ(Priority::DeckLoaded, priority);
+
+    // Only dequeued once
+    const QList<TrackId> expected = {TrackId(3), TrackId(2), TrackId(1)};
+    EXPECT_EQ(expected, popAll());
+}
+
+TEST_F(TrackAnalysisQueueTest, LowerPriorityIsIgnored) {
+    m_queue.enqueue(TrackId(1), Priority::Batch);
+    m_queue.enqueue(TrackId(2), Priority::AutoDjUpcoming);
+    m_queue.enqueue(TrackId(2), Priority::Background);
+    m_queue.enqueue(TrackId(2), Priority::AutoDjUpcoming);
+    EXPECT_EQ(2, m_queue.size());
+    EXPECT_EQ(1, m_queue.size(Priority::AutoDjUpcoming));
+    EXPECT_EQ(0, m_queue.size(Priority::Background));
+
+    const QList<TrackId> expected = {TrackId(2), TrackId(1)};
+    EXPECT_EQ(expected, popAll());
+}
+
+TEST_F(TrackAnalysisQueueTest, Clear) {
+    m_queue.enqueue(TrackId(1), Priority::Batch);
+    m_queue.enqueue(TrackId(1), Priority::DeckLoaded);
+    m_queue.clear();
+    EXPECT_TRUE(m_queue.isEmpty());
+    EXPECT_EQ(0, m_queue.size(Priority::DeckLoaded));
+    TrackId trackId;
+    Priority priority;
+    EXPECT_FALSE(m_queue.front(&trackId, &priority));
+
+    // A track that has been promoted before is queued again
+    m_queue.enqueue(TrackId(1), Priority::Batch);
+    EXPECT_EQ(QList<TrackId>{TrackId(1)}, popAll());
+}
+
+// Two workers and the reserved worker at index 2
+TEST(TrackAnalysisPreemptionTest, LowerPrioritiesArePreempted) {
+    TrackAnalysisPreemption preemption(3);
+    preemption.setBusy(0, Priority::Batch);
+    preemption.setBusy(1, Priority::Batch);
+    EXPECT_FALSE(preemption.isPreempted(0));
+    EXPECT_FALSE(preemption.isPreempted(1));
+
+    // A loaded track starts on the reserved worker and pauses the batch
+    preemption.setBusy(2, Priority::DeckLoaded);
+    EXPECT_TRUE(preemption.isPreempted(0));
+    EXPECT_TRUE(preemption.isPreempted(1));
+    EXPECT_FALSE(preemption.isPreempted(2));
+
+    // The batch continues after the loaded track is done
+    preemption.setIdle(2);
+    EXPECT_FALSE(preemption.isPreempted(0));
+    EXPECT_FALSE(preemption.isPreempted(1));
+    EXPECT_FALSE(preemption.isPreempted(2));
+}
+
+TEST(TrackAnalysisPreemptionTest, OnlyTheHighestPriorityContinues) {
+    TrackAnalysisPreemption preemption(3);
+    preemption.setBusy(0, Priority::Background);
+    preemption.setBusy(1, Priority::Batch);
+    EXPECT_TRUE(preemption.isPreempted(0));
+    EXPECT_FALSE(preemption.isPreempted(1));
+
+    preemption.setBusy(2, Priority::AutoDjUpcoming);
+    EXPECT_TRUE(preemption.isPreempted(0));
+    EXPECT_TRUE(preemption.isPreempted(1));
+    EXPECT_FALSE(preemption.isPreempted(2));
+
+    preemption.setIdle(1);
+    preemption.setIdle(2);
+    EXPECT_FALSE(preemption.isPreempted(0));
+}
+
+TEST(TrackAnalysisPreemptionTest, ReservedWorkerOnlyStartsPreemptingTracks) {
+    TrackAnalysisPreemption preemption(3);
+    // Nothing to preempt while all workers are idle
+    EXPECT_FALSE(preemption.wouldPreempt(Priority::DeckLoaded));
+
+    preemption.setBusy(0, Priority::Batch);
+    preemption.setBusy(1, Priority::Batch);
+    EXPECT_TRUE(preemption.wouldPreempt(Priority::DeckLoaded));
+    EXPECT_TRUE(preemption.wouldPreempt(Priority::AutoDjUpcoming));
+    // More batch tracks wait for a regular worker
+    EXPECT_FALSE(preemption.wouldPreempt(Priority::Batch));
+    EXPECT_FALSE(preemption.wouldPreempt(Priority::Background));
+
+    preemption.setBusy(1, Priority::DeckLoaded);
+    EXPECT_TRUE(preemption.wouldPreempt(Priority::DeckLoaded));
+    preemption.setIdle(0);
+    EXPECT_FALSE(preemption.wouldPreempt(Priority::DeckLoaded));
+}
+
+} // anonymous namespace
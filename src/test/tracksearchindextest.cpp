@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+
+#include "library/tracksearchindex.h"
+#include "test/mixxxtest.h"
+
+namespace {
+
+class TrackSearchIndexTest : public MixxxTest {
+  protected:
+    TrackSearchIndexTest()
+            : m_index(QStringList() << "artist" << "title") {
+        m_index.updateTrack(TrackId(1), QStringList() << "Daft Punk" << "One More Time");
+        m_index.updateTrack(TrackId(2), QStringList() << "Röyksopp" << "Eple");
+        m_index.updateTrack(TrackId(3), QStringList() << "Daft Punk" << "Aerodynamic");
+    }
+
+    QList<TrackId> search(const QString& argument, const QVector<int>& columns) {
+        QBitArray rows;
+        EXPECT_TRUE(m_index.rowsOf(
+                QSet<TrackId>() << TrackId(1) << TrackId(2) << TrackId(3),
+                &rows));
+        m_index.filterRows(columns, argument, &rows);
+        QList<TrackId> trackIds;
+        for (int row = 0; row < rows.size(); ++row) {
+            if (rows.testBit(row)) {
+                trackIds << m_index.trackId(row);
+            }
+        }
+        return trackIds;
+    }
+
+    QList<TrackId> search(const QString& argument) {
+        return search(argument, QVector<int>() << 0 << 1);
+    }
+
+    TrackSearchIndex m_index;
+};
+
+TEST_F(TrackSearchIndexTest, Substrings) {
+    EXPECT_EQ(QList<TrackId>() << TrackId(1) << TrackId(3), search("daft"));
+    EXPECT_EQ(QList<TrackId>() << TrackId(1), search("more t"));
+    EXPECT_EQ(QList<TrackId>() << TrackId(3), search("dyn"));
+    // Shorter than a trigram
+    EXPECT_EQ(QList<TrackId>() << TrackId(1) << TrackId(2) << TrackId(3), search("e"));
+    EXPECT_EQ(QList<TrackId>() << TrackId(2), search("pl"));
+    EXPECT_TRUE(search("punk daft").isEmpty());
+    EXPECT_TRUE(search("xyz").isEmpty());
+}
+
+TEST_F(TrackSearchIndexTest, NormalizedLikeDatabase) {
+    // Values are case and accent insensitive, arguments
+    // must already be normalized
+    EXPECT_EQ(QList<TrackId>() << TrackId(2), search("royksopp"));
+}
+
+TEST_F(TrackSearchIndexTest, SelectedColumns) {
+    EXPECT_EQ(QList<TrackId>() << TrackId(1), search("one", QVector<int>() << 1));
+    EXPECT_TRUE(search("one", QVector<int>() << 0).isEmpty());
+    EXPECT_EQ(0, m_index.columnIndex("artist"));
+    EXPECT_EQ(-1, m_index.columnIndex("album"));
+}
+
+TEST_F(TrackSearchIndexTest, UpdateAndRemove) {
+    EXPECT_EQ(3, m_index.trackCount());
+    // Identical values are only stored once
+    const int valueCount = m_index.valueCount();
+
+    m_index.updateTrack(TrackId(2), QStringList() << "Daft Punk" << "Harder");
+    EXPECT_EQ(QList<TrackId>() << TrackId(1) << TrackId(2) << TrackId(3), search("daft"));
+    EXPECT_TRUE(search("eple").isEmpty());
+    EXPECT_EQ(valueCount + 1, m_index.valueCount());
+
+    m_index.removeTrack(TrackId(1));
+    EXPECT_EQ(2, m_index.trackCount());
+    EXPECT_EQ(-1, m_index.row(TrackId(1)));
+    QBitArray rows;
+    EXPECT_FALSE(m_index.rowsOf(QSet<TrackId>() << TrackId(1), &rows));
+
+    // The row is reused
+    const int rowCount = m_index.rowCount();
+    m_index.updateTrack(TrackId(4), QStringList() << "Air" << "Sexy Boy");
+    EXPECT_EQ(rowCount, m_index.rowCount());
+    EXPECT_EQ(TrackId(4), m_index.trackId(m_index.row(TrackId(4))));
+
+    m_index.clear();
+    EXPECT_EQ(0, m_index.trackCount());
+    EXPECT_EQ(0, m_index.rowCount());
+}
+
+} // anonymous namespace
@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+
+#include "engine/deckstate.h"
+#include "util/triplebuffer.h"
+
+namespace {
+
+TEST(TripleBufferTest, LatestValue) {
+    TripleBuffer<int> buffer;
+    EXPECT_FALSE(buffer.update());
+    EXPECT_EQ(0, buffer.readBuffer());
+
+    buffer.writeBuffer() = 1;
+    buffer.publish();
+    buffer.writeBuffer() = 2;
+    buffer.publish();
+    // The value that has not been read is dropped
+    EXPECT_TRUE(buffer.update());
+    EXPECT_EQ(2, buffer.readBuffer());
+    EXPECT_FALSE(buffer.update());
+    EXPECT_EQ(2, buffer.readBuffer());
+
+    buffer.writeBuffer() = 3;
+    // Not published yet
+    EXPECT_FALSE(buffer.update());
+    EXPECT_EQ(2, buffer.readBuffer());
+    buffer.publish();
+    EXPECT_TRUE(buffer.update());
+    EXPECT_EQ(3, buffer.readBuffer());
+}
+
+struct Pair {
+    int first;
+    int second;
+};
+
+TEST(TripleBufferTest, ConsistentAcrossThreads) {
+    constexpr int kCount = 100000;
+    TripleBuffer<Pair> buffer;
+    std::atomic<bool> done(false);
+
+    std::thread writer([&buffer, &done] {
+        for (int i = 1; i <= kCount; ++i) {
+            Pair& pair = buffer.writeBuffer();
+            pair.first = i;
+            pair.second = -i;
+            buffer.publish();
+        }
+        done.store(true);
+    });
+
+    int last = 0;
+    while (!done.load()) {
+        buffer.update();
+        const Pair& pair = buffer.readBuffer();
+        ASSERT_EQ(-pair.first, pair.second);
+        ASSERT_LE(last, pair.first);
+        last = pair.first;
+    }
+    writer.join();
+    buffer.update();
+    EXPECT_EQ(kCount, buffer.readBuffer().first);
+}
+
+TEST(DeckStatePublisherTest, ReadersAreIndependent) {
+    auto pPublisher = DeckStatePublisher::createPublisher("[DeckStateTest]");
+    EXPECT_EQ(pPublisher, DeckStatePublisher::getPublisher("[DeckStateTest]"));
+    EXPECT_TRUE(DeckStatePublisher::getPublisher("[NoDeck]").isNull());
+
+    typedef DeckStatePublisher::Reader Reader;
+    EXPECT_EQ(0u, pPublisher->read(Reader::Gui).version);
+
+    DeckState state;
+    state.playPosition = 0.25;
+    pPublisher->publish(state);
+    EXPECT_EQ(1u, pPublisher->read(Reader::Gui).version);
+    EXPECT_EQ(0.25, pPublisher->read(Reader::Gui).playPosition);
+
+    state.playPosition = 0.5;
+    pPublisher->publish(state);
+    EXPECT_EQ(2u, pPublisher->read(Reader::Gui).version);
+    // The controllers have missed the first snapshot
+    EXPECT_EQ(2u, pPublisher->read(Reader::Controllers).version);
+    EXPECT_EQ(0.5, pPublisher->read(Reader::Controllers).playPosition);
+}
+
+} // anonymous namespace
@@ -0,0 +1,228 @@
+#include <benchmark/benchmark.h>
+#include <gtest/gtest.h>
+
+#include <random>
+
+#include "proto/waveform.pb.h"
+#include "util/math.h"
+#include "waveform/waveform.h"
+
+namespace {
+
+constexpr int kSampleRate = 44100;
+// 10 s with 441 visual samples per second
+constexpr int kAudioSamples = 2 * 10 * kSampleRate;
+
+void fillRandom(Waveform* pWaveform, int startIndex, int endIndex) {
+    std::mt19937 generator(startIndex);
+    std::uniform_int_distribution<int> distribution(0, 255);
+    for (int i = startIndex; i < endIndex; ++i) {
+        WaveformData& data = pWaveform->data()[i];
+        data.filtered.low = static_cast<unsigned char>(distribution(generator));
+        data.filtered.mid = static_cast<unsigned char>(distribution(generator));
+        data.filtered.high = static_cast<unsigned char>(distribution(generator));
+        data.filtered.all = static_cast<unsigned char>(distribution(generator));
+    }
+}
+
+// The maximum of the data elements of a channel that are reduced into
+// the given data element of the level
+WaveformData expectedMax(const Waveform& waveform, int level, int index) {
+    const int channel = index % 2;
+    const int first = (index / 2) << level;
+    const int last = math_min((index / 2 + 1) << level, waveform.getDataSize() / 2);
+    WaveformData max(0);
+    for (int i = first; i < last; ++i) {
+        const WaveformData& data = waveform.get(2 * i + channel);
+        max.filtered.low = math_max(max.filtered.low, data.filtered.low);
+        max.filtered.mid = math_max(max.filtered.mid, data.filtered.mid);
+        max.filtered.high = math_max(max.filtered.high, data.filtered.high);
+        max.filtered.all = math_max(max.filtered.all, data.filtered.all);
+    }
+    return max;
+}
+
+void expectSameData(const Waveform& expected, const Waveform& actual) {
+    ASSERT_EQ(expected.getDataSize(), actual.getDataSize());
+    for (int i = 0; i < expected.getDataSize(); ++i) {
+        EXPECT_EQ(expected.get(i).m_i, actual.get(i).m_i) << i;
+    }
+}
+
+void expectMipLevels(const Waveform& waveform) {
+    for (int level = 1; level < waveform.getMipLevelCount(); ++level) {
+        const WaveformData* pLevel = waveform.mipLevelData(level);
+        for (int i = 0; i < waveform.getMipLevelDataSize(level); ++i) {
+            EXPECT_EQ(expectedMax(waveform, level, i).m_i, pLevel[i].m_i)
+                    << "level " << level << " index " << i;
+        }
+    }
+}
+
+TEST(WaveformTest, MipLevels) {
+    Waveform waveform(kSampleRate, kAudioSamples, 441, -1);
+    const int dataSize = waveform.getDataSize();
+    ASSERT_EQ(0, dataSize % 2);
+
+    // Down to a single visual sample
+    ASSERT_LT(1, waveform.getMipLevelCount());
+    EXPECT_EQ(dataSize, waveform.getMipLevelDataSize(0));
+    EXPECT_EQ(waveform.data(), waveform.mipLevelData(0));
+    EXPECT_EQ(2, waveform.getMipLevelDataSize(waveform.getMipLevelCount() - 1));
+    for (int level = 1; level < waveform.getMipLevelCount(); ++level) {
+        EXPECT_EQ(2 * ((waveform.getMipLevelDataSize(level - 1) / 2 + 1) / 2),
+                waveform.getMipLevelDataSize(level));
+    }
+
+    fillRandom(&waveform, 0, dataSize);
+    waveform.updateMipLevels(0, dataSize);
+    expectMipLevels(waveform);
+}
+
+TEST(WaveformTest, UpdateMipLevelsIncrementally) {
+    Waveform waveform(kSampleRate, kAudioSamples, 441, -1);
+    const int dataSize = waveform.getDataSize();
+    // Odd ranges like the strides of a single channel
+    const int ranges[] = {0, 7, 8, 1001, 1002, 4095, dataSize};
+    for (size_t i = 1; i < sizeof(ranges) / sizeof(ranges[0]); ++i) {
+        fillRandom(&waveform, ranges[i - 1], ranges[i]);
+        waveform.updateMipLevels(ranges[i - 1], ranges[i]);
+    }
+    expectMipLevels(waveform);
+
+    // Not in order, like a provisional waveform
+    fillRandom(&waveform, 3000, 5000);
+    waveform.updateMipLevels(3000, 5000);
+    fillRandom(&waveform, 101, 123);
+    waveform.updateMipLevels(101, 123);
+    expectMipLevels(waveform);
+}
+
+TEST(WaveformTest, MipLevelForVisualSamples) {
+    Waveform waveform(kSampleRate, kAudioSamples, 441, -1);
+    EXPECT_EQ(0, waveform.mipLevelForVisualSamples(0.5));
+    EXPECT_EQ(0, waveform.mipLevelForVisualSamples(1.9));
+    EXPECT_EQ(1, waveform.mipLevelForVisualSamples(2.0));
+    EXPECT_EQ(1, waveform.mipLevelForVisualSamples(3.9));
+    EXPECT_EQ(5, waveform.mipLevelForVisualSamples(40.0));
+    EXPECT_EQ(waveform.getMipLevelCount() - 1,
+            waveform.mipLevelForVisualSamples(1e9));
+}
+
+TEST(WaveformTest, EmptyWaveform) {
+    Waveform waveform;
+    EXPECT_EQ(1, waveform.getMipLevelCount());
+    EXPECT_EQ(0, waveform.mipLevelForVisualSamples(100.0));
+}
+
+TEST(WaveformTest, BinaryFormatRoundTrip) {
+    Waveform waveform(kSampleRate, kAudioSamples, 441, -1);
+    fillRandom(&waveform, 0, waveform.getDataSize());
+    const QByteArray byteArray = waveform.toByteArray();
+    EXPECT_TRUE(Waveform::isBinaryFormat(byteArray));
+
+    const Waveform loaded(byteArray);
+    EXPECT_TRUE(loaded.isValid());
+    EXPECT_EQ(Waveform::SaveState::Saved, loaded.saveState());
+    EXPECT_EQ(waveform.getAudioVisualRatio(), loaded.getAudioVisualRatio());
+    EXPECT_EQ(waveform.getDataSize(), loaded.getCompletion());
+    expectSameData(waveform, loaded);
+    expectMipLevels(loaded);
+}
+
+TEST(WaveformTest, InvalidBinaryFormat) {
+    Waveform waveform(kSampleRate, kAudioSamples, 441, -1);
+    const QByteArray byteArray = waveform.toByteArray();
+
+    const Waveform truncated(byteArray.left(byteArray.size() - 1));
+    EXPECT_FALSE(truncated.isValid());
+    EXPECT_EQ(Waveform::SaveState::NotSaved, truncated.saveState());
+
+    QByteArray otherVersion = byteArray;
+    // The first byte of the format version
+    otherVersion[4] = 2;
+    const Waveform other(otherVersion);
+    EXPECT_FALSE(other.isValid());
+}
+
+TEST(WaveformTest, ReadProtobufFormat) {
+    Waveform waveform(kSampleRate, kAudioSamples, 441, -1);
+    fillRandom(&waveform, 0, waveform.getDataSize());
+
+    // Like the Waveform 5.0 analyses of previous versions
+    mixxx::track::io::Waveform proto;
+    proto.set_visual_sample_rate(441);
+    proto.set_audio_visual_ratio(waveform.getAudioVisualRatio());
+    auto* pAll = proto.mutable_signal_all();
+    auto* pLow = proto.mutable_signal_filtered()->mutable_low();
+    auto* pMid = proto.mutable_signal_filtered()->mutable_mid();
+    auto* pHigh = proto.mutable_signal_filtered()->mutable_high();
+    for (auto* pSignal : {pAll, pLow, pMid, pHigh}) {
+        pSignal->set_units(mixxx::track::io::Waveform::RMS);
+        pSignal->set_channels(2);
+    }
+    for (int i = 0; i < waveform.getDataSize(); ++i) {
+        pAll->add_value(waveform.getAll(i));
+        pLow->add_value(waveform.getLow(i));
+        pMid->add_value(waveform.getMid(i));
+        pHigh->add_value(waveform.getHigh(i));
+    }
+    std::string output;
+    ASSERT_TRUE(proto.SerializeToString(&output));
+    const QByteArray byteArray(output.data(), static_cast<int>(output.size()));
+    EXPECT_FALSE(Waveform::isBinaryFormat(byteArray));
+
+    const Waveform loaded(byteArray);
+    EXPECT_TRUE(loaded.isValid());
+    expectSameData(waveform, loaded);
+    expectMipLevels(loaded);
+
+    // Converted into the binary format when stored again
+    const Waveform converted(loaded.toByteArray());
+    expectSameData(waveform, converted);
+}
+
+static void BM_WaveformLoad(benchmark::State& state) {
+    // 5 minutes
+    Waveform waveform(kSampleRate, 30 * kAudioSamples, 441, -1);
+    fillRandom(&waveform, 0, waveform.getDataSize());
+    const QByteArray byteArray = waveform.toByteArray();
+    for (auto _ : state) {
+        Waveform loaded(byteArray);
+        benchmark::DoNotOptimize(loaded.data());
+    }
+}
+BENCHMARK(BM_WaveformLoad);
+
+// Reduces the visual samples of 1000 pixels like the renderers do
+static void BM_WaveformReducePixels(benchmark::State& state) {
+    // 20 minutes
+    Waveform waveform(kSampleRate, 120 * kAudioSamples, 441, -1);
+    fillRandom(&waveform, 0, waveform.getDataSize());
+    waveform.updateMipLevels(0, waveform.getDataSize());
+    const int pixels = 1000;
+    const int visualSamplesPerPixel = waveform.getDataSize() / 2 / pixels;
+    const bool useMipLevels = state.range(0) != 0;
+    const int level = useMipLevels
+            ? waveform.mipLevelForVisualSamples(visualSamplesPerPixel)
+            : 0;
+    const WaveformData* pData = waveform.mipLevelData(level);
+    const int dataSize = waveform.getMipLevelDataSize(level);
+    for (auto _ : state) {
+        int sum = 0;
+        for (int x = 0; x < pixels; ++x) {
+            const int start = 2 * ((x * visualSamplesPerPixel) >> level);
+            const int stop = math_min(
+                    2 * (((x + 1) * visualSamplesPerPixel) >> level), dataSize);
+            unsigned char max = 0;
+            for (int i = start; i < stop; ++i) {
+                max = math_max(max, pData[i].filtered.all);
+            }
+            sum += max;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+}
+BENCHMARK(BM_WaveformReducePixels)->Arg(0)->Arg(1);
+
+} // anonymous namespace
@@ -711,12 +711,29 @@ QString Track::getURL() const {
 }
 
 ConstWaveformPointer Track::getWaveform() const {
+    QMutexLocker lock(&m_qMutex);
     return m_waveform;
 }
 
 void Track::setWaveform(ConstWaveformPointer pWaveform) {
+    QMutexLocker lock(&m_qMutex);
+    m_waveform = pWaveform;
+    lock.unlock();
+    emit waveformUpdated();
+}
+
+bool Track::setProvisionalWaveform(ConstWaveformPointer pWaveform) {
+    DEBUG_ASSERT(pWaveform && pWaveform->isProvisional());
+    QMutexLocker lock(&m_qMutex);
+    // Checked while locked, because the analyzer might set its waveform
+    // concurrently
+    if (m_waveform && !m_waveform->isProvisional()) {
+        return false;
+    }
     m_waveform = pWaveform;
+    lock.unlock();
     emit waveformUpdated();
+    return true;
 }
 
 ConstWaveformPointer Track::getWaveformSummary() const {
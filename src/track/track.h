@@ -249,6 +249,9 @@ class Track : public QObject {
 
     ConstWaveformPointer getWaveform() const;
     void setWaveform(ConstWaveformPointer pWaveform);
+    // Sets a provisional waveform unless an analyzed or stored waveform
+    // has been set. Returns false if the waveform has not been set.
+    bool setProvisionalWaveform(ConstWaveformPointer pWaveform);
 
     ConstWaveformPointer getWaveformSummary() const;
     void setWaveformSummary(ConstWaveformPointer pWaveform);
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "util/assert.h"
+#include "util/math.h"
+#include "util/types.h"
+
+namespace mixxx {
+
+// A ring buffer of interleaved frames for delay based effects and filters.
+//
+// The capacity is rounded up to a power of two, so wrapping the positions
+// is a bit mask instead of a modulo. Blocks of frames are copied in at
+// most two contiguous spans, which the compiler turns into vector moves.
+//
+// Delays are counted as the age of a frame: Age 0 is the most recently
+// written frame, age capacity() - 1 the oldest one still in the buffer.
+//
+// Allocates only when constructed or resized, so these must not be called
+// from the engine thread.
+template<typename T, int kChannelCount>
+class DelayLine {
+  public:
+    explicit DelayLine(SINT minCapacity = 1) {
+        resize(minCapacity);
+    }
+
+    // Discards the content and makes room for at least minCapacity frames
+    void resize(SINT minCapacity) {
+        const SINT capacity = roundUpToPowerOf2(
+                static_cast<int>(math_max<SINT>(minCapacity, 1)));
+        DEBUG_ASSERT(capacity > 0);
+        m_frames.assign(capacity * kChannelCount, T(0));
+        m_mask = capacity - 1;
+        m_writeFrame = 0;
+    }
+
+    // The number of frames in the buffer
+    SINT capacity() const {
+        return m_mask + 1;
+    }
+
+    void clear() {
+        std::fill(m_frames.begin(), m_frames.end(), T(0));
+        m_writeFrame = 0;
+    }
+
+    // Returns the kChannelCount samples of a frame
+    const T* frame(SINT age) const {
+        DEBUG_ASSERT(age >= 0 && age <= m_mask);
+        return &m_frames[((m_writeFrame - 1 - age) & m_mask) * kChannelCount];
+    }
+
+    // Linearly interpolates a frame between two written ones
+    void readInterpolated(T* pFrame, double age) const {
+        const double ageFloor = std::floor(age);
+        const auto frac = static_cast<T>(age - ageFloor);
+        const T* pPrev = frame(static_cast<SINT>(ageFloor));
+        const T* pNext = frame(static_cast<SINT>(std::ceil(age)));
+        for (int channel = 0; channel < kChannelCount; ++channel) {
+            pFrame[channel] = pPrev[channel] + frac * (pNext[channel] - pPrev[channel]);
+        }
+    }
+
+    void writeFrame(const T* pFrame) {
+        std::copy(pFrame, pFrame + kChannelCount,
+                &m_frames[m_writeFrame * kChannelCount]);
+        m_writeFrame = (m_writeFrame + 1) & m_mask;
+    }
+
+    void write(const T* pFrames, SINT frames) {
+        DEBUG_ASSERT(frames <= capacity());
+        const SINT firstFrames = math_min(frames, capacity() - m_writeFrame);
+        std::copy(pFrames, pFrames + firstFrames * kChannelCount,
+                &m_frames[m_writeFrame * kChannelCount]);
+        std::copy(pFrames + firstFrames * kChannelCount,
+                pFrames + frames * kChannelCount,
+                m_frames.begin());
+        m_writeFrame = (m_writeFrame + frames) & m_mask;
+    }
+
+    // Reads the most recently written frames delayed by delayFrames, so
+    // that a write() followed by a read() of the same frames delays them.
+    void read(T* pFrames, SINT frames, SINT delayFrames) const {
+        DEBUG_ASSERT(delayFrames >= 0 && frames + delayFrames <= capacity());
+        const SINT readFrame = (m_writeFrame - frames - delayFrames) & m_mask;
+        const SINT firstFrames = math_min(frames, capacity() - readFrame);
+        const T* pFirst = &m_frames[readFrame * kChannelCount];
+        std::copy(pFirst, pFirst + firstFrames * kChannelCount, pFrames);
+        std::copy(m_frames.begin(),
+                m_frames.begin() + (frames - firstFrames) * kChannelCount,
+                pFrames + firstFrames * kChannelCount);
+    }
+
+    // Delays a buffer of any length by delayFrames, which must be less than
+    // the capacity. pIn and pOut may be the same buffer.
+    void process(const T* pIn, T* pOut, SINT frames, SINT delayFrames) {
+        VERIFY_OR_DEBUG_ASSERT(delayFrames >= 0 && delayFrames < capacity()) {
+            delayFrames = math_clamp<SINT>(delayFrames, 0, m_mask);
+        }
+        const SINT maxChunkFrames = capacity() - delayFrames;
+        while (frames > 0) {
+            const SINT chunkFrames = math_min(frames, maxChunkFrames);
+            write(pIn, chunkFrames);
+            read(pOut, chunkFrames, delayFrames);
+            pIn += chunkFrames * kChannelCount;
+            pOut += chunkFrames * kChannelCount;
+            frames -= chunkFrames;
+        }
+    }
+
+  private:
+    std::vector<T> m_frames;
+    SINT m_mask;
+    // The position of the next written frame
+    SINT m_writeFrame;
+};
+
+} // namespace mixxx
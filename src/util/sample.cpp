@@ -3,6 +3,7 @@
 
 #include "util/sample.h"
 #include "util/math.h"
+#include "util/samplekernels.h"
 
 #ifdef __WINDOWS__
 #include <QtGlobal>
@@ -16,9 +17,17 @@ typedef qint32 int32_t;
 // https://gcc.gnu.org/projects/tree-ssa/vectorization.html
 // This also utilizes AVX registers when compiled for a recent 64-bit CPU
 // using scons optimize=native.
+//
+// The hottest loops are dispatched at runtime through the kernel table in
+// util/samplekernels.h, which picks hand-vectorized AVX2 or AVX-512 kernels
+// if the CPU supports them, independent of the build baseline.
 
 namespace {
 
+inline const mixxx::samplekernels::Table& kernels() {
+    return mixxx::samplekernels::activeTable();
+}
+
 #ifdef __AVX__
 constexpr size_t kAlignment = 32;
 #else
@@ -116,10 +125,7 @@ void SampleUtil::applyGain(CSAMPLE* pBuffer, CSAMPLE_GAIN gain,
         return;
     }
 
-    // note: LOOP VECTORIZED.
-    for (SINT i = 0; i < numSamples; ++i) {
-        pBuffer[i] *= gain;
-    }
+    kernels().applyGain(pBuffer, gain, numSamples);
 }
 
 // static
@@ -137,18 +143,9 @@ void SampleUtil::applyRampingGain(CSAMPLE* pBuffer, CSAMPLE_GAIN old_gain,
             / CSAMPLE_GAIN(numSamples / 2);
     if (gain_delta) {
         const CSAMPLE_GAIN start_gain = old_gain + gain_delta;
-        // note: LOOP VECTORIZED.
-        for (int i = 0; i < numSamples / 2; ++i) {
-            const CSAMPLE_GAIN gain = start_gain + gain_delta * i;
-            // a loop counter i += 2 prevents vectorizing.
-            pBuffer[i * 2] *= gain;
-            pBuffer[i * 2 + 1] *= gain;
-        }
+        kernels().applyRampingGain(pBuffer, start_gain, gain_delta, numSamples / 2);
     } else {
-        // note: LOOP VECTORIZED.
-        for (int i = 0; i < numSamples; ++i) {
-            pBuffer[i] *= old_gain;
-        }
+        kernels().applyGain(pBuffer, old_gain, numSamples);
     }
 }
 
@@ -213,10 +210,7 @@ void SampleUtil::applyRampingAlternatingGain(CSAMPLE* pBuffer,
 void SampleUtil::add(CSAMPLE* M_RESTRICT pDest,
         const CSAMPLE* M_RESTRICT pSrc,
         SINT numSamples) {
-    // note: LOOP VECTORIZED.
-    for (SINT i = 0; i < numSamples; ++i) {
-        pDest[i] += pSrc[i];
-    }
+    kernels().add(pDest, pSrc, numSamples);
 }
 
 // static
@@ -227,10 +221,7 @@ void SampleUtil::addWithGain(CSAMPLE* M_RESTRICT pDest,
         return;
     }
 
-    // note: LOOP VECTORIZED.
-    for (SINT i = 0; i < numSamples; ++i) {
-        pDest[i] += pSrc[i] * gain;
-    }
+    kernels().addWithGain(pDest, pSrc, gain, numSamples);
 }
 
 void SampleUtil::addWithRampingGain(CSAMPLE* M_RESTRICT pDest,
@@ -245,17 +236,10 @@ void SampleUtil::addWithRampingGain(CSAMPLE* M_RESTRICT pDest,
             / CSAMPLE_GAIN(numSamples / 2);
     if (gain_delta) {
         const CSAMPLE_GAIN start_gain = old_gain + gain_delta;
-        // note: LOOP VECTORIZED.
-        for (int i = 0; i < numSamples / 2; ++i) {
-            const CSAMPLE_GAIN gain = start_gain + gain_delta * i;
-            pDest[i * 2] += pSrc[i * 2] * gain;
-            pDest[i * 2 + 1] += pSrc[i * 2 + 1] * gain;
-        }
+        kernels().addWithRampingGain(
+                pDest, pSrc, start_gain, gain_delta, numSamples / 2);
     } else {
-        // note: LOOP VECTORIZED.
-        for (int i = 0; i < numSamples; ++i) {
-            pDest[i] += pSrc[i] * old_gain;
-        }
+        kernels().addWithGain(pDest, pSrc, old_gain, numSamples);
     }
 }
 
@@ -270,10 +254,7 @@ void SampleUtil::add2WithGain(CSAMPLE* M_RESTRICT pDest,
         return addWithGain(pDest, pSrc1, gain1, numSamples);
     }
 
-    // note: LOOP VECTORIZED.
-    for (int i = 0; i < numSamples; ++i) {
-        pDest[i] += pSrc1[i] * gain1 + pSrc2[i] * gain2;
-    }
+    kernels().add2WithGain(pDest, pSrc1, gain1, pSrc2, gain2, numSamples);
 }
 
 // static
@@ -290,10 +271,8 @@ void SampleUtil::add3WithGain(CSAMPLE* pDest,
         return add2WithGain(pDest, pSrc1, gain1, pSrc2, gain2, numSamples);
     }
 
-    // note: LOOP VECTORIZED.
-    for (SINT i = 0; i < numSamples; ++i) {
-        pDest[i] += pSrc1[i] * gain1 + pSrc2[i] * gain2 + pSrc3[i] * gain3;
-    }
+    kernels().add3WithGain(pDest,
+            pSrc1, gain1, pSrc2, gain2, pSrc3, gain3, numSamples);
 }
 
 // static
@@ -309,10 +288,7 @@ void SampleUtil::copyWithGain(CSAMPLE* M_RESTRICT pDest,
         return;
     }
 
-    // note: LOOP VECTORIZED.
-    for (SINT i = 0; i < numSamples; ++i) {
-        pDest[i] = pSrc[i] * gain;
-    }
+    kernels().copyWithGain(pDest, pSrc, gain, numSamples);
 
     // OR! need to test which fares better
     // copy(pDest, pSrc, iNumSamples);
@@ -338,17 +314,10 @@ void SampleUtil::copyWithRampingGain(CSAMPLE* M_RESTRICT pDest,
             / CSAMPLE_GAIN(numSamples / 2);
     if (gain_delta) {
         const CSAMPLE_GAIN start_gain = old_gain + gain_delta;
-        // note: LOOP VECTORIZED only with "int i"
-        for (int i = 0; i < numSamples / 2; ++i) {
-            const CSAMPLE_GAIN gain = start_gain + gain_delta * i;
-            pDest[i * 2] = pSrc[i * 2] * gain;
-            pDest[i * 2 + 1] = pSrc[i * 2 + 1] * gain;
-        }
+        kernels().copyWithRampingGain(
+                pDest, pSrc, start_gain, gain_delta, numSamples / 2);
     } else {
-        // note: LOOP VECTORIZED.
-        for (SINT i = 0; i < numSamples; ++i) {
-            pDest[i] = pSrc[i] * old_gain;
-        }
+        kernels().copyWithGain(pDest, pSrc, old_gain, numSamples);
     }
 
     // OR! need to test which fares better
@@ -415,10 +384,7 @@ SampleUtil::CLIP_STATUS SampleUtil::sumAbsPerChannel(CSAMPLE* pfAbsL,
 // static
 void SampleUtil::copyClampBuffer(CSAMPLE* M_RESTRICT pDest,
         const CSAMPLE* M_RESTRICT pSrc, SINT iNumSamples) {
-    // note: LOOP VECTORIZED.
-    for (SINT i = 0; i < iNumSamples; ++i) {
-        pDest[i] = clampSample(pSrc[i]);
-    }
+    kernels().copyClampBuffer(pDest, pSrc, iNumSamples);
 }
 
 // static
@@ -426,11 +392,7 @@ void SampleUtil::interleaveBuffer(CSAMPLE* M_RESTRICT pDest,
         const CSAMPLE* M_RESTRICT pSrc1,
         const CSAMPLE* M_RESTRICT pSrc2,
         SINT numFrames) {
-    // note: LOOP VECTORIZED.
-    for (SINT i = 0; i < numFrames; ++i) {
-        pDest[2 * i] = pSrc1[i];
-        pDest[2 * i + 1] = pSrc2[i];
-    }
+    kernels().interleaveBuffer(pDest, pSrc1, pSrc2, numFrames);
 }
 
 // static
@@ -438,11 +400,7 @@ void SampleUtil::deinterleaveBuffer(CSAMPLE* M_RESTRICT pDest1,
         CSAMPLE* M_RESTRICT pDest2,
         const CSAMPLE* M_RESTRICT pSrc,
         SINT numFrames) {
-    // note: LOOP VECTORIZED.
-    for (SINT i = 0; i < numFrames; ++i) {
-        pDest1[i] = pSrc[i * 2];
-        pDest2[i] = pSrc[i * 2 + 1];
-    }
+    kernels().deinterleaveBuffer(pDest1, pDest2, pSrc, numFrames);
 }
 
 // static
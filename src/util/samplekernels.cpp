@@ -0,0 +1,260 @@
+#include "util/samplekernels.h"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+// This translation unit is compiled without -ffast-math and with
+// -ffp-contract=off, see CMakeLists.txt. The scalar kernels are the reference
+// for the hand-vectorized kernels and must not be reassociated or fused
+// differently by the compiler. They are still auto-vectorized for the
+// baseline instruction set.
+
+namespace mixxx {
+
+namespace samplekernels {
+
+namespace {
+
+void applyGainScalar(CSAMPLE* pBuffer,
+        CSAMPLE_GAIN gain,
+        SINT numSamples) {
+    // note: LOOP VECTORIZED.
+    for (SINT i = 0; i < numSamples; ++i) {
+        pBuffer[i] *= gain;
+    }
+}
+
+void applyRampingGainScalar(CSAMPLE* pBuffer,
+        CSAMPLE_GAIN startGain,
+        CSAMPLE_GAIN gainDelta,
+        SINT numFrames) {
+    // note: LOOP VECTORIZED.
+    for (int i = 0; i < numFrames; ++i) {
+        const CSAMPLE_GAIN gain = startGain + gainDelta * i;
+        // a loop counter i += 2 prevents vectorizing.
+        pBuffer[i * 2] *= gain;
+        pBuffer[i * 2 + 1] *= gain;
+    }
+}
+
+void copyWithGainScalar(CSAMPLE* M_RESTRICT pDest,
+        const CSAMPLE* M_RESTRICT pSrc,
+        CSAMPLE_GAIN gain,
+        SINT numSamples) {
+    // note: LOOP VECTORIZED.
+    for (SINT i = 0; i < numSamples; ++i) {
+        pDest[i] = pSrc[i] * gain;
+    }
+}
+
+void copyWithRampingGainScalar(CSAMPLE* M_RESTRICT pDest,
+        const CSAMPLE* M_RESTRICT pSrc,
+        CSAMPLE_GAIN startGain,
+        CSAMPLE_GAIN gainDelta,
+        SINT numFrames) {
+    // note: LOOP VECTORIZED only with "int i"
+    for (int i = 0; i < numFrames; ++i) {
+        const CSAMPLE_GAIN gain = startGain + gainDelta * i;
+        pDest[i * 2] = pSrc[i * 2] * gain;
+        pDest[i * 2 + 1] = pSrc[i * 2 + 1] * gain;
+    }
+}
+
+void addScalar(CSAMPLE* M_RESTRICT pDest,
+        const CSAMPLE* M_RESTRICT pSrc,
+        SINT numSamples) {
+    // note: LOOP VECTORIZED.
+    for (SINT i = 0; i < numSamples; ++i) {
+        pDest[i] += pSrc[i];
+    }
+}
+
+void addWithGainScalar(CSAMPLE* M_RESTRICT pDest,
+        const CSAMPLE* M_RESTRICT pSrc,
+        CSAMPLE_GAIN gain,
+        SINT numSamples) {
+    // note: LOOP VECTORIZED.
+    for (SINT i = 0; i < numSamples; ++i) {
+        pDest[i] += pSrc[i] * gain;
+    }
+}
+
+void addWithRampingGainScalar(CSAMPLE* M_RESTRICT pDest,
+        const CSAMPLE* M_RESTRICT pSrc,
+        CSAMPLE_GAIN startGain,
+        CSAMPLE_GAIN gainDelta,
+        SINT numFrames) {
+    // note: LOOP VECTORIZED.
+    for (int i = 0; i < numFrames; ++i) {
+        const CSAMPLE_GAIN gain = startGain + gainDelta * i;
+        pDest[i * 2] += pSrc[i * 2] * gain;
+        pDest[i * 2 + 1] += pSrc[i * 2 + 1] * gain;
+    }
+}
+
+void add2WithGainScalar(CSAMPLE* M_RESTRICT pDest,
+        const CSAMPLE* M_RESTRICT pSrc1,
+        CSAMPLE_GAIN gain1,
+        const CSAMPLE* M_RESTRICT pSrc2,
+        CSAMPLE_GAIN gain2,
+        SINT numSamples) {
+    // note: LOOP VECTORIZED.
+    for (int i = 0; i < numSamples; ++i) {
+        pDest[i] += pSrc1[i] * gain1 + pSrc2[i] * gain2;
+    }
+}
+
+void add3WithGainScalar(CSAMPLE* pDest,
+        const CSAMPLE* M_RESTRICT pSrc1,
+        CSAMPLE_GAIN gain1,
+        const CSAMPLE* M_RESTRICT pSrc2,
+        CSAMPLE_GAIN gain2,
+        const CSAMPLE* M_RESTRICT pSrc3,
+        CSAMPLE_GAIN gain3,
+        SINT numSamples) {
+    // note: LOOP VECTORIZED.
+    for (SINT i = 0; i < numSamples; ++i) {
+        pDest[i] += pSrc1[i] * gain1 + pSrc2[i] * gain2 + pSrc3[i] * gain3;
+    }
+}
+
+void copyClampBufferScalar(CSAMPLE* M_RESTRICT pDest,
+        const CSAMPLE* M_RESTRICT pSrc,
+        SINT numSamples) {
+    // note: LOOP VECTORIZED.
+    for (SINT i = 0; i < numSamples; ++i) {
+        pDest[i] = CSAMPLE_clamp(pSrc[i]);
+    }
+}
+
+void interleaveBufferScalar(CSAMPLE* M_RESTRICT pDest,
+        const CSAMPLE* M_RESTRICT pSrc1,
+        const CSAMPLE* M_RESTRICT pSrc2,
+        SINT numFrames) {
+    // note: LOOP VECTORIZED.
+    for (SINT i = 0; i < numFrames; ++i) {
+        pDest[2 * i] = pSrc1[i];
+        pDest[2 * i + 1] = pSrc2[i];
+    }
+}
+
+void deinterleaveBufferScalar(CSAMPLE* M_RESTRICT pDest1,
+        CSAMPLE* M_RESTRICT pDest2,
+        const CSAMPLE* M_RESTRICT pSrc,
+        SINT numFrames) {
+    // note: LOOP VECTORIZED.
+    for (SINT i = 0; i < numFrames; ++i) {
+        pDest1[i] = pSrc[i * 2];
+        pDest2[i] = pSrc[i * 2 + 1];
+    }
+}
+
+const Table kScalarTable = {
+        Isa::Scalar,
+        applyGainScalar,
+        applyRampingGainScalar,
+        copyWithGainScalar,
+        copyWithRampingGainScalar,
+        addScalar,
+        addWithGainScalar,
+        addWithRampingGainScalar,
+        add2WithGainScalar,
+        add3WithGainScalar,
+        copyClampBufferScalar,
+        interleaveBufferScalar,
+        deinterleaveBufferScalar,
+};
+
+struct CpuFeatures {
+    bool avx2 = false;
+    bool avx512f = false;
+};
+
+CpuFeatures detectCpuFeatures() {
+    CpuFeatures features;
+#if (defined(__GNUC__) || defined(__clang__)) && \
+        (defined(__x86_64__) || defined(__i386__))
+    // __builtin_cpu_supports() also verifies that the operating system
+    // saves the extended register state on context switches.
+    __builtin_cpu_init();
+    features.avx2 = __builtin_cpu_supports("avx2");
+    features.avx512f = __builtin_cpu_supports("avx512f");
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    int info[4];
+    __cpuid(info, 0);
+    const int maxLeaf = info[0];
+    if (maxLeaf < 7) {
+        return features;
+    }
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    if (!osxsave) {
+        return features;
+    }
+    // The OS must save the YMM (bits 1 and 2) and for AVX-512 also the
+    // opmask and ZMM registers (bits 5 to 7) on context switches.
+    const unsigned long long xcr0 = _xgetbv(0);
+    const bool osYmm = (xcr0 & 0x06) == 0x06;
+    const bool osZmm = (xcr0 & 0xe6) == 0xe6;
+    __cpuidex(info, 7, 0);
+    features.avx2 = osYmm && (info[1] & (1 << 5)) != 0;
+    features.avx512f = osZmm && (info[1] & (1 << 16)) != 0;
+#endif
+    return features;
+}
+
+const CpuFeatures& cpuFeatures() {
+    static const CpuFeatures s_features = detectCpuFeatures();
+    return s_features;
+}
+
+const Table& selectTable() {
+    // Prefer the widest vectors. Tables are only available if their
+    // translation unit was compiled with the corresponding flags.
+    const Table* pTable = tableForIsa(Isa::Avx512);
+    if (pTable) {
+        return *pTable;
+    }
+    pTable = tableForIsa(Isa::Avx2);
+    if (pTable) {
+        return *pTable;
+    }
+    return kScalarTable;
+}
+
+} // anonymous namespace
+
+const char* isaName(Isa isa) {
+    switch (isa) {
+    case Isa::Scalar:
+        return "scalar";
+    case Isa::Avx2:
+        return "AVX2";
+    case Isa::Avx512:
+        return "AVX-512";
+    }
+    return "unknown";
+}
+
+const Table* tableForIsa(Isa isa) {
+    switch (isa) {
+    case Isa::Scalar:
+        return &kScalarTable;
+    case Isa::Avx2:
+        return cpuFeatures().avx2 ? avx2Table() : nullptr;
+    case Isa::Avx512:
+        return cpuFeatures().avx512f ? avx512Table() : nullptr;
+    }
+    return nullptr;
+}
+
+const Table& activeTable() {
+    static const Table& s_table = selectTable();
+    return s_table;
+}
+
+} // namespace samplekernels
+
+} // namespace mixxx
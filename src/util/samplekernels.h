@@ -0,0 +1,104 @@
+#pragma once
+
+#include "util/platform.h"
+#include "util/types.h"
+
+namespace mixxx {
+
+namespace samplekernels {
+
+/// The instruction set a kernel table has been hand-vectorized for.
+enum class Isa {
+    Scalar,
+    Avx2,
+    Avx512,
+};
+
+/// A table of the hot inner loops of SampleUtil.
+///
+/// The kernels only contain the loops. All special cases (e.g. unity or
+/// zero gain) are handled by the SampleUtil wrappers before dispatching.
+/// Every table must produce bit-exact results compared to the scalar table,
+/// which is why all kernel translation units are compiled without fast-math
+/// and without floating-point contraction.
+///
+/// Ramping kernels operate on interleaved stereo frames: Frame i is scaled
+/// by startGain + gainDelta * i.
+struct Table {
+    Isa isa;
+    void (*applyGain)(CSAMPLE* pBuffer,
+            CSAMPLE_GAIN gain,
+            SINT numSamples);
+    void (*applyRampingGain)(CSAMPLE* pBuffer,
+            CSAMPLE_GAIN startGain,
+            CSAMPLE_GAIN gainDelta,
+            SINT numFrames);
+    void (*copyWithGain)(CSAMPLE* pDest,
+            const CSAMPLE* pSrc,
+            CSAMPLE_GAIN gain,
+            SINT numSamples);
+    void (*copyWithRampingGain)(CSAMPLE* pDest,
+            const CSAMPLE* pSrc,
+            CSAMPLE_GAIN startGain,
+            CSAMPLE_GAIN gainDelta,
+            SINT numFrames);
+    void (*add)(CSAMPLE* pDest,
+            const CSAMPLE* pSrc,
+            SINT numSamples);
+    void (*addWithGain)(CSAMPLE* pDest,
+            const CSAMPLE* pSrc,
+            CSAMPLE_GAIN gain,
+            SINT numSamples);
+    void (*addWithRampingGain)(CSAMPLE* pDest,
+            const CSAMPLE* pSrc,
+            CSAMPLE_GAIN startGain,
+            CSAMPLE_GAIN gainDelta,
+            SINT numFrames);
+    void (*add2WithGain)(CSAMPLE* pDest,
+            const CSAMPLE* pSrc1,
+            CSAMPLE_GAIN gain1,
+            const CSAMPLE* pSrc2,
+            CSAMPLE_GAIN gain2,
+            SINT numSamples);
+    void (*add3WithGain)(CSAMPLE* pDest,
+            const CSAMPLE* pSrc1,
+            CSAMPLE_GAIN gain1,
+            const CSAMPLE* pSrc2,
+            CSAMPLE_GAIN gain2,
+            const CSAMPLE* pSrc3,
+            CSAMPLE_GAIN gain3,
+            SINT numSamples);
+    void (*copyClampBuffer)(CSAMPLE* pDest,
+            const CSAMPLE* pSrc,
+            SINT numSamples);
+    void (*interleaveBuffer)(CSAMPLE* pDest,
+            const CSAMPLE* pSrc1,
+            const CSAMPLE* pSrc2,
+            SINT numFrames);
+    void (*deinterleaveBuffer)(CSAMPLE* pDest1,
+            CSAMPLE* pDest2,
+            const CSAMPLE* pSrc,
+            SINT numFrames);
+};
+
+/// Returns a human readable name of the instruction set, e.g. for logging.
+const char* isaName(Isa isa);
+
+/// Returns the kernel table for the given instruction set or nullptr if
+/// it has not been compiled into this build or is not supported by the
+/// CPU we are running on. The scalar table is always available.
+const Table* tableForIsa(Isa isa);
+
+/// Returns the fastest kernel table for the CPU we are running on. The CPU
+/// features are detected once on first use.
+const Table& activeTable();
+
+// Only to be used by the dispatcher. These return nullptr if the
+// corresponding translation unit has been compiled without the required
+// instruction set flags, e.g. on non-x86 targets.
+const Table* avx2Table();
+const Table* avx512Table();
+
+} // namespace samplekernels
+
+} // namespace mixxx
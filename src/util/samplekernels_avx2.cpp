@@ -0,0 +1,312 @@
+#include "util/samplekernels.h"
+
+// This translation unit is compiled with -mavx2 (/arch:AVX2 on MSVC) on x86
+// targets, see CMakeLists.txt. It must only be entered through the table
+// after a successful CPU feature check.
+//
+// Don't call any inline functions from other headers here! The linker may
+// pick the AVX2 instantiation of such a function for the whole binary, which
+// would crash on older CPUs.
+
+#ifdef __AVX2__
+
+#include <immintrin.h>
+
+namespace mixxx {
+
+namespace samplekernels {
+
+namespace {
+
+constexpr SINT kLanes = 8;
+constexpr SINT kFramesPerVector = kLanes / 2;
+
+// Frame offsets of the interleaved stereo samples in one vector
+inline __m256 rampFrameOffsets() {
+    return _mm256_setr_ps(0, 0, 1, 1, 2, 2, 3, 3);
+}
+
+// Calculates the gains for kFramesPerVector frames starting at frame i
+// exactly like the scalar kernel does: startGain + gainDelta * i
+inline __m256 rampGains(__m256 startGain, __m256 gainDelta, int i) {
+    const __m256 index = _mm256_add_ps(
+            _mm256_set1_ps(static_cast<float>(i)), rampFrameOffsets());
+    return _mm256_add_ps(startGain, _mm256_mul_ps(gainDelta, index));
+}
+
+void applyGainAvx2(CSAMPLE* pBuffer,
+        CSAMPLE_GAIN gain,
+        SINT numSamples) {
+    const __m256 vGain = _mm256_set1_ps(gain);
+    SINT i = 0;
+    for (; i + kLanes <= numSamples; i += kLanes) {
+        _mm256_storeu_ps(pBuffer + i,
+                _mm256_mul_ps(_mm256_loadu_ps(pBuffer + i), vGain));
+    }
+    for (; i < numSamples; ++i) {
+        pBuffer[i] *= gain;
+    }
+}
+
+void applyRampingGainAvx2(CSAMPLE* pBuffer,
+        CSAMPLE_GAIN startGain,
+        CSAMPLE_GAIN gainDelta,
+        SINT numFrames) {
+    const __m256 vStartGain = _mm256_set1_ps(startGain);
+    const __m256 vGainDelta = _mm256_set1_ps(gainDelta);
+    int i = 0;
+    for (; i + kFramesPerVector <= numFrames; i += kFramesPerVector) {
+        const __m256 gains = rampGains(vStartGain, vGainDelta, i);
+        _mm256_storeu_ps(pBuffer + i * 2,
+                _mm256_mul_ps(_mm256_loadu_ps(pBuffer + i * 2), gains));
+    }
+    for (; i < numFrames; ++i) {
+        const CSAMPLE_GAIN gain = startGain + gainDelta * i;
+        pBuffer[i * 2] *= gain;
+        pBuffer[i * 2 + 1] *= gain;
+    }
+}
+
+void copyWithGainAvx2(CSAMPLE* M_RESTRICT pDest,
+        const CSAMPLE* M_RESTRICT pSrc,
+        CSAMPLE_GAIN gain,
+        SINT numSamples) {
+    const __m256 vGain = _mm256_set1_ps(gain);
+    SINT i = 0;
+    for (; i + kLanes <= numSamples; i += kLanes) {
+        _mm256_storeu_ps(pDest + i,
+                _mm256_mul_ps(_mm256_loadu_ps(pSrc + i), vGain));
+    }
+    for (; i < numSamples; ++i) {
+        pDest[i] = pSrc[i] * gain;
+    }
+}
+
+void copyWithRampingGainAvx2(CSAMPLE* M_RESTRICT pDest,
+        const CSAMPLE* M_RESTRICT pSrc,
+        CSAMPLE_GAIN startGain,
+        CSAMPLE_GAIN gainDelta,
+        SINT numFrames) {
+    const __m256 vStartGain = _mm256_set1_ps(startGain);
+    const __m256 vGainDelta = _mm256_set1_ps(gainDelta);
+    int i = 0;
+    for (; i + kFramesPerVector <= numFrames; i += kFramesPerVector) {
+        const __m256 gains = rampGains(vStartGain, vGainDelta, i);
+        _mm256_storeu_ps(pDest + i * 2,
+                _mm256_mul_ps(_mm256_loadu_ps(pSrc + i * 2), gains));
+    }
+    for (; i < numFrames; ++i) {
+        const CSAMPLE_GAIN gain = startGain + gainDelta * i;
+        pDest[i * 2] = pSrc[i * 2] * gain;
+        pDest[i * 2 + 1] = pSrc[i * 2 + 1] * gain;
+    }
+}
+
+void addAvx2(CSAMPLE* M_RESTRICT pDest,
+        const CSAMPLE* M_RESTRICT pSrc,
+        SINT numSamples) {
+    SINT i = 0;
+    for (; i + kLanes <= numSamples; i += kLanes) {
+        _mm256_storeu_ps(pDest + i,
+                _mm256_add_ps(_mm256_loadu_ps(pDest + i),
+                        _mm256_loadu_ps(pSrc + i)));
+    }
+    for (; i < numSamples; ++i) {
+        pDest[i] += pSrc[i];
+    }
+}
+
+void addWithGainAvx2(CSAMPLE* M_RESTRICT pDest,
+        const CSAMPLE* M_RESTRICT pSrc,
+        CSAMPLE_GAIN gain,
+        SINT numSamples) {
+    const __m256 vGain = _mm256_set1_ps(gain);
+    SINT i = 0;
+    for (; i + kLanes <= numSamples; i += kLanes) {
+        const __m256 product = _mm256_mul_ps(_mm256_loadu_ps(pSrc + i), vGain);
+        _mm256_storeu_ps(pDest + i,
+                _mm256_add_ps(_mm256_loadu_ps(pDest + i), product));
+    }
+    for (; i < numSamples; ++i) {
+        pDest[i] += pSrc[i] * gain;
+    }
+}
+
+void addWithRampingGainAvx2(CSAMPLE* M_RESTRICT pDest,
+        const CSAMPLE* M_RESTRICT pSrc,
+        CSAMPLE_GAIN startGain,
+        CSAMPLE_GAIN gainDelta,
+        SINT numFrames) {
+    const __m256 vStartGain = _mm256_set1_ps(startGain);
+    const __m256 vGainDelta = _mm256_set1_ps(gainDelta);
+    int i = 0;
+    for (; i + kFramesPerVector <= numFrames; i += kFramesPerVector) {
+        const __m256 gains = rampGains(vStartGain, vGainDelta, i);
+        const __m256 product = _mm256_mul_ps(_mm256_loadu_ps(pSrc + i * 2), gains);
+        _mm256_storeu_ps(pDest + i * 2,
+                _mm256_add_ps(_mm256_loadu_ps(pDest + i * 2), product));
+    }
+    for (; i < numFrames; ++i) {
+        const CSAMPLE_GAIN gain = startGain + gainDelta * i;
+        pDest[i * 2] += pSrc[i * 2] * gain;
+        pDest[i * 2 + 1] += pSrc[i * 2 + 1] * gain;
+    }
+}
+
+void add2WithGainAvx2(CSAMPLE* M_RESTRICT pDest,
+        const CSAMPLE* M_RESTRICT pSrc1,
+        CSAMPLE_GAIN gain1,
+        const CSAMPLE* M_RESTRICT pSrc2,
+        CSAMPLE_GAIN gain2,
+        SINT numSamples) {
+    const __m256 vGain1 = _mm256_set1_ps(gain1);
+    const __m256 vGain2 = _mm256_set1_ps(gain2);
+    SINT i = 0;
+    for (; i + kLanes <= numSamples; i += kLanes) {
+        const __m256 sum = _mm256_add_ps(
+                _mm256_mul_ps(_mm256_loadu_ps(pSrc1 + i), vGain1),
+                _mm256_mul_ps(_mm256_loadu_ps(pSrc2 + i), vGain2));
+        _mm256_storeu_ps(pDest + i,
+                _mm256_add_ps(_mm256_loadu_ps(pDest + i), sum));
+    }
+    for (; i < numSamples; ++i) {
+        pDest[i] += pSrc1[i] * gain1 + pSrc2[i] * gain2;
+    }
+}
+
+void add3WithGainAvx2(CSAMPLE* pDest,
+        const CSAMPLE* M_RESTRICT pSrc1,
+        CSAMPLE_GAIN gain1,
+        const CSAMPLE* M_RESTRICT pSrc2,
+        CSAMPLE_GAIN gain2,
+        const CSAMPLE* M_RESTRICT pSrc3,
+        CSAMPLE_GAIN gain3,
+        SINT numSamples) {
+    const __m256 vGain1 = _mm256_set1_ps(gain1);
+    const __m256 vGain2 = _mm256_set1_ps(gain2);
+    const __m256 vGain3 = _mm256_set1_ps(gain3);
+    SINT i = 0;
+    for (; i + kLanes <= numSamples; i += kLanes) {
+        const __m256 sum = _mm256_add_ps(
+                _mm256_add_ps(
+                        _mm256_mul_ps(_mm256_loadu_ps(pSrc1 + i), vGain1),
+                        _mm256_mul_ps(_mm256_loadu_ps(pSrc2 + i), vGain2)),
+                _mm256_mul_ps(_mm256_loadu_ps(pSrc3 + i), vGain3));
+        _mm256_storeu_ps(pDest + i,
+                _mm256_add_ps(_mm256_loadu_ps(pDest + i), sum));
+    }
+    for (; i < numSamples; ++i) {
+        pDest[i] += pSrc1[i] * gain1 + pSrc2[i] * gain2 + pSrc3[i] * gain3;
+    }
+}
+
+void copyClampBufferAvx2(CSAMPLE* M_RESTRICT pDest,
+        const CSAMPLE* M_RESTRICT pSrc,
+        SINT numSamples) {
+    // Same operand order as math_clamp() -> std::max(min, std::min(max, x))
+    const __m256 vMin = _mm256_set1_ps(-CSAMPLE_PEAK);
+    const __m256 vMax = _mm256_set1_ps(CSAMPLE_PEAK);
+    SINT i = 0;
+    for (; i + kLanes <= numSamples; i += kLanes) {
+        const __m256 clamped = _mm256_max_ps(
+                _mm256_min_ps(_mm256_loadu_ps(pSrc + i), vMax), vMin);
+        _mm256_storeu_ps(pDest + i, clamped);
+    }
+    for (; i < numSamples; ++i) {
+        const CSAMPLE upper = pSrc[i] < CSAMPLE_PEAK ? pSrc[i] : CSAMPLE_PEAK;
+        pDest[i] = upper > -CSAMPLE_PEAK ? upper : -CSAMPLE_PEAK;
+    }
+}
+
+void interleaveBufferAvx2(CSAMPLE* M_RESTRICT pDest,
+        const CSAMPLE* M_RESTRICT pSrc1,
+        const CSAMPLE* M_RESTRICT pSrc2,
+        SINT numFrames) {
+    SINT i = 0;
+    for (; i + kLanes <= numFrames; i += kLanes) {
+        const __m256 left = _mm256_loadu_ps(pSrc1 + i);
+        const __m256 right = _mm256_loadu_ps(pSrc2 + i);
+        // l0 r0 l1 r1 | l4 r4 l5 r5
+        const __m256 low = _mm256_unpacklo_ps(left, right);
+        // l2 r2 l3 r3 | l6 r6 l7 r7
+        const __m256 high = _mm256_unpackhi_ps(left, right);
+        _mm256_storeu_ps(pDest + 2 * i,
+                _mm256_permute2f128_ps(low, high, 0x20));
+        _mm256_storeu_ps(pDest + 2 * i + kLanes,
+                _mm256_permute2f128_ps(low, high, 0x31));
+    }
+    for (; i < numFrames; ++i) {
+        pDest[2 * i] = pSrc1[i];
+        pDest[2 * i + 1] = pSrc2[i];
+    }
+}
+
+void deinterleaveBufferAvx2(CSAMPLE* M_RESTRICT pDest1,
+        CSAMPLE* M_RESTRICT pDest2,
+        const CSAMPLE* M_RESTRICT pSrc,
+        SINT numFrames) {
+    SINT i = 0;
+    for (; i + kLanes <= numFrames; i += kLanes) {
+        const __m256 first = _mm256_loadu_ps(pSrc + 2 * i);
+        const __m256 second = _mm256_loadu_ps(pSrc + 2 * i + kLanes);
+        // l0 l1 l4 l5 | l2 l3 l6 l7
+        const __m256 left = _mm256_shuffle_ps(
+                first, second, _MM_SHUFFLE(2, 0, 2, 0));
+        // r0 r1 r4 r5 | r2 r3 r6 r7
+        const __m256 right = _mm256_shuffle_ps(
+                first, second, _MM_SHUFFLE(3, 1, 3, 1));
+        // Restore the order of the 64 bit pairs
+        _mm256_storeu_ps(pDest1 + i,
+                _mm256_castpd_ps(_mm256_permute4x64_pd(
+                        _mm256_castps_pd(left), _MM_SHUFFLE(3, 1, 2, 0))));
+        _mm256_storeu_ps(pDest2 + i,
+                _mm256_castpd_ps(_mm256_permute4x64_pd(
+                        _mm256_castps_pd(right), _MM_SHUFFLE(3, 1, 2, 0))));
+    }
+    for (; i < numFrames; ++i) {
+        pDest1[i] = pSrc[i * 2];
+        pDest2[i] = pSrc[i * 2 + 1];
+    }
+}
+
+const Table kAvx2Table = {
+        Isa::Avx2,
+        applyGainAvx2,
+        applyRampingGainAvx2,
+        copyWithGainAvx2,
+        copyWithRampingGainAvx2,
+        addAvx2,
+        addWithGainAvx2,
+        addWithRampingGainAvx2,
+        add2WithGainAvx2,
+        add3WithGainAvx2,
+        copyClampBufferAvx2,
+        interleaveBufferAvx2,
+        deinterleaveBufferAvx2,
+};
+
+} // anonymous namespace
+
+const Table* avx2Table() {
+    return &kAvx2Table;
+}
+
+} // namespace samplekernels
+
+} // namespace mixxx
+
+#else // __AVX2__
+
+namespace mixxx {
+
+namespace samplekernels {
+
+const Table* avx2Table() {
+    return nullptr;
+}
+
+} // namespace samplekernels
+
+} // namespace mixxx
+
+#endif // __AVX2__
@@ -0,0 +1,309 @@
+#include "util/samplekernels.h"
+
+// This translation unit is compiled with -mavx512f (/arch:AVX512 on MSVC) on x86
+// targets, see CMakeLists.txt. It must only be entered through the table
+// after a successful CPU feature check.
+//
+// Don't call any inline functions from other headers here! The linker may
+// pick the AVX-512 instantiation of such a function for the whole binary, which
+// would crash on older CPUs.
+
+#ifdef __AVX512F__
+
+#include <immintrin.h>
+
+namespace mixxx {
+
+namespace samplekernels {
+
+namespace {
+
+constexpr SINT kLanes = 16;
+constexpr SINT kFramesPerVector = kLanes / 2;
+
+// Frame offsets of the interleaved stereo samples in one vector
+inline __m512 rampFrameOffsets() {
+    return _mm512_setr_ps(0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7);
+}
+
+// Calculates the gains for kFramesPerVector frames starting at frame i
+// exactly like the scalar kernel does: startGain + gainDelta * i
+inline __m512 rampGains(__m512 startGain, __m512 gainDelta, int i) {
+    const __m512 index = _mm512_add_ps(
+            _mm512_set1_ps(static_cast<float>(i)), rampFrameOffsets());
+    return _mm512_add_ps(startGain, _mm512_mul_ps(gainDelta, index));
+}
+
+void applyGainAvx512(CSAMPLE* pBuffer,
+        CSAMPLE_GAIN gain,
+        SINT numSamples) {
+    const __m512 vGain = _mm512_set1_ps(gain);
+    SINT i = 0;
+    for (; i + kLanes <= numSamples; i += kLanes) {
+        _mm512_storeu_ps(pBuffer + i,
+                _mm512_mul_ps(_mm512_loadu_ps(pBuffer + i), vGain));
+    }
+    for (; i < numSamples; ++i) {
+        pBuffer[i] *= gain;
+    }
+}
+
+void applyRampingGainAvx512(CSAMPLE* pBuffer,
+        CSAMPLE_GAIN startGain,
+        CSAMPLE_GAIN gainDelta,
+        SINT numFrames) {
+    const __m512 vStartGain = _mm512_set1_ps(startGain);
+    const __m512 vGainDelta = _mm512_set1_ps(gainDelta);
+    int i = 0;
+    for (; i + kFramesPerVector <= numFrames; i += kFramesPerVector) {
+        const __m512 gains = rampGains(vStartGain, vGainDelta, i);
+        _mm512_storeu_ps(pBuffer + i * 2,
+                _mm512_mul_ps(_mm512_loadu_ps(pBuffer + i * 2), gains));
+    }
+    for (; i < numFrames; ++i) {
+        const CSAMPLE_GAIN gain = startGain + gainDelta * i;
+        pBuffer[i * 2] *= gain;
+        pBuffer[i * 2 + 1] *= gain;
+    }
+}
+
+void copyWithGainAvx512(CSAMPLE* M_RESTRICT pDest,
+        const CSAMPLE* M_RESTRICT pSrc,
+        CSAMPLE_GAIN gain,
+        SINT numSamples) {
+    const __m512 vGain = _mm512_set1_ps(gain);
+    SINT i = 0;
+    for (; i + kLanes <= numSamples; i += kLanes) {
+        _mm512_storeu_ps(pDest + i,
+                _mm512_mul_ps(_mm512_loadu_ps(pSrc + i), vGain));
+    }
+    for (; i < numSamples; ++i) {
+        pDest[i] = pSrc[i] * gain;
+    }
+}
+
+void copyWithRampingGainAvx512(CSAMPLE* M_RESTRICT pDest,
+        const CSAMPLE* M_RESTRICT pSrc,
+        CSAMPLE_GAIN startGain,
+        CSAMPLE_GAIN gainDelta,
+        SINT numFrames) {
+    const __m512 vStartGain = _mm512_set1_ps(startGain);
+    const __m512 vGainDelta = _mm512_set1_ps(gainDelta);
+    int i = 0;
+    for (; i + kFramesPerVector <= numFrames; i += kFramesPerVector) {
+        const __m512 gains = rampGains(vStartGain, vGainDelta, i);
+        _mm512_storeu_ps(pDest + i * 2,
+                _mm512_mul_ps(_mm512_loadu_ps(pSrc + i * 2), gains));
+    }
+    for (; i < numFrames; ++i) {
+        const CSAMPLE_GAIN gain = startGain + gainDelta * i;
+        pDest[i * 2] = pSrc[i * 2] * gain;
+        pDest[i * 2 + 1] = pSrc[i * 2 + 1] * gain;
+    }
+}
+
+void addAvx512(CSAMPLE* M_RESTRICT pDest,
+        const CSAMPLE* M_RESTRICT pSrc,
+        SINT numSamples) {
+    SINT i = 0;
+    for (; i + kLanes <= numSamples; i += kLanes) {
+        _mm512_storeu_ps(pDest + i,
+                _mm512_add_ps(_mm512_loadu_ps(pDest + i),
+                        _mm512_loadu_ps(pSrc + i)));
+    }
+    for (; i < numSamples; ++i) {
+        pDest[i] += pSrc[i];
+    }
+}
+
+void addWithGainAvx512(CSAMPLE* M_RESTRICT pDest,
+        const CSAMPLE* M_RESTRICT pSrc,
+        CSAMPLE_GAIN gain,
+        SINT numSamples) {
+    const __m512 vGain = _mm512_set1_ps(gain);
+    SINT i = 0;
+    for (; i + kLanes <= numSamples; i += kLanes) {
+        const __m512 product = _mm512_mul_ps(_mm512_loadu_ps(pSrc + i), vGain);
+        _mm512_storeu_ps(pDest + i,
+                _mm512_add_ps(_mm512_loadu_ps(pDest + i), product));
+    }
+    for (; i < numSamples; ++i) {
+        pDest[i] += pSrc[i] * gain;
+    }
+}
+
+void addWithRampingGainAvx512(CSAMPLE* M_RESTRICT pDest,
+        const CSAMPLE* M_RESTRICT pSrc,
+        CSAMPLE_GAIN startGain,
+        CSAMPLE_GAIN gainDelta,
+        SINT numFrames) {
+    const __m512 vStartGain = _mm512_set1_ps(startGain);
+    const __m512 vGainDelta = _mm512_set1_ps(gainDelta);
+    int i = 0;
+    for (; i + kFramesPerVector <= numFrames; i += kFramesPerVector) {
+        const __m512 gains = rampGains(vStartGain, vGainDelta, i);
+        const __m512 product = _mm512_mul_ps(_mm512_loadu_ps(pSrc + i * 2), gains);
+        _mm512_storeu_ps(pDest + i * 2,
+                _mm512_add_ps(_mm512_loadu_ps(pDest + i * 2), product));
+    }
+    for (; i < numFrames; ++i) {
+        const CSAMPLE_GAIN gain = startGain + gainDelta * i;
+        pDest[i * 2] += pSrc[i * 2] * gain;
+        pDest[i * 2 + 1] += pSrc[i * 2 + 1] * gain;
+    }
+}
+
+void add2WithGainAvx512(CSAMPLE* M_RESTRICT pDest,
+        const CSAMPLE* M_RESTRICT pSrc1,
+        CSAMPLE_GAIN gain1,
+        const CSAMPLE* M_RESTRICT pSrc2,
+        CSAMPLE_GAIN gain2,
+        SINT numSamples) {
+    const __m512 vGain1 = _mm512_set1_ps(gain1);
+    const __m512 vGain2 = _mm512_set1_ps(gain2);
+    SINT i = 0;
+    for (; i + kLanes <= numSamples; i += kLanes) {
+        const __m512 sum = _mm512_add_ps(
+                _mm512_mul_ps(_mm512_loadu_ps(pSrc1 + i), vGain1),
+                _mm512_mul_ps(_mm512_loadu_ps(pSrc2 + i), vGain2));
+        _mm512_storeu_ps(pDest + i,
+                _mm512_add_ps(_mm512_loadu_ps(pDest + i), sum));
+    }
+    for (; i < numSamples; ++i) {
+        pDest[i] += pSrc1[i] * gain1 + pSrc2[i] * gain2;
+    }
+}
+
+void add3WithGainAvx512(CSAMPLE* pDest,
+        const CSAMPLE* M_RESTRICT pSrc1,
+        CSAMPLE_GAIN gain1,
+        const CSAMPLE* M_RESTRICT pSrc2,
+        CSAMPLE_GAIN gain2,
+        const CSAMPLE* M_RESTRICT pSrc3,
+        CSAMPLE_GAIN gain3,
+        SINT numSamples) {
+    const __m512 vGain1 = _mm512_set1_ps(gain1);
+    const __m512 vGain2 = _mm512_set1_ps(gain2);
+    const __m512 vGain3 = _mm512_set1_ps(gain3);
+    SINT i = 0;
+    for (; i + kLanes <= numSamples; i += kLanes) {
+        const __m512 sum = _mm512_add_ps(
+                _mm512_add_ps(
+                        _mm512_mul_ps(_mm512_loadu_ps(pSrc1 + i), vGain1),
+                        _mm512_mul_ps(_mm512_loadu_ps(pSrc2 + i), vGain2)),
+                _mm512_mul_ps(_mm512_loadu_ps(pSrc3 + i), vGain3));
+        _mm512_storeu_ps(pDest + i,
+                _mm512_add_ps(_mm512_loadu_ps(pDest + i), sum));
+    }
+    for (; i < numSamples; ++i) {
+        pDest[i] += pSrc1[i] * gain1 + pSrc2[i] * gain2 + pSrc3[i] * gain3;
+    }
+}
+
+void copyClampBufferAvx512(CSAMPLE* M_RESTRICT pDest,
+        const CSAMPLE* M_RESTRICT pSrc,
+        SINT numSamples) {
+    // Same operand order as math_clamp() -> std::max(min, std::min(max, x))
+    const __m512 vMin = _mm512_set1_ps(-CSAMPLE_PEAK);
+    const __m512 vMax = _mm512_set1_ps(CSAMPLE_PEAK);
+    SINT i = 0;
+    for (; i + kLanes <= numSamples; i += kLanes) {
+        const __m512 clamped = _mm512_max_ps(
+                _mm512_min_ps(_mm512_loadu_ps(pSrc + i), vMax), vMin);
+        _mm512_storeu_ps(pDest + i, clamped);
+    }
+    for (; i < numSamples; ++i) {
+        const CSAMPLE upper = pSrc[i] < CSAMPLE_PEAK ? pSrc[i] : CSAMPLE_PEAK;
+        pDest[i] = upper > -CSAMPLE_PEAK ? upper : -CSAMPLE_PEAK;
+    }
+}
+
+void interleaveBufferAvx512(CSAMPLE* M_RESTRICT pDest,
+        const CSAMPLE* M_RESTRICT pSrc1,
+        const CSAMPLE* M_RESTRICT pSrc2,
+        SINT numFrames) {
+    // Indices 0..15 select from the left, 16..31 from the right channel
+    const __m512i lowIndices = _mm512_setr_epi32(
+            0, 16, 1, 17, 2, 18, 3, 19, 4, 20, 5, 21, 6, 22, 7, 23);
+    const __m512i highIndices = _mm512_setr_epi32(
+            8, 24, 9, 25, 10, 26, 11, 27, 12, 28, 13, 29, 14, 30, 15, 31);
+    SINT i = 0;
+    for (; i + kLanes <= numFrames; i += kLanes) {
+        const __m512 left = _mm512_loadu_ps(pSrc1 + i);
+        const __m512 right = _mm512_loadu_ps(pSrc2 + i);
+        _mm512_storeu_ps(pDest + 2 * i,
+                _mm512_permutex2var_ps(left, lowIndices, right));
+        _mm512_storeu_ps(pDest + 2 * i + kLanes,
+                _mm512_permutex2var_ps(left, highIndices, right));
+    }
+    for (; i < numFrames; ++i) {
+        pDest[2 * i] = pSrc1[i];
+        pDest[2 * i + 1] = pSrc2[i];
+    }
+}
+
+void deinterleaveBufferAvx512(CSAMPLE* M_RESTRICT pDest1,
+        CSAMPLE* M_RESTRICT pDest2,
+        const CSAMPLE* M_RESTRICT pSrc,
+        SINT numFrames) {
+    // Indices 0..15 select from the first, 16..31 from the second vector
+    const __m512i evenIndices = _mm512_setr_epi32(
+            0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30);
+    const __m512i oddIndices = _mm512_setr_epi32(
+            1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31);
+    SINT i = 0;
+    for (; i + kLanes <= numFrames; i += kLanes) {
+        const __m512 first = _mm512_loadu_ps(pSrc + 2 * i);
+        const __m512 second = _mm512_loadu_ps(pSrc + 2 * i + kLanes);
+        _mm512_storeu_ps(pDest1 + i,
+                _mm512_permutex2var_ps(first, evenIndices, second));
+        _mm512_storeu_ps(pDest2 + i,
+                _mm512_permutex2var_ps(first, oddIndices, second));
+    }
+    for (; i < numFrames; ++i) {
+        pDest1[i] = pSrc[i * 2];
+        pDest2[i] = pSrc[i * 2 + 1];
+    }
+}
+
+const Table kAvx512Table = {
+        Isa::Avx512,
+        applyGainAvx512,
+        applyRampingGainAvx512,
+        copyWithGainAvx512,
+        copyWithRampingGainAvx512,
+        addAvx512,
+        addWithGainAvx512,
+        addWithRampingGainAvx512,
+        add2WithGainAvx512,
+        add3WithGainAvx512,
+        copyClampBufferAvx512,
+        interleaveBufferAvx512,
+        deinterleaveBufferAvx512,
+};
+
+} // anonymous namespace
+
+const Table* avx512Table() {
+    return &kAvx512Table;
+}
+
+} // namespace samplekernels
+
+} // namespace mixxx
+
+#else // __AVX512F__
+
+namespace mixxx {
+
+namespace samplekernels {
+
+const Table* avx512Table() {
+    return nullptr;
+}
+
+} // namespace samplekernels
+
+} // namespace mixxx
+
+#endif // __AVX512F__
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+
+#include "util/class.h"
+
+// A wait-free single-producer single-consumer triple buffer for handing
+// over the latest state of the writer to the reader. The writer never waits
+// for the reader and the reader always gets the most recently published
+// value, while intermediate values that have not been read are dropped.
+//
+// The writer fills writeBuffer() and calls publish(). The reader calls
+// update() and then reads readBuffer(), which stays valid and unchanged
+// until the next update(). Multiple readers are only allowed if they all
+// run on the same thread.
+template<typename T>
+class TripleBuffer {
+  public:
+    TripleBuffer()
+            : m_middle(1),
+              m_write(0),
+              m_read(2) {
+    }
+
+    // Writer
+    T& writeBuffer() {
+        return m_slots[m_write].value;
+    }
+    void publish() {
+        m_write = m_middle.exchange(m_write | kDirtyFlag,
+                          std::memory_order_acq_rel) &
+                kIndexMask;
+    }
+
+    // Reader. Returns true if a new value has been published since
+    // the last update.
+    bool update() {
+        if (!(m_middle.load(std::memory_order_relaxed) & kDirtyFlag)) {
+            return false;
+        }
+        m_read = m_middle.exchange(m_read, std::memory_order_acq_rel) & kIndexMask;
+        return true;
+    }
+    const T& readBuffer() const {
+        return m_slots[m_read].value;
+    }
+
+  private:
+    static constexpr int kIndexMask = 0x3;
+    static constexpr int kDirtyFlag = 0x4;
+
+    // Each slot on its own cache line to avoid false sharing between
+    // the writer and the reader
+    struct alignas(64) Slot {
+        T value{};
+    };
+    Slot m_slots[3];
+
+    // Index of the slot that is neither written nor read,
+    // with kDirtyFlag set if it has not been read yet
+    alignas(64) std::atomic<int> m_middle;
+    // Writer only
+    alignas(64) int m_write;
+    // Reader only
+    alignas(64) int m_read;
+
+    DISALLOW_COPY_AND_ASSIGN(TripleBuffer);
+};
@@ -0,0 +1,226 @@
+#include "waveform/provisionalwaveformbuilder.h"
+
+#include <cmath>
+#include <iterator>
+
+#include "analyzer/analyzerwaveform.h"
+#include "analyzer/waveformfilterbank.h"
+#include "util/math.h"
+
+namespace {
+
+inline void storeIfGreater(float* pDest, float source) {
+    // Like AnalyzerWaveform a NaN never replaces a peak
+    if (*pDest < source) {
+        *pDest = source;
+    }
+}
+
+inline void mergePeak(unsigned char* pDest, unsigned char source) {
+    if (*pDest < source) {
+        *pDest = source;
+    }
+}
+
+} // anonymous namespace
+
+ProvisionalWaveformBuilder::ProvisionalWaveformBuilder()
+        : m_sampleRate(0),
+          m_filteredFrameIndex(0),
+          m_addedFrameCount(0) {
+}
+
+ProvisionalWaveformBuilder::~ProvisionalWaveformBuilder() = default;
+
+void ProvisionalWaveformBuilder::start(
+        const TrackPointer& pTrack,
+        const mixxx::IndexRange& frameIndexRange,
+        int sampleRate) {
+    stop();
+    if (!pTrack || frameIndexRange.empty() || sampleRate <= 0) {
+        return;
+    }
+    // Avoids allocating a waveform that would not be set
+    const ConstWaveformPointer pTrackWaveform = pTrack->getWaveform();
+    if (pTrackWaveform && !pTrackWaveform->isProvisional()) {
+        return;
+    }
+
+    // Same geometry as the main waveform of AnalyzerWaveform
+    WaveformPointer pWaveform(new Waveform(
+            sampleRate,
+            static_cast<int>(ChannelCount * frameIndexRange.length()),
+            AnalyzerWaveform::kMainWaveformSampleRate,
+            -1));
+    pWaveform->setProvisional(true);
+    // Allocating the data marks a new waveform as pending
+    pWaveform->setSaveState(Waveform::SaveState::NotSaved);
+    // A provisional waveform that has been left incomplete when the track
+    // was loaded before is replaced, because the added frames are unknown.
+    // The analyzer might have set its waveform since the check above.
+    if (!pTrack->setProvisionalWaveform(pWaveform)) {
+        return;
+    }
+    m_pWaveform = pWaveform;
+    m_pTrack = pTrack;
+    m_frameIndexRange = frameIndexRange;
+    m_sampleRate = sampleRate;
+}
+
+void ProvisionalWaveformBuilder::stop() {
+    m_pWaveform.clear();
+    m_pTrack.reset();
+    m_pFilterBank.reset();
+    m_addedFrames.clear();
+    m_addedFrameCount = 0;
+}
+
+void ProvisionalWaveformBuilder::addFrames(
+        const mixxx::IndexRange& frameIndexRange,
+        const CSAMPLE* pSamples) {
+    if (!m_pWaveform) {
+        return;
+    }
+    // Stop as soon as the analyzed or stored waveform has been set
+    const TrackPointer pTrack = m_pTrack.lock();
+    if (!pTrack || pTrack->getWaveform().data() != m_pWaveform.data()) {
+        stop();
+        return;
+    }
+    const auto frames = intersect(frameIndexRange, m_frameIndexRange);
+    if (frames.empty()) {
+        return;
+    }
+    pSamples += ChannelCount * (frames.start() - frameIndexRange.start());
+
+    // Process the gaps between the frames that have been added before
+    // and merge all of them into a single range
+    SINT start = frames.start();
+    SINT end = frames.end();
+    auto it = m_addedFrames.upper_bound(start);
+    if (it != m_addedFrames.begin() && std::prev(it)->second >= start) {
+        --it;
+    }
+    SINT gapStart = start;
+    while (it != m_addedFrames.end() && it->first <= end) {
+        if (gapStart < it->first) {
+            processFrames(mixxx::IndexRange::between(gapStart, it->first),
+                    pSamples + ChannelCount * (gapStart - frames.start()));
+        }
+        gapStart = math_max(gapStart, it->second);
+        start = math_min(start, it->first);
+        end = math_max(end, it->second);
+        it = m_addedFrames.erase(it);
+    }
+    if (gapStart < frames.end()) {
+        processFrames(mixxx::IndexRange::between(gapStart, frames.end()),
+                pSamples + ChannelCount * (gapStart - frames.start()));
+    }
+    m_addedFrames[start] = end;
+
+    updateCompletion();
+}
+
+void ProvisionalWaveformBuilder::processFrames(
+        const mixxx::IndexRange& frameIndexRange,
+        const CSAMPLE* pSamples) {
+    const SINT sampleCount = ChannelCount * frameIndexRange.length();
+    if (!m_pFilterBank || frameIndexRange.start() != m_filteredFrameIndex) {
+        // Settled for silence like at the start of the analysis
+        m_pFilterBank = std::make_unique<WaveformFilterBank>(
+                m_sampleRate,
+                AnalyzerWaveform::kLowMidCorner,
+                AnalyzerWaveform::kMidHighCorner);
+    }
+    if (sampleCount > static_cast<SINT>(m_buffers[Low].size())) {
+        m_buffers[Low].resize(sampleCount);
+        m_buffers[Mid].resize(sampleCount);
+        m_buffers[High].resize(sampleCount);
+    }
+    m_pFilterBank->process(pSamples,
+            &m_buffers[Low][0],
+            &m_buffers[Mid][0],
+            &m_buffers[High][0],
+            sampleCount);
+    m_filteredFrameIndex = frameIndexRange.end();
+    m_addedFrameCount += frameIndexRange.length();
+
+    // Frame f of the track belongs to the visual sample floor(f / ratio)
+    const double ratio = m_pWaveform->getAudioVisualRatio();
+    const SINT firstFrame = frameIndexRange.start() - m_frameIndexRange.start();
+    const SINT endFrame = frameIndexRange.end() - m_frameIndexRange.start();
+    const auto firstVisualIndex = static_cast<SINT>(firstFrame / ratio);
+    SINT frame = firstFrame;
+    SINT endVisualIndex = firstVisualIndex;
+    while (frame < endFrame) {
+        const auto visualIndex = static_cast<SINT>(frame / ratio);
+        const SINT strideEnd = math_min(endFrame,
+                math_max(frame + 1,
+                        static_cast<SINT>(std::ceil((visualIndex + 1) * ratio))));
+        float overall[ChannelCount] = {};
+        float filtered[ChannelCount][FilterCount] = {};
+        for (; frame < strideEnd; ++frame) {
+            const SINT i = ChannelCount * (frame - firstFrame);
+            for (int c = 0; c < ChannelCount; ++c) {
+                storeIfGreater(&overall[c], std::fabs(pSamples[i + c]));
+                storeIfGreater(&filtered[c][Low], std::fabs(m_buffers[Low][i + c]));
+                storeIfGreater(&filtered[c][Mid], std::fabs(m_buffers[Mid][i + c]));
+                storeIfGreater(&filtered[c][High], std::fabs(m_buffers[High][i + c]));
+            }
+        }
+        storeVisualSample(visualIndex, overall, filtered);
+        endVisualIndex = visualIndex + 1;
+    }
+    m_pWaveform->updateMipLevels(
+            static_cast<int>(ChannelCount * firstVisualIndex),
+            static_cast<int>(ChannelCount * endVisualIndex));
+}
+
+void ProvisionalWaveformBuilder::storeVisualSample(
+        SINT visualIndex,
+        const float (&overall)[ChannelCount],
+        const float (&filtered)[ChannelCount][FilterCount]) {
+    const SINT dataIndex = ChannelCount * visualIndex;
+    if (dataIndex + ChannelCount > m_pWaveform->getDataSize()) {
+        return;
+    }
+    WaveformStride stride(
+            m_pWaveform->getAudioVisualRatio(),
+            m_pWaveform->getAudioVisualRatio());
+    for (int c = 0; c < ChannelCount; ++c) {
+        stride.m_overallData[c] = overall[c];
+        for (int f = 0; f < FilterCount; ++f) {
+            stride.m_filteredData[c][f] = filtered[c][f];
+        }
+    }
+    WaveformData data[ChannelCount];
+    stride.store(data);
+
+    // The visual sample might have been stored partially before. The
+    // scaling is monotonic, so the maximum of both is the peak of all
+    // frames.
+    WaveformData* pData = m_pWaveform->data() + dataIndex;
+    for (int c = 0; c < ChannelCount; ++c) {
+        mergePeak(&pData[c].filtered.low, data[c].filtered.low);
+        mergePeak(&pData[c].filtered.mid, data[c].filtered.mid);
+        mergePeak(&pData[c].filtered.high, data[c].filtered.high);
+        mergePeak(&pData[c].filtered.all, data[c].filtered.all);
+    }
+}
+
+void ProvisionalWaveformBuilder::updateCompletion() {
+    // The completion counts the filled data elements, but they are not
+    // necessarily the leading ones. The GLSL renderer reloads the texture
+    // whenever it increases.
+    if (m_addedFrameCount >= m_frameIndexRange.length()) {
+        m_pWaveform->setCompletion(m_pWaveform->getDataSize());
+        // Nothing left to do
+        stop();
+        return;
+    }
+    const auto visualSamples = static_cast<SINT>(
+            m_addedFrameCount / m_pWaveform->getAudioVisualRatio());
+    m_pWaveform->setCompletion(static_cast<int>(math_min(
+            ChannelCount * visualSamples,
+            static_cast<SINT>(m_pWaveform->getDataSize()))));
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "track/track.h"
+#include "util/class.h"
+#include "util/indexrange.h"
+#include "util/types.h"
+#include "waveform/waveform.h"
+
+class WaveformFilterBank;
+
+// Fills a provisional main waveform of a track from the sample frames that
+// are decoded for playback anyway, i.e. the chunks read by the
+// CachingReaderWorker around the play position and the preloaded track.
+// The renderers draw the filled parts immediately instead of waiting until
+// the AnalyzerWaveform has finished or the stored waveform has been loaded,
+// which both replace the provisional waveform.
+//
+// The frames may be added in any order. Each visual sample holds the peaks
+// of its frames like in AnalyzerWaveform, so a visual sample that is split
+// between two additions is merged exactly. Only the band filters start
+// anew for frames that do not follow the previous ones.
+//
+// Not thread-safe, owned by the thread that decodes the track.
+class ProvisionalWaveformBuilder {
+  public:
+    ProvisionalWaveformBuilder();
+    ~ProvisionalWaveformBuilder();
+
+    // Sets a new provisional waveform to the track if it does not have a
+    // waveform yet. The frameIndexRange is the range of the audio source.
+    void start(const TrackPointer& pTrack,
+            const mixxx::IndexRange& frameIndexRange,
+            int sampleRate);
+    void stop();
+
+    // False if the track has another waveform or all frames have been added
+    bool isActive() const {
+        return static_cast<bool>(m_pWaveform);
+    }
+
+    // Adds the interleaved stereo samples of the given frames. Frames
+    // that have been added before are ignored.
+    void addFrames(const mixxx::IndexRange& frameIndexRange,
+            const CSAMPLE* pSamples);
+
+    const WaveformPointer& getWaveform() const {
+        return m_pWaveform;
+    }
+
+  private:
+    void processFrames(const mixxx::IndexRange& frameIndexRange,
+            const CSAMPLE* pSamples);
+    void storeVisualSample(SINT visualIndex,
+            const float (&overall)[ChannelCount],
+            const float (&filtered)[ChannelCount][FilterCount]);
+    void updateCompletion();
+
+    TrackWeakPointer m_pTrack;
+    WaveformPointer m_pWaveform;
+    mixxx::IndexRange m_frameIndexRange;
+    int m_sampleRate;
+
+    std::unique_ptr<WaveformFilterBank> m_pFilterBank;
+    // The frame after the last one filtered by m_pFilterBank
+    SINT m_filteredFrameIndex;
+    std::vector<CSAMPLE> m_buffers[FilterCount];
+
+    // Disjoint and not adjacent ranges of the added frames,
+    // i.e. their end by their start
+    std::map<SINT, SINT> m_addedFrames;
+    SINT m_addedFrameCount;
+
+    DISALLOW_COPY_AND_ASSIGN(ProvisionalWaveformBuilder);
+};
@@ -47,6 +47,9 @@ void GLWaveformRendererFilteredSignal::draw(QPainter* painter, QPaintEvent* /*ev
 
     double firstVisualIndex = m_waveformRenderer->getFirstDisplayedPosition() * dataSize;
     double lastVisualIndex = m_waveformRenderer->getLastDisplayedPosition() * dataSize;
+
+    const MipLevel mip = getMipLevel(*waveform, firstVisualIndex, lastVisualIndex);
+
     const double lineWidth = (1.0 / m_waveformRenderer->getVisualSamplePerPixel()) + 1.0;
 
     const int firstIndex = int(firstVisualIndex+0.5);
@@ -98,40 +101,45 @@ void GLWaveformRendererFilteredSignal::draw(QPainter* painter, QPaintEvent* /*ev
 
         glBegin(GL_LINES); {
 
-            int firstIndex = math_max(static_cast<int>(firstVisualIndex), 0);
-            int lastIndex = math_min(static_cast<int>(lastVisualIndex), dataSize);
+            int firstIndex = (math_max(static_cast<int>(firstVisualIndex), 0) >> mip.level) & ~1;
+            int lastIndex = math_min(
+                    ((static_cast<int>(lastVisualIndex) / 2 + (1 << mip.level) - 1) >> mip.level) * 2,
+                    mip.dataSize);
 
             glColor4f(m_lowColor_r, m_lowColor_g, m_lowColor_b, 0.8);
-            for (int visualIndex = firstIndex;
-                    visualIndex < lastIndex;
-                    visualIndex += 2) {
+            for (int mipIndex = firstIndex;
+                    mipIndex < lastIndex;
+                    mipIndex += 2) {
+                const int visualIndex = mipIndex << mip.level;
 
-                GLfloat maxLow0 = data[visualIndex].filtered.low;
-                GLfloat maxLow1 = data[visualIndex+1].filtered.low;
+                GLfloat maxLow0 = mip.data[mipIndex].filtered.low;
+                GLfloat maxLow1 = mip.data[mipIndex + 1].filtered.low;
 
                 glVertex2f(visualIndex,lowGain*maxLow0);
                 glVertex2f(visualIndex,-1.f*lowGain*maxLow1);
             }
 
             glColor4f(m_midColor_r, m_midColor_g, m_midColor_b, 0.85);
-            for (int visualIndex = firstIndex;
-                    visualIndex < lastIndex;
-                    visualIndex += 2) {
+            for (int mipIndex = firstIndex;
+                    mipIndex < lastIndex;
+                    mipIndex += 2) {
+                const int visualIndex = mipIndex << mip.level;
 
-                GLfloat maxMid0 = data[visualIndex].filtered.mid;
-                GLfloat maxMid1 = data[visualIndex+1].filtered.mid;
+                GLfloat maxMid0 = mip.data[mipIndex].filtered.mid;
+                GLfloat maxMid1 = mip.data[mipIndex + 1].filtered.mid;
 
                 glVertex2f(visualIndex, midGain * maxMid0);
                 glVertex2f(visualIndex,-1.f * midGain * maxMid1);
             }
 
             glColor4f(m_highColor_r, m_highColor_g, m_highColor_b, 0.9);
-            for (int visualIndex = firstIndex;
-                    visualIndex < lastIndex;
-                    visualIndex += 2) {
+            for (int mipIndex = firstIndex;
+                    mipIndex < lastIndex;
+                    mipIndex += 2) {
+                const int visualIndex = mipIndex << mip.level;
 
-                GLfloat maxHigh0 = data[visualIndex].filtered.high;
-                GLfloat maxHigh1 = data[visualIndex + 1].filtered.high;
+                GLfloat maxHigh0 = mip.data[mipIndex].filtered.high;
+                GLfloat maxHigh1 = mip.data[mipIndex + 1].filtered.high;
 
                 glVertex2f(visualIndex, highGain * maxHigh0);
                 glVertex2f(visualIndex, -1.f * highGain * maxHigh1);
@@ -162,43 +170,48 @@ void GLWaveformRendererFilteredSignal::draw(QPainter* painter, QPaintEvent* /*ev
 
         glBegin(GL_LINES); {
 
-            int firstIndex = math_max(static_cast<int>(firstVisualIndex), 0);
-            int lastIndex = math_min(static_cast<int>(lastVisualIndex), dataSize);
+            int firstIndex = (math_max(static_cast<int>(firstVisualIndex), 0) >> mip.level) & ~1;
+            int lastIndex = math_min(
+                    ((static_cast<int>(lastVisualIndex) / 2 + (1 << mip.level) - 1) >> mip.level) * 2,
+                    mip.dataSize);
 
             glColor4f(m_lowColor_r, m_lowColor_g, m_lowColor_b, 0.8);
-            for (int visualIndex = firstIndex;
-                    visualIndex < lastIndex;
-                    visualIndex += 2) {
+            for (int mipIndex = firstIndex;
+                    mipIndex < lastIndex;
+                    mipIndex += 2) {
+                const int visualIndex = mipIndex << mip.level;
 
                 GLfloat maxLow = math_max(
-                        data[visualIndex].filtered.low,
-                        data[visualIndex+1].filtered.low);
+                        mip.data[mipIndex].filtered.low,
+                        mip.data[mipIndex + 1].filtered.low);
 
                 glVertex2f(visualIndex, 0);
                 glVertex2f(visualIndex, lowGain * maxLow);
             }
 
             glColor4f(m_midColor_r, m_midColor_g, m_midColor_b, 0.85);
-            for (int visualIndex = firstIndex;
-                    visualIndex < lastIndex;
-                    visualIndex += 2) {
+            for (int mipIndex = firstIndex;
+                    mipIndex < lastIndex;
+                    mipIndex += 2) {
+                const int visualIndex = mipIndex << mip.level;
 
                 GLfloat maxMid = math_max(
-                        data[visualIndex].filtered.mid,
-                        data[visualIndex+1].filtered.mid);
+                        mip.data[mipIndex].filtered.mid,
+                        mip.data[mipIndex + 1].filtered.mid);
 
                 glVertex2f(visualIndex, 0.f);
                 glVertex2f(visualIndex, midGain * maxMid);
             }
 
             glColor4f(m_highColor_r, m_highColor_g, m_highColor_b, 0.9);
-            for (int visualIndex = firstIndex;
-                    visualIndex < lastIndex;
-                    visualIndex += 2) {
+            for (int mipIndex = firstIndex;
+                    mipIndex < lastIndex;
+                    mipIndex += 2) {
+                const int visualIndex = mipIndex << mip.level;
 
                 GLfloat maxHigh = math_max(
-                        data[visualIndex].filtered.high,
-                        data[visualIndex + 1].filtered.high);
+                        mip.data[mipIndex].filtered.high,
+                        mip.data[mipIndex + 1].filtered.high);
 
                 glVertex2f(visualIndex, 0.f);
                 glVertex2f(visualIndex, highGain * maxHigh);
@@ -43,6 +43,9 @@ void GLWaveformRendererRGB::draw(QPainter* painter, QPaintEvent* /*event*/) {
 
     double firstVisualIndex = m_waveformRenderer->getFirstDisplayedPosition() * dataSize;
     double lastVisualIndex = m_waveformRenderer->getLastDisplayedPosition() * dataSize;
+
+    const MipLevel mip = getMipLevel(*waveform, firstVisualIndex, lastVisualIndex);
+
     const double lineWidth = (1.0 / m_waveformRenderer->getVisualSamplePerPixel()) + 1.5;
 
     const int firstIndex = int(firstVisualIndex + 0.5);
@@ -95,16 +98,19 @@ void GLWaveformRendererRGB::draw(QPainter* painter, QPaintEvent* /*event*/) {
 
         glBegin(GL_LINES); {
 
-            int firstIndex = math_max(static_cast<int>(firstVisualIndex), 0);
-            int lastIndex = math_min(static_cast<int>(lastVisualIndex), dataSize);
+            int firstIndex = (math_max(static_cast<int>(firstVisualIndex), 0) >> mip.level) & ~1;
+            int lastIndex = math_min(
+                    ((static_cast<int>(lastVisualIndex) / 2 + (1 << mip.level) - 1) >> mip.level) * 2,
+                    mip.dataSize);
 
-            for (int visualIndex = firstIndex;
-                    visualIndex < lastIndex;
-                    visualIndex += 2) {
+            for (int mipIndex = firstIndex;
+                    mipIndex < lastIndex;
+                    mipIndex += 2) {
+                const int visualIndex = mipIndex << mip.level;
 
-                float left_low    = lowGain  * (float) data[visualIndex].filtered.low;
-                float left_mid    = midGain  * (float) data[visualIndex].filtered.mid;
-                float left_high   = highGain * (float) data[visualIndex].filtered.high;
+                float left_low    = lowGain  * (float) mip.data[mipIndex].filtered.low;
+                float left_mid    = midGain  * (float) mip.data[mipIndex].filtered.mid;
+                float left_high   = highGain * (float) mip.data[mipIndex].filtered.high;
                 float left_all    = sqrtf(left_low * left_low + left_mid * left_mid + left_high * left_high) * kHeightScaleFactor;
                 float left_red    = left_low  * m_rgbLowColor_r + left_mid  * m_rgbMidColor_r + left_high  * m_rgbHighColor_r;
                 float left_green  = left_low  * m_rgbLowColor_g + left_mid  * m_rgbMidColor_g + left_high  * m_rgbHighColor_g;
@@ -116,9 +122,9 @@ void GLWaveformRendererRGB::draw(QPainter* painter, QPaintEvent* /*event*/) {
                     glVertex2f(visualIndex, left_all);
                 }
 
-                float right_low   = lowGain  * (float) data[visualIndex+1].filtered.low;
-                float right_mid   = midGain  * (float) data[visualIndex+1].filtered.mid;
-                float right_high  = highGain * (float) data[visualIndex+1].filtered.high;
+                float right_low   = lowGain  * (float) mip.data[mipIndex + 1].filtered.low;
+                float right_mid   = midGain  * (float) mip.data[mipIndex + 1].filtered.mid;
+                float right_high  = highGain * (float) mip.data[mipIndex + 1].filtered.high;
                 float right_all   = sqrtf(right_low * right_low + right_mid * right_mid + right_high * right_high) * kHeightScaleFactor;
                 float right_red   = right_low * m_rgbLowColor_r + right_mid * m_rgbMidColor_r + right_high * m_rgbHighColor_r;
                 float right_green = right_low * m_rgbLowColor_g + right_mid * m_rgbMidColor_g + right_high * m_rgbHighColor_g;
@@ -159,16 +165,19 @@ void GLWaveformRendererRGB::draw(QPainter* painter, QPaintEvent* /*event*/) {
 
         glBegin(GL_LINES); {
 
-            int firstIndex = math_max(static_cast<int>(firstVisualIndex), 0);
-            int lastIndex = math_min(static_cast<int>(lastVisualIndex), dataSize);
+            int firstIndex = (math_max(static_cast<int>(firstVisualIndex), 0) >> mip.level) & ~1;
+            int lastIndex = math_min(
+                    ((static_cast<int>(lastVisualIndex) / 2 + (1 << mip.level) - 1) >> mip.level) * 2,
+                    mip.dataSize);
 
-            for (int visualIndex = firstIndex;
-                    visualIndex < lastIndex;
-                    visualIndex += 2) {
+            for (int mipIndex = firstIndex;
+                    mipIndex < lastIndex;
+                    mipIndex += 2) {
+                const int visualIndex = mipIndex << mip.level;
 
-                float low  = lowGain  * (float) math_max(data[visualIndex].filtered.low,  data[visualIndex+1].filtered.low);
-                float mid  = midGain  * (float) math_max(data[visualIndex].filtered.mid,  data[visualIndex+1].filtered.mid);
-                float high = highGain * (float) math_max(data[visualIndex].filtered.high, data[visualIndex+1].filtered.high);
+                float low  = lowGain  * (float) math_max(mip.data[mipIndex].filtered.low,  mip.data[mipIndex + 1].filtered.low);
+                float mid  = midGain  * (float) math_max(mip.data[mipIndex].filtered.mid,  mip.data[mipIndex + 1].filtered.mid);
+                float high = highGain * (float) math_max(mip.data[mipIndex].filtered.high, mip.data[mipIndex + 1].filtered.high);
 
                 float all = sqrtf(low * low + mid * mid + high * high) * kHeightScaleFactor;
 
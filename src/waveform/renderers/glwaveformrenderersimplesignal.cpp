@@ -47,6 +47,9 @@ void GLWaveformRendererSimpleSignal::draw(QPainter* painter, QPaintEvent* /*even
 
     double firstVisualIndex = m_waveformRenderer->getFirstDisplayedPosition() * dataSize;
     double lastVisualIndex = m_waveformRenderer->getLastDisplayedPosition() * dataSize;
+
+    const MipLevel mip = getMipLevel(*waveform, firstVisualIndex, lastVisualIndex);
+
     double lineWidth = (1.0 / m_waveformRenderer->getVisualSamplePerPixel()) + 1.0;
 
     const int firstIndex = int(firstVisualIndex+0.5);
@@ -96,16 +99,19 @@ void GLWaveformRendererSimpleSignal::draw(QPainter* painter, QPaintEvent* /*even
         glEnable(GL_LINE_SMOOTH);
 
         glBegin(GL_LINES); {
-            int firstIndex = math_max(static_cast<int>(firstVisualIndex), 0);
-            int lastIndex = math_min(static_cast<int>(lastVisualIndex), dataSize);
+            int firstIndex = (math_max(static_cast<int>(firstVisualIndex), 0) >> mip.level) & ~1;
+            int lastIndex = math_min(
+                    ((static_cast<int>(lastVisualIndex) / 2 + (1 << mip.level) - 1) >> mip.level) * 2,
+                    mip.dataSize);
 
             glColor4f(m_signalColor_r, m_signalColor_g, m_signalColor_b, 0.9);
-            for (int visualIndex = firstIndex;
-                    visualIndex < lastIndex;
-                    visualIndex += 2) {
+            for (int mipIndex = firstIndex;
+                    mipIndex < lastIndex;
+                    mipIndex += 2) {
+                const int visualIndex = mipIndex << mip.level;
 
-                GLfloat maxAll0 = data[visualIndex].filtered.all;
-                GLfloat maxAll1 = data[visualIndex+1].filtered.all;
+                GLfloat maxAll0 = mip.data[mipIndex].filtered.all;
+                GLfloat maxAll1 = mip.data[mipIndex + 1].filtered.all;
                 glVertex2f(visualIndex, maxAll0);
                 glVertex2f(visualIndex, -1.f * maxAll1);
             }
@@ -134,17 +140,20 @@ void GLWaveformRendererSimpleSignal::draw(QPainter* painter, QPaintEvent* /*even
         glEnable(GL_LINE_SMOOTH);
 
         glBegin(GL_LINES); {
-            int firstIndex = math_max(static_cast<int>(firstVisualIndex), 0);
-            int lastIndex = math_min(static_cast<int>(lastVisualIndex), dataSize);
+            int firstIndex = (math_max(static_cast<int>(firstVisualIndex), 0) >> mip.level) & ~1;
+            int lastIndex = math_min(
+                    ((static_cast<int>(lastVisualIndex) / 2 + (1 << mip.level) - 1) >> mip.level) * 2,
+                    mip.dataSize);
 
             glColor4f(m_signalColor_r, m_signalColor_g, m_signalColor_b, 0.8);
-            for (int visualIndex = firstIndex;
-                    visualIndex < lastIndex;
-                    visualIndex += 2) {
+            for (int mipIndex = firstIndex;
+                    mipIndex < lastIndex;
+                    mipIndex += 2) {
+                const int visualIndex = mipIndex << mip.level;
 
                 GLfloat maxAll = math_max(
-                        data[visualIndex].filtered.all,
-                        data[visualIndex+1].filtered.all);
+                        mip.data[mipIndex].filtered.all,
+                        mip.data[mipIndex + 1].filtered.all);
                 glVertex2f(float(visualIndex), 0.f);
                 glVertex2f(float(visualIndex), maxAll);
             }
@@ -139,6 +139,8 @@ int QtWaveformRendererFilteredSignal::buildPolygon() {
     const double gain = (lastVisualIndex - firstVisualIndex) /
             (double)m_waveformRenderer->getLength();
 
+    const MipLevel mip = getMipLevel(*waveform, firstVisualIndex, lastVisualIndex);
+
     float lowGain(1.0), midGain(1.0), highGain(1.0);
     getGains(NULL, &lowGain, &midGain, &highGain);
 
@@ -225,8 +227,8 @@ int QtWaveformRendererFilteredSignal::buildPolygon() {
             visualFrameStart = math_clamp(visualFrameStart, 0, lastVisualFrame);
             visualFrameStop = math_clamp(visualFrameStop, 0, lastVisualFrame);
 
-            int visualIndexStart = visualFrameStart * 2 + channel;
-            int visualIndexStop = visualFrameStop * 2 + channel;
+            int visualIndexStart = (visualFrameStart >> mip.level) * 2 + channel;
+            int visualIndexStop = (visualFrameStop >> mip.level) * 2 + channel;
 
             // if (x == m_waveformRenderer->getWidth() / 2) {
             //     qDebug() << "audioVisualRatio" << waveform->getAudioVisualRatio();
@@ -243,9 +245,9 @@ int QtWaveformRendererFilteredSignal::buildPolygon() {
             unsigned char maxBand = 0;
             unsigned char maxHigh = 0;
 
-            for (int i = visualIndexStart; i >= 0 && i < dataSize && i <= visualIndexStop;
+            for (int i = visualIndexStart; i >= 0 && i < mip.dataSize && i <= visualIndexStop;
                  i += channelSeparation) {
-                const WaveformData& waveformData = *(data + i);
+                const WaveformData& waveformData = *(mip.data + i);
                 unsigned char low = waveformData.filtered.low;
                 unsigned char mid = waveformData.filtered.mid;
                 unsigned char high = waveformData.filtered.high;
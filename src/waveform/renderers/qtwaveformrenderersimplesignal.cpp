@@ -102,6 +102,8 @@ void QtWaveformRendererSimpleSignal::draw(QPainter* painter, QPaintEvent* /*even
     const double gain = (lastVisualIndex - firstVisualIndex) /
             (double)m_waveformRenderer->getLength();
 
+    const MipLevel mip = getMipLevel(*waveform, firstVisualIndex, lastVisualIndex);
+
     //NOTE(vrince) Please help me find a better name for "channelSeparation"
     //this variable stand for merged channel ... 1 = merged & 2 = separated
     int channelSeparation = 2;
@@ -179,8 +181,8 @@ void QtWaveformRendererSimpleSignal::draw(QPainter* painter, QPaintEvent* /*even
             visualFrameStart = math_clamp(visualFrameStart, 0, lastVisualFrame);
             visualFrameStop = math_clamp(visualFrameStop, 0, lastVisualFrame);
 
-            int visualIndexStart = visualFrameStart * 2 + channel;
-            int visualIndexStop = visualFrameStop * 2 + channel;
+            int visualIndexStart = (visualFrameStart >> mip.level) * 2 + channel;
+            int visualIndexStop = (visualFrameStop >> mip.level) * 2 + channel;
 
             // if (x == m_waveformRenderer->getLength() / 2) {
             //     qDebug() << "audioVisualRatio" << waveform->getAudioVisualRatio();
@@ -195,9 +197,9 @@ void QtWaveformRendererSimpleSignal::draw(QPainter* painter, QPaintEvent* /*even
 
             unsigned char maxAll = 0;
 
-            for (int i = visualIndexStart; i >= 0 && i < dataSize && i <= visualIndexStop;
+            for (int i = visualIndexStart; i >= 0 && i < mip.dataSize && i <= visualIndexStop;
                  i += channelSeparation) {
-                const WaveformData& waveformData = *(data + i);
+                const WaveformData& waveformData = *(mip.data + i);
                 unsigned char all = waveformData.filtered.all;
                 maxAll = math_max(maxAll, all);
             }
@@ -69,6 +69,8 @@ void WaveformRendererFilteredSignal::draw(QPainter* painter,
     const double gain = (lastVisualIndex - firstVisualIndex) /
             (double)m_waveformRenderer->getLength();
 
+    const MipLevel mip = getMipLevel(*waveform, firstVisualIndex, lastVisualIndex);
+
     // Per-band gain from the EQ knobs.
     float allGain(1.0), lowGain(1.0), midGain(1.0), highGain(1.0);
     getGains(&allGain, &lowGain, &midGain, &highGain);
@@ -124,8 +126,8 @@ void WaveformRendererFilteredSignal::draw(QPainter* painter,
         visualFrameStart = math_clamp(visualFrameStart, 0, lastVisualFrame);
         visualFrameStop = math_clamp(visualFrameStop, 0, lastVisualFrame);
 
-        int visualIndexStart = visualFrameStart * 2;
-        int visualIndexStop = visualFrameStop * 2;
+        int visualIndexStart = (visualFrameStart >> mip.level) * 2;
+        int visualIndexStop = (visualFrameStop >> mip.level) * 2;
 
         // if (x == m_waveformRenderer->getLength() / 2) {
         //     qDebug() << "audioVisualRatio" << waveform->getAudioVisualRatio();
@@ -143,9 +145,9 @@ void WaveformRendererFilteredSignal::draw(QPainter* painter,
         unsigned char maxHigh[2] = {0, 0};
 
         for (int i = visualIndexStart;
-             i >= 0 && i + 1 < dataSize && i + 1 <= visualIndexStop; i += 2) {
-            const WaveformData& waveformData = *(data + i);
-            const WaveformData& waveformDataNext = *(data + i + 1);
+             i >= 0 && i + 1 < mip.dataSize && i + 1 <= visualIndexStop; i += 2) {
+            const WaveformData& waveformData = *(mip.data + i);
+            const WaveformData& waveformDataNext = *(mip.data + i + 1);
             maxLow[0] = math_max(maxLow[0], waveformData.filtered.low);
             maxLow[1] = math_max(maxLow[1], waveformDataNext.filtered.low);
             maxMid[0] = math_max(maxMid[0], waveformData.filtered.mid);
@@ -65,6 +65,8 @@ void WaveformRendererHSV::draw(QPainter* painter,
     const double gain = (lastVisualIndex - firstVisualIndex) /
             (double)m_waveformRenderer->getLength();
 
+    const MipLevel mip = getMipLevel(*waveform, firstVisualIndex, lastVisualIndex);
+
     float allGain(1.0);
     getGains(&allGain, NULL, NULL, NULL);
 
@@ -120,8 +122,8 @@ void WaveformRendererHSV::draw(QPainter* painter,
         visualFrameStart = math_clamp(visualFrameStart, 0, lastVisualFrame);
         visualFrameStop = math_clamp(visualFrameStop, 0, lastVisualFrame);
 
-        int visualIndexStart = visualFrameStart * 2;
-        int visualIndexStop = visualFrameStop * 2;
+        int visualIndexStart = (visualFrameStart >> mip.level) * 2;
+        int visualIndexStop = (visualFrameStop >> mip.level) * 2;
 
         int maxLow[2] = {0, 0};
         int maxHigh[2] = {0, 0};
@@ -129,9 +131,9 @@ void WaveformRendererHSV::draw(QPainter* painter,
         int maxAll[2] = {0, 0};
 
         for (int i = visualIndexStart;
-             i >= 0 && i + 1 < dataSize && i + 1 <= visualIndexStop; i += 2) {
-            const WaveformData& waveformData = *(data + i);
-            const WaveformData& waveformDataNext = *(data + i + 1);
+             i >= 0 && i + 1 < mip.dataSize && i + 1 <= visualIndexStop; i += 2) {
+            const WaveformData& waveformData = *(mip.data + i);
+            const WaveformData& waveformDataNext = *(mip.data + i + 1);
             maxLow[0] = math_max(maxLow[0], (int)waveformData.filtered.low);
             maxLow[1] = math_max(maxLow[1], (int)waveformDataNext.filtered.low);
             maxMid[0] = math_max(maxMid[0], (int)waveformData.filtered.mid);
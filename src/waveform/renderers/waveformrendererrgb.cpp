@@ -64,6 +64,8 @@ void WaveformRendererRGB::draw(QPainter* painter,
     const double gain = (lastVisualIndex - firstVisualIndex) /
             (double)m_waveformRenderer->getLength();
 
+    const MipLevel mip = getMipLevel(*waveform, firstVisualIndex, lastVisualIndex);
+
     // Per-band gain from the EQ knobs.
     float allGain(1.0), lowGain(1.0), midGain(1.0), highGain(1.0);
     getGains(&allGain, &lowGain, &midGain, &highGain);
@@ -111,8 +113,8 @@ void WaveformRendererRGB::draw(QPainter* painter,
         visualFrameStart = math_clamp(visualFrameStart, 0, lastVisualFrame);
         visualFrameStop = math_clamp(visualFrameStop, 0, lastVisualFrame);
 
-        int visualIndexStart = visualFrameStart * 2;
-        int visualIndexStop  = visualFrameStop * 2;
+        int visualIndexStart = (visualFrameStart >> mip.level) * 2;
+        int visualIndexStop = (visualFrameStop >> mip.level) * 2;
 
         unsigned char maxLow  = 0;
         unsigned char maxMid  = 0;
@@ -121,9 +123,9 @@ void WaveformRendererRGB::draw(QPainter* painter,
         float maxAllNext = 0.;
 
         for (int i = visualIndexStart;
-             i >= 0 && i + 1 < dataSize && i + 1 <= visualIndexStop; i += 2) {
-            const WaveformData& waveformData = data[i];
-            const WaveformData& waveformDataNext = data[i + 1];
+             i >= 0 && i + 1 < mip.dataSize && i + 1 <= visualIndexStop; i += 2) {
+            const WaveformData& waveformData = mip.data[i];
+            const WaveformData& waveformDataNext = mip.data[i + 1];
 
             maxLow  = math_max3(maxLow,  waveformData.filtered.low,  waveformDataNext.filtered.low);
             maxMid  = math_max3(maxMid,  waveformData.filtered.mid,  waveformDataNext.filtered.mid);
@@ -2,6 +2,7 @@
 
 #include <QDomNode>
 
+#include "waveform/waveform.h"
 #include "waveform/waveformwidgetfactory.h"
 #include "waveformwidgetrenderer.h"
 #include "control/controlobject.h"
@@ -201,3 +202,16 @@ void WaveformRendererSignalBase::getGains(float* pAllGain, float* pLowGain,
         }
     }
 }
+
+WaveformRendererSignalBase::MipLevel WaveformRendererSignalBase::getMipLevel(
+        const Waveform& waveform,
+        double firstVisualIndex, double lastVisualIndex) const {
+    // The data interleaves both channels, so two indices per visual sample
+    const double visualSamplesPerPixel = (lastVisualIndex - firstVisualIndex) /
+            2.0 / m_waveformRenderer->getLength();
+    MipLevel mipLevel;
+    mipLevel.level = waveform.mipLevelForVisualSamples(visualSamplesPerPixel);
+    mipLevel.data = waveform.mipLevelData(mipLevel.level);
+    mipLevel.dataSize = waveform.getMipLevelDataSize(mipLevel.level);
+    return mipLevel;
+}
@@ -7,6 +7,8 @@
 
 class ControlObject;
 class ControlProxy;
+class Waveform;
+union WaveformData;
 
 class WaveformRendererSignalBase : public WaveformRendererAbstract {
 public:
@@ -25,6 +27,18 @@ public:
     void getGains(float* pAllGain, float* pLowGain, float* pMidGain,
                   float* highGain);
 
+    struct MipLevel {
+        int level;
+        const WaveformData* data;
+        int dataSize;
+    };
+    // The nearest level of the mip pyramid of the waveform for the displayed
+    // visual samples. Its visual samples span at most the frames of a pixel,
+    // so drawing or reducing them instead of the visual samples of the
+    // waveform itself gives the same picture with less work.
+    MipLevel getMipLevel(const Waveform& waveform,
+                         double firstVisualIndex, double lastVisualIndex) const;
+
   protected:
     ControlProxy* m_pEQEnabled;
     ControlProxy* m_pLowFilterControlObject;
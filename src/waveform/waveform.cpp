@@ -1,12 +1,47 @@
 #include <QtDebug>
 
+#include <algorithm>
+#include <cstring>
+
 #include "waveform/waveform.h"
 #include "proto/waveform.pb.h"
+#include "util/assert.h"
+#include "util/math.h"
 
 using namespace mixxx::track;
 
 const int kNumChannels = 2;
 
+namespace {
+
+// The binary format of Waveform 6.0 is a fixed header followed by the
+// data elements as they are stored in memory, i.e. the low, mid, high
+// and all bytes of the left and right channel of each visual sample.
+// It is stored uncompressed and read with a single copy. The header is
+// stored in native byte order like the PcmCache entries. A mismatching
+// format version invalidates the stored waveform and the track is
+// analyzed again.
+constexpr char kBinaryMagic[4] = {'M', 'X', 'W', 'F'};
+constexpr quint32 kBinaryFormatVersion = 1;
+
+struct BinaryHeader {
+    char magic[4];
+    quint32 formatVersion;
+    quint32 channelCount;
+    // The number of data elements
+    quint32 dataSize;
+    double visualSampleRate;
+    double audioVisualRatio;
+};
+
+constexpr int kBinaryDataOffset = 32;
+static_assert(sizeof(BinaryHeader) <= kBinaryDataOffset,
+        "The header must fit in front of the data elements");
+static_assert(sizeof(WaveformData) == 4,
+        "The data elements are stored as they are in memory");
+
+} // anonymous namespace
+
 // Return the smallest power of 2 which is greater than the desired size when
 // squared.
 int computeTextureStride(int size) {
@@ -20,11 +55,13 @@ int computeTextureStride(int size) {
 Waveform::Waveform(const QByteArray data)
         : m_id(-1),
           m_saveState(SaveState::NotSaved),
+          m_provisional(false),
           m_dataSize(0),
           m_visualSampleRate(0),
           m_audioVisualRatio(0),
           m_textureStride(computeTextureStride(0)),
           m_completion(-1) {
+    allocateMipLevels();
     readByteArray(data);
 }
 
@@ -32,6 +69,7 @@ Waveform::Waveform(int audioSampleRate, int audioSamples,
                    int desiredVisualSampleRate, int maxVisualSamples)
         : m_id(-1),
           m_saveState(SaveState::NotSaved),
+          m_provisional(false),
           m_dataSize(0),
           m_visualSampleRate(0),
           m_audioVisualRatio(0),
@@ -68,75 +106,65 @@ Waveform::~Waveform() {
 }
 
 QByteArray Waveform::toByteArray() const {
-    io::Waveform waveform;
-    waveform.set_visual_sample_rate(m_visualSampleRate);
-    waveform.set_audio_visual_ratio(m_audioVisualRatio);
-
-    io::Waveform::Signal* all = waveform.mutable_signal_all();
-    io::Waveform::FilteredSignal* filtered = waveform.mutable_signal_filtered();
-    // TODO(rryan) get the actual cutoff values from analyzerwaveform.cpp so
-    // that if they change we don't have to remember to update these.
-
-    // Frequency cutoffs for butterworth filters:
-    // filtered->set_low_cutoff_frequency(200);
-    // filtered->set_mid_low_cutoff_frequency(200);
-    // filtered->set_mid_high_cutoff_frequency(2000);
-    // filtered->set_high_cutoff_frequency(2000);
-
-    // Frequency cutoff for bessel_lowpass4
-    filtered->set_low_cutoff_frequency(600);
-    // Frequency cutoff for bessel_bandpass
-    filtered->set_mid_low_cutoff_frequency(600);
-    filtered->set_mid_high_cutoff_frequency(4000);
-    // Frequency cutoff for bessel_highpass4
-    filtered->set_high_cutoff_frequency(4000);
-
-    io::Waveform::Signal* low = filtered->mutable_low();
-    io::Waveform::Signal* mid = filtered->mutable_mid();
-    io::Waveform::Signal* high = filtered->mutable_high();
-
-    // TODO(vrince) set max/min for each signal
-    int numChannels = kNumChannels;
-    all->set_units(io::Waveform::RMS);
-    all->set_channels(numChannels);
-    low->set_units(io::Waveform::RMS);
-    low->set_channels(numChannels);
-    mid->set_units(io::Waveform::RMS);
-    mid->set_channels(numChannels);
-    high->set_units(io::Waveform::RMS);
-    high->set_channels(numChannels);
-
-    int dataSize = getDataSize();
-    for (int i = 0; i < dataSize; ++i) {
-        const WaveformData& datum = m_data.at(i);
-        all->add_value(datum.filtered.all);
-        low->add_value(datum.filtered.low);
-        mid->add_value(datum.filtered.mid);
-        high->add_value(datum.filtered.high);
+    const int dataSize = getDataSize();
+    QByteArray output(
+            kBinaryDataOffset + dataSize * static_cast<int>(sizeof(WaveformData)),
+            '\0');
+    BinaryHeader header;
+    std::memcpy(header.magic, kBinaryMagic, sizeof(kBinaryMagic));
+    header.formatVersion = kBinaryFormatVersion;
+    header.channelCount = kNumChannels;
+    header.dataSize = static_cast<quint32>(dataSize);
+    header.visualSampleRate = m_visualSampleRate;
+    header.audioVisualRatio = m_audioVisualRatio;
+    std::memcpy(output.data(), &header, sizeof(header));
+    if (dataSize > 0) {
+        std::memcpy(output.data() + kBinaryDataOffset,
+                data(),
+                dataSize * sizeof(WaveformData));
     }
+    return output;
+}
 
-    qDebug() << "Writing waveform from byte array:"
-             << "dataSize" << dataSize
-             << "allSignalSize" << all->value_size()
-             << "visualSampleRate" << waveform.visual_sample_rate()
-             << "audioVisualRatio" << waveform.audio_visual_ratio();
-
-    std::string output;
-    waveform.SerializeToString(&output);
-    return QByteArray(output.data(), output.length());
+// static
+bool Waveform::isBinaryFormat(const QByteArray& data) {
+    return data.size() >= kBinaryDataOffset &&
+            std::memcmp(data.constData(), kBinaryMagic, sizeof(kBinaryMagic)) == 0;
 }
 
-void Waveform::readByteArray(const QByteArray& data) {
-    if (data.isNull()) {
-        return;
+bool Waveform::readBinaryFormat(const QByteArray& byteArray) {
+    BinaryHeader header;
+    std::memcpy(&header, byteArray.constData(), sizeof(header));
+    const qint64 expectedSize = kBinaryDataOffset +
+            static_cast<qint64>(header.dataSize) * sizeof(WaveformData);
+    if (header.formatVersion != kBinaryFormatVersion ||
+            header.channelCount != kNumChannels ||
+            header.dataSize % kNumChannels != 0 ||
+            byteArray.size() != expectedSize ||
+            !(header.visualSampleRate > 0) ||
+            !(header.audioVisualRatio > 0)) {
+        qDebug() << "ERROR: Invalid binary Waveform of size" << byteArray.size();
+        return false;
     }
 
+    const int dataSize = static_cast<int>(header.dataSize);
+    resize(dataSize);
+    m_visualSampleRate = header.visualSampleRate;
+    m_audioVisualRatio = header.audioVisualRatio;
+    // The data elements are stored as they are in memory
+    std::memcpy(data(),
+            byteArray.constData() + kBinaryDataOffset,
+            dataSize * sizeof(WaveformData));
+    return true;
+}
+
+bool Waveform::readProtobufFormat(const QByteArray& data) {
     io::Waveform waveform;
 
     if (!waveform.ParseFromArray(data.constData(), data.size())) {
         qDebug() << "ERROR: Could not parse Waveform from QByteArray of size "
                  << data.size();
-        return;
+        return false;
     }
 
     if (!waveform.has_visual_sample_rate() ||
@@ -147,7 +175,7 @@ void Waveform::readByteArray(const QByteArray& data) {
         !waveform.signal_filtered().has_mid() ||
         !waveform.signal_filtered().has_high()) {
         qDebug() << "ERROR: Waveform proto is missing key data. Skipping.";
-        return;
+        return false;
     }
 
     const io::Waveform::Signal& all = waveform.signal_all();
@@ -155,7 +183,7 @@ void Waveform::readByteArray(const QByteArray& data) {
     const io::Waveform::Signal& mid = waveform.signal_filtered().mid();
     const io::Waveform::Signal& high = waveform.signal_filtered().high();
 
-    qDebug() << "Reading waveform from byte array:"
+    qDebug() << "Reading protobuf waveform from byte array:"
              << "allSignalSize" << all.value_size()
              << "visualSampleRate" << waveform.visual_sample_rate()
              << "audioVisualRatio" << waveform.audio_visual_ratio();
@@ -167,8 +195,7 @@ void Waveform::readByteArray(const QByteArray& data) {
         qDebug() << "ERROR: Couldn't resize Waveform to" << all.value_size()
                  << "while reading.";
         resize(0);
-        m_saveState = SaveState::NotSaved;
-        return;
+        return false;
     }
 
     m_visualSampleRate = waveform.visual_sample_rate();
@@ -193,6 +220,25 @@ void Waveform::readByteArray(const QByteArray& data) {
         m_data[i].filtered.mid = use_mid ? static_cast<unsigned char>(mid.value(i)) : 0;
         m_data[i].filtered.high = use_high ? static_cast<unsigned char>(high.value(i)) : 0;
     }
+    return true;
+}
+
+void Waveform::readByteArray(const QByteArray& data) {
+    if (data.isNull()) {
+        return;
+    }
+
+    // Waveforms that have been stored before Waveform 6.0 are protobuf
+    // messages and converted while reading
+    const bool success = isBinaryFormat(data)
+            ? readBinaryFormat(data)
+            : readProtobufFormat(data);
+    if (!success) {
+        m_saveState = SaveState::NotSaved;
+        return;
+    }
+    const int dataSize = getDataSize();
+    updateMipLevels(0, dataSize);
     m_completion = dataSize;
     m_saveState = SaveState::Saved;
 }
@@ -201,15 +247,87 @@ void Waveform::resize(int size) {
     m_dataSize = size;
     m_textureStride = computeTextureStride(size);
     m_data.resize(m_textureStride * m_textureStride);
+    allocateMipLevels();
 }
 
 void Waveform::assign(int size, int value) {
     m_dataSize = size;
     m_textureStride = computeTextureStride(size);
     m_data.assign(m_textureStride * m_textureStride, value);
+    allocateMipLevels();
     m_saveState = SaveState::SavePending;
 }
 
+void Waveform::allocateMipLevels() {
+    m_mipLevelOffsets.assign(1, 0);
+    int visualSamples = m_dataSize / kNumChannels;
+    int mipDataSize = 0;
+    while (visualSamples > 1) {
+        visualSamples = (visualSamples + 1) / 2;
+        m_mipLevelOffsets.push_back(mipDataSize);
+        mipDataSize += kNumChannels * visualSamples;
+    }
+    // The levels are reduced from zeroed data
+    m_mipData.assign(mipDataSize, 0);
+}
+
+int Waveform::getMipLevelDataSize(int level) const {
+    DEBUG_ASSERT(level >= 0 && level < getMipLevelCount());
+    if (level == 0) {
+        return m_dataSize;
+    }
+    const int end = level + 1 < getMipLevelCount()
+            ? m_mipLevelOffsets[level + 1]
+            : static_cast<int>(m_mipData.size());
+    return end - m_mipLevelOffsets[level];
+}
+
+const WaveformData* Waveform::mipLevelData(int level) const {
+    DEBUG_ASSERT(level >= 0 && level < getMipLevelCount());
+    if (level == 0) {
+        return data();
+    }
+    return &m_mipData[m_mipLevelOffsets[level]];
+}
+
+int Waveform::mipLevelForVisualSamples(double visualSamples) const {
+    int level = 0;
+    while (level + 1 < getMipLevelCount() && (2 << level) <= visualSamples) {
+        ++level;
+    }
+    return level;
+}
+
+void Waveform::updateMipLevels(int startIndex, int endIndex) {
+    // The visual samples of the previous level that have changed
+    int start = math_max(startIndex, 0) / kNumChannels;
+    int end = (math_min(endIndex, m_dataSize) + kNumChannels - 1) / kNumChannels;
+    const WaveformData* pPrevious = data();
+    int previousVisualSamples = m_dataSize / kNumChannels;
+    for (int level = 1; level < getMipLevelCount() && start < end; ++level) {
+        WaveformData* pLevel = &m_mipData[m_mipLevelOffsets[level]];
+        start /= 2;
+        end = (end + 1) / 2;
+        for (int i = start; i < end; ++i) {
+            // The bytes of both channels of the two visual samples
+            const auto* pFirst = reinterpret_cast<const unsigned char*>(
+                    pPrevious + kNumChannels * 2 * i);
+            auto* pMax = reinterpret_cast<unsigned char*>(
+                    pLevel + kNumChannels * i);
+            constexpr int kBytes = kNumChannels * sizeof(WaveformData);
+            if (2 * i + 1 < previousVisualSamples) {
+                for (int b = 0; b < kBytes; ++b) {
+                    pMax[b] = math_max(pFirst[b], pFirst[kBytes + b]);
+                }
+            } else {
+                std::copy(pFirst, pFirst + kBytes, pMax);
+            }
+        }
+        pPrevious = pLevel;
+        previousVisualSamples = (previousVisualSamples + 1) / 2;
+    }
+}
+
 void Waveform::dump() const {
     qDebug() << "Waveform" << this
              << "size("+QString::number(getDataSize())+")"
@@ -73,7 +73,11 @@ class Waveform {
         m_description = description;
     }
 
+    // Serializes the waveform into the binary format of Waveform 6.0
     QByteArray toByteArray() const;
+    // Distinguishes the binary format from the protobuf messages of
+    // previous versions
+    static bool isBinaryFormat(const QByteArray& data);
 
     // We do not lock the mutex since m_dataSize and m_visualSampleRate are not
     // changed after the constructor runs.
@@ -91,6 +95,17 @@ class Waveform {
         m_saveState = eState;
     }
 
+    // A provisional waveform is filled while the track is decoded for
+    // playback (see ProvisionalWaveformBuilder) until the analysis has
+    // finished. It is never saved. Not allowed to change after the waveform
+    // has been set to the track.
+    bool isProvisional() const {
+        return m_provisional;
+    }
+    void setProvisional(bool provisional) {
+        m_provisional = provisional;
+    }
+
     // We do not lock the mutex since m_audioVisualRatio is not changed after
     // the constructor runs.
     double getAudioVisualRatio() const {
@@ -133,12 +148,35 @@ class Waveform {
     // constructor runs.
     const WaveformData* data() const { return &m_data[0];}
 
+    // For drawing zoomed out waveforms the data is reduced into a mip
+    // pyramid. Each visual sample of a level holds the maximum of two
+    // consecutive visual samples of the previous level per channel, i.e.
+    // of 2^level visual samples of the waveform. Level 0 is the waveform
+    // data itself. Like the data, the levels are not resized after the
+    // constructor runs.
+    int getMipLevelCount() const {
+        return static_cast<int>(m_mipLevelOffsets.size());
+    }
+    // The number of data elements of the level
+    int getMipLevelDataSize(int level) const;
+    const WaveformData* mipLevelData(int level) const;
+    // The coarsest level whose visual samples span at most the given
+    // number of visual samples of the waveform
+    int mipLevelForVisualSamples(double visualSamples) const;
+
+    // Updates the levels after the data elements in the given range
+    // have been written. Must be called by the thread that writes the data.
+    void updateMipLevels(int startIndex, int endIndex);
+
     void dump() const;
 
   private:
     void readByteArray(const QByteArray& data);
+    bool readBinaryFormat(const QByteArray& byteArray);
+    bool readProtobufFormat(const QByteArray& data);
     void resize(int size);
     void assign(int size, int value = 0);
+    void allocateMipLevels();
 
     inline WaveformData& at(int i) { return m_data[i];}
     inline unsigned char& low(int i) { return m_data[i].filtered.low;}
@@ -151,6 +189,7 @@ class Waveform {
     int m_id;
     // mutable since AnalysisDAO needs to be able to set the waveform as saved.
     mutable SaveState m_saveState;
+    bool m_provisional;
     QString m_version;
     QString m_description;
 
@@ -170,6 +209,11 @@ class Waveform {
     // Not allowed to change after the constructor runs.
     double m_audioVisualRatio;
 
+    // The levels above 0 of the mip pyramid one after another. The offset
+    // of level 0 is unused.
+    std::vector<WaveformData> m_mipData;
+    std::vector<int> m_mipLevelOffsets;
+
     // We create an NxN texture out of m_data's buffer in the GLSL renderer. The
     // stride is N. Not allowed to change after the constructor runs.
     int m_textureStride;
@@ -13,6 +13,26 @@ Waveform* WaveformFactory::loadWaveformFromAnalysis(
     return pWaveform;
 }
 
+// static
+void WaveformFactory::convertWaveformToCurrentVersion(Waveform* pWaveform) {
+    if (!pWaveform->isValid()) {
+        return;
+    }
+    pWaveform->setVersion(currentWaveformVersion());
+    pWaveform->setDescription(currentWaveformDescription());
+    pWaveform->setSaveState(Waveform::SaveState::SavePending);
+}
+
+// static
+void WaveformFactory::convertWaveformSummaryToCurrentVersion(Waveform* pWaveform) {
+    if (!pWaveform->isValid()) {
+        return;
+    }
+    pWaveform->setVersion(currentWaveformSummaryVersion());
+    pWaveform->setDescription(currentWaveformSummaryDescription());
+    pWaveform->setSaveState(Waveform::SaveState::SavePending);
+}
+
 // static
 WaveformFactory::VersionClass WaveformFactory::waveformVersionToVersionClass(const QString& version) {
     if (version == WAVEFORM_CURRENT_VERSION) {
@@ -20,6 +40,11 @@ WaveformFactory::VersionClass WaveformFactory::waveformVersionToVersionClass(con
         return VC_USE;
     }
 
+    if (version == WAVEFORM_5_VERSION) {
+        // Used from Mixxx 1.12 alpha, stored as protobuf message
+        return VC_CONVERT;
+    }
+
     if (version == WAVEFORM_4_VERSION) {
         // Used in Mixxx 1.12 beta, suffers Bug lp:1406389
         return VC_REMOVE;
@@ -46,6 +71,11 @@ WaveformFactory::VersionClass WaveformFactory::waveformSummaryVersionToVersionCl
         return VC_USE;
     }
 
+    if (version == WAVEFORMSUMMARY_5_VERSION) {
+        // Used from Mixxx 1.12 alpha, stored as protobuf message
+        return VC_CONVERT;
+    }
+
     if (version == WAVEFORMSUMMARY_4_VERSION) {
         // Used in Mixxx 1.12 beta, suffers Bug lp:1406389
         return VC_REMOVE;
@@ -28,22 +28,36 @@ class Waveform;
 #define WAVEFORM_5_DESCRIPTION "Waveform 5.0"
 #define WAVEFORMSUMMARY_5_DESCRIPTION "WaveformSummary 5.0"
 
-#define WAVEFORM_CURRENT_VERSION WAVEFORM_5_VERSION
-#define WAVEFORMSUMMARY_CURRENT_VERSION WAVEFORMSUMMARY_5_VERSION
-#define WAVEFORM_CURRENT_DESCRIPTION WAVEFORM_5_DESCRIPTION
-#define WAVEFORMSUMMARY_CURRENT_DESCRIPTION WAVEFORMSUMMARY_5_DESCRIPTION
+// Same data as 5.0 in an uncompressed binary format instead of a
+// compressed protobuf message
+#define WAVEFORM_6_VERSION "Waveform-6.0"
+#define WAVEFORMSUMMARY_6_VERSION "WaveformSummary-6.0"
+#define WAVEFORM_6_DESCRIPTION "Waveform 6.0"
+#define WAVEFORMSUMMARY_6_DESCRIPTION "WaveformSummary 6.0"
+
+#define WAVEFORM_CURRENT_VERSION WAVEFORM_6_VERSION
+#define WAVEFORMSUMMARY_CURRENT_VERSION WAVEFORMSUMMARY_6_VERSION
+#define WAVEFORM_CURRENT_DESCRIPTION WAVEFORM_6_DESCRIPTION
+#define WAVEFORMSUMMARY_CURRENT_DESCRIPTION WAVEFORMSUMMARY_6_DESCRIPTION
 
 
 class WaveformFactory {
   public:
     enum VersionClass {
         VC_USE,
+        // Use, but store again in the current format
+        VC_CONVERT,
         VC_KEEP,
         VC_REMOVE
     };
 
     static Waveform* loadWaveformFromAnalysis(
             const AnalysisDao::AnalysisInfo& analysis);
+    // Marks a waveform that has been loaded from an analysis of class
+    // VC_CONVERT as pending for storing it in the current format. The
+    // stored analysis is replaced, because the ID is kept.
+    static void convertWaveformToCurrentVersion(Waveform* pWaveform);
+    static void convertWaveformSummaryToCurrentVersion(Waveform* pWaveform);
     static VersionClass waveformVersionToVersionClass(const QString& version);
     static VersionClass waveformSummaryVersionToVersionClass(const QString& version);
     static QString currentWaveformVersion();
@@ -24,6 +24,7 @@
 #include <QPixmap>
 
 #include "util/timer.h"
+#include "widget/controlwidgetconnection.h"
 #include "widget/wpixmapstore.h"
 #include "util/math.h"
 
@@ -44,7 +45,9 @@ WVuMeter::WVuMeter(QWidget* parent)
           m_iPeakFallStep(0),
           m_iPeakHoldTime(0),
           m_iPeakFallTime(0),
-          m_dPeakHoldCountdownMs(0) {
+          m_dPeakHoldCountdownMs(0),
+          m_pDeckStateLevel(nullptr),
+          m_deckStateVersion(0) {
     m_timer.start();
 }
 
@@ -91,6 +94,21 @@ void WVuMeter::setup(const QDomNode& node, const SkinContext& context) {
         m_iPeakFallTime = DEFAULT_FALLTIME;
     }
 
+    if (m_pDisplayConnection) {
+        const ConfigKey& key = m_pDisplayConnection->getKey();
+        if (key.item == "VuMeter") {
+            m_pDeckStateLevel = &DeckState::vuMeter;
+        } else if (key.item == "VuMeterL") {
+            m_pDeckStateLevel = &DeckState::vuMeterLeft;
+        } else if (key.item == "VuMeterR") {
+            m_pDeckStateLevel = &DeckState::vuMeterRight;
+        }
+        if (m_pDeckStateLevel) {
+            // Only decks have a publisher
+            m_pDeckStatePublisher = DeckStatePublisher::getPublisher(key.group);
+        }
+    }
+
     setFocusPolicy(Qt::NoFocus);
 }
 
@@ -124,6 +142,13 @@ void WVuMeter::setPixmaps(PixmapSource source, bool bHorizontal,
 
 void WVuMeter::onConnectedControlChanged(double dParameter, double dValue) {
     Q_UNUSED(dValue);
+    if (m_pDeckStatePublisher) {
+        return;
+    }
+    setParameter(dParameter);
+}
+
+void WVuMeter::setParameter(double dParameter) {
     m_dParameter = math_clamp(dParameter, 0.0, 1.0);
 
     if (dParameter > 0.0) {
@@ -163,6 +188,15 @@ void WVuMeter::updateState(mixxx::Duration elapsed) {
 }
 
 void WVuMeter::maybeUpdate() {
+    if (m_pDeckStatePublisher) {
+        const DeckState& state = m_pDeckStatePublisher->read(
+                DeckStatePublisher::Reader::Gui);
+        if (state.version != m_deckStateVersion) {
+            m_deckStateVersion = state.version;
+            setParameter(m_pDisplayConnection->getControlParameterForValue(
+                    state.*m_pDeckStateLevel));
+        }
+    }
     if (m_dParameter != m_dLastParameter || m_dPeakParameter != m_dLastPeakParameter) {
         repaint();
     }
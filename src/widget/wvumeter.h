@@ -23,7 +23,9 @@
 #include <QPaintEvent>
 #include <QWidget>
 #include <QDomNode>
+#include <QSharedPointer>
 
+#include "engine/deckstate.h"
 #include "widget/wwidget.h"
 #include "widget/wpixmapstore.h"
 #include "skin/skincontext.h"
@@ -52,6 +54,7 @@ class WVuMeter : public WWidget  {
 
   private:
     void paintEvent(QPaintEvent * /*unused*/) override;
+    void setParameter(double parameter);
     void setPeak(double parameter);
 
     // Current parameter and peak parameter.
@@ -83,6 +86,12 @@ class WVuMeter : public WWidget  {
     double m_dPeakHoldCountdownMs;
 
     PerformanceTimer m_timer;
+
+    // The levels of decks are read from the snapshot of the engine on each
+    // waveform tick instead of from the control
+    QSharedPointer<DeckStatePublisher> m_pDeckStatePublisher;
+    CSAMPLE DeckState::*m_pDeckStateLevel;
+    quint64 m_deckStateVersion;
 };
 
 #endif